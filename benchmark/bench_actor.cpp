@@ -6,6 +6,7 @@
 //
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
+#include "td/actor/MultiPromise.h"
 #include "td/actor/PromiseFuture.h"
 
 #include "td/utils/benchmark.h"
@@ -169,6 +170,80 @@ class RingBench final : public td::Benchmark {
   }
 };
 
+template <bool batch_outbound_events>
+class CrossThreadBench final : public td::Benchmark {
+ public:
+  struct ConsumerActor;
+  struct ProducerActor;
+
+ private:
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  td::ActorId<ConsumerActor> consumer_;
+  td::ActorId<ProducerActor> producer_;
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "CrossThread (batch_outbound_events = " << batch_outbound_events << ")";
+  }
+
+  struct ConsumerActor final : public td::Actor {
+    int left = 0;
+
+    void on_event(int x) {
+      if (--left == 0) {
+        td::Scheduler::instance()->finish();
+      }
+    }
+  };
+
+  struct ProducerActor final : public td::Actor {
+    td::ActorId<ConsumerActor> consumer;
+    int left = 0;
+
+    explicit ProducerActor(td::ActorId<ConsumerActor> consumer) : consumer(std::move(consumer)) {
+    }
+
+    void run(int n) {
+      left = n;
+      yield();
+    }
+
+    void wakeup() final {
+      for (int i = 0; i < 1000 && left > 0; i++) {
+        send_closure(consumer, &ConsumerActor::on_event, left--);
+      }
+      if (left > 0) {
+        yield();
+      }
+    }
+  };
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(2, 0);
+    scheduler_->set_batch_outbound_events(batch_outbound_events);
+    consumer_ = scheduler_->create_actor_unsafe<ConsumerActor>(2, "Consumer").release();
+    producer_ = scheduler_->create_actor_unsafe<ProducerActor>(1, "Producer", consumer_).release();
+    scheduler_->start();
+  }
+
+  void run(int n) final {
+    n = td::max(n, 1);
+    consumer_.get_actor_unsafe()->left = n;
+    {
+      auto guard = scheduler_->get_main_guard();
+      send_closure(producer_, &ProducerActor::run, n);
+    }
+    while (scheduler_->run_main(10)) {
+      // empty
+    }
+  }
+
+  void tear_down() final {
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+};
+
 template <int type>
 class QueryBench final : public td::Benchmark {
  public:
@@ -324,7 +399,61 @@ class QueryBench final : public td::Benchmark {
   td::ActorOwn<ServerActor> server_;
 };
 
+template <bool need_promise>
+class UpdateBatchBench final : public td::Benchmark {
+  static constexpr int BATCH_SIZE = 16;
+
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  int applied_count_ = 0;
+  int finished_batch_count_ = 0;
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(0, 0);
+    scheduler_->start();
+  }
+
+  void tear_down() final {
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+
+ public:
+  td::string get_description() const final {
+    return PSTRING() << "UpdateBatch: " << (need_promise ? "promise per update" : "promise per batch");
+  }
+
+  void run(int n) final {
+    applied_count_ = 0;
+    finished_batch_count_ = 0;
+    int batch_count = 0;
+    {
+      auto guard = scheduler_->get_main_guard();
+      for (int i = 0; i < n; i += BATCH_SIZE) {
+        td::MultiPromiseActorSafe mpas{"UpdateBatchMultiPromiseActor"};
+        mpas.add_promise([this](td::Result<td::Unit> result) { finished_batch_count_++; });
+        auto lock = mpas.get_promise();
+        for (int j = i; j < n && j < i + BATCH_SIZE; j++) {
+          if (need_promise) {
+            auto promise = mpas.get_promise();
+            applied_count_++;
+            promise.set_value(td::Unit());
+          } else {
+            applied_count_++;
+          }
+        }
+        lock.set_value(td::Unit());
+        batch_count++;
+      }
+    }
+    while (finished_batch_count_ < batch_count) {
+      scheduler_->run_main(0);
+    }
+    CHECK(applied_count_ == n);
+  }
+};
+
 int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
   td::init_openssl_threads();
 
   bench(CreateActorBench());
@@ -346,4 +475,8 @@ int main() {
   bench(RingBench<0>(504, 2));
   bench(RingBench<1>(504, 2));
   bench(RingBench<2>(504, 2));
+  bench(CrossThreadBench<false>());
+  bench(CrossThreadBench<true>());
+  bench(UpdateBatchBench<true>());
+  bench(UpdateBatchBench<false>());
 }
@@ -0,0 +1,186 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/Client.h"
+#include "td/telegram/td_api.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// measures time and memory needed to start clients up to the authorization state after initialization,
+// CPU usage of idle clients, latency of requests sent simultaneously to all clients and time needed to close them;
+// usage: bench_client [client_count] [idle_seconds] [requests_per_client] [destroy]
+int main(int argc, char **argv) {
+  int client_count = argc > 1 ? td::to_integer<int>(td::Slice(argv[1])) : 100;
+  int idle_seconds = argc > 2 ? td::to_integer<int>(td::Slice(argv[2])) : 5;
+  int requests_per_client = argc > 3 ? td::to_integer<int>(td::Slice(argv[3])) : 100;
+  bool use_destroy = argc > 4 && td::Slice(argv[4]) == "destroy";
+  if (client_count <= 0 || idle_seconds < 0 || requests_per_client <= 0) {
+    std::exit(2);
+  }
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+
+  const td::string database_root = "bench_client_db";
+  td::rmrf(database_root).ignore();
+
+  auto get_resident_size = [] {
+    auto r_mem_stat = td::mem_stat();
+    return r_mem_stat.is_ok() ? r_mem_stat.ok().resident_size_ : 0;
+  };
+  // resident size can decrease, so the change is signed
+  auto get_resident_size_change = [](td::uint64 start_size, td::uint64 finish_size, int divisor) {
+    auto change = static_cast<td::int64>(finish_size) - static_cast<td::int64>(start_size);
+    auto abs_change = static_cast<td::uint64>(change < 0 ? -change : change) / static_cast<td::uint64>(divisor);
+    return PSTRING() << (change < 0 ? "-" : "") << td::format::as_size(abs_change);
+  };
+  auto start_resident_size = get_resident_size();
+  auto start_time = td::Time::now();
+
+  td::ClientManager client_manager;
+  td::vector<td::int32> client_ids;
+  for (int i = 0; i < client_count; i++) {
+    auto client_id = client_manager.create_client_id();
+    auto database_directory = PSTRING() << database_root << TD_DIR_SLASH << i;
+    client_manager.send(client_id, 1,
+                        td::td_api::make_object<td::td_api::setTdlibParameters>(
+                            true, database_directory, database_directory, td::string(), true, true, true, false, 94575,
+                            "a3406de8d171bb422bb6ddf3bbd800e2", "en", "Desktop", "Unknown", "1.0"));
+    client_ids.push_back(client_id);
+  }
+
+  auto wait_authorization_states = [&](td::int32 state_id) {
+    int ready_client_count = 0;
+    while (ready_client_count < client_count) {
+      auto response = client_manager.receive(10.0);
+      if (response.object == nullptr) {
+        continue;
+      }
+      if (response.object->get_id() == td::td_api::error::ID) {
+        LOG(FATAL) << "Receive " << to_string(response.object);
+      }
+      if (response.object->get_id() != td::td_api::updateAuthorizationState::ID) {
+        continue;
+      }
+      auto &state = static_cast<const td::td_api::updateAuthorizationState &>(*response.object).authorization_state_;
+      if (state_id == 0 ? state->get_id() != td::td_api::authorizationStateWaitTdlibParameters::ID
+                        : state->get_id() == state_id) {
+        ready_client_count++;
+      }
+    }
+  };
+  wait_authorization_states(0);
+
+  auto init_time = td::Time::now() - start_time;
+  auto resident_size = get_resident_size();
+  LOG(PLAIN) << "Started " << client_count << " clients in " << init_time << " seconds, "
+             << init_time / client_count * 1000 << " ms per client";
+  LOG(PLAIN) << "Resident memory size changed by " << get_resident_size_change(start_resident_size, resident_size, 1)
+             << ", " << get_resident_size_change(start_resident_size, resident_size, client_count) << " per client";
+
+  auto get_process_cpu_time = [](double wall_time, const td::CpuStat &start_stat, const td::CpuStat &finish_stat) {
+    auto total_ticks = finish_stat.total_ticks_ - start_stat.total_ticks_;
+    if (total_ticks == 0) {
+      return 0.0;
+    }
+    auto process_ticks = finish_stat.process_user_ticks_ + finish_stat.process_system_ticks_ -
+                         start_stat.process_user_ticks_ - start_stat.process_system_ticks_;
+    // total ticks are counted for all processors
+    return static_cast<double>(process_ticks) / static_cast<double>(total_ticks) * td::thread::hardware_concurrency() *
+           wall_time;
+  };
+
+  if (idle_seconds > 0) {
+    auto r_start_cpu_stat = td::cpu_stat();
+    auto idle_start_time = td::Time::now();
+    while (td::Time::now() < idle_start_time + idle_seconds) {
+      client_manager.receive(idle_start_time + idle_seconds - td::Time::now());
+    }
+    auto r_finish_cpu_stat = td::cpu_stat();
+    if (r_start_cpu_stat.is_ok() && r_finish_cpu_stat.is_ok()) {
+      auto cpu_time = get_process_cpu_time(td::Time::now() - idle_start_time, r_start_cpu_stat.ok(),
+                                           r_finish_cpu_stat.ok());
+      LOG(PLAIN) << "Idle clients used " << cpu_time / idle_seconds * 100 << "% of a CPU, "
+                 << cpu_time / idle_seconds / client_count * 1e6 << " microseconds of CPU time per client per second";
+    }
+    auto idle_resident_size = get_resident_size();
+    LOG(PLAIN) << "Resident memory size of idle clients is " << td::format::as_size(idle_resident_size) << ", "
+               << get_resident_size_change(start_resident_size, idle_resident_size, client_count) << " per client";
+  }
+
+  // all clients receive requests simultaneously, so latencies show fairness of scheduling between the clients
+  auto r_start_cpu_stat = td::cpu_stat();
+  auto busy_start_time = td::Time::now();
+  for (int i = 0; i < requests_per_client; i++) {
+    for (auto client_id : client_ids) {
+      client_manager.send(client_id, 3, td::td_api::make_object<td::td_api::testCallString>("bench_client"));
+    }
+  }
+  td::vector<double> latencies;
+  td::FlatHashMap<td::int32, int> finished_request_counts;
+  td::vector<double> client_finish_times;
+  auto total_request_count = static_cast<size_t>(client_count) * requests_per_client;
+  while (latencies.size() < total_request_count) {
+    auto response = client_manager.receive(10.0);
+    if (response.object == nullptr || response.request_id != 3) {
+      continue;
+    }
+    auto latency = td::Time::now() - busy_start_time;
+    latencies.push_back(latency);
+    if (++finished_request_counts[response.client_id] == requests_per_client) {
+      client_finish_times.push_back(latency);
+    }
+  }
+  auto busy_time = td::Time::now() - busy_start_time;
+  auto r_finish_cpu_stat = td::cpu_stat();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto get_percentile = [&latencies](double percentile) {
+    auto index = static_cast<size_t>(percentile * static_cast<double>(latencies.size() - 1) / 100.0);
+    return latencies[index] * 1000;
+  };
+  LOG(PLAIN) << "Processed " << total_request_count << " simultaneous requests in " << busy_time << " seconds, "
+             << static_cast<double>(total_request_count) / busy_time << " requests per second";
+  LOG(PLAIN) << "Response time in ms: p50 = " << get_percentile(50) << ", p90 = " << get_percentile(90)
+             << ", p99 = " << get_percentile(99) << ", max = " << get_percentile(100);
+  if (!client_finish_times.empty()) {
+    std::sort(client_finish_times.begin(), client_finish_times.end());
+    LOG(PLAIN) << "Clients finished their requests in " << client_finish_times[0] * 1000 << "-"
+               << client_finish_times.back() * 1000 << " ms";
+  }
+  if (r_start_cpu_stat.is_ok() && r_finish_cpu_stat.is_ok()) {
+    auto cpu_time = get_process_cpu_time(busy_time, r_start_cpu_stat.ok(), r_finish_cpu_stat.ok());
+    LOG(PLAIN) << "Used " << cpu_time / static_cast<double>(total_request_count) * 1e6
+               << " microseconds of CPU time per request";
+  }
+
+  auto close_start_time = td::Time::now();
+  for (auto client_id : client_ids) {
+    if (use_destroy) {
+      client_manager.send(client_id, 2, td::td_api::make_object<td::td_api::destroy>());
+    } else {
+      client_manager.send(client_id, 2, td::td_api::make_object<td::td_api::close>());
+    }
+  }
+  wait_authorization_states(td::td_api::authorizationStateClosed::ID);
+  auto close_time = td::Time::now() - close_start_time;
+  LOG(PLAIN) << (use_destroy ? "Destroyed " : "Closed ") << client_count << " clients in " << close_time
+             << " seconds, " << close_time / client_count * 1000 << " ms per client";
+
+  auto remove_start_time = td::Time::now();
+  td::rmrf(database_root).ignore();
+  LOG(PLAIN) << "Removed database directories in " << td::Time::now() - remove_start_time << " seconds";
+}
@@ -8,10 +8,12 @@
 
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
+#include "td/utils/logging.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/StringBuilder.h"
 #include "td/utils/UInt.h"
 
 #include <openssl/evp.h>
@@ -233,6 +235,63 @@ class AesIgeDecryptBench final : public td::Benchmark {
   }
 };
 
+template <bool is_encrypt, int buffer_count>
+class AesIgeBatchBench final : public td::Benchmark {
+ public:
+  static constexpr int BUFFER_SIZE = 64 << 10;
+
+  std::string get_description() const final {
+    return PSTRING() << "AES IGE " << (buffer_count == 1 ? "single" : "batch") << ' '
+                     << (is_encrypt ? "encrypt" : "decrypt") << " [" << buffer_count << 'x' << (BUFFER_SIZE >> 10)
+                     << "KB]";
+  }
+
+  void start_up() final {
+    data_.resize(buffer_count);
+    buffers_.resize(buffer_count);
+    for (int i = 0; i < buffer_count; i++) {
+      data_[i] = td::string(BUFFER_SIZE, '\x7b');
+      td::Random::secure_bytes(buffers_[i].key.raw, sizeof(buffers_[i].key));
+      td::Random::secure_bytes(buffers_[i].iv.raw, sizeof(buffers_[i].iv));
+      buffers_[i].data = data_[i];
+    }
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      if (is_encrypt) {
+        td::aes_ige_encrypt_batch(buffers_);
+      } else {
+        td::aes_ige_decrypt_batch(buffers_);
+      }
+    }
+  }
+
+  static std::size_t get_run_size() {
+    return static_cast<std::size_t>(buffer_count) * BUFFER_SIZE;
+  }
+
+ private:
+  td::vector<td::string> data_;
+  td::vector<td::AesIgeBuffer> buffers_;
+};
+
+template <class BenchT>
+static void bench_throughput(BenchT &&b) {
+  int n = 16;
+  double time = 0.0;
+  while (true) {
+    time = td::bench_n(b, n).first;
+    if (time >= 0.5 || n >= (1 << 24)) {
+      break;
+    }
+    n *= 2;
+  }
+  auto speed = static_cast<double>(BenchT::get_run_size()) * n / time / 1e9;
+  LOG(ERROR) << "Throughput [" << b.get_description() << "]: " << td::StringBuilder::FixedDouble(speed, 3)
+             << " GB/s";
+}
+
 class AesCtrBench final : public td::Benchmark {
  public:
   alignas(64) unsigned char data[DATA_SIZE];
@@ -501,6 +560,10 @@ int main() {
   td::bench(AesIgeShortBench<false>());
   td::bench(AesIgeEncryptBench());
   td::bench(AesIgeDecryptBench());
+  bench_throughput(AesIgeBatchBench<true, 1>());
+  bench_throughput(AesIgeBatchBench<true, 8>());
+  bench_throughput(AesIgeBatchBench<false, 1>());
+  bench_throughput(AesIgeBatchBench<false, 8>());
   td::bench(AesEcbBench());
 
   td::bench(Pbkdf2Bench());
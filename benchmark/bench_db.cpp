@@ -19,8 +19,11 @@
 
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/RwMutex.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
@@ -230,6 +233,87 @@ class BinlogKeyValueBench final : public td::Benchmark {
   }
 };
 
+// the previous implementation of BinlogKeyValue::get, which always takes the read lock
+class RwMutexKeyValue {
+ public:
+  void set(td::string key, td::string value) {
+    auto lock = rw_mutex_.lock_write().move_as_ok();
+    map_[std::move(key)] = std::move(value);
+  }
+
+  td::string get(const td::string &key) {
+    auto lock = rw_mutex_.lock_read().move_as_ok();
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return td::string();
+    }
+    return it->second;
+  }
+
+ private:
+  td::FlatHashMap<td::string, td::string> map_;
+  td::RwMutex rw_mutex_;
+};
+
+template <class KeyValueT>
+class KeyValueGetBench final : public td::Benchmark {
+ public:
+  KeyValueGetBench(td::string name, int thread_count) : name_(std::move(name)), thread_count_(thread_count) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << name_ << " concurrent get " << td::tag("thread_count", thread_count_);
+  }
+
+  void start_up() final {
+    for (int i = 0; i < KEY_COUNT; i++) {
+      kv_.set(PSTRING() << "key" << i, PSTRING() << "value" << i);
+    }
+  }
+
+  void run(int n) final {
+    td::vector<td::thread> threads;
+    for (int i = 0; i < thread_count_; i++) {
+      threads.emplace_back([&, i] {
+        td::uint64 result = 0;
+        for (int j = 0; j < n; j++) {
+          result += kv_.get(PSTRING() << "key" << (i + j) % KEY_COUNT).size();
+        }
+        CHECK(result > 0);
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+ private:
+  static constexpr int KEY_COUNT = 100;
+
+  td::string name_;
+  int thread_count_;
+  KeyValueT kv_;
+};
+
+class BinlogKeyValueWrapper {
+ public:
+  BinlogKeyValueWrapper() {
+    td::Binlog::destroy("test_binlog_get").ignore();
+    kv_.init("test_binlog_get").ensure();
+  }
+
+  void set(td::string key, td::string value) {
+    kv_.set(std::move(key), std::move(value));
+  }
+
+  td::string get(const td::string &key) {
+    return kv_.get(key);
+  }
+
+ private:
+  td::BinlogKeyValue<td::Binlog> kv_;
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
   bench(TdKvBench<td::BinlogKeyValue<td::Binlog>>("BinlogKeyValue<Binlog>"));
@@ -241,4 +325,9 @@ int main() {
   bench(SqliteKVBench<true>());
   bench(SqliteKeyValueAsyncBench());
   bench(SeqKvBench());
+
+  for (int thread_count : {1, 4, 16}) {
+    bench(KeyValueGetBench<RwMutexKeyValue>("RwMutex", thread_count));
+    bench(KeyValueGetBench<BinlogKeyValueWrapper>("BinlogKeyValue", thread_count));
+  }
 }
@@ -6,13 +6,19 @@
 //
 #include "td/mtproto/DhCallback.h"
 #include "td/mtproto/DhHandshake.h"
+#include "td/mtproto/RSA.h"
 
 #include "td/utils/base64.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 
 #include <map>
+#include <mutex>
 
 #if TD_LINUX || TD_ANDROID || TD_TIZEN
 #include <semaphore.h>
@@ -25,28 +31,34 @@ static td::string prime_base64 =
     "WC2xF40WnGvEZbDW_5yjko_vW5rk5Bj8Feg-vqD4f6n_Xu1wBQ3tKEn0e_lZ2VaFDOkphR8NgRX2NbEF7i5OFdBLJFS_b0-t8DSxBAMRnNjjuS_MW"
     "w";
 
+class FakeDhCallback final : public td::mtproto::DhCallback {
+ public:
+  int is_good_prime(td::Slice prime_str) const final {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = cache.find(prime_str.str());
+    if (it == cache.end()) {
+      return -1;
+    }
+    return it->second;
+  }
+  void add_good_prime(td::Slice prime_str) const final {
+    std::lock_guard<std::mutex> guard(mutex);
+    cache[prime_str.str()] = 1;
+  }
+  void add_bad_prime(td::Slice prime_str) const final {
+    std::lock_guard<std::mutex> guard(mutex);
+    cache[prime_str.str()] = 0;
+  }
+  mutable std::mutex mutex;
+  mutable std::map<td::string, int> cache;
+};
+
 class HandshakeBench final : public td::Benchmark {
   td::string get_description() const final {
     return "Handshake";
   }
 
-  class FakeDhCallback final : public td::mtproto::DhCallback {
-   public:
-    int is_good_prime(td::Slice prime_str) const final {
-      auto it = cache.find(prime_str.str());
-      if (it == cache.end()) {
-        return -1;
-      }
-      return it->second;
-    }
-    void add_good_prime(td::Slice prime_str) const final {
-      cache[prime_str.str()] = 1;
-    }
-    void add_bad_prime(td::Slice prime_str) const final {
-      cache[prime_str.str()] = 0;
-    }
-    mutable std::map<td::string, int> cache;
-  } dh_callback;
+  FakeDhCallback dh_callback;
 
   void run(int n) final {
     td::mtproto::DhHandshake a;
@@ -67,6 +79,73 @@ class HandshakeBench final : public td::Benchmark {
   }
 };
 
+// the client side computations of an auth key creation: RSA encryption of p_q_inner_data and DH key exchange
+// with an already checked prime; each thread creates n keys, so the result is the number of auth keys per core
+class AuthKeyCreationBench final : public td::Benchmark {
+  int thread_count_;
+  FakeDhCallback dh_callback_;
+  td::string prime_;
+  td::string server_g_a_;
+
+  td::string get_description() const final {
+    return PSTRING() << "Auth key creation per core with " << thread_count_ << " threads";
+  }
+
+  void start_up() final {
+    prime_ = td::base64url_decode(prime_base64).move_as_ok();
+    td::mtproto::DhHandshake::check_config(g, prime_, &dh_callback_).ensure();
+    td::mtproto::DhHandshake server;
+    server.set_config(g, prime_);
+    server_g_a_ = server.get_g_b();
+  }
+
+  void create_auth_keys(const td::mtproto::RSA &rsa, int n) {
+    td::string encrypted_data(256, '\0');
+    for (int i = 0; i < n; i++) {
+      td::string data(256, '\0');
+      td::Random::secure_bytes(td::MutableSlice(data).substr(1));
+      CHECK(rsa.encrypt(data, encrypted_data));
+
+      td::mtproto::DhHandshake handshake;
+      handshake.set_config(g, prime_);
+      handshake.set_g_a(server_g_a_);
+      handshake.run_checks(false, &dh_callback_).ensure();
+      td::do_not_optimize_away(handshake.gen_key().first);
+    }
+  }
+
+ public:
+  explicit AuthKeyCreationBench(int thread_count) : thread_count_(thread_count) {
+  }
+
+  void run(int n) final {
+    auto rsa = td::mtproto::RSA::from_pem_public_key(
+                   "-----BEGIN RSA PUBLIC KEY-----\n"
+                   "MIIBCgKCAQEA6LszBcC1LGzyr992NzE0ieY+BSaOW622Aa9Bd4ZHLl+TuFQ4lo4g\n"
+                   "5nKaMBwK/BIb9xUfg0Q29/2mgIR6Zr9krM7HjuIcCzFvDtr+L0GQjae9H0pRB2OO\n"
+                   "62cECs5HKhT5DZ98K33vmWiLowc621dQuwKWSQKjWf50XYFw42h21P2KXUGyp2y/\n"
+                   "+aEyZ+uVgLLQbRA1dEjSDZ2iGRy12Mk5gpYc397aYp438fsJoHIgJ2lgMv5h7WY9\n"
+                   "t6N/byY9Nw9p21Og3AoXSL2q/2IJ1WRUhebgAdGVMlV1fkuOQoEzR7EdpqtQD9Cs\n"
+                   "5+bfo3Nhmcyvk5ftB0WkJ9z6bNZ7yxrP8wIDAQAB\n"
+                   "-----END RSA PUBLIC KEY-----")
+                   .move_as_ok();
+#if !TD_THREAD_UNSUPPORTED
+    td::vector<td::thread> threads;
+    for (int i = 0; i < thread_count_; i++) {
+      threads.emplace_back([&] { create_auth_keys(rsa, n); });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+#else
+    create_auth_keys(rsa, n);
+#endif
+  }
+};
+
 int main() {
   td::bench(HandshakeBench());
+  for (int thread_count = 1; thread_count <= 16; thread_count *= 2) {
+    td::bench(AuthKeyCreationBench(thread_count));
+  }
 }
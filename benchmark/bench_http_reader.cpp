@@ -12,6 +12,7 @@
 #include "td/utils/common.h"
 #include "td/utils/find_boundary.h"
 #include "td/utils/logging.h"
+#include "td/utils/Slice.h"
 
 static std::string http_query = "GET / HTTP/1.1\r\nConnection:keep-alive\r\nhost:127.0.0.1:8080\r\n\r\n";
 static const size_t block_size = 2500;
@@ -111,9 +112,48 @@ class FindBoundaryBench final : public td::Benchmark {
   }
 };
 
+class FindMultipartBoundaryBench final : public td::Benchmark {
+  std::string get_description() const final {
+    return "FindMultipartBoundaryBench";
+  }
+
+  void run(int n) final {
+    for (int i = 0; i < n; i++) {
+      auto reader = reader_.clone();
+      size_t len = 0;
+      CHECK(find_boundary(std::move(reader), boundary_, len));
+      CHECK(len + boundary_.size() == body_size_);
+    }
+  }
+  std::string boundary_ = "\r\n--------------------------d74496d66958873e";
+  size_t body_size_ = 0;
+  td::ChainBufferWriter writer_;
+  td::ChainBufferReader reader_;
+
+  void start_up() final {
+    writer_ = {};
+    reader_ = writer_.extract_reader();
+
+    // a text file upload with short lines, which is received in TCP-sized chunks
+    std::string body;
+    while (body.size() < (1 << 20)) {
+      body += std::string(62, 'a');
+      body += "\r\n";
+    }
+    body += boundary_;
+    body_size_ = body.size();
+
+    for (size_t pos = 0; pos < body.size(); pos += 1400) {
+      writer_.append(td::BufferSlice(td::Slice(body).substr(pos, 1400)));
+    }
+    reader_.sync_with_writer();
+  }
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
   td::bench(BufferBench());
   td::bench(FindBoundaryBench());
+  td::bench(FindMultipartBoundaryBench());
   td::bench(HttpReaderBench());
 }
@@ -83,31 +83,58 @@ class HttpEchoConnection final : public td::Actor {
 };
 
 const int N = 8;
+// if true, each scheduler has its own listener and keeps accepted connections; the kernel balances connections
+// between the listeners, because ServerSocketFd is opened with SO_REUSEPORT
+const bool LISTEN_ON_EACH_SCHEDULER = true;
+
 class Server final : public td::TcpListener::Callback {
  public:
   void start_up() final {
     listener_ =
         td::create_actor<td::TcpListener>("Listener", 8082, td::ActorOwn<td::TcpListener::Callback>(actor_id(this)));
+    set_timeout_in(STATS_PERIOD);
   }
   void accept(td::SocketFd fd) final {
+    accepted_count_++;
+    if (LISTEN_ON_EACH_SCHEDULER) {
+      td::create_actor<HttpEchoConnection>("HttpEchoConnection", std::move(fd)).release();
+      return;
+    }
     pos_++;
     auto scheduler_id = pos_ % (N != 0 ? N : 1) + (N != 0);
     td::create_actor_on_scheduler<HttpEchoConnection>("HttpEchoConnection", scheduler_id, std::move(fd)).release();
   }
+  void timeout_expired() final {
+    if (accepted_count_ != 0) {
+      LOG(ERROR) << "Scheduler " << td::Scheduler::instance()->sched_id() << " accepted " << accepted_count_
+                 << " connections in " << STATS_PERIOD << " seconds";
+      accepted_count_ = 0;
+    }
+    set_timeout_in(STATS_PERIOD);
+  }
   void hangup() final {
     LOG(ERROR) << "Hanging up..";
     stop();
   }
 
  private:
+  static constexpr double STATS_PERIOD = 10.0;
+
   td::ActorOwn<td::TcpListener> listener_;
   int pos_{0};
+  int accepted_count_{0};
 };
 
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   auto scheduler = td::make_unique<td::ConcurrentScheduler>(N, 0);
-  scheduler->create_actor_unsafe<Server>(0, "Server").release();
+  if (LISTEN_ON_EACH_SCHEDULER) {
+    for (int scheduler_id = N != 0; scheduler_id <= N; scheduler_id++) {
+      scheduler->create_actor_unsafe<Server>(scheduler_id, "Server").release();
+    }
+  } else {
+    scheduler->create_actor_unsafe<Server>(0, "Server").release();
+  }
   scheduler->start();
   while (scheduler->run_main(10)) {
     // empty
@@ -0,0 +1,188 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/td_json_client.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/common.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/format.h"
+#include "td/utils/JsonBuilder.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+// measures the full request pipeline from the JSON interface through Td to the response without network access;
+// usage: bench_json_client [request_count] [max_pending_request_count] [file with a JSON request per line]
+int main(int argc, char **argv) {
+  int request_count = argc > 1 ? td::to_integer<int>(td::Slice(argv[1])) : 100000;
+  int max_pending_request_count = argc > 2 ? td::to_integer<int>(td::Slice(argv[2])) : 100;
+  if (request_count <= 0 || max_pending_request_count <= 0) {
+    std::exit(2);
+  }
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  td_execute("{\"@type\":\"setLogVerbosityLevel\",\"new_verbosity_level\":0}");
+
+  td::vector<td::string> requests;
+  if (argc > 3) {
+    auto r_content = td::read_file_str(td::CSlice(argv[3]));
+    if (r_content.is_error()) {
+      LOG(PLAIN) << "Can't read requests: " << r_content.error();
+      std::exit(2);
+    }
+    for (auto &request : td::full_split(r_content.ok(), '\n')) {
+      request = td::trim(request);
+      if (!request.empty()) {
+        requests.push_back(std::move(request));
+      }
+    }
+  } else {
+    // synchronous requests are executed without Td and would measure only the JSON interface, so they aren't used
+    requests = {"{\"@type\":\"testSquareInt\",\"x\":12}", "{\"@type\":\"testCallString\",\"x\":\"benchmark\"}",
+                "{\"@type\":\"testCallVectorString\",\"x\":[\"alpha\",\"beta\",\"gamma\"]}",
+                "{\"@type\":\"getCurrentState\"}"};
+  }
+  if (requests.empty() || !td::all_of(requests, [](const td::string &request) { return request[0] == '{'; })) {
+    LOG(PLAIN) << "Requests must be JSON objects";
+    std::exit(2);
+  }
+
+  const td::string database_directory = "bench_json_client_db";
+  td::rmrf(database_directory).ignore();
+
+  auto get_resident_size = [] {
+    auto r_mem_stat = td::mem_stat();
+    return r_mem_stat.is_ok() ? r_mem_stat.ok().resident_size_ : 0;
+  };
+
+  auto client_id = td_create_client_id();
+  auto send = [client_id](td::Slice request, td::int64 extra) {
+    auto query = PSTRING() << "{\"@extra\":" << extra << ',' << request.substr(1);
+    td_send(client_id, query.c_str());
+  };
+  send("{\"@type\":\"setNetworkType\",\"type\":{\"@type\":\"networkTypeNone\"}}", 0);
+  send(PSLICE() << "{\"@type\":\"setTdlibParameters\",\"use_test_dc\":true,\"database_directory\":\""
+                << database_directory << "\",\"use_file_database\":true,\"use_chat_info_database\":true,"
+                << "\"use_message_database\":true,\"api_id\":94575,\"api_hash\":\"a3406de8d171bb422bb6ddf3bbd800e2\","
+                << "\"system_language_code\":\"en\",\"device_model\":\"Desktop\",\"application_version\":\"1.0\"}",
+       0);
+
+  td::vector<double> send_times(request_count, 0.0);
+  td::vector<double> latencies;
+  latencies.reserve(request_count);
+  td::int64 error_count = 0;
+  bool is_initialized = false;
+
+  // returns identifier of the request, to which the response was received, or 0
+  auto receive = [&] {
+    const char *result = td_receive(10.0);
+    if (result == nullptr) {
+      LOG(FATAL) << "Receive no response in 10 seconds";
+    }
+    auto receive_time = td::Time::now();
+    td::string json(result);
+    auto r_value = td::json_decode(json);
+    if (r_value.is_error() || r_value.ok().type() != td::JsonValue::Type::Object) {
+      LOG(FATAL) << "Receive invalid JSON " << result;
+    }
+    auto value = r_value.move_as_ok();
+    auto &object = value.get_object();
+    auto type = object.get_optional_string_field("@type").move_as_ok();
+    auto extra = object.get_optional_long_field("@extra").move_as_ok();
+    if (extra == 0) {
+      if (type == "updateAuthorizationState") {
+        auto r_state = object.extract_optional_field("authorization_state", td::JsonValue::Type::Object);
+        if (r_state.is_ok() && r_state.ok().type() == td::JsonValue::Type::Object) {
+          auto state_type = r_state.ok().get_object().get_optional_string_field("@type").move_as_ok();
+          if (state_type != "authorizationStateWaitTdlibParameters") {
+            is_initialized = true;
+          }
+        }
+      }
+      return static_cast<td::int64>(0);
+    }
+    if (type == "error") {
+      error_count++;
+    }
+    if (extra > 0 && extra <= request_count) {
+      latencies.push_back(receive_time - send_times[static_cast<size_t>(extra - 1)]);
+    }
+    return extra;
+  };
+
+  auto init_start_time = td::Time::now();
+  while (!is_initialized) {
+    receive();
+  }
+  auto init_time = td::Time::now() - init_start_time;
+
+  auto start_resident_size = get_resident_size();
+  auto r_start_cpu_stat = td::cpu_stat();
+  auto start_time = td::Time::now();
+  int sent_request_count = 0;
+  int finished_request_count = 0;
+  while (finished_request_count < request_count) {
+    while (sent_request_count < request_count &&
+           sent_request_count - finished_request_count < max_pending_request_count) {
+      send_times[sent_request_count] = td::Time::now();
+      send(requests[sent_request_count % requests.size()], sent_request_count + 1);
+      sent_request_count++;
+    }
+    if (receive() > 0) {
+      finished_request_count++;
+    }
+  }
+  auto total_time = td::Time::now() - start_time;
+  auto r_finish_cpu_stat = td::cpu_stat();
+  auto finish_resident_size = get_resident_size();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto get_percentile = [&latencies](double percentile) {
+    CHECK(!latencies.empty());
+    auto index = static_cast<size_t>(percentile * static_cast<double>(latencies.size() - 1) / 100.0);
+    return latencies[index] * 1000;
+  };
+
+  LOG(PLAIN) << "Initialized the client in " << init_time << " seconds";
+  LOG(PLAIN) << "Processed " << request_count << " requests of " << requests.size() << " kinds in " << total_time
+             << " seconds, " << static_cast<double>(request_count) / total_time << " requests per second, "
+             << error_count << " errors";
+  LOG(PLAIN) << "Request latency in ms: p50 = " << get_percentile(50) << ", p90 = " << get_percentile(90)
+             << ", p99 = " << get_percentile(99) << ", max = " << get_percentile(100);
+  if (r_start_cpu_stat.is_ok() && r_finish_cpu_stat.is_ok()) {
+    const auto &start_cpu_stat = r_start_cpu_stat.ok();
+    const auto &finish_cpu_stat = r_finish_cpu_stat.ok();
+    auto total_ticks = finish_cpu_stat.total_ticks_ - start_cpu_stat.total_ticks_;
+    auto process_ticks = finish_cpu_stat.process_user_ticks_ + finish_cpu_stat.process_system_ticks_ -
+                         start_cpu_stat.process_user_ticks_ - start_cpu_stat.process_system_ticks_;
+    if (total_ticks > 0) {
+      // total ticks are counted for all processors
+      auto cpu_time = static_cast<double>(process_ticks) / static_cast<double>(total_ticks) *
+                      td::thread::hardware_concurrency() * total_time;
+      LOG(PLAIN) << "Used " << cpu_time << " seconds of CPU time, " << cpu_time / request_count * 1e6
+                 << " microseconds per request";
+    }
+  }
+  LOG(PLAIN) << "Resident memory size is " << td::format::as_size(finish_resident_size) << ", changed by "
+             << static_cast<td::int64>(finish_resident_size) - static_cast<td::int64>(start_resident_size) << " bytes";
+
+  send("{\"@type\":\"close\"}", 0);
+  while (true) {
+    const char *result = td_receive(10.0);
+    if (result == nullptr || td::string(result).find("authorizationStateClosed") != td::string::npos) {
+      break;
+    }
+  }
+  td::rmrf(database_directory).ignore();
+}
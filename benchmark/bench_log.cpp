@@ -4,13 +4,17 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/utils/AsyncFileLog.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/SliceBuilder.h"
 
 #include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <ostream>
 #include <streambuf>
 #include <string>
@@ -150,8 +154,52 @@ class LogWriteBench final : public td::Benchmark {
   }
 };
 
+#if !TD_THREAD_UNSUPPORTED
+class AsyncFileLogWriteBench final : public td::Benchmark {
+  std::string file_name_;
+  int thread_count_;
+
+ public:
+  explicit AsyncFileLogWriteBench(int thread_count) : thread_count_(thread_count) {
+  }
+
+  std::string get_description() const final {
+    return PSTRING() << "AsyncFileLog from " << thread_count_ << " threads";
+  }
+
+  void start_up() final {
+    file_name_ = create_tmp_file();
+  }
+
+  void run(int n) final {
+    // the log is destroyed after all lines are written to the file
+    td::AsyncFileLog log;
+    log.init(file_name_, std::numeric_limits<td::int64>::max(), false).ensure();
+    td::vector<td::thread> threads;
+    for (int i = 0; i < thread_count_; i++) {
+      threads.emplace_back([&log, n] {
+        for (int j = 0; j < n; j++) {
+          log.append(VERBOSITY_NAME(DEBUG), "This is just for test987654321\n");
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  void tear_down() final {
+    unlink(file_name_.c_str());
+  }
+};
+#endif
+
 int main() {
   td::bench(LogWriteBench());
+#if !TD_THREAD_UNSUPPORTED
+  td::bench(AsyncFileLogWriteBench(1));
+  td::bench(AsyncFileLogWriteBench(4));
+#endif
 #if TD_ANDROID
   td::bench(ALogWriteBench());
 #endif
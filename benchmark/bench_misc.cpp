@@ -4,21 +4,35 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/telegram/DialogDate.h"
+#include "td/telegram/DialogId.h"
+#include "td/telegram/MessageEntity.h"
+#include "td/telegram/MessageId.h"
+#include "td/telegram/OrderedMessage.h"
+#include "td/telegram/ServerMessageId.h"
 #include "td/telegram/td_api.h"
 #include "td/telegram/telegram_api.h"
 #include "td/telegram/telegram_api.hpp"
 
 #include "td/utils/algorithm.h"
 #include "td/utils/benchmark.h"
+#include "td/utils/buffer.h"
+#include "td/utils/BufferedUdp.h"
+#include "td/utils/ChainScheduler.h"
+#include "td/utils/ChunkedSet.h"
 #include "td/utils/common.h"
+#include "td/utils/Hints.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/EventFd.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/IPAddress.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/PollFlags.h"
 #include "td/utils/port/RwMutex.h"
 #include "td/utils/port/Stat.h"
 #include "td/utils/port/thread.h"
+#include "td/utils/port/UdpSocketFd.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -26,6 +40,8 @@
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/ThreadSafeCounter.h"
+#include "td/utils/tl_storers.h"
+#include "td/utils/utf8.h"
 
 #if !TD_WINDOWS
 #include <unistd.h>
@@ -41,6 +57,7 @@
 #include <atomic>
 #include <cstdint>
 #include <set>
+#include <utility>
 
 class F {
   td::uint32 &sum;
@@ -126,6 +143,67 @@ BENCH(TlToStringMessage, "TL to_string message") {
   td::do_not_optimize_away(res);
 }
 
+static td::telegram_api::object_ptr<td::telegram_api::Function> get_send_album_query() {
+  td::vector<td::telegram_api::object_ptr<td::telegram_api::inputSingleMedia>> multi_media;
+  for (int i = 0; i < 10; i++) {
+    td::vector<td::telegram_api::object_ptr<td::telegram_api::MessageEntity>> entities;
+    for (int j = 0; j < 100; j++) {
+      entities.push_back(td::telegram_api::make_object<td::telegram_api::messageEntityBold>(j * 10, 5));
+    }
+    auto input_photo =
+        td::telegram_api::make_object<td::telegram_api::inputPhoto>(123456 + i, 654321, td::BufferSlice("reference"));
+    multi_media.push_back(td::telegram_api::make_object<td::telegram_api::inputSingleMedia>(
+        td::telegram_api::inputSingleMedia::ENTITIES_MASK,
+        td::telegram_api::make_object<td::telegram_api::inputMediaPhoto>(0, false, std::move(input_photo), 0),
+        1000 + i, td::string(1000, 'a'), std::move(entities)));
+  }
+  return td::telegram_api::make_object<td::telegram_api::messages_sendMultiMedia>(
+      0, false, false, false, false, false, false,
+      td::telegram_api::make_object<td::telegram_api::inputPeerChannel>(123456, 654321), nullptr,
+      std::move(multi_media), 0, nullptr, nullptr);
+}
+
+static td::telegram_api::object_ptr<td::telegram_api::Function> get_read_history_query() {
+  return td::telegram_api::make_object<td::telegram_api::messages_readHistory>(
+      td::telegram_api::make_object<td::telegram_api::inputPeerChannel>(123456, 654321), 123456);
+}
+
+class TlStoreBench final : public td::Benchmark {
+  td::string name_;
+  td::telegram_api::object_ptr<td::telegram_api::Function> query_;
+  bool is_single_pass_;
+
+ public:
+  TlStoreBench(td::string name, td::telegram_api::object_ptr<td::telegram_api::Function> query, bool is_single_pass)
+      : name_(std::move(name)), query_(std::move(query)), is_single_pass_(is_single_pass) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "TL store " << name_ << (is_single_pass_ ? " in a single pass" : " in two passes");
+  }
+
+  void run(int n) final {
+    std::size_t res = 0;
+    td::string buffer;
+    for (int i = 0; i < n; i++) {
+      if (is_single_pass_) {
+        td::TlStorerGrowable storer(buffer);
+        query_->store(storer);
+        td::BufferSlice slice(storer.as_slice());
+        res += slice.size();
+      } else {
+        td::TlStorerCalcLength storer_calc_length;
+        query_->store(storer_calc_length);
+        td::BufferSlice slice(storer_calc_length.get_length());
+        td::TlStorerUnsafe storer(slice.as_mutable_slice().ubegin());
+        query_->store(storer);
+        res += slice.size();
+      }
+    }
+    td::do_not_optimize_away(res);
+  }
+};
+
 #if !TD_EVENTFD_UNSUPPORTED
 BENCH(EventFd, "EventFd") {
   td::EventFd fd;
@@ -222,6 +300,52 @@ class PipeBench final : public td::Benchmark {
 };
 #endif
 
+#if TD_PORT_POSIX
+class UdpBench final : public td::Benchmark {
+ public:
+  td::string get_description() const final {
+    return "BufferedUdp send + receive 100-byte datagram";
+  }
+
+  void start_up() final {
+    address_.init_ipv4_port("127.0.0.1", 22889).ensure();
+    fd_ = td::make_unique<td::BufferedUdp>(td::UdpSocketFd::open(address_).move_as_ok());
+  }
+
+  void run(int n) final {
+    constexpr int BURST_SIZE = 64;
+    td::string data(100, 'a');
+    for (int i = 0; i < n; i += BURST_SIZE) {
+      for (int j = 0; j < BURST_SIZE; j++) {
+        fd_->send(td::UdpMessage{address_, td::BufferSlice(data), td::Status::OK()});
+      }
+      fd_->get_poll_info().add_flags(td::PollFlags::Write());
+      fd_->flush_send().ensure();
+
+      int received = 0;
+      while (received < BURST_SIZE) {
+        fd_->get_poll_info().add_flags(td::PollFlags::Read());
+        auto message = fd_->receive().move_as_ok();
+        if (!message) {
+          break;
+        }
+        received++;
+      }
+      CHECK(received == BURST_SIZE);
+    }
+  }
+
+  void tear_down() final {
+    fd_->close();
+    fd_ = nullptr;
+  }
+
+ private:
+  td::IPAddress address_;
+  td::unique_ptr<td::BufferedUdp> fd_;
+};
+#endif
+
 #if TD_LINUX || TD_ANDROID || TD_TIZEN
 class SemBench final : public td::Benchmark {
   sem_t sem;
@@ -698,6 +822,268 @@ class DuplicateCheckerBenchEvenOdd final : public td::Benchmark {
   }
 };
 
+// identifiers of messages in the order they are usually added to a chat history:
+// history is loaded from the newest messages to the oldest by batches, and new messages are added at the end
+static td::vector<td::MessageId> get_ordered_message_ids(int n) {
+  td::vector<td::MessageId> message_ids;
+  td::int32 first_server_message_id = 1000000;
+  td::int32 last_server_message_id = 1000000;
+  while (static_cast<int>(message_ids.size()) < n) {
+    if (td::Random::fast(0, 3) == 0) {
+      for (int i = 0; i < 10 && static_cast<int>(message_ids.size()) < n; i++) {
+        last_server_message_id += td::Random::fast(1, 3);
+        message_ids.push_back(td::MessageId(td::ServerMessageId(last_server_message_id)));
+      }
+    } else {
+      for (int i = 0; i < 100 && static_cast<int>(message_ids.size()) < n && first_server_message_id > 3; i++) {
+        first_server_message_id -= td::Random::fast(1, 3);
+        message_ids.push_back(td::MessageId(td::ServerMessageId(first_server_message_id)));
+      }
+    }
+  }
+  return message_ids;
+}
+
+class OrderedMessagesInsertBench final : public td::Benchmark {
+  td::vector<td::MessageId> message_ids_;
+
+  td::string get_description() const final {
+    return "OrderedMessages insert";
+  }
+  void start_up_n(int n) final {
+    message_ids_ = get_ordered_message_ids(n);
+  }
+  void run(int n) final {
+    td::OrderedMessages ordered_messages;
+    for (auto message_id : message_ids_) {
+      ordered_messages.insert(message_id, true, td::MessageId(), "bench");
+    }
+    CHECK(!ordered_messages.empty());
+  }
+};
+
+class OrderedMessagesEraseBench final : public td::Benchmark {
+  td::OrderedMessages ordered_messages_;
+  td::vector<td::MessageId> message_ids_;
+
+  td::string get_description() const final {
+    return "OrderedMessages erase";
+  }
+  void start_up_n(int n) final {
+    ordered_messages_ = td::OrderedMessages();
+    message_ids_ = get_ordered_message_ids(n);
+    for (auto message_id : message_ids_) {
+      ordered_messages_.insert(message_id, true, td::MessageId(), "bench");
+    }
+    for (size_t i = 1; i < message_ids_.size(); i++) {
+      std::swap(message_ids_[i], message_ids_[td::Random::fast(0, static_cast<int>(i))]);
+    }
+  }
+  void run(int n) final {
+    for (auto message_id : message_ids_) {
+      ordered_messages_.erase(message_id, td::Random::fast_bool());
+    }
+    CHECK(ordered_messages_.empty());
+  }
+};
+
+class OrderedMessagesIterateBench final : public td::Benchmark {
+  static constexpr int MESSAGE_COUNT = 100000;
+
+  td::OrderedMessages ordered_messages_;
+  td::vector<td::MessageId> message_ids_;
+
+  td::string get_description() const final {
+    return "OrderedMessages iterate 100 messages";
+  }
+  void start_up() final {
+    ordered_messages_ = td::OrderedMessages();
+    message_ids_ = get_ordered_message_ids(MESSAGE_COUNT);
+    for (auto message_id : message_ids_) {
+      ordered_messages_.insert(message_id, true, td::MessageId(), "bench");
+    }
+  }
+  void run(int n) final {
+    td::uint64 sum = 0;
+    for (int i = 0; i < n; i++) {
+      auto from_message_id = message_ids_[td::Random::fast(0, MESSAGE_COUNT - 1)];
+      int left = 100;
+      for (auto it = ordered_messages_.get_const_iterator(from_message_id); *it && left > 0; --it, left--) {
+        sum += static_cast<td::uint64>((*it)->get_message_id().get());
+      }
+    }
+    td::do_not_optimize_away(sum);
+  }
+};
+
+template <class SetT>
+class DialogOrderUpdateBench final : public td::Benchmark {
+  static constexpr int DIALOG_COUNT = 500000;
+
+  SetT ordered_dialogs_;
+  td::vector<td::int64> orders_;
+  td::int64 max_order_ = 0;
+  td::string description_;
+
+ public:
+  explicit DialogOrderUpdateBench(td::string description) : description_(std::move(description)) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << description_ << " move a chat to the top of " << DIALOG_COUNT << " chats";
+  }
+  void start_up() final {
+    ordered_dialogs_ = SetT();
+    orders_.clear();
+    for (int i = 0; i < DIALOG_COUNT; i++) {
+      orders_.push_back(++max_order_);
+    }
+    for (size_t i = 1; i < orders_.size(); i++) {
+      std::swap(orders_[i], orders_[td::Random::fast(0, static_cast<int>(i))]);
+    }
+    for (int i = 0; i < DIALOG_COUNT; i++) {
+      ordered_dialogs_.insert(td::DialogDate(orders_[i], td::DialogId(static_cast<td::int64>(i + 1))));
+    }
+  }
+  void run(int n) final {
+    td::int64 sum = 0;
+    for (int i = 0; i < n; i++) {
+      // new message in a random chat, as in set_dialog_order
+      auto pos = td::Random::fast(0, DIALOG_COUNT - 1);
+      td::DialogId dialog_id(static_cast<td::int64>(pos + 1));
+      CHECK(ordered_dialogs_.erase(td::DialogDate(orders_[pos], dialog_id)) == 1);
+      orders_[pos] = ++max_order_;
+      ordered_dialogs_.insert(td::DialogDate(orders_[pos], dialog_id));
+
+      if ((i & 15) == 0) {
+        // getChats with a random offset, as in get_dialogs
+        auto offset_pos = td::Random::fast(0, DIALOG_COUNT - 1);
+        auto offset = td::DialogDate(orders_[offset_pos], td::DialogId(static_cast<td::int64>(offset_pos + 1)));
+        int left = 100;
+        for (auto it = ordered_dialogs_.upper_bound(offset); it != ordered_dialogs_.end() && left > 0; ++it, left--) {
+          sum += it->get_dialog_id().get();
+        }
+      }
+    }
+    td::do_not_optimize_away(sum);
+  }
+};
+
+class HintsSearchBench final : public td::Benchmark {
+  static constexpr int NAME_COUNT = 500000;
+
+  td::Hints hints_;
+  size_t prefix_length_;
+
+  static td::string gen_word(size_t min_length) {
+    td::string result;
+    auto length = td::Random::fast(static_cast<int>(min_length), 9);
+    for (int i = 0; i < length; i++) {
+      result += static_cast<char>(td::Random::fast('a', 'z'));
+    }
+    return result;
+  }
+
+ public:
+  explicit HintsSearchBench(size_t prefix_length) : prefix_length_(prefix_length) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Hints search by a prefix of length " << prefix_length_ << " among " << NAME_COUNT
+                     << " names";
+  }
+  void start_up() final {
+    if (hints_.size() != 0) {
+      return;
+    }
+    for (int i = 1; i <= NAME_COUNT; i++) {
+      hints_.add(i, PSLICE() << gen_word(3) << ' ' << gen_word(3));
+      hints_.set_rating(i, td::Random::fast(0, 1000000));
+    }
+  }
+  void run(int n) final {
+    size_t sum = 0;
+    for (int i = 0; i < n; i++) {
+      sum += hints_.search(gen_word(prefix_length_).substr(0, prefix_length_), 50).first;
+    }
+    td::do_not_optimize_away(sum);
+  }
+};
+
+class HintsAddBench final : public td::Benchmark {
+  td::string description_;
+  td::vector<td::string> names_;
+
+ public:
+  HintsAddBench(td::string description, td::vector<td::string> words) : description_(std::move(description)) {
+    for (int i = 0; i < 1000; i++) {
+      names_.push_back(PSTRING() << words[td::Random::fast(0, static_cast<int>(words.size()) - 1)] << ' '
+                                 << words[td::Random::fast(0, static_cast<int>(words.size()) - 1)] << ' ' << i);
+    }
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Hints add of " << description_ << " chat titles";
+  }
+  void run(int n) final {
+    td::Hints hints;
+    for (int i = 0; i < n; i++) {
+      hints.add(i, names_[i % names_.size()]);
+    }
+    td::do_not_optimize_away(hints.size());
+  }
+};
+
+class FindEntitiesBench final : public td::Benchmark {
+  td::string description_;
+  td::string text_;
+
+ public:
+  FindEntitiesBench(td::string description, td::Slice paragraph) : description_(std::move(description)) {
+    // a long channel post
+    for (int i = 0; i < 50; i++) {
+      text_ += paragraph.str();
+      text_ += '\n';
+    }
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "find_entities in " << description_ << " text of size " << text_.size();
+  }
+  void run(int n) final {
+    size_t sum = 0;
+    for (int i = 0; i < n; i++) {
+      sum += td::find_entities(text_, false, false).size();
+    }
+    td::do_not_optimize_away(sum);
+  }
+};
+
+class Utf8Bench final : public td::Benchmark {
+  td::string description_;
+  td::string text_;
+
+ public:
+  Utf8Bench(td::string description, td::Slice paragraph) : description_(std::move(description)) {
+    for (int i = 0; i < 50; i++) {
+      text_ += paragraph.str();
+      text_ += '\n';
+    }
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "check_utf8 + utf8_utf16_length in " << description_ << " text of size " << text_.size();
+  }
+  void run(int n) final {
+    size_t sum = 0;
+    for (int i = 0; i < n; i++) {
+      sum += td::check_utf8(text_);
+      sum += td::utf8_utf16_length(text_);
+    }
+    td::do_not_optimize_away(sum);
+  }
+};
+
 BENCH(AddToTopStd, "add_to_top std") {
   td::vector<int> v;
   for (int i = 0; i < n; i++) {
@@ -752,6 +1138,52 @@ BENCH(AnyOfTd, "any_of td") {
   td::do_not_optimize_away(res);
 }
 
+// tasks are sent in chain_count independent chains with at most 10 simultaneously active tasks in each chain,
+// as in MultiSequenceDispatcher; chains are distributed between shard_count schedulers, as in ShardedSequenceDispatcher
+class ChainSchedulerBench final : public td::Benchmark {
+  int chain_count_;
+  int shard_count_;
+
+ public:
+  ChainSchedulerBench(int chain_count, int shard_count) : chain_count_(chain_count), shard_count_(shard_count) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "ChainScheduler " << chain_count_ << " chains x " << shard_count_ << " shards";
+  }
+
+  void run(int n) final {
+    using Scheduler = td::ChainScheduler<td::int32>;
+    td::vector<Scheduler> schedulers(static_cast<size_t>(shard_count_));
+    td::vector<td::vector<Scheduler::TaskId>> active_tasks(schedulers.size());
+    td::int64 sum = 0;
+    for (int i = 0; i < n; i++) {
+      Scheduler::ChainId chain_id = static_cast<Scheduler::ChainId>(i % chain_count_) + 1;
+      auto shard = static_cast<size_t>(chain_id % schedulers.size());
+      td::vector<Scheduler::ChainId> chain_ids{chain_id};
+      schedulers[shard].create_task(chain_ids, i);
+      while (true) {
+        auto o_task = schedulers[shard].start_next_task();
+        if (!o_task) {
+          break;
+        }
+        auto task = o_task.unwrap();
+        sum += static_cast<td::int64>(task.parents.size());
+        active_tasks[shard].push_back(task.task_id);
+      }
+      if ((i & 7) == 7) {
+        for (size_t j = 0; j < schedulers.size(); j++) {
+          for (auto task_id : active_tasks[j]) {
+            schedulers[j].finish_task(task_id);
+          }
+          active_tasks[j].clear();
+        }
+      }
+    }
+    td::do_not_optimize_away(sum);
+  }
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(DEBUG));
 
@@ -761,12 +1193,55 @@ int main() {
   td::bench(ToStringIntSmallBench());
   td::bench(ToStringIntBigBench());
 
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+  td::bench(OrderedMessagesInsertBench());
+  td::bench(OrderedMessagesEraseBench());
+  td::bench(OrderedMessagesIterateBench());
+  td::bench(DialogOrderUpdateBench<std::set<td::DialogDate>>("std::set"));
+  td::bench(DialogOrderUpdateBench<td::ChunkedSet<td::DialogDate>>("td::ChunkedSet"));
+
+  for (int chain_count : {10, 1000, 100000}) {
+    for (int shard_count : {1, 4}) {
+      td::bench(ChainSchedulerBench(chain_count, shard_count));
+    }
+  }
+
+  for (size_t prefix_length = 1; prefix_length <= 3; prefix_length++) {
+    td::bench(HintsSearchBench(prefix_length));
+  }
+  td::bench(HintsAddBench("English", {"Family", "Work", "News", "Football Club", "Team Chat", "Book Lovers"}));
+  td::bench(HintsAddBench("Russian", {"Семья", "Работа", "Новости", "Футбольный клуб", "Чат команды", "Книголюбы"}));
+  td::bench(HintsAddBench("mixed", {"Café Société", "日本語の勉強", "Ελληνικά", "Straße", "Новости", "Team 🔥"}));
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(DEBUG));
+
+  td::bench(FindEntitiesBench(
+      "English", "Our new release is available at https://example.com/download, see #changelog and ask @support "
+                 "about anything else. Prices start from $10 per month, and the offer ends 2:30 later today."));
+  td::bench(FindEntitiesBench(
+      "Russian", "Новая версия доступна по ссылке https://example.com/download, смотрите #изменения и пишите "
+                 "@support по любым вопросам. Цены начинаются от $10 в месяц, предложение действует до 2:30."));
+  td::bench(FindEntitiesBench("emoji", "🔥🔥🔥 Новости 📰 https://example.com 👉 #news @channel 🎉🎉🎉 ✅ Done ✅"));
+  td::bench(FindEntitiesBench(
+      "English with one entity", "Some plain English text without any entities, which is quite typical for long "
+                                "posts. Only the last sentence mentions @user, who wrote it."));
+
+  td::bench(Utf8Bench("English", "Our new release is available at https://example.com/download, see #changelog and ask "
+                                 "@support about anything else."));
+  td::bench(Utf8Bench("Russian", "Новая версия доступна по ссылке https://example.com/download, смотрите #изменения и "
+                                 "пишите @support по любым вопросам."));
+  td::bench(Utf8Bench("emoji", "🔥🔥🔥 Новости 📰 https://example.com 👉 #news @channel 🎉🎉🎉 ✅ Done ✅"));
+
   td::bench(AddToTopStdBench());
   td::bench(AddToTopTdBench());
 
   td::bench(TlToStringUpdateFileBench());
   td::bench(TlToStringMessageBench());
 
+  for (auto is_single_pass : {false, true}) {
+    td::bench(TlStoreBench("messages.readHistory", get_read_history_query(), is_single_pass));
+    td::bench(TlStoreBench("messages.sendMultiMedia", get_send_album_query(), is_single_pass));
+  }
+
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<1000>>());
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerNew<300>>());
   td::bench(DuplicateCheckerBenchEvenOdd<IdDuplicateCheckerArray<1000>>());
@@ -835,6 +1310,9 @@ int main() {
 #if !TD_WINDOWS
   td::bench(PipeBench());
 #endif
+#if TD_PORT_POSIX
+  td::bench(UdpBench());
+#endif
 #if TD_LINUX || TD_ANDROID || TD_TIZEN
   td::bench(SemBench());
 #endif
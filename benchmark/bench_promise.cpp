@@ -0,0 +1,116 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#if USE_MEMPROF
+#include "memprof/memprof_stat.h"
+#endif
+
+#include "td/utils/benchmark.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/Promise.h"
+#include "td/utils/SliceBuilder.h"
+
+#include <utility>
+
+// creates promises in the same way as before the inline storage was added
+struct HeapPromiseCreator {
+  template <class OkT, class ArgT = td::detail::drop_result_t<td::detail::get_arg_t<OkT>>>
+  static td::Promise<ArgT> lambda(OkT &&ok) {
+    return td::Promise<ArgT>(
+        td::make_unique<td::detail::LambdaPromise<ArgT, std::decay_t<OkT>>>(std::forward<OkT>(ok)));
+  }
+};
+
+struct InlinePromiseCreator {
+  template <class OkT>
+  static auto lambda(OkT &&ok) {
+    return td::PromiseCreator::lambda(std::forward<OkT>(ok));
+  }
+};
+
+template <class CreatorT>
+class PromiseCreateBench final : public td::Benchmark {
+ public:
+  explicit PromiseCreateBench(const char *name) : name_(name) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Create and set promise " << name_;
+  }
+
+  void run(int n) final {
+    td::int64 sum = 0;
+    for (int i = 0; i < n; i++) {
+      auto promise = CreatorT::lambda([&sum, i](td::Result<td::int32> r_value) {
+        if (r_value.is_ok()) {
+          sum += r_value.ok() + i;
+        }
+      });
+      promise.set_value(1);
+    }
+    td::do_not_optimize_away(sum);
+  }
+
+ private:
+  const char *name_;
+};
+
+template <class CreatorT>
+class PromiseMoveBench final : public td::Benchmark {
+ public:
+  explicit PromiseMoveBench(const char *name) : name_(name) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Create, store, move and set promise " << name_;
+  }
+
+  void run(int n) final {
+    static constexpr int BATCH_SIZE = 100;
+    td::int64 sum = 0;
+    td::vector<td::Promise<td::Unit>> promises;
+    promises.reserve(BATCH_SIZE);
+    for (int i = 0; i < n; i += BATCH_SIZE) {
+      for (int j = 0; j < BATCH_SIZE; j++) {
+        promises.push_back(CreatorT::lambda([&sum, j](td::Unit) { sum += j; }));
+      }
+      auto moved_promises = std::move(promises);
+      promises.clear();
+      for (auto &promise : moved_promises) {
+        auto moved_promise = std::move(promise);
+        moved_promise.set_value(td::Unit());
+      }
+    }
+    td::do_not_optimize_away(sum);
+  }
+
+ private:
+  const char *name_;
+};
+
+template <class BenchT>
+static void bench_with_allocation_count(BenchT &&benchmark) {
+  td::bench(benchmark);
+#if USE_MEMPROF
+  static constexpr int RUN_COUNT = 100000;
+  auto begin_allocation_count = get_allocation_count();
+  benchmark.run(RUN_COUNT);
+  auto allocation_count = get_allocation_count() - begin_allocation_count;
+  LOG(PLAIN) << "    " << static_cast<double>(allocation_count) / RUN_COUNT << " allocations per promise";
+#endif
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
+
+  LOG(PLAIN) << "sizeof(Promise) = " << sizeof(td::Promise<td::Unit>)
+             << ", inline storage size = " << td::Promise<td::Unit>::INLINE_STORAGE_SIZE;
+  bench_with_allocation_count(PromiseCreateBench<HeapPromiseCreator>("on heap"));
+  bench_with_allocation_count(PromiseCreateBench<InlinePromiseCreator>("inline"));
+  bench_with_allocation_count(PromiseMoveBench<HeapPromiseCreator>("on heap"));
+  bench_with_allocation_count(PromiseMoveBench<InlinePromiseCreator>("inline"));
+}
@@ -11,9 +11,12 @@
 #include "td/telegram/ServerMessageId.h"
 #include "td/telegram/UserId.h"
 
+#include "td/db/binlog/Binlog.h"
+#include "td/db/binlog/ConcurrentBinlog.h"
 #include "td/db/DbKey.h"
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
+#include "td/db/TQueue.h"
 
 #include "td/actor/ConcurrentScheduler.h"
 
@@ -21,10 +24,13 @@
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Random.h"
 #include "td/utils/Status.h"
+#include "td/utils/Storer.h"
 
+#include <atomic>
 #include <memory>
 
 static td::Status init_db(td::SqliteDb &db) {
@@ -107,7 +113,135 @@ class MessageDbBench final : public td::Benchmark {
   }
 };
 
+// every event is added with a forced sync, like a log event of a sent message
+class BinlogSyncBench final : public td::Benchmark {
+ public:
+  BinlogSyncBench(td::string name, td::BinlogSyncPolicy sync_policy)
+      : name_(std::move(name)), sync_policy_(sync_policy) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "ConcurrentBinlog sync " << name_;
+  }
+
+  void start_up() final {
+    scheduler_ = td::make_unique<td::ConcurrentScheduler>(1, 0);
+    {
+      auto guard = scheduler_->get_main_guard();
+      td::string binlog_name = "bench_binlog";
+      td::Binlog::destroy(binlog_name).ignore();
+      binlog_ = std::make_shared<td::ConcurrentBinlog>();
+      binlog_->init(binlog_name, [](const td::BinlogEvent &event) {}, td::DbKey::empty(), td::DbKey::empty(), 1)
+          .ensure();
+      binlog_->set_sync_policy(sync_policy_);
+    }
+    scheduler_->start();
+  }
+
+  void run(int n) final {
+    finished_count_ = 0;
+    {
+      auto guard = scheduler_->get_main_guard();
+      td::string data(td::Random::fast(25, 75) * 4, 'a');
+      for (int i = 0; i < n; i++) {
+        binlog_->add(1, td::create_storer(data));
+        binlog_->force_sync(td::PromiseCreator::lambda([this](td::Unit) { finished_count_++; }), "bench");
+      }
+    }
+    while (finished_count_.load() < n) {
+      scheduler_->run_main(0.01);
+    }
+  }
+
+  void tear_down() final {
+    {
+      auto guard = scheduler_->get_main_guard();
+      binlog_->close_and_destroy();
+      binlog_.reset();
+    }
+    scheduler_->run_main(0.1);
+    scheduler_->finish();
+    scheduler_.reset();
+  }
+
+ private:
+  td::string name_;
+  td::BinlogSyncPolicy sync_policy_;
+  td::unique_ptr<td::ConcurrentScheduler> scheduler_;
+  std::shared_ptr<td::ConcurrentBinlog> binlog_;
+  std::atomic<int> finished_count_{0};
+};
+
+// readers get events from the head of queues, while the owner adds and forgets events
+class TQueueConcurrentReadBench final : public td::Benchmark {
+ public:
+  explicit TQueueConcurrentReadBench(size_t reader_count) : reader_count_(reader_count) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "TQueue concurrent get with " << reader_count_ << " readers";
+  }
+
+  void start_up() final {
+    tqueue_ = td::TQueue::create();
+    tqueue_->enable_concurrent_reads(reader_count_);
+    for (td::TQueue::QueueId queue_id = 1; queue_id <= QUEUE_COUNT; queue_id++) {
+      for (int i = 0; i < 1000; i++) {
+        push_event(queue_id);
+      }
+    }
+  }
+
+  void run(int n) final {
+    std::atomic<size_t> finished_reader_count{0};
+    td::vector<td::thread> readers;
+    for (size_t i = 0; i < reader_count_; i++) {
+      readers.emplace_back([&, reader = tqueue_->create_concurrent_reader(), n]() mutable {
+        td::vector<td::TQueue::RawEvent> events;
+        auto from_id = td::TQueue::EventId::from_int32(1).move_as_ok();
+        size_t event_count = 0;
+        for (int j = 0; j < n; j++) {
+          reader->get(td::Random::fast(1, QUEUE_COUNT), from_id, 0, 10, events);
+          event_count += events.size();
+        }
+        td::do_not_optimize_away(event_count);
+        reader = nullptr;
+        finished_reader_count++;
+      });
+    }
+    while (finished_reader_count.load() < reader_count_) {
+      auto queue_id = td::Random::fast(1, QUEUE_COUNT);
+      push_event(queue_id);
+      tqueue_->forget(queue_id, tqueue_->get_head(queue_id));
+    }
+    for (auto &reader : readers) {
+      reader.join();
+    }
+  }
+
+  void tear_down() final {
+    tqueue_ = nullptr;
+  }
+
+ private:
+  static constexpr int QUEUE_COUNT = 10;
+
+  size_t reader_count_;
+  td::unique_ptr<td::TQueue> tqueue_;
+
+  void push_event(td::TQueue::QueueId queue_id) {
+    tqueue_->push(queue_id, td::string(100, 'a'), 2000000000, 0, td::TQueue::EventId::from_int32(1).move_as_ok())
+        .ensure();
+  }
+};
+
 int main() {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(WARNING));
   td::bench(MessageDbBench());
+  td::bench(BinlogSyncBench("per-event", td::BinlogSyncPolicy::per_event()));
+  td::bench(BinlogSyncBench("grouped 3ms", td::BinlogSyncPolicy::grouped(0.003)));
+  td::bench(BinlogSyncBench("grouped 3ms, at most 16", td::BinlogSyncPolicy::grouped(0.003, 16)));
+  td::bench(BinlogSyncBench("periodic 10ms", td::BinlogSyncPolicy::periodic(0.01)));
+  td::bench(TQueueConcurrentReadBench(1));
+  td::bench(TQueueConcurrentReadBench(4));
 }
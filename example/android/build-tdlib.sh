@@ -56,6 +56,7 @@ if [ "$TDLIB_INTERFACE" == "Java" ] ; then
   mkdir -p tdlib/java/org/drinkless/tdlib || exit 1
   cp -p {../../example,tdlib}/java/org/drinkless/tdlib/Client.java || exit 1
   mv {,tdlib/java/}org/drinkless/tdlib/TdApi.java || exit 1
+  mv {,tdlib/java/}org/drinkless/tdlib/TdApiBinaryReader.java || exit 1
   rm -rf org || exit 1
 
   echo "Generating Javadoc documentation..."
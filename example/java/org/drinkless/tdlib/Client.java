@@ -6,6 +6,8 @@
 //
 package org.drinkless.tdlib;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.concurrent.ConcurrentHashMap;
 import java.util.concurrent.atomic.AtomicLong;
 
@@ -161,12 +163,26 @@ public final class Client {
         nativeClientSetLogMessageHandler(maxVerbosityLevel, logMessageHandler);
     }
 
+    /**
+     * Enables transfer of incoming updates and request responses from the native code serialized in the TL binary format
+     * through a direct ByteBuffer. This requires only one JNI call for a batch of updates instead of creating Java objects
+     * field by field from the native code. Affects only updates and responses received after the call.
+     */
+    public static void enableBinaryResponseTransfer() {
+        isBinaryResponseTransferEnabled = true;
+    }
+
     private static class ResponseReceiver implements Runnable {
         public boolean isRun = false;
 
         @Override
         public void run() {
             while (true) {
+                if (isBinaryResponseTransferEnabled) {
+                    receiveBinary();
+                    continue;
+                }
+
                 int resultN = nativeClientReceive(clientIds, eventIds, events, 100000.0 /*seconds*/);
                 for (int i = 0; i < resultN; i++) {
                     processResult(clientIds[i], eventIds[i], events[i]);
@@ -175,6 +191,24 @@ public final class Client {
             }
         }
 
+        private void receiveBinary() {
+            if (buffer == null) {
+                buffer = ByteBuffer.allocateDirect(INITIAL_BUFFER_SIZE).order(ByteOrder.nativeOrder());
+            }
+            int resultN = nativeClientReceiveBinary(buffer, 100000.0 /*seconds*/);
+            if (resultN < 0) {
+                // the next response doesn't fit in the buffer
+                buffer = ByteBuffer.allocateDirect(-resultN).order(ByteOrder.nativeOrder());
+                return;
+            }
+            buffer.clear();
+            for (int i = 0; i < resultN; i++) {
+                int clientId = buffer.getInt();
+                long id = buffer.getLong();
+                processResult(clientId, id, TdApiBinaryReader.readObject(buffer));
+            }
+        }
+
         private void processResult(int clientId, long id, TdApi.Object object) {
             boolean isClosed = false;
             if (id == 0 && object instanceof TdApi.UpdateAuthorizationState) {
@@ -213,6 +247,9 @@ public final class Client {
         private final int[] clientIds = new int[MAX_EVENTS];
         private final long[] eventIds = new long[MAX_EVENTS];
         private final TdApi.Object[] events = new TdApi.Object[MAX_EVENTS];
+
+        private static final int INITIAL_BUFFER_SIZE = 1 << 20;
+        private ByteBuffer buffer = null;
     }
 
     private final int nativeClientId;
@@ -224,6 +261,7 @@ public final class Client {
     private static final AtomicLong clientCount = new AtomicLong();
 
     private static final ResponseReceiver responseReceiver = new ResponseReceiver();
+    private static volatile boolean isBinaryResponseTransferEnabled = false;
 
     private static class Handler {
         final ResultHandler resultHandler;
@@ -253,6 +291,8 @@ public final class Client {
 
     private static native int nativeClientReceive(int[] clientIds, long[] eventIds, TdApi.Object[] events, double timeout);
 
+    private static native int nativeClientReceiveBinary(ByteBuffer buffer, double timeout);
+
     private static native TdApi.Object nativeClientExecute(TdApi.Function function);
 
     private static native void nativeClientSetLogMessageHandler(int maxVerbosityLevel, LogMessageHandler logMessageHandler);
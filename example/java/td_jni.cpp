@@ -8,7 +8,11 @@
 #include <td/telegram/td_api.h>
 
 #include <td/tl/tl_jni_object.h>
+#include <td/tl/tl_object_store.h>
 
+#include <td/utils/tl_storers.h>
+
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <string>
@@ -70,6 +74,54 @@ static jint Client_nativeClientReceive(JNIEnv *env, jclass clazz, jintArray clie
   return result_size;
 }
 
+template <class StorerT>
+static void store_binary_response(const td::ClientManager::Response &response, StorerT &storer) {
+  storer.store_binary(static_cast<std::int32_t>(response.client_id));
+  storer.store_binary(static_cast<std::int64_t>(response.request_id));
+  storer.store_binary(response.object->get_id());
+  response.object->store(storer);
+}
+
+// the response, which didn't fit in the buffer during the previous call to Client_nativeClientReceiveBinary
+static td::ClientManager::Response pending_binary_response;
+
+static jint Client_nativeClientReceiveBinary(JNIEnv *env, jclass clazz, jobject buffer, jdouble timeout) {
+  auto *buffer_begin = static_cast<unsigned char *>(env->GetDirectBufferAddress(buffer));
+  auto buffer_size = env->GetDirectBufferCapacity(buffer);
+  if (buffer_begin == nullptr || buffer_size <= 0) {
+    return 0;
+  }
+  jint result_size = 0;
+  std::size_t offset = 0;
+
+  auto *manager = get_manager();
+  auto response = std::move(pending_binary_response);
+  if (!response.object) {
+    response = manager->receive(timeout);
+  }
+  while (response.object) {
+    td::TlStorerCalcLength calc_length;
+    store_binary_response(response, calc_length);
+    auto length = calc_length.get_length();
+    if (length > static_cast<std::size_t>(buffer_size) - offset) {
+      pending_binary_response = std::move(response);
+      if (result_size == 0) {
+        // the buffer must be reallocated
+        return -static_cast<jint>(length);
+      }
+      break;
+    }
+
+    td::TlStorerUnsafe storer(buffer_begin + offset);
+    store_binary_response(response, storer);
+    offset += length;
+    result_size++;
+
+    response = manager->receive(0);
+  }
+  return result_size;
+}
+
 static jobject Client_nativeClientExecute(JNIEnv *env, jclass clazz, jobject function) {
   jobject result;
   td::ClientManager::execute(fetch_function(env, function))->store(env, result);
@@ -157,6 +209,8 @@ static jint register_native(JavaVM *vm) {
   register_method(client_class, "createNativeClient", "()I", Client_createNativeClient);
   register_method(client_class, "nativeClientSend", "(IJ" TD_FUNCTION ")V", Client_nativeClientSend);
   register_method(client_class, "nativeClientReceive", "([I[J[" TD_OBJECT "D)I", Client_nativeClientReceive);
+  register_method(client_class, "nativeClientReceiveBinary", "(Ljava/nio/ByteBuffer;D)I",
+                  Client_nativeClientReceiveBinary);
   register_method(client_class, "nativeClientExecute", "(" TD_FUNCTION ")" TD_OBJECT, Client_nativeClientExecute);
   register_method(client_class, "nativeClientSetLogMessageHandler", "(IL" PACKAGE_NAME "/Client$LogMessageHandler;)V",
                   Client_nativeClientSetLogMessageHandler);
@@ -9,6 +9,8 @@
 #include "td/utils/port/platform.h"
 
 #if (TD_DARWIN || TD_LINUX) && defined(USE_MEMPROF)
+#include "td/utils/MemoryAttribution.h"
+
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
@@ -127,6 +129,7 @@ struct malloc_info {
   std::int32_t magic;
   std::int32_t size;
   std::int32_t ht_pos;
+  std::int32_t tag_pos;
 };
 
 static std::uint64_t get_hash(const Backtrace &bt) {
@@ -200,13 +203,75 @@ void dump_alloc(const std::function<void(const AllocInfo &)> &func) {
   }
 }
 
+// live allocations by td::MemoryAttribution tag; tags are compared by pointer, because they are interned
+struct TagNode {
+  std::atomic<const char *> tag;
+  std::atomic<std::size_t> size;
+  std::atomic<std::size_t> count;
+};
+
+static constexpr std::size_t TAG_HT_SIZE = 4096;
+static std::array<TagNode, TAG_HT_SIZE> tag_ht;  // tag_ht[0] is used for allocations without a tag
+
+static std::int32_t get_tag_pos(const char *tag) {
+  if (tag == nullptr) {
+    return 0;
+  }
+  auto pos = static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(tag) >> 4) % (TAG_HT_SIZE - 1) + 1;
+  for (std::size_t i = 1; i < TAG_HT_SIZE; i++) {
+    auto pos_tag = tag_ht[pos].tag.load(std::memory_order_acquire);
+    if (pos_tag == nullptr) {
+      const char *expected = nullptr;
+      if (tag_ht[pos].tag.compare_exchange_strong(expected, tag) || expected == tag) {
+        return static_cast<std::int32_t>(pos);
+      }
+    } else if (pos_tag == tag) {
+      return static_cast<std::int32_t>(pos);
+    }
+    pos++;
+    if (pos == TAG_HT_SIZE) {
+      pos = 1;
+    }
+  }
+  // the table is full
+  return 0;
+}
+
+static std::vector<td::MemoryAttribution::Entry> get_memory_attribution() {
+  std::vector<td::MemoryAttribution::Entry> result;
+  for (auto &node : tag_ht) {
+    auto count = node.count.load(std::memory_order_relaxed);
+    if (count == 0) {
+      continue;
+    }
+    auto tag = node.tag.load(std::memory_order_acquire);
+    td::MemoryAttribution::Entry entry;
+    entry.tag = tag == nullptr ? "<unattributed>" : tag;
+    entry.size = node.size.load(std::memory_order_relaxed);
+    entry.allocation_count = count;
+    result.push_back(std::move(entry));
+  }
+  return result;
+}
+
+static struct MemoryAttributionRegistrar {
+  MemoryAttributionRegistrar() {
+    td::MemoryAttribution::set_statistics_getter(&get_memory_attribution);
+  }
+} memory_attribution_registrar;
+
 void register_xalloc(malloc_info *info, std::int32_t diff) {
   my_assert(info->size >= 0);
+  auto &tag_node = tag_ht[info->tag_pos];
   if (diff > 0) {
     ht[info->ht_pos].size.fetch_add(info->size, std::memory_order_relaxed);
+    tag_node.size.fetch_add(info->size, std::memory_order_relaxed);
+    tag_node.count.fetch_add(1, std::memory_order_relaxed);
   } else {
     auto old_value = ht[info->ht_pos].size.fetch_sub(info->size, std::memory_order_relaxed);
     my_assert(old_value >= static_cast<std::size_t>(info->size));
+    tag_node.size.fetch_sub(info->size, std::memory_order_relaxed);
+    tag_node.count.fetch_sub(1, std::memory_order_relaxed);
   }
 }
 
@@ -228,6 +293,7 @@ static void *malloc_with_frame(std::size_t size, const Backtrace &frame) {
   info->magic = MALLOC_INFO_MAGIC;
   info->size = static_cast<std::int32_t>(size);
   info->ht_pos = get_ht_pos(frame);
+  info->tag_pos = get_tag_pos(td::MemoryAttribution::get_current_tag());
 
   register_xalloc(info, +1);
 
@@ -37,18 +37,26 @@ struct malloc_info {
 };
 
 static std::atomic<std::size_t> total_memory_used;
+static std::atomic<std::size_t> total_allocation_count;
 
 void register_xalloc(malloc_info *info, std::int32_t diff) {
   my_assert(info->size >= 0);
   // TODO: this is very slow in case of several threads.
   // Currently, the statistics are intended only for memory benchmarks.
   total_memory_used.fetch_add(diff * info->size, std::memory_order_relaxed);
+  if (diff > 0) {
+    total_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
 }
 
 std::size_t get_used_memory_size() {
   return total_memory_used.load();
 }
 
+std::size_t get_allocation_count() {
+  return total_allocation_count.load();
+}
+
 extern "C" {
 
 static constexpr std::size_t RESERVED_SIZE = 16;
@@ -163,4 +171,7 @@ bool is_memprof_on() {
 std::size_t get_used_memory_size() {
   return 0;
 }
+std::size_t get_allocation_count() {
+  return 0;
+}
 #endif
@@ -11,3 +11,5 @@
 bool is_memprof_on();
 
 std::size_t get_used_memory_size();
+
+std::size_t get_allocation_count();
@@ -4,6 +4,7 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "tl_java_binary_reader.h"
 #include "tl_writer_java.h"
 
 #include "td/tl/tl_config.h"
@@ -23,7 +24,11 @@ int main(int argc, char *argv[]) {
   std::string package = argv[4];
   std::string package_name = package;
   std::replace(package_name.begin(), package_name.end(), '/', '.');
-  destination += "/" + package + "/" + api_name + ".java";
-  td::tl::write_tl_to_file(td::tl::read_tl_config_from_file(source), destination,
-                           td::TD_TL_writer_java(api_name, package_name));
+  destination += "/" + package + "/";
+  auto config = td::tl::read_tl_config_from_file(source);
+  td::tl::write_tl_to_file(config, destination + api_name + ".java", td::TD_TL_writer_java(api_name, package_name));
+
+  auto binary_reader_name = api_name + "BinaryReader";
+  td::gen_java_binary_reader(config, destination + binary_reader_name + ".java", api_name, binary_reader_name,
+                             package_name);
 }
@@ -0,0 +1,207 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "tl_java_binary_reader.h"
+
+#include "td/tl/tl_file_utils.h"
+#include "td/tl/tl_simple.h"
+#include "td/tl/tl_writer.h"
+
+#include <cassert>
+#include <string>
+
+namespace td {
+
+static std::string gen_java_name(const std::string &name, bool is_class_name) {
+  bool next_to_upper = is_class_name;
+  std::string result;
+  for (auto c : name) {
+    if (!tl::TL_writer::is_alnum(c)) {
+      next_to_upper = true;
+      continue;
+    }
+    if (next_to_upper) {
+      result += tl::TL_writer::to_upper(c);
+      next_to_upper = false;
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+static std::string gen_java_class_name(const std::string &api_name, const tl::simple::CustomType *custom_type) {
+  // the same as TD_TL_writer_java::gen_main_class_name
+  const auto &name = custom_type->constructors.size() == 1 ? custom_type->constructors[0]->name : custom_type->name;
+  return api_name + "." + gen_java_name(name, true);
+}
+
+static std::string gen_java_type_name(const std::string &api_name, const tl::simple::Type *type) {
+  switch (type->type) {
+    case tl::simple::Type::Int32:
+      return "int";
+    case tl::simple::Type::Int53:
+    case tl::simple::Type::Int64:
+      return "long";
+    case tl::simple::Type::Double:
+      return "double";
+    case tl::simple::Type::String:
+      return "String";
+    case tl::simple::Type::Bytes:
+      return "byte[]";
+    case tl::simple::Type::Vector:
+      return gen_java_type_name(api_name, type->vector_value_type) + "[]";
+    case tl::simple::Type::Bool:
+      return "boolean";
+    case tl::simple::Type::Custom:
+      return gen_java_class_name(api_name, type->custom);
+    default:
+      assert(false);
+      return std::string();
+  }
+}
+
+static std::string gen_read_value(const std::string &api_name, const tl::simple::Type *type, const std::string &target,
+                                  int depth, const std::string &indent) {
+  switch (type->type) {
+    case tl::simple::Type::Int32:
+      return indent + target + " = buffer.getInt();\n";
+    case tl::simple::Type::Int53:
+    case tl::simple::Type::Int64:
+      return indent + target + " = buffer.getLong();\n";
+    case tl::simple::Type::Double:
+      return indent + target + " = buffer.getDouble();\n";
+    case tl::simple::Type::String:
+      return indent + target + " = readString(buffer);\n";
+    case tl::simple::Type::Bytes:
+      return indent + target + " = readBytes(buffer);\n";
+    case tl::simple::Type::Bool:
+      return indent + target + " = readBool(buffer);\n";
+    case tl::simple::Type::Custom:
+      return indent + target + " = (" + gen_java_type_name(api_name, type) + ") readObject(buffer);\n";
+    case tl::simple::Type::Vector: {
+      auto count = "count" + std::to_string(depth);
+      auto i = "i" + std::to_string(depth);
+      auto value_type_name = gen_java_type_name(api_name, type->vector_value_type);
+      auto bracket_pos = value_type_name.find('[');
+      auto new_array = bracket_pos == std::string::npos
+                           ? value_type_name + "[" + count + "]"
+                           : value_type_name.substr(0, bracket_pos) + "[" + count + "]" +
+                                 value_type_name.substr(bracket_pos);
+      return indent + "{\n" + indent + "    int " + count + " = buffer.getInt();\n" + indent + "    " + target +
+             " = new " + new_array + ";\n" + indent + "    for (int " + i + " = 0; " + i + " < " + count + "; " + i +
+             "++) {\n" +
+             gen_read_value(api_name, type->vector_value_type, target + "[" + i + "]", depth + 1, indent + "        ") +
+             indent + "    }\n" + indent + "}\n";
+    }
+    default:
+      assert(false);
+      return std::string();
+  }
+}
+
+bool gen_java_binary_reader(const tl::tl_config &config, const std::string &file_name, const std::string &api_name,
+                            const std::string &class_name, const std::string &package_name) {
+  tl::simple::Schema schema(config);
+
+  std::string read_functions;
+  std::string switch_cases;
+  for (auto *custom_type : schema.custom_types) {
+    if (!custom_type->is_result_) {
+      // only results are serialized by TDLib
+      continue;
+    }
+    for (auto *constructor : custom_type->constructors) {
+      auto constructor_class_name = api_name + "." + gen_java_name(constructor->name, true);
+      auto function_name = "read" + gen_java_name(constructor->name, true);
+      switch_cases += "            case " + constructor_class_name +
+                      ".CONSTRUCTOR:\n"
+                      "                return " +
+                      function_name + "(buffer);\n";
+
+      read_functions += "\n    private static " + constructor_class_name + " " + function_name +
+                        "(ByteBuffer buffer) {\n"
+                        "        " +
+                        constructor_class_name + " object = new " + constructor_class_name + "();\n";
+      for (auto &arg : constructor->args) {
+        read_functions += gen_read_value(api_name, arg.type, "object." + gen_java_name(arg.name, false), 0, "        ");
+      }
+      read_functions +=
+          "        return object;\n"
+          "    }\n";
+    }
+  }
+
+  std::string result = "package " + package_name +
+                       ";\n"
+                       "\n"
+                       "import java.nio.ByteBuffer;\n"
+                       "import java.nio.charset.StandardCharsets;\n"
+                       "\n"
+                       "/**\n"
+                       " * Decodes " +
+                       api_name +
+                       " objects serialized by TDLib in the TL binary format.\n"
+                       " */\n"
+                       "public final class " +
+                       class_name +
+                       " {\n"
+                       "    private static final int ID_BOOL_TRUE = 0x997275b5;\n"
+                       "\n"
+                       "    private " +
+                       class_name +
+                       "() {\n"
+                       "    }\n"
+                       "\n"
+                       "    /**\n"
+                       "     * Reads an object from the buffer. The buffer must use the native byte order.\n"
+                       "     *\n"
+                       "     * @param buffer The buffer to read the object from.\n"
+                       "     * @return The read object; may be null.\n"
+                       "     */\n"
+                       "    public static " +
+                       api_name +
+                       ".Object readObject(ByteBuffer buffer) {\n"
+                       "        int constructor = buffer.getInt();\n"
+                       "        switch (constructor) {\n"
+                       "            case 0:\n"
+                       "                return null;\n" +
+                       switch_cases +
+                       "            default:\n"
+                       "                throw new IllegalArgumentException(\"Unknown constructor \" + constructor);\n"
+                       "        }\n"
+                       "    }\n"
+                       "\n"
+                       "    private static boolean readBool(ByteBuffer buffer) {\n"
+                       "        return buffer.getInt() == ID_BOOL_TRUE;\n"
+                       "    }\n"
+                       "\n"
+                       "    private static byte[] readBytes(ByteBuffer buffer) {\n"
+                       "        int length = buffer.get() & 0xFF;\n"
+                       "        int prefixLength = 1;\n"
+                       "        if (length == 254) {\n"
+                       "            length = (buffer.get() & 0xFF) | ((buffer.get() & 0xFF) << 8) | "
+                       "((buffer.get() & 0xFF) << 16);\n"
+                       "            prefixLength = 4;\n"
+                       "        } else if (length == 255) {\n"
+                       "            length = buffer.getInt();\n"
+                       "            buffer.position(buffer.position() + 3);\n"
+                       "            prefixLength = 8;\n"
+                       "        }\n"
+                       "        byte[] result = new byte[length];\n"
+                       "        buffer.get(result);\n"
+                       "        buffer.position(buffer.position() + ((-(prefixLength + length)) & 3));\n"
+                       "        return result;\n"
+                       "    }\n"
+                       "\n"
+                       "    private static String readString(ByteBuffer buffer) {\n"
+                       "        return new String(readBytes(buffer), StandardCharsets.UTF_8);\n"
+                       "    }\n" +
+                       read_functions + "}\n";
+  return tl::put_file_contents(file_name, result, false);
+}
+
+}  // namespace td
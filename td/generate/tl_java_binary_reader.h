@@ -0,0 +1,19 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/tl/tl_config.h"
+
+#include <string>
+
+namespace td {
+
+// generates a Java class, which decodes objects of the API, serialized in the TL binary format by TlStorerUnsafe
+bool gen_java_binary_reader(const tl::tl_config &config, const std::string &file_name, const std::string &api_name,
+                            const std::string &class_name, const std::string &package_name);
+
+}  // namespace td
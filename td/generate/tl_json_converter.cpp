@@ -109,6 +109,22 @@ void gen_from_json_constructor(StringBuilder &sb, const T *constructor, bool is_
     sb << "  return Status::OK();\n";
     sb << "}\n\n";
   }
+
+  sb << "Status from_json_field(td_api::" << tl::simple::gen_cpp_name(constructor->name)
+     << " &to, Slice name, Parser &parser, int32 max_depth)";
+  if (is_header) {
+    sb << ";\n\n";
+  } else {
+    sb << " {\n";
+    for (auto &arg : constructor->args) {
+      sb << "  if (name == \"" << tl::simple::gen_cpp_name(arg.name) << "\") {\n";
+      sb << "    return from_json" << (arg.type->type == tl::simple::Type::Bytes ? "_bytes" : "") << "(to."
+         << tl::simple::gen_cpp_field_name(arg.name) << ", parser, max_depth);\n";
+      sb << "  }\n";
+    }
+    sb << "  return do_json_skip(parser, max_depth);\n";
+    sb << "}\n\n";
+  }
 }
 
 void gen_from_json(StringBuilder &sb, const tl::simple::Schema &schema, bool is_header, Mode mode) {
@@ -204,6 +220,8 @@ void gen_json_converter_file(const tl::simple::Schema &schema, const std::string
     sb << "#include \"td/telegram/td_api.h\"\n\n";
 
     sb << "#include \"td/utils/JsonBuilder.h\"\n";
+    sb << "#include \"td/utils/Parser.h\"\n";
+    sb << "#include \"td/utils/Slice.h\"\n";
     sb << "#include \"td/utils/Status.h\"\n\n";
   } else {
     sb << "#include \"" << file_name_base << ".h\"\n\n";
@@ -225,6 +243,7 @@ void gen_json_converter_file(const tl::simple::Schema &schema, const std::string
   if (is_header) {
     sb << "\nvoid to_json(JsonValueScope &jv, const tl_object_ptr<Object> &value);\n";
     sb << "\nStatus from_json(tl_object_ptr<Function> &to, td::JsonValue from);\n";
+    sb << "\nStatus from_json(tl_object_ptr<Function> &to, td::MutableSlice json, td::Slice &extra);\n";
     sb << "\nvoid to_json(JsonValueScope &jv, const Object &object);\n";
     sb << "\nvoid to_json(JsonValueScope &jv, const Function &object);\n\n";
   } else {
@@ -237,6 +256,17 @@ Status from_json(tl_object_ptr<Function> &to, td::JsonValue from) {
   return td::from_json(to, std::move(from));
 }
 
+Status from_json(tl_object_ptr<Function> &to, td::MutableSlice json, td::Slice &extra) {
+  Parser parser(json);
+  const int32 DEFAULT_MAX_DEPTH = 100;
+  TRY_STATUS(td::from_json(to, parser, DEFAULT_MAX_DEPTH, &extra));
+  parser.skip_whitespaces();
+  if (!parser.empty()) {
+    return Status::Error("Expected string end");
+  }
+  return Status::OK();
+}
+
 template <class T>
 auto lazy_to_json(JsonValueScope &jv, const T &t) -> decltype(td_api::to_json(jv, t)) {
   return td_api::to_json(jv, t);
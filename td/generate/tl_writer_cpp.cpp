@@ -375,6 +375,20 @@ std::string TD_TL_writer_cpp::gen_full_store_class_name(const tl::tl_tree_type *
 
   assert(!(t->flags & tl::FLAG_DEFAULT_CONSTRUCTOR));  // Not supported yet
 
+  if (tl_name == "td_api" && t->name != "#" && !is_built_in_simple_type(t->name) &&
+      !is_built_in_complex_type(t->name)) {
+    // objects in td_api can be null, so they are always stored with a constructor identifier
+    if (!is_type_bare(t)) {
+      return "TlStoreBoxedUnknownOptional<" + gen_store_class_name(tree_type) + ">";
+    }
+    for (std::size_t i = 0; i < t->constructors_num; i++) {
+      if (is_combinator_supported(t->constructors[i])) {
+        return "TlStoreBoxedOptional<" + gen_store_class_name(tree_type) + ", " +
+               int_to_string(t->constructors[i]->id) + ">";
+      }
+    }
+  }
+
   if ((tree_type->flags & tl::FLAG_BARE) != 0 || t->name == "#" || t->name == "Bool") {
     return gen_store_class_name(tree_type);
   }
@@ -36,6 +36,17 @@ int TD_TL_writer_jni_cpp::get_additional_function_type(const std::string &additi
   return 1;
 }
 
+// 0 - conversion to a Java object, 1 - conversion to a string, 2 - serialization in the TL binary format
+int TD_TL_writer_jni_cpp::get_storer_type(const tl::tl_combinator *t, const std::string &storer_name) const {
+  if (storer_name == "TlStorerToString") {
+    return 1;
+  }
+  if (storer_name == "TlStorerCalcLength" || storer_name == "TlStorerUnsafe") {
+    return 2;
+  }
+  return 0;
+}
+
 std::vector<std::string> TD_TL_writer_jni_cpp::get_parsers() const {
   std::vector<std::string> parsers;
   parsers.push_back("JNIEnv *env, jobject");
@@ -46,6 +57,8 @@ std::vector<std::string> TD_TL_writer_jni_cpp::get_storers() const {
   std::vector<std::string> storers;
   storers.push_back("JNIEnv *env, jobject");
   storers.push_back("TlStorerToString");
+  storers.push_back("TlStorerCalcLength");
+  storers.push_back("TlStorerUnsafe");
   return storers;
 }
 
@@ -280,6 +293,10 @@ std::string TD_TL_writer_jni_cpp::gen_vector_store(const std::string &field_name
 
 std::string TD_TL_writer_jni_cpp::gen_type_store(const std::string &field_name, const tl::tl_tree_type *tree_type,
                                                  const std::vector<tl::var_description> &vars, int storer_type) const {
+  if (storer_type == 2) {
+    return TD_TL_writer_cpp::gen_type_store(field_name, tree_type, vars, 0);
+  }
+
   const tl::tl_type *t = tree_type->type;
   const std::string &name = t->name;
 
@@ -347,6 +364,11 @@ std::string TD_TL_writer_jni_cpp::gen_field_store(const tl::arg &a, std::vector<
   std::string field_name = gen_field_name(a.name);
   std::string shift = storer_type == 1 ? "    " : "  ";
 
+  if (storer_type == 2) {
+    assert(a.type->get_type() == tl::NODE_TYPE_TYPE);
+    return shift + gen_type_store(field_name, static_cast<const tl::tl_tree_type *>(a.type), vars, storer_type) + "\n";
+  }
+
   assert(a.exist_var_num == -1);
   if (a.type->get_type() == tl::NODE_TYPE_VAR_TYPE) {
     const tl::tl_tree_var_type *t = static_cast<const tl::tl_tree_var_type *>(a.type);
@@ -460,6 +482,10 @@ std::string TD_TL_writer_jni_cpp::gen_store_function_begin(const std::string &st
                                                            const std::string &class_name, int arity,
                                                            std::vector<tl::var_description> &vars,
                                                            int storer_type) const {
+  if (storer_type == 2) {
+    return TD_TL_writer_cpp::gen_store_function_begin(storer_name, class_name, arity, vars, 0);
+  }
+
   for (std::size_t i = 0; i < vars.size(); i++) {
     vars[i].is_stored = false;
   }
@@ -481,6 +507,11 @@ std::string TD_TL_writer_jni_cpp::gen_store_function_begin(const std::string &st
                                  get_pretty_class_name(class_name) + "\");\n");
 }
 
+std::string TD_TL_writer_jni_cpp::gen_store_function_end(const std::vector<tl::var_description> &vars,
+                                                         int storer_type) const {
+  return TD_TL_writer_cpp::gen_store_function_end(vars, storer_type == 2 ? 0 : storer_type);
+}
+
 std::string TD_TL_writer_jni_cpp::gen_fetch_switch_begin() const {
   return "  if (p == nullptr) { return nullptr; }\n"
          "  switch (env->CallIntMethod(p, jni::GetConstructorID)) {\n";
@@ -30,6 +30,17 @@ int TD_TL_writer_jni_h::get_parser_type(const tl::tl_combinator *t, const std::s
   return 1;
 }
 
+// 0 - conversion to a Java object, 1 - conversion to a string, 2 - serialization in the TL binary format
+int TD_TL_writer_jni_h::get_storer_type(const tl::tl_combinator *t, const std::string &storer_name) const {
+  if (storer_name == "TlStorerToString") {
+    return 1;
+  }
+  if (storer_name == "TlStorerCalcLength" || storer_name == "TlStorerUnsafe") {
+    return 2;
+  }
+  return 0;
+}
+
 std::vector<std::string> TD_TL_writer_jni_h::get_parsers() const {
   std::vector<std::string> parsers;
   parsers.push_back("JNIEnv *env, jobject");
@@ -40,6 +51,8 @@ std::vector<std::string> TD_TL_writer_jni_h::get_storers() const {
   std::vector<std::string> storers;
   storers.push_back("JNIEnv *env, jobject");
   storers.push_back("TlStorerToString");
+  storers.push_back("TlStorerCalcLength");
+  storers.push_back("TlStorerUnsafe");
   return storers;
 }
 
@@ -71,7 +84,8 @@ std::string TD_TL_writer_jni_h::gen_output_begin(const std::string &additional_i
          "#include <jni.h>\n\n" +
          ext_include_str + "\n" + additional_imports +
 
-         "namespace td {\n" + forward_declaration("TlStorerToString") +
+         "namespace td {\n" + forward_declaration("TlStorerToString") + forward_declaration("TlStorerCalcLength") +
+         forward_declaration("TlStorerUnsafe") +
          "\n"
          "namespace " +
          tl_name + " {\n\n";
@@ -103,6 +117,10 @@ std::string TD_TL_writer_jni_h::gen_class_begin(const std::string &class_name, c
            "  virtual void store(JNIEnv *env, jobject &s) const {\n"
            "  }\n\n"
            "  virtual void store(TlStorerToString &s, const char *field_name) const = 0;\n\n"
+           "  virtual void store(TlStorerCalcLength &s) const {\n"
+           "  }\n\n"
+           "  virtual void store(TlStorerUnsafe &s) const {\n"
+           "  }\n\n"
            "  static jclass Class;\n";
   }
   return TD_TL_writer_h::gen_class_begin(class_name, base_class_name, is_proxy, result) + "  static jclass Class;\n";
@@ -114,6 +132,14 @@ std::string TD_TL_writer_jni_h::gen_field_definition(const std::string &class_na
          "fieldID;\n";
 }
 
+std::string TD_TL_writer_jni_h::gen_store_function_begin(const std::string &storer_name,
+                                                         const std::string &class_name, int arity,
+                                                         std::vector<tl::var_description> &vars,
+                                                         int storer_type) const {
+  return TD_TL_writer_h::gen_store_function_begin(storer_name, class_name, arity, vars,
+                                                  storer_type == 2 ? 0 : storer_type);
+}
+
 std::string TD_TL_writer_jni_h::gen_additional_function(const std::string &function_name, const tl::tl_combinator *t,
                                                         bool is_function) const {
   if (function_name == "init_jni_vars") {
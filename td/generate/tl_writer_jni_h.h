@@ -24,6 +24,7 @@ class TD_TL_writer_jni_h final : public TD_TL_writer_h {
   bool is_built_in_complex_type(const std::string &name) const final;
 
   int get_parser_type(const tl::tl_combinator *t, const std::string &parser_name) const final;
+  int get_storer_type(const tl::tl_combinator *t, const std::string &storer_name) const final;
   int get_additional_function_type(const std::string &additional_function_name) const final;
   std::vector<std::string> get_parsers() const final;
   std::vector<std::string> get_storers() const final;
@@ -41,6 +42,9 @@ class TD_TL_writer_jni_h final : public TD_TL_writer_h {
   std::string gen_field_definition(const std::string &class_name, const std::string &type_name,
                                    const std::string &field_name) const final;
 
+  std::string gen_store_function_begin(const std::string &storer_name, const std::string &class_name, int arity,
+                                       std::vector<tl::var_description> &vars, int storer_type) const final;
+
   std::string gen_additional_function(const std::string &function_name, const tl::tl_combinator *t,
                                       bool is_function) const final;
   std::string gen_additional_proxy_function_begin(const std::string &function_name, const tl::tl_type *type,
@@ -109,10 +109,13 @@ std::vector<std::string> TD_TL_writer::get_parsers() const {
 
 std::vector<std::string> TD_TL_writer::get_storers() const {
   std::vector<std::string> storers;
-  if (tl_name == "telegram_api" || tl_name == "mtproto_api" || tl_name == "secret_api") {
+  if (tl_name == "telegram_api" || tl_name == "mtproto_api" || tl_name == "secret_api" || tl_name == "td_api") {
     storers.push_back("TlStorerCalcLength");
     storers.push_back("TlStorerUnsafe");
   }
+  if (tl_name == "telegram_api" || tl_name == "secret_api") {
+    storers.push_back("TlStorerGrowable");
+  }
   storers.push_back("TlStorerToString");
   return storers;
 }
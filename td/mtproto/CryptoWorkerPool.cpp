@@ -0,0 +1,227 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/mtproto/CryptoWorkerPool.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Slice.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace td {
+namespace mtproto {
+
+namespace {
+
+struct CryptoJob {
+  const std::function<void(size_t)> *func;
+  size_t task_count;
+  std::atomic<size_t> next_task{0};
+  std::atomic<size_t> finished_task_count{0};
+};
+
+class CryptoWorkerPoolImpl {
+ public:
+  explicit CryptoWorkerPoolImpl(int32 thread_count) {
+#if !TD_THREAD_UNSUPPORTED
+    for (int32 i = 0; i < thread_count; i++) {
+      threads_.emplace_back([this] { worker_loop(); });
+    }
+#endif
+  }
+  CryptoWorkerPoolImpl(const CryptoWorkerPoolImpl &) = delete;
+  CryptoWorkerPoolImpl &operator=(const CryptoWorkerPoolImpl &) = delete;
+  CryptoWorkerPoolImpl(CryptoWorkerPoolImpl &&) = delete;
+  CryptoWorkerPoolImpl &operator=(CryptoWorkerPoolImpl &&) = delete;
+  ~CryptoWorkerPoolImpl() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_closed_ = true;
+    }
+    worker_cv_.notify_all();
+#if !TD_THREAD_UNSUPPORTED
+    for (auto &worker : threads_) {
+      worker.join();
+    }
+#endif
+  }
+
+  int32 get_thread_count() const {
+#if TD_THREAD_UNSUPPORTED
+    return 0;
+#else
+    return narrow_cast<int32>(threads_.size());
+#endif
+  }
+
+  void run(CryptoJob &job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(&job);
+    }
+    worker_cv_.notify_all();
+
+    while (true) {
+      auto task = job.next_task.fetch_add(1, std::memory_order_relaxed);
+      if (task >= job.task_count) {
+        break;
+      }
+      run_task(job, task);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    td::remove(jobs_, &job);
+    job_cv_.wait(lock, [&job] { return job.finished_task_count.load() == job.task_count; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable worker_cv_;
+  std::condition_variable job_cv_;
+  std::deque<CryptoJob *> jobs_;
+  bool is_closed_ = false;
+#if !TD_THREAD_UNSUPPORTED
+  vector<thread> threads_;
+#endif
+
+  void run_task(CryptoJob &job, size_t task) {
+    (*job.func)(task);
+    if (job.finished_task_count.fetch_add(1) + 1 == job.task_count) {
+      // the job can be destroyed as soon as the counter is updated
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_cv_.notify_all();
+    }
+  }
+
+  void worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      worker_cv_.wait(lock, [this] { return is_closed_ || !jobs_.empty(); });
+      if (is_closed_) {
+        // the pool is destroyed only after all its jobs are finished
+        return;
+      }
+      auto *job = jobs_.front();
+      // the task is claimed under the lock, so the job can't be finished and destroyed concurrently
+      auto task = job->next_task.fetch_add(1, std::memory_order_relaxed);
+      if (task >= job->task_count) {
+        jobs_.pop_front();
+        continue;
+      }
+      lock.unlock();
+      run_task(*job, task);
+      lock.lock();
+    }
+  }
+};
+
+constexpr int32 MAX_THREAD_COUNT = 32;
+
+int32 get_default_thread_count() {
+  const char *str = std::getenv("TDLIB_CRYPTO_THREAD_COUNT");
+  if (str == nullptr) {
+    return 0;
+  }
+  auto r_thread_count = to_integer_safe<int32>(Slice(str));
+  if (r_thread_count.is_error() || r_thread_count.ok() < 0) {
+    LOG(ERROR) << "Ignore invalid value \"" << str << "\" of TDLIB_CRYPTO_THREAD_COUNT";
+    return 0;
+  }
+  return r_thread_count.ok();
+}
+
+class CryptoWorkerPoolState {
+ public:
+  CryptoWorkerPoolState() {
+    set_thread_count(get_default_thread_count());
+  }
+
+  void set_thread_count(int32 thread_count) {
+    thread_count = clamp(thread_count, 0, MAX_THREAD_COUNT);
+#if TD_THREAD_UNSUPPORTED
+    thread_count = 0;
+#endif
+    std::shared_ptr<CryptoWorkerPoolImpl> old_pool;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (thread_count == (pool_ == nullptr ? 0 : pool_->get_thread_count())) {
+        return;
+      }
+      old_pool = std::move(pool_);
+      if (thread_count > 0) {
+        LOG(INFO) << "Use " << thread_count << " crypto worker threads";
+        pool_ = std::make_shared<CryptoWorkerPoolImpl>(thread_count);
+      }
+      is_enabled_.store(pool_ != nullptr, std::memory_order_relaxed);
+    }
+    // the threads of the old pool are joined after its running jobs are finished
+  }
+
+  int32 get_thread_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pool_ == nullptr ? 0 : pool_->get_thread_count();
+  }
+
+  bool is_enabled() const {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  std::shared_ptr<CryptoWorkerPoolImpl> get_pool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pool_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::shared_ptr<CryptoWorkerPoolImpl> pool_;
+  std::atomic<bool> is_enabled_{false};
+};
+
+// the worker threads are joined when the state is destroyed on exit
+CryptoWorkerPoolState &get_pool_state() {
+  static CryptoWorkerPoolState state;
+  return state;
+}
+
+}  // namespace
+
+void CryptoWorkerPool::set_thread_count(int32 thread_count) {
+  get_pool_state().set_thread_count(thread_count);
+}
+
+int32 CryptoWorkerPool::get_thread_count() {
+  return get_pool_state().get_thread_count();
+}
+
+bool CryptoWorkerPool::is_enabled() {
+  return get_pool_state().is_enabled();
+}
+
+void CryptoWorkerPool::run(size_t task_count, const std::function<void(size_t)> &func) {
+  auto pool = task_count <= 1 ? nullptr : get_pool_state().get_pool();
+  if (pool == nullptr) {
+    for (size_t i = 0; i < task_count; i++) {
+      func(i);
+    }
+    return;
+  }
+
+  CryptoJob job;
+  job.func = &func;
+  job.task_count = task_count;
+  pool->run(job);
+}
+
+}  // namespace mtproto
+}  // namespace td
@@ -0,0 +1,33 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <functional>
+
+namespace td {
+namespace mtproto {
+
+// optional process-wide pool of threads used to encrypt and decrypt MTProto packets of a connection in parallel
+class CryptoWorkerPool {
+ public:
+  // 0 disables the pool; threads of the previous pool are joined after its running jobs are finished
+  // by default the number of threads is taken from the environment variable TDLIB_CRYPTO_THREAD_COUNT
+  static void set_thread_count(int32 thread_count);
+
+  static int32 get_thread_count();
+
+  static bool is_enabled();
+
+  // calls func(i) for all i from 0 to task_count - 1 in the calling thread and in the worker threads
+  // returns after all calls are finished
+  static void run(size_t task_count, const std::function<void(size_t)> &func);
+};
+
+}  // namespace mtproto
+}  // namespace td
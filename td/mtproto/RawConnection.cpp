@@ -7,6 +7,7 @@
 #include "td/mtproto/RawConnection.h"
 
 #include "td/mtproto/AuthKey.h"
+#include "td/mtproto/CryptoWorkerPool.h"
 #include "td/mtproto/IStreamTransport.h"
 #include "td/mtproto/ProxySecret.h"
 #include "td/mtproto/Transport.h"
@@ -15,9 +16,11 @@
 #include "td/net/DarwinHttp.h"
 #endif
 
+#include "td/utils/crypto.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/misc.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/port/EventFd.h"
@@ -36,6 +39,16 @@ RawConnection::~RawConnection() {
   LOG(DEBUG) << "Destroy raw connection " << this;
 }
 
+static void on_network_read(size_t size) {
+  static auto *counter = MetricsRegistry::get_counter("td_network_received_bytes_total");
+  counter->add(static_cast<int64>(size));
+}
+
+static void on_network_write(size_t size) {
+  static auto *counter = MetricsRegistry::get_counter("td_network_sent_bytes_total");
+  counter->add(static_cast<int64>(size));
+}
+
 class RawConnectionDefault final : public RawConnection {
  public:
   RawConnectionDefault(BufferedFd<SocketFd> buffered_socket_fd, TransportType transport_type,
@@ -67,8 +80,13 @@ class RawConnectionDefault final : public RawConnection {
     packet_info.salt = salt;
     packet_info.session_id = session_id;
     packet_info.use_random_padding = transport_->use_random_padding();
-    auto packet =
-        Transport::write(storer, auth_key, &packet_info, transport_->max_prepend_size(), transport_->max_append_size());
+    AesIgeBuffer *deferred_encryption = nullptr;
+    if (is_send_batch_started_) {
+      pending_encryptions_.emplace_back();
+      deferred_encryption = &pending_encryptions_.back();
+    }
+    auto packet = Transport::write(storer, auth_key, &packet_info, transport_->max_prepend_size(),
+                                   transport_->max_append_size(), deferred_encryption);
 
     bool use_quick_ack = false;
     if (quick_ack_token != 0 && transport_->support_quick_ack()) {
@@ -82,11 +100,17 @@ class RawConnectionDefault final : public RawConnection {
     }
 
     auto packet_size = packet.size();
-    transport_->write(std::move(packet), use_quick_ack);
+    if (deferred_encryption != nullptr) {
+      pending_packets_.push_back({std::move(packet), use_quick_ack});
+    } else {
+      transport_->write(std::move(packet), use_quick_ack);
+    }
     return packet_size;
   }
 
   void send_no_crypto(const Storer &storer) final {
+    flush_send_batch();
+
     PacketInfo packet_info;
     packet_info.no_crypto_flag = true;
     auto packet = Transport::write(storer, AuthKey(), &packet_info, transport_->max_prepend_size(),
@@ -96,6 +120,17 @@ class RawConnectionDefault final : public RawConnection {
     transport_->write(std::move(packet), false);
   }
 
+  void start_send_batch() final {
+    CHECK(!is_send_batch_started_);
+    is_send_batch_started_ = true;
+  }
+
+  void finish_send_batch() final {
+    CHECK(is_send_batch_started_);
+    is_send_batch_started_ = false;
+    flush_send_batch();
+  }
+
   PollableFdInfo &get_poll_info() final {
     return socket_fd_.get_poll_info();
   }
@@ -106,6 +141,7 @@ class RawConnectionDefault final : public RawConnection {
 
   // NB: After first returned error, all subsequent calls will return error too.
   Status flush(const AuthKey &auth_key, Callback &callback) final {
+    flush_send_batch();
     auto status = do_flush(auth_key, callback);
     if (status.is_error()) {
       if (stats_callback_ && status.code() != 2) {
@@ -122,6 +158,9 @@ class RawConnectionDefault final : public RawConnection {
 
   void close() final {
     LOG(DEBUG) << "Close raw connection " << this;
+    pending_packets_.clear();
+    pending_encryptions_.clear();
+    pending_read_packets_.clear();
     transport_.reset();
     socket_fd_.close();
   }
@@ -140,15 +179,52 @@ class RawConnectionDefault final : public RawConnection {
   FlatHashMap<uint32, uint64> quick_ack_to_token_;
   bool has_error_{false};
 
+  struct PendingPacket {
+    BufferWriter packet;
+    bool use_quick_ack;
+  };
+  bool is_send_batch_started_ = false;
+  vector<PendingPacket> pending_packets_;
+  vector<AesIgeBuffer> pending_encryptions_;
+  vector<BufferSlice> pending_read_packets_;
+
+  static constexpr size_t MAX_PARALLEL_TASK_COUNT = 8;
+
   unique_ptr<StatsCallback> stats_callback_;
 
   ConnectionManager::ConnectionToken connection_token_;
 
+  void flush_send_batch() {
+    if (pending_packets_.empty()) {
+      return;
+    }
+    CHECK(pending_packets_.size() == pending_encryptions_.size());
+    if (CryptoWorkerPool::is_enabled() && pending_encryptions_.size() > 1) {
+      // each worker encrypts a contiguous part of the packets; packet order is kept, because all of them are
+      // written to the transport after the encryption is finished
+      auto packet_count = pending_encryptions_.size();
+      auto task_count = td::min(packet_count, MAX_PARALLEL_TASK_COUNT);
+      CryptoWorkerPool::run(task_count, [&](size_t task) {
+        auto begin = packet_count * task / task_count;
+        auto end = packet_count * (task + 1) / task_count;
+        aes_ige_encrypt_batch(MutableSpan<AesIgeBuffer>(pending_encryptions_.data() + begin, end - begin));
+      });
+    } else {
+      aes_ige_encrypt_batch(pending_encryptions_);
+    }
+    for (auto &pending_packet : pending_packets_) {
+      transport_->write(std::move(pending_packet.packet), pending_packet.use_quick_ack);
+    }
+    pending_packets_.clear();
+    pending_encryptions_.clear();
+  }
+
   void on_read(size_t size, Callback &callback) {
     if (size <= 0) {
       return;
     }
 
+    on_network_read(size);
     if (stats_callback_) {
       stats_callback_->on_read(size);
     }
@@ -160,6 +236,16 @@ class RawConnectionDefault final : public RawConnection {
     if (r.is_ok()) {
       on_read(r.ok(), callback);
     }
+    auto status = read_packets(auth_key, callback);
+    auto pending_status = process_pending_read_packets(auth_key, callback);
+    TRY_STATUS(std::move(pending_status));
+    TRY_STATUS(std::move(status));
+    TRY_STATUS(std::move(r));
+    return Status::OK();
+  }
+
+  Status read_packets(const AuthKey &auth_key, Callback &callback) {
+    bool defer_decryption = CryptoWorkerPool::is_enabled() && !auth_key.empty();
     while (transport_->can_read()) {
       BufferSlice packet;
       uint32 quick_ack = 0;
@@ -172,6 +258,7 @@ class RawConnectionDefault final : public RawConnection {
         break;
       }
       if (quick_ack != 0) {
+        TRY_STATUS(process_pending_read_packets(auth_key, callback));
         TRY_STATUS(on_quick_ack(quick_ack, callback));
         continue;
       }
@@ -186,35 +273,67 @@ class RawConnectionDefault final : public RawConnection {
           << old_pointer << ' ' << packet.as_slice().ubegin() << ' ' << BufferSlice(0).as_slice().ubegin() << ' '
           << packet.size() << ' ' << wait_size << ' ' << quick_ack;
 
+      if (defer_decryption) {
+        pending_read_packets_.push_back(std::move(packet));
+        continue;
+      }
+
       PacketInfo packet_info;
       packet_info.version = 2;
+      auto r_read_result = Transport::read(packet.as_mutable_slice(), auth_key, &packet_info);
+      TRY_STATUS(on_read_packet(std::move(packet), packet_info, std::move(r_read_result), auth_key, callback));
+    }
+    return Status::OK();
+  }
 
-      TRY_RESULT(read_result, Transport::read(packet.as_mutable_slice(), auth_key, &packet_info));
-      switch (read_result.type()) {
-        case Transport::ReadResult::Quickack:
-          TRY_STATUS(on_quick_ack(read_result.quick_ack(), callback));
-          break;
-        case Transport::ReadResult::Error:
-          TRY_STATUS(on_read_mtproto_error(read_result.error()));
-          break;
-        case Transport::ReadResult::Packet:
-          // If a packet was successfully decrypted, then it is ok to assume that the connection is alive
-          if (!auth_key.empty()) {
-            if (stats_callback_) {
-              stats_callback_->on_pong();
-            }
+  // decrypts all pending packets in parallel and processes them in the order of receiving
+  Status process_pending_read_packets(const AuthKey &auth_key, Callback &callback) {
+    if (pending_read_packets_.empty()) {
+      return Status::OK();
+    }
+    auto packets = std::move(pending_read_packets_);
+    pending_read_packets_.clear();
+
+    auto packet_count = packets.size();
+    vector<PacketInfo> packet_infos(packet_count);
+    vector<Result<Transport::ReadResult>> read_results(packet_count);
+    // Transport::read depends only on the packet and the authorization key, so it can be called from any thread
+    CryptoWorkerPool::run(packet_count, [&](size_t i) {
+      packet_infos[i].version = 2;
+      read_results[i] = Transport::read(packets[i].as_mutable_slice(), auth_key, &packet_infos[i]);
+    });
+
+    for (size_t i = 0; i < packet_count; i++) {
+      TRY_STATUS(on_read_packet(std::move(packets[i]), packet_infos[i], std::move(read_results[i]), auth_key, callback));
+    }
+    return Status::OK();
+  }
+
+  Status on_read_packet(BufferSlice packet, const PacketInfo &packet_info, Result<Transport::ReadResult> r_read_result,
+                        const AuthKey &auth_key, Callback &callback) {
+    TRY_RESULT(read_result, std::move(r_read_result));
+    switch (read_result.type()) {
+      case Transport::ReadResult::Quickack:
+        TRY_STATUS(on_quick_ack(read_result.quick_ack(), callback));
+        break;
+      case Transport::ReadResult::Error:
+        TRY_STATUS(on_read_mtproto_error(read_result.error()));
+        break;
+      case Transport::ReadResult::Packet:
+        // If a packet was successfully decrypted, then it is ok to assume that the connection is alive
+        if (!auth_key.empty()) {
+          if (stats_callback_) {
+            stats_callback_->on_pong();
           }
+        }
 
-          TRY_STATUS(callback.on_raw_packet(packet_info, packet.from_slice(read_result.packet())));
-          break;
-        case Transport::ReadResult::Nop:
-          break;
-        default:
-          UNREACHABLE();
-      }
+        TRY_STATUS(callback.on_raw_packet(packet_info, packet.from_slice(read_result.packet())));
+        break;
+      case Transport::ReadResult::Nop:
+        break;
+      default:
+        UNREACHABLE();
     }
-
-    TRY_STATUS(std::move(r));
     return Status::OK();
   }
 
@@ -250,6 +369,7 @@ class RawConnectionDefault final : public RawConnection {
 
   Status flush_write() {
     TRY_RESULT(size, socket_fd_.flush_write());
+    on_network_write(size);
     if (size > 0 && stats_callback_) {
       stats_callback_->on_write(size);
     }
@@ -277,6 +397,8 @@ class RawConnectionDefault final : public RawConnection {
   }
 };
 
+constexpr size_t RawConnectionDefault::MAX_PARALLEL_TASK_COUNT;
+
 #if TD_DARWIN_WATCH_OS
 class RawConnectionHttp final : public RawConnection {
  public:
@@ -323,6 +445,13 @@ class RawConnectionHttp final : public RawConnection {
     send_packet(packet.as_buffer_slice());
   }
 
+  void start_send_batch() final {
+    // HTTP requests are sent one by one
+  }
+
+  void finish_send_batch() final {
+  }
+
   PollableFdInfo &get_poll_info() final {
     return answers_->reader_get_event_fd().get_poll_info();
   }
@@ -377,6 +506,7 @@ class RawConnectionHttp final : public RawConnection {
       return;
     }
 
+    on_network_read(size);
     if (stats_callback_) {
       stats_callback_->on_read(size);
     }
@@ -451,6 +581,7 @@ class RawConnectionHttp final : public RawConnection {
   Status flush_write() {
     for (auto &packet : to_send_) {
       TRY_STATUS(do_send(packet.as_slice()));
+      on_network_write(packet.size());
       if (packet.size() > 0 && stats_callback_) {
         stats_callback_->on_write(packet.size());
       }
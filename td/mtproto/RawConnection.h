@@ -52,6 +52,10 @@ class RawConnection {
                              uint64 quick_ack_token) = 0;
   virtual void send_no_crypto(const Storer &storer) = 0;
 
+  // packets sent by send_crypto between the calls are encrypted together, which is faster for several packets
+  virtual void start_send_batch() = 0;
+  virtual void finish_send_batch() = 0;
+
   virtual PollableFdInfo &get_poll_info() = 0;
   virtual StatsCallback *stats_callback() = 0;
 
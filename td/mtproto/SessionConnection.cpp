@@ -21,6 +21,7 @@
 #include "td/utils/format.h"
 #include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/misc.h"
 #include "td/utils/Random.h"
 #include "td/utils/ScopeGuard.h"
@@ -351,6 +352,7 @@ Status SessionConnection::on_packet(const MsgInfo &info,
       LOG(WARNING) << bad_info << ": MessageId is too high. Session will be closed";
       // All this queries will be re-sent by parent
       to_send_.clear();
+      to_send_size_ = 0;
       reset_server_time_difference(info.message_id);
       callback_->on_session_failed(Status::Error("MessageId is too high"));
       return Status::Error("MessageId is too high");
@@ -697,9 +699,11 @@ bool SessionConnection::must_flush_packet() {
 
 Status SessionConnection::before_write() {
   CHECK(raw_connection_);
+  raw_connection_->start_send_batch();
   while (must_flush_packet()) {
     flush_packet();
   }
+  raw_connection_->finish_send_batch();
   return Status::OK();
 }
 
@@ -815,8 +819,13 @@ Result<MessageId> SessionConnection::send_query(BufferSlice buffer, bool gzip_fl
   if (to_send_.empty()) {
     send_before(Time::now_cached() + QUERY_DELAY);
   }
+  to_send_size_ += buffer.size();
   to_send_.push_back(MtprotoQuery{message_id, seq_no, std::move(buffer), gzip_flag, std::move(invoke_after_message_ids),
                                   use_quick_ack});
+  if (to_send_.size() >= MAX_PACKET_QUERY_COUNT || to_send_size_ >= MAX_PACKET_QUERY_SIZE) {
+    // there is no reason to wait for more queries
+    send_before(Time::now_cached());
+  }
   VLOG(mtproto) << "Invoke query with " << message_id << " and seq_no " << seq_no << " of size "
                 << to_send_.back().packet.size() << " after " << invoke_after_message_ids
                 << (use_quick_ack ? " with quick ack" : "");
@@ -941,19 +950,21 @@ void SessionConnection::flush_packet() {
     }
   }
 
-  static constexpr size_t MAX_QUERY_COUNT = 1000;
   size_t send_till = 0;
   size_t send_size = 0;
   if (has_salt) {
-    // send at most MAX_QUERY_COUNT queries, of total size up to 2^15
-    while (send_till < to_send_.size() && send_till < MAX_QUERY_COUNT && send_size < (1 << 15)) {
+    // send at most MAX_PACKET_QUERY_COUNT queries, of total size up to MAX_PACKET_QUERY_SIZE
+    while (send_till < to_send_.size() && send_till < MAX_PACKET_QUERY_COUNT && send_size < MAX_PACKET_QUERY_SIZE) {
       send_size += to_send_[send_till].packet.size();
       send_till++;
     }
   }
+  CHECK(send_size <= to_send_size_);
+  to_send_size_ -= send_size;
   vector<MtprotoQuery> queries;
   if (send_till == to_send_.size()) {
     queries = std::move(to_send_);
+    to_send_.clear();
   } else if (send_till != 0) {
     queries.reserve(send_till);
     std::move(to_send_.begin(), to_send_.begin() + send_till, std::back_inserter(queries));
@@ -1001,13 +1012,19 @@ void SessionConnection::flush_packet() {
   // no more than 8192 message identifiers per container..
   auto to_resend_answer = cut_tail(to_resend_answer_message_ids_, 8192, "resend_answer");
   MessageId resend_answer_message_id;
-  CHECK(queries.size() <= MAX_QUERY_COUNT);
-  auto to_cancel_answer = cut_tail(to_cancel_answer_message_ids_, MAX_QUERY_COUNT - queries.size(), "cancel_answer");
+  CHECK(queries.size() <= MAX_PACKET_QUERY_COUNT);
+  auto to_cancel_answer =
+      cut_tail(to_cancel_answer_message_ids_, MAX_PACKET_QUERY_COUNT - queries.size(), "cancel_answer");
   auto to_get_state_info = cut_tail(to_get_state_info_message_ids_, 8192, "get_state_info");
   MessageId get_state_info_message_id;
   auto to_ack = cut_tail(to_ack_message_ids_, 8192, "ack");
   MessageId ping_message_id;
 
+  static auto *query_count_histogram = MetricsRegistry::get_histogram("td_mtproto_packet_query_count", 1.0);
+  static auto *ack_count_histogram = MetricsRegistry::get_histogram("td_mtproto_packet_ack_count", 1.0);
+  query_count_histogram->observe(static_cast<double>(queries.size()));
+  ack_count_histogram->observe(static_cast<double>(to_ack.size()));
+
   bool use_quick_ack = any_of(queries, [](const auto &query) { return query.use_quick_ack; });
 
   {
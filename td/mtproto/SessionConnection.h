@@ -118,10 +118,16 @@ class SessionConnection final
   void force_close(SessionConnection::Callback *callback);
 
  private:
+  // maximum delays before sending of pending messages of each kind; all pending messages are sent in one packet,
+  // so acknowledgements are usually sent together with queries long before their delay expires
   static constexpr int ACK_DELAY = 30;                  // 30s
   static constexpr double QUERY_DELAY = 0.001;          // 0.001s
   static constexpr double RESEND_ANSWER_DELAY = 0.001;  // 0.001s
 
+  // pending queries are sent immediately if they fill a whole packet
+  static constexpr size_t MAX_PACKET_QUERY_COUNT = 1000;
+  static constexpr size_t MAX_PACKET_QUERY_SIZE = 1 << 15;
+
   struct MsgInfo {
     MessageId message_id;
     int32 seq_no;
@@ -161,6 +167,7 @@ class SessionConnection final
   static constexpr int HTTP_MAX_DELAY = 30;  // 0.03s
 
   vector<MtprotoQuery> to_send_;
+  size_t to_send_size_ = 0;
   vector<MessageId> to_ack_message_ids_;
   double force_send_at_ = 0;
 
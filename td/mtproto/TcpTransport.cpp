@@ -167,7 +167,7 @@ void ObfuscatedTransport::do_write_main(BufferWriter &&message) {
     builder.prepend(header_);
     header_ = {};
   }
-  do_write(builder.extract());
+  do_write(std::move(builder));
 }
 
 void ObfuscatedTransport::do_write_tls(BufferWriter &&message) {
@@ -209,11 +209,13 @@ void ObfuscatedTransport::do_write_tls(BufferBuilder &&builder) {
     builder.prepend(first_prefix);
   }
 
-  do_write(builder.extract());
+  do_write(std::move(builder));
 }
 
-void ObfuscatedTransport::do_write(BufferSlice &&message) {
-  output_->append(std::move(message));
+void ObfuscatedTransport::do_write(BufferBuilder &&builder) {
+  // the parts are appended separately instead of being merged with BufferBuilder::extract,
+  // so that large message bodies are linked into the output stream and sent with writev without copying
+  std::move(builder).for_each([&](BufferSlice &&slice) { output_->append(std::move(slice)); });
 }
 
 }  // namespace tcp
@@ -171,7 +171,7 @@ class ObfuscatedTransport final : public IStreamTransport {
   void do_write_tls(BufferWriter &&message);
   void do_write_tls(BufferBuilder &&builder);
   void do_write_main(BufferWriter &&message);
-  void do_write(BufferSlice &&message);
+  void do_write(BufferBuilder &&builder);
 };
 
 using Transport = ObfuscatedTransport;
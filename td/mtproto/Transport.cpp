@@ -342,7 +342,8 @@ BufferWriter Transport::write_no_crypto(const Storer &storer, PacketInfo *packet
 
 template <class HeaderT>
 void Transport::write_crypto_impl(int X, const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                                  HeaderT *header, size_t data_size, size_t padded_size) {
+                                  HeaderT *header, size_t data_size, size_t padded_size,
+                                  AesIgeBuffer *deferred_encryption) {
   auto real_data_size = storer.store(header->data);
   CHECK(real_data_size == data_size);
   VLOG(raw_mtproto) << "Send packet of size " << data_size << ':'
@@ -362,11 +363,17 @@ void Transport::write_crypto_impl(int X, const Storer &storer, const AuthKey &au
     KDF2(auth_key.key(), header->message_key, X, &aes_key, &aes_iv);
   }
 
+  if (deferred_encryption != nullptr) {
+    deferred_encryption->key = aes_key;
+    deferred_encryption->iv = aes_iv;
+    deferred_encryption->data = to_encrypt;
+    return;
+  }
   aes_ige_encrypt(as_slice(aes_key), as_mutable_slice(aes_iv), to_encrypt, to_encrypt);
 }
 
 BufferWriter Transport::write_crypto(const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                                     size_t prepend_size, size_t append_size) {
+                                     size_t prepend_size, size_t append_size, AesIgeBuffer *deferred_encryption) {
   size_t data_size = storer.size();
   size_t padded_size;
   if (packet_info->version == 1) {
@@ -382,13 +389,13 @@ BufferWriter Transport::write_crypto(const Storer &storer, const AuthKey &auth_k
   header.salt = packet_info->salt;
   header.session_id = packet_info->session_id;
 
-  write_crypto_impl(0, storer, auth_key, packet_info, &header, data_size, padded_size);
+  write_crypto_impl(0, storer, auth_key, packet_info, &header, data_size, padded_size, deferred_encryption);
 
   return packet;
 }
 
 BufferWriter Transport::write_e2e_crypto(const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                                         size_t prepend_size, size_t append_size) {
+                                         size_t prepend_size, size_t append_size, AesIgeBuffer *deferred_encryption) {
   size_t data_size = storer.size();
   size_t padded_size;
   if (packet_info->version == 1) {
@@ -403,7 +410,7 @@ BufferWriter Transport::write_e2e_crypto(const Storer &storer, const AuthKey &au
   header.auth_key_id = auth_key.id();
 
   write_crypto_impl(packet_info->is_creator || packet_info->version == 1 ? 0 : 8, storer, auth_key, packet_info,
-                    &header, data_size, padded_size);
+                    &header, data_size, padded_size, deferred_encryption);
 
   return packet;
 }
@@ -448,15 +455,16 @@ Result<Transport::ReadResult> Transport::read(MutableSlice message, const AuthKe
 }
 
 BufferWriter Transport::write(const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                              size_t prepend_size, size_t append_size) {
+                              size_t prepend_size, size_t append_size, AesIgeBuffer *deferred_encryption) {
   if (packet_info->type == PacketInfo::EndToEnd) {
-    return write_e2e_crypto(storer, auth_key, packet_info, prepend_size, append_size);
+    return write_e2e_crypto(storer, auth_key, packet_info, prepend_size, append_size, deferred_encryption);
   }
   if (packet_info->no_crypto_flag) {
+    CHECK(deferred_encryption == nullptr);
     return write_no_crypto(storer, packet_info, prepend_size, append_size);
   } else {
     CHECK(!auth_key.empty());
-    return write_crypto(storer, auth_key, packet_info, prepend_size, append_size);
+    return write_crypto(storer, auth_key, packet_info, prepend_size, append_size, deferred_encryption);
   }
 }
 
@@ -20,6 +20,8 @@
 
 namespace td {
 
+struct AesIgeBuffer;
+
 extern int VERBOSITY_NAME(raw_mtproto);
 
 namespace mtproto {
@@ -90,8 +92,11 @@ class Transport {
   static Result<ReadResult> read(MutableSlice message, const AuthKey &auth_key,
                                  PacketInfo *packet_info) TD_WARN_UNUSED_RESULT;
 
+  // If [deferred_encryption] is non-null, an encrypted packet is left unencrypted and [deferred_encryption] is
+  // filled instead; the packet must be encrypted with aes_ige_encrypt_batch before it is sent.
   static BufferWriter write(const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                            size_t prepend_size = 0, size_t append_size = 0);
+                            size_t prepend_size = 0, size_t append_size = 0,
+                            AesIgeBuffer *deferred_encryption = nullptr);
 
   // public for testing purposes
   static std::pair<uint32, UInt128> calc_message_key2(const AuthKey &auth_key, int X, Slice to_encrypt);
@@ -125,14 +130,15 @@ class Transport {
                                       size_t append_size);
 
   static BufferWriter write_crypto(const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                                   size_t prepend_size, size_t append_size);
+                                   size_t prepend_size, size_t append_size, AesIgeBuffer *deferred_encryption);
 
   static BufferWriter write_e2e_crypto(const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                                       size_t prepend_size, size_t append_size);
+                                       size_t prepend_size, size_t append_size, AesIgeBuffer *deferred_encryption);
 
   template <class HeaderT>
   static void write_crypto_impl(int X, const Storer &storer, const AuthKey &auth_key, PacketInfo *packet_info,
-                                HeaderT *header, size_t data_size, size_t padded_size);
+                                HeaderT *header, size_t data_size, size_t padded_size,
+                                AesIgeBuffer *deferred_encryption);
 };
 
 }  // namespace mtproto
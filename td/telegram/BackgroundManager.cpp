@@ -500,6 +500,12 @@ void BackgroundManager::store_background(BackgroundId background_id, LogEventSto
   store(*background, storer);
 }
 
+void BackgroundManager::store_background(BackgroundId background_id, LogEventStorerGrowable &storer) {
+  const auto *background = get_background(background_id);
+  CHECK(background != nullptr);
+  store(*background, storer);
+}
+
 void BackgroundManager::store_background(BackgroundId background_id, LogEventStorerUnsafe &storer) {
   const auto *background = get_background(background_id);
   CHECK(background != nullptr);
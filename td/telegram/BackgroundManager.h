@@ -74,6 +74,8 @@ class BackgroundManager final : public Actor {
 
   void store_background(BackgroundId background_id, LogEventStorerCalcLength &storer);
 
+  void store_background(BackgroundId background_id, LogEventStorerGrowable &storer);
+
   void store_background(BackgroundId background_id, LogEventStorerUnsafe &storer);
 
   void parse_background(BackgroundId &background_id, LogEventParser &parser);
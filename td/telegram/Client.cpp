@@ -9,6 +9,8 @@
 #include "td/telegram/Td.h"
 #include "td/telegram/TdCallback.h"
 
+#include "td/mtproto/CryptoWorkerPool.h"
+
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
 
@@ -23,17 +25,22 @@
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/port/RwMutex.h"
 #include "td/utils/port/thread.h"
+#include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/utf8.h"
 
-#include <algorithm>
+#include <array>
 #include <atomic>
+#include <condition_variable>
+#include <cstdlib>
 #include <limits>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <utility>
 
 namespace td {
 
@@ -46,7 +53,7 @@ class TdReceiver {
       responses_.pop();
       return result;
     }
-    return {0, 0, nullptr};
+    return {0, 0, nullptr, string()};
   }
 
   unique_ptr<TdCallback> create_callback(ClientManager::ClientId client_id) {
@@ -55,17 +62,17 @@ class TdReceiver {
       Callback(ClientManager::ClientId client_id, TdReceiver *impl) : client_id_(client_id), impl_(impl) {
       }
       void on_result(uint64 id, td_api::object_ptr<td_api::Object> result) final {
-        impl_->responses_.push({client_id_, id, std::move(result)});
+        impl_->responses_.push({client_id_, id, std::move(result), string()});
       }
       void on_error(uint64 id, td_api::object_ptr<td_api::error> error) final {
-        impl_->responses_.push({client_id_, id, std::move(error)});
+        impl_->responses_.push({client_id_, id, std::move(error), string()});
       }
       Callback(const Callback &) = delete;
       Callback &operator=(const Callback &) = delete;
       Callback(Callback &&) = delete;
       Callback &operator=(Callback &&) = delete;
       ~Callback() final {
-        impl_->responses_.push({client_id_, 0, nullptr});
+        impl_->responses_.push({client_id_, 0, nullptr, string()});
       }
 
      private:
@@ -76,7 +83,7 @@ class TdReceiver {
   }
 
   void add_response(ClientManager::ClientId client_id, uint64 id, td_api::object_ptr<td_api::Object> result) {
-    responses_.push({client_id, id, std::move(result)});
+    responses_.push({client_id, id, std::move(result), string()});
   }
 
  private:
@@ -92,6 +99,22 @@ class ClientManager::Impl final {
     return client_id;
   }
 
+  void set_response_encoder(ResponseEncoderPtr encoder) {
+    // responses are received in the same thread, so there is no reason to serialize them in advance
+  }
+
+  static void set_thread_count(int32 scheduler_count, int32 additional_thread_count) {
+    // all clients are run in the thread calling receive
+  }
+
+  vector<int32> get_client_distribution() const {
+    vector<int32> result;
+    if (!tds_.empty()) {
+      result.push_back(narrow_cast<int32>(tds_.size()));
+    }
+    return result;
+  }
+
   void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
     if (pending_clients_.erase(client_id) != 0) {
       if (tds_.empty()) {
@@ -171,6 +194,29 @@ class ClientManager::Impl final {
     return response;
   }
 
+  void set_response_partitioner(int32 partition_count, ResponsePartitionerPtr partitioner) {
+    // responses are received in the same thread, so there is no reason to partition them
+  }
+
+  Response receive_partition(int32 partition, double timeout) {
+    if (partition != 0) {
+      return {0, 0, nullptr, string()};
+    }
+    return receive(timeout);
+  }
+
+  vector<Response> receive_batch(size_t max_count, double timeout) {
+    vector<Response> responses;
+    while (responses.size() < max_count) {
+      auto response = receive(responses.empty() ? timeout : 0.0);
+      if (response.object == nullptr) {
+        break;
+      }
+      responses.push_back(std::move(response));
+    }
+    return responses;
+  }
+
   Impl() = default;
   Impl(const Impl &) = delete;
   Impl &operator=(const Impl &) = delete;
@@ -269,91 +315,358 @@ class MultiTd final : public Actor {
   FlatHashMap<int32, ActorOwn<Td>> tds_;
 };
 
-class TdReceiver {
+// pool of threads, which execute synchronous requests sent asynchronously,
+// so that they don't wait in the mailbox of the Td actor behind other requests;
+// requests of every client are executed in order and clients are served in a round-robin fashion
+class SynchronousRequestPool {
  public:
-  TdReceiver() {
-    output_queue_ = std::make_shared<OutputQueue>();
-    output_queue_->init();
+  // the pool is shared between all receivers and is destroyed together with the last of them
+  static std::shared_ptr<SynchronousRequestPool> get_pool() {
+    static std::mutex pool_mutex;
+    static std::weak_ptr<SynchronousRequestPool> weak_pool;
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    auto pool = weak_pool.lock();
+    if (pool == nullptr) {
+      pool = std::make_shared<SynchronousRequestPool>();
+      weak_pool = pool;
+    }
+    return pool;
   }
 
-  ClientManager::Response receive(double timeout, bool from_manager) {
-    VLOG(td_requests) << "Begin to wait for updates with timeout " << timeout;
-    auto is_locked = receive_lock_.exchange(true);
-    if (is_locked) {
-      if (from_manager) {
-        LOG(FATAL) << "Receive must not be called simultaneously from two different threads, but this has just "
-                      "happened. Call it from a fixed thread, dedicated for updates and response processing.";
+  SynchronousRequestPool() {
+    auto thread_count = clamp(static_cast<int32>(thread::hardware_concurrency()) / 4, 1, MAX_THREAD_COUNT);
+    for (int32 i = 0; i < thread_count; i++) {
+      threads_.emplace_back([this] { worker_loop(); });
+    }
+  }
+  SynchronousRequestPool(const SynchronousRequestPool &) = delete;
+  SynchronousRequestPool &operator=(const SynchronousRequestPool &) = delete;
+  SynchronousRequestPool(SynchronousRequestPool &&) = delete;
+  SynchronousRequestPool &operator=(SynchronousRequestPool &&) = delete;
+  ~SynchronousRequestPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_closing_ = true;
+    }
+    condition_variable_.notify_all();
+    for (auto &worker : threads_) {
+      if (!ExitGuard::is_exited()) {
+        worker.join();
       } else {
-        LOG(FATAL) << "Receive is called after Client destroy, or simultaneously from different threads";
+        worker.detach();
       }
     }
-    auto response = receive_unlocked(clamp(timeout, 0.0, 1000000.0));
-    is_locked = receive_lock_.exchange(false);
-    CHECK(is_locked);
+  }
+
+  void execute(ClientManager::ClientId client_id, td_api::object_ptr<td_api::Function> &&function,
+               Promise<td_api::object_ptr<td_api::Object>> &&promise) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto &client = clients_[client_id];
+      client.requests.push(Request{std::move(function), std::move(promise)});
+      if (client.requests.size() != 1u || client.is_running) {
+        return;
+      }
+      ready_client_ids_.push(client_id);
+    }
+    condition_variable_.notify_all();
+  }
+
+  // waits until all synchronous requests of the client are executed
+  void wait_client(ClientManager::ClientId client_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_variable_.wait(lock, [&] { return clients_.count(client_id) == 0; });
+  }
+
+ private:
+  static constexpr int32 MAX_THREAD_COUNT = 4;
+
+  struct Request {
+    td_api::object_ptr<td_api::Function> function;
+    Promise<td_api::object_ptr<td_api::Object>> promise;
+  };
+
+  struct ClientRequests {
+    std::queue<Request> requests;
+    bool is_running = false;
+  };
+
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  FlatHashMap<ClientManager::ClientId, ClientRequests> clients_;
+  std::queue<ClientManager::ClientId> ready_client_ids_;
+  bool is_closing_ = false;
+  vector<thread> threads_;
+
+  void worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      condition_variable_.wait(lock, [this] { return is_closing_ || !ready_client_ids_.empty(); });
+      if (ready_client_ids_.empty()) {
+        CHECK(is_closing_);
+        return;
+      }
+      auto client_id = ready_client_ids_.front();
+      ready_client_ids_.pop();
+      auto &client = clients_[client_id];
+      CHECK(!client.is_running);
+      CHECK(!client.requests.empty());
+      client.is_running = true;
+      auto request = std::move(client.requests.front());
+      client.requests.pop();
+      lock.unlock();
+
+      request.promise.set_value(Td::static_request(std::move(request.function)));
+
+      lock.lock();
+      auto it = clients_.find(client_id);
+      CHECK(it != clients_.end());
+      it->second.is_running = false;
+      if (it->second.requests.empty()) {
+        clients_.erase(it);
+        condition_variable_.notify_all();
+      } else {
+        // let requests of the other clients run first
+        ready_client_ids_.push(client_id);
+        condition_variable_.notify_one();
+      }
+    }
+  }
+};
+
+constexpr int32 SynchronousRequestPool::MAX_THREAD_COUNT;
+
+class TdReceiver {
+ public:
+  static constexpr int32 MAX_PARTITION_COUNT = 64;
+
+  TdReceiver() : synchronous_request_pool_(SynchronousRequestPool::get_pool()) {
+    partitions_[0] = td::make_unique<Partition>();
+  }
+
+  // can be called only once; the partitions are published after they are created,
+  // so they can be used concurrently from other threads
+  void set_partition_count(int32 partition_count) {
+    CHECK(partition_count_.load(std::memory_order_relaxed) == 1);
+    CHECK(1 <= partition_count && partition_count <= MAX_PARTITION_COUNT);
+    for (int32 i = 1; i < partition_count; i++) {
+      partitions_[i] = td::make_unique<Partition>();
+    }
+    partition_count_.store(partition_count, std::memory_order_release);
+  }
+
+  ClientManager::Response receive(double timeout, bool from_manager) {
+    return receive_partition(0, timeout, from_manager);
+  }
+
+  ClientManager::Response receive_partition(int32 partition_id, double timeout, bool from_manager) {
+    if (partition_id < 0 || partition_id >= partition_count_.load(std::memory_order_acquire)) {
+      LOG(ERROR) << "Receive from invalid partition " << partition_id;
+      return {0, 0, nullptr, string()};
+    }
+    auto &partition = *partitions_[partition_id];
+    VLOG(td_requests) << "Begin to wait for updates with timeout " << timeout;
+    lock_receive(partition, from_manager);
+    auto response = receive_unlocked(partition, clamp(timeout, 0.0, 1000000.0));
+    unlock_receive(partition);
     VLOG(td_requests) << "End to wait for updates, returning object " << response.request_id << ' '
                       << response.object.get();
     return response;
   }
 
-  unique_ptr<TdCallback> create_callback(ClientManager::ClientId client_id) {
+  vector<ClientManager::Response> receive_batch(size_t max_count, double timeout, bool from_manager) {
+    VLOG(td_requests) << "Begin to wait for at most " << max_count << " updates with timeout " << timeout;
+    vector<ClientManager::Response> responses;
+    auto &partition = *partitions_[0];
+    lock_receive(partition, from_manager);
+    timeout = clamp(timeout, 0.0, 1000000.0);
+    while (responses.size() < max_count) {
+      auto response = receive_unlocked(partition, responses.empty() ? timeout : 0.0);
+      if (response.client_id == 0 && response.request_id == 0 && response.object == nullptr) {
+        break;
+      }
+      responses.push_back(std::move(response));
+    }
+    unlock_receive(partition);
+    VLOG(td_requests) << "End to wait for updates, returning " << responses.size() << " objects";
+    return responses;
+  }
+
+  unique_ptr<TdCallback> create_callback(ClientManager::ClientId client_id,
+                                         ClientManager::ResponseEncoderPtr encoder = nullptr,
+                                         ClientManager::ResponsePartitionerPtr partitioner = nullptr) {
     class Callback final : public TdCallback {
      public:
-      explicit Callback(ClientManager::ClientId client_id, std::shared_ptr<OutputQueue> output_queue)
-          : client_id_(client_id), output_queue_(std::move(output_queue)) {
+      Callback(ClientManager::ClientId client_id, OutputQueues output_queues,
+               std::shared_ptr<SynchronousRequestPool> synchronous_request_pool,
+               ClientManager::ResponseEncoderPtr encoder, ClientManager::ResponsePartitionerPtr partitioner)
+          : client_id_(client_id)
+          , output_queues_(std::move(output_queues))
+          , synchronous_request_pool_(std::move(synchronous_request_pool))
+          , encoder_(encoder)
+          , partitioner_(partitioner) {
       }
       void on_result(uint64 id, td_api::object_ptr<td_api::Object> result) final {
-        output_queue_->writer_put({client_id_, id, std::move(result)});
+        auto &output_queue = get_output_queue(id, *result);
+        auto encoded_object = encode(*result);
+        output_queue.writer_put({client_id_, id, std::move(result), std::move(encoded_object)});
       }
       void on_error(uint64 id, td_api::object_ptr<td_api::error> error) final {
-        output_queue_->writer_put({client_id_, id, std::move(error)});
+        auto &output_queue = get_output_queue(id, *error);
+        auto encoded_object = encode(*error);
+        output_queue.writer_put({client_id_, id, std::move(error), std::move(encoded_object)});
       }
       Callback(const Callback &) = delete;
       Callback &operator=(const Callback &) = delete;
       Callback(Callback &&) = delete;
       Callback &operator=(Callback &&) = delete;
       ~Callback() final {
-        output_queue_->writer_put({client_id_, 0, nullptr});
+        // responses to synchronous requests must not be received after the final empty response
+        synchronous_request_pool_->wait_client(client_id_);
+        output_queues_[0]->writer_put({client_id_, 0, nullptr, string()});
       }
 
      private:
       ClientManager::ClientId client_id_;
-      std::shared_ptr<OutputQueue> output_queue_;
+      OutputQueues output_queues_;
+      std::shared_ptr<SynchronousRequestPool> synchronous_request_pool_;
+      ClientManager::ResponseEncoderPtr encoder_;
+      ClientManager::ResponsePartitionerPtr partitioner_;
+
+      string encode(const td_api::Object &object) const {
+        // updateAuthorizationState is inspected by ClientManager to destroy closed clients, so it is never serialized
+        if (encoder_ == nullptr || object.get_id() == td_api::updateAuthorizationState::ID) {
+          return string();
+        }
+        return encoder_(object);
+      }
+
+      OutputQueue &get_output_queue(uint64 id, const td_api::Object &object) const {
+        return TdReceiver::get_output_queue(output_queues_, partitioner_, client_id_, id, object);
+      }
     };
-    return td::make_unique<Callback>(client_id, output_queue_);
+    return td::make_unique<Callback>(client_id, get_output_queues(), synchronous_request_pool_, encoder, partitioner);
   }
 
   void add_response(ClientManager::ClientId client_id, uint64 id, td_api::object_ptr<td_api::Object> result) {
-    output_queue_->writer_put({client_id, id, std::move(result)});
+    partitions_[0]->output_queue->writer_put({client_id, id, std::move(result), string()});
+  }
+
+  // the response is sent directly to the receiver, bypassing the Td actor
+  void add_synchronous_request(ClientManager::ClientId client_id, uint64 id,
+                               td_api::object_ptr<td_api::Function> &&function,
+                               ClientManager::ResponseEncoderPtr encoder = nullptr,
+                               ClientManager::ResponsePartitionerPtr partitioner = nullptr) {
+    synchronous_request_pool_->execute(
+        client_id, std::move(function),
+        PromiseCreator::lambda([output_queues = get_output_queues(), client_id, id, encoder,
+                                partitioner](Result<td_api::object_ptr<td_api::Object>> r_result) {
+          if (r_result.is_error()) {
+            return;
+          }
+          auto result = r_result.move_as_ok();
+          auto &output_queue = get_output_queue(output_queues, partitioner, client_id, id, *result);
+          auto encoded_object = encoder == nullptr ? string() : encoder(*result);
+          output_queue.writer_put({client_id, id, std::move(result), std::move(encoded_object)});
+        }));
   }
 
  private:
   using OutputQueue = MpscPollableQueue<ClientManager::Response>;
-  std::shared_ptr<OutputQueue> output_queue_;
-  int output_queue_ready_cnt_{0};
-  std::atomic<bool> receive_lock_{false};
+  using OutputQueues = vector<std::shared_ptr<OutputQueue>>;
+
+  std::shared_ptr<SynchronousRequestPool> synchronous_request_pool_;
+
+  struct Partition {
+    std::shared_ptr<OutputQueue> output_queue;
+    int output_queue_ready_cnt{0};
+    std::atomic<bool> receive_lock{false};
+
+    Partition() {
+      output_queue = std::make_shared<OutputQueue>();
+      output_queue->init();
+    }
+  };
+  // the slots are preallocated, so that existing partitions aren't moved when new partitions are added
+  std::array<unique_ptr<Partition>, MAX_PARTITION_COUNT> partitions_;
+  std::atomic<int32> partition_count_{1};
+
+  OutputQueues get_output_queues() const {
+    auto partition_count = partition_count_.load(std::memory_order_acquire);
+    OutputQueues output_queues;
+    output_queues.reserve(partition_count);
+    for (int32 i = 0; i < partition_count; i++) {
+      output_queues.push_back(partitions_[i]->output_queue);
+    }
+    return output_queues;
+  }
 
-  ClientManager::Response receive_unlocked(double timeout) {
-    if (output_queue_ready_cnt_ == 0) {
-      output_queue_ready_cnt_ = output_queue_->reader_wait_nonblock();
+  static OutputQueue &get_output_queue(const OutputQueues &output_queues,
+                                       ClientManager::ResponsePartitionerPtr partitioner,
+                                       ClientManager::ClientId client_id, uint64 id, const td_api::Object &object) {
+    // updateAuthorizationState must be received in the same partition as the final empty response
+    if (partitioner == nullptr || output_queues.size() == 1u ||
+        object.get_id() == td_api::updateAuthorizationState::ID) {
+      return *output_queues[0];
     }
-    if (output_queue_ready_cnt_ > 0) {
-      output_queue_ready_cnt_--;
-      return output_queue_->reader_get_unsafe();
+    auto partition_id = partitioner(client_id, id, object);
+    if (partition_id <= 0 || static_cast<size_t>(partition_id) >= output_queues.size()) {
+      return *output_queues[0];
+    }
+    return *output_queues[partition_id];
+  }
+
+  static void lock_receive(Partition &partition, bool from_manager) {
+    auto is_locked = partition.receive_lock.exchange(true);
+    if (is_locked) {
+      if (from_manager) {
+        LOG(FATAL) << "Receive must not be called simultaneously from two different threads, but this has just "
+                      "happened. Call it from a fixed thread, dedicated for updates and response processing.";
+      } else {
+        LOG(FATAL) << "Receive is called after Client destroy, or simultaneously from different threads";
+      }
+    }
+  }
+
+  static void unlock_receive(Partition &partition) {
+    auto is_locked = partition.receive_lock.exchange(false);
+    CHECK(is_locked);
+  }
+
+  static ClientManager::Response receive_unlocked(Partition &partition, double timeout) {
+    if (partition.output_queue_ready_cnt == 0) {
+      partition.output_queue_ready_cnt = partition.output_queue->reader_wait_nonblock();
+    }
+    if (partition.output_queue_ready_cnt > 0) {
+      partition.output_queue_ready_cnt--;
+      return partition.output_queue->reader_get_unsafe();
     }
     if (timeout != 0) {
-      output_queue_->reader_get_event_fd().wait(static_cast<int>(timeout * 1000));
-      return receive_unlocked(0);
+      partition.output_queue->reader_get_event_fd().wait(static_cast<int>(timeout * 1000));
+      return receive_unlocked(partition, 0);
     }
-    return {0, 0, nullptr};
+    return {0, 0, nullptr, string()};
   }
 };
 
+constexpr int32 TdReceiver::MAX_PARTITION_COUNT;
+
 class MultiImpl {
  public:
-  static constexpr int32 ADDITIONAL_THREAD_COUNT = 3;
-
-  explicit MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats) {
-    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(ADDITIONAL_THREAD_COUNT, 0);
+  static constexpr int32 MAX_ADDITIONAL_THREAD_COUNT = 3;
+
+  MultiImpl(std::shared_ptr<NetQueryStats> net_query_stats, int32 additional_thread_count,
+            ConcurrentScheduler::ThreadPlacement thread_placement, int32 first_thread_placement_slot,
+            double event_time_budget, bool use_low_priority_schedulers) {
+    CHECK(0 <= additional_thread_count && additional_thread_count <= MAX_ADDITIONAL_THREAD_COUNT);
+    concurrent_scheduler_ = std::make_shared<ConcurrentScheduler>(additional_thread_count, 0);
+    concurrent_scheduler_->set_event_time_budget(event_time_budget);
+    concurrent_scheduler_->set_thread_placement(thread_placement, first_thread_placement_slot);
+    if (use_low_priority_schedulers && additional_thread_count == MAX_ADDITIONAL_THREAD_COUNT) {
+      // Td runs on the main scheduler and uses the schedulers 2 and 3 for file GC and slow network queries
+      concurrent_scheduler_->set_low_priority_scheduler(2);
+      concurrent_scheduler_->set_low_priority_scheduler(3);
+    }
     concurrent_scheduler_->start();
 
     {
@@ -381,8 +694,10 @@ class MultiImpl {
 
   void create(int32 td_id, unique_ptr<TdCallback> callback) {
     LOG(INFO) << "Initialize client " << td_id;
+    client_count_.fetch_add(1, std::memory_order_relaxed);
     auto guard = concurrent_scheduler_->get_send_guard();
-    send_closure(multi_td_, &MultiTd::create, td_id, std::move(callback));
+    send_closure(multi_td_, &MultiTd::create, td_id,
+                 td::make_unique<CountingCallback>(std::move(callback), event_count_));
   }
 
   static bool is_valid_client_id(int32 client_id) {
@@ -391,16 +706,41 @@ class MultiImpl {
 
   void send(ClientManager::ClientId client_id, ClientManager::RequestId request_id,
             td_api::object_ptr<td_api::Function> &&request) {
+    event_count_->fetch_add(1, std::memory_order_relaxed);
     auto guard = concurrent_scheduler_->get_send_guard();
     send_closure(multi_td_, &MultiTd::send, client_id, request_id, std::move(request));
   }
 
   void close(ClientManager::ClientId client_id) {
     LOG(INFO) << "Close client";
+    client_count_.fetch_sub(1, std::memory_order_relaxed);
     auto guard = concurrent_scheduler_->get_send_guard();
     send_closure(multi_td_, &MultiTd::close, client_id);
   }
 
+  int32 get_client_count() const {
+    return client_count_.load(std::memory_order_relaxed);
+  }
+
+  // returns exponentially smoothed number of requests and responses per second; must not be called concurrently
+  double update_event_rate(double now) {
+    auto event_count = event_count_->load(std::memory_order_relaxed);
+    if (event_rate_update_time_ == 0.0) {
+      event_rate_update_time_ = now;
+      last_event_count_ = event_count;
+      return 0.0;
+    }
+    auto passed_time = now - event_rate_update_time_;
+    if (passed_time >= MIN_EVENT_RATE_UPDATE_PERIOD) {
+      auto current_rate = static_cast<double>(event_count - last_event_count_) / passed_time;
+      auto weight = td::min(passed_time / EVENT_RATE_SMOOTHING_PERIOD, 1.0);
+      event_rate_ += (current_rate - event_rate_) * weight;
+      event_rate_update_time_ = now;
+      last_event_count_ = event_count;
+    }
+    return event_rate_;
+  }
+
   ~MultiImpl() {
     {
       auto guard = concurrent_scheduler_->get_send_guard();
@@ -419,39 +759,116 @@ class MultiImpl {
   std::shared_ptr<ConcurrentScheduler> concurrent_scheduler_;
   thread scheduler_thread_;
   ActorOwn<MultiTd> multi_td_;
+  std::atomic<int32> client_count_{0};
+  std::shared_ptr<std::atomic<uint64>> event_count_ = std::make_shared<std::atomic<uint64>>(0);
+
+  static constexpr double MIN_EVENT_RATE_UPDATE_PERIOD = 1.0;
+  static constexpr double EVENT_RATE_SMOOTHING_PERIOD = 60.0;
+  double event_rate_update_time_ = 0.0;
+  uint64 last_event_count_ = 0;
+  double event_rate_ = 0.0;
 
   static std::atomic<uint32> current_id_;
+
+  class CountingCallback final : public TdCallback {
+   public:
+    CountingCallback(unique_ptr<TdCallback> callback, std::shared_ptr<std::atomic<uint64>> event_count)
+        : callback_(std::move(callback)), event_count_(std::move(event_count)) {
+    }
+    void on_result(uint64 id, td_api::object_ptr<td_api::Object> result) final {
+      event_count_->fetch_add(1, std::memory_order_relaxed);
+      callback_->on_result(id, std::move(result));
+    }
+    void on_error(uint64 id, td_api::object_ptr<td_api::error> error) final {
+      event_count_->fetch_add(1, std::memory_order_relaxed);
+      callback_->on_error(id, std::move(error));
+    }
+
+   private:
+    unique_ptr<TdCallback> callback_;
+    std::shared_ptr<std::atomic<uint64>> event_count_;
+  };
 };
 
-constexpr int32 MultiImpl::ADDITIONAL_THREAD_COUNT;
+constexpr int32 MultiImpl::MAX_ADDITIONAL_THREAD_COUNT;
+constexpr double MultiImpl::MIN_EVENT_RATE_UPDATE_PERIOD;
+constexpr double MultiImpl::EVENT_RATE_SMOOTHING_PERIOD;
 std::atomic<uint32> MultiImpl::current_id_{1};
 
 class MultiImplPool {
  public:
+  static void set_thread_count(int32 scheduler_count, int32 additional_thread_count) {
+    scheduler_count_override_.store(scheduler_count, std::memory_order_relaxed);
+    additional_thread_count_override_.store(additional_thread_count, std::memory_order_relaxed);
+  }
+
   std::shared_ptr<MultiImpl> get() {
     std::unique_lock<std::mutex> lock(mutex_);
     if (impls_.empty()) {
       init_openssl_threads();
 
-      auto max_client_threads = clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4;
-#if TD_OPENBSD
-      max_client_threads = td::min(max_client_threads, 4u);
-#endif
+      additional_thread_count_ = get_additional_thread_count();
+      thread_placement_ = get_thread_placement();
+      event_time_budget_ = get_event_time_budget();
+      use_low_priority_schedulers_ = get_use_low_priority_schedulers();
+      auto max_client_threads = get_scheduler_count(additional_thread_count_);
       impls_.resize(max_client_threads);
-      CHECK(impls_.size() * (1 + MultiImpl::ADDITIONAL_THREAD_COUNT + 1 /* IOCP */) < 128);
+      CHECK(impls_.size() * (1 + additional_thread_count_ + 1 /* IOCP */) < MAX_THREAD_COUNT);
+      LOG(INFO) << "Use " << max_client_threads << " client threads with " << additional_thread_count_
+                << " additional threads each";
 
       net_query_stats_ = std::make_shared<NetQueryStats>();
     }
-    auto &impl = *std::min_element(impls_.begin(), impls_.end(),
-                                   [](auto &a, auto &b) { return a.lock().use_count() < b.lock().use_count(); });
+    // choose the least loaded thread; the load is estimated as the thread's share of the recent event rate plus
+    // its share of the clients, so that clients which haven't been used yet are still distributed evenly
+    auto now = Time::now();
+    size_t best_pos = impls_.size();
+    vector<std::pair<double, double>> event_rates_and_client_counts;
+    double total_event_rate = 0.0;
+    double total_client_count = 0.0;
+    for (size_t i = 0; i < impls_.size(); i++) {
+      auto impl = impls_[i].lock();
+      if (impl == nullptr) {
+        best_pos = i;
+        break;
+      }
+      auto event_rate = impl->update_event_rate(now);
+      auto client_count = static_cast<double>(impl.use_count() - 1);
+      event_rates_and_client_counts.emplace_back(event_rate, client_count);
+      total_event_rate += event_rate;
+      total_client_count += client_count;
+    }
+    if (best_pos == impls_.size()) {
+      double best_load = 0.0;
+      for (size_t i = 0; i < event_rates_and_client_counts.size(); i++) {
+        auto &event_rate_and_client_count = event_rates_and_client_counts[i];
+        auto load = (total_event_rate > 0.0 ? event_rate_and_client_count.first / total_event_rate : 0.0) +
+                    (total_client_count > 0.0 ? event_rate_and_client_count.second / total_client_count : 0.0);
+        if (i == 0 || load < best_load) {
+          best_pos = i;
+          best_load = load;
+        }
+      }
+    }
+    auto &impl = impls_[best_pos];
     auto result = impl.lock();
     if (!result) {
-      result = std::make_shared<MultiImpl>(net_query_stats_);
+      result = std::make_shared<MultiImpl>(net_query_stats_, additional_thread_count_, thread_placement_,
+                                           static_cast<int32>(best_pos) * additional_thread_count_,
+                                           event_time_budget_, use_low_priority_schedulers_);
       impl = result;
     }
     return result;
   }
 
+  vector<int32> get_client_distribution() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return transform(impls_, [](auto &weak_impl) {
+      auto impl = weak_impl.lock();
+      return impl == nullptr ? 0 : impl->get_client_count();
+    });
+  }
+
   void try_clear() {
     std::unique_lock<std::mutex> lock(mutex_);
     if (impls_.empty()) {
@@ -471,11 +888,106 @@ class MultiImplPool {
   }
 
  private:
+  static constexpr int32 MAX_THREAD_COUNT = 128;
+
   std::mutex mutex_;
   std::vector<std::weak_ptr<MultiImpl>> impls_;
   std::shared_ptr<NetQueryStats> net_query_stats_;
+  int32 additional_thread_count_ = MultiImpl::MAX_ADDITIONAL_THREAD_COUNT;
+  ConcurrentScheduler::ThreadPlacement thread_placement_ = ConcurrentScheduler::ThreadPlacement::None;
+  double event_time_budget_ = 0.0;
+  bool use_low_priority_schedulers_ = false;
+
+  static std::atomic<int32> scheduler_count_override_;
+  static std::atomic<int32> additional_thread_count_override_;
+
+  static int32 get_override(const std::atomic<int32> &value, const char *environment_variable) {
+    auto result = value.load(std::memory_order_relaxed);
+    if (result >= 0) {
+      return result;
+    }
+    const char *str = std::getenv(environment_variable);
+    if (str == nullptr) {
+      return -1;
+    }
+    auto r_result = to_integer_safe<int32>(Slice(str));
+    if (r_result.is_error() || r_result.ok() < 0) {
+      LOG(ERROR) << "Ignore invalid value \"" << str << "\" of " << environment_variable;
+      return -1;
+    }
+    return r_result.ok();
+  }
+
+  static int32 get_additional_thread_count() {
+    auto result = get_override(additional_thread_count_override_, "TDLIB_CLIENT_ADDITIONAL_THREAD_COUNT");
+    if (result < 0) {
+      return MultiImpl::MAX_ADDITIONAL_THREAD_COUNT;
+    }
+    return td::min(result, MultiImpl::MAX_ADDITIONAL_THREAD_COUNT);
+  }
+
+  static ConcurrentScheduler::ThreadPlacement get_thread_placement() {
+    const char *str = std::getenv("TDLIB_CLIENT_THREAD_PLACEMENT");
+    if (str == nullptr) {
+      return ConcurrentScheduler::ThreadPlacement::None;
+    }
+    Slice placement(str);
+    if (placement == "compact") {
+      return ConcurrentScheduler::ThreadPlacement::Compact;
+    }
+    if (placement == "spread") {
+      return ConcurrentScheduler::ThreadPlacement::Spread;
+    }
+    if (placement != "none") {
+      LOG(ERROR) << "Ignore invalid value \"" << str << "\" of TDLIB_CLIENT_THREAD_PLACEMENT";
+    }
+    return ConcurrentScheduler::ThreadPlacement::None;
+  }
+
+  // the event time budget is disabled by default, because it changes the order in which actors are run
+  static double get_event_time_budget() {
+    const char *str = std::getenv("TDLIB_CLIENT_EVENT_TIME_BUDGET_MS");
+    if (str == nullptr) {
+      return 0.0;
+    }
+    auto r_budget = to_integer_safe<int32>(Slice(str));
+    if (r_budget.is_error() || r_budget.ok() < 0) {
+      LOG(ERROR) << "Ignore invalid value \"" << str << "\" of TDLIB_CLIENT_EVENT_TIME_BUDGET_MS";
+      return 0.0;
+    }
+    return r_budget.ok() * 1e-3;
+  }
+
+  // lowering the priority of the background threads is disabled by default, because it can starve them on busy CPUs
+  static bool get_use_low_priority_schedulers() {
+    const char *str = std::getenv("TDLIB_CLIENT_LOW_PRIORITY_BACKGROUND_THREADS");
+    if (str == nullptr) {
+      return false;
+    }
+    Slice value(str);
+    if (value != "0" && value != "1") {
+      LOG(ERROR) << "Ignore invalid value \"" << str << "\" of TDLIB_CLIENT_LOW_PRIORITY_BACKGROUND_THREADS";
+      return false;
+    }
+    return value == "1";
+  }
+
+  static int32 get_scheduler_count(int32 additional_thread_count) {
+    auto result = get_override(scheduler_count_override_, "TDLIB_CLIENT_THREAD_COUNT");
+    if (result <= 0) {
+      result = static_cast<int32>(clamp(thread::hardware_concurrency(), 8u, 20u) * 5 / 4);
+#if TD_OPENBSD
+      result = td::min(result, 4);
+#endif
+    }
+    return clamp(result, 1, (MAX_THREAD_COUNT - 1) / (1 + additional_thread_count + 1));
+  }
 };
 
+constexpr int32 MultiImplPool::MAX_THREAD_COUNT;
+std::atomic<int32> MultiImplPool::scheduler_count_override_{-1};
+std::atomic<int32> MultiImplPool::additional_thread_count_override_{-1};
+
 class ClientManager::Impl final {
  public:
   ClientId create_client_id() {
@@ -488,6 +1000,31 @@ class ClientManager::Impl final {
     return client_id;
   }
 
+  void set_response_encoder(ResponseEncoderPtr encoder) {
+    response_encoder_.store(encoder, std::memory_order_relaxed);
+  }
+
+  void set_response_partitioner(int32 partition_count, ResponsePartitionerPtr partitioner) {
+    if (partition_count < 1 || partition_count > TdReceiver::MAX_PARTITION_COUNT) {
+      LOG(ERROR) << "Ignore invalid number of partitions " << partition_count;
+      return;
+    }
+    if (is_partitioned_.exchange(true)) {
+      LOG(ERROR) << "Ignore repeated ClientManager::set_response_partitioner call";
+      return;
+    }
+    receiver_.set_partition_count(partition_count);
+    response_partitioner_.store(partitioner, std::memory_order_relaxed);
+  }
+
+  static void set_thread_count(int32 scheduler_count, int32 additional_thread_count) {
+    MultiImplPool::set_thread_count(scheduler_count, additional_thread_count);
+  }
+
+  vector<int32> get_client_distribution() {
+    return pool_.get_client_distribution();
+  }
+
   void send(ClientId client_id, RequestId request_id, td_api::object_ptr<td_api::Function> &&request) {
     auto lock = impls_mutex_.lock_read().move_as_ok();
     if (!MultiImpl::is_valid_client_id(client_id)) {
@@ -504,7 +1041,10 @@ class ClientManager::Impl final {
       it = impls_.find(client_id);
       if (it != impls_.end() && it->second.impl == nullptr) {
         it->second.impl = pool_.get();
-        it->second.impl->create(client_id, receiver_.create_callback(client_id));
+        it->second.impl->create(client_id,
+                                receiver_.create_callback(client_id,
+                                                          response_encoder_.load(std::memory_order_relaxed),
+                                                          response_partitioner_.load(std::memory_order_relaxed)));
       }
       write_lock.reset();
 
@@ -515,11 +1055,38 @@ class ClientManager::Impl final {
       receiver_.add_response(client_id, request_id, td_api::make_object<td_api::error>(500, "Request aborted"));
       return;
     }
+    if (request_id != 0 && request != nullptr && Td::is_synchronous_request(request.get())) {
+      return receiver_.add_synchronous_request(client_id, request_id, std::move(request),
+                                               response_encoder_.load(std::memory_order_relaxed),
+                                               response_partitioner_.load(std::memory_order_relaxed));
+    }
     it->second.impl->send(client_id, request_id, std::move(request));
   }
 
   Response receive(double timeout) {
     auto response = receiver_.receive(timeout, true);
+    process_response(response);
+    return response;
+  }
+
+  Response receive_partition(int32 partition, double timeout) {
+    if (partition == 0) {
+      return receive(timeout);
+    }
+    // the other partitions never contain updateAuthorizationState and final empty responses
+    return receiver_.receive_partition(partition, timeout, true);
+  }
+
+  vector<Response> receive_batch(size_t max_count, double timeout) {
+    auto responses = receiver_.receive_batch(max_count, timeout, true);
+    for (auto &response : responses) {
+      process_response(response);
+    }
+    td::remove_if(responses, [](const Response &response) { return response.object == nullptr; });
+    return responses;
+  }
+
+  void process_response(Response &response) {
     if (response.request_id == 0 && response.object != nullptr &&
         response.object->get_id() == td_api::updateAuthorizationState::ID &&
         static_cast<const td_api::updateAuthorizationState *>(response.object.get())->authorization_state_->get_id() ==
@@ -546,7 +1113,6 @@ class ClientManager::Impl final {
         pool_.try_clear();
       }
     }
-    return response;
   }
 
   void close_impl(ClientId client_id) {
@@ -589,6 +1155,9 @@ class ClientManager::Impl final {
   };
   FlatHashMap<ClientId, MultiImplInfo> impls_;
   TdReceiver receiver_;
+  std::atomic<ResponseEncoderPtr> response_encoder_{nullptr};
+  std::atomic<ResponsePartitionerPtr> response_partitioner_{nullptr};
+  std::atomic<bool> is_partitioned_{false};
 };
 
 class Client::Impl final {
@@ -606,6 +1175,9 @@ class Client::Impl final {
       LOG(ERROR) << "Drop wrong request " << request.id;
       return;
     }
+    if (Td::is_synchronous_request(request.function.get())) {
+      return receiver_.add_synchronous_request(td_id_, request.id, std::move(request.function));
+    }
 
     multi_impl_->send(td_id_, request.id, std::move(request.function));
   }
@@ -679,6 +1251,34 @@ ClientManager::Response ClientManager::receive(double timeout) {
   return impl_->receive(timeout);
 }
 
+void ClientManager::set_response_encoder(ResponseEncoderPtr encoder) {
+  impl_->set_response_encoder(encoder);
+}
+
+void ClientManager::set_response_partitioner(std::int32_t partition_count, ResponsePartitionerPtr partitioner) {
+  impl_->set_response_partitioner(partition_count, partitioner);
+}
+
+ClientManager::Response ClientManager::receive_partition(std::int32_t partition, double timeout) {
+  return impl_->receive_partition(partition, timeout);
+}
+
+std::vector<ClientManager::Response> ClientManager::receive_batch(std::size_t max_count, double timeout) {
+  return impl_->receive_batch(max_count, timeout);
+}
+
+void ClientManager::set_thread_count(std::int32_t scheduler_count, std::int32_t additional_thread_count) {
+  Impl::set_thread_count(scheduler_count, additional_thread_count);
+}
+
+void ClientManager::set_crypto_thread_count(std::int32_t thread_count) {
+  mtproto::CryptoWorkerPool::set_thread_count(thread_count);
+}
+
+std::vector<std::int32_t> ClientManager::get_client_distribution() const {
+  return impl_->get_client_distribution();
+}
+
 td_api::object_ptr<td_api::Object> ClientManager::execute(td_api::object_ptr<td_api::Function> &&request) {
   return Td::static_request(std::move(request));
 }
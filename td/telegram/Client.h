@@ -11,8 +11,11 @@
 #include "td/telegram/td_api.h"
 #include "td/telegram/td_api.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace td {
 
@@ -79,7 +82,8 @@ class ClientManager final {
   ClientId create_client_id();
 
   /**
-   * Sends request to TDLib. May be called from any thread.
+   * Sends request to TDLib. May be called from any thread. Responses to requests, which can be executed synchronously,
+   * can be received before responses to requests sent earlier.
    * \param[in] client_id TDLib client instance identifier.
    * \param[in] request_id Request identifier. Must be non-zero.
    * \param[in] request Request to TDLib.
@@ -104,6 +108,12 @@ class ClientManager final {
      * TDLib API object representing a response to a TDLib request or an incoming update.
      */
     td_api::object_ptr<td_api::Object> object;
+
+    /**
+     * The object serialized by the function set through ClientManager::set_response_encoder, or an empty string if
+     * the object wasn't serialized.
+     */
+    std::string encoded_object;
   };
 
   /**
@@ -115,6 +125,112 @@ class ClientManager final {
    */
   Response receive(double timeout);
 
+  /**
+   * Receives all already available incoming updates and responses to requests from TDLib, but no more than max_count
+   * of them. Waits for the first response at most timeout seconds. May be called from any thread, but must not be
+   * called simultaneously from two different threads or simultaneously with ClientManager::receive.
+   * \param[in] max_count The maximum number of responses to return.
+   * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+   * \return Received updates and responses to requests in the order they were received. May be empty if the timeout
+   *         expires.
+   */
+  std::vector<Response> receive_batch(std::size_t max_count, double timeout);
+
+  /**
+   * A type of function that can be used to serialize incoming updates and responses to requests in TDLib threads.
+   *
+   * \param object TDLib API object representing a response to a TDLib request or an incoming update.
+   * \return The serialized object, which will be returned by ClientManager::receive in Response::encoded_object.
+   */
+  using ResponseEncoderPtr = std::string (*)(const td_api::Object &object);
+
+  /**
+   * Sets the function that will be called in TDLib threads for all incoming updates and responses to requests, except
+   * updateAuthorizationState, before they are returned by ClientManager::receive. Can be used to move expensive
+   * serialization of the objects out of the thread calling ClientManager::receive. The objects are still returned
+   * in Response::object. Affects only TDLib client instances to which the first request is sent after the call.
+   * By default the function isn't set.
+   *
+   * \param[in] encoder Function that will be called for every incoming update and response to a request.
+   *                    Pass nullptr to remove the function.
+   */
+  void set_response_encoder(ResponseEncoderPtr encoder);
+
+  /**
+   * A type of function that can be used to choose a partition for incoming updates and responses to requests in TDLib
+   * threads.
+   *
+   * \param client_id TDLib client instance identifier, for which the response was received.
+   * \param request_id Request identifier, to which the response corresponds, or 0 for incoming updates.
+   * \param object TDLib API object representing a response to a TDLib request or an incoming update.
+   * \return The partition number, from 0 up to the number of partitions minus one, for example, the identifier of
+   *         the chat, to which the update belongs, modulo the number of partitions. Invalid values are treated as 0.
+   */
+  using ResponsePartitionerPtr = std::int32_t (*)(ClientId client_id, RequestId request_id,
+                                                  const td_api::Object &object);
+
+  /**
+   * Splits incoming updates and responses to requests into partitions, each of which can be received by a separate
+   * thread using ClientManager::receive_partition. The order of responses is preserved only within a partition.
+   * The partition 0 is received by ClientManager::receive and ClientManager::receive_batch. It always contains
+   * updateAuthorizationState and responses to requests sent to invalid or closed TDLib client instances.
+   * Must be called at most once and before the first call to ClientManager::receive_partition. Affects only TDLib
+   * client instances to which the first request is sent after the call. Partitions other than 0 aren't supported
+   * if TDLib is built without thread support.
+   *
+   * \param[in] partition_count The number of partitions, from 1 up to 64.
+   * \param[in] partitioner Function that will be called for every incoming update and response to a request before
+   *                        it is serialized. Pass nullptr to add all responses to the partition 0.
+   */
+  void set_response_partitioner(std::int32_t partition_count, ResponsePartitionerPtr partitioner);
+
+  /**
+   * Receives incoming updates and responses to requests from the specified partition. May be called from any thread,
+   * but must not be called simultaneously from two different threads for the same partition. Receiving from the
+   * partition 0 is equivalent to ClientManager::receive.
+   * \param[in] partition The partition number.
+   * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+   * \return An incoming update or response to a request. The object returned in the response may be a nullptr
+   *         if the timeout expires or the partition doesn't exist.
+   */
+  Response receive_partition(std::int32_t partition, double timeout);
+
+  /**
+   * Changes the number of threads used to run TDLib client instances. Must be called before the first TDLib client
+   * instance is created to have any effect. The same values can be specified through the environment variables
+   * TDLIB_CLIENT_THREAD_COUNT and TDLIB_CLIENT_ADDITIONAL_THREAD_COUNT, which are used if the function wasn't called.
+   * Has no effect if TDLib is built without thread support.
+   *
+   * \param[in] scheduler_count The number of threads running TDLib client instances. Pass 0 to use the default number
+   *                            of threads, which depends on the number of CPU cores.
+   * \param[in] additional_thread_count The number of helper threads used for database, file garbage collection and
+   *                                    slow network requests by each thread running TDLib client instances, from 0
+   *                                    up to 3. Pass -1 to use the default value 3.
+   *
+   * The helper threads can be pinned to CPUs by setting the environment variable TDLIB_CLIENT_THREAD_PLACEMENT to
+   * "compact", to pin each thread to its own CPU, or to "spread", to distribute the threads between NUMA nodes.
+   * The threads for file garbage collection and slow network requests run with a lower OS priority.
+   */
+  static void set_thread_count(std::int32_t scheduler_count, std::int32_t additional_thread_count);
+
+  /**
+   * Changes the number of threads used to encrypt and decrypt network packets of TDLib client instances in parallel.
+   * Can be called at any time; the new value is applied to the packets processed after the call. The initial value can
+   * be specified through the environment variable TDLIB_CRYPTO_THREAD_COUNT.
+   * By default the threads aren't used and the packets are encrypted in the threads that send them.
+   *
+   * \param[in] thread_count The number of additional threads used for encryption and decryption. Pass 0 to disable.
+   */
+  static void set_crypto_thread_count(std::int32_t thread_count);
+
+  /**
+   * Returns the current distribution of TDLib client instances, created by this client manager, between
+   * threads. May be called from any thread.
+   * \return The number of active TDLib client instances for each thread running them. Empty if no instances were
+   *         created yet.
+   */
+  std::vector<std::int32_t> get_client_distribution() const;
+
   /**
    * Synchronously executes a TDLib request.
    * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
@@ -229,7 +345,8 @@ class Client final {
   };
 
   /**
-   * Sends request to TDLib. May be called from any thread.
+   * Sends request to TDLib. May be called from any thread. Responses to requests, which can be executed synchronously,
+   * can be received before responses to requests sent earlier.
    * \param[in] request Request to TDLib.
    */
   void send(Request &&request);
@@ -9,13 +9,15 @@
 #include "td/telegram/td_api.h"
 #include "td/telegram/td_api_json.h"
 
+#include "td/tl/tl_object_store.h"
+
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/SliceBuilder.h"
-#include "td/utils/StackAllocator.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/tl_storers.h"
 
 #include <utility>
 
@@ -28,6 +30,22 @@ static td_api::object_ptr<td_api::Function> get_return_error_function(Slice erro
 
 static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice request) {
   auto request_str = request.str();
+  {
+    // fast path without building of JsonValue
+    td_api::object_ptr<td_api::Function> func;
+    Slice raw_extra;
+    if (td_api::from_json(func, request_str, raw_extra).is_ok()) {
+      string extra;
+      if (!raw_extra.empty()) {
+        auto extra_str = raw_extra.str();
+        extra = json_encode<string>(json_decode(extra_str).move_as_ok());
+      }
+      return std::make_pair(std::move(func), std::move(extra));
+    }
+    // parse the request once more to return the same error and extra as before
+    request_str = request.str();
+  }
+
   auto r_json_value = json_decode(request_str);
   if (r_json_value.is_error()) {
     return {get_return_error_function(PSLICE()
@@ -53,13 +71,37 @@ static std::pair<td_api::object_ptr<td_api::Function>, string> to_request(Slice
   return std::make_pair(std::move(func), std::move(extra));
 }
 
-static string from_response(const td_api::Object &object, const string &extra, int client_id) {
-  auto buf = StackAllocator::alloc(1 << 18);
-  JsonBuilder jb(StringBuilder(buf.as_slice(), true), -1);
-  jb.enter_value() << ToJson(object);
+// is called in TDLib threads if parallel JSON encoding is enabled
+static string encode_response(const td_api::Object &object) {
+  return json_encode<string>(ToJson(object));
+}
+
+// the JSON is built directly in a thread-local buffer, which is reused by subsequent responses
+static TD_THREAD_LOCAL JsonBuilder *current_output;
+static TD_THREAD_LOCAL size_t current_output_size;
+
+static JsonBuilder &get_output() {
+  static constexpr size_t MAX_KEPT_OUTPUT_SIZE = 1 << 22;
+  if (current_output != nullptr && current_output_size > MAX_KEPT_OUTPUT_SIZE) {
+    // don't keep too big buffer forever
+    *current_output = JsonBuilder(StringBuilder(), -1);
+  }
+  init_thread_local<JsonBuilder>(current_output, StringBuilder(), -1);
+  current_output->string_builder().clear();
+  return *current_output;
+}
+
+static void store_response(JsonBuilder &jb, const td_api::Object &object, Slice encoded_object, const string &extra,
+                           int client_id) {
   auto &sb = jb.string_builder();
+  auto old_size = sb.size();
+  if (!encoded_object.empty()) {
+    sb << encoded_object;
+  } else {
+    jb.enter_value() << ToJson(object);
+  }
   auto slice = sb.as_cslice();
-  CHECK(!slice.empty() && slice.back() == '}');
+  CHECK(slice.size() > old_size && slice.back() == '}');
   sb.pop_back();
   if (!extra.empty()) {
     sb << ",\"@extra\":" << extra;
@@ -68,15 +110,57 @@ static string from_response(const td_api::Object &object, const string &extra, i
     sb << ",\"@client_id\":" << client_id;
   }
   sb << '}';
-  return sb.as_cslice().str();
 }
 
-static TD_THREAD_LOCAL string *current_output;
+static const char *finish_output(JsonBuilder &jb, size_t *length) {
+  auto result = jb.string_builder().as_cslice();
+  current_output_size = result.size();
+  if (length != nullptr) {
+    *length = result.size();
+  }
+  return result.c_str();
+}
 
-static const char *store_string(string str) {
-  init_thread_local<string>(current_output);
-  *current_output = std::move(str);
-  return current_output->c_str();
+static const char *from_response(const td_api::Object &object, Slice encoded_object, const string &extra,
+                                 int client_id, size_t *length) {
+  auto &jb = get_output();
+  store_response(jb, object, encoded_object, extra, client_id);
+  return finish_output(jb, length);
+}
+
+// the binary response is stored in a thread-local buffer, which is reused by subsequent responses
+static TD_THREAD_LOCAL string *current_binary_output;
+
+template <class StorerT>
+static void store_binary_response(const td_api::Object &object, const string &extra, int client_id, StorerT &storer) {
+  storer.store_binary(static_cast<int32>(client_id));
+  TlStoreString::store(extra, storer);
+  storer.store_binary(object.get_id());
+  object.store(storer);
+}
+
+static const char *from_binary_response(const td_api::Object &object, const string &extra, int client_id,
+                                        size_t *length) {
+  static constexpr size_t MAX_KEPT_OUTPUT_SIZE = 1 << 22;
+  init_thread_local<string>(current_binary_output);
+  auto &output = *current_binary_output;
+
+  TlStorerCalcLength calc_length;
+  store_binary_response(object, extra, client_id, calc_length);
+  auto size = calc_length.get_length();
+  if (output.capacity() > MAX_KEPT_OUTPUT_SIZE && size <= MAX_KEPT_OUTPUT_SIZE) {
+    // don't keep too big buffer forever
+    string().swap(output);
+  }
+  output.resize(size);
+
+  TlStorerUnsafe storer(MutableSlice(output).ubegin());
+  store_binary_response(object, extra, client_id, storer);
+  CHECK(storer.get_buf() == MutableSlice(output).uend());
+  if (length != nullptr) {
+    *length = size;
+  }
+  return output.c_str();
 }
 
 void ClientJson::send(Slice request) {
@@ -89,7 +173,7 @@ void ClientJson::send(Slice request) {
   client_.send(Client::Request{extra_id, std::move(parsed_request.first)});
 }
 
-const char *ClientJson::receive(double timeout) {
+const char *ClientJson::receive(double timeout, size_t *length) {
   auto response = client_.receive(timeout);
   if (response.object == nullptr) {
     return nullptr;
@@ -104,13 +188,13 @@ const char *ClientJson::receive(double timeout) {
       extra_.erase(it);
     }
   }
-  return store_string(from_response(*response.object, extra, 0));
+  return from_response(*response.object, Slice(), extra, 0, length);
 }
 
 const char *ClientJson::execute(Slice request) {
   auto parsed_request = to_request(request);
-  return store_string(from_response(*Client::execute(Client::Request{0, std::move(parsed_request.first)}).object,
-                                    parsed_request.second, 0));
+  return from_response(*Client::execute(Client::Request{0, std::move(parsed_request.first)}).object, Slice(),
+                       parsed_request.second, 0, nullptr);
 }
 
 static ClientManager *get_manager() {
@@ -135,28 +219,73 @@ void json_send(int client_id, Slice request) {
   get_manager()->send(client_id, request_id, std::move(parsed_request.first));
 }
 
-const char *json_receive(double timeout) {
-  auto response = get_manager()->receive(timeout);
-  if (!response.object) {
-    return nullptr;
-  }
-
+static string extract_extra(ClientManager::RequestId request_id) {
   string extra_str;
-  if (response.request_id != 0) {
+  if (request_id != 0) {
     std::lock_guard<std::mutex> guard(extra_mutex);
-    auto it = extra.find(response.request_id);
+    auto it = extra.find(request_id);
     if (it != extra.end()) {
       extra_str = std::move(it->second);
       extra.erase(it);
     }
   }
-  return store_string(from_response(*response.object, extra_str, response.client_id));
+  return extra_str;
+}
+
+const char *json_receive(double timeout, size_t *length) {
+  auto response = get_manager()->receive(timeout);
+  if (!response.object) {
+    return nullptr;
+  }
+
+  return from_response(*response.object, response.encoded_object, extract_extra(response.request_id),
+                       response.client_id, length);
+}
+
+const char *json_receive_binary(double timeout, size_t *length) {
+  auto response = get_manager()->receive(timeout);
+  if (!response.object) {
+    return nullptr;
+  }
+
+  // the object is serialized even if it has already been encoded to JSON, because the constructor identifier 0 is
+  // reserved for null objects
+  return from_binary_response(*response.object, extract_extra(response.request_id), response.client_id, length);
+}
+
+const char *json_receive_batch(int max_count, double timeout, size_t *length) {
+  if (max_count <= 0) {
+    return nullptr;
+  }
+  auto responses = get_manager()->receive_batch(static_cast<size_t>(max_count), timeout);
+  if (responses.empty()) {
+    return nullptr;
+  }
+
+  auto &jb = get_output();
+  auto &sb = jb.string_builder();
+  sb << '[';
+  bool is_first = true;
+  for (auto &response : responses) {
+    if (!is_first) {
+      sb << ',';
+    }
+    is_first = false;
+    store_response(jb, *response.object, response.encoded_object, extract_extra(response.request_id),
+                   response.client_id);
+  }
+  sb << ']';
+  return finish_output(jb, length);
+}
+
+void json_set_parallel_encoding(bool is_enabled) {
+  get_manager()->set_response_encoder(is_enabled ? encode_response : nullptr);
 }
 
 const char *json_execute(Slice request) {
   auto parsed_request = to_request(request);
-  return store_string(
-      from_response(*ClientManager::execute(std::move(parsed_request.first)), parsed_request.second, 0));
+  return from_response(*ClientManager::execute(std::move(parsed_request.first)), Slice(), parsed_request.second, 0,
+                       nullptr);
 }
 
 }  // namespace td
@@ -12,6 +12,7 @@
 #include "td/utils/Slice.h"
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <string>
@@ -23,7 +24,8 @@ class ClientJson final {
  public:
   void send(Slice request);
 
-  const char *receive(double timeout);
+  // the returned string is valid until the next receive or execute in the same thread
+  const char *receive(double timeout, size_t *length = nullptr);
 
   static const char *execute(Slice request);
 
@@ -38,8 +40,14 @@ int json_create_client_id();
 
 void json_send(int client_id, Slice request);
 
-const char *json_receive(double timeout);
+const char *json_receive(double timeout, size_t *length = nullptr);
+
+const char *json_receive_binary(double timeout, size_t *length);
+
+const char *json_receive_batch(int max_count, double timeout, size_t *length = nullptr);
 
 const char *json_execute(Slice request);
 
+void json_set_parallel_encoding(bool is_enabled);
+
 }  // namespace td
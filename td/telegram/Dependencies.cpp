@@ -8,11 +8,15 @@
 
 #include "td/telegram/ChatManager.h"
 #include "td/telegram/DialogManager.h"
+#include "td/telegram/Global.h"
 #include "td/telegram/StoryManager.h"
 #include "td/telegram/Td.h"
+#include "td/telegram/TdDb.h"
 #include "td/telegram/UserManager.h"
 #include "td/telegram/WebPagesManager.h"
 
+#include "td/db/SqliteKeyValue.h"
+
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 
@@ -91,6 +95,14 @@ void Dependencies::add_message_sender_dependencies(DialogId dialog_id) {
 }
 
 bool Dependencies::resolve_force(Td *td, const char *source, bool ignore_errors) const {
+  // load all missing users and chats from the database in a single read transaction instead of one per object
+  SqliteKeyValue *pmc = nullptr;
+  if (G()->use_chat_info_database() &&
+      user_ids.size() + chat_ids.size() + channel_ids.size() + secret_chat_ids.size() > 1) {
+    pmc = G()->td_db()->get_sqlite_sync_pmc();
+    pmc->begin_read_transaction().ensure();
+  }
+
   bool success = true;
   for (auto user_id : user_ids) {
     if (!td->user_manager_->have_user_force(user_id, source)) {
@@ -128,6 +140,10 @@ bool Dependencies::resolve_force(Td *td, const char *source, bool ignore_errors)
       success = false;
     }
   }
+  if (pmc != nullptr) {
+    pmc->commit_transaction().ensure();
+  }
+
   for (auto dialog_id : dialog_ids) {
     if (!td->dialog_manager_->have_dialog_force(dialog_id, source)) {
       if (!ignore_errors) {
@@ -264,7 +264,7 @@ void DeviceTokenManager::register_device(tl_object_ptr<td_api::DeviceToken> devi
   } else {
     if ((info.state == TokenInfo::State::Reregister || info.state == TokenInfo::State::Sync) && info.token == token &&
         info.other_user_ids == input_user_ids && info.is_app_sandbox == is_app_sandbox && encrypt == info.encrypt) {
-      int64 push_token_id = encrypt ? info.encryption_key_id : G()->get_option_integer("my_id");
+      int64 push_token_id = encrypt ? info.encryption_key_id : G()->get_option_integer(OptionId::MyId);
       return promise.set_value(td_api::make_object<td_api::pushReceiverId>(push_token_id));
     }
 
@@ -316,7 +316,7 @@ vector<std::pair<int64, Slice>> DeviceTokenManager::get_encryption_keys() const
       if (info.encrypt) {
         result.emplace_back(info.encryption_key_id, info.encryption_key);
       } else {
-        result.emplace_back(G()->get_option_integer("my_id"), Slice());
+        result.emplace_back(G()->get_option_integer(OptionId::MyId), Slice());
       }
     }
   }
@@ -432,7 +432,7 @@ void DeviceTokenManager::on_result(NetQueryPtr net_query) {
         if (info.encrypt) {
           push_token_id = info.encryption_key_id;
         } else {
-          push_token_id = G()->get_option_integer("my_id");
+          push_token_id = G()->get_option_integer(OptionId::MyId);
         }
       }
       info.promise.set_value(td_api::make_object<td_api::pushReceiverId>(push_token_id));
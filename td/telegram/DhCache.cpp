@@ -10,10 +10,31 @@
 #include "td/telegram/TdDb.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/misc.h"
 
+#include <mutex>
+
 namespace td {
 
+// results of prime checks shared by all clients in the process; the binlog keeps them between restarts
+static std::mutex checked_primes_mutex;
+static FlatHashMap<string, bool> checked_primes;
+
+static int get_checked_prime(Slice prime_str) {
+  std::lock_guard<std::mutex> guard(checked_primes_mutex);
+  auto it = checked_primes.find(prime_str.str());
+  if (it == checked_primes.end()) {
+    return -1;
+  }
+  return it->second ? 1 : 0;
+}
+
+static void add_checked_prime(Slice prime_str, bool is_good) {
+  std::lock_guard<std::mutex> guard(checked_primes_mutex);
+  checked_primes[prime_str.str()] = is_good;
+}
+
 static string good_prime_key(Slice prime_str) {
   string key("good_prime:");
   key.append(prime_str.data(), prime_str.size());
@@ -33,11 +54,18 @@ int DhCache::is_good_prime(Slice prime_str) const {
     return 1;
   }
 
+  auto result = get_checked_prime(prime_str);
+  if (result != -1) {
+    return result;
+  }
+
   string value = G()->td_db()->get_binlog_pmc()->get(good_prime_key(prime_str));
   if (value == "good") {
+    add_checked_prime(prime_str, true);
     return 1;
   }
   if (value == "bad") {
+    add_checked_prime(prime_str, false);
     return 0;
   }
   CHECK(value.empty());
@@ -45,10 +73,12 @@ int DhCache::is_good_prime(Slice prime_str) const {
 }
 
 void DhCache::add_good_prime(Slice prime_str) const {
+  add_checked_prime(prime_str, true);
   G()->td_db()->get_binlog_pmc()->set(good_prime_key(prime_str), "good");
 }
 
 void DhCache::add_bad_prime(Slice prime_str) const {
+  add_checked_prime(prime_str, false);
   G()->td_db()->get_binlog_pmc()->set(good_prime_key(prime_str), "bad");
 }
 
@@ -279,7 +279,7 @@ void DialogActionManager::on_dialog_action(DialogId dialog_id, MessageId top_thr
 
 void DialogActionManager::send_update_chat_action(DialogId dialog_id, MessageId top_thread_message_id,
                                                   DialogId typing_dialog_id, const DialogAction &action) {
-  if (td_->auth_manager_->is_bot()) {
+  if (td_->auth_manager_->is_bot() || td_->is_update_ignored(td_api::updateChatAction::ID)) {
     return;
   }
 
@@ -825,6 +825,23 @@ bool DialogFilter::need_dialog(const Td *td, const DialogFilterDialogInfo &dialo
   }
 }
 
+int32 DialogFilter::get_dependent_dialog_properties() const {
+  int32 result = 0;
+  if (exclude_muted_) {
+    result |= DialogFilterDialogInfo::IsMuted | DialogFilterDialogInfo::HasUnreadMentions;
+  }
+  if (exclude_read_) {
+    result |= DialogFilterDialogInfo::HasUnreadMessages | DialogFilterDialogInfo::HasUnreadMentions;
+  }
+  if (exclude_archived_) {
+    result |= DialogFilterDialogInfo::Folder;
+  }
+  if (include_contacts_ != include_non_contacts_ || include_contacts_ != include_bots_) {
+    result |= DialogFilterDialogInfo::UserType;
+  }
+  return result;
+}
+
 vector<DialogFilterId> DialogFilter::get_dialog_filter_ids(const vector<unique_ptr<DialogFilter>> &dialog_filters,
                                                            int32 main_dialog_list_position) {
   auto result = transform(dialog_filters, [](const auto &dialog_filter) { return dialog_filter->dialog_filter_id_; });
@@ -102,6 +102,9 @@ class DialogFilter {
 
   bool need_dialog(const Td *td, const DialogFilterDialogInfo &dialog_info) const;
 
+  // returns a mask of DialogFilterDialogInfo::Property, changes of which can change the result of need_dialog
+  int32 get_dependent_dialog_properties() const;
+
   static vector<DialogFilterId> get_dialog_filter_ids(const vector<unique_ptr<DialogFilter>> &dialog_filters,
                                                       int32 main_dialog_list_position);
 
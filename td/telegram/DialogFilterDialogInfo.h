@@ -19,6 +19,16 @@ struct DialogFilterDialogInfo {
   bool has_unread_mentions_ = false;
   bool is_muted_ = false;
   bool has_unread_messages_ = false;
+
+  // dialog properties, which are checked by DialogFilter::need_dialog
+  enum Property : int32 {
+    IsMuted = 1 << 0,
+    HasUnreadMessages = 1 << 1,
+    HasUnreadMentions = 1 << 2,
+    Folder = 1 << 3,
+    UserType = 1 << 4,  // whether the user is a contact or a bot
+    AllProperties = (1 << 5) - 1
+  };
 };
 
 }  // namespace td
@@ -51,6 +51,12 @@ class DialogFilterManager final : public Actor {
 
   bool need_dialog_in_filter(DialogFilterId dialog_filter_id, const DialogFilterDialogInfo &dialog_info) const;
 
+  // returns true if a change of the given dialog properties can change the list of dialogs in the filter
+  bool is_dialog_filter_affected(DialogFilterId dialog_filter_id, int32 changed_dialog_properties) const;
+
+  // returns true if a change of the given dialog properties can change the list of dialogs in some filter
+  bool is_some_dialog_filter_affected(int32 changed_dialog_properties) const;
+
   bool is_dialog_pinned(DialogFilterId dialog_filter_id, DialogId dialog_id) const;
 
   const vector<InputDialogId> &get_pinned_input_dialog_ids(DialogFilterId dialog_filter_id) const;
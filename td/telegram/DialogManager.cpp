@@ -1883,7 +1883,7 @@ bool DialogManager::can_use_premium_custom_emoji_in_dialog(DialogId dialog_id) c
   if (td_->auth_manager_->is_bot()) {
     return true;
   }
-  if (dialog_id == get_my_dialog_id() || td_->option_manager_->get_option_boolean("is_premium")) {
+  if (dialog_id == get_my_dialog_id() || td_->option_manager_->get_option_boolean(OptionId::IsPremium)) {
     return true;
   }
   if (dialog_id.get_type() == DialogType::Channel &&
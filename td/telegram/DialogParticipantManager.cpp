@@ -957,7 +957,7 @@ void DialogParticipantManager::set_dialog_online_member_count(DialogId dialog_id
 
 void DialogParticipantManager::send_update_chat_online_member_count(DialogId dialog_id,
                                                                     int32 online_member_count) const {
-  if (td_->auth_manager_->is_bot()) {
+  if (td_->auth_manager_->is_bot() || td_->is_update_ignored(td_api::updateChatOnlineMemberCount::ID)) {
     return;
   }
 
@@ -1190,7 +1190,7 @@ void DialogParticipantManager::get_dialog_administrators(
 
   auto it = dialog_administrators_.find(dialog_id);
   if (it != dialog_administrators_.end()) {
-    reload_dialog_administrators(dialog_id, it->second, Auto());  // update administrators cache
+    update_dialog_administrators_cache(dialog_id, it->second);
     return promise.set_value(get_chat_administrators_object(it->second));
   }
 
@@ -1213,6 +1213,25 @@ string DialogParticipantManager::get_dialog_administrators_database_key(DialogId
   return PSTRING() << "adm" << (-dialog_id.get());
 }
 
+void DialogParticipantManager::update_dialog_administrators_cache(DialogId dialog_id,
+                                                                  const vector<DialogAdministrator> &administrators) {
+  // changes of administrators are applied to the cache speculatively, so it doesn't need to be reloaded on each access
+  auto now = Time::now();
+  auto reload_time_it = dialog_administrators_next_reload_time_.find(dialog_id);
+  if (reload_time_it != dialog_administrators_next_reload_time_.end() && reload_time_it->second > now) {
+    return;
+  }
+  if (reload_time_it == dialog_administrators_next_reload_time_.end() &&
+      dialog_administrators_next_reload_time_.size() >= MAX_DIALOG_ADMINISTRATORS_RELOAD_TIMES) {
+    table_remove_if(dialog_administrators_next_reload_time_, [now](const auto &it) { return it.second <= now; });
+    if (dialog_administrators_next_reload_time_.size() >= MAX_DIALOG_ADMINISTRATORS_RELOAD_TIMES) {
+      dialog_administrators_next_reload_time_.clear();
+    }
+  }
+  dialog_administrators_next_reload_time_[dialog_id] = now + DIALOG_ADMINISTRATORS_RELOAD_DELAY;
+  reload_dialog_administrators(dialog_id, administrators, Auto());
+}
+
 void DialogParticipantManager::on_load_dialog_administrators_from_database(
     DialogId dialog_id, string value, Promise<td_api::object_ptr<td_api::chatAdministrators>> &&promise) {
   TRY_STATUS_PROMISE(promise, G()->close_status());
@@ -1256,7 +1275,7 @@ void DialogParticipantManager::on_load_administrator_users_finished(
   }
 
   auto it = dialog_administrators_.emplace(dialog_id, std::move(administrators)).first;
-  reload_dialog_administrators(dialog_id, it->second, Auto());  // update administrators cache
+  update_dialog_administrators_cache(dialog_id, it->second);
   promise.set_value(get_chat_administrators_object(it->second));
 }
 
@@ -1288,6 +1307,7 @@ void DialogParticipantManager::on_update_dialog_administrators(DialogId dialog_i
     }
   } else {
     dialog_administrators_.erase(dialog_id);
+    dialog_administrators_next_reload_time_.erase(dialog_id);
     if (G()->use_chat_info_database()) {
       G()->td_db()->get_sqlite_pmc()->erase(get_dialog_administrators_database_key(dialog_id), Auto());
     }
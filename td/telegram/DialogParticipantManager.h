@@ -161,6 +161,9 @@ class DialogParticipantManager final : public Actor {
 
   static constexpr int32 MAX_GET_CHANNEL_PARTICIPANTS = 200;  // server side limit
 
+  static constexpr int32 DIALOG_ADMINISTRATORS_RELOAD_DELAY = 60;  // minimum delay between background reloads
+  static constexpr size_t MAX_DIALOG_ADMINISTRATORS_RELOAD_TIMES = 1000;  // some reasonable value
+
   void tear_down() final;
 
   static void on_update_dialog_online_member_count_timeout_callback(void *dialog_participant_manager_ptr,
@@ -180,6 +183,8 @@ class DialogParticipantManager final : public Actor {
 
   static string get_dialog_administrators_database_key(DialogId dialog_id);
 
+  void update_dialog_administrators_cache(DialogId dialog_id, const vector<DialogAdministrator> &administrators);
+
   void on_load_dialog_administrators_from_database(DialogId dialog_id, string value,
                                                    Promise<td_api::object_ptr<td_api::chatAdministrators>> &&promise);
 
@@ -292,6 +297,7 @@ class DialogParticipantManager final : public Actor {
   FlatHashMap<UserId, unique_ptr<UserOnlineMemberDialogs>, UserIdHash> user_online_member_dialogs_;
 
   FlatHashMap<DialogId, vector<DialogAdministrator>, DialogIdHash> dialog_administrators_;
+  FlatHashMap<DialogId, double, DialogIdHash> dialog_administrators_next_reload_time_;
 
   // bot-administrators only
   struct ChannelParticipantInfo {
@@ -13,6 +13,7 @@
 #include "td/telegram/TdDb.h"
 
 #include "td/actor/MultiPromise.h"
+#include "td/actor/MultiTimeout.h"
 #include "td/actor/PromiseFuture.h"
 
 #include "td/utils/algorithm.h"
@@ -28,6 +29,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <limits>
 #include <set>
 
@@ -72,6 +74,8 @@ struct FileDownloadInDatabase {
 class DownloadManagerImpl final : public DownloadManager {
  public:
   explicit DownloadManagerImpl(unique_ptr<Callback> callback) : callback_(std::move(callback)) {
+    save_timeout_.set_callback(on_save_timeout_callback);
+    save_timeout_.set_callback_data(static_cast<void *>(this));
   }
 
   void start_up() final {
@@ -227,34 +231,41 @@ class DownloadManagerImpl final : public DownloadManager {
       }
       offset_int64 = r_offset.move_as_ok();
     }
-    auto download_ids = hints_.search(query, 10000, true).second;
+    vector<int64> download_ids;
     FileCounters counters;
-    td::remove_if(download_ids, [&](int64 download_id) {
-      auto r_file_info_ptr = get_file_info_ptr(download_id);
-      CHECK(r_file_info_ptr.is_ok());
-      auto &file_info = *r_file_info_ptr.ok();
-      if (is_completed(file_info)) {
-        counters.completed_count++;
-        if (only_active) {
-          return true;
-        }
-      } else {
-        counters.active_count++;
-        if (file_info.is_paused) {
-          counters.paused_count++;
+    if (query.empty()) {
+      // all downloads match the query, so walk ordered identifiers instead of sorting all of them
+      counters = file_counters_;
+      download_ids = get_last_download_ids(only_active, only_completed, offset_int64, limit);
+    } else {
+      download_ids = hints_.search(query, 10000, true).second;
+      td::remove_if(download_ids, [&](int64 download_id) {
+        auto r_file_info_ptr = get_file_info_ptr(download_id);
+        CHECK(r_file_info_ptr.is_ok());
+        auto &file_info = *r_file_info_ptr.ok();
+        if (is_completed(file_info)) {
+          counters.completed_count++;
+          if (only_active) {
+            return true;
+          }
+        } else {
+          counters.active_count++;
+          if (file_info.is_paused) {
+            counters.paused_count++;
+          }
+          if (only_completed) {
+            return true;
+          }
         }
-        if (only_completed) {
+        if (download_id >= offset_int64) {
           return true;
         }
+        return false;
+      });
+      std::sort(download_ids.begin(), download_ids.end(), std::greater<>());
+      if (static_cast<int32>(download_ids.size()) > limit) {
+        download_ids.resize(limit);
       }
-      if (download_id >= offset_int64) {
-        return true;
-      }
-      return false;
-    });
-    std::sort(download_ids.begin(), download_ids.end(), std::greater<>());
-    if (static_cast<int32>(download_ids.size()) > limit) {
-      download_ids.resize(limit);
     }
     auto file_downloads = transform(download_ids, [&](int64 download_id) {
       on_file_viewed(download_id);
@@ -344,6 +355,7 @@ class DownloadManagerImpl final : public DownloadManager {
   FlatHashMap<FileId, int64, FileIdHash> by_file_id_;
   FlatHashMap<FileId, int64, FileIdHash> by_internal_file_id_;
   FlatHashMap<int64, unique_ptr<FileInfo>> files_;
+  std::set<int64> active_download_ids_;
   std::set<int64> completed_download_ids_;
   FlatHashSet<int64> unviewed_completed_download_ids_;
   Hints hints_;
@@ -359,6 +371,12 @@ class DownloadManagerImpl final : public DownloadManager {
   uint64 last_link_token_{0};
   MultiPromiseActor load_search_text_multipromise_{"LoadFileSearchTextMultiPromiseActor"};
 
+  static constexpr double SAVE_DELAY = 1.0;  // the maximum delay before changes are saved to the database
+
+  FlatHashSet<int64> download_ids_to_save_;
+  bool need_save_counters_{false};
+  MultiTimeout save_timeout_{"DownloadManagerSaveTimeout"};
+
   int64 next_download_id() {
     return ++max_download_id_;
   }
@@ -389,6 +407,49 @@ class DownloadManagerImpl final : public DownloadManager {
       return;
     }
 
+    // repeated changes of the same download are coalesced into one database write
+    download_ids_to_save_.insert(file_info.download_id);
+    schedule_save();
+  }
+
+  void schedule_save() {
+    if (!save_timeout_.has_timeout(0)) {
+      save_timeout_.set_timeout_in(0, SAVE_DELAY);
+    }
+  }
+
+  static void on_save_timeout_callback(void *download_manager_ptr, int64 key) {
+    if (G()->close_flag()) {
+      return;
+    }
+
+    auto download_manager = static_cast<DownloadManagerImpl *>(download_manager_ptr);
+    send_closure_later(download_manager->actor_id(download_manager), &DownloadManagerImpl::save_changes);
+  }
+
+  void save_changes() {
+    save_timeout_.cancel_timeout(0);
+    if (!download_ids_to_save_.empty()) {
+      LOG(INFO) << "Save " << download_ids_to_save_.size() << " changed downloads to database";
+      for (auto download_id : download_ids_to_save_) {
+        auto it = files_.find(download_id);
+        if (it != files_.end()) {
+          save_to_database(*it->second);
+        }
+      }
+      reset_to_empty(download_ids_to_save_);
+    }
+    if (need_save_counters_) {
+      need_save_counters_ = false;
+      if (is_finished(sent_counters_)) {
+        G()->td_db()->get_binlog_pmc()->erase("dlds_counter");
+      } else {
+        G()->td_db()->get_binlog_pmc()->set("dlds_counter", log_event_store(sent_counters_).as_slice().str());
+      }
+    }
+  }
+
+  static void save_to_database(const FileInfo &file_info) {
     LOG(INFO) << "Saving to download database file " << file_info.file_id << '/' << file_info.internal_file_id
               << " with is_paused = " << file_info.is_paused;
     FileDownloadInDatabase to_save;
@@ -402,11 +463,12 @@ class DownloadManagerImpl final : public DownloadManager {
     G()->td_db()->get_binlog_pmc()->set(pmc_key(file_info), log_event_store(to_save).as_slice().str());
   }
 
-  static void remove_from_database(const FileInfo &file_info) {
+  void remove_from_database(const FileInfo &file_info) {
     if (!is_database_enabled()) {
       return;
     }
 
+    download_ids_to_save_.erase(file_info.download_id);
     G()->td_db()->get_binlog_pmc()->erase(pmc_key(file_info));
   }
 
@@ -554,6 +616,7 @@ class DownloadManagerImpl final : public DownloadManager {
       bool is_inserted = completed_download_ids_.insert(it->second->download_id).second;
       CHECK(is_inserted == was_completed);
     } else {
+      active_download_ids_.insert(it->second->download_id);
       if (!it->second->is_paused) {
         callback_->start_file(it->second->internal_file_id, it->second->priority,
                               actor_shared(this, it->second->link_token));
@@ -579,6 +642,7 @@ class DownloadManagerImpl final : public DownloadManager {
     by_internal_file_id_.erase(file_info.internal_file_id);
     by_file_id_.erase(file_id);
     hints_.remove(download_id);
+    active_download_ids_.erase(download_id);
     completed_download_ids_.erase(download_id);
 
     remove_from_database(file_info);
@@ -624,6 +688,9 @@ class DownloadManagerImpl final : public DownloadManager {
   }
 
   void tear_down() final {
+    if (is_database_enabled()) {
+      save_changes();
+    }
     callback_.reset();
   }
 
@@ -658,20 +725,48 @@ class DownloadManagerImpl final : public DownloadManager {
     CHECK(counters_.total_size >= 0);
     CHECK(counters_.total_count >= 0);
     CHECK(counters_.downloaded_size >= 0);
-    if ((counters_.downloaded_size == counters_.total_size && counters_.total_size != 0) || counters_ == Counters()) {
+    if (is_finished(counters_)) {
       if (counters_.total_size != 0) {
         constexpr double EMPTY_UPDATE_DELAY = 60.0;
         set_timeout_in(EMPTY_UPDATE_DELAY);
       } else {
         cancel_timeout();
       }
-      G()->td_db()->get_binlog_pmc()->erase("dlds_counter");
     } else {
       cancel_timeout();
-      G()->td_db()->get_binlog_pmc()->set("dlds_counter", log_event_store(counters_).as_slice().str());
     }
     sent_counters_ = counters_;
     callback_->update_counters(counters_);
+
+    // download progress changes the counters very often, so they are saved to the database with a delay
+    need_save_counters_ = true;
+    schedule_save();
+  }
+
+  static bool is_finished(const Counters &counters) {
+    return (counters.downloaded_size == counters.total_size && counters.total_size != 0) || counters == Counters();
+  }
+
+  vector<int64> get_last_download_ids(bool only_active, bool only_completed, int64 offset, int32 limit) const {
+    static const std::set<int64> empty_download_ids;
+    const auto &active_download_ids = only_completed ? empty_download_ids : active_download_ids_;
+    const auto &completed_download_ids = only_active ? empty_download_ids : completed_download_ids_;
+    auto active_it = std::make_reverse_iterator(active_download_ids.lower_bound(offset));
+    auto completed_it = std::make_reverse_iterator(completed_download_ids.lower_bound(offset));
+    vector<int64> download_ids;
+    while (static_cast<int32>(download_ids.size()) < limit) {
+      bool has_active = active_it != active_download_ids.rend();
+      bool has_completed = completed_it != completed_download_ids.rend();
+      if (!has_active && !has_completed) {
+        break;
+      }
+      if (has_active && (!has_completed || *active_it > *completed_it)) {
+        download_ids.push_back(*active_it++);
+      } else {
+        download_ids.push_back(*completed_it++);
+      }
+    }
+    return download_ids;
   }
 
   Result<const FileInfo *> get_file_info_ptr(FileId file_id, FileSourceId file_source_id = {}) {
@@ -733,6 +828,7 @@ class DownloadManagerImpl final : public DownloadManager {
       file_info.completed_at = G()->unix_time();
       file_info.need_save_to_database = true;
 
+      active_download_ids_.erase(file_info.download_id);
       bool is_inserted = completed_download_ids_.insert(file_info.download_id).second;
       CHECK(is_inserted);
       if (file_info.is_counted) {
@@ -33,6 +33,9 @@ void DownloadManagerCallback::update_file_added(FileId file_id, FileSourceId fil
 
 void DownloadManagerCallback::update_file_changed(FileId file_id, int32 complete_date, bool is_paused,
                                                   DownloadManager::FileCounters counters) {
+  if (td_->is_update_ignored(td_api::updateFileDownload::ID)) {
+    return;
+  }
   send_closure(td_->actor_id(td_), &Td::send_update,
                td_api::make_object<td_api::updateFileDownload>(file_id.get(), complete_date, is_paused,
                                                                counters.get_downloaded_file_counts_object()));
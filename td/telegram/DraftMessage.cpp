@@ -333,6 +333,10 @@ void store_draft_message_content(const DraftMessageContent *content, LogEventSto
   store(content, storer);
 }
 
+void store_draft_message_content(const DraftMessageContent *content, LogEventStorerGrowable &storer) {
+  store(content, storer);
+}
+
 void store_draft_message_content(const DraftMessageContent *content, LogEventStorerUnsafe &storer) {
   store(content, storer);
 }
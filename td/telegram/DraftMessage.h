@@ -86,6 +86,8 @@ class DraftMessage {
 
 void store_draft_message_content(const DraftMessageContent *content, LogEventStorerCalcLength &storer);
 
+void store_draft_message_content(const DraftMessageContent *content, LogEventStorerGrowable &storer);
+
 void store_draft_message_content(const DraftMessageContent *content, LogEventStorerUnsafe &storer);
 
 void parse_draft_message_content(unique_ptr<DraftMessageContent> &content, LogEventParser &parser);
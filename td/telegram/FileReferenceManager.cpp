@@ -321,8 +321,7 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
   CHECK(index < file_sources_.size());
   file_sources_[index].visit(overloaded(
       [&](const FileSourceMessage &source) {
-        send_closure_later(G()->messages_manager(), &MessagesManager::get_message_from_server, source.message_full_id,
-                           std::move(promise), "FileSourceMessage", nullptr);
+        repair_message_file_reference(source.message_full_id, std::move(promise));
       },
       [&](const FileSourceUserPhoto &source) {
         send_closure_later(G()->user_manager(), &UserManager::reload_user_profile_photo, source.user_id,
@@ -399,6 +398,53 @@ void FileReferenceManager::send_query(Destination dest, FileSourceId file_source
       }));
 }
 
+void FileReferenceManager::repair_message_file_reference(MessageFullId message_full_id, Promise<Unit> &&promise) {
+  // file references of many files are often repaired at once, so reload their messages in batches
+  pending_message_repairs_[message_full_id].push_back(std::move(promise));
+  if (pending_message_repairs_.size() >= MAX_MESSAGE_REPAIR_BATCH_SIZE) {
+    return reload_pending_repair_messages();
+  }
+  if (!has_timeout()) {
+    set_timeout_in(MESSAGE_REPAIR_BATCH_DELAY);
+  }
+}
+
+void FileReferenceManager::timeout_expired() {
+  reload_pending_repair_messages();
+}
+
+void FileReferenceManager::reload_pending_repair_messages() {
+  cancel_timeout();
+  auto pending_message_repairs = std::move(pending_message_repairs_);
+  pending_message_repairs_.clear();
+
+  FlatHashMap<DialogId, vector<MessageFullId>, DialogIdHash> dialog_message_full_ids;
+  for (auto &it : pending_message_repairs) {
+    dialog_message_full_ids[it.first.get_dialog_id()].push_back(it.first);
+  }
+  for (auto &it : dialog_message_full_ids) {
+    VLOG(file_references) << "Reload " << it.second.size() << " messages from " << it.first
+                          << " to repair file references";
+    for (size_t i = 0; i < it.second.size(); i += MAX_MESSAGE_REPAIR_BATCH_SIZE) {
+      auto end = min(i + MAX_MESSAGE_REPAIR_BATCH_SIZE, it.second.size());
+      vector<MessageFullId> message_full_ids(it.second.begin() + i, it.second.begin() + end);
+      vector<Promise<Unit>> promises;
+      for (auto message_full_id : message_full_ids) {
+        append(promises, std::move(pending_message_repairs[message_full_id]));
+      }
+      auto promise = PromiseCreator::lambda([promises = std::move(promises)](Result<Unit> result) mutable {
+        if (result.is_error()) {
+          fail_promises(promises, result.move_as_error());
+        } else {
+          set_promises(promises);
+        }
+      });
+      send_closure_later(G()->messages_manager(), &MessagesManager::get_messages_from_server,
+                         std::move(message_full_ids), std::move(promise), "FileSourceMessage", nullptr);
+    }
+  }
+}
+
 FileReferenceManager::Destination FileReferenceManager::on_query_result(Destination dest, FileSourceId file_source_id,
                                                                         Status status, int32 sub) {
   if (G()->close_flag()) {
@@ -22,6 +22,7 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
@@ -95,6 +96,9 @@ class FileReferenceManager final : public Actor {
   FileSourceId parse_file_source(Td *td, ParserT &parser);
 
  private:
+  static constexpr size_t MAX_MESSAGE_REPAIR_BATCH_SIZE = 100;  // the maximum number of messages reloaded at once
+  static constexpr double MESSAGE_REPAIR_BATCH_DELAY = 0.05;    // the time to wait for other messages to reload
+
   struct Destination {
     NodeId node_id;
     int64 generation{0};
@@ -193,6 +197,9 @@ class FileReferenceManager final : public Actor {
 
   WaitFreeHashMap<NodeId, unique_ptr<Node>, FileIdHash> nodes_;
 
+  // messages, which must be reloaded to repair file references, and promises waiting for them
+  FlatHashMap<MessageFullId, vector<Promise<Unit>>, MessageFullIdHash> pending_message_repairs_;
+
   ActorShared<> parent_;
 
   Node &add_node(NodeId node_id);
@@ -201,6 +208,12 @@ class FileReferenceManager final : public Actor {
   void send_query(Destination dest, FileSourceId file_source_id);
   Destination on_query_result(Destination dest, FileSourceId file_source_id, Status status, int32 sub = 0);
 
+  void repair_message_file_reference(MessageFullId message_full_id, Promise<Unit> &&promise);
+
+  void reload_pending_repair_messages();
+
+  void timeout_expired() final;
+
   template <class T>
   FileSourceId add_file_source_id(T &source, Slice source_str);
 
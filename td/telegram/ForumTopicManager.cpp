@@ -36,6 +36,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/tl_helpers.h"
 
 namespace td {
@@ -813,10 +814,54 @@ void ForumTopicManager::get_forum_topics(DialogId dialog_id, string query, int32
   if (limit <= 0) {
     return promise.set_error(Status::Error(400, "Invalid limit specified"));
   }
-  td_->create_handler<GetForumTopicsQuery>(std::move(promise))
+
+  // identical requests, for example, from several chat list views, are sent to the server only once
+  string query_key = PSTRING() << dialog_id.get() << ' ' << offset_date << ' ' << offset_message_id.get() << ' '
+                               << offset_top_thread_message_id.get() << ' ' << limit << ' ' << query;
+  auto &queries = get_forum_topics_queries_[query_key];
+  queries.push_back(std::move(promise));
+  if (queries.size() != 1) {
+    LOG(INFO) << "Wait for an identical request for forum topics in " << dialog_id;
+    return;
+  }
+
+  auto query_promise =
+      PromiseCreator::lambda([actor_id = actor_id(this), dialog_id, query_key](
+                                 Result<td_api::object_ptr<td_api::forumTopics>> &&result) mutable {
+        send_closure(actor_id, &ForumTopicManager::on_get_forum_topics_result, dialog_id, query_key, std::move(result));
+      });
+  td_->create_handler<GetForumTopicsQuery>(std::move(query_promise))
       ->send(channel_id, query, offset_date, offset_message_id, offset_top_thread_message_id, limit);
 }
 
+void ForumTopicManager::on_get_forum_topics_result(DialogId dialog_id, const string &query_key,
+                                                   Result<td_api::object_ptr<td_api::forumTopics>> &&result) {
+  auto it = get_forum_topics_queries_.find(query_key);
+  CHECK(it != get_forum_topics_queries_.end());
+  auto promises = std::move(it->second);
+  CHECK(!promises.empty());
+  get_forum_topics_queries_.erase(it);
+
+  if (result.is_error()) {
+    return fail_promises(promises, result.move_as_error());
+  }
+
+  // all waiters receive topics built from the same just-updated local topic state
+  auto forum_topics = result.move_as_ok();
+  for (auto &promise : promises) {
+    vector<td_api::object_ptr<td_api::forumTopic>> topics;
+    for (auto &topic : forum_topics->topics_) {
+      auto topic_object = get_forum_topic_object(dialog_id, MessageId(topic->info_->message_thread_id_));
+      if (topic_object != nullptr) {
+        topics.push_back(std::move(topic_object));
+      }
+    }
+    promise.set_value(td_api::make_object<td_api::forumTopics>(
+        forum_topics->total_count_, std::move(topics), forum_topics->next_offset_date_,
+        forum_topics->next_offset_message_id_, forum_topics->next_offset_message_thread_id_));
+  }
+}
+
 void ForumTopicManager::on_get_forum_topics(ChannelId channel_id, bool order_by_creation_date, MessagesInfo &&info,
                                             vector<telegram_api::object_ptr<telegram_api::ForumTopic>> &&topics,
                                             Promise<td_api::object_ptr<td_api::forumTopics>> &&promise) {
@@ -21,6 +21,7 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Status.h"
 #include "td/utils/WaitFreeHashMap.h"
@@ -177,6 +178,9 @@ class ForumTopicManager final : public Actor {
 
   void on_delete_forum_topic(DialogId dialog_id, MessageId top_thread_message_id, Promise<Unit> &&promise);
 
+  void on_get_forum_topics_result(DialogId dialog_id, const string &query_key,
+                                  Result<td_api::object_ptr<td_api::forumTopics>> &&result);
+
   td_api::object_ptr<td_api::updateForumTopicInfo> get_update_forum_topic_info(DialogId dialog_id,
                                                                                const ForumTopicInfo *topic_info) const;
 
@@ -190,6 +194,8 @@ class ForumTopicManager final : public Actor {
   ActorShared<> parent_;
 
   WaitFreeHashMap<DialogId, unique_ptr<DialogTopics>, DialogIdHash> dialog_topics_;
+
+  FlatHashMap<string, vector<Promise<td_api::object_ptr<td_api::forumTopics>>>> get_forum_topics_queries_;
 };
 
 }  // namespace td
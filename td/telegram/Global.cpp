@@ -15,6 +15,8 @@
 #include "td/telegram/TdDb.h"
 #include "td/telegram/UpdatesManager.h"
 
+#include "td/actor/CpuTaskPool.h"
+
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
@@ -31,6 +33,12 @@ Global::Global() {
   database_scheduler_id_ = min(current_scheduler_id + 1, max_scheduler_id);
   gc_scheduler_id_ = min(current_scheduler_id + 2, max_scheduler_id);
   slow_net_scheduler_id_ = min(current_scheduler_id + 3, max_scheduler_id);
+
+  vector<int32> cpu_task_scheduler_ids{gc_scheduler_id_};
+  if (slow_net_scheduler_id_ != gc_scheduler_id_) {
+    cpu_task_scheduler_ids.push_back(slow_net_scheduler_id_);
+  }
+  cpu_task_pool_ = td::make_unique<CpuTaskPool>(std::move(cpu_task_scheduler_ids));
 }
 
 Global::~Global() = default;
@@ -308,6 +316,14 @@ string Global::get_option_string(Slice name, string default_value) const {
   return get_option_manager()->get_option_string(name, std::move(default_value));
 }
 
+bool Global::get_option_boolean(OptionId option_id, bool default_value) const {
+  return get_option_manager()->get_option_boolean(option_id, default_value);
+}
+
+int64 Global::get_option_integer(OptionId option_id, int64 default_value) const {
+  return get_option_manager()->get_option_integer(option_id, default_value);
+}
+
 int64 Global::get_location_key(double latitude, double longitude) {
   const double PI = 3.14159265358979323846;
   latitude *= PI / 180;
@@ -10,6 +10,7 @@
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQueryCreator.h"
+#include "td/telegram/OptionId.h"
 
 #include "td/net/NetStats.h"
 
@@ -43,6 +44,7 @@ class CallManager;
 class ChatManager;
 class ConfigManager;
 class ConnectionCreator;
+class CpuTaskPool;
 class DialogActionManager;
 class DialogFilterManager;
 class DialogInviteLinkManager;
@@ -156,6 +158,10 @@ class Global final : public ActorContext {
 
   string get_option_string(Slice name, string default_value = "") const;
 
+  bool get_option_boolean(OptionId option_id, bool default_value = false) const;
+
+  int64 get_option_integer(OptionId option_id, int64 default_value = 0) const;
+
   bool is_server_time_reliable() const {
     return server_time_difference_was_updated_.load(std::memory_order_relaxed);
   }
@@ -549,6 +555,11 @@ class Global final : public ActorContext {
     return slow_net_scheduler_id_;
   }
 
+  // runs pure computations, like parsing of huge server responses, outside of the main scheduler
+  CpuTaskPool &get_cpu_task_pool() {
+    return *cpu_task_pool_;
+  }
+
   DcId get_webfile_dc_id() const;
 
   std::shared_ptr<DhConfig> get_dh_config() {
@@ -691,6 +702,8 @@ class Global final : public ActorContext {
   int32 gc_scheduler_id_ = 0;
   int32 slow_net_scheduler_id_ = 0;
 
+  unique_ptr<CpuTaskPool> cpu_task_pool_;
+
   std::atomic<bool> store_all_files_in_files_directory_{false};
 
   std::atomic<double> server_time_difference_{0.0};
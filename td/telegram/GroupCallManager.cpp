@@ -953,6 +953,8 @@ struct GroupCallManager::GroupCall {
 
 struct GroupCallManager::GroupCallParticipants {
   vector<GroupCallParticipant> participants;
+  FlatHashMap<DialogId, size_t, DialogIdHash> participant_positions;  // dialog_id -> position in participants
+  FlatHashMap<int32, DialogId> audio_source_dialog_ids;  // audio_source or presentation_audio_source -> dialog_id
   string next_offset;
   GroupCallParticipantOrder min_order = GroupCallParticipantOrder::max();
   bool joined_date_asc = false;
@@ -966,6 +968,74 @@ struct GroupCallManager::GroupCallParticipants {
   };
   std::map<int32, PendingUpdates> pending_version_updates_;
   std::map<int32, PendingUpdates> pending_mute_updates_;
+
+  GroupCallParticipant *find_participant(DialogId dialog_id) {
+    auto it = participant_positions.find(dialog_id);
+    if (it == participant_positions.end()) {
+      return nullptr;
+    }
+    return &participants[it->second];
+  }
+
+  GroupCallParticipant *find_participant_by_audio_source(int32 audio_source) {
+    auto it = audio_source_dialog_ids.find(audio_source);
+    if (it == audio_source_dialog_ids.end()) {
+      return nullptr;
+    }
+    return find_participant(it->second);
+  }
+
+  void add_participant(GroupCallParticipant &&participant) {
+    CHECK(participant.dialog_id.is_valid());
+    CHECK(participant_positions.emplace(participant.dialog_id, participants.size()).second);
+    add_audio_sources(participant);
+    participants.push_back(std::move(participant));
+  }
+
+  void replace_participant(GroupCallParticipant &old_participant, GroupCallParticipant &&participant) {
+    remove_audio_sources(old_participant);
+    if (old_participant.dialog_id != participant.dialog_id) {
+      auto position = participant_positions[old_participant.dialog_id];
+      participant_positions.erase(old_participant.dialog_id);
+      CHECK(participant_positions.emplace(participant.dialog_id, position).second);
+    }
+    add_audio_sources(participant);
+    old_participant = std::move(participant);
+  }
+
+  // the last participant is moved to the place of the removed one
+  void remove_participant(DialogId dialog_id) {
+    auto it = participant_positions.find(dialog_id);
+    CHECK(it != participant_positions.end());
+    auto position = it->second;
+    participant_positions.erase(it);
+    remove_audio_sources(participants[position]);
+    if (position + 1 != participants.size()) {
+      participants[position] = std::move(participants.back());
+      participant_positions[participants[position].dialog_id] = position;
+    }
+    participants.pop_back();
+  }
+
+  void add_audio_sources(const GroupCallParticipant &participant) {
+    for (auto audio_source : {participant.audio_source, participant.presentation_audio_source}) {
+      if (audio_source != 0) {
+        audio_source_dialog_ids[audio_source] = participant.dialog_id;
+      }
+    }
+  }
+
+  void remove_audio_sources(const GroupCallParticipant &participant) {
+    for (auto audio_source : {participant.audio_source, participant.presentation_audio_source}) {
+      if (audio_source == 0) {
+        continue;
+      }
+      auto it = audio_source_dialog_ids.find(audio_source);
+      if (it != audio_source_dialog_ids.end() && it->second == participant.dialog_id) {
+        audio_source_dialog_ids.erase(it);
+      }
+    }
+  }
 };
 
 struct GroupCallManager::GroupCallRecentSpeakers {
@@ -1709,11 +1779,7 @@ GroupCallParticipant *GroupCallManager::get_group_call_participant(GroupCallPart
       }
     }
   } else {
-    for (auto &group_call_participant : group_call_participants->participants) {
-      if (group_call_participant.dialog_id == dialog_id) {
-        return &group_call_participant;
-      }
-    }
+    return group_call_participants->find_participant(dialog_id);
   }
   return nullptr;
 }
@@ -2127,12 +2193,10 @@ void GroupCallManager::process_group_call_participants(
   }
   if (is_sync) {
     auto *group_call_participants = add_group_call_participants(input_group_call_id);
-    auto &group_participants = group_call_participants->participants;
-    for (auto participant_it = group_participants.begin(); participant_it != group_participants.end();) {
-      auto &participant = *participant_it;
+    vector<DialogId> removed_participant_dialog_ids;
+    for (auto &participant : group_call_participants->participants) {
       if (old_participant_dialog_ids.count(participant.dialog_id) == 0) {
         // successfully synced old user
-        ++participant_it;
         continue;
       }
 
@@ -2141,7 +2205,6 @@ void GroupCallManager::process_group_call_participants(
           participant.order = min_order;
           send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participants self");
         }
-        ++participant_it;
         continue;
       }
 
@@ -2153,7 +2216,10 @@ void GroupCallManager::process_group_call_participants(
       }
       on_remove_group_call_participant(input_group_call_id, participant.dialog_id);
       group_call_participants->local_unmuted_video_count -= participant.get_has_video();
-      participant_it = group_participants.erase(participant_it);
+      removed_participant_dialog_ids.push_back(participant.dialog_id);
+    }
+    for (auto participant_dialog_id : removed_participant_dialog_ids) {
+      group_call_participants->remove_participant(participant_dialog_id);
     }
     if (group_call_participants->min_order < min_order) {
       // if previously known more users, adjust min_order
@@ -2255,54 +2321,61 @@ std::pair<int32, int32> GroupCallManager::process_group_call_participant(InputGr
   bool can_self_unmute = get_group_call_can_self_unmute(input_group_call_id);
   bool can_manage = can_manage_group_call(input_group_call_id);
   auto *participants = add_group_call_participants(input_group_call_id);
-  for (size_t i = 0; i < participants->participants.size(); i++) {
-    auto &old_participant = participants->participants[i];
-    if (old_participant.dialog_id == participant.dialog_id || (old_participant.is_self && participant.is_self)) {
-      if (participant.joined_date == 0) {
-        LOG(INFO) << "Remove " << old_participant;
-        if (old_participant.order.is_valid()) {
-          send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant remove");
-        }
-        on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
-        remove_recent_group_call_speaker(input_group_call_id, old_participant.dialog_id);
-        int32 unmuted_video_diff = -old_participant.get_has_video();
-        participants->local_unmuted_video_count += unmuted_video_diff;
-        participants->participants.erase(participants->participants.begin() + i);
-        return {-1, unmuted_video_diff};
+  auto *old_participant_ptr = participants->find_participant(participant.dialog_id);
+  if (old_participant_ptr == nullptr && participant.is_self) {
+    for (auto &group_call_participant : participants->participants) {
+      if (group_call_participant.is_self) {
+        old_participant_ptr = &group_call_participant;
+        break;
       }
-
-      if (old_participant.version > participant.version) {
-        LOG(INFO) << "Ignore outdated update of " << old_participant.dialog_id;
-        return {0, 0};
+    }
+  }
+  if (old_participant_ptr != nullptr) {
+    auto &old_participant = *old_participant_ptr;
+    if (participant.joined_date == 0) {
+      LOG(INFO) << "Remove " << old_participant;
+      if (old_participant.order.is_valid()) {
+        send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant remove");
       }
+      on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
+      remove_recent_group_call_speaker(input_group_call_id, old_participant.dialog_id);
+      int32 unmuted_video_diff = -old_participant.get_has_video();
+      participants->local_unmuted_video_count += unmuted_video_diff;
+      participants->remove_participant(old_participant.dialog_id);
+      return {-1, unmuted_video_diff};
+    }
 
-      if (old_participant.dialog_id != participant.dialog_id) {
-        on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
-        on_add_group_call_participant(input_group_call_id, participant.dialog_id);
-      }
+    if (old_participant.version > participant.version) {
+      LOG(INFO) << "Ignore outdated update of " << old_participant.dialog_id;
+      return {0, 0};
+    }
 
-      participant.update_from(old_participant);
+    if (old_participant.dialog_id != participant.dialog_id) {
+      on_remove_group_call_participant(input_group_call_id, old_participant.dialog_id);
+      on_add_group_call_participant(input_group_call_id, participant.dialog_id);
+    }
 
-      participant.is_just_joined = false;
-      participant.order = get_real_participant_order(can_self_unmute, participant, participants);
-      update_group_call_participant_can_be_muted(can_manage, participants, participant);
+    participant.update_from(old_participant);
 
-      LOG(INFO) << "Edit " << old_participant << " to " << participant;
-      if (old_participant != participant && (old_participant.order.is_valid() || participant.order.is_valid())) {
-        send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant edit");
-        if (old_participant.dialog_id != participant.dialog_id) {
-          // delete old self-participant; shouldn't affect correct apps
-          old_participant.order = GroupCallParticipantOrder();
-          send_update_group_call_participant(input_group_call_id, old_participant,
-                                             "process_group_call_participant edit self");
-        }
+    participant.is_just_joined = false;
+    participant.order = get_real_participant_order(can_self_unmute, participant, participants);
+    update_group_call_participant_can_be_muted(can_manage, participants, participant);
+
+    LOG(INFO) << "Edit " << old_participant << " to " << participant;
+    if (old_participant != participant && (old_participant.order.is_valid() || participant.order.is_valid())) {
+      send_update_group_call_participant(input_group_call_id, participant, "process_group_call_participant edit");
+      if (old_participant.dialog_id != participant.dialog_id) {
+        // delete old self-participant; shouldn't affect correct apps
+        old_participant.order = GroupCallParticipantOrder();
+        send_update_group_call_participant(input_group_call_id, old_participant,
+                                           "process_group_call_participant edit self");
       }
-      on_participant_speaking_in_group_call(input_group_call_id, participant);
-      int32 unmuted_video_diff = participant.get_has_video() - old_participant.get_has_video();
-      participants->local_unmuted_video_count += unmuted_video_diff;
-      old_participant = std::move(participant);
-      return {0, unmuted_video_diff};
     }
+    on_participant_speaking_in_group_call(input_group_call_id, participant);
+    int32 unmuted_video_diff = participant.get_has_video() - old_participant.get_has_video();
+    participants->local_unmuted_video_count += unmuted_video_diff;
+    participants->replace_participant(old_participant, std::move(participant));
+    return {0, unmuted_video_diff};
   }
 
   if (participant.joined_date == 0) {
@@ -2322,7 +2395,7 @@ std::pair<int32, int32> GroupCallManager::process_group_call_participant(InputGr
   participant.is_just_joined = false;
   participants->local_unmuted_video_count += participant.get_has_video();
   update_group_call_participant_can_be_muted(can_manage, participants, participant);
-  participants->participants.push_back(std::move(participant));
+  participants->add_participant(std::move(participant));
   if (participants->participants.back().order.is_valid()) {
     send_update_group_call_participant(input_group_call_id, participants->participants.back(),
                                        "process_group_call_participant add");
@@ -4633,30 +4706,31 @@ DialogId GroupCallManager::set_group_call_participant_is_speaking_by_source(Inpu
     return DialogId();
   }
 
-  for (auto &participant : participants_it->second->participants) {
-    if (participant.audio_source == audio_source || participant.presentation_audio_source == audio_source) {
-      if (is_speaking && participant.get_is_muted_by_admin()) {
-        // don't allow to show as speaking muted by admin participants
-        return DialogId();
-      }
-      if (participant.is_speaking != is_speaking) {
-        participant.is_speaking = is_speaking;
-        if (is_speaking) {
-          participant.local_active_date = max(participant.local_active_date, date);
-        }
-        bool can_self_unmute = get_group_call_can_self_unmute(input_group_call_id);
-        auto old_order = participant.order;
-        participant.order = get_real_participant_order(can_self_unmute, participant, participants_it->second.get());
-        if (participant.order.is_valid() || old_order.is_valid()) {
-          send_update_group_call_participant(input_group_call_id, participant,
-                                             "set_group_call_participant_is_speaking_by_source");
-        }
-      }
+  auto *participant_ptr = participants_it->second->find_participant_by_audio_source(audio_source);
+  if (participant_ptr == nullptr) {
+    return DialogId();
+  }
 
-      return participant.dialog_id;
+  auto &participant = *participant_ptr;
+  if (is_speaking && participant.get_is_muted_by_admin()) {
+    // don't allow to show as speaking muted by admin participants
+    return DialogId();
+  }
+  if (participant.is_speaking != is_speaking) {
+    participant.is_speaking = is_speaking;
+    if (is_speaking) {
+      participant.local_active_date = max(participant.local_active_date, date);
+    }
+    bool can_self_unmute = get_group_call_can_self_unmute(input_group_call_id);
+    auto old_order = participant.order;
+    participant.order = get_real_participant_order(can_self_unmute, participant, participants_it->second.get());
+    if (participant.order.is_valid() || old_order.is_valid()) {
+      send_update_group_call_participant(input_group_call_id, participant,
+                                         "set_group_call_participant_is_speaking_by_source");
     }
   }
-  return DialogId();
+
+  return participant.dialog_id;
 }
 
 bool GroupCallManager::set_group_call_participant_count(GroupCall *group_call, int32 count, const char *source,
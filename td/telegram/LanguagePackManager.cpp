@@ -48,10 +48,42 @@ struct LanguagePackManager::PluralizedString {
       , many_value_(std::move(many_value))
       , other_value_(std::move(other_value)) {
   }
+
+  friend bool operator==(const PluralizedString &lhs, const PluralizedString &rhs) {
+    return lhs.zero_value_ == rhs.zero_value_ && lhs.one_value_ == rhs.one_value_ && lhs.two_value_ == rhs.two_value_ &&
+           lhs.few_value_ == rhs.few_value_ && lhs.many_value_ == rhs.many_value_ &&
+           lhs.other_value_ == rhs.other_value_;
+  }
+};
+
+struct LanguagePackManager::LanguageStrings {
+  FlatHashMap<string, string> ordinary_strings_;
+  FlatHashMap<string, unique_ptr<PluralizedString>> pluralized_strings_;
+
+  friend bool operator==(const LanguageStrings &lhs, const LanguageStrings &rhs) {
+    if (lhs.ordinary_strings_.size() != rhs.ordinary_strings_.size() ||
+        lhs.pluralized_strings_.size() != rhs.pluralized_strings_.size()) {
+      return false;
+    }
+    for (auto &str : lhs.ordinary_strings_) {
+      auto it = rhs.ordinary_strings_.find(str.first);
+      if (it == rhs.ordinary_strings_.end() || it->second != str.second) {
+        return false;
+      }
+    }
+    for (auto &str : lhs.pluralized_strings_) {
+      auto it = rhs.pluralized_strings_.find(str.first);
+      if (it == rhs.pluralized_strings_.end() || !(*it->second == *str.second)) {
+        return false;
+      }
+    }
+    return true;
+  }
 };
 
 struct LanguagePackManager::Language {
   std::mutex mutex_;
+  string shared_strings_name_;  // language pack and language code; empty if strings can't be shared
   std::atomic<int32> version_{-1};
   std::atomic<int32> key_count_{0};
   std::string base_language_code_;
@@ -59,8 +91,8 @@ struct LanguagePackManager::Language {
   bool was_loaded_full_ = false;
   bool has_get_difference_query_ = false;
   vector<Promise<Unit>> get_difference_queries_;
-  FlatHashMap<string, string> ordinary_strings_;
-  FlatHashMap<string, unique_ptr<PluralizedString>> pluralized_strings_;
+  std::shared_ptr<LanguageStrings> strings_ = std::make_shared<LanguageStrings>();
+  string shared_strings_key_;  // non-empty if strings_ are shared and must not be changed
   FlatHashSet<string> deleted_strings_;
   SqliteKeyValue kv_;  // usages must be guarded by database_->mutex_
 };
@@ -657,6 +689,9 @@ LanguagePackManager::Language *LanguagePackManager::add_language(LanguageDatabas
   auto code_it = pack->languages_.find(language_code);
   if (code_it == pack->languages_.end()) {
     auto language = make_unique<Language>();
+    if (!is_custom_language_code(language_code)) {
+      language->shared_strings_name_ = PSTRING() << language_pack << '\x00' << language_code;
+    }
     if (!database->database_.empty()) {
       language->kv_
           .init_with_connection(database->database_.clone(), get_database_table_name(language_pack, language_code))
@@ -673,9 +708,56 @@ LanguagePackManager::Language *LanguagePackManager::add_language(LanguageDatabas
   return code_it->second.get();
 }
 
+void LanguagePackManager::share_language_strings_unsafe(Language *language) {
+  if (!language->is_full_ || language->shared_strings_name_.empty()) {
+    return;
+  }
+
+  auto key = PSTRING() << language->shared_strings_name_ << '\x00' << language->version_.load();
+  std::lock_guard<std::mutex> lock(shared_language_strings_mutex_);
+  if (!language->shared_strings_key_.empty()) {
+    return;
+  }
+  auto &weak_strings = shared_language_strings_[key];
+  auto strings = weak_strings.lock();
+  if (strings == nullptr) {
+    weak_strings = language->strings_;
+  } else {
+    if (!(*strings == *language->strings_)) {
+      LOG(INFO) << "Can't share strings of a language of version " << language->version_.load();
+      return;
+    }
+    LOG(INFO) << "Share strings of a language of version " << language->version_.load();
+    language->strings_ = std::move(strings);
+  }
+  language->shared_strings_key_ = std::move(key);
+}
+
+LanguagePackManager::LanguageStrings *LanguagePackManager::get_mutable_language_strings_unsafe(Language *language) {
+  if (language->shared_strings_key_.empty()) {
+    return language->strings_.get();
+  }
+
+  std::lock_guard<std::mutex> lock(shared_language_strings_mutex_);
+  if (language->strings_.use_count() == 1) {
+    shared_language_strings_.erase(language->shared_strings_key_);
+  } else {
+    auto strings = std::make_shared<LanguageStrings>();
+    for (auto &str : language->strings_->ordinary_strings_) {
+      strings->ordinary_strings_.emplace(str.first, str.second);
+    }
+    for (auto &str : language->strings_->pluralized_strings_) {
+      strings->pluralized_strings_.emplace(str.first, td::make_unique<PluralizedString>(*str.second));
+    }
+    language->strings_ = std::move(strings);
+  }
+  language->shared_strings_key_.clear();
+  return language->strings_.get();
+}
+
 bool LanguagePackManager::language_has_string_unsafe(const Language *language, const string &key) {
-  return language->ordinary_strings_.count(key) != 0 || language->pluralized_strings_.count(key) != 0 ||
-         language->deleted_strings_.count(key) != 0;
+  return language->strings_->ordinary_strings_.count(key) != 0 ||
+         language->strings_->pluralized_strings_.count(key) != 0 || language->deleted_strings_.count(key) != 0;
 }
 
 bool LanguagePackManager::language_has_strings(Language *language, const vector<string> &keys) {
@@ -701,14 +783,14 @@ bool LanguagePackManager::language_has_strings(Language *language, const vector<
 void LanguagePackManager::load_language_string_unsafe(Language *language, const string &key, const string &value) {
   CHECK(is_valid_key(key));
   if (value[0] == '1') {
-    language->ordinary_strings_.emplace(key, value.substr(1));
+    get_mutable_language_strings_unsafe(language)->ordinary_strings_.emplace(key, value.substr(1));
     return;
   }
 
   if (value[0] == '2') {
     auto all = full_split(Slice(value).substr(1), '\x00');
     if (all.size() == 6) {
-      language->pluralized_strings_.emplace(
+      get_mutable_language_strings_unsafe(language)->pluralized_strings_.emplace(
           key, td::make_unique<PluralizedString>(all[0].str(), all[1].str(), all[2].str(), all[3].str(), all[4].str(),
                                                  all[5].str()));
       return;
@@ -763,6 +845,7 @@ bool LanguagePackManager::load_language_strings(LanguageDatabase *database, Lang
 
     language->is_full_ = true;
     language->deleted_strings_.clear();
+    share_language_strings_unsafe(language);
     return true;
   }
 
@@ -818,12 +901,12 @@ td_api::object_ptr<td_api::languagePackString> LanguagePackManager::get_language
 td_api::object_ptr<td_api::LanguagePackStringValue> LanguagePackManager::get_language_pack_string_value_object(
     const Language *language, const string &key) {
   CHECK(language != nullptr);
-  auto ordinary_it = language->ordinary_strings_.find(key);
-  if (ordinary_it != language->ordinary_strings_.end()) {
+  auto ordinary_it = language->strings_->ordinary_strings_.find(key);
+  if (ordinary_it != language->strings_->ordinary_strings_.end()) {
     return get_language_pack_string_value_object(ordinary_it->second);
   }
-  auto pluralized_it = language->pluralized_strings_.find(key);
-  if (pluralized_it != language->pluralized_strings_.end()) {
+  auto pluralized_it = language->strings_->pluralized_strings_.find(key);
+  if (pluralized_it != language->strings_->pluralized_strings_.end()) {
     return get_language_pack_string_value_object(*pluralized_it->second);
   }
   LOG_IF(ERROR, !language->is_full_ && language->deleted_strings_.count(key) == 0) << "Have no string for key " << key;
@@ -842,10 +925,10 @@ td_api::object_ptr<td_api::languagePackStrings> LanguagePackManager::get_languag
   std::lock_guard<std::mutex> lock(language->mutex_);
   vector<td_api::object_ptr<td_api::languagePackString>> strings;
   if (keys.empty()) {
-    for (auto &str : language->ordinary_strings_) {
+    for (auto &str : language->strings_->ordinary_strings_) {
       strings.push_back(get_language_pack_string_object(str.first, str.second));
     }
-    for (auto &str : language->pluralized_strings_) {
+    for (auto &str : language->strings_->pluralized_strings_) {
       strings.push_back(get_language_pack_string_object(str.first, *str.second));
     }
   } else {
@@ -1366,6 +1449,7 @@ void LanguagePackManager::on_get_language_pack_strings(
     if (language->version_ < version || !keys.empty()) {
       auto is_first = language->version_ == -1;
       vector<td_api::object_ptr<td_api::languagePackString>> strings;
+      auto *language_strings = get_mutable_language_strings_unsafe(language);
       if (language->version_ < version) {
         LOG(INFO) << "Set language pack " << language_code << " version to " << version;
         language->version_ = version;
@@ -1382,14 +1466,14 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
-            auto it = language->ordinary_strings_.find(str->key_);
-            if (it == language->ordinary_strings_.end()) {
+            auto it = language_strings->ordinary_strings_.find(str->key_);
+            if (it == language_strings->ordinary_strings_.end()) {
               key_count_delta++;
-              it = language->ordinary_strings_.emplace(str->key_, std::move(str->value_)).first;
+              it = language_strings->ordinary_strings_.emplace(str->key_, std::move(str->value_)).first;
             } else {
               it->second = std::move(str->value_);
             }
-            key_count_delta -= static_cast<int32>(language->pluralized_strings_.erase(str->key_));
+            key_count_delta -= static_cast<int32>(language_strings->pluralized_strings_.erase(str->key_));
             language->deleted_strings_.erase(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(it->first, it->second));
@@ -1406,14 +1490,14 @@ void LanguagePackManager::on_get_language_pack_strings(
             auto value = td::make_unique<PluralizedString>(std::move(str->zero_value_), std::move(str->one_value_),
                                                            std::move(str->two_value_), std::move(str->few_value_),
                                                            std::move(str->many_value_), std::move(str->other_value_));
-            auto it = language->pluralized_strings_.find(str->key_);
-            if (it == language->pluralized_strings_.end()) {
+            auto it = language_strings->pluralized_strings_.find(str->key_);
+            if (it == language_strings->pluralized_strings_.end()) {
               key_count_delta++;
-              it = language->pluralized_strings_.emplace(str->key_, std::move(value)).first;
+              it = language_strings->pluralized_strings_.emplace(str->key_, std::move(value)).first;
             } else {
               it->second = std::move(value);
             }
-            key_count_delta -= static_cast<int32>(language->ordinary_strings_.erase(str->key_));
+            key_count_delta -= static_cast<int32>(language_strings->ordinary_strings_.erase(str->key_));
             language->deleted_strings_.erase(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(it->first, *it->second));
@@ -1431,8 +1515,8 @@ void LanguagePackManager::on_get_language_pack_strings(
               LOG(ERROR) << "Receive invalid key \"" << str->key_ << '"';
               break;
             }
-            key_count_delta -= static_cast<int32>(language->ordinary_strings_.erase(str->key_));
-            key_count_delta -= static_cast<int32>(language->pluralized_strings_.erase(str->key_));
+            key_count_delta -= static_cast<int32>(language_strings->ordinary_strings_.erase(str->key_));
+            key_count_delta -= static_cast<int32>(language_strings->pluralized_strings_.erase(str->key_));
             language->deleted_strings_.insert(str->key_);
             if (is_diff) {
               strings.push_back(get_language_pack_string_object(str->key_));
@@ -1468,6 +1552,7 @@ void LanguagePackManager::on_get_language_pack_strings(
         language->is_full_ = true;
         language->deleted_strings_.clear();
       }
+      share_language_strings_unsafe(language);
       new_is_full = language->is_full_;
 
       if (is_diff || (new_is_full && is_first)) {
@@ -1853,8 +1938,9 @@ Status LanguagePackManager::do_delete_language(const string &language_code) {
   language->version_ = -1;
   language->key_count_ = load_database_language_key_count(&language->kv_);
   language->is_full_ = false;
-  language->ordinary_strings_.clear();
-  language->pluralized_strings_.clear();
+  auto *language_strings = get_mutable_language_strings_unsafe(language);
+  language_strings->ordinary_strings_.clear();
+  language_strings->pluralized_strings_.clear();
   language->deleted_strings_.clear();
 
   if (!pack->pack_kv_.empty()) {
@@ -1883,6 +1969,9 @@ void LanguagePackManager::hangup() {
 
 int32 LanguagePackManager::manager_count_ = 0;
 std::mutex LanguagePackManager::language_database_mutex_;
+std::mutex LanguagePackManager::shared_language_strings_mutex_;
+std::unordered_map<string, std::weak_ptr<LanguagePackManager::LanguageStrings>, Hash<string>>
+    LanguagePackManager::shared_language_strings_;
 std::unordered_map<string, unique_ptr<LanguagePackManager::LanguageDatabase>, Hash<string>>
     LanguagePackManager::language_databases_;
 
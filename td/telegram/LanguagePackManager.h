@@ -20,6 +20,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
@@ -85,6 +86,7 @@ class LanguagePackManager final : public NetQueryCallback {
 
  private:
   struct PluralizedString;
+  struct LanguageStrings;
   struct Language;
   struct LanguageInfo;
   struct LanguagePack;
@@ -108,6 +110,10 @@ class LanguagePackManager final : public NetQueryCallback {
   static std::mutex language_database_mutex_;
   static std::unordered_map<string, unique_ptr<LanguageDatabase>, Hash<string>> language_databases_;
 
+  // full languages with the same version from different databases share one immutable copy of their strings
+  static std::mutex shared_language_strings_mutex_;
+  static std::unordered_map<string, std::weak_ptr<LanguageStrings>, Hash<string>> shared_language_strings_;
+
   static LanguageDatabase *add_language_database(string path);
 
   static Language *get_language(LanguageDatabase *database, const string &language_pack, const string &language_code);
@@ -115,6 +121,9 @@ class LanguagePackManager final : public NetQueryCallback {
 
   static Language *add_language(LanguageDatabase *database, const string &language_pack, const string &language_code);
 
+  static void share_language_strings_unsafe(Language *language);
+  static LanguageStrings *get_mutable_language_strings_unsafe(Language *language);
+
   static bool language_has_string_unsafe(const Language *language, const string &key);
   static bool language_has_strings(Language *language, const vector<string> &keys);
 
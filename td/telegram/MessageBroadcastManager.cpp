@@ -0,0 +1,978 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/MessageBroadcastManager.h"
+
+#include "td/telegram/AccessRights.h"
+#include "td/telegram/AuthManager.h"
+#include "td/telegram/Dependencies.h"
+#include "td/telegram/DialogManager.h"
+#include "td/telegram/files/FileManager.h"
+#include "td/telegram/files/FileType.h"
+#include "td/telegram/Global.h"
+#include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/MessageContent.h"
+#include "td/telegram/MessageBroadcastProgress.h"
+#include "td/telegram/MessageContentType.h"
+#include "td/telegram/MessageCopyOptions.h"
+#include "td/telegram/MessageEntity.h"
+#include "td/telegram/MessageSelfDestructType.h"
+#include "td/telegram/MessagesManager.h"
+#include "td/telegram/net/NetQueryCreator.h"
+#include "td/telegram/OptionManager.h"
+#include "td/telegram/Td.h"
+#include "td/telegram/TdDb.h"
+#include "td/telegram/UpdatesManager.h"
+#include "td/telegram/UserManager.h"
+
+#include "td/db/binlog/BinlogEvent.h"
+#include "td/db/binlog/BinlogHelper.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/buffer.h"
+#include "td/utils/FlatHashSet.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+#include "td/utils/tl_helpers.h"
+
+namespace td {
+
+struct MessageBroadcastManager::Broadcast {
+  int64 broadcast_id_ = 0;
+  vector<DialogId> dialog_ids_;
+  unique_ptr<MessageContent> content_;
+  MessageSelfDestructType ttl_;
+  string send_emoji_;
+  int64 random_id_ = 0;  // random_id of the message sent to the first chat
+  bool disable_notification_ = false;
+  bool protect_content_ = false;
+  bool invert_media_ = false;
+  bool disable_web_page_preview_ = false;
+
+  MessageBroadcastProgress progress_;
+
+  bool is_content_ready_ = false;
+  bool is_canceled_ = false;
+  bool is_finished_ = false;
+
+  uint64 log_event_id_ = 0;
+  uint64 progress_log_event_id_ = 0;
+
+  int64 get_random_id(int32 dialog_pos) const {
+    return static_cast<int64>(static_cast<uint64>(random_id_) + static_cast<uint64>(dialog_pos));
+  }
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    bool has_send_emoji = !send_emoji_.empty();
+    BEGIN_STORE_FLAGS();
+    STORE_FLAG(disable_notification_);
+    STORE_FLAG(protect_content_);
+    STORE_FLAG(invert_media_);
+    STORE_FLAG(disable_web_page_preview_);
+    STORE_FLAG(has_send_emoji);
+    END_STORE_FLAGS();
+    td::store(broadcast_id_, storer);
+    td::store(dialog_ids_, storer);
+    store_message_content(content_.get(), storer);
+    td::store(ttl_, storer);
+    if (has_send_emoji) {
+      td::store(send_emoji_, storer);
+    }
+    td::store(random_id_, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    bool has_send_emoji;
+    BEGIN_PARSE_FLAGS();
+    PARSE_FLAG(disable_notification_);
+    PARSE_FLAG(protect_content_);
+    PARSE_FLAG(invert_media_);
+    PARSE_FLAG(disable_web_page_preview_);
+    PARSE_FLAG(has_send_emoji);
+    END_PARSE_FLAGS();
+    td::parse(broadcast_id_, parser);
+    td::parse(dialog_ids_, parser);
+    parse_message_content(content_, parser);
+    td::parse(ttl_, parser);
+    if (has_send_emoji) {
+      td::parse(send_emoji_, parser);
+    }
+    td::parse(random_id_, parser);
+  }
+};
+
+class MessageBroadcastManager::MessageBroadcastLogEvent {
+ public:
+  const Broadcast *broadcast_in_;
+  unique_ptr<Broadcast> broadcast_out_;
+
+  MessageBroadcastLogEvent() : broadcast_in_(nullptr) {
+  }
+
+  explicit MessageBroadcastLogEvent(const Broadcast *broadcast) : broadcast_in_(broadcast) {
+  }
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(*broadcast_in_, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(broadcast_out_, parser);
+  }
+};
+
+class MessageBroadcastManager::MessageBroadcastProgressLogEvent {
+ public:
+  int64 broadcast_id_ = 0;
+  const MessageBroadcastProgress *progress_in_ = nullptr;
+  MessageBroadcastProgress progress_out_;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(broadcast_id_, storer);
+    td::store(*progress_in_, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(broadcast_id_, parser);
+    td::parse(progress_out_, parser);
+  }
+};
+
+static void process_sent_broadcast_message(Td *td, DialogId dialog_id,
+                                           telegram_api::object_ptr<telegram_api::Updates> &&updates_ptr) {
+  if (updates_ptr->get_id() != telegram_api::updateShortSentMessage::ID) {
+    return td->updates_manager_->on_get_updates(std::move(updates_ptr), Promise<Unit>());
+  }
+
+  // there is no local message to update, so only pts needs to be applied
+  auto sent_message = telegram_api::move_object_as<telegram_api::updateShortSentMessage>(updates_ptr);
+  if (dialog_id.get_type() == DialogType::Channel) {
+    td->messages_manager_->add_pending_channel_update(dialog_id, make_tl_object<dummyUpdate>(), sent_message->pts_,
+                                                      sent_message->pts_count_, Promise<Unit>(),
+                                                      "process_sent_broadcast_message");
+  } else {
+    td->updates_manager_->add_pending_pts_update(make_tl_object<dummyUpdate>(), sent_message->pts_,
+                                                 sent_message->pts_count_, Time::now(), Promise<Unit>(),
+                                                 "process_sent_broadcast_message");
+  }
+}
+
+class MessageBroadcastManager::SendBroadcastMessageQuery final : public Td::ResultHandler {
+  int64 broadcast_id_;
+  int32 dialog_pos_;
+  DialogId dialog_id_;
+
+ public:
+  SendBroadcastMessageQuery(int64 broadcast_id, int32 dialog_pos, DialogId dialog_id)
+      : broadcast_id_(broadcast_id), dialog_pos_(dialog_pos), dialog_id_(dialog_id) {
+  }
+
+  void send(const Broadcast *broadcast, telegram_api::object_ptr<telegram_api::InputPeer> &&input_peer) {
+    int32 flags = 0;
+    if (broadcast->disable_web_page_preview_) {
+      flags |= telegram_api::messages_sendMessage::NO_WEBPAGE_MASK;
+    }
+    if (broadcast->disable_notification_) {
+      flags |= telegram_api::messages_sendMessage::SILENT_MASK;
+    }
+    if (broadcast->protect_content_) {
+      flags |= telegram_api::messages_sendMessage::NOFORWARDS_MASK;
+    }
+    if (broadcast->invert_media_) {
+      flags |= telegram_api::messages_sendMessage::INVERT_MEDIA_MASK;
+    }
+
+    const FormattedText *message_text = get_message_content_text(broadcast->content_.get());
+    CHECK(message_text != nullptr);
+    auto entities = get_input_message_entities(td_->user_manager_.get(), message_text, "SendBroadcastMessageQuery");
+    if (!entities.empty()) {
+      flags |= telegram_api::messages_sendMessage::ENTITIES_MASK;
+    }
+
+    // messages are sent in the same sequence as ordinary messages to the chat and share their rate limit
+    auto query = G()->net_query_creator().create(
+        telegram_api::messages_sendMessage(flags, false /*ignored*/, false /*ignored*/, false /*ignored*/,
+                                           false /*ignored*/, false /*ignored*/, false /*ignored*/, false /*ignored*/,
+                                           std::move(input_peer), nullptr, message_text->text,
+                                           broadcast->get_random_id(dialog_pos_), nullptr, std::move(entities), 0,
+                                           nullptr, nullptr),
+        {{dialog_id_, MessageContentType::Text}});
+    query->total_timeout_limit_ = QUERY_TOTAL_TIMEOUT_LIMIT;
+    send_query(std::move(query));
+  }
+
+  void on_result(BufferSlice packet) final {
+    auto result_ptr = fetch_result<telegram_api::messages_sendMessage>(packet);
+    if (result_ptr.is_error()) {
+      return on_error(result_ptr.move_as_error());
+    }
+
+    auto ptr = result_ptr.move_as_ok();
+    LOG(DEBUG) << "Receive result for SendBroadcastMessageQuery: " << to_string(ptr);
+    process_sent_broadcast_message(td_, dialog_id_, std::move(ptr));
+    td_->message_broadcast_manager_->on_broadcast_message_sent(broadcast_id_, dialog_pos_, Status::OK());
+  }
+
+  void on_error(Status status) final {
+    LOG(INFO) << "Receive error for SendBroadcastMessageQuery: " << status;
+    if (G()->close_flag() && G()->use_message_database()) {
+      // the message will be re-sent after restart
+      return;
+    }
+    td_->dialog_manager_->on_get_dialog_error(dialog_id_, status, "SendBroadcastMessageQuery");
+    td_->message_broadcast_manager_->on_broadcast_message_sent(broadcast_id_, dialog_pos_, std::move(status));
+  }
+};
+
+class MessageBroadcastManager::SendBroadcastMediaQuery final : public Td::ResultHandler {
+  int64 broadcast_id_;
+  int32 dialog_pos_;
+  DialogId dialog_id_;
+
+ public:
+  SendBroadcastMediaQuery(int64 broadcast_id, int32 dialog_pos, DialogId dialog_id)
+      : broadcast_id_(broadcast_id), dialog_pos_(dialog_pos), dialog_id_(dialog_id) {
+  }
+
+  void send(const Broadcast *broadcast, telegram_api::object_ptr<telegram_api::InputPeer> &&input_peer,
+            telegram_api::object_ptr<telegram_api::InputMedia> &&input_media) {
+    CHECK(input_media != nullptr);
+
+    int32 flags = 0;
+    if (broadcast->disable_notification_) {
+      flags |= telegram_api::messages_sendMedia::SILENT_MASK;
+    }
+    if (broadcast->protect_content_) {
+      flags |= telegram_api::messages_sendMedia::NOFORWARDS_MASK;
+    }
+    if (broadcast->invert_media_) {
+      flags |= telegram_api::messages_sendMedia::INVERT_MEDIA_MASK;
+    }
+
+    const FormattedText *message_text = get_message_content_text(broadcast->content_.get());
+    auto entities = get_input_message_entities(td_->user_manager_.get(), message_text, "SendBroadcastMediaQuery");
+    if (!entities.empty()) {
+      flags |= telegram_api::messages_sendMedia::ENTITIES_MASK;
+    }
+
+    auto query = G()->net_query_creator().create(
+        telegram_api::messages_sendMedia(flags, false /*ignored*/, false /*ignored*/, false /*ignored*/,
+                                         false /*ignored*/, false /*ignored*/, false /*ignored*/, std::move(input_peer),
+                                         nullptr, std::move(input_media),
+                                         message_text == nullptr ? string() : message_text->text,
+                                         broadcast->get_random_id(dialog_pos_), nullptr, std::move(entities), 0,
+                                         nullptr, nullptr),
+        {{dialog_id_, broadcast->content_->get_type()}});
+    query->total_timeout_limit_ = QUERY_TOTAL_TIMEOUT_LIMIT;
+    send_query(std::move(query));
+  }
+
+  void on_result(BufferSlice packet) final {
+    auto result_ptr = fetch_result<telegram_api::messages_sendMedia>(packet);
+    if (result_ptr.is_error()) {
+      return on_error(result_ptr.move_as_error());
+    }
+
+    auto ptr = result_ptr.move_as_ok();
+    LOG(DEBUG) << "Receive result for SendBroadcastMediaQuery: " << to_string(ptr);
+    process_sent_broadcast_message(td_, dialog_id_, std::move(ptr));
+    td_->message_broadcast_manager_->on_broadcast_message_sent(broadcast_id_, dialog_pos_, Status::OK());
+  }
+
+  void on_error(Status status) final {
+    LOG(INFO) << "Receive error for SendBroadcastMediaQuery: " << status;
+    if (G()->close_flag() && G()->use_message_database()) {
+      // the message will be re-sent after restart
+      return;
+    }
+    td_->dialog_manager_->on_get_dialog_error(dialog_id_, status, "SendBroadcastMediaQuery");
+    td_->message_broadcast_manager_->on_broadcast_message_sent(broadcast_id_, dialog_pos_, std::move(status));
+  }
+};
+
+class MessageBroadcastManager::UploadBroadcastMediaQuery final : public Td::ResultHandler {
+  int64 broadcast_id_;
+  bool was_uploaded_ = false;
+  bool was_thumbnail_uploaded_ = false;
+
+ public:
+  explicit UploadBroadcastMediaQuery(int64 broadcast_id) : broadcast_id_(broadcast_id) {
+  }
+
+  void send(telegram_api::object_ptr<telegram_api::InputPeer> &&input_peer,
+            telegram_api::object_ptr<telegram_api::InputMedia> &&input_media) {
+    CHECK(input_peer != nullptr);
+    CHECK(input_media != nullptr);
+    was_uploaded_ = FileManager::extract_was_uploaded(input_media);
+    was_thumbnail_uploaded_ = FileManager::extract_was_thumbnail_uploaded(input_media);
+
+    send_query(G()->net_query_creator().create(
+        telegram_api::messages_uploadMedia(0, string(), std::move(input_peer), std::move(input_media))));
+  }
+
+  void on_result(BufferSlice packet) final {
+    auto result_ptr = fetch_result<telegram_api::messages_uploadMedia>(packet);
+    if (result_ptr.is_error()) {
+      return on_error(result_ptr.move_as_error());
+    }
+
+    auto ptr = result_ptr.move_as_ok();
+    LOG(INFO) << "Receive result for UploadBroadcastMediaQuery: " << to_string(ptr);
+    td_->message_broadcast_manager_->on_upload_broadcast_media(broadcast_id_, std::move(ptr), was_uploaded_,
+                                                               was_thumbnail_uploaded_);
+  }
+
+  void on_error(Status status) final {
+    LOG(INFO) << "Receive error for UploadBroadcastMediaQuery: " << status;
+    td_->message_broadcast_manager_->on_upload_broadcast_media(broadcast_id_, std::move(status), was_uploaded_,
+                                                               was_thumbnail_uploaded_);
+  }
+};
+
+class MessageBroadcastManager::UploadMediaCallback final : public FileManager::UploadCallback {
+  ActorId<MessageBroadcastManager> actor_id_;
+
+ public:
+  explicit UploadMediaCallback(ActorId<MessageBroadcastManager> actor_id) : actor_id_(actor_id) {
+  }
+  void on_upload_ok(FileId file_id, telegram_api::object_ptr<telegram_api::InputFile> input_file) final {
+    send_closure_later(actor_id_, &MessageBroadcastManager::on_upload_media, file_id, std::move(input_file));
+  }
+  void on_upload_encrypted_ok(FileId file_id,
+                              telegram_api::object_ptr<telegram_api::InputEncryptedFile> input_file) final {
+    UNREACHABLE();
+  }
+  void on_upload_secure_ok(FileId file_id, telegram_api::object_ptr<telegram_api::InputSecureFile> input_file) final {
+    UNREACHABLE();
+  }
+  void on_upload_error(FileId file_id, Status error) final {
+    send_closure_later(actor_id_, &MessageBroadcastManager::on_upload_media_error, file_id, std::move(error));
+  }
+};
+
+class MessageBroadcastManager::UploadThumbnailCallback final : public FileManager::UploadCallback {
+  ActorId<MessageBroadcastManager> actor_id_;
+
+ public:
+  explicit UploadThumbnailCallback(ActorId<MessageBroadcastManager> actor_id) : actor_id_(actor_id) {
+  }
+  void on_upload_ok(FileId file_id, telegram_api::object_ptr<telegram_api::InputFile> input_file) final {
+    send_closure_later(actor_id_, &MessageBroadcastManager::on_upload_thumbnail, file_id, std::move(input_file));
+  }
+  void on_upload_encrypted_ok(FileId file_id,
+                              telegram_api::object_ptr<telegram_api::InputEncryptedFile> input_file) final {
+    UNREACHABLE();
+  }
+  void on_upload_secure_ok(FileId file_id, telegram_api::object_ptr<telegram_api::InputSecureFile> input_file) final {
+    UNREACHABLE();
+  }
+  void on_upload_error(FileId file_id, Status error) final {
+    send_closure_later(actor_id_, &MessageBroadcastManager::on_upload_thumbnail, file_id, nullptr);
+  }
+};
+
+MessageBroadcastManager::MessageBroadcastManager(Td *td, ActorShared<> parent) : td_(td), parent_(std::move(parent)) {
+  update_timeout_.set_callback(on_update_timeout_callback);
+  update_timeout_.set_callback_data(static_cast<void *>(this));
+}
+
+MessageBroadcastManager::~MessageBroadcastManager() = default;
+
+void MessageBroadcastManager::start_up() {
+  upload_media_callback_ = std::make_shared<UploadMediaCallback>(actor_id(this));
+  upload_thumbnail_callback_ = std::make_shared<UploadThumbnailCallback>(actor_id(this));
+}
+
+void MessageBroadcastManager::tear_down() {
+  parent_.reset();
+}
+
+void MessageBroadcastManager::on_update_timeout_callback(void *message_broadcast_manager_ptr, int64 broadcast_id) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  auto message_broadcast_manager = static_cast<MessageBroadcastManager *>(message_broadcast_manager_ptr);
+  send_closure_later(message_broadcast_manager->actor_id(message_broadcast_manager),
+                     &MessageBroadcastManager::on_update_timeout, broadcast_id);
+}
+
+void MessageBroadcastManager::on_update_timeout(int64 broadcast_id) {
+  auto *broadcast = get_broadcast(broadcast_id);
+  if (broadcast == nullptr) {
+    return;
+  }
+  send_closure(G()->td(), &Td::send_update, get_update_message_broadcast_object(broadcast));
+  save_message_broadcast_progress_log_event(broadcast);
+}
+
+int64 MessageBroadcastManager::save_message_broadcast_log_event(const Broadcast *broadcast) {
+  if (!G()->use_message_database()) {
+    return 0;
+  }
+
+  return binlog_add(G()->td_db()->get_binlog(), LogEvent::HandlerType::SendMessageBroadcast,
+                    get_log_event_storer(MessageBroadcastLogEvent(broadcast)));
+}
+
+void MessageBroadcastManager::save_message_broadcast_progress_log_event(Broadcast *broadcast) {
+  if (broadcast->log_event_id_ == 0 || !broadcast->progress_.need_save()) {
+    return;
+  }
+
+  MessageBroadcastProgressLogEvent log_event;
+  log_event.broadcast_id_ = broadcast->broadcast_id_;
+  log_event.progress_in_ = &broadcast->progress_;
+  auto storer = get_log_event_storer(log_event);
+  if (broadcast->progress_log_event_id_ == 0) {
+    broadcast->progress_log_event_id_ = binlog_add(
+        G()->td_db()->get_binlog(), LogEvent::HandlerType::UpdateMessageBroadcastProgress, storer);
+  } else {
+    binlog_rewrite(G()->td_db()->get_binlog(), broadcast->progress_log_event_id_,
+                   LogEvent::HandlerType::UpdateMessageBroadcastProgress, storer);
+  }
+}
+
+MessageBroadcastManager::Broadcast *MessageBroadcastManager::get_broadcast(int64 broadcast_id) {
+  auto it = broadcasts_.find(broadcast_id);
+  if (it == broadcasts_.end()) {
+    return nullptr;
+  }
+  return it->second.get();
+}
+
+void MessageBroadcastManager::send_message_broadcast(
+    vector<DialogId> dialog_ids, bool disable_notification, bool protect_content,
+    td_api::object_ptr<td_api::InputMessageContent> &&input_message_content,
+    Promise<td_api::object_ptr<td_api::messageBroadcast>> &&promise) {
+  if (dialog_ids.empty()) {
+    return promise.set_error(Status::Error(400, "Chat list must be non-empty"));
+  }
+  if (dialog_ids.size() > static_cast<size_t>(MAX_BROADCAST_CHAT_COUNT)) {
+    return promise.set_error(Status::Error(400, "Too many chats specified"));
+  }
+  FlatHashSet<DialogId, DialogIdHash> added_dialog_ids;
+  vector<DialogId> unique_dialog_ids;
+  unique_dialog_ids.reserve(dialog_ids.size());
+  for (auto dialog_id : dialog_ids) {
+    if (!dialog_id.is_valid()) {
+      return promise.set_error(Status::Error(400, "Invalid chat identifier specified"));
+    }
+    if (dialog_id.get_type() == DialogType::SecretChat) {
+      return promise.set_error(Status::Error(400, "Can't broadcast messages to secret chats"));
+    }
+    if (added_dialog_ids.insert(dialog_id).second) {
+      unique_dialog_ids.push_back(dialog_id);
+    }
+  }
+
+  if (input_message_content == nullptr) {
+    return promise.set_error(Status::Error(400, "Can't send message without content"));
+  }
+  if (input_message_content->get_id() == td_api::inputMessageForwarded::ID) {
+    return promise.set_error(Status::Error(400, "Can't broadcast forwarded messages"));
+  }
+  bool is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
+  TRY_RESULT_PROMISE(promise, input_content,
+                     get_input_message_content(DialogId(), std::move(input_message_content), td_, is_premium));
+
+  auto broadcast = make_unique<Broadcast>();
+  do {
+    broadcast->broadcast_id_ = static_cast<int64>(Random::secure_uint64() >> 11);
+  } while (broadcast->broadcast_id_ == 0 || broadcasts_.count(broadcast->broadcast_id_) != 0);
+  broadcast->dialog_ids_ = std::move(unique_dialog_ids);
+  broadcast->content_ = dup_message_content(td_, td_->dialog_manager_->get_my_dialog_id(), input_content.content.get(),
+                                            MessageContentDupType::Send, MessageCopyOptions());
+  broadcast->ttl_ = input_content.ttl;
+  broadcast->send_emoji_ = std::move(input_content.emoji);
+  broadcast->random_id_ = Random::secure_int64();
+  broadcast->disable_notification_ = disable_notification;
+  broadcast->protect_content_ = protect_content;
+  broadcast->invert_media_ = input_content.invert_media;
+  broadcast->disable_web_page_preview_ = input_content.disable_web_page_preview;
+  broadcast->log_event_id_ = save_message_broadcast_log_event(broadcast.get());
+
+  LOG(INFO) << "Start broadcast " << broadcast->broadcast_id_ << " to " << broadcast->dialog_ids_.size() << " chats";
+  auto *broadcast_ptr = broadcast.get();
+  broadcasts_.emplace(broadcast_ptr->broadcast_id_, std::move(broadcast));
+  promise.set_value(get_message_broadcast_object(broadcast_ptr));
+
+  prepare_broadcast_content(broadcast_ptr);
+}
+
+void MessageBroadcastManager::cancel_message_broadcast(int64 broadcast_id, Promise<Unit> &&promise) {
+  auto *broadcast = get_broadcast(broadcast_id);
+  if (broadcast == nullptr) {
+    return promise.set_error(Status::Error(400, "Broadcast not found"));
+  }
+
+  LOG(INFO) << "Cancel broadcast " << broadcast_id;
+  broadcast->is_canceled_ = true;
+  try_finish_broadcast(broadcast);
+  promise.set_value(Unit());
+}
+
+void MessageBroadcastManager::prepare_broadcast_content(Broadcast *broadcast, vector<int> bad_parts) {
+  const auto *content = broadcast->content_.get();
+  CHECK(content != nullptr);
+  auto content_type = content->get_type();
+  if (content_type == MessageContentType::Text ||
+      get_input_media(content, td_, broadcast->ttl_, broadcast->send_emoji_, td_->auth_manager_->is_bot()) !=
+          nullptr) {
+    return on_broadcast_content_ready(broadcast);
+  }
+  if (content_type == MessageContentType::Game || content_type == MessageContentType::Poll ||
+      content_type == MessageContentType::Story) {
+    return on_broadcast_content_error(broadcast, Status::Error(400, "Message has no file"));
+  }
+
+  // the file is uploaded only once and the received remote file is used for all messages
+  auto file_id = get_message_content_any_file_id(content);  // any_file_id, because it could be a photo sent by ID
+  CHECK(file_id.is_valid());
+  FileView file_view = td_->file_manager_->get_file_view(file_id);
+  if (file_view.is_encrypted()) {
+    return on_broadcast_content_error(broadcast, Status::Error(400, "Can't use encrypted file"));
+  }
+  if (file_view.has_remote_location() && file_view.main_remote_location().is_web()) {
+    return on_broadcast_content_error(broadcast, Status::Error(400, "Can't use a web file"));
+  }
+
+  BeingUploadedMedia media;
+  media.broadcast_id_ = broadcast->broadcast_id_;
+
+  if (!file_view.has_remote_location() && file_view.has_url()) {
+    return do_upload_media(std::move(media), nullptr);
+  }
+
+  LOG(INFO) << "Ask to upload file " << file_id << " with bad parts " << bad_parts << " for broadcast "
+            << broadcast->broadcast_id_;
+  bool is_inserted = being_uploaded_files_.emplace(file_id, std::move(media)).second;
+  CHECK(is_inserted);
+  td_->file_manager_->resume_upload(file_id, std::move(bad_parts), upload_media_callback_, 1, 0);
+}
+
+FileId MessageBroadcastManager::get_broadcast_thumbnail_file_id(const Broadcast *broadcast, FileId file_id) const {
+  FileView file_view = td_->file_manager_->get_file_view(file_id);
+  if (get_main_file_type(file_view.get_type()) == FileType::Photo) {
+    return FileId();
+  }
+  return get_message_content_thumbnail_file_id(broadcast->content_.get(), td_);
+}
+
+void MessageBroadcastManager::on_upload_media(FileId file_id,
+                                              telegram_api::object_ptr<telegram_api::InputFile> input_file) {
+  LOG(INFO) << "File " << file_id << " has been uploaded";
+
+  auto it = being_uploaded_files_.find(file_id);
+  if (it == being_uploaded_files_.end()) {
+    // the broadcast has already been finished
+    return;
+  }
+  auto being_uploaded_media = std::move(it->second);
+  being_uploaded_files_.erase(it);
+
+  auto *broadcast = get_broadcast(being_uploaded_media.broadcast_id_);
+  CHECK(broadcast != nullptr);
+  being_uploaded_media.input_file_ = std::move(input_file);
+  auto thumbnail_file_id = get_broadcast_thumbnail_file_id(broadcast, file_id);
+  if (being_uploaded_media.input_file_ != nullptr && thumbnail_file_id.is_valid()) {
+    LOG(INFO) << "Ask to upload thumbnail " << thumbnail_file_id;
+    bool is_inserted = being_uploaded_thumbnails_.emplace(thumbnail_file_id, std::move(being_uploaded_media)).second;
+    CHECK(is_inserted);
+    td_->file_manager_->upload(thumbnail_file_id, upload_thumbnail_callback_, 1, 0);
+  } else {
+    do_upload_media(std::move(being_uploaded_media), nullptr);
+  }
+}
+
+void MessageBroadcastManager::on_upload_media_error(FileId file_id, Status status) {
+  CHECK(status.is_error());
+
+  auto it = being_uploaded_files_.find(file_id);
+  if (it == being_uploaded_files_.end()) {
+    return;
+  }
+  auto broadcast_id = it->second.broadcast_id_;
+  being_uploaded_files_.erase(it);
+
+  auto *broadcast = get_broadcast(broadcast_id);
+  CHECK(broadcast != nullptr);
+  on_broadcast_content_error(broadcast, std::move(status));
+}
+
+void MessageBroadcastManager::on_upload_thumbnail(
+    FileId thumbnail_file_id, telegram_api::object_ptr<telegram_api::InputFile> thumbnail_input_file) {
+  LOG(INFO) << "Thumbnail " << thumbnail_file_id << " has been uploaded as " << to_string(thumbnail_input_file);
+
+  auto it = being_uploaded_thumbnails_.find(thumbnail_file_id);
+  if (it == being_uploaded_thumbnails_.end()) {
+    return;
+  }
+  auto being_uploaded_media = std::move(it->second);
+  being_uploaded_thumbnails_.erase(it);
+
+  if (thumbnail_input_file == nullptr) {
+    auto *broadcast = get_broadcast(being_uploaded_media.broadcast_id_);
+    CHECK(broadcast != nullptr);
+    delete_message_content_thumbnail(broadcast->content_.get(), td_);
+  }
+
+  do_upload_media(std::move(being_uploaded_media), std::move(thumbnail_input_file));
+}
+
+void MessageBroadcastManager::do_upload_media(BeingUploadedMedia &&being_uploaded_media,
+                                              telegram_api::object_ptr<telegram_api::InputFile> input_thumbnail) {
+  auto *broadcast = get_broadcast(being_uploaded_media.broadcast_id_);
+  CHECK(broadcast != nullptr);
+  const auto *content = broadcast->content_.get();
+  auto file_id = get_message_content_any_file_id(content);
+  auto thumbnail_file_id = get_broadcast_thumbnail_file_id(broadcast, file_id);
+  auto input_file = std::move(being_uploaded_media.input_file_);
+  LOG(INFO) << "Do upload media file " << file_id << " with thumbnail " << thumbnail_file_id
+            << ", have_input_file = " << (input_file != nullptr)
+            << ", have_input_thumbnail = " << (input_thumbnail != nullptr);
+
+  auto input_media = get_input_media(content, td_, std::move(input_file), std::move(input_thumbnail), file_id,
+                                     thumbnail_file_id, broadcast->ttl_, broadcast->send_emoji_, true);
+  CHECK(input_media != nullptr);
+  switch (input_media->get_id()) {
+    case telegram_api::inputMediaDocument::ID:
+    case telegram_api::inputMediaPhoto::ID:
+      // the file has already been uploaded
+      return on_broadcast_content_ready(broadcast);
+    case telegram_api::inputMediaUploadedDocument::ID:
+      if (content->get_type() != MessageContentType::Animation) {
+        static_cast<telegram_api::inputMediaUploadedDocument *>(input_media.get())->flags_ |=
+            telegram_api::inputMediaUploadedDocument::NOSOUND_VIDEO_MASK;
+      }
+    // fallthrough
+    case telegram_api::inputMediaUploadedPhoto::ID:
+    case telegram_api::inputMediaDocumentExternal::ID:
+    case telegram_api::inputMediaPhotoExternal::ID: {
+      // bots have no chat with themselves, so the file is uploaded to the first chat of the broadcast
+      auto upload_dialog_id = td_->auth_manager_->is_bot() ? broadcast->dialog_ids_[0]
+                                                           : td_->dialog_manager_->get_my_dialog_id();
+      auto input_peer = td_->dialog_manager_->get_input_peer(upload_dialog_id, AccessRights::Write);
+      if (input_peer == nullptr) {
+        return on_broadcast_content_error(broadcast, Status::Error(400, "Have no write access to the chat"));
+      }
+      td_->create_handler<UploadBroadcastMediaQuery>(broadcast->broadcast_id_)
+          ->send(std::move(input_peer), std::move(input_media));
+      break;
+    }
+    default:
+      LOG(ERROR) << "Have wrong input media " << to_string(input_media);
+      on_broadcast_content_error(broadcast, Status::Error(400, "Invalid input media"));
+  }
+}
+
+void MessageBroadcastManager::on_upload_broadcast_media(
+    int64 broadcast_id, Result<telegram_api::object_ptr<telegram_api::MessageMedia>> r_media, bool was_uploaded,
+    bool was_thumbnail_uploaded) {
+  G()->ignore_result_if_closing(r_media);
+  auto *broadcast = get_broadcast(broadcast_id);
+  if (broadcast == nullptr) {
+    return;
+  }
+
+  auto file_id = get_message_content_any_file_id(broadcast->content_.get());
+  CHECK(file_id.is_valid());
+  if (was_thumbnail_uploaded) {
+    auto thumbnail_file_id = get_broadcast_thumbnail_file_id(broadcast, file_id);
+    CHECK(thumbnail_file_id.is_valid());
+    // always delete partial remote location for the thumbnail, because it can't be reused anyway
+    td_->file_manager_->delete_partial_remote_location(thumbnail_file_id);
+  }
+
+  if (r_media.is_error()) {
+    auto status = r_media.move_as_error();
+    if (was_uploaded) {
+      auto bad_parts = FileManager::get_missing_file_parts(status);
+      if (!bad_parts.empty()) {
+        return prepare_broadcast_content(broadcast, std::move(bad_parts));
+      }
+      td_->file_manager_->delete_partial_remote_location_if_needed(file_id, status);
+    }
+    return on_broadcast_content_error(broadcast, std::move(status));
+  }
+
+  complete_upload_media(broadcast, r_media.move_as_ok());
+}
+
+void MessageBroadcastManager::complete_upload_media(Broadcast *broadcast,
+                                                    telegram_api::object_ptr<telegram_api::MessageMedia> &&media) {
+  auto *content = broadcast->content_.get();
+  auto *caption = get_message_content_caption(content);
+  auto has_spoiler = get_message_content_has_spoiler(content);
+  auto new_content = get_message_content(td_, caption == nullptr ? FormattedText() : *caption, std::move(media),
+                                         td_->dialog_manager_->get_my_dialog_id(), G()->unix_time(), false, UserId(),
+                                         nullptr, nullptr, "complete_upload_media");
+  set_message_content_has_spoiler(new_content.get(), has_spoiler);
+
+  bool is_content_changed = false;
+  bool need_update = false;
+
+  unique_ptr<MessageContent> &old_content = broadcast->content_;
+  MessageContentType old_content_type = old_content->get_type();
+  MessageContentType new_content_type = new_content->get_type();
+
+  auto old_file_id = get_message_content_any_file_id(old_content.get());
+  if (old_content_type != new_content_type) {
+    need_update = true;
+
+    td_->file_manager_->try_merge_documents(old_file_id, get_message_content_any_file_id(new_content.get()));
+  } else {
+    merge_message_contents(td_, old_content.get(), new_content.get(), false, DialogId(), true, is_content_changed,
+                           need_update);
+    compare_message_contents(td_, old_content.get(), new_content.get(), is_content_changed, need_update);
+  }
+  send_closure_later(G()->file_manager(), &FileManager::cancel_upload, old_file_id);
+
+  if (is_content_changed || need_update) {
+    old_content = std::move(new_content);
+    update_message_content_file_id_remote(old_content.get(), old_file_id);
+  } else {
+    update_message_content_file_id_remote(old_content.get(), get_message_content_any_file_id(new_content.get()));
+  }
+
+  if (get_input_media(broadcast->content_.get(), td_, broadcast->ttl_, broadcast->send_emoji_, true) == nullptr) {
+    return on_broadcast_content_error(broadcast, Status::Error(400, "Failed to upload file"));
+  }
+  on_broadcast_content_ready(broadcast);
+}
+
+void MessageBroadcastManager::on_broadcast_content_ready(Broadcast *broadcast) {
+  LOG(INFO) << "Content of broadcast " << broadcast->broadcast_id_ << " is ready";
+  broadcast->is_content_ready_ = true;
+  send_broadcast_messages(broadcast);
+}
+
+void MessageBroadcastManager::on_broadcast_content_error(Broadcast *broadcast, Status status) {
+  LOG(INFO) << "Failed to prepare content of broadcast " << broadcast->broadcast_id_ << ": " << status;
+  broadcast->progress_.fail_remaining_messages(static_cast<int32>(broadcast->dialog_ids_.size()));
+  try_finish_broadcast(broadcast);
+}
+
+void MessageBroadcastManager::send_broadcast_messages(Broadcast *broadcast) {
+  auto dialog_count = static_cast<int32>(broadcast->dialog_ids_.size());
+  if (broadcast->is_content_ready_ && !broadcast->is_canceled_) {
+    auto &progress = broadcast->progress_;
+    while (progress.get_active_query_count() < MAX_ACTIVE_QUERY_COUNT && progress.get_next_dialog_pos() < dialog_count) {
+      auto dialog_pos = progress.start_next_message();
+      auto status = do_send_broadcast_message(broadcast, dialog_pos);
+      if (status.is_error()) {
+        LOG(INFO) << "Failed to send broadcast message to " << broadcast->dialog_ids_[dialog_pos] << ": " << status;
+        progress.finish_message(dialog_pos, false);
+      }
+    }
+  }
+  on_broadcast_changed(broadcast);
+  try_finish_broadcast(broadcast);
+}
+
+Status MessageBroadcastManager::do_send_broadcast_message(const Broadcast *broadcast, int32 dialog_pos) {
+  auto dialog_id = broadcast->dialog_ids_[dialog_pos];
+  if (!td_->dialog_manager_->have_dialog_force(dialog_id, "do_send_broadcast_message")) {
+    return Status::Error(400, "Chat not found");
+  }
+  auto input_peer = td_->dialog_manager_->get_input_peer(dialog_id, AccessRights::Write);
+  if (input_peer == nullptr) {
+    return Status::Error(400, "Have no write access to the chat");
+  }
+
+  const auto *content = broadcast->content_.get();
+  if (content->get_type() == MessageContentType::Text) {
+    auto input_media = get_message_content_input_media_web_page(td_, content);
+    if (input_media == nullptr) {
+      td_->create_handler<SendBroadcastMessageQuery>(broadcast->broadcast_id_, dialog_pos, dialog_id)
+          ->send(broadcast, std::move(input_peer));
+    } else {
+      td_->create_handler<SendBroadcastMediaQuery>(broadcast->broadcast_id_, dialog_pos, dialog_id)
+          ->send(broadcast, std::move(input_peer), std::move(input_media));
+    }
+    return Status::OK();
+  }
+
+  auto input_media =
+      get_input_media(content, td_, broadcast->ttl_, broadcast->send_emoji_, td_->auth_manager_->is_bot());
+  if (input_media == nullptr) {
+    return Status::Error(400, "Failed to get message media");
+  }
+  td_->create_handler<SendBroadcastMediaQuery>(broadcast->broadcast_id_, dialog_pos, dialog_id)
+      ->send(broadcast, std::move(input_peer), std::move(input_media));
+  return Status::OK();
+}
+
+void MessageBroadcastManager::on_broadcast_message_sent(int64 broadcast_id, int32 dialog_pos, Status status) {
+  auto *broadcast = get_broadcast(broadcast_id);
+  if (broadcast == nullptr) {
+    return;
+  }
+
+  if (status.is_error()) {
+    if (status.message() == "RANDOM_ID_DUPLICATE") {
+      // the message has already been sent before restart
+      status = Status::OK();
+    } else {
+      LOG(INFO) << "Failed to send broadcast message to " << broadcast->dialog_ids_[dialog_pos] << ": " << status;
+    }
+  }
+  broadcast->progress_.finish_message(dialog_pos, status.is_ok());
+  send_broadcast_messages(broadcast);
+}
+
+void MessageBroadcastManager::on_broadcast_changed(Broadcast *broadcast) {
+  if (!update_timeout_.has_timeout(broadcast->broadcast_id_)) {
+    update_timeout_.set_timeout_in(broadcast->broadcast_id_, UPDATE_DELAY);
+  }
+}
+
+void MessageBroadcastManager::try_finish_broadcast(Broadcast *broadcast) {
+  const auto &progress = broadcast->progress_;
+  if (progress.get_active_query_count() != 0 ||
+      (!broadcast->is_canceled_ &&
+       progress.get_next_dialog_pos() < static_cast<int32>(broadcast->dialog_ids_.size()))) {
+    return;
+  }
+  CHECK(progress.get_next_dialog_pos() == progress.get_committed_dialog_pos());
+
+  auto broadcast_id = broadcast->broadcast_id_;
+  LOG(INFO) << "Finish broadcast " << broadcast_id << " with " << progress.get_sent_count() << " sent and "
+            << progress.get_failed_count() << " failed messages";
+  broadcast->is_finished_ = true;
+  send_closure(G()->td(), &Td::send_update, get_update_message_broadcast_object(broadcast));
+  update_timeout_.cancel_timeout(broadcast_id);
+
+  if (broadcast->log_event_id_ != 0) {
+    binlog_erase(G()->td_db()->get_binlog(), broadcast->log_event_id_);
+  }
+  if (broadcast->progress_log_event_id_ != 0) {
+    binlog_erase(G()->td_db()->get_binlog(), broadcast->progress_log_event_id_);
+  }
+
+  auto file_id = get_message_content_any_file_id(broadcast->content_.get());
+  if (file_id.is_valid() && being_uploaded_files_.erase(file_id) != 0) {
+    send_closure_later(G()->file_manager(), &FileManager::cancel_upload, file_id);
+  }
+  for (auto it = being_uploaded_thumbnails_.begin(); it != being_uploaded_thumbnails_.end(); ++it) {
+    if (it->second.broadcast_id_ == broadcast_id) {
+      send_closure_later(G()->file_manager(), &FileManager::cancel_upload, it->first);
+      being_uploaded_thumbnails_.erase(it);
+      break;
+    }
+  }
+
+  broadcasts_.erase(broadcast_id);
+}
+
+td_api::object_ptr<td_api::messageBroadcast> MessageBroadcastManager::get_message_broadcast_object(
+    const Broadcast *broadcast) const {
+  const auto &progress = broadcast->progress_;
+  vector<int64> failed_chat_ids;
+  if (broadcast->is_finished_) {
+    failed_chat_ids = transform(progress.get_failed_dialog_positions(),
+                                [broadcast](int32 dialog_pos) { return broadcast->dialog_ids_[dialog_pos].get(); });
+  }
+  return td_api::make_object<td_api::messageBroadcast>(
+      broadcast->broadcast_id_, static_cast<int32>(broadcast->dialog_ids_.size()), progress.get_sent_count(),
+      progress.get_failed_count(), std::move(failed_chat_ids), broadcast->is_finished_);
+}
+
+td_api::object_ptr<td_api::updateMessageBroadcast> MessageBroadcastManager::get_update_message_broadcast_object(
+    const Broadcast *broadcast) const {
+  return td_api::make_object<td_api::updateMessageBroadcast>(get_message_broadcast_object(broadcast));
+}
+
+void MessageBroadcastManager::on_binlog_events(vector<BinlogEvent> &&events) {
+  if (G()->close_flag()) {
+    return;
+  }
+  vector<BinlogEvent> progress_events;
+  for (auto &event : events) {
+    CHECK(event.id_ != 0);
+    switch (event.type_) {
+      case LogEvent::HandlerType::SendMessageBroadcast: {
+        if (!G()->use_message_database()) {
+          binlog_erase(G()->td_db()->get_binlog(), event.id_);
+          break;
+        }
+
+        MessageBroadcastLogEvent log_event;
+        log_event_parse(log_event, event.get_data()).ensure();
+
+        auto broadcast = std::move(log_event.broadcast_out_);
+        CHECK(broadcast->content_ != nullptr);
+        if (broadcast->content_->get_type() == MessageContentType::Unsupported) {
+          LOG(ERROR) << "Broadcast message content is invalid: " << format::as_hex_dump<4>(event.get_data());
+          binlog_erase(G()->td_db()->get_binlog(), event.id_);
+          break;
+        }
+        if (broadcast->broadcast_id_ == 0 || broadcasts_.count(broadcast->broadcast_id_) != 0) {
+          binlog_erase(G()->td_db()->get_binlog(), event.id_);
+          break;
+        }
+
+        Dependencies dependencies;
+        add_message_content_dependencies(dependencies, broadcast->content_.get(), td_->auth_manager_->is_bot());
+        if (!dependencies.resolve_force(td_, "MessageBroadcastLogEvent")) {
+          binlog_erase(G()->td_db()->get_binlog(), event.id_);
+          break;
+        }
+
+        broadcast->log_event_id_ = event.id_;
+        auto broadcast_id = broadcast->broadcast_id_;
+        broadcasts_.emplace(broadcast_id, std::move(broadcast));
+        break;
+      }
+      case LogEvent::HandlerType::UpdateMessageBroadcastProgress:
+        // must be applied after all broadcasts are loaded
+        progress_events.push_back(std::move(event));
+        break;
+      default:
+        LOG(FATAL) << "Unsupported log event type " << event.type_;
+    }
+  }
+
+  for (auto &event : progress_events) {
+    MessageBroadcastProgressLogEvent log_event;
+    auto status = log_event_parse(log_event, event.get_data());
+    auto *broadcast = status.is_ok() ? get_broadcast(log_event.broadcast_id_) : nullptr;
+    auto dialog_count = broadcast == nullptr ? 0 : static_cast<int32>(broadcast->dialog_ids_.size());
+    if (broadcast == nullptr || broadcast->progress_log_event_id_ != 0 ||
+        log_event.progress_out_.get_committed_dialog_pos() > dialog_count) {
+      binlog_erase(G()->td_db()->get_binlog(), event.id_);
+      continue;
+    }
+    broadcast->progress_log_event_id_ = event.id_;
+    broadcast->progress_ = std::move(log_event.progress_out_);
+  }
+
+  auto broadcast_ids = transform(broadcasts_, [](const auto &it) { return it.first; });
+  for (auto broadcast_id : broadcast_ids) {
+    auto *broadcast = get_broadcast(broadcast_id);
+    CHECK(broadcast != nullptr);
+    LOG(INFO) << "Continue broadcast " << broadcast_id << " from chat "
+              << broadcast->progress_.get_committed_dialog_pos() << " of "
+              << broadcast->dialog_ids_.size();
+    prepare_broadcast_content(broadcast);
+  }
+}
+
+void MessageBroadcastManager::get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const {
+  for (const auto &it : broadcasts_) {
+    updates.push_back(get_update_message_broadcast_object(it.second.get()));
+  }
+}
+
+}  // namespace td
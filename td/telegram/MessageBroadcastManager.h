@@ -0,0 +1,136 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/DialogId.h"
+#include "td/telegram/files/FileId.h"
+#include "td/telegram/td_api.h"
+#include "td/telegram/telegram_api.h"
+
+#include "td/actor/actor.h"
+#include "td/actor/MultiTimeout.h"
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Status.h"
+
+#include <memory>
+
+namespace td {
+
+struct BinlogEvent;
+class Td;
+
+// sends the same message to many chats without creating local messages
+class MessageBroadcastManager final : public Actor {
+ public:
+  MessageBroadcastManager(Td *td, ActorShared<> parent);
+  MessageBroadcastManager(const MessageBroadcastManager &) = delete;
+  MessageBroadcastManager &operator=(const MessageBroadcastManager &) = delete;
+  MessageBroadcastManager(MessageBroadcastManager &&) = delete;
+  MessageBroadcastManager &operator=(MessageBroadcastManager &&) = delete;
+  ~MessageBroadcastManager() final;
+
+  void send_message_broadcast(vector<DialogId> dialog_ids, bool disable_notification, bool protect_content,
+                              td_api::object_ptr<td_api::InputMessageContent> &&input_message_content,
+                              Promise<td_api::object_ptr<td_api::messageBroadcast>> &&promise);
+
+  void cancel_message_broadcast(int64 broadcast_id, Promise<Unit> &&promise);
+
+  void on_binlog_events(vector<BinlogEvent> &&events);
+
+  void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
+
+ private:
+  static constexpr int32 MAX_ACTIVE_QUERY_COUNT = 10;               // the maximum number of messages sent at once
+  static constexpr int32 MAX_BROADCAST_CHAT_COUNT = 1000000;        // the maximum number of chats in a broadcast
+  static constexpr double UPDATE_DELAY = 1.0;                       // the minimum delay between broadcast updates
+  static constexpr int32 QUERY_TOTAL_TIMEOUT_LIMIT = 60 * 60 * 24;  // the maximum total flood wait for a message
+
+  struct Broadcast;
+  class MessageBroadcastLogEvent;
+  class MessageBroadcastProgressLogEvent;
+  class SendBroadcastMessageQuery;
+  class SendBroadcastMediaQuery;
+  class UploadBroadcastMediaQuery;
+  class UploadMediaCallback;
+  class UploadThumbnailCallback;
+
+  struct BeingUploadedMedia {
+    int64 broadcast_id_ = 0;
+    telegram_api::object_ptr<telegram_api::InputFile> input_file_;
+  };
+
+  void start_up() final;
+
+  void tear_down() final;
+
+  static void on_update_timeout_callback(void *message_broadcast_manager_ptr, int64 broadcast_id);
+
+  void on_update_timeout(int64 broadcast_id);
+
+  static int64 save_message_broadcast_log_event(const Broadcast *broadcast);
+
+  static void save_message_broadcast_progress_log_event(Broadcast *broadcast);
+
+  Broadcast *get_broadcast(int64 broadcast_id);
+
+  void prepare_broadcast_content(Broadcast *broadcast, vector<int> bad_parts = {});
+
+  FileId get_broadcast_thumbnail_file_id(const Broadcast *broadcast, FileId file_id) const;
+
+  void on_upload_media(FileId file_id, telegram_api::object_ptr<telegram_api::InputFile> input_file);
+
+  void on_upload_media_error(FileId file_id, Status status);
+
+  void on_upload_thumbnail(FileId thumbnail_file_id,
+                           telegram_api::object_ptr<telegram_api::InputFile> thumbnail_input_file);
+
+  void do_upload_media(BeingUploadedMedia &&being_uploaded_media,
+                       telegram_api::object_ptr<telegram_api::InputFile> input_thumbnail);
+
+  void on_upload_broadcast_media(int64 broadcast_id,
+                                 Result<telegram_api::object_ptr<telegram_api::MessageMedia>> r_media,
+                                 bool was_uploaded, bool was_thumbnail_uploaded);
+
+  void complete_upload_media(Broadcast *broadcast, telegram_api::object_ptr<telegram_api::MessageMedia> &&media);
+
+  void on_broadcast_content_ready(Broadcast *broadcast);
+
+  void on_broadcast_content_error(Broadcast *broadcast, Status status);
+
+  void send_broadcast_messages(Broadcast *broadcast);
+
+  Status do_send_broadcast_message(const Broadcast *broadcast, int32 dialog_pos);
+
+  void on_broadcast_message_sent(int64 broadcast_id, int32 dialog_pos, Status status);
+
+  void on_broadcast_changed(Broadcast *broadcast);
+
+  void try_finish_broadcast(Broadcast *broadcast);
+
+  td_api::object_ptr<td_api::messageBroadcast> get_message_broadcast_object(const Broadcast *broadcast) const;
+
+  td_api::object_ptr<td_api::updateMessageBroadcast> get_update_message_broadcast_object(
+      const Broadcast *broadcast) const;
+
+  FlatHashMap<int64, unique_ptr<Broadcast>> broadcasts_;
+
+  std::shared_ptr<UploadMediaCallback> upload_media_callback_;
+  std::shared_ptr<UploadThumbnailCallback> upload_thumbnail_callback_;
+
+  FlatHashMap<FileId, BeingUploadedMedia, FileIdHash> being_uploaded_files_;
+  FlatHashMap<FileId, BeingUploadedMedia, FileIdHash> being_uploaded_thumbnails_;
+
+  MultiTimeout update_timeout_{"MessageBroadcastUpdateTimeout"};
+
+  Td *td_;
+  ActorShared<> parent_;
+};
+
+}  // namespace td
@@ -0,0 +1,68 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/MessageBroadcastProgress.h"
+
+#include "td/utils/logging.h"
+
+namespace td {
+
+int32 MessageBroadcastProgress::start_next_message() {
+  auto dialog_pos = get_next_dialog_pos();
+  uncommitted_states_.push(State::Pending);
+  active_query_count_++;
+  return dialog_pos;
+}
+
+void MessageBroadcastProgress::finish_message(int32 dialog_pos, bool is_sent) {
+  auto states = uncommitted_states_.as_mutable_span();
+  auto state_pos = static_cast<size_t>(dialog_pos - committed_dialog_pos_);
+  CHECK(state_pos < states.size());
+  CHECK(states[state_pos] == State::Pending);
+  states[state_pos] = is_sent ? State::Sent : State::Failed;
+  if (is_sent) {
+    sent_count_++;
+  } else {
+    failed_count_++;
+  }
+  CHECK(active_query_count_ > 0);
+  active_query_count_--;
+
+  commit_finished_messages();
+}
+
+void MessageBroadcastProgress::fail_remaining_messages(int32 dialog_count) {
+  CHECK(active_query_count_ == 0);
+  CHECK(uncommitted_states_.empty());
+  CHECK(committed_dialog_pos_ <= dialog_count);
+  for (auto dialog_pos = committed_dialog_pos_; dialog_pos < dialog_count; dialog_pos++) {
+    failed_dialog_positions_.push_back(dialog_pos);
+  }
+  failed_count_ += dialog_count - committed_dialog_pos_;
+  committed_dialog_pos_ = dialog_count;
+}
+
+bool MessageBroadcastProgress::need_save() {
+  // the committed state changes only when the committed position increases
+  if (saved_dialog_pos_ == committed_dialog_pos_) {
+    return false;
+  }
+  saved_dialog_pos_ = committed_dialog_pos_;
+  return true;
+}
+
+void MessageBroadcastProgress::commit_finished_messages() {
+  while (!uncommitted_states_.empty() && uncommitted_states_.front() != State::Pending) {
+    if (uncommitted_states_.pop() == State::Sent) {
+      committed_sent_count_++;
+    } else {
+      failed_dialog_positions_.push_back(committed_dialog_pos_);
+    }
+    committed_dialog_pos_++;
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,103 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/tl_helpers.h"
+#include "td/utils/VectorQueue.h"
+
+namespace td {
+
+// states of messages sent to chats of a message broadcast in the order of the chats
+// messages to all chats before the committed position are finished; only the committed state is saved in the binlog,
+// so after a restart messages to the other chats are sent again with the same random_id and are deduplicated
+class MessageBroadcastProgress {
+ public:
+  int32 get_next_dialog_pos() const {
+    return committed_dialog_pos_ + static_cast<int32>(uncommitted_states_.size());
+  }
+
+  int32 get_committed_dialog_pos() const {
+    return committed_dialog_pos_;
+  }
+
+  int32 get_active_query_count() const {
+    return active_query_count_;
+  }
+
+  int32 get_sent_count() const {
+    return sent_count_;
+  }
+
+  int32 get_failed_count() const {
+    return failed_count_;
+  }
+
+  const vector<int32> &get_failed_dialog_positions() const {
+    return failed_dialog_positions_;
+  }
+
+  // returns position of the chat to which a message must be sent next
+  int32 start_next_message();
+
+  void finish_message(int32 dialog_pos, bool is_sent);
+
+  // fails messages to all chats, to which they weren't sent yet
+  void fail_remaining_messages(int32 dialog_count);
+
+  // returns true if the committed state has changed since the last call
+  bool need_save();
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(committed_dialog_pos_, storer);
+    td::store(committed_sent_count_, storer);
+    td::store(failed_dialog_positions_, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser);
+
+ private:
+  enum class State : int8 { Pending, Sent, Failed };
+
+  int32 committed_dialog_pos_ = 0;
+  int32 committed_sent_count_ = 0;
+  vector<int32> failed_dialog_positions_;
+  VectorQueue<State> uncommitted_states_;  // states of messages to chats, starting from committed_dialog_pos_
+
+  int32 active_query_count_ = 0;
+  int32 sent_count_ = 0;
+  int32 failed_count_ = 0;
+
+  int32 saved_dialog_pos_ = 0;
+
+  void commit_finished_messages();
+};
+
+template <class ParserT>
+void MessageBroadcastProgress::parse(ParserT &parser) {
+  td::parse(committed_dialog_pos_, parser);
+  td::parse(committed_sent_count_, parser);
+  td::parse(failed_dialog_positions_, parser);
+  if (committed_dialog_pos_ < 0 || committed_sent_count_ < 0 ||
+      committed_sent_count_ + static_cast<int64>(failed_dialog_positions_.size()) != committed_dialog_pos_) {
+    return parser.set_error("Invalid message broadcast progress");
+  }
+  int32 previous_dialog_pos = -1;
+  for (auto dialog_pos : failed_dialog_positions_) {
+    if (dialog_pos <= previous_dialog_pos || dialog_pos >= committed_dialog_pos_) {
+      return parser.set_error("Invalid failed message broadcast chat");
+    }
+    previous_dialog_pos = dialog_pos;
+  }
+  sent_count_ = committed_sent_count_;
+  failed_count_ = static_cast<int32>(failed_dialog_positions_.size());
+  saved_dialog_pos_ = committed_dialog_pos_;
+}
+
+}  // namespace td
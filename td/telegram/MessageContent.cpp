@@ -2446,6 +2446,10 @@ void store_message_content(const MessageContent *content, LogEventStorerCalcLeng
   store(content, storer);
 }
 
+void store_message_content(const MessageContent *content, LogEventStorerGrowable &storer) {
+  store(content, storer);
+}
+
 void store_message_content(const MessageContent *content, LogEventStorerUnsafe &storer) {
   store(content, storer);
 }
@@ -2631,7 +2635,7 @@ static Result<InputMessageContent> create_input_message_content(
       clear_draft = input_message_text.clear_draft;
 
       if (is_bot && static_cast<int64>(utf8_length(input_message_text.text.text)) >
-                        G()->get_option_integer("message_text_length_max")) {
+                        G()->get_option_integer(OptionId::MessageTextLengthMax)) {
         return Status::Error(400, "Message is too long");
       }
 
@@ -2986,7 +2990,8 @@ Result<InputMessageContent> get_input_message_content(
   bool is_bot = td->auth_manager_->is_bot();
   TRY_RESULT(caption, get_formatted_text(td, dialog_id, extract_input_caption(input_message_content), is_bot, true,
                                          false, false));
-  if (is_bot && static_cast<int64>(utf8_length(caption.text)) > G()->get_option_integer("message_caption_length_max")) {
+  if (is_bot &&
+      static_cast<int64>(utf8_length(caption.text)) > G()->get_option_integer(OptionId::MessageCaptionLengthMax)) {
     return Status::Error(400, "Message caption is too long");
   }
   return create_input_message_content(
@@ -4457,7 +4462,7 @@ void merge_message_contents(Td *td, const MessageContent *old_content, MessageCo
         if (need_message_changed_warning && need_message_text_changed_warning(old_, new_) &&
             old_->text.entities.size() <= MAX_CUSTOM_ENTITIES_COUNT &&
             need_message_entities_changed_warning(old_->text.entities, new_->text.entities) &&
-            td->option_manager_->get_option_integer("session_count") <= 1) {
+            td->option_manager_->get_option_integer(OptionId::SessionCount) <= 1) {
           LOG(WARNING) << "Entities have changed for a message in " << dialog_id << " from "
                        << get_content_object(old_content) << " to " << get_content_object(new_content);
         }
@@ -6365,7 +6370,7 @@ unique_ptr<MessageContent> dup_message_content(Td *td, DialogId dialog_id, const
       }
     case MessageContentType::Sticker: {
       auto result = make_unique<MessageSticker>(*static_cast<const MessageSticker *>(content));
-      result->is_premium = td->option_manager_->get_option_boolean("is_premium");
+      result->is_premium = td->option_manager_->get_option_boolean(OptionId::IsPremium);
       if (td->stickers_manager_->has_input_media(result->file_id, to_secret)) {
         return std::move(result);
       }
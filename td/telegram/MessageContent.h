@@ -91,6 +91,8 @@ struct InlineMessageContent {
 
 void store_message_content(const MessageContent *content, LogEventStorerCalcLength &storer);
 
+void store_message_content(const MessageContent *content, LogEventStorerGrowable &storer);
+
 void store_message_content(const MessageContent *content, LogEventStorerUnsafe &storer);
 
 void parse_message_content(unique_ptr<MessageContent> &content, LogEventParser &parser);
@@ -6,7 +6,10 @@
 //
 #include "td/telegram/MessageDb.h"
 
+#include "td/telegram/DialogId.h"
 #include "td/telegram/logevent/LogEvent.h"
+#include "td/telegram/net/LatencyHistogram.h"
+#include "td/telegram/SecretChatId.h"
 #include "td/telegram/UserId.h"
 #include "td/telegram/Version.h"
 
@@ -15,10 +18,16 @@
 #include "td/db/SqliteStatement.h"
 
 #include "td/actor/actor.h"
+#include "td/actor/MultiPromise.h"
 #include "td/actor/SchedulerLocalStorage.h"
 
+#include "td/utils/algorithm.h"
+#include "td/utils/as.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -41,6 +50,52 @@ namespace td {
 static constexpr int32 MESSAGE_DB_INDEX_COUNT = 30;
 static constexpr int32 MESSAGE_DB_INDEX_COUNT_OLD = 9;
 
+// first 4 bytes of compressed message data; uncompressed message data starts with a small positive LogEvent version
+static constexpr int32 COMPRESSED_MESSAGE_DATA_MAGIC = static_cast<int32>(0xC0DEDA7A);
+static constexpr size_t COMPRESSED_MESSAGE_DATA_HEADER_SIZE = 8;
+static constexpr size_t MIN_COMPRESSED_MESSAGE_DATA_SIZE = 128;
+
+static bool is_compressed_message_data(Slice data) {
+  return data.size() >= COMPRESSED_MESSAGE_DATA_HEADER_SIZE && as<int32>(data.begin()) == COMPRESSED_MESSAGE_DATA_MAGIC;
+}
+
+int64 get_message_db_data_original_size(Slice data_prefix, int64 stored_size) {
+  if (!is_compressed_message_data(data_prefix)) {
+    return stored_size;
+  }
+  return as<int32>(data_prefix.begin() + 4);
+}
+
+static BufferSlice compress_message_data(Gzip &gzip, BufferSlice data) {
+  if (data.size() < MIN_COMPRESSED_MESSAGE_DATA_SIZE) {
+    return data;
+  }
+  auto compressed_data = gzencode(gzip, data.as_slice(), 0.9);
+  if (compressed_data.empty()) {
+    return data;
+  }
+  BufferSlice result(COMPRESSED_MESSAGE_DATA_HEADER_SIZE + compressed_data.size());
+  auto result_slice = result.as_mutable_slice();
+  as<int32>(result_slice.begin()) = COMPRESSED_MESSAGE_DATA_MAGIC;
+  as<int32>(result_slice.begin() + 4) = narrow_cast<int32>(data.size());
+  result_slice.substr(COMPRESSED_MESSAGE_DATA_HEADER_SIZE).copy_from(compressed_data.as_slice());
+  return result;
+}
+
+// a message with corrupted data must be treated as a missing one
+static Result<BufferSlice> decode_message_data(Slice data) {
+  if (!is_compressed_message_data(data)) {
+    return BufferSlice(data);
+  }
+  auto original_size = static_cast<size_t>(as<int32>(data.begin() + 4));
+  auto result = gzdecode(data.substr(COMPRESSED_MESSAGE_DATA_HEADER_SIZE));
+  if (result.size() == original_size) {
+    return std::move(result);
+  }
+  LOG(ERROR) << "Failed to decompress message data of size " << data.size() << " to size " << original_size;
+  return Status::Error("Corrupted message data");
+}
+
 // NB: must happen inside a transaction
 Status init_message_db(SqliteDb &db, int32 version) {
   LOG(INFO) << "Init message database " << tag("version", version);
@@ -71,20 +126,70 @@ Status init_message_db(SqliteDb &db, int32 version) {
     TRY_STATUS(
         db.exec("CREATE VIRTUAL TABLE IF NOT EXISTS messages_fts USING fts5(text, content='messages', "
                 "content_rowid='search_id', tokenize = \"unicode61 remove_diacritics 0 tokenchars '\a'\")"));
+
+    return Status::OK();
+  };
+  // new and edited messages are added to the full-text search index later in batches
+  auto add_deferred_fts = [&db] {
+    TRY_STATUS(db.exec("CREATE TABLE IF NOT EXISTS messages_fts_pending (search_id INTEGER PRIMARY KEY)"));
+
+    TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_fts_delete"));
+    TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_fts_insert"));
+    TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_fts_replace"));
+    // text of messages, which weren't indexed yet, must not be deleted from the index
     TRY_STATUS(db.exec(
         "CREATE TRIGGER IF NOT EXISTS trigger_fts_delete BEFORE DELETE ON messages WHEN OLD.search_id IS NOT NULL"
-        " BEGIN INSERT INTO messages_fts(messages_fts, rowid, text) VALUES(\'delete\', OLD.search_id, OLD.text); END"));
+        " BEGIN INSERT INTO messages_fts(messages_fts, rowid, text) SELECT \'delete\', OLD.search_id, OLD.text WHERE "
+        "NOT EXISTS (SELECT 1 FROM messages_fts_pending WHERE search_id = OLD.search_id); "
+        "DELETE FROM messages_fts_pending WHERE search_id = OLD.search_id; END"));
     TRY_STATUS(db.exec(
         "CREATE TRIGGER IF NOT EXISTS trigger_fts_insert AFTER INSERT ON messages WHEN NEW.search_id IS NOT NULL"
-        " BEGIN INSERT INTO messages_fts(rowid, text) VALUES(NEW.search_id, NEW.text); END"));
-    //TRY_STATUS(db.exec(
-    //"CREATE TRIGGER IF NOT EXISTS trigger_fts_update AFTER UPDATE ON messages WHEN NEW.search_id IS NOT NULL OR "
-    //"OLD.search_id IS NOT NULL"
-    //" BEGIN "
-    //"INSERT INTO messages_fts(messages_fts, rowid, text) VALUES(\'delete\', OLD.search_id, OLD.text); "
-    //"INSERT INTO messages_fts(rowid, text) VALUES(NEW.search_id, NEW.text); "
-    //" END"));
-
+        " BEGIN INSERT OR IGNORE INTO messages_fts_pending VALUES(NEW.search_id); END"));
+    // INSERT OR REPLACE doesn't run delete triggers, so the previous version of the message is deleted explicitly;
+    // the check uses the primary key, so inserts of new messages pay only for one index lookup
+    TRY_STATUS(db.exec(
+        "CREATE TRIGGER IF NOT EXISTS trigger_fts_replace BEFORE INSERT ON messages WHEN EXISTS (SELECT 1 FROM "
+        "messages WHERE dialog_id = NEW.dialog_id AND message_id = NEW.message_id) BEGIN DELETE FROM messages WHERE "
+        "dialog_id = NEW.dialog_id AND message_id = NEW.message_id; END"));
+    return Status::OK();
+  };
+  // number of messages in every media index of every secret chat is maintained by the triggers;
+  // other chats have only a part of their messages in the database, so their counters would be useless
+  auto add_index_counts = [&db](bool fill) {
+    auto is_secret_chat = [](Slice dialog_id) {
+      return PSTRING() << dialog_id << " BETWEEN "
+                       << DialogId(SecretChatId(std::numeric_limits<int32>::min())).get() << " AND "
+                       << DialogId(SecretChatId(std::numeric_limits<int32>::max())).get();
+    };
+    TRY_STATUS(db.exec("CREATE TABLE IF NOT EXISTS message_index_ids (index_id INTEGER PRIMARY KEY)"));
+    for (int i = 0; i < MESSAGE_DB_INDEX_COUNT; i++) {
+      TRY_STATUS(db.exec(PSLICE() << "INSERT OR IGNORE INTO message_index_ids VALUES(" << i << ")"));
+    }
+    TRY_STATUS(
+        db.exec("CREATE TABLE IF NOT EXISTS message_index_counts (dialog_id INT8, index_id INT4, message_count INT4, "
+                "PRIMARY KEY (dialog_id, index_id))"));
+    if (fill) {
+      TRY_STATUS(db.exec("DELETE FROM message_index_counts"));
+      TRY_STATUS(db.exec(PSLICE() << "INSERT INTO message_index_counts SELECT dialog_id, index_id, COUNT(*) FROM "
+                                     "messages JOIN message_index_ids ON ((index_mask >> index_id) & 1) != 0 WHERE "
+                                     "index_mask IS NOT NULL AND "
+                                  << is_secret_chat("dialog_id") << " GROUP BY dialog_id, index_id"));
+    }
+    TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_index_counts_insert"));
+    TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_index_counts_delete"));
+    TRY_STATUS(db.exec(PSLICE() << "CREATE TRIGGER trigger_index_counts_insert AFTER INSERT ON messages WHEN "
+                                   "NEW.index_mask IS NOT NULL AND "
+                                << is_secret_chat("NEW.dialog_id")
+                                << " BEGIN INSERT INTO message_index_counts SELECT NEW.dialog_id, index_id, 1 FROM "
+                                   "message_index_ids WHERE ((NEW.index_mask >> index_id) & 1) != 0 ON "
+                                   "CONFLICT(dialog_id, index_id) DO UPDATE SET message_count = message_count + 1; "
+                                   "END"));
+    // the previous version of a replaced message is deleted by trigger_fts_replace, which runs the delete trigger
+    TRY_STATUS(db.exec(PSLICE() << "CREATE TRIGGER trigger_index_counts_delete AFTER DELETE ON messages WHEN "
+                                   "OLD.index_mask IS NOT NULL AND "
+                                << is_secret_chat("OLD.dialog_id")
+                                << " BEGIN UPDATE message_index_counts SET message_count = message_count - 1 WHERE "
+                                   "dialog_id = OLD.dialog_id AND ((OLD.index_mask >> index_id) & 1) != 0; END"));
     return Status::OK();
   };
   auto add_call_index = [&db] {
@@ -134,6 +239,10 @@ Status init_message_db(SqliteDb &db, int32 version) {
 
     TRY_STATUS(add_fts());
 
+    TRY_STATUS(add_deferred_fts());
+
+    TRY_STATUS(add_index_counts(false));
+
     TRY_STATUS(add_call_index());
 
     TRY_STATUS(add_notification_id_index());
@@ -167,6 +276,12 @@ Status init_message_db(SqliteDb &db, int32 version) {
   if (version < static_cast<int32>(DbVersion::AddMessageThreadSupport)) {
     TRY_STATUS(db.exec("ALTER TABLE messages ADD COLUMN top_thread_message_id INT8"));
   }
+  if (version < static_cast<int32>(DbVersion::AddMessageDbDeferredFts)) {
+    TRY_STATUS(add_deferred_fts());
+  }
+  if (version < static_cast<int32>(DbVersion::AddMessageDbIndexCounts)) {
+    TRY_STATUS(add_index_counts(true));
+  }
   return Status::OK();
 }
 
@@ -174,6 +289,14 @@ Status init_message_db(SqliteDb &db, int32 version) {
 Status drop_message_db(SqliteDb &db, int32 version) {
   LOG(WARNING) << "Drop message database " << tag("version", version)
                << tag("current_db_version", current_db_version());
+  TRY_STATUS(db.exec("DROP TABLE IF EXISTS message_index_counts"));
+  TRY_STATUS(db.exec("DROP TABLE IF EXISTS message_index_ids"));
+  TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_fts_delete"));
+  TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_fts_insert"));
+  TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_fts_replace"));
+  TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_index_counts_insert"));
+  TRY_STATUS(db.exec("DROP TRIGGER IF EXISTS trigger_index_counts_delete"));
+  TRY_STATUS(db.exec("DROP TABLE IF EXISTS messages_fts_pending"));
   return db.exec("DROP TABLE IF EXISTS messages");
 }
 
@@ -204,6 +327,10 @@ class MessageDbImpl final : public MessageDbSyncInterface {
         get_message_by_unique_message_id_stmt_,
         db_.get_statement("SELECT dialog_id, message_id, data FROM messages WHERE unique_message_id = ?1"));
 
+    TRY_RESULT_ASSIGN(get_dialog_message_count_stmt_,
+                      db_.get_statement("SELECT message_count FROM message_index_counts WHERE dialog_id = ?1 AND "
+                                        "index_id = ?2"));
+
     TRY_RESULT_ASSIGN(
         get_expiring_messages_stmt_,
         db_.get_statement("SELECT dialog_id, message_id, data FROM messages WHERE ttl_expires_at <= ?1 LIMIT ?2"));
@@ -224,6 +351,17 @@ class MessageDbImpl final : public MessageDbSyncInterface {
                       db_.get_statement("SELECT dialog_id, message_id, data, search_id FROM messages WHERE search_id "
                                         "IN (SELECT rowid FROM messages_fts WHERE messages_fts MATCH ?1 AND rowid < ?2 "
                                         "ORDER BY rowid DESC LIMIT ?3) ORDER BY search_id DESC"));
+    TRY_RESULT_ASSIGN(get_pending_fts_batch_stmt_,
+                      db_.get_statement("SELECT MAX(search_id), COUNT(*) FROM (SELECT search_id FROM "
+                                        "messages_fts_pending ORDER BY search_id LIMIT ?1)"));
+    TRY_RESULT_ASSIGN(index_pending_fts_stmt_,
+                      db_.get_statement("INSERT INTO messages_fts(rowid, text) SELECT messages.search_id, "
+                                        "messages.text FROM messages_fts_pending JOIN messages ON messages.search_id = "
+                                        "messages_fts_pending.search_id WHERE messages_fts_pending.search_id <= ?1"));
+    TRY_RESULT_ASSIGN(delete_pending_fts_stmt_,
+                      db_.get_statement("DELETE FROM messages_fts_pending WHERE search_id <= ?1"));
+    TRY_RESULT_ASSIGN(merge_fts_stmt_,
+                      db_.get_statement("INSERT INTO messages_fts(messages_fts, rank) VALUES('merge', ?1)"));
 
     for (int32 i = 0; i < MESSAGE_DB_INDEX_COUNT; i++) {
       TRY_RESULT_ASSIGN(
@@ -463,16 +601,58 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       return Status::Error("Not found");
     }
     MessageId received_message_id(stmt.view_int64(0));
-    Slice data = stmt.view_blob(1);
+    TRY_RESULT(data, decode_message_data(stmt.view_blob(1)));
     if (is_scheduled_server) {
       CHECK(received_message_id.is_scheduled());
       CHECK(received_message_id.is_scheduled_server());
       CHECK(received_message_id.get_scheduled_server_message_id() == message_id.get_scheduled_server_message_id());
     } else {
       LOG_CHECK(received_message_id == message_id)
-          << received_message_id << ' ' << message_id << ' ' << get_message_info(received_message_id, data, true).first;
+          << received_message_id << ' ' << message_id << ' '
+          << get_message_info(received_message_id, data.as_slice(), true).first;
+    }
+    return MessageDbDialogMessage{received_message_id, std::move(data)};
+  }
+
+  vector<MessageDbDialogMessage> get_dialog_messages(DialogId dialog_id, const vector<MessageId> &message_ids) final {
+    CHECK(dialog_id.is_valid());
+    CHECK(!message_ids.empty());
+    CHECK(message_ids.size() <= MAX_GET_DIALOG_MESSAGES_COUNT);
+    auto &stmt = get_dialog_messages_stmts_[message_ids.size() - 1];
+    if (stmt.empty()) {
+      // statements are prepared on demand for each number of requested messages
+      string placeholders;
+      for (size_t i = 0; i < message_ids.size(); i++) {
+        if (i != 0) {
+          placeholders += ", ";
+        }
+        placeholders += PSTRING() << '?' << i + 2;
+      }
+      stmt = db_.get_statement(PSLICE() << "SELECT message_id, data FROM messages WHERE dialog_id = ?1 AND message_id "
+                                           "IN ("
+                                        << placeholders << ')')
+                 .move_as_ok();
+    }
+    SCOPE_EXIT {
+      stmt.reset();
+    };
+
+    stmt.bind_int64(1, dialog_id.get()).ensure();
+    for (size_t i = 0; i < message_ids.size(); i++) {
+      CHECK(message_ids[i].is_valid());
+      stmt.bind_int64(static_cast<int>(i + 2), message_ids[i].get()).ensure();
+    }
+    vector<MessageDbDialogMessage> result;
+    stmt.step().ensure();
+    while (stmt.has_row()) {
+      MessageId message_id(stmt.view_int64(0));
+      auto r_data = decode_message_data(stmt.view_blob(1));
+      if (r_data.is_ok()) {
+        result.push_back(MessageDbDialogMessage{message_id, r_data.move_as_ok()});
+      }
+      stmt.step().ensure();
     }
-    return MessageDbDialogMessage{received_message_id, BufferSlice(data)};
+    return result;
   }
 
   Result<MessageDbMessage> get_message_by_unique_message_id(ServerMessageId unique_message_id) final {
@@ -489,7 +669,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     }
     DialogId dialog_id(get_message_by_unique_message_id_stmt_.view_int64(0));
     MessageId message_id(get_message_by_unique_message_id_stmt_.view_int64(1));
-    return MessageDbMessage{dialog_id, message_id, BufferSlice(get_message_by_unique_message_id_stmt_.view_blob(2))};
+    TRY_RESULT(data, decode_message_data(get_message_by_unique_message_id_stmt_.view_blob(2)));
+    return MessageDbMessage{dialog_id, message_id, std::move(data)};
   }
 
   Result<MessageDbDialogMessage> get_message_by_random_id(DialogId dialog_id, int64 random_id) final {
@@ -503,7 +684,8 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       return Status::Error("Not found");
     }
     MessageId message_id(get_message_by_random_id_stmt_.view_int64(0));
-    return MessageDbDialogMessage{message_id, BufferSlice(get_message_by_random_id_stmt_.view_blob(1))};
+    TRY_RESULT(data, decode_message_data(get_message_by_random_id_stmt_.view_blob(1)));
+    return MessageDbDialogMessage{message_id, std::move(data)};
   }
 
   Result<MessageDbDialogMessage> get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id,
@@ -581,14 +763,30 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (get_expiring_messages_stmt_.has_row()) {
       DialogId dialog_id(get_expiring_messages_stmt_.view_int64(0));
       MessageId message_id(get_expiring_messages_stmt_.view_int64(1));
-      BufferSlice data(get_expiring_messages_stmt_.view_blob(2));
-      messages.push_back(MessageDbMessage{dialog_id, message_id, std::move(data)});
+      auto r_data = decode_message_data(get_expiring_messages_stmt_.view_blob(2));
+      if (r_data.is_ok()) {
+        messages.push_back(MessageDbMessage{dialog_id, message_id, r_data.move_as_ok()});
+      }
       get_expiring_messages_stmt_.step().ensure();
     }
 
     return messages;
   }
 
+  int32 get_dialog_message_count(DialogId dialog_id, MessageSearchFilter filter) final {
+    auto &stmt = get_dialog_message_count_stmt_;
+    SCOPE_EXIT {
+      stmt.reset();
+    };
+    stmt.bind_int64(1, dialog_id.get()).ensure();
+    stmt.bind_int32(2, message_search_filter_index(filter)).ensure();
+    stmt.step().ensure();
+    if (!stmt.has_row()) {
+      return 0;
+    }
+    return max(stmt.view_int32(0), 0);
+  }
+
   MessageDbCalendar get_dialog_message_calendar(MessageDbDialogCalendarQuery query) final {
     auto &stmt = get_messages_from_index_stmts_[message_search_filter_index(query.filter)].desc_stmt_;
     SCOPE_EXIT {
@@ -604,16 +802,21 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     stmt.step().ensure();
     int32 current_day = std::numeric_limits<int32>::max();
     while (stmt.has_row()) {
-      auto data_slice = stmt.view_blob(0);
+      auto r_data = decode_message_data(stmt.view_blob(0));
       MessageId message_id(stmt.view_int64(1));
-      auto info = get_message_info(message_id, data_slice, false);
+      if (r_data.is_error()) {
+        stmt.step().ensure();
+        continue;
+      }
+      auto data = r_data.move_as_ok();
+      auto info = get_message_info(message_id, data.as_slice(), false);
       auto day = (query.tz_offset + info.second) / 86400;
       if (day >= current_day) {
         CHECK(!total_counts.empty());
         total_counts.back()++;
       } else {
         current_day = day;
-        messages.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+        messages.push_back(MessageDbDialogMessage{message_id, std::move(data)});
         total_counts.push_back(1);
       }
       stmt.step().ensure();
@@ -681,7 +884,10 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (stmt.has_row()) {
       auto data_slice = stmt.view_blob(0);
       MessageId message_id(stmt.view_int64(1));
-      result.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+      auto r_data = decode_message_data(data_slice);
+      if (r_data.is_ok()) {
+        result.push_back(MessageDbDialogMessage{message_id, r_data.move_as_ok()});
+      }
       LOG(INFO) << "Load " << message_id << " in " << dialog_id << " from database";
       stmt.step().ensure();
     }
@@ -774,7 +980,10 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       auto data_slice = stmt.view_blob(2);
       auto search_id = stmt.view_int64(3);
       result.next_search_id = search_id;
-      result.messages.push_back(MessageDbMessage{dialog_id, message_id, BufferSlice(data_slice)});
+      auto r_data = decode_message_data(data_slice);
+      if (r_data.is_ok()) {
+        result.messages.push_back(MessageDbMessage{dialog_id, message_id, r_data.move_as_ok()});
+      }
       stmt.step().ensure();
     }
     return result;
@@ -810,12 +1019,49 @@ class MessageDbImpl final : public MessageDbSyncInterface {
       DialogId dialog_id(stmt.view_int64(0));
       MessageId message_id(stmt.view_int64(1));
       auto data_slice = stmt.view_blob(2);
-      result.messages.push_back(MessageDbMessage{dialog_id, message_id, BufferSlice(data_slice)});
+      auto r_data = decode_message_data(data_slice);
+      if (r_data.is_ok()) {
+        result.messages.push_back(MessageDbMessage{dialog_id, message_id, r_data.move_as_ok()});
+      }
       stmt.step().ensure();
     }
     return result;
   }
 
+  int32 index_pending_messages_fts(int32 limit) final {
+    SCOPE_EXIT {
+      get_pending_fts_batch_stmt_.reset();
+      index_pending_fts_stmt_.reset();
+      delete_pending_fts_stmt_.reset();
+    };
+    get_pending_fts_batch_stmt_.bind_int32(1, limit).ensure();
+    get_pending_fts_batch_stmt_.step().ensure();
+    CHECK(get_pending_fts_batch_stmt_.has_row());
+    auto count = get_pending_fts_batch_stmt_.view_int32(1);
+    if (count == 0) {
+      return 0;
+    }
+    auto max_search_id = get_pending_fts_batch_stmt_.view_int64(0);
+
+    index_pending_fts_stmt_.bind_int64(1, max_search_id).ensure();
+    index_pending_fts_stmt_.step().ensure();
+    delete_pending_fts_stmt_.bind_int64(1, max_search_id).ensure();
+    delete_pending_fts_stmt_.step().ensure();
+    LOG(INFO) << "Added " << count << " messages to the full-text search index";
+    return count;
+  }
+
+  void merge_messages_fts(int32 page_count) final {
+    SCOPE_EXIT {
+      merge_fts_stmt_.reset();
+    };
+    merge_fts_stmt_.bind_int32(1, page_count).ensure();
+    auto status = merge_fts_stmt_.step();
+    if (status.is_error()) {
+      LOG(ERROR) << status;
+    }
+  }
+
   Status begin_write_transaction() final {
     return db_.begin_write_transaction();
   }
@@ -833,8 +1079,10 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   SqliteStatement delete_dialog_messages_by_sender_stmt_;
 
   SqliteStatement get_message_stmt_;
+  std::array<SqliteStatement, MAX_GET_DIALOG_MESSAGES_COUNT> get_dialog_messages_stmts_;
   SqliteStatement get_message_by_random_id_stmt_;
   SqliteStatement get_message_by_unique_message_id_stmt_;
+  SqliteStatement get_dialog_message_count_stmt_;
   SqliteStatement get_expiring_messages_stmt_;
 
   struct GetMessagesStmt {
@@ -850,6 +1098,10 @@ class MessageDbImpl final : public MessageDbSyncInterface {
   std::array<SqliteStatement, 2> get_calls_stmts_;
 
   SqliteStatement get_messages_fts_stmt_;
+  SqliteStatement get_pending_fts_batch_stmt_;
+  SqliteStatement index_pending_fts_stmt_;
+  SqliteStatement delete_pending_fts_stmt_;
+  SqliteStatement merge_fts_stmt_;
 
   SqliteStatement add_scheduled_message_stmt_;
   SqliteStatement get_scheduled_message_stmt_;
@@ -925,7 +1177,10 @@ class MessageDbImpl final : public MessageDbSyncInterface {
     while (stmt.has_row()) {
       auto data_slice = stmt.view_blob(0);
       MessageId message_id(stmt.view_int64(1));
-      result.push_back(MessageDbDialogMessage{message_id, BufferSlice(data_slice)});
+      auto r_data = decode_message_data(data_slice);
+      if (r_data.is_ok()) {
+        result.push_back(MessageDbDialogMessage{message_id, r_data.move_as_ok()});
+      }
       LOG(INFO) << "Loaded " << message_id << " in " << dialog_id << " from database";
       stmt.step().ensure();
     }
@@ -984,8 +1239,10 @@ std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
 
 class MessageDbAsync final : public MessageDbAsyncInterface {
  public:
-  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id) {
-    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db));
+  MessageDbAsync(std::shared_ptr<MessageDbSyncSafeInterface> sync_db, int32 scheduler_id,
+                 vector<int32> read_scheduler_ids) {
+    impl_ = create_actor_on_scheduler<Impl>("MessageDbActor", scheduler_id, std::move(sync_db),
+                                            std::move(read_scheduler_ids));
   }
 
   void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
@@ -1025,6 +1282,10 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
                        std::move(promise));
   }
 
+  void get_dialog_message_count(DialogId dialog_id, MessageSearchFilter filter, Promise<int32> promise) final {
+    send_closure_later(impl_, &Impl::get_dialog_message_count, dialog_id, filter, std::move(promise));
+  }
+
   void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) final {
     send_closure_later(impl_, &Impl::get_dialog_message_calendar, std::move(query), std::move(promise));
   }
@@ -1063,10 +1324,80 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     send_closure_later(impl_, &Impl::force_flush);
   }
 
+  void set_use_compression(bool use_compression) final {
+    send_closure_later(impl_, &Impl::set_use_compression, use_compression);
+  }
+
  private:
+  class Impl;
+
+  // executes heavy read queries using SQLite connection of the scheduler, on which it was created
+  // the database is in WAL mode, so the queries don't block writes and reads of other readers
+  class Reader final : public Actor {
+   public:
+    Reader(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe, ActorId<Impl> parent)
+        : sync_db_safe_(std::move(sync_db_safe)), parent_(std::move(parent)) {
+    }
+
+    void get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id, MessageId last_message_id,
+                                    int32 date, Promise<MessageDbDialogMessage> promise) {
+      run_query("get_dialog_message_by_date", std::move(promise), [&] {
+        return sync_db_->get_dialog_message_by_date(dialog_id, first_message_id, last_message_id, date);
+      });
+    }
+
+    void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) {
+      run_query("get_dialog_message_calendar", std::move(promise),
+                [&] { return sync_db_->get_dialog_message_calendar(std::move(query)); });
+    }
+
+    void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
+                                             Promise<MessageDbMessagePositions> promise) {
+      run_query("get_dialog_sparse_message_positions", std::move(promise),
+                [&] { return sync_db_->get_dialog_sparse_message_positions(std::move(query)); });
+    }
+
+    void get_messages(MessageDbMessagesQuery query, Promise<vector<MessageDbDialogMessage>> promise) {
+      run_query("get_messages", std::move(promise), [&] { return sync_db_->get_messages(std::move(query)); });
+    }
+
+    void get_calls(MessageDbCallsQuery query, Promise<MessageDbCallsResult> promise) {
+      run_query("get_calls", std::move(promise), [&] { return sync_db_->get_calls(std::move(query)); });
+    }
+
+    void get_messages_fts(MessageDbFtsQuery query, Promise<MessageDbFtsResult> promise) {
+      run_query("get_messages_fts", std::move(promise), [&] { return sync_db_->get_messages_fts(std::move(query)); });
+    }
+
+    void close(Promise<> promise) {
+      sync_db_safe_.reset();
+      sync_db_ = nullptr;
+      promise.set_value(Unit());
+      stop();
+    }
+
+   private:
+    std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe_;
+    MessageDbSyncInterface *sync_db_ = nullptr;
+    ActorId<Impl> parent_;
+
+    template <class T, class F>
+    void run_query(Slice name, Promise<T> promise, F &&f) {
+      auto start_time = Time::now();
+      auto result = f();
+      send_closure(parent_, &Impl::on_query_finished, name, Time::now() - start_time);
+      promise.set_result(std::move(result));
+    }
+
+    void start_up() final {
+      sync_db_ = &sync_db_safe_->get();
+    }
+  };
+
   class Impl final : public Actor {
    public:
-    explicit Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe) : sync_db_safe_(std::move(sync_db_safe)) {
+    Impl(std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe, vector<int32> read_scheduler_ids)
+        : sync_db_safe_(std::move(sync_db_safe)), read_scheduler_ids_(std::move(read_scheduler_ids)) {
     }
     void add_message(MessageFullId message_full_id, ServerMessageId unique_message_id, DialogId sender_dialog_id,
                      int64 random_id, int32 ttl_expires_at, int32 index_mask, int64 search_id, string text,
@@ -1077,13 +1408,16 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
                        data = std::move(data), promise = std::move(promise)](Unit) mutable {
         sync_db_->add_message(message_full_id, unique_message_id, sender_dialog_id, random_id, ttl_expires_at,
                               index_mask, search_id, std::move(text), notification_id, top_thread_message_id,
-                              std::move(data));
+                              maybe_compress_message_data(std::move(data)));
         on_write_result(std::move(promise));
       });
+      if (search_id != 0) {
+        schedule_fts_indexing();
+      }
     }
     void add_scheduled_message(MessageFullId message_full_id, BufferSlice data, Promise<> promise) {
       add_write_query([this, message_full_id, promise = std::move(promise), data = std::move(data)](Unit) mutable {
-        sync_db_->add_scheduled_message(message_full_id, std::move(data));
+        sync_db_->add_scheduled_message(message_full_id, maybe_compress_message_data(std::move(data)));
         on_write_result(std::move(promise));
       });
     }
@@ -1113,87 +1447,254 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
     }
 
     void get_message(MessageFullId message_full_id, Promise<MessageDbDialogMessage> promise) {
-      add_read_query();
-      promise.set_result(sync_db_->get_message(message_full_id));
+      if (message_full_id.get_message_id().is_scheduled()) {
+        add_read_query();
+        return promise.set_result(measure_query("get_message", [&] { return sync_db_->get_message(message_full_id); }));
+      }
+
+      // concurrent requests for messages are answered by few queries after all already received requests are handled
+      if (pending_message_reads_.empty()) {
+        send_closure_later(actor_id(this), &Impl::process_pending_message_reads);
+      }
+      pending_message_reads_.emplace_back(message_full_id, std::move(promise));
     }
     void get_message_by_unique_message_id(ServerMessageId unique_message_id, Promise<MessageDbMessage> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_message_by_unique_message_id(unique_message_id));
+      promise.set_result(measure_query("get_message_by_unique_message_id", [&] {
+        return sync_db_->get_message_by_unique_message_id(unique_message_id);
+      }));
     }
     void get_message_by_random_id(DialogId dialog_id, int64 random_id, Promise<MessageDbDialogMessage> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_message_by_random_id(dialog_id, random_id));
+      promise.set_result(measure_query("get_message_by_random_id",
+                                       [&] { return sync_db_->get_message_by_random_id(dialog_id, random_id); }));
     }
     void get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id, MessageId last_message_id,
                                     int32 date, Promise<MessageDbDialogMessage> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_dialog_message_by_date(dialog_id, first_message_id, last_message_id, date));
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_dialog_message_by_date, dialog_id, first_message_id,
+                            last_message_id, date, std::move(promise));
+      }
+      promise.set_result(measure_query("get_dialog_message_by_date", [&] {
+        return sync_db_->get_dialog_message_by_date(dialog_id, first_message_id, last_message_id, date);
+      }));
+    }
+
+    void get_dialog_message_count(DialogId dialog_id, MessageSearchFilter filter, Promise<int32> promise) {
+      add_read_query();
+      promise.set_value(measure_query("get_dialog_message_count",
+                                      [&] { return sync_db_->get_dialog_message_count(dialog_id, filter); }));
     }
 
     void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_dialog_message_calendar(std::move(query)));
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_dialog_message_calendar, std::move(query), std::move(promise));
+      }
+      promise.set_value(measure_query("get_dialog_message_calendar",
+                                      [&] { return sync_db_->get_dialog_message_calendar(std::move(query)); }));
     }
 
     void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
                                              Promise<MessageDbMessagePositions> promise) {
       add_read_query();
-      promise.set_result(sync_db_->get_dialog_sparse_message_positions(std::move(query)));
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_dialog_sparse_message_positions, std::move(query),
+                            std::move(promise));
+      }
+      promise.set_result(measure_query("get_dialog_sparse_message_positions", [&] {
+        return sync_db_->get_dialog_sparse_message_positions(std::move(query));
+      }));
     }
 
     void get_messages(MessageDbMessagesQuery query, Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_messages(std::move(query)));
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_messages, std::move(query), std::move(promise));
+      }
+      promise.set_value(measure_query("get_messages", [&] { return sync_db_->get_messages(std::move(query)); }));
     }
     void get_scheduled_messages(DialogId dialog_id, int32 limit, Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_scheduled_messages(dialog_id, limit));
+      promise.set_value(measure_query("get_scheduled_messages",
+                                      [&] { return sync_db_->get_scheduled_messages(dialog_id, limit); }));
     }
     void get_messages_from_notification_id(DialogId dialog_id, NotificationId from_notification_id, int32 limit,
                                            Promise<vector<MessageDbDialogMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_messages_from_notification_id(dialog_id, from_notification_id, limit));
+      promise.set_value(measure_query("get_messages_from_notification_id", [&] {
+        return sync_db_->get_messages_from_notification_id(dialog_id, from_notification_id, limit);
+      }));
     }
     void get_calls(MessageDbCallsQuery query, Promise<MessageDbCallsResult> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_calls(std::move(query)));
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_calls, std::move(query), std::move(promise));
+      }
+      promise.set_value(measure_query("get_calls", [&] { return sync_db_->get_calls(std::move(query)); }));
     }
     void get_messages_fts(MessageDbFtsQuery query, Promise<MessageDbFtsResult> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_messages_fts(std::move(query)));
+      if (!readers_.empty()) {
+        return send_closure(get_reader(), &Reader::get_messages_fts, std::move(query), std::move(promise));
+      }
+      promise.set_value(
+          measure_query("get_messages_fts", [&] { return sync_db_->get_messages_fts(std::move(query)); }));
     }
     void get_expiring_messages(int32 expires_till, int32 limit, Promise<vector<MessageDbMessage>> promise) {
       add_read_query();
-      promise.set_value(sync_db_->get_expiring_messages(expires_till, limit));
+      promise.set_value(measure_query("get_expiring_messages",
+                                      [&] { return sync_db_->get_expiring_messages(expires_till, limit); }));
+    }
+
+    void on_query_finished(Slice name, double duration) {
+      query_latencies_[name].add(duration);
+
+      auto now = Time::now_cached();
+      if (next_query_statistics_log_time_ == 0.0) {
+        next_query_statistics_log_time_ = now + QUERY_STATISTICS_LOG_PERIOD;
+      } else if (now >= next_query_statistics_log_time_) {
+        next_query_statistics_log_time_ = now + QUERY_STATISTICS_LOG_PERIOD;
+        for (auto &it : query_latencies_) {
+          LOG(INFO) << "Latency of MessageDb " << it.first << tag("count", it.second.total_count)
+                    << " p50/p90/p99 in ms: " << it.second.get_percentile(0.5) << '/' << it.second.get_percentile(0.9)
+                    << '/' << it.second.get_percentile(0.99);
+        }
+      }
     }
 
     void close(Promise<> promise) {
+      process_pending_message_reads();
       do_flush();
+
+      // the connection must not be closed while readers are still using it
+      MultiPromiseActorSafe mpas{"MessageDbCloseMultiPromiseActor"};
+      mpas.add_promise(std::move(promise));
+      auto lock = mpas.get_promise();
+      for (auto &reader : readers_) {
+        send_closure(std::move(reader), &Reader::close, mpas.get_promise());
+      }
+      readers_.clear();
       sync_db_safe_.reset();
       sync_db_ = nullptr;
-      promise.set_value(Unit());
+      lock.set_value(Unit());
       stop();
     }
 
     void force_flush() {
+      process_pending_message_reads();
       do_flush();
       LOG(INFO) << "MessageDb flushed";
     }
 
+    void set_use_compression(bool use_compression) {
+      use_compression_ = use_compression;
+    }
+
    private:
     std::shared_ptr<MessageDbSyncSafeInterface> sync_db_safe_;
     MessageDbSyncInterface *sync_db_ = nullptr;
 
+    vector<int32> read_scheduler_ids_;
+    vector<ActorOwn<Reader>> readers_;
+    size_t next_reader_ = 0;
+
     static constexpr size_t MAX_PENDING_QUERIES_COUNT{50};
     static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
 
+    static constexpr double QUERY_STATISTICS_LOG_PERIOD{300.0};
+
+    static constexpr double FTS_INDEX_DELAY{1.0};
+    static constexpr int32 FTS_INDEX_BATCH_SIZE{1000};
+    static constexpr int32 FTS_MERGE_PAGE_COUNT{500};
+
     //NB: order is important, destructor of pending_writes_ will change finished_writes_
     vector<Promise<Unit>> finished_writes_;
     vector<Promise<Unit>> pending_writes_;  // TODO use Action
     double wakeup_at_ = 0;
 
+    vector<std::pair<MessageFullId, Promise<MessageDbDialogMessage>>> pending_message_reads_;
+
+    FlatHashMap<Slice, LatencyHistogram, SliceHash> query_latencies_;
+    double next_query_statistics_log_time_ = 0.0;
+
+    double fts_index_at_ = 0;
+    bool need_fts_merge_ = false;
+
+    bool use_compression_ = false;
+    Gzip gzip_;
+
+    BufferSlice maybe_compress_message_data(BufferSlice data) {
+      if (!use_compression_) {
+        return data;
+      }
+      return compress_message_data(gzip_, std::move(data));
+    }
+
+    template <class F>
+    auto measure_query(Slice name, F &&f) -> decltype(f()) {
+      auto start_time = Time::now();
+      auto result = f();
+      on_query_finished(name, Time::now() - start_time);
+      return result;
+    }
+
+    void process_pending_message_reads() {
+      if (pending_message_reads_.empty()) {
+        return;
+      }
+      auto reads = std::move(pending_message_reads_);
+      pending_message_reads_.clear();
+      do_flush();
+
+      std::stable_sort(reads.begin(), reads.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.first.get_dialog_id().get() < rhs.first.get_dialog_id().get();
+      });
+      for (size_t begin_pos = 0; begin_pos < reads.size();) {
+        auto dialog_id = reads[begin_pos].first.get_dialog_id();
+        size_t end_pos = begin_pos;
+        vector<MessageId> message_ids;
+        while (end_pos < reads.size() && reads[end_pos].first.get_dialog_id() == dialog_id) {
+          auto message_id = reads[end_pos].first.get_message_id();
+          if (!td::contains(message_ids, message_id)) {
+            if (message_ids.size() == MessageDbSyncInterface::MAX_GET_DIALOG_MESSAGES_COUNT) {
+              break;
+            }
+            message_ids.push_back(message_id);
+          }
+          end_pos++;
+        }
+
+        vector<MessageDbDialogMessage> messages;
+        if (message_ids.size() == 1) {
+          auto r_message =
+              measure_query("get_message", [&] { return sync_db_->get_message({dialog_id, message_ids[0]}); });
+          if (r_message.is_ok()) {
+            messages.push_back(r_message.move_as_ok());
+          }
+        } else {
+          messages = measure_query("get_dialog_messages",
+                                   [&] { return sync_db_->get_dialog_messages(dialog_id, message_ids); });
+        }
+
+        for (; begin_pos < end_pos; begin_pos++) {
+          auto message_id = reads[begin_pos].first.get_message_id();
+          auto it = std::find_if(messages.begin(), messages.end(), [message_id](const MessageDbDialogMessage &message) {
+            return message.message_id == message_id;
+          });
+          if (it == messages.end()) {
+            reads[begin_pos].second.set_error(Status::Error("Not found"));
+          } else {
+            reads[begin_pos].second.set_value(MessageDbDialogMessage{message_id, it->data.clone()});
+          }
+        }
+      }
+    }
+
     template <class F>
     void add_write_query(F &&f) {
+      process_pending_message_reads();
       pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
       if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
         do_flush();
@@ -1206,32 +1707,89 @@ class MessageDbAsync final : public MessageDbAsyncInterface {
       }
     }
     void add_read_query() {
+      process_pending_message_reads();
       do_flush();
     }
     void do_flush() {
       if (pending_writes_.empty()) {
         return;
       }
+      auto start_time = Time::now();
       sync_db_->begin_write_transaction().ensure();
       set_promises(pending_writes_);
       sync_db_->commit_transaction().ensure();
+      on_query_finished("write_transaction", Time::now() - start_time);
       set_promises(finished_writes_);
       cancel_timeout();
+      if (fts_index_at_ != 0) {
+        set_timeout_at(fts_index_at_);
+      }
     }
     void timeout_expired() final {
       do_flush();
+      if (fts_index_at_ != 0 && Time::now() >= fts_index_at_) {
+        index_pending_messages_fts();
+      }
+    }
+
+    void schedule_fts_indexing() {
+      if (fts_index_at_ != 0) {
+        return;
+      }
+      fts_index_at_ = Time::now() + FTS_INDEX_DELAY;
+      if (pending_writes_.empty()) {
+        set_timeout_at(fts_index_at_);
+      }
+      // otherwise, the timeout will be set after the pending writes are flushed
+    }
+
+    void index_pending_messages_fts() {
+      fts_index_at_ = 0;
+      auto start_time = Time::now();
+      sync_db_->begin_write_transaction().ensure();
+      auto count = sync_db_->index_pending_messages_fts(FTS_INDEX_BATCH_SIZE);
+      if (count > 0) {
+        need_fts_merge_ = true;
+      }
+      bool is_finished = count < FTS_INDEX_BATCH_SIZE;
+      if (is_finished && need_fts_merge_) {
+        // merge new index segments only after all pending messages were indexed
+        sync_db_->merge_messages_fts(FTS_MERGE_PAGE_COUNT);
+        need_fts_merge_ = false;
+      }
+      sync_db_->commit_transaction().ensure();
+      on_query_finished("index_fts", Time::now() - start_time);
+
+      if (!is_finished) {
+        // index the next batch after other queries are handled
+        fts_index_at_ = Time::now();
+        set_timeout_at(fts_index_at_);
+      }
+    }
+
+    ActorId<Reader> get_reader() {
+      CHECK(!readers_.empty());
+      next_reader_ = (next_reader_ + 1) % readers_.size();
+      return readers_[next_reader_].get();
     }
 
     void start_up() final {
       sync_db_ = &sync_db_safe_->get();
+      for (auto scheduler_id : read_scheduler_ids_) {
+        readers_.push_back(
+            create_actor_on_scheduler<Reader>("MessageDbReader", scheduler_id, sync_db_safe_, actor_id(this)));
+      }
+
+      // index messages, which were left unindexed after the previous run
+      schedule_fts_indexing();
     }
   };
   ActorOwn<Impl> impl_;
 };
 
 std::shared_ptr<MessageDbAsyncInterface> create_message_db_async(std::shared_ptr<MessageDbSyncSafeInterface> sync_db,
-                                                                 int32 scheduler_id) {
-  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id);
+                                                                 int32 scheduler_id, vector<int32> read_scheduler_ids) {
+  return std::make_shared<MessageDbAsync>(std::move(sync_db), scheduler_id, std::move(read_scheduler_ids));
 }
 
 }  // namespace td
@@ -16,6 +16,7 @@
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
 #include <memory>
@@ -99,6 +100,8 @@ struct MessageDbCallsResult {
 
 class MessageDbSyncInterface {
  public:
+  static constexpr size_t MAX_GET_DIALOG_MESSAGES_COUNT = 32;
+
   MessageDbSyncInterface() = default;
   MessageDbSyncInterface(const MessageDbSyncInterface &) = delete;
   MessageDbSyncInterface &operator=(const MessageDbSyncInterface &) = delete;
@@ -114,11 +117,17 @@ class MessageDbSyncInterface {
   virtual void delete_dialog_messages_by_sender(DialogId dialog_id, DialogId sender_dialog_id) = 0;
 
   virtual Result<MessageDbDialogMessage> get_message(MessageFullId message_full_id) = 0;
+  // returns found non-scheduled messages in an unspecified order
+  virtual vector<MessageDbDialogMessage> get_dialog_messages(DialogId dialog_id,
+                                                             const vector<MessageId> &message_ids) = 0;
   virtual Result<MessageDbMessage> get_message_by_unique_message_id(ServerMessageId unique_message_id) = 0;
   virtual Result<MessageDbDialogMessage> get_message_by_random_id(DialogId dialog_id, int64 random_id) = 0;
   virtual Result<MessageDbDialogMessage> get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id,
                                                                     MessageId last_message_id, int32 date) = 0;
 
+  // returns the number of stored messages in the dialog matching the filter; the counter is maintained by the database
+  virtual int32 get_dialog_message_count(DialogId dialog_id, MessageSearchFilter filter) = 0;
+
   virtual MessageDbCalendar get_dialog_message_calendar(MessageDbDialogCalendarQuery query) = 0;
 
   virtual Result<MessageDbMessagePositions> get_dialog_sparse_message_positions(
@@ -134,6 +143,11 @@ class MessageDbSyncInterface {
   virtual MessageDbCallsResult get_calls(MessageDbCallsQuery query) = 0;
   virtual MessageDbFtsResult get_messages_fts(MessageDbFtsQuery query) = 0;
 
+  // adds up to limit new and edited messages to the full-text search index; returns the number of processed messages
+  virtual int32 index_pending_messages_fts(int32 limit) = 0;
+  // merges segments of the full-text search index, writing approximately page_count pages
+  virtual void merge_messages_fts(int32 page_count) = 0;
+
   virtual Status begin_write_transaction() = 0;
   virtual Status commit_transaction() = 0;
 };
@@ -173,6 +187,8 @@ class MessageDbAsyncInterface {
   virtual void get_dialog_message_by_date(DialogId dialog_id, MessageId first_message_id, MessageId last_message_id,
                                           int32 date, Promise<MessageDbDialogMessage> promise) = 0;
 
+  virtual void get_dialog_message_count(DialogId dialog_id, MessageSearchFilter filter, Promise<int32> promise) = 0;
+
   virtual void get_dialog_message_calendar(MessageDbDialogCalendarQuery query, Promise<MessageDbCalendar> promise) = 0;
 
   virtual void get_dialog_sparse_message_positions(MessageDbGetDialogSparseMessagePositionsQuery query,
@@ -191,15 +207,23 @@ class MessageDbAsyncInterface {
 
   virtual void close(Promise<> promise) = 0;
   virtual void force_flush() = 0;
+
+  // new messages will be stored compressed; messages are decompressed on load regardless of the setting
+  virtual void set_use_compression(bool use_compression) = 0;
 };
 
+// returns size of the stored message data after decompression; data_prefix must contain at least 8 first bytes of it
+int64 get_message_db_data_original_size(Slice data_prefix, int64 stored_size);
+
 Status init_message_db(SqliteDb &db, int version) TD_WARN_UNUSED_RESULT;
 Status drop_message_db(SqliteDb &db, int version) TD_WARN_UNUSED_RESULT;
 
 std::shared_ptr<MessageDbSyncSafeInterface> create_message_db_sync(
     std::shared_ptr<SqliteConnectionSafe> sqlite_connection);
 
+// heavy read queries are executed concurrently on schedulers from read_scheduler_ids using their own connections
 std::shared_ptr<MessageDbAsyncInterface> create_message_db_async(std::shared_ptr<MessageDbSyncSafeInterface> sync_db,
-                                                                 int32 scheduler_id = -1);
+                                                                 int32 scheduler_id = -1,
+                                                                 vector<int32> read_scheduler_ids = {});
 
 }  // namespace td
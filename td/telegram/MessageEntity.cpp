@@ -1651,9 +1651,17 @@ static void fix_entity_offsets(Slice text, vector<MessageEntity> &entities) {
 
     uint32 skipped_code = 0;
     while (ptr != end && cnt > 0) {
-      unsigned char c = ptr[0];
-      utf16_pos += 1 + (c >= 0xf0);
-      ptr = next_utf8_unsafe(ptr, &skipped_code);
+      // skip ASCII characters before the next entity boundary at once
+      auto boundary_ptr = begin + td::min(static_cast<size_t>(cnt == 2 ? entity_begin : entity_end), text.size());
+      auto ascii_length = boundary_ptr > ptr ? utf8_ascii_prefix_length(Slice(ptr, boundary_ptr)) : 0;
+      if (ascii_length > 0) {
+        utf16_pos += narrow_cast<int32>(ascii_length);
+        ptr += ascii_length;
+      } else {
+        unsigned char c = ptr[0];
+        utf16_pos += 1 + (c >= 0xf0);
+        ptr = next_utf8_unsafe(ptr, &skipped_code);
+      }
 
       pos = static_cast<int32>(ptr - begin);
       if (entity_begin == pos) {
@@ -4519,7 +4527,7 @@ Result<FormattedText> get_formatted_text(const Td *td, DialogId dialog_id,
   TRY_RESULT(entities, get_message_entities(td->user_manager_.get(), std::move(text->entities_)));
   auto need_skip_bot_commands = need_always_skip_bot_commands(td->user_manager_.get(), dialog_id, is_bot);
   bool parse_markdown = td->option_manager_->get_option_boolean("always_parse_markdown");
-  bool skip_new_entities = is_bot && td->option_manager_->get_option_integer("session_count") > 1;
+  bool skip_new_entities = is_bot && td->option_manager_->get_option_integer(OptionId::SessionCount) > 1;
   TRY_STATUS(fix_formatted_text(text->text_, entities, allow_empty, skip_new_entities || parse_markdown,
                                 skip_new_entities || need_skip_bot_commands,
                                 is_bot || skip_media_timestamps || parse_markdown, skip_trim, ltrim_count));
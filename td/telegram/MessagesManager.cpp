@@ -2730,7 +2730,7 @@ class SendMessageQuery final : public Td::ResultHandler {
             std::move(reply_markup), std::move(entities), schedule_date, std::move(as_input_peer), nullptr),
         {{dialog_id, MessageContentType::Text},
          {dialog_id, is_copy ? MessageContentType::Photo : MessageContentType::Text}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(OptionId::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
           send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -2799,7 +2799,7 @@ class StartBotQuery final : public Td::ResultHandler {
     auto query = G()->net_query_creator().create(
         telegram_api::messages_startBot(std::move(bot_input_user), std::move(input_peer), random_id, parameter),
         {{dialog_id, MessageContentType::Text}, {dialog_id, MessageContentType::Photo}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(OptionId::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
           send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -3054,7 +3054,7 @@ class SendMediaQuery final : public Td::ResultHandler {
             false /*ignored*/, std::move(input_peer), std::move(reply_to), std::move(input_media), text, random_id,
             std::move(reply_markup), std::move(entities), schedule_date, std::move(as_input_peer), nullptr),
         {{dialog_id, content_type}, {dialog_id, is_copy ? MessageContentType::Text : content_type}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack") && was_uploaded_) {
+    if (td_->option_manager_->get_option_boolean(OptionId::UseQuickAck) && was_uploaded_) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_id](Result<Unit> result) {
         if (result.is_ok()) {
           send_closure(G()->messages_manager(), &MessagesManager::on_send_message_get_quick_ack, random_id);
@@ -3434,7 +3434,7 @@ class ForwardMessagesQuery final : public Td::ResultHandler {
             std::move(random_ids), std::move(to_input_peer), top_thread_message_id.get_server_message_id().get(),
             schedule_date, std::move(as_input_peer), nullptr),
         {{to_dialog_id, MessageContentType::Text}, {to_dialog_id, MessageContentType::Photo}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(OptionId::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_ids = random_ids_](Result<Unit> result) {
         if (result.is_ok()) {
           for (auto random_id : random_ids) {
@@ -3542,7 +3542,7 @@ class SendQuickReplyMessagesQuery final : public Td::ResultHandler {
                                                       MessageId::get_server_message_ids(message_ids),
                                                       std::move(random_ids)),
         {{dialog_id, MessageContentType::Text}, {dialog_id, MessageContentType::Photo}});
-    if (td_->option_manager_->get_option_boolean("use_quick_ack")) {
+    if (td_->option_manager_->get_option_boolean(OptionId::UseQuickAck)) {
       query->quick_ack_promise_ = PromiseCreator::lambda([random_ids = random_ids_](Result<Unit> result) {
         if (result.is_ok()) {
           for (auto random_id : random_ids) {
@@ -4073,10 +4073,11 @@ class MessagesManager::UploadThumbnailCallback final : public FileManager::Uploa
 template <class StorerT>
 void MessagesManager::Message::store(StorerT &storer) const {
   using td::store;
+  const auto &info = get_message_send_info(this);
   bool has_sender = sender_user_id.is_valid();
   bool has_edit_date = edit_date > 0;
   bool has_random_id = random_id != 0;
-  bool is_reply_to_random_id = reply_to_random_id != 0;
+  bool is_reply_to_random_id = info.reply_to_random_id != 0;
   bool is_via_bot = via_bot_user_id.is_valid();
   bool has_view_count = view_count > 0;
   bool has_reply_markup = reply_markup != nullptr;
@@ -4086,8 +4087,9 @@ void MessagesManager::Message::store(StorerT &storer) const {
   bool has_send_date = message_id.is_yet_unsent() && send_date != 0;
   bool has_flags2 = true;
   bool has_notification_id = notification_id.is_valid();
-  bool has_send_error_code = send_error_code != 0;
-  bool has_real_forward_from = real_forward_from_dialog_id.is_valid() && real_forward_from_message_id.is_valid();
+  bool has_send_error_code = info.send_error_code != 0;
+  bool has_real_forward_from =
+      info.real_forward_from_dialog_id.is_valid() && info.real_forward_from_message_id.is_valid();
   bool has_legacy_layer = legacy_layer != 0;
   bool has_restriction_reasons = !restriction_reasons.empty();
   bool has_forward_count = forward_count > 0;
@@ -4098,7 +4100,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
   bool has_local_thread_message_ids = !local_thread_message_ids.empty();
   bool has_linked_top_thread_message_id = linked_top_thread_message_id.is_valid();
   bool has_interaction_info_update_date = interaction_info_update_date != 0;
-  bool has_send_emoji = !send_emoji.empty();
+  bool has_send_emoji = !info.send_emoji.empty();
   bool has_ttl_period = ttl_period != 0;
   bool has_max_reply_media_timestamp = max_reply_media_timestamp >= 0;
   bool are_message_media_timestamp_entities_found = true;
@@ -4107,11 +4109,12 @@ void MessagesManager::Message::store(StorerT &storer) const {
   bool has_available_reactions_generation = available_reactions_generation != 0;
   bool has_history_generation = history_generation != 0;
   bool is_reply_to_story = reply_to_story_full_id != StoryFullId();
-  bool has_input_reply_to = !message_id.is_any_server() && input_reply_to.is_valid();
+  bool has_input_reply_to = !message_id.is_any_server() && info.input_reply_to.is_valid();
   bool has_replied_message_info = !replied_message_info.is_empty();
   bool has_forward_info = forward_info != nullptr;
   bool has_saved_messages_topic_id = saved_messages_topic_id.is_valid();
-  bool has_initial_top_thread_message_id = !message_id.is_any_server() && initial_top_thread_message_id.is_valid();
+  bool has_initial_top_thread_message_id =
+      !message_id.is_any_server() && info.initial_top_thread_message_id.is_valid();
   bool has_sender_boost_count = sender_boost_count != 0;
   bool has_via_business_bot_user_id = via_business_bot_user_id.is_valid();
   BEGIN_STORE_FLAGS();
@@ -4221,11 +4224,11 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(forward_info, storer);
   }
   if (has_real_forward_from) {
-    store(real_forward_from_dialog_id, storer);
-    store(real_forward_from_message_id, storer);
+    store(info.real_forward_from_dialog_id, storer);
+    store(info.real_forward_from_message_id, storer);
   }
   if (is_reply_to_random_id) {
-    store(reply_to_random_id, storer);
+    store(info.reply_to_random_id, storer);
   }
   if (is_via_bot) {
     store(via_bot_user_id, storer);
@@ -4244,10 +4247,10 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store_time(ttl_expires_at, storer);
   }
   if (has_send_error_code) {
-    store(send_error_code, storer);
-    store(send_error_message, storer);
-    if (send_error_code == 429) {
-      store_time(try_resend_at, storer);
+    store(info.send_error_code, storer);
+    store(info.send_error_message, storer);
+    if (info.send_error_code == 429) {
+      store_time(info.try_resend_at, storer);
     }
   }
   if (has_author_signature) {
@@ -4284,7 +4287,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(interaction_info_update_date, storer);
   }
   if (has_send_emoji) {
-    store(send_emoji, storer);
+    store(info.send_emoji, storer);
   }
   store_message_content(content.get(), storer);
   if (has_reply_markup) {
@@ -4309,7 +4312,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(reply_to_story_full_id, storer);
   }
   if (has_input_reply_to) {
-    store(input_reply_to, storer);
+    store(info.input_reply_to, storer);
   }
   if (has_replied_message_info) {
     store(replied_message_info, storer);
@@ -4318,7 +4321,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
     store(saved_messages_topic_id, storer);
   }
   if (has_initial_top_thread_message_id) {
-    store(initial_top_thread_message_id, storer);
+    store(info.initial_top_thread_message_id, storer);
   }
   if (has_sender_boost_count) {
     store(sender_boost_count, storer);
@@ -4332,6 +4335,7 @@ void MessagesManager::Message::store(StorerT &storer) const {
 template <class ParserT>
 void MessagesManager::Message::parse(ParserT &parser) {
   using td::parse;
+  MessageSendInfo info;
   bool legacy_have_previous;
   bool legacy_have_next;
   bool has_sender;
@@ -4538,15 +4542,15 @@ void MessagesManager::Message::parse(ParserT &parser) {
         std::move(forward_origin), forward_date, std::move(last_message_info), std::move(psa_type), legacy_is_imported);
   }
   if (has_real_forward_from) {
-    parse(real_forward_from_dialog_id, parser);
-    parse(real_forward_from_message_id, parser);
+    parse(info.real_forward_from_dialog_id, parser);
+    parse(info.real_forward_from_message_id, parser);
   }
   MessageId legacy_reply_to_message_id;
   if (legacy_is_reply) {
     parse(legacy_reply_to_message_id, parser);
   }
   if (is_reply_to_random_id) {
-    parse(reply_to_random_id, parser);
+    parse(info.reply_to_random_id, parser);
   }
   if (is_via_bot) {
     parse(via_bot_user_id, parser);
@@ -4565,10 +4569,10 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse_time(ttl_expires_at, parser);
   }
   if (has_send_error_code) {
-    parse(send_error_code, parser);
-    parse(send_error_message, parser);
-    if (send_error_code == 429) {
-      parse_time(try_resend_at, parser);
+    parse(info.send_error_code, parser);
+    parse(info.send_error_message, parser);
+    if (info.send_error_code == 429) {
+      parse_time(info.try_resend_at, parser);
     }
   }
   if (has_author_signature) {
@@ -4609,7 +4613,7 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse(interaction_info_update_date, parser);
   }
   if (has_send_emoji) {
-    parse(send_emoji, parser);
+    parse(info.send_emoji, parser);
   }
   parse_message_content(content, parser);
   if (has_reply_markup) {
@@ -4634,12 +4638,12 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse(reply_to_story_full_id, parser);
   }
   if (has_input_reply_to) {
-    parse(input_reply_to, parser);
+    parse(info.input_reply_to, parser);
   } else if (!message_id.is_any_server()) {
     if (reply_to_story_full_id.is_valid()) {
-      input_reply_to = MessageInputReplyTo(reply_to_story_full_id);
+      info.input_reply_to = MessageInputReplyTo(reply_to_story_full_id);
     } else if (legacy_reply_to_message_id.is_valid()) {
-      input_reply_to = MessageInputReplyTo{legacy_reply_to_message_id, DialogId(), MessageQuote()};
+      info.input_reply_to = MessageInputReplyTo{legacy_reply_to_message_id, DialogId(), MessageQuote()};
     }
   }
   if (has_replied_message_info) {
@@ -4651,7 +4655,7 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse(saved_messages_topic_id, parser);
   }
   if (has_initial_top_thread_message_id) {
-    parse(initial_top_thread_message_id, parser);
+    parse(info.initial_top_thread_message_id, parser);
   }
   if (has_sender_boost_count) {
     parse(sender_boost_count, parser);
@@ -4660,6 +4664,11 @@ void MessagesManager::Message::parse(ParserT &parser) {
     parse(via_business_bot_user_id, parser);
   }
 
+  if (has_real_forward_from || is_reply_to_random_id || has_send_error_code || has_send_emoji ||
+      info.input_reply_to.is_valid() || has_initial_top_thread_message_id) {
+    send_info = td::make_unique<MessageSendInfo>(std::move(info));
+  }
+
   CHECK(content != nullptr);
   is_content_secret |= ttl.is_secret_message_content(content->get_type());  // repair is_content_secret for old messages
   if (hide_edit_date && content->get_type() == MessageContentType::LiveLocation) {
@@ -5358,6 +5367,9 @@ MessagesManager::MessagesManager(Td *td, ActorShared<> parent)
   pending_message_views_timeout_.set_callback(on_pending_message_views_timeout_callback);
   pending_message_views_timeout_.set_callback_data(static_cast<void *>(this));
 
+  pending_message_interaction_info_timeout_.set_callback(on_pending_message_interaction_info_timeout_callback);
+  pending_message_interaction_info_timeout_.set_callback_data(static_cast<void *>(this));
+
   pending_message_live_location_view_timeout_.set_callback(on_pending_message_live_location_view_timeout_callback);
   pending_message_live_location_view_timeout_.set_callback_data(static_cast<void *>(this));
 
@@ -5393,13 +5405,15 @@ MessagesManager::~MessagesManager() {
   Scheduler::instance()->destroy_on_scheduler(
       G()->get_gc_scheduler_id(), ttl_nodes_, ttl_heap_, being_sent_messages_, update_message_ids_,
       update_scheduled_message_ids_, message_id_to_dialog_id_, last_clear_history_message_id_to_dialog_id_, dialogs_,
-      postponed_chat_read_inbox_updates_, found_public_dialogs_, found_on_server_dialogs_, message_embedding_codes_[0],
+      postponed_chat_read_inbox_updates_, found_public_dialogs_, message_embedding_codes_[0],
       message_embedding_codes_[1], message_to_replied_media_timestamp_messages_,
       story_to_replied_media_timestamp_messages_, notification_group_id_to_dialog_id_, pending_get_channel_differences_,
-      active_get_channel_differences_, get_channel_difference_to_log_event_id_, channel_get_difference_retry_timeouts_,
-      is_channel_difference_finished_, expected_channel_pts_, expected_channel_max_message_id_,
-      dialog_bot_command_message_ids_, message_full_id_to_file_source_id_, last_outgoing_forwarded_message_date_,
-      dialog_viewed_messages_, previous_repaired_read_inbox_max_message_id_, failed_to_load_dialogs_);
+      pending_important_get_channel_differences_, active_get_channel_differences_,
+      get_channel_difference_to_log_event_id_, channel_get_difference_retry_timeouts_, is_channel_difference_finished_,
+      expected_channel_pts_, expected_channel_max_message_id_, dialog_bot_command_message_ids_,
+      message_full_id_to_file_source_id_, last_outgoing_forwarded_message_date_, dialog_viewed_messages_,
+      previous_repaired_read_inbox_max_message_id_, failed_to_load_dialogs_,
+      pending_message_interaction_info_updates_);
 }
 
 MessagesManager::AddDialogData::AddDialogData(int32 dependent_dialog_count, unique_ptr<Message> &&last_message,
@@ -5429,6 +5443,17 @@ void MessagesManager::on_pending_message_views_timeout_callback(void *messages_m
                      DialogId(dialog_id_int));
 }
 
+void MessagesManager::on_pending_message_interaction_info_timeout_callback(void *messages_manager_ptr,
+                                                                           int64 dialog_id_int) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  auto messages_manager = static_cast<MessagesManager *>(messages_manager_ptr);
+  send_closure_later(messages_manager->actor_id(messages_manager),
+                     &MessagesManager::on_pending_message_interaction_info_timeout, DialogId(dialog_id_int));
+}
+
 void MessagesManager::on_pending_message_live_location_view_timeout_callback(void *messages_manager_ptr,
                                                                              int64 task_id) {
   if (G()->close_flag()) {
@@ -5532,14 +5557,12 @@ void MessagesManager::on_send_update_chat_read_inbox_timeout_callback(void *mess
 
 BufferSlice MessagesManager::get_dialog_database_value(const Dialog *d) {
   // can't use log_event_store, because it tries to parse stored Dialog
-  LogEventStorerCalcLength storer_calc_length;
-  store(*d, storer_calc_length);
-
-  BufferSlice value_buffer{storer_calc_length.get_length()};
-  auto value = value_buffer.as_mutable_slice();
+  auto buffer = log_event::acquire_store_buffer();
+  LogEventStorerGrowable storer(buffer);
+  store(*d, storer);
 
-  LogEventStorerUnsafe storer_unsafe(value.ubegin());
-  store(*d, storer_unsafe);
+  BufferSlice value_buffer(storer.as_slice());
+  log_event::release_store_buffer(std::move(buffer));
   return value_buffer;
 }
 
@@ -6191,6 +6214,55 @@ void MessagesManager::on_pending_message_views_timeout(DialogId dialog_id) {
   pending_message_views_.erase(it);
 }
 
+void MessagesManager::queue_update_message_interaction_info(DialogId dialog_id, const Message *m) {
+  CHECK(m != nullptr);
+  if (td_->auth_manager_->is_bot() || !m->is_update_sent) {
+    return;
+  }
+
+  // counters of popular messages change very often, so send at most one update per message in a time interval
+  if (pending_message_interaction_info_updates_[dialog_id].insert(m->message_id).second) {
+    pending_message_interaction_info_timeout_.add_timeout_in(dialog_id.get(), MESSAGE_INTERACTION_INFO_UPDATE_DELAY);
+  }
+}
+
+void MessagesManager::remove_pending_message_interaction_info_update(DialogId dialog_id, const Message *m,
+                                                                     bool need_send_update) {
+  auto it = pending_message_interaction_info_updates_.find(dialog_id);
+  if (it == pending_message_interaction_info_updates_.end() || it->second.erase(m->message_id) == 0) {
+    return;
+  }
+  if (need_send_update) {
+    send_update_message_interaction_info(dialog_id, m);
+  }
+  if (it->second.empty()) {
+    pending_message_interaction_info_updates_.erase(it);
+    pending_message_interaction_info_timeout_.cancel_timeout(dialog_id.get());
+  }
+}
+
+void MessagesManager::on_pending_message_interaction_info_timeout(DialogId dialog_id) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  auto it = pending_message_interaction_info_updates_.find(dialog_id);
+  if (it == pending_message_interaction_info_updates_.end()) {
+    return;
+  }
+  auto message_ids = std::move(it->second);
+  pending_message_interaction_info_updates_.erase(it);
+
+  const Dialog *d = get_dialog(dialog_id);
+  CHECK(d != nullptr);
+  for (auto message_id : message_ids) {
+    const Message *m = get_message(d, message_id);
+    if (m != nullptr) {
+      send_update_message_interaction_info(dialog_id, m);
+    }
+  }
+}
+
 void MessagesManager::update_message_interaction_info(MessageFullId message_full_id, int32 view_count,
                                                       int32 forward_count, bool has_reply_info,
                                                       tl_object_ptr<telegram_api::messageReplies> &&reply_info,
@@ -6538,7 +6610,7 @@ bool MessagesManager::update_message_interaction_info(Dialog *d, Message *m, int
       }
     }
     if (need_update) {
-      send_update_message_interaction_info(dialog_id, m);
+      queue_update_message_interaction_info(dialog_id, m);
     }
     if (new_dialog_unread_reaction_count >= 0) {
       send_update_message_unread_reactions(dialog_id, m, new_dialog_unread_reaction_count);
@@ -7271,8 +7343,10 @@ void MessagesManager::update_dialog_unmute_timeout(Dialog *d, bool &old_use_defa
   old_use_default = new_use_default;
   old_mute_until = new_mute_until;
 
-  if (was_muted != is_muted && td_->dialog_filter_manager_->have_dialog_filters()) {
-    update_dialog_lists(d, get_dialog_positions(d), true, false, "update_dialog_unmute_timeout");
+  if (was_muted != is_muted &&
+      td_->dialog_filter_manager_->is_some_dialog_filter_affected(DialogFilterDialogInfo::IsMuted)) {
+    update_dialog_lists(d, get_dialog_positions(d), true, false, "update_dialog_unmute_timeout",
+                        DialogFilterDialogInfo::IsMuted);
   }
 }
 
@@ -7330,12 +7404,13 @@ void MessagesManager::on_update_notification_scope_is_muted(NotificationSettings
     }
   }
 
-  if (td_->dialog_filter_manager_->have_dialog_filters()) {
+  if (td_->dialog_filter_manager_->is_some_dialog_filter_affected(DialogFilterDialogInfo::IsMuted)) {
     dialogs_.foreach([&](const DialogId &dialog_id, unique_ptr<Dialog> &dialog) {
       Dialog *d = dialog.get();
       if (need_unread_counter(d->order) && d->notification_settings.use_default_mute_until &&
           td_->dialog_manager_->get_dialog_notification_setting_scope(d->dialog_id) == scope) {
-        update_dialog_lists(d, get_dialog_positions(d), true, false, "on_update_notification_scope_is_muted");
+        update_dialog_lists(d, get_dialog_positions(d), true, false, "on_update_notification_scope_is_muted",
+                            DialogFilterDialogInfo::IsMuted);
       }
     });
   }
@@ -8171,7 +8246,7 @@ void MessagesManager::do_send_media(DialogId dialog_id, Message *m, FileId file_
   }
 
   auto input_media = get_input_media(content, td_, std::move(input_file), std::move(input_thumbnail), file_id,
-                                     thumbnail_file_id, m->ttl, m->send_emoji, true);
+                                     thumbnail_file_id, m->ttl, get_message_send_info(m).send_emoji, true);
   LOG_CHECK(input_media != nullptr) << to_string(get_message_object(dialog_id, m, "do_send_media")) << ' '
                                     << have_input_file << ' ' << have_input_thumbnail << ' ' << file_id << ' '
                                     << thumbnail_file_id << ' ' << m->ttl;
@@ -8707,6 +8782,7 @@ void MessagesManager::on_get_history(DialogId dialog_id, MessageId from_message_
     }
   }
 
+  preload_history_messages_from_database(d, messages);
   for (auto &message : messages) {
     auto expected_message_id = MessageId::get_message_id(message, false);
     if (!have_next && from_the_end && expected_message_id < d->last_message_id) {
@@ -8740,6 +8816,8 @@ void MessagesManager::on_get_history(DialogId dialog_id, MessageId from_message_
       first_added_message_id = message_id;
     }
   }
+  missing_database_messages_dialog_id_ = DialogId();
+  missing_database_message_ids_.clear();
 
   if (from_the_end && last_added_message_id.is_valid() && last_added_message_id != last_received_message_id) {
     CHECK(last_added_message_id < last_received_message_id);
@@ -8881,8 +8959,8 @@ void MessagesManager::on_get_public_dialogs_search_result(const string &query,
   search_public_dialogs_queries_.erase(it);
 
   CHECK(!query.empty());
-  found_public_dialogs_[query] = td_->dialog_manager_->get_peers_dialog_ids(std::move(peers));
-  found_on_server_dialogs_[query] = td_->dialog_manager_->get_peers_dialog_ids(std::move(my_peers));
+  add_found_public_dialogs(query, td_->dialog_manager_->get_peers_dialog_ids(std::move(peers)),
+                           td_->dialog_manager_->get_peers_dialog_ids(std::move(my_peers)));
 
   set_promises(promises);
 }
@@ -8894,8 +8972,7 @@ void MessagesManager::on_failed_public_dialogs_search(const string &query, Statu
   auto promises = std::move(it->second);
   search_public_dialogs_queries_.erase(it);
 
-  found_public_dialogs_[query];     // negative cache
-  found_on_server_dialogs_[query];  // negative cache
+  add_found_public_dialogs(query, {}, {});  // negative cache
 
   fail_promises(promises, std::move(error));
 }
@@ -10602,7 +10679,19 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
 
   bool has_left_to_unload_messages = false;
   auto to_unload_message_ids = find_unloadable_messages(d, G()->unix_time() - delay, has_left_to_unload_messages);
+  unload_dialog_messages(d, to_unload_message_ids);
 
+  if (has_left_to_unload_messages) {
+    LOG(DEBUG) << "Need to unload more messages in " << dialog_id;
+    pending_unload_dialog_timeout_.add_timeout_in(
+        d->dialog_id.get(),
+        to_unload_message_ids.size() >= MAX_UNLOADED_MESSAGES ? 1.0 : get_next_unload_dialog_delay(d));
+  } else {
+    d->has_unload_timeout = false;
+  }
+}
+
+void MessagesManager::unload_dialog_messages(Dialog *d, const vector<MessageId> &to_unload_message_ids) {
   vector<int64> unloaded_message_ids;
   vector<unique_ptr<Message>> unloaded_messages;
   for (auto message_id : to_unload_message_ids) {
@@ -10625,18 +10714,96 @@ void MessagesManager::unload_dialog(DialogId dialog_id, int32 delay) {
   if (!unloaded_message_ids.empty()) {
     send_closure_later(
         G()->td(), &Td::send_update,
-        td_api::make_object<td_api::updateDeleteMessages>(get_chat_id_object(dialog_id, "updateDeleteMessages"),
+        td_api::make_object<td_api::updateDeleteMessages>(get_chat_id_object(d->dialog_id, "updateDeleteMessages"),
                                                           std::move(unloaded_message_ids), false, true));
   }
+}
 
-  if (has_left_to_unload_messages) {
-    LOG(DEBUG) << "Need to unload more messages in " << dialog_id;
-    pending_unload_dialog_timeout_.add_timeout_in(
-        d->dialog_id.get(),
-        to_unload_message_ids.size() >= MAX_UNLOADED_MESSAGES ? 1.0 : get_next_unload_dialog_delay(d));
-  } else {
-    d->has_unload_timeout = false;
+void MessagesManager::on_message_cache_max_count_changed() {
+  message_cache_max_count_ = td_->option_manager_->get_option_integer("message_cache_max_count");
+  check_message_cache_size();
+}
+
+void MessagesManager::check_message_cache_size() {
+  if (message_cache_max_count_ <= 0 || loaded_message_count_ <= message_cache_max_count_ ||
+      is_message_cache_cleanup_scheduled_ || !is_message_unload_enabled()) {
+    return;
+  }
+  is_message_cache_cleanup_scheduled_ = true;
+  send_closure_later(actor_id(this), &MessagesManager::unload_least_recently_used_messages);
+}
+
+void MessagesManager::unload_least_recently_used_messages() {
+  is_message_cache_cleanup_scheduled_ = false;
+  if (G()->close_flag() || message_cache_max_count_ <= 0 || loaded_message_count_ <= message_cache_max_count_ ||
+      !is_message_unload_enabled()) {
+    return;
+  }
+
+  // unload slightly more messages than needed to avoid cleanup after each new message
+  do_unload_least_recently_used_messages(
+      static_cast<size_t>(loaded_message_count_ - message_cache_max_count_ + message_cache_max_count_ / 10));
+}
+
+void MessagesManager::reduce_memory_usage() {
+  if (!is_message_unload_enabled()) {
+    return;
   }
+  do_unload_least_recently_used_messages(static_cast<size_t>(loaded_message_count_));
+}
+
+void MessagesManager::do_unload_least_recently_used_messages(size_t unload_count) {
+  struct UnloadCandidate {
+    int32 last_access_date_;
+    Dialog *d_;
+    MessageId message_id_;
+  };
+  vector<UnloadCandidate> candidates;
+  dialogs_.foreach([&](const DialogId &dialog_id, unique_ptr<Dialog> &dialog) {
+    Dialog *d = dialog.get();
+    size_t dialog_candidate_count = 0;
+    // messages are sorted by last access date, so only the first unload_count messages can be unloaded
+    for (auto it = d->message_lru_list.next; it != &d->message_lru_list && dialog_candidate_count < unload_count;
+         it = it->next) {
+      const auto *m = static_cast<const Message *>(it);
+      if (can_unload_message(d, m)) {
+        candidates.push_back({m->last_access_date, d, m->message_id});
+        dialog_candidate_count++;
+      }
+    }
+  });
+  if (candidates.size() > unload_count) {
+    std::nth_element(candidates.begin(), candidates.begin() + unload_count, candidates.end(),
+                     [](const UnloadCandidate &lhs, const UnloadCandidate &rhs) {
+                       return lhs.last_access_date_ < rhs.last_access_date_;
+                     });
+    candidates.resize(unload_count);
+  }
+  std::sort(candidates.begin(), candidates.end(), [](const UnloadCandidate &lhs, const UnloadCandidate &rhs) {
+    return lhs.d_->dialog_id.get() < rhs.d_->dialog_id.get();
+  });
+
+  LOG(INFO) << "Unload " << candidates.size() << " least recently used messages out of " << loaded_message_count_;
+  for (size_t i = 0; i < candidates.size();) {
+    auto *d = candidates[i].d_;
+    vector<MessageId> message_ids;
+    for (; i < candidates.size() && candidates[i].d_ == d; i++) {
+      message_ids.push_back(candidates[i].message_id_);
+    }
+    unload_dialog_messages(d, message_ids);
+  }
+}
+
+td_api::object_ptr<td_api::messageCacheStatistics> MessagesManager::get_message_cache_statistics_object() const {
+  int32 chat_count = 0;
+  dialogs_.foreach([&](const DialogId &dialog_id, const unique_ptr<Dialog> &dialog) {
+    if (!dialog->messages.empty()) {
+      chat_count++;
+    }
+  });
+  return td_api::make_object<td_api::messageCacheStatistics>(
+      loaded_message_count_, chat_count, td::max(message_cache_max_count_, static_cast<int64>(0)),
+      sequential_history_request_count_, sequential_history_miss_count_);
 }
 
 void MessagesManager::clear_dialog_message_list(Dialog *d, bool remove_from_dialog_list, int32 last_message_date) {
@@ -10727,6 +10894,7 @@ void MessagesManager::delete_all_dialog_messages(Dialog *d, bool remove_from_dia
       d->deleted_message_ids.insert(m->message_id);
     }
   });
+  loaded_message_count_ -= static_cast<int64>(d->messages.calc_size());
   Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), d->messages, d->ordered_messages);
 
   delete_all_dialog_messages_from_database(d, MessageId::max(), "delete_all_dialog_messages 3");
@@ -11635,8 +11803,10 @@ void MessagesManager::set_dialog_last_read_inbox_message_id(Dialog *d, MessageId
 
     bool was_unread = old_unread_count != 0 || d->is_marked_as_unread;
     bool is_unread = new_unread_count != 0 || d->is_marked_as_unread;
-    if (td_->dialog_filter_manager_->have_dialog_filters() && was_unread != is_unread) {
-      update_dialog_lists(d, get_dialog_positions(d), true, false, "set_dialog_last_read_inbox_message_id");
+    if (was_unread != is_unread &&
+        td_->dialog_filter_manager_->is_some_dialog_filter_affected(DialogFilterDialogInfo::HasUnreadMessages)) {
+      update_dialog_lists(d, get_dialog_positions(d), true, false, "set_dialog_last_read_inbox_message_id",
+                          DialogFilterDialogInfo::HasUnreadMessages);
     }
   }
 
@@ -12058,8 +12228,10 @@ void MessagesManager::ttl_update_timeout(double now) {
     }
     return;
   }
+  // messages expiring soon after the first one are expired in the same ttl_loop,
+  // so they are deleted from a chat with a single updateDeleteMessages
   ttl_slot_.set_event(EventCreator::yield(actor_id()));
-  ttl_slot_.set_timeout_in(ttl_heap_.top_key() - now);
+  ttl_slot_.set_timeout_in(ttl_heap_.top_key() - now + TTL_EXPIRATION_BATCH_DELAY);
 }
 
 void MessagesManager::on_message_ttl_expired(Dialog *d, Message *m) {
@@ -12246,6 +12418,7 @@ void MessagesManager::init() {
     create_folders(10);  // ensure that Main and Archive dialog lists are created
   }
   authorization_date_ = td_->option_manager_->get_option_integer("authorization_date");
+  message_cache_max_count_ = td_->option_manager_->get_option_integer("message_cache_max_count");
 
   td_->dialog_filter_manager_->init();  // load dialog filters
 
@@ -15009,6 +15182,9 @@ unique_ptr<MessagesManager::Message> MessagesManager::do_delete_message(Dialog *
     return nullptr;
   }
 
+  // the latest interaction info of an unloaded message can't be sent after the timeout
+  remove_pending_message_interaction_info_update(d->dialog_id, m, only_from_memory);
+
   LOG_CHECK(!d->being_deleted_message_id.is_valid())
       << d->being_deleted_message_id << " " << message_id << " " << source;
   d->being_deleted_message_id = message_id;
@@ -15102,6 +15278,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::do_delete_message(Dialog *
   auto result = std::move(d->messages[message_id]);
   CHECK(m == result.get());
   d->messages.erase(message_id);
+  loaded_message_count_--;
 
   static_cast<ListNode *>(result.get())->remove();
 
@@ -15549,7 +15726,7 @@ vector<DialogId> MessagesManager::get_dialogs(DialogListId dialog_list_id, Dialo
   update_list_last_pinned_dialog_date(list);
 
   vector<const DialogFolder *> folders;
-  vector<std::set<DialogDate>::const_iterator> folder_iterators;
+  vector<ChunkedSet<DialogDate>::const_iterator> folder_iterators;
   for (auto folder_id : get_dialog_list_folder_ids(list)) {
     folders.push_back(get_dialog_folder(folder_id));
     folder_iterators.push_back(folders.back()->ordered_dialogs_.upper_bound(offset));
@@ -15753,6 +15930,7 @@ void MessagesManager::on_get_dialogs_from_database(FolderId folder_id, int32 lim
   }
   folder.load_dialog_list_limit_max_ = 0;
 
+  auto start_time = Time::now();
   size_t dialogs_skipped = 0;
   for (auto &dialog : dialogs.dialogs) {
     Dialog *d = on_load_dialog_from_database(DialogId(), std::move(dialog), "on_get_dialogs_from_database");
@@ -15769,6 +15947,7 @@ void MessagesManager::on_get_dialogs_from_database(FolderId folder_id, int32 lim
 
     LOG(INFO) << "Loaded from database " << d->dialog_id << " with order " << d->order;
   }
+  update_preload_dialog_list_limit(folder, dialogs.dialogs.size(), Time::now() - start_time);
 
   DialogDate max_dialog_date(dialogs.next_order, dialogs.next_dialog_id);
   if (!have_more_dialogs_in_database) {
@@ -15808,6 +15987,22 @@ void MessagesManager::on_get_dialogs_from_database(FolderId folder_id, int32 lim
   }
 }
 
+void MessagesManager::update_preload_dialog_list_limit(DialogFolder &folder, size_t loaded_dialog_count,
+                                                       double elapsed_time) {
+  if (static_cast<int32>(loaded_dialog_count) < folder.preload_dialog_list_limit_) {
+    // the time isn't representative for the current limit
+    return;
+  }
+  // double the limit while chats are loaded fast, and halve it if loading blocks the actor for too long
+  if (elapsed_time < MAX_PRELOAD_DIALOG_LIST_TIME / 2) {
+    folder.preload_dialog_list_limit_ = min(folder.preload_dialog_list_limit_ * 2, MAX_PRELOADED_DIALOGS);
+  } else if (elapsed_time > MAX_PRELOAD_DIALOG_LIST_TIME) {
+    folder.preload_dialog_list_limit_ = max(folder.preload_dialog_list_limit_ / 2, MIN_PRELOADED_DIALOGS);
+  }
+  LOG(INFO) << "Loaded " << loaded_dialog_count << " chats in " << folder.folder_id << " from database in "
+            << elapsed_time << " seconds; preload " << folder.preload_dialog_list_limit_ << " chats next time";
+}
+
 void MessagesManager::preload_folder_dialog_list(FolderId folder_id) {
   if (G()->close_flag()) {
     LOG(INFO) << "Skip chat list preload in " << folder_id << " because of closing";
@@ -15824,7 +16019,7 @@ void MessagesManager::preload_folder_dialog_list(FolderId folder_id) {
 
   if (folder.last_loaded_database_dialog_date_ < folder.last_database_server_dialog_date_) {
     // if there are some dialogs in database, preload some of them
-    load_folder_dialog_list(folder_id, 20, true);
+    load_folder_dialog_list(folder_id, folder.preload_dialog_list_limit_, true);
   } else if (folder.folder_last_dialog_date_ != MAX_DIALOG_DATE) {
     // otherwise load more dialogs from the server
     load_folder_dialog_list(folder_id, MAX_GET_DIALOGS, false);
@@ -16027,16 +16222,43 @@ vector<DialogId> MessagesManager::search_public_dialogs(const string &query, Pro
     return {};
   }
 
-  auto it = found_public_dialogs_.find(query);
-  if (it != found_public_dialogs_.end()) {
+  auto found_public_dialogs = get_found_public_dialogs(query);
+  if (found_public_dialogs != nullptr) {
     promise.set_value(Unit());
-    return it->second;
+    return found_public_dialogs->public_dialog_ids;
   }
 
   send_search_public_dialogs_query(query, std::move(promise));
   return {};
 }
 
+const MessagesManager::FoundPublicDialogs *MessagesManager::get_found_public_dialogs(const string &query) {
+  auto it = found_public_dialogs_.find(query);
+  if (it == found_public_dialogs_.end()) {
+    return nullptr;
+  }
+  if (it->second.expires_at < Time::now()) {
+    found_public_dialogs_.erase(it);
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void MessagesManager::add_found_public_dialogs(const string &query, vector<DialogId> &&public_dialog_ids,
+                                               vector<DialogId> &&on_server_dialog_ids) {
+  auto now = Time::now();
+  if (found_public_dialogs_.size() >= MAX_FOUND_PUBLIC_DIALOGS_QUERIES) {
+    table_remove_if(found_public_dialogs_, [now](const auto &it) { return it.second.expires_at < now; });
+    if (found_public_dialogs_.size() >= MAX_FOUND_PUBLIC_DIALOGS_QUERIES) {
+      found_public_dialogs_.clear();
+    }
+  }
+  auto &found_public_dialogs = found_public_dialogs_[query];
+  found_public_dialogs.public_dialog_ids = std::move(public_dialog_ids);
+  found_public_dialogs.on_server_dialog_ids = std::move(on_server_dialog_ids);
+  found_public_dialogs.expires_at = now + FOUND_PUBLIC_DIALOGS_CACHE_TIME;
+}
+
 void MessagesManager::send_search_public_dialogs_query(const string &query, Promise<Unit> &&promise) {
   CHECK(!query.empty());
   auto &promises = search_public_dialogs_queries_[query];
@@ -16138,10 +16360,10 @@ vector<DialogId> MessagesManager::search_dialogs_on_server(const string &query,
     return {};
   }
 
-  auto it = found_on_server_dialogs_.find(query);
-  if (it != found_on_server_dialogs_.end()) {
+  auto found_public_dialogs = get_found_public_dialogs(query);
+  if (found_public_dialogs != nullptr) {
     promise.set_value(Unit());
-    return sort_dialogs_by_order(it->second, limit);
+    return sort_dialogs_by_order(found_public_dialogs->on_server_dialog_ids, limit);
   }
 
   send_search_public_dialogs_query(query, std::move(promise));
@@ -17664,7 +17886,7 @@ int32 MessagesManager::get_pinned_dialogs_limit(DialogListId dialog_list_id) con
   }
   int32 limit = clamp(narrow_cast<int32>(td_->option_manager_->get_option_integer(key)), 0, 1000);
   if (limit <= 0) {
-    if (td_->option_manager_->get_option_boolean("is_premium")) {
+    if (td_->option_manager_->get_option_boolean(OptionId::IsPremium)) {
       default_limit *= 2;
     }
     return default_limit;
@@ -19196,7 +19418,7 @@ td_api::object_ptr<td_api::MessageSender> MessagesManager::get_default_message_s
 td_api::object_ptr<td_api::chat> MessagesManager::get_chat_object(const Dialog *d, const char *source) const {
   CHECK(d != nullptr);
 
-  bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  bool is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
   auto chat_source = is_dialog_sponsored(d) ? sponsored_dialog_source_.get_chat_source_object() : nullptr;
   auto can_delete = can_delete_dialog(d);
   // TODO hide/show draft message when need_hide_dialog_draft_message changes
@@ -19462,7 +19684,7 @@ tl_object_ptr<td_api::messages> MessagesManager::get_dialog_history(DialogId dia
     return nullptr;
   }
 
-  const Dialog *d = get_dialog_force(dialog_id, "get_dialog_history");
+  Dialog *d = get_dialog_force(dialog_id, "get_dialog_history");
   if (d == nullptr) {
     promise.set_error(Status::Error(400, "Chat not found"));
     return nullptr;
@@ -19485,15 +19707,27 @@ tl_object_ptr<td_api::messages> MessagesManager::get_dialog_history(DialogId dia
             << " tries left, is_empty = " << d->is_empty << ", have_full_history = " << d->have_full_history
             << ", have_full_history_source = " << d->have_full_history_source;
 
+  // the next pages are preloaded more aggressively if history is scrolled page by page
+  bool is_sequential_scroll = from_message_id == d->last_history_min_message_id && from_message_id.is_valid();
   auto message_ids = d->ordered_messages.get_history(d->last_message_id, from_message_id, offset, limit,
                                                      left_tries == 0 && !only_local);
   if (!message_ids.empty()) {
     // maybe need some messages
     CHECK(offset == 0);
+    if (is_sequential_scroll) {
+      d->sequential_history_request_count++;
+      sequential_history_request_count_++;
+    } else {
+      d->sequential_history_request_count = 0;
+    }
+    d->last_history_min_message_id = message_ids.back();
     preload_newer_messages(d, message_ids[0]);
-    preload_older_messages(d, message_ids.back());
+    preload_older_messages(d, message_ids.back(), d->sequential_history_request_count >= 2);
   } else if (limit > 0 && left_tries != 0 && !(d->is_empty && d->have_full_history && left_tries < 3)) {
     // there can be more messages in the database or on the server, need to load them
+    if (is_sequential_scroll) {
+      sequential_history_miss_count_++;
+    }
     send_closure_later(actor_id(this), &MessagesManager::load_messages, dialog_id, from_message_id, offset, limit,
                        left_tries, only_local, std::move(promise));
     return nullptr;
@@ -20057,7 +20291,7 @@ td_api::object_ptr<td_api::messageCalendar> MessagesManager::get_dialog_message_
       db_query.dialog_id = dialog_id;
       db_query.filter = filter;
       db_query.from_message_id = fixed_from_message_id;
-      db_query.tz_offset = static_cast<int32>(td_->option_manager_->get_option_integer("utc_time_offset"));
+      db_query.tz_offset = static_cast<int32>(td_->option_manager_->get_option_integer(OptionId::UtcTimeOffset));
       G()->td_db()->get_message_db_async()->get_dialog_message_calendar(db_query, std::move(new_promise));
       return {};
     }
@@ -21396,6 +21630,15 @@ void MessagesManager::get_dialog_message_count(DialogId dialog_id, SavedMessages
     if (message_count == -1 && filter == MessageSearchFilter::UnreadReaction) {
       message_count = d->unread_reaction_count;
     }
+    if (message_count == -1 && dialog_type == DialogType::SecretChat && G()->use_message_database()) {
+      // all messages of secret chats are stored in the database, which maintains the counters
+      auto new_promise = PromiseCreator::lambda(
+          [dialog_id, filter, promise = std::move(promise)](Result<int32> r_message_count) mutable {
+            send_closure(G()->messages_manager(), &MessagesManager::on_get_dialog_message_count_from_database,
+                         dialog_id, filter, std::move(r_message_count), std::move(promise));
+          });
+      return G()->td_db()->get_message_db_async()->get_dialog_message_count(dialog_id, filter, std::move(new_promise));
+    }
     if (message_count != -1 || return_local || dialog_type == DialogType::SecretChat ||
         filter == MessageSearchFilter::FailedToSend) {
       return promise.set_value(std::move(message_count));
@@ -21405,6 +21648,24 @@ void MessagesManager::get_dialog_message_count(DialogId dialog_id, SavedMessages
   get_dialog_message_count_from_server(dialog_id, saved_messages_topic_id, filter, std::move(promise));
 }
 
+void MessagesManager::on_get_dialog_message_count_from_database(DialogId dialog_id, MessageSearchFilter filter,
+                                                                Result<int32> r_message_count,
+                                                                Promise<int32> &&promise) {
+  TRY_STATUS_PROMISE(promise, G()->close_status());
+  if (r_message_count.is_error()) {
+    return promise.set_error(r_message_count.move_as_error());
+  }
+
+  Dialog *d = get_dialog(dialog_id);
+  CHECK(d != nullptr);
+  auto &old_message_count = d->message_count_by_index[message_search_filter_index(filter)];
+  if (old_message_count == -1) {
+    old_message_count = r_message_count.ok();
+    on_dialog_updated(dialog_id, "on_get_dialog_message_count_from_database");
+  }
+  promise.set_value(std::move(old_message_count));
+}
+
 void MessagesManager::get_dialog_message_count_from_server(DialogId dialog_id,
                                                            SavedMessagesTopicId saved_messages_topic_id,
                                                            MessageSearchFilter filter, Promise<int32> &&promise) {
@@ -21490,7 +21751,7 @@ void MessagesManager::preload_newer_messages(const Dialog *d, MessageId max_mess
   }
 }
 
-void MessagesManager::preload_older_messages(const Dialog *d, MessageId min_message_id) {
+void MessagesManager::preload_older_messages(const Dialog *d, MessageId min_message_id, bool is_sequential_scroll) {
   CHECK(d != nullptr);
   CHECK(min_message_id.is_valid());
   CHECK(!td_->auth_manager_->is_bot());
@@ -21501,8 +21762,13 @@ void MessagesManager::preload_older_messages(const Dialog *d, MessageId min_mess
       return;
     }
   */
+  // during sequential scrolling a whole next page is kept loaded, unless the message cache is almost full
+  if (is_sequential_scroll && message_cache_max_count_ > 0 &&
+      loaded_message_count_ + MAX_GET_HISTORY > message_cache_max_count_) {
+    is_sequential_scroll = false;
+  }
   auto it = d->ordered_messages.get_const_iterator(min_message_id);
-  int32 limit = MAX_GET_HISTORY * 3 / 10 + 1;
+  int32 limit = is_sequential_scroll ? MAX_GET_HISTORY : MAX_GET_HISTORY * 3 / 10 + 1;
   while (*it != nullptr && limit-- > 0) {
     min_message_id = (*it)->get_message_id();
     --it;
@@ -21510,7 +21776,8 @@ void MessagesManager::preload_older_messages(const Dialog *d, MessageId min_mess
   if (limit > 0) {
     // need to preload some old messages
     LOG(INFO) << "Preloading older before " << min_message_id;
-    load_messages_impl(d, min_message_id, 0, MAX_GET_HISTORY / 2, 3, false, Promise<Unit>());
+    load_messages_impl(d, min_message_id, 0, is_sequential_scroll ? MAX_GET_HISTORY : MAX_GET_HISTORY / 2, 3, false,
+                       Promise<Unit>());
   }
 }
 
@@ -21607,7 +21874,8 @@ unique_ptr<MessagesManager::Message> MessagesManager::parse_message(Dialog *d, M
     m->is_pinned = false;
   }
   if (dialog_id == td_->dialog_manager_->get_my_dialog_id() && !m->saved_messages_topic_id.is_valid()) {
-    m->saved_messages_topic_id = SavedMessagesTopicId(dialog_id, m->forward_info.get(), m->real_forward_from_dialog_id);
+    m->saved_messages_topic_id =
+        SavedMessagesTopicId(dialog_id, m->forward_info.get(), get_message_send_info(m).real_forward_from_dialog_id);
   }
 
   LOG(INFO) << "Loaded " << m->message_id << " in " << dialog_id << " of size " << value.size() << " from database";
@@ -22225,7 +22493,7 @@ ChatReactions MessagesManager::get_message_available_reactions(const Dialog *d,
     if (can_add_message_tag(d->dialog_id, m->reactions.get())) {
       auto default_tag_reactions = td_->reaction_manager_->get_default_tag_reactions();
       active_reactions.reaction_types_ = default_tag_reactions;
-      if (td_->option_manager_->get_option_boolean("is_premium")) {
+      if (td_->option_manager_->get_option_boolean(OptionId::IsPremium)) {
         for (auto &reaction_type : active_reaction_types_) {
           if (!td::contains(default_tag_reactions, reaction_type)) {
             active_reactions.reaction_types_.push_back(reaction_type);
@@ -22249,7 +22517,7 @@ ChatReactions MessagesManager::get_message_available_reactions(const Dialog *d,
       }
     }
   }
-  if (disallow_custom_for_non_premium && !td_->option_manager_->get_option_boolean("is_premium")) {
+  if (disallow_custom_for_non_premium && !td_->option_manager_->get_option_boolean(OptionId::IsPremium)) {
     active_reactions.allow_all_custom_ = false;
   }
   return active_reactions;
@@ -22449,16 +22717,17 @@ tl_object_ptr<td_api::MessageSendingState> MessagesManager::get_message_sending_
   }
   if (m->is_failed_to_send) {
     auto can_retry = can_resend_message(m);
-    auto error_code = m->send_error_code > 0 ? m->send_error_code : 400;
+    const auto &send_info = get_message_send_info(m);
+    auto error_code = send_info.send_error_code > 0 ? send_info.send_error_code : 400;
     auto need_another_sender =
-        can_retry && error_code == 400 && m->send_error_message == CSlice("SEND_AS_PEER_INVALID");
+        can_retry && error_code == 400 && send_info.send_error_message == CSlice("SEND_AS_PEER_INVALID");
     auto need_another_reply_quote =
-        can_retry && error_code == 400 && m->send_error_message == CSlice("QUOTE_TEXT_INVALID");
+        can_retry && error_code == 400 && send_info.send_error_message == CSlice("QUOTE_TEXT_INVALID");
     auto need_drop_reply =
-        can_retry && error_code == 400 && m->send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
+        can_retry && error_code == 400 && send_info.send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
     return td_api::make_object<td_api::messageSendingStateFailed>(
-        td_api::make_object<td_api::error>(error_code, m->send_error_message), can_retry, need_another_sender,
-        need_another_reply_quote, need_drop_reply, max(m->try_resend_at - Time::now(), 0.0));
+        td_api::make_object<td_api::error>(error_code, send_info.send_error_message), can_retry, need_another_sender,
+        need_another_reply_quote, need_drop_reply, max(send_info.try_resend_at - Time::now(), 0.0));
   }
   return nullptr;
 }
@@ -22848,10 +23117,11 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
   m->date = is_scheduled ? options.schedule_date : m->send_date;
   m->replied_message_info = RepliedMessageInfo(td_, input_reply_to);
   m->reply_to_story_full_id = input_reply_to.get_story_full_id();
-  m->input_reply_to = std::move(input_reply_to);
-  m->reply_to_random_id = reply_to_random_id;
+  auto &send_info = add_message_send_info(m);
+  send_info.input_reply_to = std::move(input_reply_to);
+  send_info.reply_to_random_id = reply_to_random_id;
   m->top_thread_message_id = top_thread_message_id;
-  m->initial_top_thread_message_id = initial_top_thread_message_id;
+  send_info.initial_top_thread_message_id = initial_top_thread_message_id;
   m->is_topic_message = is_topic_message;
   m->is_channel_post = is_channel_post;
   m->is_outgoing = is_scheduled || dialog_id != DialogId(my_id);
@@ -22876,7 +23146,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
         if (is_channel_post) {
           return td_->chat_manager_->get_channel_has_linked_channel(dialog_id.get_channel_id());
         }
-        return !m->input_reply_to.is_valid();
+        return !send_info.input_reply_to.is_valid();
       }()) {
     m->reply_info.reply_count_ = 0;
     if (is_channel_post) {
@@ -22894,12 +23164,12 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
   m->content = std::move(content);
   m->invert_media = invert_media;
   m->forward_info = std::move(forward_info);
-  m->real_forward_from_dialog_id = real_forward_from_dialog_id;
+  send_info.real_forward_from_dialog_id = real_forward_from_dialog_id;
   m->is_copy = is_copy || m->forward_info != nullptr;
   m->sending_id = options.sending_id;
 
   if (td_->auth_manager_->is_bot() || options.disable_notification ||
-      td_->option_manager_->get_option_boolean("ignore_default_disable_notification")) {
+      td_->option_manager_->get_option_boolean(OptionId::IgnoreDefaultDisableNotification)) {
     m->disable_notification = options.disable_notification;
   } else {
     m->disable_notification = d->notification_settings.silent_send_message;
@@ -22915,7 +23185,7 @@ unique_ptr<MessagesManager::Message> MessagesManager::create_message_to_send(
     m->is_content_secret = m->ttl.is_secret_message_content(m->content->get_type());
   }
   if (dialog_id == DialogId(my_id)) {
-    m->saved_messages_topic_id = SavedMessagesTopicId(dialog_id, m->forward_info.get(), m->real_forward_from_dialog_id);
+    m->saved_messages_topic_id = SavedMessagesTopicId(dialog_id, m->forward_info.get(), real_forward_from_dialog_id);
   }
 
   return message;
@@ -23108,7 +23378,24 @@ MessagesManager::ForwardedMessageInfo MessagesManager::get_forwarded_message_inf
 const MessageInputReplyTo *MessagesManager::get_message_input_reply_to(const Message *m) {
   CHECK(m != nullptr);
   CHECK(!m->message_id.is_any_server());
-  return &m->input_reply_to;
+  return &get_message_send_info(m).input_reply_to;
+}
+
+const MessagesManager::MessageSendInfo &MessagesManager::get_message_send_info(const Message *m) {
+  CHECK(m != nullptr);
+  if (m->send_info == nullptr) {
+    static const MessageSendInfo empty_send_info;
+    return empty_send_info;
+  }
+  return *m->send_info;
+}
+
+MessagesManager::MessageSendInfo &MessagesManager::add_message_send_info(Message *m) {
+  CHECK(m != nullptr);
+  if (m->send_info == nullptr) {
+    m->send_info = make_unique<MessageSendInfo>();
+  }
+  return *m->send_info;
 }
 
 vector<FileId> MessagesManager::get_message_file_ids(const Message *m) const {
@@ -23249,7 +23536,7 @@ void MessagesManager::add_message_dependencies(Dependencies &dependencies, const
   m->saved_messages_topic_id.add_dependencies(dependencies);
   m->replied_message_info.add_dependencies(dependencies, is_bot);
   dependencies.add_dialog_and_dependencies(m->reply_to_story_full_id.get_dialog_id());
-  dependencies.add_dialog_and_dependencies(m->real_forward_from_dialog_id);
+  dependencies.add_dialog_and_dependencies(get_message_send_info(m).real_forward_from_dialog_id);
   dependencies.add(m->via_bot_user_id);
   dependencies.add(m->via_business_bot_user_id);
   if (m->forward_info != nullptr) {
@@ -23301,7 +23588,7 @@ void MessagesManager::get_dialog_send_message_as_dialog_ids(
       };
       std::multimap<int64, Sender> sorted_senders;
 
-      bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+      bool is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
       auto linked_channel_id = td_->chat_manager_->get_channel_linked_channel_id(
           dialog_id.get_channel_id(), "get_dialog_send_message_as_dialog_ids");
       for (auto channel_id : created_public_broadcasts) {
@@ -23467,7 +23754,7 @@ Result<td_api::object_ptr<td_api::message>> MessagesManager::send_message(
     m->ttl = message_content.ttl;
     m->is_content_secret = m->ttl.is_secret_message_content(m->content->get_type());
   }
-  m->send_emoji = std::move(message_content.emoji);
+  add_message_send_info(m).send_emoji = std::move(message_content.emoji);
 
   if (message_send_options.only_preview) {
     return get_message_object(dialog_id, m, "send_message");
@@ -23527,10 +23814,10 @@ Result<InputMessageContent> MessagesManager::process_input_message_content(
 
     return InputMessageContent(std::move(content), get_message_disable_web_page_preview(copied_message),
                                copied_message->invert_media, false, MessageSelfDestructType(), UserId(),
-                               copied_message->send_emoji);
+                               get_message_send_info(copied_message).send_emoji);
   }
 
-  bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  bool is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
   TRY_RESULT(content, get_input_message_content(dialog_id, std::move(input_message_content), td_, is_premium));
 
   if (dialog_id != DialogId()) {
@@ -23814,8 +24101,8 @@ void MessagesManager::do_send_message(DialogId dialog_id, const Message *m, vect
       on_secret_message_media_uploaded(dialog_id, m, std::move(secret_input_media), file_id, thumbnail_file_id);
     }
   } else {
-    auto input_media =
-        get_input_media(content, td_, m->ttl, m->send_emoji, td_->auth_manager_->is_bot() && bad_parts.empty());
+    auto input_media = get_input_media(content, td_, m->ttl, get_message_send_info(m).send_emoji,
+                                       td_->auth_manager_->is_bot() && bad_parts.empty());
     if (input_media == nullptr) {
       if (content_type == MessageContentType::Game || content_type == MessageContentType::Poll ||
           content_type == MessageContentType::Story) {
@@ -23894,7 +24181,7 @@ void MessagesManager::on_message_media_uploaded(DialogId dialog_id, const Messag
                          td_->create_handler<SendMediaQuery>()->send(
                              file_id, thumbnail_file_id, get_message_flags(m), dialog_id,
                              get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
-                             m->initial_top_thread_message_id, get_message_schedule_date(m),
+                             get_message_send_info(m).initial_top_thread_message_id, get_message_schedule_date(m),
                              get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
                              get_input_message_entities(td_->user_manager_.get(), caption, "on_message_media_uploaded"),
                              caption == nullptr ? "" : caption->text, std::move(input_media), m->content->get_type(),
@@ -23987,7 +24274,7 @@ void MessagesManager::send_secret_message(DialogId dialog_id, const Message *m,
   }
 
   int32 flags = 0;
-  if (m->reply_to_random_id != 0) {
+  if (get_message_send_info(m).reply_to_random_id != 0) {
     flags |= secret_api::decryptedMessage::REPLY_TO_RANDOM_ID_MASK;
   }
   if (m->via_bot_user_id.is_valid()) {
@@ -24012,8 +24299,8 @@ void MessagesManager::send_secret_message(DialogId dialog_id, const Message *m,
       make_tl_object<secret_api::decryptedMessage>(
           flags, false /*ignored*/, random_id, m->ttl.get_input_ttl(),
           m->content->get_type() == MessageContentType::Text ? text->text : string(), std::move(media.decrypted_media_),
-          std::move(entities), td_->user_manager_->get_user_first_username(m->via_bot_user_id), m->reply_to_random_id,
-          -m->media_album_id),
+          std::move(entities), td_->user_manager_->get_user_first_username(m->via_bot_user_id),
+          get_message_send_info(m).reply_to_random_id, -m->media_album_id),
       std::move(media.input_file_), Promise<Unit>());
 }
 
@@ -24053,7 +24340,7 @@ void MessagesManager::on_upload_message_media_success(DialogId dialog_id, Messag
     on_message_changed(d, m, need_update, "on_upload_message_media_success");
   }
 
-  auto input_media = get_input_media(m->content.get(), td_, m->ttl, m->send_emoji, true);
+  auto input_media = get_input_media(m->content.get(), td_, m->ttl, get_message_send_info(m).send_emoji, true);
   Status result;
   if (input_media == nullptr) {
     result = Status::Error(400, "Failed to upload file");
@@ -24209,7 +24496,7 @@ void MessagesManager::do_send_message_group(int64 media_album_id) {
     }
 
     input_reply_to = get_message_input_reply_to(m);
-    top_thread_message_id = m->initial_top_thread_message_id;
+    top_thread_message_id = get_message_send_info(m).initial_top_thread_message_id;
     flags = get_message_flags(m);
     schedule_date = get_message_schedule_date(m);
     is_copy = m->is_copy;
@@ -24227,7 +24514,7 @@ void MessagesManager::do_send_message_group(int64 media_album_id) {
     }
 
     const FormattedText *caption = get_message_content_caption(m->content.get());
-    auto input_media = get_input_media(m->content.get(), td_, m->ttl, m->send_emoji, true);
+    auto input_media = get_input_media(m->content.get(), td_, m->ttl, get_message_send_info(m).send_emoji, true);
     if (input_media == nullptr) {
       // TODO return CHECK
       auto file_id = get_message_content_any_file_id(m->content.get());
@@ -24308,15 +24595,15 @@ void MessagesManager::on_text_message_ready_to_send(DialogId dialog_id, MessageI
     if (input_media == nullptr) {
       td_->create_handler<SendMessageQuery>()->send(
           get_message_flags(m), dialog_id, get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
-          m->initial_top_thread_message_id, get_message_schedule_date(m),
+          get_message_send_info(m).initial_top_thread_message_id, get_message_schedule_date(m),
           get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
           get_input_message_entities(td_->user_manager_.get(), message_text, "on_text_message_ready_to_send"),
           message_text->text, m->is_copy, random_id, &m->send_query_ref);
     } else {
       td_->create_handler<SendMediaQuery>()->send(
           FileId(), FileId(), get_message_flags(m), dialog_id, get_send_message_as_input_peer(m),
-          *get_message_input_reply_to(m), m->initial_top_thread_message_id, get_message_schedule_date(m),
-          get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
+          *get_message_input_reply_to(m), get_message_send_info(m).initial_top_thread_message_id,
+          get_message_schedule_date(m), get_input_reply_markup(td_->user_manager_.get(), m->reply_markup),
           get_input_message_entities(td_->user_manager_.get(), message_text, "on_text_message_ready_to_send"),
           message_text->text, std::move(input_media), MessageContentType::Text, m->is_copy, random_id,
           &m->send_query_ref);
@@ -24715,7 +25002,8 @@ void MessagesManager::do_send_inline_query_result_message(DialogId dialog_id, Me
   }
   m->send_query_ref = td_->create_handler<SendInlineBotResultQuery>()->send(
       flags, dialog_id, get_send_message_as_input_peer(m), *get_message_input_reply_to(m),
-      m->initial_top_thread_message_id, get_message_schedule_date(m), random_id, query_id, result_id);
+      get_message_send_info(m).initial_top_thread_message_id, get_message_schedule_date(m), random_id, query_id,
+      result_id);
 }
 
 bool MessagesManager::can_edit_message(DialogId dialog_id, const Message *m, bool is_editing,
@@ -24833,15 +25121,17 @@ bool MessagesManager::can_edit_message(DialogId dialog_id, const Message *m, boo
 }
 
 bool MessagesManager::can_resend_message(const Message *m) const {
-  if (m->send_error_code != 429 && m->send_error_message != "Message is too old to be re-sent automatically" &&
-      m->send_error_message != "SCHEDULE_TOO_MUCH" && m->send_error_message != "SEND_AS_PEER_INVALID" &&
-      m->send_error_message != "QUOTE_TEXT_INVALID" && m->send_error_message != "REPLY_MESSAGE_ID_INVALID") {
+  const auto &send_info = get_message_send_info(m);
+  const auto &error_message = send_info.send_error_message;
+  if (send_info.send_error_code != 429 && error_message != "Message is too old to be re-sent automatically" &&
+      error_message != "SCHEDULE_TOO_MUCH" && error_message != "SEND_AS_PEER_INVALID" &&
+      error_message != "QUOTE_TEXT_INVALID" && error_message != "REPLY_MESSAGE_ID_INVALID") {
     return false;
   }
   if (m->is_bot_start_message) {
     return false;
   }
-  if (m->forward_info != nullptr || m->real_forward_from_dialog_id.is_valid()) {
+  if (m->forward_info != nullptr || send_info.real_forward_from_dialog_id.is_valid()) {
     // TODO implement resending of forwarded messages
     return false;
   }
@@ -25951,8 +26241,9 @@ void MessagesManager::do_forward_messages(DialogId to_dialog_id, DialogId from_d
   vector<int64> random_ids =
       transform(messages, [this, to_dialog_id](const Message *m) { return begin_send_message(to_dialog_id, m); });
   send_closure_later(actor_id(this), &MessagesManager::send_forward_message_query, flags, to_dialog_id,
-                     messages[0]->initial_top_thread_message_id, from_dialog_id, std::move(as_input_peer), message_ids,
-                     std::move(random_ids), schedule_date, get_erase_log_event_promise(log_event_id));
+                     get_message_send_info(messages[0]).initial_top_thread_message_id, from_dialog_id,
+                     std::move(as_input_peer), message_ids, std::move(random_ids), schedule_date,
+                     get_erase_log_event_promise(log_event_id));
 }
 
 void MessagesManager::send_forward_message_query(int32 flags, DialogId to_dialog_id,
@@ -26366,7 +26657,7 @@ Result<td_api::object_ptr<td_api::messages>> MessagesManager::forward_messages(
     fix_forwarded_message(m, to_dialog_id, forwarded_message, forwarded_message_contents[j].media_album_id,
                           drop_author);
     m->in_game_share = in_game_share;
-    m->real_forward_from_message_id = message_id;
+    add_message_send_info(m).real_forward_from_message_id = message_id;
     forwarded_message_id_to_new_message_id.emplace(message_id, m->message_id);
     if (forwarded_message->replied_message_info.is_external()) {
       if (!message_send_options.only_preview) {
@@ -26628,7 +26919,7 @@ Result<vector<MessageId>> MessagesManager::resend_messages(DialogId dialog_id, v
     if (!can_resend_message(m)) {
       return Status::Error(400, "Message can't be re-sent");
     }
-    if (m->try_resend_at > Time::now()) {
+    if (get_message_send_info(m).try_resend_at > Time::now()) {
       return Status::Error(400, "Message can't be re-sent yet");
     }
     if (last_message_id != MessageId()) {
@@ -26690,23 +26981,24 @@ Result<vector<MessageId>> MessagesManager::resend_messages(DialogId dialog_id, v
     CHECK(message != nullptr);
     send_update_delete_messages(dialog_id, {message->message_id.get()}, true);
 
+    auto &send_info = add_message_send_info(message.get());
     auto need_another_sender =
-        message->send_error_code == 400 && message->send_error_message == CSlice("SEND_AS_PEER_INVALID");
+        send_info.send_error_code == 400 && send_info.send_error_message == CSlice("SEND_AS_PEER_INVALID");
     auto need_another_reply_quote =
-        message->send_error_code == 400 && message->send_error_message == CSlice("QUOTE_TEXT_INVALID");
+        send_info.send_error_code == 400 && send_info.send_error_message == CSlice("QUOTE_TEXT_INVALID");
     auto need_drop_reply =
-        message->send_error_code == 400 && message->send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
+        send_info.send_error_code == 400 && send_info.send_error_message == CSlice("REPLY_MESSAGE_ID_INVALID");
     if (need_another_reply_quote && message_ids.size() == 1 && quote != nullptr) {
-      CHECK(message->input_reply_to.is_valid());
-      CHECK(message->input_reply_to.has_quote());  // checked in on_send_message_fail
-      message->input_reply_to.set_quote(MessageQuote{td_, std::move(quote)});
+      CHECK(send_info.input_reply_to.is_valid());
+      CHECK(send_info.input_reply_to.has_quote());  // checked in on_send_message_fail
+      send_info.input_reply_to.set_quote(MessageQuote{td_, std::move(quote)});
     } else if (need_drop_reply) {
-      message->input_reply_to = {};
+      send_info.input_reply_to = {};
     }
     MessageSendOptions options(message->disable_notification, message->from_background,
                                message->update_stickersets_order, message->noforwards, false,
                                get_message_schedule_date(message.get()), message->sending_id);
-    Message *m = get_message_to_send(d, message->top_thread_message_id, std::move(message->input_reply_to), options,
+    Message *m = get_message_to_send(d, message->top_thread_message_id, std::move(send_info.input_reply_to), options,
                                      std::move(new_contents[i]), message->invert_media, &need_update_dialog_pos, false,
                                      nullptr, DialogId(), message->is_copy,
                                      need_another_sender ? DialogId() : get_message_sender(message.get()));
@@ -26717,7 +27009,7 @@ Result<vector<MessageId>> MessagesManager::resend_messages(DialogId dialog_id, v
     m->ttl = message->ttl;
     m->is_content_secret = message->is_content_secret;
     m->media_album_id = new_media_album_ids[message->media_album_id].first;
-    m->send_emoji = message->send_emoji;
+    add_message_send_info(m).send_emoji = send_info.send_emoji;
     m->has_explicit_sender |= message->has_explicit_sender;
 
     save_send_message_log_event(dialog_id, m);
@@ -26951,7 +27243,7 @@ Result<MessageId> MessagesManager::add_local_message(
     m->ttl = message_content.ttl;
   }
   m->is_content_secret = m->ttl.is_secret_message_content(m->content->get_type());
-  m->send_emoji = std::move(message_content.emoji);
+  add_message_send_info(m).send_emoji = std::move(message_content.emoji);
   if (dialog_id == DialogId(my_id)) {
     m->saved_messages_topic_id = SavedMessagesTopicId(dialog_id, m->forward_info.get(), DialogId());
   }
@@ -28493,14 +28785,40 @@ void MessagesManager::send_update_chat_last_message_impl(const Dialog *d, const
   CHECK(d != nullptr);
   LOG_CHECK(d->is_update_new_chat_sent) << "Wrong " << d->dialog_id << " in send_update_chat_last_message from "
                                         << source;
-  LOG(INFO) << "Send updateChatLastMessage in " << d->dialog_id << " to " << d->last_message_id << " from " << source;
-  const auto *m = get_message(d, d->last_message_id);
-  auto message_object = get_message_object(d->dialog_id, m, "send_update_chat_last_message_impl");
-  auto positions_object = get_chat_positions_object(d);
-  auto update =
-      td_api::make_object<td_api::updateChatLastMessage>(get_chat_id_object(d->dialog_id, "updateChatLastMessage"),
-                                                         std::move(message_object), std::move(positions_object));
-  send_closure(G()->td(), &Td::send_update, std::move(update));
+  if (d->has_pending_update_chat_last_message) {
+    LOG(INFO) << "Coalesce updateChatLastMessage in " << d->dialog_id << " to " << d->last_message_id << " from "
+              << source;
+    return;
+  }
+
+  // all changes of the last message made while handling the current event are sent as a single update
+  LOG(INFO) << "Postpone updateChatLastMessage in " << d->dialog_id << " to " << d->last_message_id << " from "
+            << source;
+  d->has_pending_update_chat_last_message = true;
+  if (pending_update_chat_last_message_dialog_ids_.empty()) {
+    send_closure_later(G()->messages_manager(), &MessagesManager::flush_pending_update_chat_last_messages);
+  }
+  pending_update_chat_last_message_dialog_ids_.push_back(d->dialog_id);
+}
+
+void MessagesManager::flush_pending_update_chat_last_messages() {
+  auto dialog_ids = std::move(pending_update_chat_last_message_dialog_ids_);
+  pending_update_chat_last_message_dialog_ids_.clear();
+  for (auto dialog_id : dialog_ids) {
+    const Dialog *d = get_dialog(dialog_id);
+    CHECK(d != nullptr);
+    CHECK(d->has_pending_update_chat_last_message);
+    d->has_pending_update_chat_last_message = false;
+
+    LOG(INFO) << "Send updateChatLastMessage in " << dialog_id << " to " << d->last_message_id;
+    const auto *m = get_message(d, d->last_message_id);
+    auto message_object = get_message_object(dialog_id, m, "flush_pending_update_chat_last_messages");
+    auto positions_object = get_chat_positions_object(d);
+    auto update =
+        td_api::make_object<td_api::updateChatLastMessage>(get_chat_id_object(dialog_id, "updateChatLastMessage"),
+                                                           std::move(message_object), std::move(positions_object));
+    send_closure(G()->td(), &Td::send_update, std::move(update));
+  }
 }
 
 void MessagesManager::send_update_unread_message_count(DialogList &list, DialogId dialog_id, bool force,
@@ -29516,12 +29834,13 @@ void MessagesManager::fail_send_message(MessageFullId message_full_id, int32 err
     message->view_count = 0;
   }
   message->is_failed_to_send = true;
-  message->send_error_code = error_code;
-  message->send_error_message = error_message;
-  message->try_resend_at = 0.0;
+  auto &send_info = add_message_send_info(message.get());
+  send_info.send_error_code = error_code;
+  send_info.send_error_message = error_message;
+  send_info.try_resend_at = 0.0;
   auto retry_after = Global::get_retry_after(error_code, error_message);
   if (retry_after > 0) {
-    message->try_resend_at = Time::now() + retry_after;
+    send_info.try_resend_at = Time::now() + retry_after;
   }
   update_failed_to_send_message_content(td_, message->content);
 
@@ -29659,10 +29978,11 @@ void MessagesManager::clear_dialog_draft_by_sent_message(Dialog *d, const Messag
   if (td_->auth_manager_->is_bot()) {
     return;
   }
+  auto initial_top_thread_message_id = get_message_send_info(m).initial_top_thread_message_id;
   if (!m->clear_draft) {
     const DraftMessage *draft_message = nullptr;
-    if (m->initial_top_thread_message_id.is_valid()) {
-      auto top_m = get_message_force(d, m->initial_top_thread_message_id, "clear_dialog_draft_by_sent_message");
+    if (initial_top_thread_message_id.is_valid()) {
+      auto top_m = get_message_force(d, initial_top_thread_message_id, "clear_dialog_draft_by_sent_message");
       if (top_m != nullptr) {
         draft_message = top_m->thread_draft_message.get();
       }
@@ -29673,8 +29993,8 @@ void MessagesManager::clear_dialog_draft_by_sent_message(Dialog *d, const Messag
       return;
     }
   }
-  if (m->initial_top_thread_message_id.is_valid()) {
-    set_dialog_draft_message(d->dialog_id, m->initial_top_thread_message_id, nullptr).ignore();
+  if (initial_top_thread_message_id.is_valid()) {
+    set_dialog_draft_message(d->dialog_id, initial_top_thread_message_id, nullptr).ignore();
   } else {
     update_dialog_draft_message(d, nullptr, false, need_update_dialog_pos);
   }
@@ -29877,8 +30197,9 @@ void MessagesManager::set_dialog_is_marked_as_unread(Dialog *d, bool is_marked_a
       }
     }
 
-    if (td_->dialog_filter_manager_->have_dialog_filters()) {
-      update_dialog_lists(d, get_dialog_positions(d), true, false, "set_dialog_is_marked_as_unread");
+    if (td_->dialog_filter_manager_->is_some_dialog_filter_affected(DialogFilterDialogInfo::HasUnreadMessages)) {
+      update_dialog_lists(d, get_dialog_positions(d), true, false, "set_dialog_is_marked_as_unread",
+                          DialogFilterDialogInfo::HasUnreadMessages);
     }
   }
 }
@@ -29934,7 +30255,7 @@ void MessagesManager::set_dialog_is_translatable(Dialog *d, bool is_translatable
 
   LOG(INFO) << "Set " << d->dialog_id << " is translatable to " << is_translatable;
   LOG_CHECK(d->is_update_new_chat_sent) << "Wrong " << d->dialog_id << " in set_dialog_is_translatable";
-  bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  bool is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
   if (is_premium) {
     send_closure(G()->td(), &Td::send_update,
                  td_api::make_object<td_api::updateChatIsTranslatable>(
@@ -30792,14 +31113,17 @@ void MessagesManager::on_dialog_user_is_contact_updated(DialogId dialog_id, bool
       }
     }
 
-    if (td_->dialog_filter_manager_->have_dialog_filters() && d->order != DEFAULT_ORDER) {
-      update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_contact_updated");
+    if (d->order != DEFAULT_ORDER &&
+        td_->dialog_filter_manager_->is_some_dialog_filter_affected(DialogFilterDialogInfo::UserType)) {
+      update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_contact_updated",
+                          DialogFilterDialogInfo::UserType);
       td_->user_manager_->for_each_secret_chat_with_user(
           d->dialog_id.get_user_id(), [this](SecretChatId secret_chat_id) {
             DialogId dialog_id(secret_chat_id);
             auto d = get_dialog(dialog_id);  // must not create the dialog
             if (d != nullptr && d->is_update_new_chat_sent && d->order != DEFAULT_ORDER) {
-              update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_contact_updated");
+              update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_contact_updated",
+                                  DialogFilterDialogInfo::UserType);
             }
           });
     }
@@ -30823,13 +31147,16 @@ void MessagesManager::on_dialog_user_is_deleted_updated(DialogId dialog_id, bool
       }
     }
 
-    if (td_->dialog_filter_manager_->have_dialog_filters() && d->order != DEFAULT_ORDER) {
-      update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_deleted_updated");
+    if (d->order != DEFAULT_ORDER &&
+        td_->dialog_filter_manager_->is_some_dialog_filter_affected(DialogFilterDialogInfo::UserType)) {
+      update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_deleted_updated",
+                          DialogFilterDialogInfo::UserType);
       td_->user_manager_->for_each_secret_chat_with_user(dialog_id.get_user_id(), [this](SecretChatId secret_chat_id) {
         DialogId dialog_id(secret_chat_id);
         auto d = get_dialog(dialog_id);  // must not create the dialog
         if (d != nullptr && d->is_update_new_chat_sent && d->order != DEFAULT_ORDER) {
-          update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_deleted_updated");
+          update_dialog_lists(d, get_dialog_positions(d), true, false, "on_dialog_user_is_deleted_updated",
+                              DialogFilterDialogInfo::UserType);
         }
       });
     }
@@ -31809,6 +32136,10 @@ MessagesManager::Message *MessagesManager::get_message_force(Dialog *d, MessageI
     return nullptr;
   }
 
+  if (d->dialog_id == missing_database_messages_dialog_id_ && missing_database_message_ids_.count(message_id) > 0) {
+    return nullptr;
+  }
+
   LOG(INFO) << "Trying to load " << MessageFullId{d->dialog_id, message_id} << " from database from " << source;
 
   auto r_value = G()->td_db()->get_message_db_sync()->get_message({d->dialog_id, message_id});
@@ -31818,6 +32149,55 @@ MessagesManager::Message *MessagesManager::get_message_force(Dialog *d, MessageI
   return on_get_message_from_database(d, r_value.ok(), message_id.is_scheduled(), source);
 }
 
+void MessagesManager::preload_history_messages_from_database(
+    Dialog *d, const vector<tl_object_ptr<telegram_api::Message>> &messages) {
+  CHECK(missing_database_message_ids_.empty());
+  if (!G()->use_message_database()) {
+    return;
+  }
+
+  // messages are sorted in decreasing message_id order
+  vector<MessageId> message_ids;
+  for (const auto &message : messages) {
+    auto message_id = MessageId::get_message_id(message, false);
+    if (message_id.is_valid() && DialogId::get_message_dialog_id(message) == d->dialog_id &&
+        get_message(d, message_id) == nullptr && !is_deleted_message(d, message_id)) {
+      message_ids.push_back(message_id);
+    }
+  }
+  if (message_ids.size() <= 1) {
+    // a single message can be found by identifier
+    return;
+  }
+
+  // load all messages from the range with one query instead of searching for each of them separately
+  auto limit = static_cast<int32>(2 * message_ids.size());
+  auto database_messages = G()->td_db()->get_message_db_sync()->get_messages(
+      {d->dialog_id, MessageSearchFilter::Empty, message_ids[0].get_next_message_id(MessageType::Server), 0, limit});
+  LOG(INFO) << "Preloaded " << database_messages.size() << " messages from " << message_ids.back() << " to "
+            << message_ids[0] << " in " << d->dialog_id << " from database";
+
+  auto min_loaded_message_id = message_ids.back();
+  if (database_messages.size() == static_cast<size_t>(limit)) {
+    min_loaded_message_id = td::max(min_loaded_message_id, database_messages.back().message_id);
+  }
+  FlatHashSet<MessageId, MessageIdHash> database_message_ids;
+  for (auto &database_message : database_messages) {
+    database_message_ids.insert(database_message.message_id);
+    if (std::binary_search(message_ids.begin(), message_ids.end(), database_message.message_id,
+                           std::greater<>())) {
+      on_get_message_from_database(d, database_message, false, "preload_history_messages_from_database");
+    }
+  }
+
+  missing_database_messages_dialog_id_ = d->dialog_id;
+  for (auto message_id : message_ids) {
+    if (message_id >= min_loaded_message_id && database_message_ids.count(message_id) == 0) {
+      missing_database_message_ids_.insert(message_id);
+    }
+  }
+}
+
 MessagesManager::Message *MessagesManager::on_get_message_from_database(const MessageDbMessage &message,
                                                                         bool is_scheduled, const char *source) {
   if (message.data.empty()) {
@@ -32709,6 +33089,8 @@ MessagesManager::Message *MessagesManager::add_message_to_dialog(Dialog *d, uniq
 
   Message *result_message = message.get();
   d->messages.set(message_id, std::move(message));
+  loaded_message_count_++;
+  check_message_cache_size();
 
   d->message_lru_list.put_back(result_message);
 
@@ -33438,7 +33820,8 @@ bool MessagesManager::update_message(Dialog *d, Message *old_message, unique_ptr
       LOG(ERROR) << message_id << " in " << dialog_id << " sent by " << old_message->sender_user_id << "/"
                  << old_message->sender_dialog_id << " has changed forward info from " << old_message->forward_info
                  << " to " << new_message->forward_info << ", really forwarded from "
-                 << old_message->real_forward_from_message_id << " in " << old_message->real_forward_from_dialog_id
+                 << get_message_send_info(old_message).real_forward_from_message_id << " in "
+                 << get_message_send_info(old_message).real_forward_from_dialog_id
                  << ", message content type is " << old_content_type << '/' << new_content_type;
     } else {
       LOG(DEBUG) << "Message forward info has changed from " << old_message->forward_info << " to "
@@ -33578,7 +33961,10 @@ bool MessagesManager::update_message(Dialog *d, Message *old_message, unique_ptr
     old_message->reply_to_story_full_id = new_message->reply_to_story_full_id;
     old_message->top_thread_message_id = new_message->top_thread_message_id;
     old_message->is_topic_message = new_message->is_topic_message;
-    old_message->reply_to_random_id = get_message_reply_to_random_id(d, old_message);
+    auto reply_to_random_id = get_message_reply_to_random_id(d, old_message);
+    if (reply_to_random_id != get_message_send_info(old_message).reply_to_random_id) {
+      add_message_send_info(old_message).reply_to_random_id = reply_to_random_id;
+    }
 
     if (is_message_in_dialog) {
       register_message_reply(d->dialog_id, old_message);
@@ -33827,7 +34213,7 @@ bool MessagesManager::need_message_changed_warning(const Message *old_message) {
   }
   if (old_message->message_id.is_yet_unsent() &&
       (old_message->forward_info != nullptr || old_message->had_forward_info ||
-       old_message->real_forward_from_dialog_id.is_valid())) {
+       get_message_send_info(old_message).real_forward_from_dialog_id.is_valid())) {
     // original message may be edited
     return false;
   }
@@ -35051,7 +35437,7 @@ bool MessagesManager::set_dialog_order(Dialog *d, int64 new_order, bool need_sen
 
 void MessagesManager::update_dialog_lists(
     Dialog *d, std::unordered_map<DialogListId, DialogPositionInList, DialogListIdHash> &&old_positions,
-    bool need_send_update, bool is_loaded_from_database, const char *source) {
+    bool need_send_update, bool is_loaded_from_database, const char *source, int32 changed_dialog_properties) {
   if (td_->auth_manager_->is_bot()) {
     return;
   }
@@ -35086,7 +35472,11 @@ void MessagesManager::update_dialog_lists(
     auto &list = dialog_list.second;
 
     const DialogPositionInList &old_position = old_positions[dialog_list_id];
-    const DialogPositionInList new_position = get_dialog_position_in_list(&list, d, true);
+    // the dialog is kept in chat folders, which don't depend on the changed dialog properties
+    bool need_check_list = !dialog_list_id.is_filter() || d->order == DEFAULT_ORDER ||
+                           td_->dialog_filter_manager_->is_dialog_filter_affected(dialog_list_id.get_filter_id(),
+                                                                                  changed_dialog_properties);
+    const DialogPositionInList new_position = get_dialog_position_in_list(&list, d, need_check_list);
 
     // sponsored chat is never "in list"
     bool was_in_list = old_position.order != DEFAULT_ORDER && old_position.private_order != 0;
@@ -35921,23 +36311,33 @@ void MessagesManager::do_get_channel_difference(DialogId dialog_id, int32 pts, b
     limit = MIN_CHANNEL_DIFFERENCE;
   }
 
-  pending_get_channel_differences_.push(
-      td::make_unique<PendingGetChannelDifference>(dialog_id, pts, limit, force, std::move(input_channel), source));
+  auto query =
+      td::make_unique<PendingGetChannelDifference>(dialog_id, pts, limit, force, std::move(input_channel), source);
+  if (d != nullptr && (d->server_unread_count + d->local_unread_count > 0 || d->unread_mention_count > 0)) {
+    pending_important_get_channel_differences_.push(std::move(query));
+  } else {
+    pending_get_channel_differences_.push(std::move(query));
+  }
   process_pending_get_channel_differences();
 }
 
 void MessagesManager::process_pending_get_channel_differences() {
   static constexpr int32 MAX_CONCURRENT_GET_CHANNEL_DIFFERENCES = 10;
 
-  if (pending_get_channel_differences_.empty() ||
-      get_channel_difference_count_ >= MAX_CONCURRENT_GET_CHANNEL_DIFFERENCES) {
+  if (get_channel_difference_count_ >= MAX_CONCURRENT_GET_CHANNEL_DIFFERENCES) {
+    return;
+  }
+  auto &pending_queries = !pending_important_get_channel_differences_.empty()
+                              ? pending_important_get_channel_differences_
+                              : pending_get_channel_differences_;
+  if (pending_queries.empty()) {
     return;
   }
 
   get_channel_difference_count_++;
 
-  auto query = std::move(pending_get_channel_differences_.front());
-  pending_get_channel_differences_.pop();
+  auto query = std::move(pending_queries.front());
+  pending_queries.pop();
 
   LOG(INFO) << "-----BEGIN GET CHANNEL DIFFERENCE----- for " << query->dialog_id_ << " with PTS " << query->pts_
             << " and limit " << query->limit_ << " from " << query->source_;
@@ -36846,9 +37246,12 @@ void MessagesManager::set_message_reply(const Dialog *d, Message *m, MessageInpu
   }
   m->replied_message_info = RepliedMessageInfo(td_, input_reply_to);
   m->reply_to_story_full_id = StoryFullId();
-  m->reply_to_random_id = get_message_reply_to_random_id(d, m);
+  auto reply_to_random_id = get_message_reply_to_random_id(d, m);
+  if (reply_to_random_id != get_message_send_info(m).reply_to_random_id) {
+    add_message_send_info(m).reply_to_random_id = reply_to_random_id;
+  }
   if (!m->message_id.is_any_server()) {
-    m->input_reply_to = std::move(input_reply_to);
+    add_message_send_info(m).input_reply_to = std::move(input_reply_to);
   }
   if (is_message_in_dialog) {
     register_message_reply(d->dialog_id, m);
@@ -36865,7 +37268,7 @@ void MessagesManager::update_message_reply_to_message_id(const Dialog *d, Messag
   }
   m->replied_message_info.set_message_id(reply_to_message_id);
   if (!m->message_id.is_any_server()) {
-    m->input_reply_to.set_message_id(reply_to_message_id);
+    add_message_send_info(m).input_reply_to.set_message_id(reply_to_message_id);
   }
   if (is_message_in_dialog) {
     register_message_reply(d->dialog_id, m);
@@ -36887,7 +37290,8 @@ void MessagesManager::restore_message_reply_to_message_id(Dialog *d, Message *m)
   LOG_CHECK(m->replied_message_info.get_reply_message_full_id(d->dialog_id, true) == replied_message_full_id)
       << replied_message_full_id << ' ' << m->replied_message_info << ' ' << *input_reply_to;
 
-  auto message_id = get_message_id_by_random_id(d, m->reply_to_random_id, "restore_message_reply_to_message_id");
+  auto reply_to_random_id = get_message_send_info(m).reply_to_random_id;
+  auto message_id = get_message_id_by_random_id(d, reply_to_random_id, "restore_message_reply_to_message_id");
   if (message_id.is_valid() || message_id.is_valid_scheduled()) {
     update_message_reply_to_message_id(d, m, message_id, false);
   } else {
@@ -79,6 +79,7 @@
 
 #include "td/utils/buffer.h"
 #include "td/utils/ChangesProcessor.h"
+#include "td/utils/ChunkedSet.h"
 #include "td/utils/common.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashSet.h"
@@ -963,6 +964,12 @@ class MessagesManager final : public Actor {
 
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
+  void on_message_cache_max_count_changed();
+
+  td_api::object_ptr<td_api::messageCacheStatistics> get_message_cache_statistics_object() const;
+
+  void reduce_memory_usage();
+
   void add_message_file_to_downloads(MessageFullId message_full_id, FileId file_id, int32 priority,
                                      Promise<td_api::object_ptr<td_api::file>> promise);
 
@@ -1022,6 +1029,21 @@ class MessagesManager final : public Actor {
     tl_object_ptr<telegram_api::ReplyMarkup> reply_markup;
   };
 
+  // fields of Message, which are used only for messages being sent, resent or failed to send
+  struct MessageSendInfo {
+    MessageId initial_top_thread_message_id;  // for send_message
+    MessageInputReplyTo input_reply_to;       // for send_message
+    int64 reply_to_random_id = 0;             // for send_message
+    string send_emoji;                        // for send_message
+
+    DialogId real_forward_from_dialog_id;    // for resend_message
+    MessageId real_forward_from_message_id;  // for resend_message
+
+    int32 send_error_code = 0;
+    string send_error_message;
+    double try_resend_at = 0;
+  };
+
   // Do not forget to update MessagesManager::update_message and all make_unique<Message> when this class is changed
   struct Message final : public ListNode {
     MessageId message_id;
@@ -1045,11 +1067,6 @@ class MessagesManager final : public Actor {
     MessageId linked_top_thread_message_id;
     vector<MessageId> local_thread_message_ids;
 
-    MessageId initial_top_thread_message_id;  // for send_message
-    MessageInputReplyTo input_reply_to;       // for send_message
-    int64 reply_to_random_id = 0;             // for send_message
-    string send_emoji;                        // for send_message
-
     UserId via_bot_user_id;
     UserId via_business_bot_user_id;
 
@@ -1091,9 +1108,6 @@ class MessagesManager final : public Actor {
 
     bool has_get_extended_media_query = false;
 
-    DialogId real_forward_from_dialog_id;    // for resend_message
-    MessageId real_forward_from_message_id;  // for resend_message
-
     NotificationId notification_id;
     NotificationId removed_notification_id;
 
@@ -1111,9 +1125,7 @@ class MessagesManager final : public Actor {
 
     int32 legacy_layer = 0;
 
-    int32 send_error_code = 0;
-    string send_error_message;
-    double try_resend_at = 0;
+    unique_ptr<MessageSendInfo> send_info;  // allocated only when any of the fields is set
 
     int32 ttl_period = 0;         // counted from message send date
     MessageSelfDestructType ttl;  // counted from message content view date
@@ -1310,6 +1322,7 @@ class MessagesManager final : public Actor {
 
     bool is_update_new_chat_sent = false;
     bool is_update_new_chat_being_sent = false;
+    mutable bool has_pending_update_chat_last_message = false;
     bool has_unload_timeout = false;
     bool is_channel_difference_finished = false;
 
@@ -1319,6 +1332,10 @@ class MessagesManager final : public Actor {
     MessageId pending_read_channel_inbox_max_message_id;       // for channels only
     FlatHashMap<int64, MessageId> random_id_to_message_id;     // for secret chats and yet unsent messages only
 
+    MessageId last_history_min_message_id;  // the oldest message returned by the last getChatHistory request
+    int32 sequential_history_request_count = 0;  // number of consecutive getChatHistory requests continuing
+                                                  // from the oldest message returned by the previous request
+
     MessageId last_assigned_message_id;  // identifier of the last local or yet unsent message, assigned after
                                          // application start, used to guarantee that all assigned message identifiers
                                          // are different
@@ -1390,7 +1407,7 @@ class MessagesManager final : public Actor {
     // date of the last loaded dialog in the folder
     DialogDate folder_last_dialog_date_{MAX_ORDINARY_DIALOG_ORDER, DialogId()};  // in memory
 
-    std::set<DialogDate> ordered_dialogs_;  // all known dialogs, including with default order
+    ChunkedSet<DialogDate> ordered_dialogs_;  // all known dialogs, including with default order
 
     // date of last known user/group/channel dialog in the right order
     DialogDate last_server_dialog_date_{MAX_ORDINARY_DIALOG_ORDER, DialogId()};
@@ -1400,6 +1417,7 @@ class MessagesManager final : public Actor {
     MultiPromiseActor load_folder_dialog_list_multipromise_{
         "LoadDialogListMultiPromiseActor"};  // must be defined before pending_on_get_dialogs_
     int32 load_dialog_list_limit_max_ = 0;
+    int32 preload_dialog_list_limit_ = MIN_PRELOADED_DIALOGS;  // adapted to the observed chat loading time
   };
 
   class DialogListViewIterator {
@@ -1585,6 +1603,11 @@ class MessagesManager final : public Actor {
   static constexpr int32 MAX_CHANNEL_DIFFERENCE = 100;
   static constexpr int32 MAX_BOT_CHANNEL_DIFFERENCE = 100000;  // server side limit
   static constexpr int32 MAX_RECENT_DIALOGS = 50;              // some reasonable value
+  static constexpr double FOUND_PUBLIC_DIALOGS_CACHE_TIME = 300.0;  // seconds, some reasonable value
+  static constexpr size_t MAX_FOUND_PUBLIC_DIALOGS_QUERIES = 1000;  // some reasonable value
+  static constexpr int32 MIN_PRELOADED_DIALOGS = 20;
+  static constexpr int32 MAX_PRELOADED_DIALOGS = 1000;
+  static constexpr double MAX_PRELOAD_DIALOG_LIST_TIME = 0.02;  // seconds, maximum time to block the actor
   static constexpr size_t MIN_DELETED_ASYNCHRONOUSLY_MESSAGES = 2;
   static constexpr size_t MAX_UNLOADED_MESSAGES = 5000;
 
@@ -1606,7 +1629,10 @@ class MessagesManager final : public Actor {
   static constexpr int32 MIN_READ_HISTORY_DELAY = 3;  // seconds
   static constexpr int32 MAX_SAVE_DIALOG_DELAY = 0;   // seconds
 
+  static constexpr double MESSAGE_INTERACTION_INFO_UPDATE_DELAY = 0.5;  // seconds
+
   static constexpr int32 DEFAULT_LOADED_EXPIRED_MESSAGES = 50;
+  static constexpr double TTL_EXPIRATION_BATCH_DELAY = 0.2;  // seconds, to expire message bursts at once
 
   static constexpr int32 LIVE_LOCATION_VIEW_PERIOD = 60;      // seconds, server-side limit
   static constexpr int32 UPDATE_VIEWED_MESSAGES_PERIOD = 15;  // seconds
@@ -1671,6 +1697,9 @@ class MessagesManager final : public Actor {
 
   void delete_update_message_id(DialogId dialog_id, MessageId message_id);
 
+  void on_get_dialog_message_count_from_database(DialogId dialog_id, MessageSearchFilter filter,
+                                                 Result<int32> r_message_count, Promise<int32> &&promise);
+
   void get_dialog_message_count_from_server(DialogId dialog_id, SavedMessagesTopicId saved_messages_topic_id,
                                             MessageSearchFilter filter, Promise<int32> &&promise);
 
@@ -1746,6 +1775,10 @@ class MessagesManager final : public Actor {
 
   static const MessageInputReplyTo *get_message_input_reply_to(const Message *m);
 
+  static const MessageSendInfo &get_message_send_info(const Message *m);
+
+  static MessageSendInfo &add_message_send_info(Message *m);
+
   bool can_set_game_score(DialogId dialog_id, const Message *m) const;
 
   void add_postponed_channel_update(DialogId dialog_id, tl_object_ptr<telegram_api::Update> &&update, int32 new_pts,
@@ -1944,6 +1977,14 @@ class MessagesManager final : public Actor {
 
   void unload_dialog(DialogId dialog_id, int32 delay);
 
+  void unload_dialog_messages(Dialog *d, const vector<MessageId> &to_unload_message_ids);
+
+  void check_message_cache_size();
+
+  void unload_least_recently_used_messages();
+
+  void do_unload_least_recently_used_messages(size_t unload_count);
+
   void clear_dialog_message_list(Dialog *d, bool remove_from_dialog_list, int32 last_message_date);
 
   void delete_all_dialog_messages(Dialog *d, bool remove_from_dialog_list, bool is_permanently_deleted);
@@ -1994,6 +2035,12 @@ class MessagesManager final : public Actor {
 
   void on_pending_message_views_timeout(DialogId dialog_id);
 
+  void queue_update_message_interaction_info(DialogId dialog_id, const Message *m);
+
+  void remove_pending_message_interaction_info_update(DialogId dialog_id, const Message *m, bool need_send_update);
+
+  void on_pending_message_interaction_info_timeout(DialogId dialog_id);
+
   void update_message_interaction_info(MessageFullId message_full_id, int32 view_count, int32 forward_count,
                                        bool has_reply_info, tl_object_ptr<telegram_api::messageReplies> &&reply_info,
                                        bool has_reactions, unique_ptr<MessageReactions> &&reactions);
@@ -2095,7 +2142,7 @@ class MessagesManager final : public Actor {
 
   void preload_newer_messages(const Dialog *d, MessageId max_message_id);
 
-  void preload_older_messages(const Dialog *d, MessageId min_message_id);
+  void preload_older_messages(const Dialog *d, MessageId min_message_id, bool is_sequential_scroll = false);
 
   void load_last_dialog_message_later(DialogId dialog_id);
 
@@ -2150,6 +2197,8 @@ class MessagesManager final : public Actor {
 
   void load_folder_dialog_list_from_database(FolderId folder_id, int32 limit, Promise<Unit> &&promise);
 
+  static void update_preload_dialog_list_limit(DialogFolder &folder, size_t loaded_dialog_count, double elapsed_time);
+
   void preload_folder_dialog_list(FolderId folder_id);
 
   void get_dialogs_from_list_impl(int64 task_id);
@@ -2349,6 +2398,8 @@ class MessagesManager final : public Actor {
 
   void send_update_chat_last_message_impl(const Dialog *d, const char *source) const;
 
+  void flush_pending_update_chat_last_messages();
+
   void send_update_unread_message_count(DialogList &list, DialogId dialog_id, bool force, const char *source,
                                         bool from_database = false);
 
@@ -2651,6 +2702,17 @@ class MessagesManager final : public Actor {
 
   void send_search_public_dialogs_query(const string &query, Promise<Unit> &&promise);
 
+  struct FoundPublicDialogs {
+    vector<DialogId> public_dialog_ids;
+    vector<DialogId> on_server_dialog_ids;
+    double expires_at = 0.0;
+  };
+
+  const FoundPublicDialogs *get_found_public_dialogs(const string &query);
+
+  void add_found_public_dialogs(const string &query, vector<DialogId> &&public_dialog_ids,
+                                vector<DialogId> &&on_server_dialog_ids);
+
   vector<DialogId> get_pinned_dialog_ids(DialogListId dialog_list_id) const;
 
   bool set_folder_pinned_dialogs(FolderId folder_id, vector<DialogId> old_dialog_ids, vector<DialogId> new_dialog_ids);
@@ -2706,6 +2768,9 @@ class MessagesManager final : public Actor {
 
   Message *get_message_force(MessageFullId message_full_id, const char *source);
 
+  void preload_history_messages_from_database(Dialog *d,
+                                              const vector<tl_object_ptr<telegram_api::Message>> &messages);
+
   void get_message_force_from_server(Dialog *d, MessageId message_id, Promise<Unit> &&promise,
                                      tl_object_ptr<telegram_api::InputMessage> input_message = nullptr);
 
@@ -2914,7 +2979,8 @@ class MessagesManager final : public Actor {
 
   void update_dialog_lists(Dialog *d,
                            std::unordered_map<DialogListId, DialogPositionInList, DialogListIdHash> &&old_positions,
-                           bool need_send_update, bool is_loaded_from_database, const char *source);
+                           bool need_send_update, bool is_loaded_from_database, const char *source,
+                           int32 changed_dialog_properties = DialogFilterDialogInfo::AllProperties);
 
   void update_last_dialog_date(FolderId folder_id);
 
@@ -2977,6 +3043,8 @@ class MessagesManager final : public Actor {
 
   static void on_pending_message_views_timeout_callback(void *messages_manager_ptr, int64 dialog_id_int);
 
+  static void on_pending_message_interaction_info_timeout_callback(void *messages_manager_ptr, int64 dialog_id_int);
+
   static void on_pending_message_live_location_view_timeout_callback(void *messages_manager_ptr, int64 task_id);
 
   static void on_pending_draft_message_timeout_callback(void *messages_manager_ptr, int64 dialog_id_int);
@@ -3234,8 +3302,7 @@ class MessagesManager final : public Actor {
   FlatHashSet<DialogId, DialogIdHash> postponed_chat_read_inbox_updates_;
 
   FlatHashMap<string, vector<Promise<Unit>>> search_public_dialogs_queries_;
-  FlatHashMap<string, vector<DialogId>> found_public_dialogs_;     // TODO time bound cache
-  FlatHashMap<string, vector<DialogId>> found_on_server_dialogs_;  // TODO time bound cache
+  FlatHashMap<string, FoundPublicDialogs> found_public_dialogs_;  // query -> result of contacts.search
 
   FlatHashMap<int64, td_api::object_ptr<td_api::messageCalendar>> found_dialog_message_calendars_;
   FlatHashMap<int64, FoundDialogMessages> found_dialog_messages_;  // random_id -> FoundDialogMessages
@@ -3267,6 +3334,9 @@ class MessagesManager final : public Actor {
   uint64 current_message_edit_generation_ = 0;
 
   std::unordered_set<DialogListId, DialogListIdHash> postponed_unread_message_count_updates_;
+
+  // chats with changed last message, for which updateChatLastMessage will be sent after the current event
+  mutable vector<DialogId> pending_update_chat_last_message_dialog_ids_;
   std::unordered_set<DialogListId, DialogListIdHash> postponed_unread_chat_count_updates_;
 
   int64 current_pinned_dialog_order_ = static_cast<int64>(MIN_PINNED_DIALOG_DATE) << 32;
@@ -3295,6 +3365,8 @@ class MessagesManager final : public Actor {
     }
   };
   std::queue<unique_ptr<PendingGetChannelDifference>> pending_get_channel_differences_;
+  // differences in chats with unread messages or mentions are fetched first
+  std::queue<unique_ptr<PendingGetChannelDifference>> pending_important_get_channel_differences_;
   int32 get_channel_difference_count_ = 0;
 
   FlatHashMap<DialogId, string, DialogIdHash> active_get_channel_differences_;
@@ -3308,6 +3380,7 @@ class MessagesManager final : public Actor {
   MultiTimeout channel_get_difference_timeout_{"ChannelGetDifferenceTimeout"};
   MultiTimeout channel_get_difference_retry_timeout_{"ChannelGetDifferenceRetryTimeout"};
   MultiTimeout pending_message_views_timeout_{"PendingMessageViewsTimeout"};
+  MultiTimeout pending_message_interaction_info_timeout_{"PendingMessageInteractionInfoTimeout"};
   MultiTimeout pending_message_live_location_view_timeout_{"PendingMessageLiveLocationViewTimeout"};
   MultiTimeout pending_draft_message_timeout_{"PendingDraftMessageTimeout"};
   MultiTimeout pending_read_history_timeout_{"PendingReadHistoryTimeout"};
@@ -3439,6 +3512,8 @@ class MessagesManager final : public Actor {
   };
   FlatHashMap<DialogId, PendingMessageView, DialogIdHash> pending_message_views_;
 
+  FlatHashMap<DialogId, FlatHashSet<MessageId, MessageIdHash>, DialogIdHash> pending_message_interaction_info_updates_;
+
   FlatHashMap<DialogId, std::unordered_map<int64, LogEventIdWithGeneration, Hash<int64>>, DialogIdHash>
       read_history_log_event_ids_;
 
@@ -3461,12 +3536,23 @@ class MessagesManager final : public Actor {
 
   int64 authorization_date_ = 0;
 
+  int64 sequential_history_request_count_ = 0;  // getChatHistory requests made during sequential scrolling
+  int64 sequential_history_miss_count_ = 0;     // such requests, which had to wait for messages to be loaded
+
+  int64 loaded_message_count_ = 0;    // number of messages in Dialog::messages of all dialogs
+  int64 message_cache_max_count_ = 0;  // the maximum number of messages to keep in memory; 0 if unlimited
+  bool is_message_cache_cleanup_scheduled_ = false;
+
   DialogId removed_sponsored_dialog_id_;
   DialogId sponsored_dialog_id_;
   DialogSource sponsored_dialog_source_;
 
   MessageFullId being_readded_message_id_;
 
+  // messages of a history slice being added, which are known to be absent in the database
+  DialogId missing_database_messages_dialog_id_;
+  FlatHashSet<MessageId, MessageIdHash> missing_database_message_ids_;
+
   DialogId being_added_dialog_id_;
   DialogId being_added_by_new_message_dialog_id_;
   DialogId being_added_new_dialog_id_;
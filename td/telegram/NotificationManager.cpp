@@ -61,6 +61,7 @@
 #include "td/utils/utf8.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <limits>
 
@@ -141,9 +142,13 @@ void NotificationManager::on_flush_pending_notifications_timeout_callback(void *
   auto notification_manager = static_cast<NotificationManager *>(notification_manager_ptr);
   VLOG(notifications) << "Ready to flush pending notifications for notification group " << group_id_int;
   if (group_id_int > 0) {
-    send_closure_later(notification_manager->actor_id(notification_manager),
-                       &NotificationManager::flush_pending_notifications,
-                       NotificationGroupId(narrow_cast<int32>(group_id_int)));
+    // all groups with expired timeouts are flushed in one event
+    auto &group_ids = notification_manager->expired_pending_notification_group_ids_;
+    if (group_ids.empty()) {
+      send_closure_later(notification_manager->actor_id(notification_manager),
+                         &NotificationManager::flush_expired_pending_notifications);
+    }
+    group_ids.push_back(NotificationGroupId(narrow_cast<int32>(group_id_int)));
   } else if (group_id_int == 0) {
     send_closure_later(notification_manager->actor_id(notification_manager),
                        &NotificationManager::after_get_difference_impl);
@@ -935,7 +940,8 @@ void NotificationManager::add_notification(NotificationGroupId group_id, Notific
 
   auto delay_ms = get_notification_delay_ms(dialog_id, notification, min_delay_ms);
   VLOG(notifications) << "Delay " << notification_id << " for " << delay_ms << " milliseconds";
-  auto flush_time = delay_ms * 0.001 + Time::now();
+  auto flush_time = std::ceil((delay_ms * 0.001 + Time::now()) * (1000.0 / NOTIFICATION_FLUSH_TICK_MS)) *
+                    (NOTIFICATION_FLUSH_TICK_MS * 0.001);
 
   if (group.pending_notifications_flush_time == 0 || flush_time < group.pending_notifications_flush_time) {
     group.pending_notifications_flush_time = flush_time;
@@ -1645,6 +1651,28 @@ void NotificationManager::flush_all_pending_notifications() {
   }
 }
 
+void NotificationManager::flush_expired_pending_notifications() {
+  auto expired_group_ids = std::move(expired_pending_notification_group_ids_);
+  expired_pending_notification_group_ids_.clear();
+  if (expired_group_ids.size() == 1) {
+    return flush_pending_notifications(expired_group_ids[0]);
+  }
+
+  std::multimap<int32, NotificationGroupId> group_ids;
+  for (auto group_id : expired_group_ids) {
+    auto group_it = get_group(group_id);
+    if (group_it != groups_.end() && !group_it->second.pending_notifications.empty()) {
+      group_ids.emplace(group_it->second.pending_notifications.back().date, group_id);
+    }
+  }
+
+  // flush groups in order of last notification date
+  VLOG(notifications) << "Flush expired pending notifications in " << group_ids.size() << " notification groups";
+  for (auto &it : group_ids) {
+    flush_pending_notifications(it.second);
+  }
+}
+
 void NotificationManager::edit_notification(NotificationGroupId group_id, NotificationId notification_id,
                                             unique_ptr<NotificationType> type) {
   if (is_disabled() || max_notification_group_count_ == 0) {
@@ -2794,7 +2822,7 @@ void NotificationManager::process_push_notification(string payload, Promise<Unit
     send_closure(G()->state_manager(), &StateManager::on_online, false);
   }
 
-  if (receiver_id == 0 || receiver_id == td_->option_manager_->get_option_integer("my_id")) {
+  if (receiver_id == 0 || receiver_id == td_->option_manager_->get_option_integer(OptionId::MyId)) {
     auto status = process_push_notification_payload(payload, was_encrypted, promise);
     if (status.is_error()) {
       if (status.code() == 406 || status.code() == 200) {
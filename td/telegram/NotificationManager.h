@@ -148,6 +148,7 @@ class NotificationManager final : public Actor {
   static constexpr int32 DEFAULT_DEFAULT_DELAY_MS = 1500;
 
   static constexpr int32 MIN_NOTIFICATION_DELAY_MS = 1;
+  static constexpr int32 NOTIFICATION_FLUSH_TICK_MS = 50;  // flush times are aligned to flush many groups at once
 
   static constexpr int32 MIN_UPDATE_DELAY_MS = 50;
   static constexpr int32 MAX_UPDATE_DELAY_MS = 60000;
@@ -288,6 +289,8 @@ class NotificationManager final : public Actor {
 
   void flush_all_pending_notifications();
 
+  void flush_expired_pending_notifications();
+
   void on_notification_processed(NotificationId notification_id);
 
   void on_notification_removed(NotificationId notification_id);
@@ -392,6 +395,7 @@ class NotificationManager final : public Actor {
   FlatHashMap<int32, vector<td_api::object_ptr<td_api::Update>>> pending_updates_;
 
   MultiTimeout flush_pending_notifications_timeout_{"FlushPendingNotificationsTimeout"};
+  vector<NotificationGroupId> expired_pending_notification_group_ids_;
   MultiTimeout flush_pending_updates_timeout_{"FlushPendingUpdatesTimeout"};
 
   vector<NotificationGroupId> call_notification_group_ids_;
@@ -104,6 +104,10 @@ void store_notification_sound(const NotificationSound *notification_sound, LogEv
   store(notification_sound, storer);
 }
 
+void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerGrowable &storer) {
+  store(notification_sound, storer);
+}
+
 void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerUnsafe &storer) {
   store(notification_sound, storer);
 }
@@ -34,6 +34,8 @@ StringBuilder &operator<<(StringBuilder &string_builder, const unique_ptr<Notifi
 
 void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerCalcLength &storer);
 
+void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerGrowable &storer);
+
 void store_notification_sound(const NotificationSound *notification_sound, LogEventStorerUnsafe &storer);
 
 template <class StorerT>
@@ -0,0 +1,36 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// frequently used options, which values are cached pre-parsed by OptionManager
+// must be kept in sync with the list of their names in OptionManager.cpp
+enum class OptionId : int32 {
+  DisableNetworkStatistics,
+  DisablePersistentNetworkStatistics,
+  FileProgressUpdateMinDelta,
+  FileProgressUpdateMinIntervalMs,
+  IgnoreBackgroundUpdates,
+  IgnoreDefaultDisableNotification,
+  IgnoreInlineThumbnails,
+  IgnorePlatformRestrictions,
+  IsPremium,
+  MessageCaptionLengthMax,
+  MessageTextLengthMax,
+  MyId,
+  RequestTraceSampleRate,
+  SessionCount,
+  SlowRequestThresholdMs,
+  UseQuickAck,
+  UtcTimeOffset,
+  Size
+};
+
+}  // namespace td
@@ -14,10 +14,13 @@
 #include "td/telegram/ConfigManager.h"
 #include "td/telegram/CountryInfoManager.h"
 #include "td/telegram/DialogId.h"
+#include "td/telegram/files/FileManager.h"
 #include "td/telegram/GitCommitHash.h"
 #include "td/telegram/Global.h"
 #include "td/telegram/JsonValue.h"
 #include "td/telegram/LanguagePackManager.h"
+#include "td/telegram/MessageDb.h"
+#include "td/telegram/MessagesManager.h"
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/NotificationManager.h"
@@ -34,11 +37,15 @@
 #include "td/telegram/UserManager.h"
 
 #include "td/db/KeyValueSyncInterface.h"
+#include "td/db/SqliteStatement.h"
 #include "td/db/TsSeqKeyValue.h"
 
+#include "td/net/SslCtx.h"
+
 #include "td/actor/actor.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
@@ -49,9 +56,47 @@
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <utility>
 
 namespace td {
 
+// must be kept in the same order as OptionId
+static const std::pair<Slice, bool> TYPED_OPTIONS[] = {{"disable_network_statistics", true},
+                                                       {"disable_persistent_network_statistics", true},
+                                                       {"file_progress_update_min_delta", false},
+                                                       {"file_progress_update_min_interval_ms", false},
+                                                       {"ignore_background_updates", true},
+                                                       {"ignore_default_disable_notification", true},
+                                                       {"ignore_inline_thumbnails", true},
+                                                       {"ignore_platform_restrictions", true},
+                                                       {"is_premium", true},
+                                                       {"message_caption_length_max", false},
+                                                       {"message_text_length_max", false},
+                                                       {"my_id", false},
+                                                       {"request_trace_sample_rate", false},
+                                                       {"session_count", false},
+                                                       {"slow_request_threshold_ms", false},
+                                                       {"use_quick_ack", true},
+                                                       {"utc_time_offset", false}};
+
+static_assert(sizeof(TYPED_OPTIONS) / sizeof(TYPED_OPTIONS[0]) == static_cast<size_t>(OptionId::Size),
+              "Wrong number of typed options");
+
+static int32 get_typed_option_index(Slice name) {
+  static const FlatHashMap<Slice, int32, SliceHash> option_indexes = [] {
+    FlatHashMap<Slice, int32, SliceHash> result;
+    for (size_t i = 0; i < static_cast<size_t>(OptionId::Size); i++) {
+      result.emplace(TYPED_OPTIONS[i].first, static_cast<int32>(i));
+    }
+    return result;
+  }();
+  auto it = option_indexes.find(name);
+  if (it == option_indexes.end()) {
+    return -1;
+  }
+  return it->second;
+}
+
 OptionManager::OptionManager(Td *td)
     : td_(td)
     , current_scheduler_id_(Scheduler::instance()->sched_id())
@@ -151,6 +196,16 @@ OptionManager::OptionManager(Td *td)
   set_default_integer_option("business_chat_link_count_max", is_test_dc ? 5 : 100);
   set_default_integer_option("pinned_story_count_max", 3);
 
+  for (auto &typed_option : TYPED_OPTIONS) {
+    update_typed_option(typed_option.first, options.get(typed_option.first.str()));
+  }
+  if (options.isset("slow_database_statement_threshold_ms")) {
+    update_slow_database_statement_threshold();
+  }
+  if (options.isset("tls_session_cache_size_max")) {
+    update_tls_session_cache_size_max();
+  }
+
   if (options.isset("my_phone_number") || !options.isset("my_id")) {
     update_premium_options();
   }
@@ -168,6 +223,17 @@ OptionManager::OptionManager(Td *td)
 
 OptionManager::~OptionManager() = default;
 
+void OptionManager::update_slow_database_statement_threshold() const {
+  // the threshold is shared by all databases in the process
+  SqliteStatement::set_slow_step_threshold(
+      static_cast<double>(get_option_integer("slow_database_statement_threshold_ms")) * 1e-3);
+}
+
+void OptionManager::update_tls_session_cache_size_max() const {
+  // the limit is shared by all TLS connections in the process
+  SslCtx::set_max_cached_session_count(static_cast<size_t>(get_option_integer("tls_session_cache_size_max", 256)));
+}
+
 void OptionManager::update_premium_options() {
   bool is_premium = get_option_boolean("is_premium");
   if (is_premium) {
@@ -229,6 +295,16 @@ void OptionManager::on_td_inited() {
     get_option(request.first, std::move(request.second));
   }
   reset_to_empty(pending_get_options_);
+
+  update_use_message_database_compression();
+  td_->set_coalesce_state_updates(get_option_boolean("coalesce_state_updates"));
+}
+
+void OptionManager::update_use_message_database_compression() const {
+  if (G()->use_message_database()) {
+    G()->td_db()->get_message_db_async()->set_use_compression(
+        get_option_boolean("use_message_database_compression"));
+  }
 }
 
 void OptionManager::set_option_boolean(Slice name, bool value) {
@@ -304,6 +380,7 @@ void OptionManager::set_option(Slice name, Slice value) {
     }
     option_pmc_->set(name.str(), value.str());
   }
+  update_typed_option(name, value);
 
   if (!G()->close_flag() && is_td_inited_) {
     on_option_updated(name);
@@ -320,6 +397,40 @@ void OptionManager::set_option(Slice name, Slice value) {
   }
 }
 
+void OptionManager::update_typed_option(Slice name, Slice value) {
+  auto index = get_typed_option_index(name);
+  if (index < 0) {
+    return;
+  }
+
+  auto &is_set = typed_option_is_set_[index];
+  if (value.empty()) {
+    is_set.store(false, std::memory_order_release);
+    return;
+  }
+
+  int64 parsed_value = 0;
+  if (TYPED_OPTIONS[index].second) {
+    if (value != "Btrue" && value != "Bfalse") {
+      LOG(ERROR) << "Found \"" << value << "\" instead of boolean option " << name;
+      is_set.store(false, std::memory_order_release);
+      return;
+    }
+    parsed_value = value == "Btrue" ? 1 : 0;
+  } else {
+    if (value[0] != 'I') {
+      LOG(ERROR) << "Found \"" << value << "\" instead of integer option " << name;
+      is_set.store(false, std::memory_order_release);
+      return;
+    }
+    parsed_value = to_integer<int64>(value.substr(1));
+  }
+
+  // the value must be written before it is published; a changed option must never be seen as unset meanwhile
+  typed_option_values_[index].store(parsed_value, std::memory_order_relaxed);
+  is_set.store(true, std::memory_order_release);
+}
+
 string OptionManager::get_option(Slice name) const {
   return options_->get(name.str());
 }
@@ -497,6 +608,9 @@ void OptionManager::on_option_updated(Slice name) {
       }
       break;
     case 'c':
+      if (name == "coalesce_state_updates") {
+        td_->set_coalesce_state_updates(get_option_boolean(name));
+      }
       if (name == "connection_parameters") {
         if (G()->mtproto_header().set_parameters(get_option_string(name))) {
           G()->net_query_dispatcher().update_mtproto_header();
@@ -533,6 +647,9 @@ void OptionManager::on_option_updated(Slice name) {
       if (name == "favorite_stickers_limit") {
         td_->stickers_manager_->on_update_favorite_stickers_limit();
       }
+      if (name == "file_download_speed_limit" || name == "file_upload_speed_limit") {
+        send_closure(G()->file_manager(), &FileManager::on_speed_limit_changed);
+      }
       if (name == "fragment_prefixes") {
         send_closure(td_->country_info_manager_actor_, &CountryInfoManager::on_update_fragment_prefixes);
       }
@@ -570,6 +687,9 @@ void OptionManager::on_option_updated(Slice name) {
       }
       break;
     case 'm':
+      if (name == "message_cache_max_count") {
+        send_closure(td_->messages_manager_actor_, &MessagesManager::on_message_cache_max_count_changed);
+      }
       if (name == "my_phone_number") {
         send_closure(G()->config_manager(), &ConfigManager::reget_config, Promise<Unit>());
       }
@@ -618,8 +738,19 @@ void OptionManager::on_option_updated(Slice name) {
       if (name == "session_count") {
         G()->net_query_dispatcher().update_session_count();
       }
+      if (name == "slow_database_statement_threshold_ms") {
+        update_slow_database_statement_threshold();
+      }
+      break;
+    case 't':
+      if (name == "tls_session_cache_size_max") {
+        update_tls_session_cache_size_max();
+      }
       break;
     case 'u':
+      if (name == "use_message_database_compression") {
+        update_use_message_database_compression();
+      }
       if (name == "use_pfs") {
         G()->net_query_dispatcher().update_use_pfs();
       }
@@ -799,6 +930,9 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       */
       break;
     case 'c':
+      if (set_boolean_option("coalesce_state_updates")) {
+        return;
+      }
       if (!is_bot && set_string_option("connection_parameters", [](Slice value) {
             string value_copy = value.str();
             auto r_json_value = get_json_value(value_copy);
@@ -838,6 +972,23 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
         return promise.set_value(Unit());
       }
       break;
+    case 'f':
+      if (set_integer_option("file_download_speed_limit")) {
+        return;
+      }
+      if (set_integer_option("file_generation_active_count_max", 1, 1000)) {
+        return;
+      }
+      if (set_integer_option("file_progress_update_min_delta")) {
+        return;
+      }
+      if (set_integer_option("file_progress_update_min_interval_ms", 0, 60000)) {
+        return;
+      }
+      if (set_integer_option("file_upload_speed_limit")) {
+        return;
+      }
+      break;
     case 'i':
       if (set_boolean_option("ignore_background_updates")) {
         return;
@@ -892,7 +1043,11 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'm':
-      if (set_integer_option("message_unload_delay", 60, 86400)) {
+      if (set_integer_option("message_cache_max_count", 0, 1000000000)) {
+        return;
+      }
+      // bots relaying updates can keep only a short window of recent messages in memory
+      if (set_integer_option("message_unload_delay", is_bot ? 10 : 60, 86400)) {
         return;
       }
       break;
@@ -933,12 +1088,36 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       }
       break;
     case 'r':
+      if (set_integer_option("request_trace_sample_rate", 0, 1000000)) {
+        return;
+      }
       // temporary option
       if (set_boolean_option("reuse_uploaded_photos_by_hash")) {
         return;
       }
       break;
     case 's':
+      // files in the store are trusted by name and size only, so the directory must be writable only by the clients
+      if (set_string_option("shared_file_store_directory", [](Slice value) { return true; })) {
+        return;
+      }
+      if (set_integer_option("slow_database_statement_threshold_ms", 0, 86400000)) {
+        return;
+      }
+      if (set_integer_option("slow_request_threshold_ms", 0, 86400000)) {
+        return;
+      }
+      // SQLite options are applied only after restart
+      if (set_integer_option("sqlite_cache_size", 0, static_cast<int64>(1) << 30)) {
+        return;
+      }
+      if (set_integer_option("sqlite_mmap_size", 0, static_cast<int64>(1) << 40)) {
+        return;
+      }
+      // automatic checkpoints can't be disabled, because nothing else would limit the WAL size
+      if (set_integer_option("sqlite_wal_autocheckpoint", 1, 1000000000)) {
+        return;
+      }
       if (set_integer_option("storage_max_files_size")) {
         return;
       }
@@ -959,14 +1138,34 @@ void OptionManager::set_option(const string &name, td_api::object_ptr<td_api::Op
       if (set_boolean_option("test_flood_wait")) {
         return;
       }
+      if (set_integer_option("tls_session_cache_size_max", 0, 100000)) {
+        return;
+      }
       break;
     case 'u':
+      if (set_boolean_option("use_background_sqlite_checkpointer")) {
+        return;
+      }
+      if (set_boolean_option("use_message_database_compression")) {
+        return;
+      }
+      if (set_boolean_option("use_parallel_file_download")) {
+        return;
+      }
       if (set_boolean_option("use_pfs")) {
         return;
       }
       if (set_boolean_option("use_quick_ack")) {
         return;
       }
+      if (set_boolean_option("use_shared_server_data_cache")) {
+        return;
+      }
+      // applied on the next start; the first start after the option is enabled runs a full VACUUM of the database,
+      // which can block the start for minutes for a big database
+      if (set_boolean_option("use_sqlite_incremental_vacuum")) {
+        return;
+      }
       if (set_boolean_option("use_storage_optimizer")) {
         return;
       }
@@ -6,12 +6,14 @@
 //
 #pragma once
 
+#include "td/telegram/OptionId.h"
 #include "td/telegram/td_api.h"
 
 #include "td/utils/common.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <utility>
@@ -51,6 +53,23 @@ class OptionManager {
 
   string get_option_string(Slice name, string default_value = "") const;
 
+  // lock-free versions for frequently used options
+  bool get_option_boolean(OptionId option_id, bool default_value = false) const {
+    auto index = static_cast<size_t>(option_id);
+    if (!typed_option_is_set_[index].load(std::memory_order_acquire)) {
+      return default_value;
+    }
+    return typed_option_values_[index].load(std::memory_order_relaxed) != 0;
+  }
+
+  int64 get_option_integer(OptionId option_id, int64 default_value = 0) const {
+    auto index = static_cast<size_t>(option_id);
+    if (!typed_option_is_set_[index].load(std::memory_order_acquire)) {
+      return default_value;
+    }
+    return typed_option_values_[index].load(std::memory_order_relaxed);
+  }
+
   void on_update_server_time_difference();
 
   void get_option(const string &name, Promise<td_api::object_ptr<td_api::OptionValue>> &&promise);
@@ -70,6 +89,12 @@ class OptionManager {
 
   void on_option_updated(Slice name);
 
+  void update_typed_option(Slice name, Slice value);
+
+  void update_slow_database_statement_threshold() const;
+
+  void update_tls_session_cache_size_max() const;
+
   string get_option(Slice name) const;
 
   static bool is_internal_option(Slice name);
@@ -84,6 +109,8 @@ class OptionManager {
 
   void send_unix_time_update();
 
+  void update_use_message_database_compression() const;
+
   Td *td_;
   bool is_td_inited_ = false;
   vector<std::pair<string, Promise<td_api::object_ptr<td_api::OptionValue>>>> pending_get_options_;
@@ -93,6 +120,10 @@ class OptionManager {
   std::shared_ptr<KeyValueSyncInterface> option_pmc_;
 
   std::atomic<double> last_sent_server_time_difference_{1e100};
+
+  static constexpr size_t TYPED_OPTION_COUNT = static_cast<size_t>(OptionId::Size);
+  std::array<std::atomic<int64>, TYPED_OPTION_COUNT> typed_option_values_{};
+  std::array<std::atomic<bool>, TYPED_OPTION_COUNT> typed_option_is_set_{};
 };
 
 }  // namespace td
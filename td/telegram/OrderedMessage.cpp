@@ -8,28 +8,17 @@
 
 #include "td/utils/logging.h"
 
+#include <algorithm>
+
 namespace td {
 
 void OrderedMessages::insert(MessageId message_id, bool auto_attach, MessageId old_last_message_id,
                              const char *source) {
-  auto random_y = static_cast<int32>(static_cast<uint32>(message_id.get() * 2101234567u));
-  unique_ptr<OrderedMessage> *v = &messages_;
-  while (*v != nullptr && (*v)->random_y_ >= random_y) {
-    if ((*v)->message_id_.get() < message_id.get()) {
-      v = &(*v)->right_;
-    } else if ((*v)->message_id_ == message_id) {
-      UNREACHABLE();
-    } else {
-      v = &(*v)->left_;
-    }
-  }
-
-  auto message = make_unique<OrderedMessage>();
-  message->message_id_ = message_id;
-  message->random_y_ = random_y;
+  OrderedMessage message;
+  message.message_id_ = message_id;
 
   if (auto_attach) {
-    auto_attach_message(message.get(), old_last_message_id, source);
+    auto_attach_message(&message, old_last_message_id, source);
   } else {
     auto it = get_iterator(message_id);
     if (*it != nullptr && (*it)->have_next_) {
@@ -46,72 +35,85 @@ void OrderedMessages::insert(MessageId message_id, bool auto_attach, MessageId o
     }
   }
 
-  unique_ptr<OrderedMessage> *left = &message->left_;
-  unique_ptr<OrderedMessage> *right = &message->right_;
-
-  unique_ptr<OrderedMessage> cur = std::move(*v);
-  while (cur != nullptr) {
-    if (cur->message_id_.get() < message_id.get()) {
-      *left = std::move(cur);
-      left = &((*left)->right_);
-      cur = std::move(*left);
-    } else {
-      *right = std::move(cur);
-      right = &((*right)->left_);
-      cur = std::move(*right);
-    }
-  }
-  CHECK(*left == nullptr);
-  CHECK(*right == nullptr);
-  *v = std::move(message);
+  do_insert(message);
 }
 
-void OrderedMessages::erase(MessageId message_id, bool only_from_memory) {
-  unique_ptr<OrderedMessage> *v = &messages_;
-  while (*v != nullptr) {
-    if ((*v)->message_id_.get() < message_id.get()) {
-      v = &(*v)->right_;
-    } else if ((*v)->message_id_.get() > message_id.get()) {
-      v = &(*v)->left_;
-    } else {
-      break;
-    }
+void OrderedMessages::do_insert(const OrderedMessage &message) {
+  auto message_id = message.message_id_;
+  if (chunks_.empty()) {
+    chunks_.emplace_back(1, message);
+    return;
   }
+  auto chunk_pos = get_chunk_pos(chunks_, message_id);
+  if (chunk_pos == chunks_.size()) {
+    // the new message has the greatest identifier
+    chunk_pos--;
+  }
+
+  auto &chunk = chunks_[chunk_pos];
+  auto it = std::lower_bound(chunk.begin(), chunk.end(), message_id,
+                             [](const OrderedMessage &lhs, MessageId rhs) { return lhs.message_id_ < rhs; });
+  if (it != chunk.end() && it->message_id_ == message_id) {
+    UNREACHABLE();
+  }
+  chunk.insert(it, message);
+
+  if (chunk.size() > MAX_CHUNK_SIZE) {
+    auto half_size = chunk.size() / 2;
+    Chunk new_chunk(chunk.begin() + half_size, chunk.end());
+    chunk.resize(half_size);
+    chunks_.insert(chunks_.begin() + chunk_pos + 1, std::move(new_chunk));
+  }
+}
 
-  CHECK(*v != nullptr);
-  if ((*v)->have_previous_ && (only_from_memory || !(*v)->have_next_)) {
+void OrderedMessages::erase(MessageId message_id, bool only_from_memory) {
+  auto chunk_pos = get_chunk_pos(chunks_, message_id);
+  CHECK(chunk_pos < chunks_.size());
+  auto &chunk = chunks_[chunk_pos];
+  auto message_it = std::lower_bound(chunk.begin(), chunk.end(), message_id,
+                                     [](const OrderedMessage &lhs, MessageId rhs) { return lhs.message_id_ < rhs; });
+  CHECK(message_it != chunk.end() && message_it->message_id_ == message_id);
+
+  if (message_it->have_previous_ && (only_from_memory || !message_it->have_next_)) {
     auto it = get_iterator(message_id);
-    CHECK(*it == v->get());
+    CHECK(*it == &*message_it);
     --it;
     OrderedMessage *prev_m = *it;
     CHECK(prev_m != nullptr);
     prev_m->have_next_ = false;
   }
-  if ((*v)->have_next_ && (only_from_memory || !(*v)->have_previous_)) {
+  if (message_it->have_next_ && (only_from_memory || !message_it->have_previous_)) {
     auto it = get_iterator(message_id);
-    CHECK(*it == v->get());
+    CHECK(*it == &*message_it);
     ++it;
     OrderedMessage *next_m = *it;
     CHECK(next_m != nullptr);
     next_m->have_previous_ = false;
   }
 
-  unique_ptr<OrderedMessage> result = std::move(*v);
-  unique_ptr<OrderedMessage> left = std::move(result->left_);
-  unique_ptr<OrderedMessage> right = std::move(result->right_);
-
-  while (left != nullptr || right != nullptr) {
-    if (left == nullptr || (right != nullptr && right->random_y_ > left->random_y_)) {
-      *v = std::move(right);
-      v = &((*v)->left_);
-      right = std::move(*v);
-    } else {
-      *v = std::move(left);
-      v = &((*v)->right_);
-      left = std::move(*v);
-    }
+  chunk.erase(message_it);
+  if (chunk.empty()) {
+    chunks_.erase(chunks_.begin() + chunk_pos);
+    return;
+  }
+  if (chunk_pos + 1 < chunks_.size() && chunk.size() + chunks_[chunk_pos + 1].size() <= MAX_CHUNK_SIZE / 2) {
+    // merge small adjacent chunks
+    auto &next_chunk = chunks_[chunk_pos + 1];
+    chunk.insert(chunk.end(), next_chunk.begin(), next_chunk.end());
+    chunks_.erase(chunks_.begin() + chunk_pos + 1);
+  }
+}
+
+OrderedMessage *OrderedMessages::get_next_message(MessageId message_id) {
+  auto chunk_pos = get_chunk_pos(chunks_, message_id);
+  if (chunk_pos == chunks_.size()) {
+    return nullptr;
   }
-  CHECK(*v == nullptr);
+  auto &chunk = chunks_[chunk_pos];
+  auto it = std::lower_bound(chunk.begin(), chunk.end(), message_id,
+                             [](const OrderedMessage &lhs, MessageId rhs) { return lhs.message_id_ < rhs; });
+  CHECK(it != chunk.end());
+  return &*it;
 }
 
 void OrderedMessages::attach_message_to_previous(MessageId message_id, const char *source) {
@@ -181,16 +183,7 @@ void OrderedMessages::auto_attach_message(OrderedMessage *message, MessageId las
   }
   if (!message_id.is_yet_unsent()) {
     // message may be attached to the next message if there is no previous message
-    OrderedMessage *cur = messages_.get();
-    OrderedMessage *next_message = nullptr;
-    while (cur != nullptr) {
-      if (cur->message_id_ < message_id) {
-        cur = cur->right_.get();
-      } else {
-        next_message = cur;
-        cur = cur->left_.get();
-      }
-    }
+    OrderedMessage *next_message = get_next_message(message_id);
     if (next_message != nullptr) {
       CHECK(!next_message->have_previous_);
       LOG(INFO) << "Attach " << message_id << " to the next " << next_message->message_id_ << " from " << source;
@@ -203,117 +196,123 @@ void OrderedMessages::auto_attach_message(OrderedMessage *message, MessageId las
   LOG(INFO) << "Can't auto-attach " << message_id << " from " << source;
 }
 
-void OrderedMessages::do_find_older_messages(const OrderedMessage *ordered_message, MessageId max_message_id,
-                                             vector<MessageId> &message_ids) {
-  if (ordered_message == nullptr) {
-    return;
-  }
-
-  do_find_older_messages(ordered_message->left_.get(), max_message_id, message_ids);
-
-  if (ordered_message->message_id_ <= max_message_id) {
-    message_ids.push_back(ordered_message->message_id_);
-
-    do_find_older_messages(ordered_message->right_.get(), max_message_id, message_ids);
-  }
-}
-
 vector<MessageId> OrderedMessages::find_older_messages(MessageId max_message_id) const {
   vector<MessageId> message_ids;
-  do_find_older_messages(messages_.get(), max_message_id, message_ids);
-  return message_ids;
-}
-
-void OrderedMessages::do_find_newer_messages(const OrderedMessage *ordered_message, MessageId min_message_id,
-                                             vector<MessageId> &message_ids) {
-  if (ordered_message == nullptr) {
-    return;
-  }
-
-  if (ordered_message->message_id_ > min_message_id) {
-    do_find_newer_messages(ordered_message->left_.get(), min_message_id, message_ids);
-
-    message_ids.push_back(ordered_message->message_id_);
+  for (const auto &chunk : chunks_) {
+    for (const auto &message : chunk) {
+      if (message.message_id_ > max_message_id) {
+        return message_ids;
+      }
+      message_ids.push_back(message.message_id_);
+    }
   }
-
-  do_find_newer_messages(ordered_message->right_.get(), min_message_id, message_ids);
+  return message_ids;
 }
 
 vector<MessageId> OrderedMessages::find_newer_messages(MessageId min_message_id) const {
   vector<MessageId> message_ids;
-  do_find_newer_messages(messages_.get(), min_message_id, message_ids);
+  for (auto chunk_pos = get_chunk_pos(chunks_, min_message_id); chunk_pos < chunks_.size(); chunk_pos++) {
+    for (const auto &message : chunks_[chunk_pos]) {
+      if (message.message_id_ > min_message_id) {
+        message_ids.push_back(message.message_id_);
+      }
+    }
+  }
   return message_ids;
 }
 
-MessageId OrderedMessages::do_find_message_by_date(const OrderedMessage *ordered_message, int32 date,
-                                                   const std::function<int32(MessageId)> &get_message_date) {
-  if (ordered_message == nullptr) {
-    return MessageId();
-  }
-
-  auto message_date = get_message_date(ordered_message->message_id_);
-  if (message_date > date) {
-    return do_find_message_by_date(ordered_message->left_.get(), date, get_message_date);
+template <class PredicateT>
+std::pair<size_t, size_t> OrderedMessages::partition_point(const PredicateT &predicate) const {
+  auto chunk_it = std::lower_bound(chunks_.begin(), chunks_.end(), 0,
+                                   [&](const Chunk &chunk, int) { return predicate(chunk.back().message_id_); });
+  if (chunk_it == chunks_.end()) {
+    return {chunks_.size(), 0};
   }
-
-  auto message_id = do_find_message_by_date(ordered_message->right_.get(), date, get_message_date);
-  if (message_id.is_valid()) {
-    return message_id;
-  }
-
-  return ordered_message->message_id_;
+  auto message_it = std::lower_bound(chunk_it->begin(), chunk_it->end(), 0, [&](const OrderedMessage &message, int) {
+    return predicate(message.message_id_);
+  });
+  CHECK(message_it != chunk_it->end());
+  return {static_cast<size_t>(chunk_it - chunks_.begin()), static_cast<size_t>(message_it - chunk_it->begin())};
 }
 
 MessageId OrderedMessages::find_message_by_date(int32 date,
                                                 const std::function<int32(MessageId)> &get_message_date) const {
-  return do_find_message_by_date(messages_.get(), date, get_message_date);
-}
-
-void OrderedMessages::do_find_messages_by_date(const OrderedMessage *ordered_message, int32 min_date, int32 max_date,
-                                               const std::function<int32(MessageId)> &get_message_date,
-                                               vector<MessageId> &message_ids) {
-  if (ordered_message == nullptr) {
-    return;
-  }
-
-  auto message_date = get_message_date(ordered_message->message_id_);
-  if (message_date >= min_date) {
-    do_find_messages_by_date(ordered_message->left_.get(), min_date, max_date, get_message_date, message_ids);
-    if (message_date <= max_date) {
-      message_ids.push_back(ordered_message->message_id_);
-    }
+  // dates of messages are expected to be non-decreasing
+  auto pos = partition_point([&](MessageId message_id) { return get_message_date(message_id) <= date; });
+  if (pos.second > 0) {
+    return chunks_[pos.first][pos.second - 1].message_id_;
   }
-  if (message_date <= max_date) {
-    do_find_messages_by_date(ordered_message->right_.get(), min_date, max_date, get_message_date, message_ids);
+  if (pos.first > 0) {
+    return chunks_[pos.first - 1].back().message_id_;
   }
+  return MessageId();
 }
 
 vector<MessageId> OrderedMessages::find_messages_by_date(
     int32 min_date, int32 max_date, const std::function<int32(MessageId)> &get_message_date) const {
+  // dates of messages are expected to be non-decreasing
   vector<MessageId> message_ids;
-  do_find_messages_by_date(messages_.get(), min_date, max_date, get_message_date, message_ids);
+  auto pos = partition_point([&](MessageId message_id) { return get_message_date(message_id) < min_date; });
+  for (auto chunk_pos = pos.first; chunk_pos < chunks_.size(); chunk_pos++) {
+    const auto &chunk = chunks_[chunk_pos];
+    for (auto message_pos = chunk_pos == pos.first ? pos.second : 0; message_pos < chunk.size(); message_pos++) {
+      auto message_id = chunk[message_pos].message_id_;
+      auto message_date = get_message_date(message_id);
+      if (message_date > max_date) {
+        return message_ids;
+      }
+      if (message_date >= min_date) {
+        message_ids.push_back(message_id);
+      }
+    }
+  }
   return message_ids;
 }
 
-void OrderedMessages::do_traverse_messages(const OrderedMessage *ordered_message,
+// messages are traversed as a binary search tree, in which each chunk is a balanced subtree and
+// the leftmost and the rightmost subtrees of the chunk are built from the previous and the next chunks respectively
+void OrderedMessages::do_traverse_messages(size_t begin_chunk_pos, size_t end_chunk_pos,
                                            const std::function<bool(MessageId)> &need_scan_older,
-                                           const std::function<bool(MessageId)> &need_scan_newer) {
-  if (ordered_message == nullptr) {
+                                           const std::function<bool(MessageId)> &need_scan_newer) const {
+  if (begin_chunk_pos == end_chunk_pos) {
     return;
   }
+  auto chunk_pos = begin_chunk_pos + (end_chunk_pos - begin_chunk_pos) / 2;
+  do_traverse_chunk_messages(begin_chunk_pos, chunk_pos, end_chunk_pos, 0, chunks_[chunk_pos].size(),
+                             need_scan_older, need_scan_newer);
+}
 
-  if (need_scan_older(ordered_message->message_id_)) {
-    do_traverse_messages(ordered_message->left_.get(), need_scan_older, need_scan_newer);
+void OrderedMessages::do_traverse_chunk_messages(size_t begin_chunk_pos, size_t chunk_pos, size_t end_chunk_pos,
+                                                 size_t begin, size_t end,
+                                                 const std::function<bool(MessageId)> &need_scan_older,
+                                                 const std::function<bool(MessageId)> &need_scan_newer) const {
+  CHECK(begin < end);
+  const auto &chunk = chunks_[chunk_pos];
+  auto pos = begin + (end - begin) / 2;
+  auto message_id = chunk[pos].message_id_;
+
+  if (need_scan_older(message_id)) {
+    if (begin < pos) {
+      do_traverse_chunk_messages(begin_chunk_pos, chunk_pos, end_chunk_pos, begin, pos, need_scan_older,
+                                 need_scan_newer);
+    } else if (begin == 0) {
+      do_traverse_messages(begin_chunk_pos, chunk_pos, need_scan_older, need_scan_newer);
+    }
   }
 
-  if (need_scan_newer(ordered_message->message_id_)) {
-    do_traverse_messages(ordered_message->right_.get(), need_scan_older, need_scan_newer);
+  if (need_scan_newer(message_id)) {
+    if (pos + 1 < end) {
+      do_traverse_chunk_messages(begin_chunk_pos, chunk_pos, end_chunk_pos, pos + 1, end, need_scan_older,
+                                 need_scan_newer);
+    } else if (end == chunk.size()) {
+      do_traverse_messages(chunk_pos + 1, end_chunk_pos, need_scan_older, need_scan_newer);
+    }
   }
 }
 
 void OrderedMessages::traverse_messages(const std::function<bool(MessageId)> &need_scan_older,
                                         const std::function<bool(MessageId)> &need_scan_newer) const {
-  do_traverse_messages(messages_.get(), need_scan_older, need_scan_newer);
+  do_traverse_messages(0, chunks_.size(), need_scan_older, need_scan_newer);
 }
 
 vector<MessageId> OrderedMessages::get_history(MessageId last_message_id, MessageId &from_message_id, int32 &offset,
@@ -341,7 +340,7 @@ vector<MessageId> OrderedMessages::get_history(MessageId last_message_id, Messag
     bool have_a_gap = false;
     if (*it == nullptr) {
       // there is no gap if from_message_id is less than the first message
-      if (force && offset < 0 && messages_ != nullptr) {
+      if (force && offset < 0 && !chunks_.empty()) {
         MessageId min_message_id;
         traverse_messages(
             [&](MessageId message_id) {
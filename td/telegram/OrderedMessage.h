@@ -10,7 +10,9 @@
 
 #include "td/utils/common.h"
 
+#include <algorithm>
 #include <functional>
+#include <utility>
 
 namespace td {
 
@@ -25,46 +27,55 @@ class OrderedMessage {
   }
 
  private:
-  int32 random_y_ = 0;
+  MessageId message_id_;
 
   bool have_previous_ = false;
   bool have_next_ = false;
 
-  MessageId message_id_;
-
-  unique_ptr<OrderedMessage> left_;
-  unique_ptr<OrderedMessage> right_;
-
   friend class OrderedMessages;
 };
 
+// messages are stored in sorted chunks of limited size to allow fast iteration without pointer chasing
 class OrderedMessages {
+  using Chunk = vector<OrderedMessage>;
+
  public:
   class IteratorBase {
-    vector<const OrderedMessage *> stack_;
+    const vector<Chunk> *chunks_ = nullptr;  // nullptr if the iterator doesn't point to a message
+    size_t chunk_pos_ = 0;
+    size_t message_pos_ = 0;
 
    protected:
     IteratorBase() = default;
 
     // points iterator to message with greatest identifier which is less or equal than message_id
-    IteratorBase(const OrderedMessage *root, MessageId message_id) {
+    IteratorBase(const vector<Chunk> &chunks, MessageId message_id) {
       CHECK(!message_id.is_scheduled());
 
-      size_t last_right_pos = 0;
-      while (root != nullptr) {
-        stack_.push_back(root);
-        if (root->message_id_ <= message_id) {
-          last_right_pos = stack_.size();
-          root = root->right_.get();
-        } else {
-          root = root->left_.get();
+      auto chunk_pos = get_chunk_pos(chunks, message_id);
+      if (chunk_pos == chunks.size() || chunks[chunk_pos][0].message_id_ > message_id) {
+        // the message is the last message in the previous chunk
+        if (chunk_pos == 0) {
+          return;
         }
+        chunk_pos--;
+        chunks_ = &chunks;
+        chunk_pos_ = chunk_pos;
+        message_pos_ = chunks[chunk_pos].size() - 1;
+        return;
       }
-      stack_.resize(last_right_pos);
+
+      const auto &chunk = chunks[chunk_pos];
+      auto it = std::upper_bound(chunk.begin(), chunk.end(), message_id,
+                                 [](MessageId lhs, const OrderedMessage &rhs) { return lhs < rhs.message_id_; });
+      CHECK(it != chunk.begin());
+      chunks_ = &chunks;
+      chunk_pos_ = chunk_pos;
+      message_pos_ = static_cast<size_t>(it - chunk.begin()) - 1;
     }
 
     const OrderedMessage *operator*() const {
-      return stack_.empty() ? nullptr : stack_.back();
+      return chunks_ == nullptr ? nullptr : &(*chunks_)[chunk_pos_][message_pos_];
     }
 
     ~IteratorBase() = default;
@@ -76,69 +87,46 @@ class OrderedMessages {
     IteratorBase &operator=(IteratorBase &&) = default;
 
     void operator++() {
-      if (stack_.empty()) {
+      if (chunks_ == nullptr) {
         return;
       }
 
-      const OrderedMessage *cur = stack_.back();
-      if (!cur->have_next_) {
-        stack_.clear();
+      if (!(*chunks_)[chunk_pos_][message_pos_].have_next_) {
+        chunks_ = nullptr;
         return;
       }
-      if (cur->right_ == nullptr) {
-        while (true) {
-          stack_.pop_back();
-          if (stack_.empty()) {
-            return;
-          }
-          const OrderedMessage *new_cur = stack_.back();
-          if (new_cur->left_.get() == cur) {
-            return;
-          }
-          cur = new_cur;
+      message_pos_++;
+      if (message_pos_ == (*chunks_)[chunk_pos_].size()) {
+        chunk_pos_++;
+        message_pos_ = 0;
+        if (chunk_pos_ == chunks_->size()) {
+          chunks_ = nullptr;
         }
       }
-
-      cur = cur->right_.get();
-      while (cur != nullptr) {
-        stack_.push_back(cur);
-        cur = cur->left_.get();
-      }
     }
 
     void operator--() {
-      if (stack_.empty()) {
+      if (chunks_ == nullptr) {
         return;
       }
 
-      const OrderedMessage *cur = stack_.back();
-      if (!cur->have_previous_) {
-        stack_.clear();
+      if (!(*chunks_)[chunk_pos_][message_pos_].have_previous_) {
+        chunks_ = nullptr;
         return;
       }
-      if (cur->left_ == nullptr) {
-        while (true) {
-          stack_.pop_back();
-          if (stack_.empty()) {
-            return;
-          }
-          const OrderedMessage *new_cur = stack_.back();
-          if (new_cur->right_.get() == cur) {
-            return;
-          }
-          cur = new_cur;
+      if (message_pos_ == 0) {
+        if (chunk_pos_ == 0) {
+          chunks_ = nullptr;
+          return;
         }
+        chunk_pos_--;
+        message_pos_ = (*chunks_)[chunk_pos_].size();
       }
-
-      cur = cur->left_.get();
-      while (cur != nullptr) {
-        stack_.push_back(cur);
-        cur = cur->right_.get();
-      }
+      message_pos_--;
     }
 
     void clear() {
-      stack_.clear();
+      chunks_ = nullptr;
     }
   };
 
@@ -146,7 +134,7 @@ class OrderedMessages {
    public:
     ConstIterator() = default;
 
-    ConstIterator(const OrderedMessage *root, MessageId message_id) : IteratorBase(root, message_id) {
+    ConstIterator(const vector<Chunk> &chunks, MessageId message_id) : IteratorBase(chunks, message_id) {
     }
 
     const OrderedMessage *operator*() const {
@@ -155,7 +143,7 @@ class OrderedMessages {
   };
 
   ConstIterator get_const_iterator(MessageId message_id) const {
-    return ConstIterator(messages_.get(), message_id);
+    return ConstIterator(chunks_, message_id);
   }
 
   void insert(MessageId message_id, bool auto_attach, MessageId old_last_message_id, const char *source);
@@ -183,7 +171,7 @@ class OrderedMessages {
                                 bool force) const;
 
   bool empty() const {
-    return messages_ == nullptr;
+    return chunks_.empty();
   }
 
  private:
@@ -191,7 +179,7 @@ class OrderedMessages {
    public:
     Iterator() = default;
 
-    Iterator(OrderedMessage *root, MessageId message_id) : IteratorBase(root, message_id) {
+    Iterator(const vector<Chunk> &chunks, MessageId message_id) : IteratorBase(chunks, message_id) {
     }
 
     OrderedMessage *operator*() const {
@@ -199,30 +187,40 @@ class OrderedMessages {
     }
   };
 
+  static constexpr size_t MAX_CHUNK_SIZE = 256;
+
+  // returns position of the first chunk with the last message identifier greater or equal than message_id
+  static size_t get_chunk_pos(const vector<Chunk> &chunks, MessageId message_id) {
+    return static_cast<size_t>(
+        std::lower_bound(chunks.begin(), chunks.end(), message_id,
+                         [](const Chunk &lhs, MessageId rhs) { return lhs.back().message_id_ < rhs; }) -
+        chunks.begin());
+  }
+
   void auto_attach_message(OrderedMessage *message, MessageId last_message_id, const char *source);
 
   Iterator get_iterator(MessageId message_id) {
-    return Iterator(messages_.get(), message_id);
+    return Iterator(chunks_, message_id);
   }
 
-  static void do_find_older_messages(const OrderedMessage *ordered_message, MessageId max_message_id,
-                                     vector<MessageId> &message_ids);
+  // returns the first message with identifier greater or equal than message_id
+  OrderedMessage *get_next_message(MessageId message_id);
 
-  static void do_find_newer_messages(const OrderedMessage *ordered_message, MessageId min_message_id,
-                                     vector<MessageId> &message_ids);
+  void do_insert(const OrderedMessage &message);
 
-  static MessageId do_find_message_by_date(const OrderedMessage *ordered_message, int32 date,
-                                           const std::function<int32(MessageId)> &get_message_date);
+  // returns the first message, for which the predicate is false, if the predicate is true for a prefix of messages
+  template <class PredicateT>
+  std::pair<size_t, size_t> partition_point(const PredicateT &predicate) const;
 
-  static void do_find_messages_by_date(const OrderedMessage *ordered_message, int32 min_date, int32 max_date,
-                                       const std::function<int32(MessageId)> &get_message_date,
-                                       vector<MessageId> &message_ids);
+  void do_traverse_messages(size_t begin_chunk_pos, size_t end_chunk_pos,
+                            const std::function<bool(MessageId)> &need_scan_older,
+                            const std::function<bool(MessageId)> &need_scan_newer) const;
 
-  static void do_traverse_messages(const OrderedMessage *ordered_message,
-                                   const std::function<bool(MessageId)> &need_scan_older,
-                                   const std::function<bool(MessageId)> &need_scan_newer);
+  void do_traverse_chunk_messages(size_t begin_chunk_pos, size_t chunk_pos, size_t end_chunk_pos, size_t begin,
+                                  size_t end, const std::function<bool(MessageId)> &need_scan_older,
+                                  const std::function<bool(MessageId)> &need_scan_newer) const;
 
-  unique_ptr<OrderedMessage> messages_;
+  vector<Chunk> chunks_;
 };
 
 }  // namespace td
@@ -17,6 +17,7 @@
 #include "td/telegram/ReactionManager.hpp"
 #include "td/telegram/ReactionType.hpp"
 #include "td/telegram/SavedMessagesManager.h"
+#include "td/telegram/SharedServerDataCache.h"
 #include "td/telegram/StickerFormat.h"
 #include "td/telegram/StickersManager.h"
 #include "td/telegram/Td.h"
@@ -41,8 +42,20 @@
 namespace td {
 
 class GetAvailableReactionsQuery final : public Td::ResultHandler {
+  bool is_shared_ = false;
+
  public:
   void send(int32 hash) {
+    if (SharedServerDataCache::is_up_to_date("available_reactions", hash)) {
+      return td_->reaction_manager_->on_get_available_reactions(
+          telegram_api::make_object<telegram_api::messages_availableReactionsNotModified>());
+    }
+    auto response = SharedServerDataCache::get_response("available_reactions", hash);
+    if (!response.empty()) {
+      is_shared_ = true;
+      return on_result(std::move(response));
+    }
+
     send_query(G()->net_query_creator().create(telegram_api::messages_getAvailableReactions(hash)));
   }
 
@@ -54,6 +67,11 @@ class GetAvailableReactionsQuery final : public Td::ResultHandler {
 
     auto ptr = result_ptr.move_as_ok();
     LOG(INFO) << "Receive result for GetAvailableReactionsQuery: " << to_string(ptr);
+    if (!is_shared_ && ptr->get_id() == telegram_api::messages_availableReactions::ID) {
+      SharedServerDataCache::add_response(
+          "available_reactions", static_cast<const telegram_api::messages_availableReactions *>(ptr.get())->hash_,
+          packet);
+    }
     td_->reaction_manager_->on_get_available_reactions(std::move(ptr));
   }
 
@@ -493,7 +511,7 @@ td_api::object_ptr<td_api::availableReactions> ReactionManager::get_sorted_avail
     row_size = 8;
   }
 
-  bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+  bool is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
   bool show_premium = is_premium || is_tag;
   vector<ReactionType> recent_reactions;
   vector<ReactionType> top_reactions;
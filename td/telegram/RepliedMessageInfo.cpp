@@ -28,7 +28,7 @@ static bool has_qts_messages(const Td *td, DialogId dialog_id) {
   switch (dialog_id.get_type()) {
     case DialogType::User:
     case DialogType::Chat:
-      return td->option_manager_->get_option_integer("session_count") > 1;
+      return td->option_manager_->get_option_integer(OptionId::SessionCount) > 1;
     case DialogType::Channel:
     case DialogType::SecretChat:
       return false;
@@ -35,7 +35,7 @@ string get_restriction_reason_description(const vector<RestrictionReason> &restr
 #endif
   }();
 
-  if (G()->get_option_boolean("ignore_platform_restrictions")) {
+  if (G()->get_option_boolean(OptionId::IgnorePlatformRestrictions)) {
     platform = Slice();
     restriction_add_platforms.clear();
   }
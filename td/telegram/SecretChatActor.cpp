@@ -1014,6 +1014,7 @@ void SecretChatActor::do_outbound_message_impl(unique_ptr<log_event::OutboundSec
   LOG(INFO) << tag("state_id", state_id);
   CHECK(state);
   state->message = std::move(binlog_event);
+  state->start_time = Time::now();
 
   // OutboundSecretMessage
   //
@@ -1682,7 +1683,12 @@ void SecretChatActor::on_outbound_send_message_finish(uint64 state_id) {
   if (!state) {
     return;
   }
-  LOG(INFO) << "Outbound secret message [send_message] finish " << tag("log_event_id", state->message->log_event_id());
+  auto send_time = Time::now() - state->start_time;
+  sent_message_count_++;
+  total_message_send_time_ += send_time;
+  LOG(INFO) << "Outbound secret message [send_message] finish " << tag("log_event_id", state->message->log_event_id())
+            << " in " << send_time << " seconds; average send time of " << sent_message_count_ << " messages is "
+            << total_message_send_time_ / static_cast<double>(sent_message_count_);
   state->send_message_finish_flag = true;
   state->outer_send_message_finish.set_value(Unit());
 
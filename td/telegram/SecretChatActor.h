@@ -594,11 +594,15 @@ class SecretChatActor final : public NetQueryCallback {
     bool net_query_may_fail = false;
 
     std::function<void(Promise<>)> send_result_;
+
+    double start_time = 0.0;
   };
   std::map<uint64, uint64> random_id_to_outbound_message_state_token_;
   std::map<int32, uint64> out_seq_no_to_outbound_message_state_token_;
 
   Container<OutboundMessageState> outbound_message_states_;
+  int64 sent_message_count_ = 0;
+  double total_message_send_time_ = 0.0;
 
   NetQueryRef set_typing_query_;
   NetQueryRef read_history_query_;
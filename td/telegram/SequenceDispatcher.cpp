@@ -8,6 +8,7 @@
 
 #include "td/telegram/Global.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
+#include "td/telegram/SequenceShardRouter.h"
 #include "td/telegram/Td.h"
 
 #include "td/actor/PromiseFuture.h"
@@ -18,10 +19,12 @@
 #include "td/utils/misc.h"
 #include "td/utils/Promise.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 
 #include <limits>
+#include <mutex>
 
 namespace td {
 
@@ -268,7 +271,7 @@ void MultiSequenceDispatcherOld::send(NetQueryPtr query) {
     data.dispatcher_ = create_actor<SequenceDispatcher>("SequenceDispatcher", actor_shared(this, sequence_id));
   }
   data.cnt_++;
-  query->debug(PSTRING() << "send to SequenceDispatcher " << sequence_id);
+  query->debug(PSLICE() << "send to SequenceDispatcher " << sequence_id);
   send_closure(data.dispatcher_, &SequenceDispatcher::send_with_callback, std::move(query), std::move(callback));
 }
 
@@ -287,8 +290,32 @@ void MultiSequenceDispatcherOld::ready_to_close() {
   }
 }
 
+class ShardedSequenceDispatcher::Router {
+ public:
+  void start(vector<ActorOwn<MultiSequenceDispatcher>> shards);
+
+  void send(NetQueryPtr query);
+
+  void on_task_finished(Span<uint64> chain_ids);
+
+  vector<NetQueryPtr> close();
+
+ private:
+  std::mutex mutex_;
+  vector<ActorOwn<MultiSequenceDispatcher>> shards_;
+  unique_ptr<SequenceShardRouter<NetQueryPtr>> router_;
+
+  void do_send(size_t shard, NetQueryPtr query);
+};
+
 class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
  public:
+  MultiSequenceDispatcherImpl() = default;
+
+  explicit MultiSequenceDispatcherImpl(std::weak_ptr<ShardedSequenceDispatcher::Router> router)
+      : router_(std::move(router)) {
+  }
+
   void send(NetQueryPtr query) final {
     auto callback = query->move_callback();
     auto chain_ids = query->get_chain_ids();
@@ -315,9 +342,22 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
     }
   };
   ChainScheduler<Node> scheduler_;
+  std::weak_ptr<ShardedSequenceDispatcher::Router> router_;
 
   using TaskId = ChainScheduler<Node>::TaskId;
 
+  void finish_task(TaskId task_id) {
+    auto router = router_.lock();
+    if (router == nullptr) {
+      return scheduler_.finish_task(task_id);
+    }
+
+    vector<uint64> chain_ids;
+    scheduler_.for_each_task_chain(task_id, [&chain_ids](uint64 chain_id) { chain_ids.push_back(chain_id); });
+    scheduler_.finish_task(task_id);
+    router->on_task_finished(chain_ids);
+  }
+
   bool check_timeout(Node &node) {
     auto &net_query = node.net_query;
     if (net_query.empty() || net_query->is_ready()) {
@@ -383,7 +423,7 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
     auto &node = *scheduler_.get_task_extra(task_id);
     if (node.callback.empty()) {
       auto query = std::move(node.net_query);
-      scheduler_.finish_task(task_id);
+      finish_task(task_id);
       send_closure_later(G()->td(), &Td::on_result, std::move(query));
       loop();
       return;
@@ -396,7 +436,7 @@ class MultiSequenceDispatcherImpl final : public MultiSequenceDispatcher {
     auto task_id = TaskId(get_link_token());
     auto &node = *scheduler_.get_task_extra(task_id);
     if (r_query.is_error()) {
-      scheduler_.finish_task(task_id);
+      finish_task(task_id);
     } else {
       do_resend(task_id, node, r_query.move_as_ok());
     }
@@ -459,4 +499,66 @@ ActorOwn<MultiSequenceDispatcher> MultiSequenceDispatcher::create(Slice name) {
   return ActorOwn<MultiSequenceDispatcher>(create_actor<MultiSequenceDispatcherImpl>(name));
 }
 
+void ShardedSequenceDispatcher::Router::start(vector<ActorOwn<MultiSequenceDispatcher>> shards) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  CHECK(shards_.empty());
+  CHECK(!shards.empty());
+  shards_ = std::move(shards);
+  router_ = make_unique<SequenceShardRouter<NetQueryPtr>>(shards_.size());
+}
+
+void ShardedSequenceDispatcher::Router::do_send(size_t shard, NetQueryPtr query) {
+  send_closure_later(shards_[shard], &MultiSequenceDispatcher::send, std::move(query));
+}
+
+void ShardedSequenceDispatcher::Router::send(NetQueryPtr query) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  CHECK(!shards_.empty());
+  auto chain_ids = query->get_chain_ids();
+  vector<uint64> query_chain_ids(chain_ids.begin(), chain_ids.end());
+  query->debug("send to ShardedSequenceDispatcher");
+  router_->add_query(std::move(query_chain_ids), std::move(query),
+                     [this](size_t shard, NetQueryPtr query) { do_send(shard, std::move(query)); });
+}
+
+void ShardedSequenceDispatcher::Router::on_task_finished(Span<uint64> chain_ids) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (shards_.empty()) {
+    return;
+  }
+  router_->on_query_finished(chain_ids, [this](size_t shard, NetQueryPtr query) { do_send(shard, std::move(query)); });
+}
+
+vector<NetQueryPtr> ShardedSequenceDispatcher::Router::close() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  shards_.clear();
+  if (router_ == nullptr) {
+    return {};
+  }
+  return router_->close();
+}
+
+ShardedSequenceDispatcher::ShardedSequenceDispatcher(Slice name, size_t shard_count)
+    : router_(std::make_shared<Router>()) {
+  CHECK(shard_count > 0);
+  vector<ActorOwn<MultiSequenceDispatcher>> shards;
+  for (size_t i = 0; i < shard_count; i++) {
+    shards.push_back(ActorOwn<MultiSequenceDispatcher>(
+        create_actor<MultiSequenceDispatcherImpl>(PSLICE() << name << ':' << i, std::weak_ptr<Router>(router_))));
+  }
+  router_->start(std::move(shards));
+}
+
+ShardedSequenceDispatcher::~ShardedSequenceDispatcher() {
+  router_->close();
+}
+
+void ShardedSequenceDispatcher::send(NetQueryPtr query) {
+  router_->send(std::move(query));
+}
+
+vector<NetQueryPtr> ShardedSequenceDispatcher::close() {
+  return router_->close();
+}
+
 }  // namespace td
@@ -16,6 +16,7 @@
 #include "td/utils/Slice.h"
 
 #include <limits>
+#include <memory>
 
 namespace td {
 
@@ -97,4 +98,27 @@ class MultiSequenceDispatcher : public NetQueryCallback {
   static ActorOwn<MultiSequenceDispatcher> create(Slice name);
 };
 
+// sends queries through several independent MultiSequenceDispatcher shards
+// all simultaneously sent queries, which have a common chain, are sent through the same shard
+class ShardedSequenceDispatcher {
+ public:
+  ShardedSequenceDispatcher(Slice name, size_t shard_count);
+  ShardedSequenceDispatcher(const ShardedSequenceDispatcher &) = delete;
+  ShardedSequenceDispatcher &operator=(const ShardedSequenceDispatcher &) = delete;
+  ShardedSequenceDispatcher(ShardedSequenceDispatcher &&) = delete;
+  ShardedSequenceDispatcher &operator=(ShardedSequenceDispatcher &&) = delete;
+  ~ShardedSequenceDispatcher();
+
+  // can be called from any thread
+  void send(NetQueryPtr query);
+
+  // stops all shards and returns queries, which weren't sent to a shard yet
+  vector<NetQueryPtr> close();
+
+  class Router;
+
+ private:
+  std::shared_ptr<Router> router_;
+};
+
 }  // namespace td
@@ -0,0 +1,160 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
+#include "td/utils/logging.h"
+#include "td/utils/Span.h"
+
+namespace td {
+
+// chooses shards for queries, so that all simultaneously sent queries, which have a common chain, are sent through
+// the same shard; a query, which chains are handled by different shards, waits until the chains are finished,
+// but doesn't delay queries with other chains
+template <class QueryT>
+class SequenceShardRouter {
+ public:
+  explicit SequenceShardRouter(size_t shard_count) : shard_count_(shard_count) {
+    CHECK(shard_count_ > 0);
+  }
+
+  // f(shard, query) is called for the query now or after the chains of the query are finished in other shards
+  template <class F>
+  void add_query(vector<uint64> chain_ids, QueryT query, F &&f) {
+    CHECK(!chain_ids.empty());
+    size_t shard = 0;
+    if (find_shard(chain_ids, nullptr, shard)) {
+      return send_query(shard, chain_ids, std::move(query), f);
+    }
+
+    for (auto chain_id : chain_ids) {
+      chains_[chain_id].blocked_query_count_++;
+    }
+    blocked_queries_.push_back({std::move(chain_ids), std::move(query)});
+  }
+
+  // must be called after a query sent to a shard is finished; may call f for blocked queries
+  template <class F>
+  void on_query_finished(Span<uint64> chain_ids, F &&f) {
+    for (auto chain_id : chain_ids) {
+      auto it = chains_.find(chain_id);
+      CHECK(it != chains_.end());
+      auto &chain_info = it->second;
+      CHECK(chain_info.query_count_ > 0);
+      chain_info.query_count_--;
+      if (chain_info.query_count_ == 0 && chain_info.blocked_query_count_ == 0) {
+        chains_.erase(it);
+      }
+    }
+    flush_blocked_queries(f);
+  }
+
+  size_t get_blocked_query_count() const {
+    return blocked_queries_.size();
+  }
+
+  // returns all blocked queries and forgets all chains
+  vector<QueryT> close() {
+    chains_ = {};
+    vector<QueryT> result;
+    for (auto &blocked_query : blocked_queries_) {
+      result.push_back(std::move(blocked_query.query_));
+    }
+    blocked_queries_.clear();
+    return result;
+  }
+
+ private:
+  struct ChainInfo {
+    size_t shard_ = 0;
+    int32 query_count_ = 0;          // the number of queries with the chain sent to the shard
+    int32 blocked_query_count_ = 0;  // the number of queries with the chain waiting in blocked_queries_
+  };
+
+  struct BlockedQuery {
+    vector<uint64> chain_ids_;
+    QueryT query_;
+  };
+
+  size_t shard_count_;
+  FlatHashMap<uint64, ChainInfo> chains_;
+  vector<BlockedQuery> blocked_queries_;  // queries with chains from different shards in the order of addition
+
+  // if blocked_chain_ids is nullptr, then the query must be sent after all blocked queries with the same chains;
+  // otherwise, the query is blocked and must be sent after blocked queries with chains from blocked_chain_ids
+  bool find_shard(const vector<uint64> &chain_ids, const FlatHashSet<uint64> *blocked_chain_ids, size_t &shard) const {
+    bool is_found = false;
+    for (auto chain_id : chain_ids) {
+      if (blocked_chain_ids != nullptr && blocked_chain_ids->count(chain_id) != 0) {
+        return false;
+      }
+      auto it = chains_.find(chain_id);
+      if (it == chains_.end()) {
+        continue;
+      }
+      const auto &chain_info = it->second;
+      if (chain_info.blocked_query_count_ > 0 && blocked_chain_ids == nullptr) {
+        // the query must be sent after a blocked query with the same chain
+        return false;
+      }
+      if (chain_info.query_count_ == 0) {
+        continue;
+      }
+      if (is_found && shard != chain_info.shard_) {
+        return false;
+      }
+      shard = chain_info.shard_;
+      is_found = true;
+    }
+    if (!is_found) {
+      shard = static_cast<size_t>(chain_ids[0] % shard_count_);
+    }
+    return true;
+  }
+
+  template <class F>
+  void send_query(size_t shard, const vector<uint64> &chain_ids, QueryT query, F &f) {
+    for (auto chain_id : chain_ids) {
+      auto &chain_info = chains_[chain_id];
+      chain_info.shard_ = shard;
+      chain_info.query_count_++;
+    }
+    f(shard, std::move(query));
+  }
+
+  template <class F>
+  void flush_blocked_queries(F &f) {
+    // a blocked query can be sent if there are no earlier blocked queries with the same chains
+    FlatHashSet<uint64> blocked_chain_ids;
+    size_t left_query_count = 0;
+    for (auto &blocked_query : blocked_queries_) {
+      size_t shard = 0;
+      if (!find_shard(blocked_query.chain_ids_, &blocked_chain_ids, shard)) {
+        for (auto chain_id : blocked_query.chain_ids_) {
+          blocked_chain_ids.insert(chain_id);
+        }
+        if (&blocked_queries_[left_query_count] != &blocked_query) {
+          blocked_queries_[left_query_count] = std::move(blocked_query);
+        }
+        left_query_count++;
+        continue;
+      }
+
+      for (auto chain_id : blocked_query.chain_ids_) {
+        auto &chain_info = chains_[chain_id];
+        CHECK(chain_info.blocked_query_count_ > 0);
+        chain_info.blocked_query_count_--;
+      }
+      send_query(shard, blocked_query.chain_ids_, std::move(blocked_query.query_), f);
+    }
+    blocked_queries_.erase(blocked_queries_.begin() + left_query_count, blocked_queries_.end());
+  }
+};
+
+}  // namespace td
@@ -0,0 +1,94 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/SharedServerDataCache.h"
+
+#include "td/telegram/Global.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
+
+#include <mutex>
+
+namespace td {
+
+static std::mutex shared_server_data_mutex;
+
+FlatHashMap<string, SharedServerDataCache::Response> &SharedServerDataCache::get_responses() {
+  static FlatHashMap<string, Response> responses;
+  return responses;
+}
+
+bool SharedServerDataCache::is_enabled() {
+  return G()->get_option_boolean("use_shared_server_data_cache");
+}
+
+string SharedServerDataCache::get_key(Slice name) {
+  return PSTRING() << (G()->is_test_dc() ? "test_" : "") << name;
+}
+
+const SharedServerDataCache::Response *SharedServerDataCache::get_recent_response(const string &key) {
+  auto &responses = get_responses();
+  auto it = responses.find(key);
+  if (it == responses.end() || it->second.received_at_ < Time::now() - MAX_RESPONSE_AGE) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+bool SharedServerDataCache::is_up_to_date(Slice name, int64 hash) {
+  if (!is_enabled()) {
+    return false;
+  }
+  auto key = get_key(name);
+  std::lock_guard<std::mutex> lock(shared_server_data_mutex);
+  auto response = get_recent_response(key);
+  return response != nullptr && response->hash_ == hash;
+}
+
+BufferSlice SharedServerDataCache::get_response(Slice name, int64 hash) {
+  if (!is_enabled()) {
+    return BufferSlice();
+  }
+  auto key = get_key(name);
+  std::lock_guard<std::mutex> lock(shared_server_data_mutex);
+  auto response = get_recent_response(key);
+  if (response == nullptr || response->hash_ == hash) {
+    return BufferSlice();
+  }
+  LOG(INFO) << "Use shared " << key << " with hash " << response->hash_;
+  return response->response_.clone();
+}
+
+BufferSlice SharedServerDataCache::get_response(Slice name) {
+  if (!is_enabled()) {
+    return BufferSlice();
+  }
+  auto key = get_key(name);
+  std::lock_guard<std::mutex> lock(shared_server_data_mutex);
+  auto response = get_recent_response(key);
+  if (response == nullptr) {
+    return BufferSlice();
+  }
+  LOG(INFO) << "Use shared " << key << " with hash " << response->hash_;
+  return response->response_.clone();
+}
+
+void SharedServerDataCache::add_response(Slice name, int64 hash, const BufferSlice &response) {
+  if (!is_enabled() || response.empty()) {
+    return;
+  }
+  auto key = get_key(name);
+  Response new_response;
+  new_response.hash_ = hash;
+  new_response.response_ = response.copy();
+  new_response.received_at_ = Time::now();
+  std::lock_guard<std::mutex> lock(shared_server_data_mutex);
+  get_responses()[std::move(key)] = std::move(new_response);
+}
+
+}  // namespace td
@@ -0,0 +1,49 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+// process-wide cache of server responses, which are the same for all users and identified by a hash or a version
+// used only by clients with the option "use_shared_server_data_cache" enabled
+class SharedServerDataCache {
+ public:
+  // returns true, if the response with the given hash was recently received and the data doesn't need to be requested
+  static bool is_up_to_date(Slice name, int64 hash);
+
+  // returns a recently received response with a hash different from the given one or an empty buffer
+  static BufferSlice get_response(Slice name, int64 hash);
+
+  // returns a recently received response or an empty buffer
+  static BufferSlice get_response(Slice name);
+
+  static void add_response(Slice name, int64 hash, const BufferSlice &response);
+
+ private:
+  static constexpr double MAX_RESPONSE_AGE = 3600.0;  // the maximum time during which a response is reused
+
+  struct Response {
+    int64 hash_ = 0;
+    BufferSlice response_;
+    double received_at_ = 0.0;
+  };
+
+  static bool is_enabled();
+
+  static FlatHashMap<string, Response> &get_responses();
+
+  static string get_key(Slice name);
+
+  static const Response *get_recent_response(const string &key);
+};
+
+}  // namespace td
@@ -306,7 +306,7 @@ void SponsoredMessageManager::get_dialog_sponsored_messages(
 
   auto &messages = dialog_sponsored_messages_[dialog_id];
   if (messages != nullptr && messages->promises.empty()) {
-    if (messages->is_premium == td_->option_manager_->get_option_boolean("is_premium", false)) {
+    if (messages->is_premium == td_->option_manager_->get_option_boolean(OptionId::IsPremium, false)) {
       // use cached value
       return promise.set_value(get_sponsored_messages_object(dialog_id, *messages));
     } else {
@@ -397,7 +397,7 @@ void SponsoredMessageManager::on_get_dialog_sponsored_messages(
     default:
       UNREACHABLE();
   }
-  messages->is_premium = td_->option_manager_->get_option_boolean("is_premium", false);
+  messages->is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium, false);
 
   for (auto &promise : promises) {
     promise.set_value(get_sponsored_messages_object(dialog_id, *messages));
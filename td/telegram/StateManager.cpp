@@ -131,7 +131,7 @@ void StateManager::on_network_soft() {
 }
 
 void StateManager::start_up() {
-  if (!G()->get_option_boolean("disable_network_statistics")) {
+  if (!G()->get_option_boolean(OptionId::DisableNetworkStatistics)) {
     create_actor<SleepActor>("SleepActor", 1, create_event_promise(self_closure(this, &StateManager::on_network_soft)))
         .release();
   }
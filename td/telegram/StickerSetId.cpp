@@ -16,6 +16,10 @@ void StickerSetId::store(LogEventStorerCalcLength &storer) const {
   storer.context()->td().get_actor_unsafe()->stickers_manager_->store_sticker_set_id(*this, storer);
 }
 
+void StickerSetId::store(LogEventStorerGrowable &storer) const {
+  storer.context()->td().get_actor_unsafe()->stickers_manager_->store_sticker_set_id(*this, storer);
+}
+
 void StickerSetId::store(LogEventStorerUnsafe &storer) const {
   storer.context()->td().get_actor_unsafe()->stickers_manager_->store_sticker_set_id(*this, storer);
 }
@@ -45,6 +45,8 @@ class StickerSetId {
 
   void store(LogEventStorerCalcLength &storer) const;
 
+  void store(LogEventStorerGrowable &storer) const;
+
   void store(LogEventStorerUnsafe &storer) const;
 
   void parse(LogEventParser &parser);
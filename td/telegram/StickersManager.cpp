@@ -32,6 +32,7 @@
 #include "td/telegram/PhotoSizeSource.h"
 #include "td/telegram/secret_api.h"
 #include "td/telegram/SecretChatLayer.h"
+#include "td/telegram/SharedServerDataCache.h"
 #include "td/telegram/StickersManager.hpp"
 #include "td/telegram/Td.h"
 #include "td/telegram/td_api.h"
@@ -198,6 +199,8 @@ class GetEmojiKeywordsLanguageQuery final : public Td::ResultHandler {
 
 class GetEmojiKeywordsQuery final : public Td::ResultHandler {
   Promise<telegram_api::object_ptr<telegram_api::emojiKeywordsDifference>> promise_;
+  string language_code_;
+  bool is_shared_ = false;
 
  public:
   explicit GetEmojiKeywordsQuery(Promise<telegram_api::object_ptr<telegram_api::emojiKeywordsDifference>> &&promise)
@@ -205,6 +208,13 @@ class GetEmojiKeywordsQuery final : public Td::ResultHandler {
   }
 
   void send(const string &language_code) {
+    language_code_ = language_code;
+    auto response = SharedServerDataCache::get_response(PSLICE() << "emoji_keywords_" << language_code);
+    if (!response.empty()) {
+      is_shared_ = true;
+      return on_result(std::move(response));
+    }
+
     send_query(G()->net_query_creator().create(telegram_api::messages_getEmojiKeywords(language_code)));
   }
 
@@ -214,7 +224,11 @@ class GetEmojiKeywordsQuery final : public Td::ResultHandler {
       return on_error(result_ptr.move_as_error());
     }
 
-    promise_.set_value(result_ptr.move_as_ok());
+    auto ptr = result_ptr.move_as_ok();
+    if (!is_shared_) {
+      SharedServerDataCache::add_response(PSLICE() << "emoji_keywords_" << language_code_, ptr->version_, packet);
+    }
+    promise_.set_value(std::move(ptr));
   }
 
   void on_error(Status status) final {
@@ -2601,7 +2615,7 @@ tl_object_ptr<td_api::stickerSetInfo> StickersManager::get_sticker_set_info_obje
     vector<FileId> regular_sticker_ids;
     vector<FileId> premium_sticker_ids;
     std::tie(regular_sticker_ids, premium_sticker_ids) = split_stickers_by_premium(sticker_set);
-    auto is_premium = td_->option_manager_->get_option_boolean("is_premium");
+    auto is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
     size_t max_premium_stickers = is_premium ? covers_limit : 1;
     if (premium_sticker_ids.size() > max_premium_stickers) {
       premium_sticker_ids.resize(max_premium_stickers);
@@ -4506,7 +4520,7 @@ vector<FileId> StickersManager::get_stickers(StickerType sticker_type, string qu
       vector<FileId> regular_sticker_ids;
       vector<FileId> premium_sticker_ids;
       std::tie(regular_sticker_ids, premium_sticker_ids) = split_stickers_by_premium(result);
-      if (td_->option_manager_->get_option_boolean("is_premium") || allow_premium) {
+      if (td_->option_manager_->get_option_boolean(OptionId::IsPremium) || allow_premium) {
         auto normal_count = td_->option_manager_->get_option_integer("stickers_normal_by_emoji_per_premium_num", 2);
         if (normal_count < 0) {
           normal_count = 2;
@@ -5288,18 +5302,13 @@ string StickersManager::get_full_sticker_set_database_key(StickerSetId set_id) {
 }
 
 string StickersManager::get_sticker_set_database_value(const StickerSet *s, bool with_stickers, const char *source) {
-  LogEventStorerCalcLength storer_calc_length;
-  store_sticker_set(s, with_stickers, storer_calc_length, source);
-
-  BufferSlice value_buffer{storer_calc_length.get_length()};
-  auto value = value_buffer.as_mutable_slice();
+  string value;
+  LogEventStorerGrowable storer(value);
+  store_sticker_set(s, with_stickers, storer, source);
+  value.resize(storer.get_length());
 
   LOG(DEBUG) << "Serialized size of " << s->id_ << " is " << value.size();
-
-  LogEventStorerUnsafe storer_unsafe(value.ubegin());
-  store_sticker_set(s, with_stickers, storer_unsafe, source);
-
-  return value.str();
+  return value;
 }
 
 void StickersManager::update_sticker_set(StickerSet *sticker_set, const char *source) {
@@ -6977,7 +6986,8 @@ void StickersManager::send_update_animated_emoji_clicked(MessageFullId message_f
     return;
   }
   auto dialog_id = message_full_id.get_dialog_id();
-  if (!td_->dialog_manager_->have_input_peer(dialog_id, false, AccessRights::Write)) {
+  if (!td_->dialog_manager_->have_input_peer(dialog_id, false, AccessRights::Write) ||
+      td_->is_update_ignored(td_api::updateAnimatedEmojiMessageClicked::ID)) {
     return;
   }
 
@@ -23,6 +23,7 @@
 #include "td/utils/port/Stat.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 
 namespace td {
@@ -40,9 +41,11 @@ void StorageManager::start_up() {
   schedule_next_gc();
 
   load_fast_stat();
+  load_file_stats_index();
 }
 
-void StorageManager::on_new_file(int64 size, int64 real_size, int32 cnt) {
+void StorageManager::on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int64 real_size,
+                                 int32 cnt) {
   LOG(INFO) << "Add " << cnt << " file of size " << size << " with real size " << real_size
             << " to fast storage statistics";
   fast_stat_.cnt += cnt;
@@ -58,9 +61,22 @@ void StorageManager::on_new_file(int64 size, int64 real_size, int32 cnt) {
     fast_stat_ = FileTypeStat();
   }
   save_fast_stat();
+  if (add_size > 0) {
+    check_files_size_limit();
+  }
+
+  if (has_file_stats_index()) {
+    file_stats_index_.add_delta(file_type, owner_dialog_id, add_size, cnt);
+    if (!is_file_stats_index_changed_) {
+      // the index is saved only on rebuild and on close; if the changes are lost, then the saved index is discarded
+      is_file_stats_index_changed_ = true;
+      G()->td_db()->get_binlog_pmc()->set("file_stats_index_changed", "1");
+    }
+  }
 }
 
-void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit, Promise<FileStats> promise) {
+void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit, bool can_use_index,
+                                       Promise<FileStats> promise) {
   if (is_closed_) {
     return promise.set_error(Global::request_aborted_error());
   }
@@ -72,6 +88,16 @@ void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit,
     //TODO group same queries
     close_stats_worker();
   }
+  if (!need_all_files && can_use_index && has_file_stats_index()) {
+    LOG(INFO) << "Return storage statistics from the index";
+    auto stats = file_stats_index_.get_aggregated_copy();
+    if (dialog_limit == 0) {
+      stats.merge_owner_dialogs();
+    }
+    vector<Promise<FileStats>> promises;
+    promises.push_back(std::move(promise));
+    return send_stats(std::move(stats), dialog_limit, std::move(promises));
+  }
   if (!pending_run_gc_[0].empty() || !pending_run_gc_[1].empty()) {
     close_gc_worker();
   }
@@ -80,7 +106,8 @@ void StorageManager::get_storage_stats(bool need_all_files, int32 dialog_limit,
   pending_storage_stats_.emplace_back(std::move(promise));
 
   create_stats_worker();
-  send_closure(stats_worker_, &FileStatsWorker::get_stats, need_all_files, stats_dialog_limit_ != 0,
+  // files are always split by owner dialog to rebuild the index
+  send_closure(stats_worker_, &FileStatsWorker::get_stats, need_all_files, true,
                PromiseCreator::lambda(
                    [actor_id = actor_id(this), stats_generation = stats_generation_](Result<FileStats> file_stats) {
                      send_closure(actor_id, &StorageManager::on_file_stats, std::move(file_stats), stats_generation);
@@ -93,13 +120,22 @@ void StorageManager::get_storage_stats_fast(Promise<FileStatsFast> promise) {
 }
 
 void StorageManager::get_database_stats(Promise<DatabaseStats> promise) {
-  //TODO: use another thread
-  auto r_stats = G()->td_db()->get_stats();
-  if (r_stats.is_error()) {
-    promise.set_error(r_stats.move_as_error());
-  } else {
-    promise.set_value(DatabaseStats(r_stats.move_as_ok()));
-  }
+  // the whole database is scanned on the low-priority GC thread through its own SQLite connection,
+  // and then statistics of the connection of the database thread are collected on the database thread
+  bool with_compression_stats = G()->get_option_boolean("use_message_database_compression");
+  Scheduler::instance()->run_on_scheduler(
+      G()->get_gc_scheduler_id(),
+      PromiseCreator::lambda([with_compression_stats, promise = std::move(promise)](Unit) mutable {
+        TRY_STATUS_PROMISE(promise, G()->close_status());
+        TRY_RESULT_PROMISE(promise, stats, G()->td_db()->get_stats(with_compression_stats));
+        Scheduler::instance()->run_on_scheduler(
+            G()->get_database_scheduler_id(),
+            PromiseCreator::lambda([stats = std::move(stats), promise = std::move(promise)](Unit) mutable {
+              TRY_STATUS_PROMISE(promise, G()->close_status());
+              TRY_RESULT_PROMISE(promise, connection_stats, G()->td_db()->get_connection_stats());
+              promise.set_value(DatabaseStats(stats + connection_stats));
+            }));
+      }));
 }
 
 void StorageManager::update_use_storage_optimizer() {
@@ -118,7 +154,7 @@ void StorageManager::run_gc(FileGcParameters parameters, bool return_deleted_fil
   bool split_by_owner_dialog_id = !parameters.owner_dialog_ids_.empty() ||
                                   !parameters.exclude_owner_dialog_ids_.empty() || parameters.dialog_limit_ != 0;
   get_storage_stats(
-      true /*need_all_files*/, split_by_owner_dialog_id,
+      true /*need_all_files*/, split_by_owner_dialog_id, false /*can_use_index*/,
       PromiseCreator::lambda(
           [actor_id = actor_id(this), parameters = std::move(parameters)](Result<FileStats> file_stats) mutable {
             send_closure(actor_id, &StorageManager::on_all_files, std::move(parameters), std::move(file_stats));
@@ -138,7 +174,12 @@ void StorageManager::on_file_stats(Result<FileStats> r_file_stats, uint32 genera
   }
 
   update_fast_stats(r_file_stats.ok());
-  send_stats(r_file_stats.move_as_ok(), stats_dialog_limit_, std::move(pending_storage_stats_));
+  update_file_stats_index(r_file_stats.ok());
+  auto file_stats = r_file_stats.move_as_ok();
+  if (stats_dialog_limit_ == 0) {
+    file_stats.merge_owner_dialogs();
+  }
+  send_stats(std::move(file_stats), stats_dialog_limit_, std::move(pending_storage_stats_));
 }
 
 void StorageManager::create_stats_worker() {
@@ -223,6 +264,12 @@ void StorageManager::on_gc_finished(int32 dialog_limit, Result<FileGcResult> r_f
   }
 
   update_fast_stats(r_file_gc_result.ok().kept_file_stats_);
+  update_file_stats_index(r_file_gc_result.ok().kept_file_stats_);
+  gc_kept_files_size_ = fast_stat_.size;
+  if (dialog_limit == 0) {
+    r_file_gc_result.ok_ref().kept_file_stats_.merge_owner_dialogs();
+    r_file_gc_result.ok_ref().removed_file_stats_.merge_owner_dialogs();
+  }
 
   auto kept_file_promises = std::move(pending_run_gc_[0]);
   auto removed_file_promises = std::move(pending_run_gc_[1]);
@@ -242,6 +289,55 @@ void StorageManager::load_fast_stat() {
   LOG(INFO) << "Loaded fast storage statistics with " << fast_stat_.cnt << " files of total size " << fast_stat_.size;
 }
 
+bool StorageManager::has_file_stats_index() const {
+  auto now = static_cast<uint32>(Clocks::system());
+  return file_stats_index_date_ != 0 && file_stats_index_date_ <= now &&
+         now - file_stats_index_date_ < static_cast<uint32>(FILE_STATS_INDEX_TTL);
+}
+
+void StorageManager::update_file_stats_index(const FileStats &stats) {
+  // the index is rebuilt after each full scan to fix changes, which weren't tracked incrementally
+  file_stats_index_ = stats.get_aggregated_copy();
+  file_stats_index_date_ = static_cast<uint32>(Clocks::system());
+  auto total_stat = file_stats_index_.get_total_nontemp_stat();
+  LOG(INFO) << "Rebuild storage statistics index with " << total_stat.cnt << " files of total size "
+            << total_stat.size;
+  save_file_stats_index();
+}
+
+void StorageManager::save_file_stats_index() {
+  auto binlog_pmc = G()->td_db()->get_binlog_pmc();
+  binlog_pmc->set("file_stats_index",
+                  PSTRING() << file_stats_index_date_ << ' ' << log_event_store(file_stats_index_).as_slice());
+  if (is_file_stats_index_changed_) {
+    is_file_stats_index_changed_ = false;
+    binlog_pmc->erase("file_stats_index_changed");
+  }
+}
+
+void StorageManager::load_file_stats_index() {
+  auto binlog_pmc = G()->td_db()->get_binlog_pmc();
+  if (!binlog_pmc->get("file_stats_index_changed").empty()) {
+    LOG(INFO) << "Drop outdated storage statistics index";
+    binlog_pmc->erase("file_stats_index");
+    binlog_pmc->erase("file_stats_index_changed");
+    return;
+  }
+  auto value = binlog_pmc->get("file_stats_index");
+  if (value.empty()) {
+    return;
+  }
+  auto date_and_index = split(Slice(value));
+  FileStats file_stats_index(false, true);
+  if (log_event_parse(file_stats_index, date_and_index.second).is_error()) {
+    LOG(ERROR) << "Failed to load storage statistics index";
+    return;
+  }
+  file_stats_index_ = std::move(file_stats_index);
+  file_stats_index_date_ = to_integer<uint32>(date_and_index.first);
+  LOG(INFO) << "Loaded storage statistics index from " << file_stats_index_date_;
+}
+
 void StorageManager::update_fast_stats(const FileStats &stats) {
   fast_stat_ = stats.get_total_nontemp_stat();
   LOG(INFO) << "Recalculate fast storage statistics to " << fast_stat_.cnt << " files of total size "
@@ -304,6 +400,9 @@ void StorageManager::close_gc_worker() {
 
 void StorageManager::hangup() {
   is_closed_ = true;
+  if (is_file_stats_index_changed_) {
+    save_file_stats_index();
+  }
   close_stats_worker();
   close_gc_worker();
   hangup_shared();
@@ -344,6 +443,27 @@ void StorageManager::schedule_next_gc() {
   set_timeout_at(next_gc_at_);
 }
 
+void StorageManager::check_files_size_limit() {
+  if (is_closed_ || next_gc_at_ == 0) {
+    // storage optimizer is disabled or the GC is already running
+    return;
+  }
+  // the limit can be unreachable because of immune files, so wait for new files after the last GC
+  auto max_files_size = G()->get_option_integer("storage_max_files_size", 100 << 10) << 10;
+  if (fast_stat_.size <= td::max(max_files_size, gc_kept_files_size_)) {
+    return;
+  }
+  auto now = Time::now();
+  if (now < last_gc_by_size_at_ + GC_BY_SIZE_DELAY || next_gc_at_ <= now) {
+    return;
+  }
+  LOG(INFO) << "Run file clean up, because total size of files " << fast_stat_.size << " exceeds the limit "
+            << max_files_size;
+  last_gc_by_size_at_ = now;
+  next_gc_at_ = now;
+  set_timeout_at(next_gc_at_);
+}
+
 void StorageManager::timeout_expired() {
   if (next_gc_at_ == 0) {
     return;
@@ -6,9 +6,11 @@
 //
 #pragma once
 
+#include "td/telegram/DialogId.h"
 #include "td/telegram/files/FileGcWorker.h"
 #include "td/telegram/files/FileStats.h"
 #include "td/telegram/files/FileStatsWorker.h"
+#include "td/telegram/files/FileType.h"
 #include "td/telegram/td_api.h"
 
 #include "td/actor/actor.h"
@@ -32,18 +34,21 @@ struct DatabaseStats {
 class StorageManager final : public Actor {
  public:
   StorageManager(ActorShared<> parent, int32 scheduler_id);
-  void get_storage_stats(bool need_all_files, int32 dialog_limit, Promise<FileStats> promise);
+  // the index of file statistics can be used only if the StorageManager is notified about all new and deleted files
+  void get_storage_stats(bool need_all_files, int32 dialog_limit, bool can_use_index, Promise<FileStats> promise);
   void get_storage_stats_fast(Promise<FileStatsFast> promise);
   void get_database_stats(Promise<DatabaseStats> promise);
   void run_gc(FileGcParameters parameters, bool return_deleted_file_statistics, Promise<FileStats> promise);
   void update_use_storage_optimizer();
 
-  void on_new_file(int64 size, int64 real_size, int32 cnt);
+  void on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int64 real_size, int32 cnt);
 
  private:
   static constexpr int GC_EACH = 60 * 60 * 24;  // 1 day
   static constexpr int GC_DELAY = 60;
   static constexpr int GC_RAND_DELAY = 60 * 15;
+  static constexpr double GC_BY_SIZE_DELAY = 60.0 * 10;
+  static constexpr int FILE_STATS_INDEX_TTL = 60 * 60 * 24;  // 1 day
 
   ActorShared<> parent_;
 
@@ -58,6 +63,11 @@ class StorageManager final : public Actor {
 
   FileTypeStat fast_stat_;
 
+  // statistics of all files by owner dialog and file type, which is incrementally updated after each full scan
+  FileStats file_stats_index_{false, true};
+  uint32 file_stats_index_date_ = 0;
+  bool is_file_stats_index_changed_ = false;  // the index has changes, which aren't saved to the database
+
   CancellationTokenSource stats_cancellation_token_source_;
   CancellationTokenSource gc_cancellation_token_source_;
 
@@ -68,6 +78,11 @@ class StorageManager final : public Actor {
 
   void save_fast_stat();
   void load_fast_stat();
+
+  bool has_file_stats_index() const;
+  void update_file_stats_index(const FileStats &stats);
+  void save_file_stats_index();
+  void load_file_stats_index();
   static int64 get_database_size();
   static int64 get_language_pack_database_size();
   static int64 get_log_size();
@@ -87,6 +102,8 @@ class StorageManager final : public Actor {
 
   uint32 last_gc_timestamp_ = 0;
   double next_gc_at_ = 0;
+  double last_gc_by_size_at_ = 0;
+  int64 gc_kept_files_size_ = 0;
 
   void on_all_files(FileGcParameters gc_parameters, Result<FileStats> r_file_stats);
   void create_gc_worker();
@@ -98,6 +115,7 @@ class StorageManager final : public Actor {
   uint32 load_last_gc_timestamp();
   void save_last_gc_timestamp();
   void schedule_next_gc();
+  void check_files_size_limit();
 
   void timeout_expired() final;
 };
@@ -164,6 +164,10 @@ void store_story_content(const StoryContent *content, LogEventStorerCalcLength &
   store(content, storer);
 }
 
+void store_story_content(const StoryContent *content, LogEventStorerGrowable &storer) {
+  store(content, storer);
+}
+
 void store_story_content(const StoryContent *content, LogEventStorerUnsafe &storer) {
   store(content, storer);
 }
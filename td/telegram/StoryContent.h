@@ -35,6 +35,8 @@ class StoryContent {
 
 void store_story_content(const StoryContent *content, LogEventStorerCalcLength &storer);
 
+void store_story_content(const StoryContent *content, LogEventStorerGrowable &storer);
+
 void store_story_content(const StoryContent *content, LogEventStorerUnsafe &storer);
 
 void parse_story_content(unique_ptr<StoryContent> &content, LogEventParser &parser);
@@ -1417,6 +1417,9 @@ StoryManager::StoryManager(Td *td, ActorShared<> parent) : td_(td), parent_(std:
   story_can_get_viewers_timeout_.set_callback(on_story_can_get_viewers_timeout_callback);
   story_can_get_viewers_timeout_.set_callback_data(static_cast<void *>(this));
 
+  story_unload_timeout_.set_callback(on_story_unload_timeout_callback);
+  story_unload_timeout_.set_callback_data(static_cast<void *>(this));
+
   if (G()->use_message_database() && td_->auth_manager_->is_authorized() && !td_->auth_manager_->is_bot()) {
     for (auto story_list_id : {StoryListId::main(), StoryListId::archive()}) {
       auto r_value = G()->td_db()->get_story_db_sync()->get_active_story_list_state(story_list_id);
@@ -1449,6 +1452,11 @@ void StoryManager::start_up() {
   if (!td_->auth_manager_->is_authorized()) {
     return;
   }
+  if (td_->auth_manager_->is_bot()) {
+    // bots have no stealth mode and story lists; only expired stories need to be deleted from the database
+    load_expired_database_stories();
+    return;
+  }
 
   auto stealth_mode_str = G()->td_db()->get_binlog_pmc()->get(get_story_stealth_mode_key());
   if (!stealth_mode_str.empty()) {
@@ -1556,6 +1564,9 @@ void StoryManager::on_story_expire_timeout(int64 story_global_id) {
   if (story->content_ != nullptr && !can_access_expired_story(owner_dialog_id, story)) {
     on_delete_story(story_full_id);  // also updates active stories
   } else {
+    if (story->content_ != nullptr && G()->use_message_database()) {
+      set_story_unload_timeout(story);
+    }
     auto active_stories = get_active_stories(owner_dialog_id);
     if (active_stories != nullptr && contains(active_stories->story_ids_, story_full_id.get_story_id())) {
       auto story_ids = active_stories->story_ids_;
@@ -1600,6 +1611,49 @@ void StoryManager::on_story_can_get_viewers_timeout(int64 story_global_id) {
   reload_story(story_full_id, Promise<Unit>(), "on_story_can_get_viewers_timeout");
 }
 
+void StoryManager::on_story_unload_timeout_callback(void *story_manager_ptr, int64 story_global_id) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  auto story_manager = static_cast<StoryManager *>(story_manager_ptr);
+  send_closure_later(story_manager->actor_id(story_manager), &StoryManager::on_story_unload_timeout, story_global_id);
+}
+
+void StoryManager::on_story_unload_timeout(int64 story_global_id) {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  auto story_full_id = stories_by_global_id_.get(story_global_id);
+  auto story = get_story(story_full_id);
+  if (story == nullptr) {
+    return;
+  }
+
+  if (!can_unload_story(story_full_id, story)) {
+    if (!is_active_story(story)) {
+      set_story_unload_timeout(story);
+    }
+    return;
+  }
+
+  LOG(INFO) << "Unload " << story_full_id;
+  if (story->is_update_sent_) {
+    unloaded_sent_story_full_ids_.insert(story_full_id);
+  }
+  unregister_story_global_id(story);
+  stories_.erase(story_full_id);
+}
+
+bool StoryManager::can_unload_story(StoryFullId story_full_id, const Story *story) const {
+  // the story must be reloadable from the database and must not be used by any other object
+  return G()->use_message_database() && story_full_id.get_story_id().is_server() && story->content_ != nullptr &&
+         !is_active_story(story) && opened_stories_.count(story_full_id) == 0 &&
+         opened_stories_with_view_count_.count(story_full_id) == 0 &&
+         being_edited_stories_.count(story_full_id) == 0 && story_messages_.count(story_full_id) == 0;
+}
+
 void StoryManager::load_expired_database_stories() {
   if (!G()->use_message_database()) {
     if (!td_->auth_manager_->is_bot()) {
@@ -1861,6 +1915,11 @@ StoryManager::Story *StoryManager::on_get_story_from_database(StoryFullId story_
 
   on_story_changed(story_full_id, result, true, false, true);
 
+  if (unloaded_sent_story_full_ids_.erase(story_full_id) != 0) {
+    // the application already knows the story; subsequent changes must be sent to it
+    result->is_update_sent_ = true;
+  }
+
   return result;
 }
 
@@ -2697,7 +2756,7 @@ bool StoryManager::can_use_story_reaction(const Story *story, const ReactionType
     return true;
   }
   if (reaction_type.is_custom_reaction()) {
-    if (td_->option_manager_->get_option_boolean("is_premium")) {
+    if (td_->option_manager_->get_option_boolean(OptionId::IsPremium)) {
       return true;
     }
     if (has_suggested_reaction(story, reaction_type)) {
@@ -3707,6 +3766,7 @@ void StoryManager::on_delete_story(StoryFullId story_full_id) {
   }
 
   update_story_ids_.erase(story_full_id);
+  unloaded_sent_story_full_ids_.erase(story_full_id);
 
   inaccessible_story_full_ids_.set(story_full_id, Time::now());
   send_closure_later(G()->messages_manager(),
@@ -3768,6 +3828,11 @@ void StoryManager::set_story_can_get_viewers_timeout(const Story *story) {
                                                 get_story_viewers_expire_date(story) - G()->unix_time() + 2);
 }
 
+void StoryManager::set_story_unload_timeout(const Story *story) {
+  CHECK(story->global_id_ > 0);
+  story_unload_timeout_.set_timeout_in(story->global_id_, STORY_UNLOAD_DELAY);
+}
+
 void StoryManager::on_story_changed(StoryFullId story_full_id, const Story *story, bool is_changed,
                                     bool need_save_to_database, bool from_database) {
   if (!story_full_id.get_story_id().is_server()) {
@@ -3782,6 +3847,9 @@ void StoryManager::on_story_changed(StoryFullId story_full_id, const Story *stor
   if (story->content_ == nullptr) {
     return;
   }
+  if (G()->use_message_database() && !is_active_story(story)) {
+    set_story_unload_timeout(story);
+  }
   if (is_changed || need_save_to_database) {
     if (G()->use_message_database() && !from_database) {
       LOG(INFO) << "Add " << story_full_id << " to database";
@@ -4876,7 +4944,7 @@ void StoryManager::send_story(DialogId dialog_id, td_api::object_ptr<td_api::Inp
     forward_info->hide_sender_if_needed(td_);
   }
   if (active_period != 86400 && !(G()->is_test_dc() && (active_period == 60 || active_period == 300))) {
-    bool is_premium = td_->option_manager_->get_option_boolean("is_premium");
+    bool is_premium = td_->option_manager_->get_option_boolean(OptionId::IsPremium);
     if (!is_premium || !td::contains(vector<int32>{6 * 3600, 12 * 3600, 2 * 86400}, active_period)) {
       return promise.set_error(Status::Error(400, "Invalid story active period specified"));
     }
@@ -370,6 +370,7 @@ class StoryManager final : public Actor {
   static constexpr int32 VIEWED_STORY_POLL_PERIOD = 300;
 
   static constexpr int32 DEFAULT_LOADED_EXPIRED_STORIES = 50;
+  static constexpr int32 STORY_UNLOAD_DELAY = 3600;  // expired stories are unloaded from memory after the delay
 
   void start_up() final;
 
@@ -391,6 +392,12 @@ class StoryManager final : public Actor {
 
   void on_story_can_get_viewers_timeout(int64 story_global_id);
 
+  static void on_story_unload_timeout_callback(void *story_manager_ptr, int64 story_global_id);
+
+  void on_story_unload_timeout(int64 story_global_id);
+
+  bool can_unload_story(StoryFullId story_full_id, const Story *story) const;
+
   bool is_my_story(DialogId owner_dialog_id) const;
 
   bool can_access_expired_story(DialogId owner_dialog_id, const Story *story) const;
@@ -448,6 +455,8 @@ class StoryManager final : public Actor {
 
   void set_story_can_get_viewers_timeout(const Story *story);
 
+  void set_story_unload_timeout(const Story *story);
+
   void on_story_changed(StoryFullId story_full_id, const Story *story, bool is_changed, bool need_save_to_database,
                         bool from_database = false);
 
@@ -688,6 +697,8 @@ class StoryManager final : public Actor {
 
   FlatHashMap<StoryFullId, StoryId, StoryFullIdHash> update_story_ids_;
 
+  FlatHashSet<StoryFullId, StoryFullIdHash> unloaded_sent_story_full_ids_;  // unloaded stories known to the app
+
   FlatHashMap<int64, vector<Promise<Unit>>> delete_yet_unsent_story_queries_;
 
   FlatHashMap<uint32, unique_ptr<ReadyToSendStory>> ready_to_send_stories_;
@@ -722,6 +733,7 @@ class StoryManager final : public Actor {
   MultiTimeout story_reload_timeout_{"StoryReloadTimeout"};
   MultiTimeout story_expire_timeout_{"StoryExpireTimeout"};
   MultiTimeout story_can_get_viewers_timeout_{"StoryCanGetViewersTimeout"};
+  MultiTimeout story_unload_timeout_{"StoryUnloadTimeout"};
 
   Td *td_;
   ActorShared<> parent_;
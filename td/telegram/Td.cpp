@@ -90,6 +90,7 @@
 #include "td/telegram/MessageEntity.h"
 #include "td/telegram/MessageFullId.h"
 #include "td/telegram/MessageId.h"
+#include "td/telegram/MessageBroadcastManager.h"
 #include "td/telegram/MessageImportManager.h"
 #include "td/telegram/MessageLinkInfo.h"
 #include "td/telegram/MessageQuote.h"
@@ -105,6 +106,7 @@
 #include "td/telegram/net/MtprotoHeader.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/net/NetQueryDelayer.h"
+#include "td/telegram/net/NetQueryCreator.h"
 #include "td/telegram/net/NetQueryDispatcher.h"
 #include "td/telegram/net/NetStatsManager.h"
 #include "td/telegram/net/NetType.h"
@@ -183,12 +185,17 @@
 #include "td/mtproto/RSA.h"
 #include "td/mtproto/TransportType.h"
 
+#include "td/net/SslCtx.h"
+
 #include "td/actor/actor.h"
+#include "td/actor/ActorStatistics.h"
 
 #include "td/utils/algorithm.h"
 #include "td/utils/buffer.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/format.h"
+#include "td/utils/MemoryAttribution.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/MimeType.h"
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
@@ -199,6 +206,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
 #include "td/utils/Timer.h"
 #include "td/utils/utf8.h"
 
@@ -2476,6 +2484,10 @@ void Td::on_alarm_timeout(int64 alarm_id) {
     }
     return;
   }
+  if (alarm_id == FLUSH_COALESCED_UPDATES_ALARM_ID) {
+    flush_coalesced_updates();
+    return;
+  }
   if (alarm_id == PROMO_DATA_ALARM_ID) {
     if (!close_flag_ && !auth_manager_->is_bot()) {
       reloading_promo_data_ = true;
@@ -2643,7 +2655,7 @@ void Td::set_is_online(bool is_online) {
 void Td::set_is_bot_online(bool is_bot_online) {
   alarm_timeout_.set_timeout_in(PING_SERVER_ALARM_ID, PING_SERVER_TIMEOUT + Random::fast(0, PING_SERVER_TIMEOUT / 5));
 
-  if (G()->get_option_integer("session_count") > 1) {
+  if (G()->get_option_integer(OptionId::SessionCount) > 1) {
     is_bot_online = false;
   }
 
@@ -2656,7 +2668,7 @@ void Td::set_is_bot_online(bool is_bot_online) {
 }
 
 bool Td::ignore_background_updates() const {
-  return can_ignore_background_updates_ && option_manager_->get_option_boolean("ignore_background_updates");
+  return can_ignore_background_updates_ && option_manager_->get_option_boolean(OptionId::IgnoreBackgroundUpdates);
 }
 
 bool Td::is_authentication_request(int32 id) {
@@ -2716,6 +2728,9 @@ bool Td::is_synchronous_request(const td_api::Function *function) {
     case td_api::setLogTagVerbosityLevel::ID:
     case td_api::getLogTagVerbosityLevel::ID:
     case td_api::addLogMessage::ID:
+    case td_api::setActorStatisticsCollection::ID:
+    case td_api::getActorStatistics::ID:
+    case td_api::getMemoryStatistics::ID:
     case td_api::testReturnError::ID:
       return true;
     case td_api::getOption::ID:
@@ -2761,6 +2776,7 @@ bool Td::is_preauthentication_request(int32 id) {
     case td_api::processPushNotification::ID:
     case td_api::getOption::ID:
     case td_api::setOption::ID:
+    case td_api::setIgnoredUpdateTypes::ID:
     case td_api::getStorageStatistics::ID:
     case td_api::getStorageStatisticsFast::ID:
     case td_api::getDatabaseStatistics::ID:
@@ -2768,6 +2784,9 @@ bool Td::is_preauthentication_request(int32 id) {
     case td_api::getNetworkStatistics::ID:
     case td_api::addNetworkStatistics::ID:
     case td_api::resetNetworkStatistics::ID:
+    case td_api::getNetworkRequestLatencyStatistics::ID:
+    case td_api::getNetworkRequestRateLimits::ID:
+    case td_api::getMetrics::ID:
     case td_api::getCountries::ID:
     case td_api::getCountryCode::ID:
     case td_api::getPhoneNumberInfo::ID:
@@ -2834,6 +2853,7 @@ void Td::request(uint64 id, tl_object_ptr<td_api::Function> function) {
   }
 
   if (function == nullptr) {
+    flush_coalesced_updates();
     return callback_->on_error(id, make_error(400, "Request is empty"));
   }
 
@@ -2844,7 +2864,54 @@ void Td::request(uint64 id, tl_object_ptr<td_api::Function> function) {
     return send_result(id, static_request(std::move(function)));
   }
 
+  // network queries created synchronously during request handling are attributed to the request trace
+  NetQueryCreator::set_current_trace_id(start_request_trace(id));
   run_request(id, std::move(function));
+  NetQueryCreator::set_current_trace_id(0);
+}
+
+uint64 Td::start_request_trace(uint64 id) {
+  if (option_manager_ == nullptr) {
+    // requests aren't traced before initialization and after closing
+    return 0;
+  }
+  auto sample_rate = option_manager_->get_option_integer(OptionId::RequestTraceSampleRate);
+  auto slow_request_threshold = option_manager_->get_option_integer(OptionId::SlowRequestThresholdMs);
+  bool is_sampled = sample_rate > 0 && ++request_trace_counter_ % static_cast<uint64>(sample_rate) == 0;
+  if (!is_sampled && slow_request_threshold <= 0) {
+    return 0;
+  }
+
+  auto &trace = request_traces_[id];
+  trace.trace_id_ = is_sampled ? ++last_request_trace_id_ : 0;
+  trace.start_time_ = Time::now();
+  trace.slow_request_threshold_ = slow_request_threshold;
+  return trace.trace_id_;
+}
+
+void Td::finish_request_trace(uint64 id, int32 function_id, bool is_error) {
+  if (request_traces_.empty()) {
+    return;
+  }
+  auto it = request_traces_.find(id);
+  if (it == request_traces_.end()) {
+    return;
+  }
+
+  const auto &trace = it->second;
+  auto duration = Time::now() - trace.start_time_;
+  if (trace.trace_id_ != 0) {
+    LOG(WARNING) << "Trace " << trace.trace_id_ << ": finish request " << id << " of type "
+                 << format::as_hex(function_id) << (is_error ? " with an error" : "") << " in " << duration
+                 << " seconds";
+  }
+  if (trace.slow_request_threshold_ > 0 && duration * 1000 >= static_cast<double>(trace.slow_request_threshold_)) {
+    // the request itself isn't serialized, because it would cost too much for every request;
+    // its content can be found in the log with td_requests verbosity by its identifier
+    LOG(WARNING) << "Slow request " << id << " of type " << format::as_hex(function_id)
+                 << (is_error ? " failed" : " succeeded") << " in " << duration << " seconds";
+  }
+  request_traces_.erase(it);
 }
 
 void Td::run_request(uint64 id, tl_object_ptr<td_api::Function> function) {
@@ -3142,6 +3209,7 @@ void Td::dec_actor_refcnt() {
       reset_manager(group_call_manager_, "GroupCallManager");
       reset_manager(inline_queries_manager_, "InlineQueriesManager");
       reset_manager(link_manager_, "LinkManager");
+      reset_manager(message_broadcast_manager_, "MessageBroadcastManager");
       reset_manager(message_import_manager_, "MessageImportManager");
       reset_manager(messages_manager_, "MessagesManager");
       reset_manager(notification_manager_, "NotificationManager");
@@ -3230,6 +3298,7 @@ void Td::clear_requests() {
       send_error_impl(id, make_error(500, "Request aborted"));
     }
   }
+  reset_to_empty(request_traces_);
 }
 
 void Td::clear() {
@@ -3316,6 +3385,7 @@ void Td::clear() {
   reset_actor(ActorOwn<Actor>(std::move(group_call_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(inline_queries_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(link_manager_actor_)));
+  reset_actor(ActorOwn<Actor>(std::move(message_broadcast_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(message_import_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(messages_manager_actor_)));
   reset_actor(ActorOwn<Actor>(std::move(notification_manager_actor_)));
@@ -3481,7 +3551,7 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
     }
   });
 
-  if (!option_manager_->get_option_boolean("disable_network_statistics")) {
+  if (!option_manager_->get_option_boolean(OptionId::DisableNetworkStatistics)) {
     net_stats_manager_ = create_actor<NetStatsManager>("NetStatsManager", create_reference());
 
     // How else could I let two actor know about each other, without quite complex async logic?
@@ -3513,7 +3583,7 @@ void Td::init(Parameters parameters, Result<TdDb::OpenedDatabase> r_opened_datab
   options_.language_pack = option_manager_->get_option_string("localization_target");
   options_.language_code = option_manager_->get_option_string("language_pack_id");
   options_.parameters = option_manager_->get_option_string("connection_parameters");
-  options_.tz_offset = static_cast<int32>(option_manager_->get_option_integer("utc_time_offset"));
+  options_.tz_offset = static_cast<int32>(option_manager_->get_option_integer(OptionId::UtcTimeOffset));
   options_.is_emulator = option_manager_->get_option_boolean("is_emulator");
   // options_.proxy = Proxy();
   G()->set_mtproto_header(make_unique<MtprotoHeader>(options_));
@@ -3636,6 +3706,9 @@ void Td::process_binlog_events(TdDb::OpenedDatabase &&events) {
 
   send_closure_later(story_manager_actor_, &StoryManager::on_binlog_events, std::move(events.to_story_manager));
 
+  send_closure_later(message_broadcast_manager_actor_, &MessageBroadcastManager::on_binlog_events,
+                     std::move(events.to_message_broadcast_manager));
+
   send_closure_later(notification_manager_actor_, &NotificationManager::on_binlog_events,
                      std::move(events.to_notification_manager));
 
@@ -3708,11 +3781,15 @@ void Td::init_file_manager() {
       return !td_->auth_manager_->is_bot();
     }
 
-    void on_new_file(int64 size, int64 real_size, int32 cnt) final {
-      send_closure(G()->storage_manager(), &StorageManager::on_new_file, size, real_size, cnt);
+    void on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int64 real_size, int32 cnt) final {
+      send_closure(G()->storage_manager(), &StorageManager::on_new_file, file_type, owner_dialog_id, size, real_size,
+                   cnt);
     }
 
     void on_file_updated(FileId file_id) final {
+      if (td_->is_update_ignored(td_api::updateFile::ID)) {
+        return;
+      }
       send_closure(G()->td(), &Td::send_update,
                    make_tl_object<td_api::updateFile>(td_->file_manager_->get_file_object(file_id)));
     }
@@ -3841,6 +3918,8 @@ void Td::init_managers() {
   link_manager_ = make_unique<LinkManager>(this, create_reference());
   link_manager_actor_ = register_actor("LinkManager", link_manager_.get());
   G()->set_link_manager(link_manager_actor_.get());
+  message_broadcast_manager_ = make_unique<MessageBroadcastManager>(this, create_reference());
+  message_broadcast_manager_actor_ = register_actor("MessageBroadcastManager", message_broadcast_manager_.get());
   message_import_manager_ = make_unique<MessageImportManager>(this, create_reference());
   message_import_manager_actor_ = register_actor("MessageImportManager", message_import_manager_.get());
   G()->set_message_import_manager(message_import_manager_actor_.get());
@@ -3931,6 +4010,9 @@ void Td::send_update(tl_object_ptr<td_api::Update> &&object) {
     // just in case
     return;
   }
+  if (is_update_ignored(object_id)) {
+    return;
+  }
 
   switch (object_id) {
     case td_api::updateAccentColors::ID:
@@ -3965,9 +4047,89 @@ void Td::send_update(tl_object_ptr<td_api::Update> &&object) {
       VLOG(td_requests) << "Sending update: " << to_string(object);
   }
 
+  CoalescedUpdateKey key;
+  if (coalesce_state_updates_ && get_coalesced_update_key(object.get(), key)) {
+    auto it = coalesced_update_positions_.find(key);
+    if (it != coalesced_update_positions_.end()) {
+      // the previous update is superseded; the new one is sent after all updates received before it
+      coalesced_updates_[it->second] = nullptr;
+      it->second = coalesced_updates_.size();
+    } else {
+      coalesced_update_positions_.emplace(key, coalesced_updates_.size());
+    }
+    if (coalesced_updates_.empty()) {
+      alarm_timeout_.set_timeout_in(FLUSH_COALESCED_UPDATES_ALARM_ID, COALESCED_UPDATES_DELAY);
+    }
+    coalesced_updates_.push_back(std::move(object));
+    return;
+  }
+
+  // other updates and results can depend on the previous state updates, so they must be sent first
+  flush_coalesced_updates();
   callback_->on_result(0, std::move(object));
 }
 
+void Td::set_coalesce_state_updates(bool coalesce_state_updates) {
+  coalesce_state_updates_ = coalesce_state_updates;
+  if (!coalesce_state_updates) {
+    flush_coalesced_updates();
+  }
+}
+
+bool Td::get_coalesced_update_key(const td_api::Update *update, CoalescedUpdateKey &key) {
+  auto update_id = update->get_id();
+  switch (update_id) {
+    case td_api::updateChatLastMessage::ID:
+      key = CoalescedUpdateKey(update_id, static_cast<const td_api::updateChatLastMessage *>(update)->chat_id_, 0, 0);
+      return true;
+    case td_api::updateChatPosition::ID: {
+      auto chat_update = static_cast<const td_api::updateChatPosition *>(update);
+      const auto *chat_list = chat_update->position_->list_.get();
+      auto chat_list_id = chat_list->get_id();
+      auto chat_folder_id = chat_list_id == td_api::chatListFolder::ID
+                                ? static_cast<const td_api::chatListFolder *>(chat_list)->chat_folder_id_
+                                : 0;
+      key = CoalescedUpdateKey(update_id, chat_update->chat_id_, chat_list_id, chat_folder_id);
+      return true;
+    }
+    case td_api::updateChatReadInbox::ID:
+      key = CoalescedUpdateKey(update_id, static_cast<const td_api::updateChatReadInbox *>(update)->chat_id_, 0, 0);
+      return true;
+    case td_api::updateChatReadOutbox::ID:
+      key = CoalescedUpdateKey(update_id, static_cast<const td_api::updateChatReadOutbox *>(update)->chat_id_, 0, 0);
+      return true;
+    case td_api::updateChatUnreadMentionCount::ID:
+      key = CoalescedUpdateKey(update_id,
+                               static_cast<const td_api::updateChatUnreadMentionCount *>(update)->chat_id_, 0, 0);
+      return true;
+    case td_api::updateChatUnreadReactionCount::ID:
+      key = CoalescedUpdateKey(update_id,
+                               static_cast<const td_api::updateChatUnreadReactionCount *>(update)->chat_id_, 0, 0);
+      return true;
+    case td_api::updateUserStatus::ID:
+      key = CoalescedUpdateKey(update_id, static_cast<const td_api::updateUserStatus *>(update)->user_id_, 0, 0);
+      return true;
+    default:
+      return false;
+  }
+}
+
+void Td::flush_coalesced_updates() {
+  if (coalesced_updates_.empty()) {
+    return;
+  }
+
+  alarm_timeout_.cancel_timeout(FLUSH_COALESCED_UPDATES_ALARM_ID);
+  auto updates = std::move(coalesced_updates_);
+  coalesced_updates_.clear();
+  coalesced_update_positions_.clear();
+  for (auto &update : updates) {
+    if (update != nullptr) {
+      callback_->on_result(0, std::move(update));
+    }
+  }
+}
+
 void Td::send_result(uint64 id, tl_object_ptr<td_api::Object> object) {
   if (id == 0) {
     LOG(ERROR) << "Sending " << to_string(object) << " through send_result";
@@ -3980,7 +4142,9 @@ void Td::send_result(uint64 id, tl_object_ptr<td_api::Object> object) {
       object = make_tl_object<td_api::error>(404, "Not Found");
     }
     VLOG(td_requests) << "Sending result for request " << id << ": " << to_string(object);
+    finish_request_trace(id, it->second, false);
     request_set_.erase(it);
+    flush_coalesced_updates();
     callback_->on_result(id, std::move(object));
   }
 }
@@ -3994,7 +4158,9 @@ void Td::send_error_impl(uint64 id, tl_object_ptr<td_api::error> error) {
       LOG(FATAL) << "Lost promise for query " << id << " of type " << it->second << " in close state " << close_flag_;
     }
     VLOG(td_requests) << "Sending error for request " << id << ": " << oneline(to_string(error));
+    finish_request_trace(id, it->second, true);
     request_set_.erase(it);
+    flush_coalesced_updates();
     callback_->on_error(id, std::move(error));
   }
 }
@@ -4282,6 +4448,8 @@ void Td::on_request(uint64 id, const td_api::getCurrentState &request) {
 
     business_connection_manager_->get_current_state(updates);
 
+    message_broadcast_manager_->get_current_state(updates);
+
     // TODO updateFileGenerationStart generation_id:int64 original_path:string destination_path:string conversion:string = Update;
     // TODO updateCall call:call = Update;
     // TODO updateGroupCall call:groupCall = Update;
@@ -4812,8 +4980,9 @@ void Td::on_request(uint64 id, td_api::getStorageStatistics &request) {
       promise.set_value(result.ok().get_storage_statistics_object());
     }
   });
+  // bots aren't notified about new files, so the index of file statistics isn't updated for them
   send_closure(storage_manager_, &StorageManager::get_storage_stats, false /*need_all_files*/, request.chat_limit_,
-               std::move(query_promise));
+               !auth_manager_->is_bot() /*can_use_index*/, std::move(query_promise));
 }
 
 void Td::on_request(uint64 id, td_api::getStorageStatisticsFast &request) {
@@ -4840,6 +5009,15 @@ void Td::on_request(uint64 id, td_api::getDatabaseStatistics &request) {
   send_closure(storage_manager_, &StorageManager::get_database_stats, std::move(query_promise));
 }
 
+void Td::on_request(uint64 id, const td_api::getMessageCacheStatistics &request) {
+  send_closure(actor_id(this), &Td::send_result, id, messages_manager_->get_message_cache_statistics_object());
+}
+
+void Td::on_request(uint64 id, const td_api::reduceMemoryUsage &request) {
+  messages_manager_->reduce_memory_usage();
+  send_closure(actor_id(this), &Td::send_result, id, messages_manager_->get_message_cache_statistics_object());
+}
+
 void Td::on_request(uint64 id, td_api::optimizeStorage &request) {
   std::vector<FileType> file_types;
   for (auto &file_type : request.file_types_) {
@@ -4869,7 +5047,7 @@ void Td::on_request(uint64 id, td_api::getNetworkStatistics &request) {
   if (net_stats_manager_.empty()) {
     return send_error_raw(id, 400, "Network statistics are disabled");
   }
-  if (!request.only_current_ && G()->get_option_boolean("disable_persistent_network_statistics")) {
+  if (!request.only_current_ && G()->get_option_boolean(OptionId::DisablePersistentNetworkStatistics)) {
     return send_error_raw(id, 400, "Persistent network statistics are disabled");
   }
   CREATE_REQUEST_PROMISE();
@@ -4893,6 +5071,74 @@ void Td::on_request(uint64 id, td_api::resetNetworkStatistics &request) {
   promise.set_value(Unit());
 }
 
+void Td::on_request(uint64 id, const td_api::getNetworkRequestLatencyStatistics &request) {
+  if (td_options_.net_query_stats == nullptr) {
+    return send_error_raw(id, 400, "Network request statistics are disabled");
+  }
+  auto entries = transform(td_options_.net_query_stats->get_latency_statistics(request.reset_),
+                           [](const NetQueryStats::LatencyStatistics &statistics) {
+                             vector<td_api::object_ptr<td_api::networkRequestStageLatency>> stages;
+                             for (size_t stage = 0; stage < statistics.histograms.size(); stage++) {
+                               const auto &histogram = statistics.histograms[stage];
+                               stages.push_back(td_api::make_object<td_api::networkRequestStageLatency>(
+                                   NetQueryStats::get_stage_name(stage), histogram.get_percentile(0.5),
+                                   histogram.get_percentile(0.99)));
+                             }
+                             return td_api::make_object<td_api::networkRequestLatencyStatisticsEntry>(
+                                 statistics.tl_constructor,
+                                 static_cast<int64>(statistics.histograms.back().total_count), std::move(stages));
+                           });
+  send_closure(actor_id(this), &Td::send_result, id,
+               td_api::make_object<td_api::networkRequestLatencyStatistics>(std::move(entries)));
+}
+
+void Td::on_request(uint64 id, const td_api::getNetworkRequestRateLimits &request) {
+  CREATE_REQUEST_PROMISE();
+  auto query_promise = PromiseCreator::lambda(
+      [promise = std::move(promise)](Result<vector<NetQueryDelayer::RateLimitStatistics>> r_statistics) mutable {
+        if (r_statistics.is_error()) {
+          return promise.set_error(r_statistics.move_as_error());
+        }
+        promise.set_value(td_api::make_object<td_api::networkRequestRateLimits>(
+            transform(r_statistics.ok(), [](const NetQueryDelayer::RateLimitStatistics &statistics) {
+              return td_api::make_object<td_api::networkRequestRateLimit>(
+                  statistics.tl_constructor, statistics.key_count, statistics.average_rate,
+                  statistics.pending_query_count);
+            })));
+      });
+  G()->net_query_dispatcher().get_rate_limit_statistics(std::move(query_promise));
+}
+
+void Td::on_request(uint64 id, const td_api::getMetrics &request) {
+  auto metrics = MetricsRegistry::get_metrics();
+  metrics.push_back(
+      MetricsRegistry::get_gauge("td_buffer_memory_bytes", static_cast<double>(BufferAllocator::get_buffer_mem())));
+  if (td_options_.net_query_stats != nullptr) {
+    metrics.push_back(MetricsRegistry::get_gauge("td_pending_net_queries",
+                                                 static_cast<double>(td_options_.net_query_stats->get_count())));
+    metrics.push_back(MetricsRegistry::get_gauge(
+        "td_sessions", static_cast<double>(td_options_.net_query_stats->get_session_count())));
+  }
+  // the ratio of the values is the hit rate of the TLS session cache
+  auto tls_session_cache_stats = SslCtx::get_session_cache_stats();
+  metrics.push_back(
+      MetricsRegistry::get_gauge("td_tls_handshakes", static_cast<double>(tls_session_cache_stats.handshake_count)));
+  metrics.push_back(MetricsRegistry::get_gauge("td_tls_resumed_handshakes",
+                                               static_cast<double>(tls_session_cache_stats.resumed_handshake_count)));
+  auto text = MetricsRegistry::get_prometheus_text(metrics);
+  send_closure(actor_id(this), &Td::send_result, id,
+               td_api::make_object<td_api::metrics>(
+                   transform(metrics,
+                             [](const MetricsRegistry::Metric &metric) {
+                               return td_api::make_object<td_api::metric>(
+                                   metric.name, metric.type.str(),
+                                   transform(metric.samples, [](const std::pair<string, double> &sample) {
+                                     return td_api::make_object<td_api::metricSample>(sample.first, sample.second);
+                                   }));
+                             }),
+                   std::move(text)));
+}
+
 void Td::on_request(uint64 id, td_api::addNetworkStatistics &request) {
   if (request.entry_ == nullptr) {
     return send_error_raw(id, 400, "Network statistics entry must be non-empty");
@@ -5624,6 +5870,18 @@ void Td::on_request(uint64 id, td_api::sendMessageAlbum &request) {
   }
 }
 
+void Td::on_request(uint64 id, td_api::sendMessageBroadcast &request) {
+  CREATE_REQUEST_PROMISE();
+  message_broadcast_manager_->send_message_broadcast(
+      DialogId::get_dialog_ids(request.chat_ids_), request.disable_notification_, request.protect_content_,
+      std::move(request.input_message_content_), std::move(promise));
+}
+
+void Td::on_request(uint64 id, const td_api::cancelMessageBroadcast &request) {
+  CREATE_OK_REQUEST_PROMISE();
+  message_broadcast_manager_->cancel_message_broadcast(request.broadcast_id_, std::move(promise));
+}
+
 void Td::on_request(uint64 id, td_api::sendBotStartMessage &request) {
   CHECK_IS_USER();
   CLEAN_INPUT_STRING(request.parameter_);
@@ -8779,6 +9037,43 @@ void Td::on_request(uint64 id, td_api::setOption &request) {
   option_manager_->set_option(request.name_, std::move(request.value_), std::move(promise));
 }
 
+void Td::on_request(uint64 id, const td_api::setIgnoredUpdateTypes &request) {
+  CREATE_OK_REQUEST_PROMISE();
+  FlatHashSet<int32> ignored_update_ids;
+  for (auto &update_type : request.update_types_) {
+    int32 update_id = [&update_type] {
+      if (update_type == "updateAnimatedEmojiMessageClicked") {
+        return td_api::updateAnimatedEmojiMessageClicked::ID;
+      }
+      if (update_type == "updateChatAction") {
+        return td_api::updateChatAction::ID;
+      }
+      if (update_type == "updateChatOnlineMemberCount") {
+        return td_api::updateChatOnlineMemberCount::ID;
+      }
+      if (update_type == "updateFile") {
+        return td_api::updateFile::ID;
+      }
+      if (update_type == "updateFileDownload") {
+        return td_api::updateFileDownload::ID;
+      }
+      if (update_type == "updateFileDownloads") {
+        return td_api::updateFileDownloads::ID;
+      }
+      if (update_type == "updateUserStatus") {
+        return td_api::updateUserStatus::ID;
+      }
+      return 0;
+    }();
+    if (update_id == 0) {
+      return promise.set_error(Status::Error(400, "Unsupported update type specified"));
+    }
+    ignored_update_ids.insert(update_id);
+  }
+  ignored_update_ids_ = std::move(ignored_update_ids);
+  promise.set_value(Unit());
+}
+
 void Td::on_request(uint64 id, td_api::setPollAnswer &request) {
   CHECK_IS_USER();
   CREATE_OK_REQUEST_PROMISE();
@@ -9654,6 +9949,18 @@ void Td::on_request(uint64 id, const td_api::addLogMessage &request) {
   UNREACHABLE();
 }
 
+void Td::on_request(uint64 id, const td_api::setActorStatisticsCollection &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getActorStatistics &request) {
+  UNREACHABLE();
+}
+
+void Td::on_request(uint64 id, const td_api::getMemoryStatistics &request) {
+  UNREACHABLE();
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(td_api::searchQuote &request) {
   if (request.text_ == nullptr || request.quote_ == nullptr) {
     return make_error(400, "Text and quote must be non-empty");
@@ -9928,6 +10235,37 @@ td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::addLogMes
   return td_api::make_object<td_api::ok>();
 }
 
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::setActorStatisticsCollection &request) {
+  if (request.log_period_ < 0) {
+    return make_error(400, "Invalid log period specified");
+  }
+  ActorStatistics::set_enabled(request.is_enabled_, request.log_period_);
+  return td_api::make_object<td_api::ok>();
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getActorStatistics &request) {
+  auto entries = transform(ActorStatistics::get_statistics(request.reset_), [](const ActorStatistics::Entry &entry) {
+    return td_api::make_object<td_api::actorStatisticsEntry>(entry.name, static_cast<int64>(entry.event_count),
+                                                             entry.run_time, entry.queue_time,
+                                                             static_cast<int64>(entry.max_mailbox_size));
+  });
+  return td_api::make_object<td_api::actorStatistics>(std::move(entries));
+}
+
+td_api::object_ptr<td_api::Object> Td::do_static_request(const td_api::getMemoryStatistics &request) {
+  if (!MemoryAttribution::is_enabled()) {
+    return make_error(400, "Memory profiling is disabled");
+  }
+  int64 total_size = 0;
+  auto statistics = MemoryAttribution::get_statistics();
+  auto subsystems = transform(statistics, [&total_size](const MemoryAttribution::Entry &entry) {
+    total_size += static_cast<int64>(entry.size);
+    return td_api::make_object<td_api::memorySubsystemStatistics>(entry.tag, static_cast<int64>(entry.size),
+                                                                  static_cast<int64>(entry.allocation_count));
+  });
+  return td_api::make_object<td_api::memoryStatistics>(total_size, std::move(subsystems));
+}
+
 td_api::object_ptr<td_api::Object> Td::do_static_request(td_api::testReturnError &request) {
   if (request.error_ == nullptr) {
     return td_api::make_object<td_api::error>(404, "Not Found");
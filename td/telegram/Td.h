@@ -26,12 +26,15 @@
 #include "td/utils/common.h"
 #include "td/utils/Container.h"
 #include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <map>
 #include <memory>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 
@@ -72,6 +75,7 @@ class InlineQueriesManager;
 class HashtagHints;
 class LanguagePackManager;
 class LinkManager;
+class MessageBroadcastManager;
 class MessageImportManager;
 class MessagesManager;
 class NetStatsManager;
@@ -220,6 +224,8 @@ class Td final : public Actor {
   ActorOwn<InlineQueriesManager> inline_queries_manager_actor_;
   unique_ptr<LinkManager> link_manager_;
   ActorOwn<LinkManager> link_manager_actor_;
+  unique_ptr<MessageBroadcastManager> message_broadcast_manager_;
+  ActorOwn<MessageBroadcastManager> message_broadcast_manager_actor_;
   unique_ptr<MessageImportManager> message_import_manager_;
   ActorOwn<MessageImportManager> message_import_manager_actor_;
   unique_ptr<MessagesManager> messages_manager_;
@@ -324,19 +330,34 @@ class Td final : public Actor {
 
   void send_update(tl_object_ptr<td_api::Update> &&object);
 
+  // frequent updates must not be created if the application has chosen to ignore them
+  bool is_update_ignored(int32 update_id) const {
+    return !ignored_update_ids_.empty() && ignored_update_ids_.count(update_id) != 0;
+  }
+
+  void set_coalesce_state_updates(bool coalesce_state_updates);
+
   static td_api::object_ptr<td_api::Object> static_request(td_api::object_ptr<td_api::Function> function);
 
+  static bool is_synchronous_request(const td_api::Function *function);
+
  private:
   static constexpr int64 ONLINE_ALARM_ID = 0;
   static constexpr int64 PING_SERVER_ALARM_ID = -1;
   static constexpr int32 PING_SERVER_TIMEOUT = 300;
   static constexpr int64 TERMS_OF_SERVICE_ALARM_ID = -2;
   static constexpr int64 PROMO_DATA_ALARM_ID = -3;
+  static constexpr int64 FLUSH_COALESCED_UPDATES_ALARM_ID = -4;
+  static constexpr double COALESCED_UPDATES_DELAY = 0.05;
 
   void on_connection_state_changed(ConnectionState new_state);
 
   void run_request(uint64 id, tl_object_ptr<td_api::Function> function);
 
+  uint64 start_request_trace(uint64 id);
+
+  void finish_request_trace(uint64 id, int32 function_id, bool is_error);
+
   void send_result(uint64 id, tl_object_ptr<td_api::Object> object);
   void send_error(uint64 id, Status error);
   void send_error_impl(uint64 id, tl_object_ptr<td_api::error> error);
@@ -364,6 +385,19 @@ class Td final : public Actor {
   ConnectionState connection_state_ = ConnectionState::Empty;
 
   std::unordered_multimap<uint64, int32> request_set_;
+
+  // sampled requests and, if the slow request log is enabled, all requests, which time is traced
+  struct RequestTrace {
+    uint64 trace_id_ = 0;
+    double start_time_ = 0.0;
+    int64 slow_request_threshold_ = 0;
+  };
+  FlatHashMap<uint64, RequestTrace> request_traces_;
+  uint64 request_trace_counter_ = 0;
+  uint64 last_request_trace_id_ = 0;
+
+  FlatHashSet<int32> ignored_update_ids_;
+
   int actor_refcnt_ = 0;
   int request_actor_refcnt_ = 0;
   int stop_cnt_ = 2;
@@ -390,6 +424,12 @@ class Td final : public Actor {
   FlatHashMap<int64, uint64> pending_alarms_;
   MultiTimeout alarm_timeout_{"AlarmTimeout"};
 
+  // update type, object identifier and chat list of updates, which can be replaced with a newer update
+  using CoalescedUpdateKey = std::tuple<int32, int64, int32, int32>;
+  bool coalesce_state_updates_ = false;
+  vector<td_api::object_ptr<td_api::Update>> coalesced_updates_;  // superseded updates are replaced with nullptr
+  std::map<CoalescedUpdateKey, size_t> coalesced_update_positions_;
+
   TermsOfService pending_terms_of_service_;
 
   struct DownloadInfo {
@@ -414,6 +454,10 @@ class Td final : public Actor {
   static void on_alarm_timeout_callback(void *td_ptr, int64 alarm_id);
   void on_alarm_timeout(int64 alarm_id);
 
+  static bool get_coalesced_update_key(const td_api::Update *update, CoalescedUpdateKey &key);
+
+  void flush_coalesced_updates();
+
   td_api::object_ptr<td_api::updateTermsOfService> get_update_terms_of_service_object() const;
 
   void on_get_terms_of_service(Result<std::pair<int32, TermsOfService>> result, bool dummy);
@@ -462,8 +506,6 @@ class Td final : public Actor {
 
   static bool is_authentication_request(int32 id);
 
-  static bool is_synchronous_request(const td_api::Function *function);
-
   static bool is_preinitialization_request(int32 id);
 
   static bool is_preauthentication_request(int32 id);
@@ -669,12 +711,22 @@ class Td final : public Actor {
 
   void on_request(uint64 id, td_api::getDatabaseStatistics &request);
 
+  void on_request(uint64 id, const td_api::getMessageCacheStatistics &request);
+
+  void on_request(uint64 id, const td_api::reduceMemoryUsage &request);
+
   void on_request(uint64 id, td_api::optimizeStorage &request);
 
   void on_request(uint64 id, td_api::getNetworkStatistics &request);
 
   void on_request(uint64 id, td_api::resetNetworkStatistics &request);
 
+  void on_request(uint64 id, const td_api::getNetworkRequestLatencyStatistics &request);
+
+  void on_request(uint64 id, const td_api::getNetworkRequestRateLimits &request);
+
+  void on_request(uint64 id, const td_api::getMetrics &request);
+
   void on_request(uint64 id, td_api::addNetworkStatistics &request);
 
   void on_request(uint64 id, const td_api::setNetworkType &request);
@@ -861,6 +913,10 @@ class Td final : public Actor {
 
   void on_request(uint64 id, td_api::sendMessageAlbum &request);
 
+  void on_request(uint64 id, td_api::sendMessageBroadcast &request);
+
+  void on_request(uint64 id, const td_api::cancelMessageBroadcast &request);
+
   void on_request(uint64 id, td_api::sendBotStartMessage &request);
 
   void on_request(uint64 id, td_api::sendInlineQueryResultMessage &request);
@@ -1687,6 +1743,8 @@ class Td final : public Actor {
 
   void on_request(uint64 id, td_api::setOption &request);
 
+  void on_request(uint64 id, const td_api::setIgnoredUpdateTypes &request);
+
   void on_request(uint64 id, td_api::setPollAnswer &request);
 
   void on_request(uint64 id, td_api::getPollVoters &request);
@@ -1927,6 +1985,12 @@ class Td final : public Actor {
 
   void on_request(uint64 id, const td_api::addLogMessage &request);
 
+  void on_request(uint64 id, const td_api::setActorStatisticsCollection &request);
+
+  void on_request(uint64 id, const td_api::getActorStatistics &request);
+
+  void on_request(uint64 id, const td_api::getMemoryStatistics &request);
+
   // test
   void on_request(uint64 id, const td_api::testNetwork &request);
   void on_request(uint64 id, td_api::testProxy &request);
@@ -1973,6 +2037,9 @@ class Td final : public Actor {
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setLogTagVerbosityLevel &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getLogTagVerbosityLevel &request);
   static td_api::object_ptr<td_api::Object> do_static_request(const td_api::addLogMessage &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::setActorStatisticsCollection &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getActorStatistics &request);
+  static td_api::object_ptr<td_api::Object> do_static_request(const td_api::getMemoryStatistics &request);
   static td_api::object_ptr<td_api::Object> do_static_request(td_api::testReturnError &request);
 
   static DbKey as_db_key(string key);
@@ -19,6 +19,7 @@
 
 #include "td/db/binlog/Binlog.h"
 #include "td/db/binlog/ConcurrentBinlog.h"
+#include "td/db/binlog/ShardedBinlog.h"
 #include "td/db/BinlogKeyValue.h"
 #include "td/db/SqliteConnectionSafe.h"
 #include "td/db/SqliteDb.h"
@@ -29,6 +30,7 @@
 #include "td/actor/actor.h"
 #include "td/actor/MultiPromise.h"
 
+#include "td/utils/algorithm.h"
 #include "td/utils/common.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
@@ -36,11 +38,15 @@
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
+#include "td/utils/tl_helpers.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace td {
 
@@ -50,13 +56,77 @@ std::string get_binlog_path(const TdDb::Parameters &parameters) {
   return PSTRING() << parameters.database_directory_ << "td" << (parameters.is_test_dc_ ? "_test" : "") << ".binlog";
 }
 
+// events of these subsystems are stored in separate binlogs, so they don't contend with each other for writes and
+// are compacted independently; indexes of shards must never change, because they are encoded in event identifiers
+struct BinlogShard {
+  const char *name;
+  int32 min_type;
+  int32 max_type;
+  double sync_period;  // period of forced syncs, or 0 if syncs are grouped as in the main binlog
+};
+
+constexpr BinlogShard BINLOG_SHARDS[] = {
+    {"messages", LogEvent::HandlerType::SendMessage, 0x1ff, 0.0},
+    {"notifications", LogEvent::HandlerType::AddMessagePushNotification, 0x2ff, 0.05},
+    {"stories", LogEvent::HandlerType::DeleteStoryOnServer, 0x4ff, 0.0}};
+
+// is stored in the main binlog; versions without the shard binlogs fail to open the database because of
+// the unsupported log event type instead of silently losing the events from the shard binlogs
+class BinlogShardsLogEvent {
+ public:
+  int32 shard_count_ = 0;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(shard_count_, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    td::parse(shard_count_, parser);
+  }
+};
+
+struct BinlogShardsInfo {
+  uint64 event_id = 0;
+  int32 shard_count = 0;
+};
+
+std::string get_binlog_shard_path(const TdDb::Parameters &parameters, const BinlogShard &shard) {
+  return PSTRING() << parameters.database_directory_ << "td" << (parameters.is_test_dc_ ? "_test" : "") << '.'
+                   << shard.name << ".binlog";
+}
+
 std::string get_sqlite_path(const TdDb::Parameters &parameters) {
   const string db_name = "db" + (parameters.is_test_dc_ ? string("_test") : string());
   return parameters.database_directory_ + db_name + ".sqlite";
 }
 
-Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_pmc, BinlogKeyValue<Binlog> &config_pmc,
-                   TdDb::OpenedDatabase &events, DbKey key) {
+// the profile is read directly from the stored options, because the database is opened before OptionManager is created
+SqliteDb::PerformanceProfile get_sqlite_performance_profile(BinlogKeyValue<Binlog> &config_pmc,
+                                                           bool use_background_checkpointer) {
+  auto get_integer_option = [&config_pmc](const string &name, int64 default_value) {
+    auto value = config_pmc.get(name);
+    if (value.empty() || value[0] != 'I') {
+      return default_value;
+    }
+    return to_integer<int64>(Slice(value).substr(1));
+  };
+
+  SqliteDb::PerformanceProfile profile;
+  profile.mmap_size = get_integer_option("sqlite_mmap_size", -1);
+  profile.cache_size = get_integer_option("sqlite_cache_size", 0);
+  if (use_background_checkpointer) {
+    profile.wal_autocheckpoint = 0;
+  } else {
+    // a non-positive value, which could have been stored before, is replaced with the SQLite default
+    auto wal_autocheckpoint = get_integer_option("sqlite_wal_autocheckpoint", -1);
+    profile.wal_autocheckpoint = wal_autocheckpoint >= 1 ? narrow_cast<int32>(wal_autocheckpoint) : -1;
+  }
+  return profile;
+}
+
+void init_since_last_open(CSlice path, TdDb::OpenedDatabase &events) {
   auto r_binlog_stat = stat(path);
   if (r_binlog_stat.is_ok()) {
     auto since_last_open = Clocks::system() - static_cast<double>(r_binlog_stat.ok().mtime_nsec_) * 1e-9;
@@ -67,7 +137,10 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
       events.since_last_open = static_cast<int64>(since_last_open);
     }
   }
+}
 
+Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_pmc, BinlogKeyValue<Binlog> &config_pmc,
+                   TdDb::OpenedDatabase &events, BinlogShardsInfo &shards_info, DbKey key) {
   auto callback = [&](const BinlogEvent &event) {
     switch (event.type_) {
       case LogEvent::HandlerType::SecretChats:
@@ -129,6 +202,10 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
       case LogEvent::HandlerType::SendQuickReplyShortcutMessages:
         events.to_messages_manager.push_back(event.clone());
         break;
+      case LogEvent::HandlerType::SendMessageBroadcast:
+      case LogEvent::HandlerType::UpdateMessageBroadcastProgress:
+        events.to_message_broadcast_manager.push_back(event.clone());
+        break;
       case LogEvent::HandlerType::DeleteStoryOnServer:
       case LogEvent::HandlerType::ReadStoriesOnServer:
       case LogEvent::HandlerType::LoadDialogExpiringStories:
@@ -158,6 +235,17 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
       case LogEvent::HandlerType::SetDefaultHistoryTtlOnServer:
         events.to_account_manager.push_back(event.clone());
         break;
+      case LogEvent::HandlerType::BinlogShards: {
+        BinlogShardsLogEvent log_event;
+        if (log_event_parse(log_event, event.get_data()).is_error()) {
+          LOG(ERROR) << "Failed to parse binlog shards log event";
+          shards_info.shard_count = std::numeric_limits<int32>::max();
+        } else {
+          shards_info.shard_count = log_event.shard_count_;
+        }
+        shards_info.event_id = event.id_;
+        break;
+      }
       case LogEvent::HandlerType::BinlogPmcMagic:
         binlog_pmc.external_init_handle(event);
         break;
@@ -179,8 +267,144 @@ Status init_binlog(Binlog &binlog, string path, BinlogKeyValue<Binlog> &binlog_p
   return Status::OK();
 }
 
+void append_events(TdDb::OpenedDatabase &events, TdDb::OpenedDatabase &&other_events) {
+  append(events.to_secret_chats_manager, std::move(other_events.to_secret_chats_manager));
+  append(events.user_events, std::move(other_events.user_events));
+  append(events.chat_events, std::move(other_events.chat_events));
+  append(events.channel_events, std::move(other_events.channel_events));
+  append(events.secret_chat_events, std::move(other_events.secret_chat_events));
+  append(events.web_page_events, std::move(other_events.web_page_events));
+  append(events.save_app_log_events, std::move(other_events.save_app_log_events));
+  append(events.to_account_manager, std::move(other_events.to_account_manager));
+  append(events.to_message_broadcast_manager, std::move(other_events.to_message_broadcast_manager));
+  append(events.to_messages_manager, std::move(other_events.to_messages_manager));
+  append(events.to_notification_manager, std::move(other_events.to_notification_manager));
+  append(events.to_notification_settings_manager, std::move(other_events.to_notification_settings_manager));
+  append(events.to_poll_manager, std::move(other_events.to_poll_manager));
+  append(events.to_story_manager, std::move(other_events.to_story_manager));
+}
+
 }  // namespace
 
+// runs passive WAL checkpoints on a separate scheduler instead of automatic checkpoints after commits
+class SqliteCheckpointer {
+ public:
+  SqliteCheckpointer(int32 scheduler_id, std::shared_ptr<SqliteConnectionSafe> sql_connection) {
+    impl_ = create_actor_on_scheduler<Impl>("SqliteCheckpointer", scheduler_id, std::move(sql_connection));
+  }
+
+  void close(Promise<Unit> promise) {
+    send_closure_later(impl_, &Impl::close, std::move(promise));
+    impl_.release();
+  }
+
+ private:
+  class Impl final : public Actor {
+   public:
+    explicit Impl(std::shared_ptr<SqliteConnectionSafe> sql_connection) : sql_connection_(std::move(sql_connection)) {
+    }
+
+    void close(Promise<Unit> promise) {
+      sql_connection_.reset();
+      stop();
+      promise.set_value(Unit());
+    }
+
+   private:
+    static constexpr double CHECKPOINT_PERIOD = 1.0;
+
+    std::shared_ptr<SqliteConnectionSafe> sql_connection_;
+
+    void start_up() final {
+      set_timeout_in(CHECKPOINT_PERIOD);
+    }
+
+    void timeout_expired() final {
+      set_timeout_in(CHECKPOINT_PERIOD);
+      auto r_wal_page_count = sql_connection_->get().checkpoint_wal();
+      if (r_wal_page_count.is_error()) {
+        LOG(ERROR) << r_wal_page_count.error();
+      } else {
+        VLOG(sqlite) << "WAL contains " << r_wal_page_count.ok() << " pages after checkpoint";
+      }
+    }
+  };
+  ActorOwn<Impl> impl_;
+};
+
+// reclaims free pages of a database in auto_vacuum=INCREMENTAL mode in small steps while the database is idle
+class SqliteIncrementalVacuumer {
+ public:
+  SqliteIncrementalVacuumer(int32 scheduler_id, std::shared_ptr<SqliteConnectionSafe> sql_connection) {
+    impl_ = create_actor_on_scheduler<Impl>("SqliteIncrementalVacuumer", scheduler_id, std::move(sql_connection));
+  }
+
+  void close(Promise<Unit> promise) {
+    send_closure_later(impl_, &Impl::close, std::move(promise));
+    impl_.release();
+  }
+
+ private:
+  class Impl final : public Actor {
+   public:
+    explicit Impl(std::shared_ptr<SqliteConnectionSafe> sql_connection) : sql_connection_(std::move(sql_connection)) {
+    }
+
+    void close(Promise<Unit> promise) {
+      sql_connection_.reset();
+      stop();
+      promise.set_value(Unit());
+    }
+
+   private:
+    static constexpr double VACUUM_PERIOD = 1.0;
+    static constexpr int32 MAX_VACUUM_PAGE_COUNT = 128;  // limits the rate of vacuum writes
+
+    std::shared_ptr<SqliteConnectionSafe> sql_connection_;
+    string data_version_;
+
+    void start_up() final {
+      set_timeout_in(VACUUM_PERIOD);
+    }
+
+    void timeout_expired() final {
+      set_timeout_in(VACUUM_PERIOD);
+      auto &db = sql_connection_->get();
+
+      // data_version changes after each commit of other connections, so vacuum is postponed while they write
+      auto r_data_version = db.get_pragma("data_version");
+      if (r_data_version.is_error()) {
+        LOG(ERROR) << r_data_version.error();
+        return;
+      }
+      if (r_data_version.ok() != data_version_) {
+        data_version_ = r_data_version.move_as_ok();
+        return;
+      }
+
+      auto r_free_page_count = db.get_pragma("freelist_count");
+      if (r_free_page_count.is_error()) {
+        LOG(ERROR) << r_free_page_count.error();
+        return;
+      }
+      if (to_integer<int64>(r_free_page_count.ok()) == 0) {
+        return;
+      }
+      auto status = db.exec(PSLICE() << "PRAGMA incremental_vacuum(" << MAX_VACUUM_PAGE_COUNT << ')');
+      if (status.is_error()) {
+        // the database can be locked by another connection
+        VLOG(sqlite) << "Incremental vacuum failed: " << status;
+      } else {
+        VLOG(sqlite) << "Reclaimed up to " << MAX_VACUUM_PAGE_COUNT << " out of " << r_free_page_count.ok()
+                     << " free pages";
+      }
+    }
+  };
+  ActorOwn<Impl> impl_;
+};
+
+constexpr int32 SqliteIncrementalVacuumer::Impl::MAX_VACUUM_PAGE_COUNT;
+
 std::shared_ptr<FileDbInterface> TdDb::get_file_db_shared() {
   return file_db_;
 }
@@ -288,8 +512,13 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
     LOG(INFO) << "Close all databases";
   }
   MultiPromiseActorSafe mpas{"TdDbCloseMultiPromiseActor"};
-  mpas.add_promise(PromiseCreator::lambda(
-      [promise = std::move(on_finished), sql_connection = std::move(sql_connection_), destroy_flag](Unit) mutable {
+  mpas.add_promise(std::move(on_finished));
+  auto lock = mpas.get_promise();
+
+  // the SQLite database is closed after all its users, but doesn't wait for the binlog
+  MultiPromiseActorSafe sqlite_mpas{"TdDbCloseSqliteMultiPromiseActor"};
+  sqlite_mpas.add_promise(PromiseCreator::lambda(
+      [promise = mpas.get_promise(), sql_connection = std::move(sql_connection_), destroy_flag](Unit) mutable {
         if (sql_connection) {
           LOG_CHECK(sql_connection.unique()) << sql_connection.use_count();
           if (destroy_flag) {
@@ -301,36 +530,46 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
         }
         promise.set_value(Unit());
       }));
-  auto lock = mpas.get_promise();
+  auto sqlite_lock = sqlite_mpas.get_promise();
 
   if (file_db_) {
-    file_db_->close(mpas.get_promise());
+    file_db_->close(sqlite_mpas.get_promise());
     file_db_.reset();
   }
 
   common_kv_safe_.reset();
   if (common_kv_async_) {
-    common_kv_async_->close(mpas.get_promise());
+    common_kv_async_->close(sqlite_mpas.get_promise());
   }
 
   message_db_sync_safe_.reset();
   if (message_db_async_) {
-    message_db_async_->close(mpas.get_promise());
+    message_db_async_->close(sqlite_mpas.get_promise());
   }
 
   message_thread_db_sync_safe_.reset();
   if (message_thread_db_async_) {
-    message_thread_db_async_->close(mpas.get_promise());
+    message_thread_db_async_->close(sqlite_mpas.get_promise());
   }
 
   dialog_db_sync_safe_.reset();
   if (dialog_db_async_) {
-    dialog_db_async_->close(mpas.get_promise());
+    dialog_db_async_->close(sqlite_mpas.get_promise());
   }
 
   story_db_sync_safe_.reset();
   if (story_db_async_) {
-    story_db_async_->close(mpas.get_promise());
+    story_db_async_->close(sqlite_mpas.get_promise());
+  }
+
+  if (sqlite_checkpointer_) {
+    sqlite_checkpointer_->close(sqlite_mpas.get_promise());
+    sqlite_checkpointer_.reset();
+  }
+
+  if (sqlite_incremental_vacuumer_) {
+    sqlite_incremental_vacuumer_->close(sqlite_mpas.get_promise());
+    sqlite_incremental_vacuumer_.reset();
   }
 
   // binlog_pmc is dependent on binlog_ and anyway it doesn't support close_and_destroy
@@ -348,11 +587,12 @@ void TdDb::do_close(bool destroy_flag, Promise<Unit> on_finished) {
     binlog_.reset();
   }
 
+  sqlite_lock.set_value(Unit());
   lock.set_value(Unit());
 }
 
 Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
-                         BinlogKeyValue<Binlog> &binlog_pmc) {
+                         BinlogKeyValue<Binlog> &binlog_pmc, BinlogKeyValue<Binlog> &config_pmc) {
   CHECK(!parameters.use_message_database_ || parameters.use_chat_info_database_);
   CHECK(!parameters.use_chat_info_database_ || parameters.use_file_database_);
 
@@ -373,11 +613,34 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
   }
 
   TRY_RESULT(db_instance, SqliteDb::change_key(sql_database_path, true, key, old_key));
-  sql_connection_ = std::make_shared<SqliteConnectionSafe>(sql_database_path, key, db_instance.get_cipher_version());
+  auto use_background_checkpointer = config_pmc.get("use_background_sqlite_checkpointer") == "Btrue";
+  auto performance_profile = get_sqlite_performance_profile(config_pmc, use_background_checkpointer);
+  sql_connection_ = std::make_shared<SqliteConnectionSafe>(sql_database_path, key, db_instance.get_cipher_version(),
+                                                           performance_profile);
   sql_connection_->set(std::move(db_instance));
   auto &db = sql_connection_->get();
   TRY_STATUS(db.exec("PRAGMA journal_mode=WAL"));
   TRY_STATUS(db.exec("PRAGMA secure_delete=1"));
+  TRY_STATUS(db.set_performance_profile(performance_profile));
+
+  auto use_incremental_vacuum = config_pmc.get("use_sqlite_incremental_vacuum") == "Btrue";
+  if (use_incremental_vacuum) {
+    auto status = [&db] {
+      TRY_RESULT(auto_vacuum, db.get_pragma("auto_vacuum"));
+      if (auto_vacuum != "2") {
+        // auto_vacuum mode of an existing database can be changed only by a full VACUUM, which is done once
+        LOG(WARNING) << "Enable incremental vacuum for the database";
+        TRY_STATUS(db.exec("PRAGMA auto_vacuum=INCREMENTAL"));
+        TRY_STATUS(db.exec("VACUUM"));
+      }
+      return Status::OK();
+    }();
+    if (status.is_error()) {
+      // the VACUUM can fail, for example, if there is not enough free disk space for a copy of the database
+      LOG(ERROR) << "Failed to enable incremental vacuum: " << status;
+      use_incremental_vacuum = false;
+    }
+  }
 
   // Init databases
   // Do initialization once and before everything else to avoid "database is locked" error.
@@ -481,7 +744,16 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
 
   if (use_message_database) {
     message_db_sync_safe_ = create_message_db_sync(sql_connection_);
-    message_db_async_ = create_message_db_async(message_db_sync_safe_);
+    // each scheduler has its own SQLite connection, so the other worker schedulers can serve slow reads concurrently
+    auto current_scheduler_id = Scheduler::instance()->sched_id();
+    vector<int32> read_scheduler_ids;
+    for (auto scheduler_id : {G()->get_gc_scheduler_id(), G()->get_slow_net_scheduler_id()}) {
+      if (scheduler_id != current_scheduler_id && !td::contains(read_scheduler_ids, scheduler_id)) {
+        read_scheduler_ids.push_back(scheduler_id);
+      }
+    }
+    message_db_async_ =
+        create_message_db_async(message_db_sync_safe_, current_scheduler_id, std::move(read_scheduler_ids));
   }
 
   if (use_story_database) {
@@ -489,6 +761,14 @@ Status TdDb::init_sqlite(const Parameters &parameters, const DbKey &key, const D
     story_db_async_ = create_story_db_async(story_db_sync_safe_);
   }
 
+  if (use_background_checkpointer) {
+    sqlite_checkpointer_ = td::make_unique<SqliteCheckpointer>(G()->get_gc_scheduler_id(), sql_connection_);
+  }
+  if (use_incremental_vacuum) {
+    sqlite_incremental_vacuumer_ =
+        td::make_unique<SqliteIncrementalVacuumer>(G()->get_gc_scheduler_id(), sql_connection_);
+  }
+
   return Status::OK();
 }
 
@@ -514,9 +794,72 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   config_pmc->external_init_begin(static_cast<int32>(LogEvent::HandlerType::ConfigPmcMagic));
 
   bool encrypt_binlog = !parameters.encryption_key_.is_empty();
+  auto start_time = Time::now();
   VLOG(td_init) << "Start binlog loading";
-  TRY_STATUS_PROMISE(promise, init_binlog(*binlog, get_binlog_path(parameters), *binlog_pmc, *config_pmc, result,
-                                          std::move(parameters.encryption_key_)));
+  init_since_last_open(get_binlog_path(parameters), result);
+
+  // shard binlogs contain only events of their own types and have their own encryption key derivation,
+  // so they are replayed concurrently with the main binlog
+  constexpr size_t SHARD_COUNT = sizeof(BINLOG_SHARDS) / sizeof(BINLOG_SHARDS[0]);
+  vector<unique_ptr<Binlog>> shard_binlogs(SHARD_COUNT);
+  vector<OpenedDatabase> shard_events(SHARD_COUNT);
+  vector<Status> shard_statuses(SHARD_COUNT);
+  vector<double> shard_load_times(SHARD_COUNT);
+  auto load_shard_binlog = [&parameters, &shard_binlogs, &shard_events, &shard_statuses, &shard_load_times](size_t i) {
+    auto shard_start_time = Time::now();
+    BinlogKeyValue<Binlog> shard_binlog_pmc;
+    BinlogKeyValue<Binlog> shard_config_pmc;
+    BinlogShardsInfo shard_shards_info;
+    shard_binlog_pmc.external_init_begin(static_cast<int32>(LogEvent::HandlerType::BinlogPmcMagic));
+    shard_config_pmc.external_init_begin(static_cast<int32>(LogEvent::HandlerType::ConfigPmcMagic));
+    shard_binlogs[i] = make_unique<Binlog>();
+    shard_statuses[i] =
+        init_binlog(*shard_binlogs[i], get_binlog_shard_path(parameters, BINLOG_SHARDS[i]), shard_binlog_pmc,
+                    shard_config_pmc, shard_events[i], shard_shards_info, parameters.encryption_key_);
+    shard_binlogs[i]->skip_event_ids(ShardedBinlog::get_shard_min_event_id(i + 1));
+    shard_load_times[i] = Time::now() - shard_start_time;
+  };
+#if !TD_THREAD_UNSUPPORTED
+  vector<td::thread> shard_threads;
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    shard_threads.emplace_back(load_shard_binlog, i);
+  }
+#endif
+  BinlogShardsInfo shards_info;
+  auto init_binlog_status = init_binlog(*binlog, get_binlog_path(parameters), *binlog_pmc, *config_pmc, result,
+                                        shards_info, parameters.encryption_key_);
+  auto binlog_load_time = Time::now() - start_time;
+#if !TD_THREAD_UNSUPPORTED
+  for (auto &thread : shard_threads) {
+    thread.join();
+  }
+#else
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    load_shard_binlog(i);
+  }
+#endif
+  TRY_STATUS_PROMISE(promise, std::move(init_binlog_status));
+  if (shards_info.shard_count > static_cast<int32>(SHARD_COUNT)) {
+    // events from the unknown shard binlogs would be lost
+    return promise.set_error(Status::Error(400, "The database was created by a newer TDLib version"));
+  }
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    TRY_STATUS_PROMISE(promise, std::move(shard_statuses[i]));
+    append_events(result, std::move(shard_events[i]));
+  }
+  if (shards_info.shard_count != static_cast<int32>(SHARD_COUNT)) {
+    // must be saved before the first event is added to the shard binlogs
+    BinlogShardsLogEvent log_event;
+    log_event.shard_count_ = static_cast<int32>(SHARD_COUNT);
+    if (shards_info.event_id == 0) {
+      binlog->add(LogEvent::HandlerType::BinlogShards, get_log_event_storer(log_event));
+    } else {
+      binlog->rewrite(shards_info.event_id, LogEvent::HandlerType::BinlogShards, get_log_event_storer(log_event));
+    }
+    binlog->sync("TdDb::open_impl 0");
+  }
+  parameters.encryption_key_ = DbKey::empty();
+  auto binlogs_load_time = Time::now() - start_time;
   VLOG(td_init) << "Finish binlog loading";
 
   binlog_pmc->external_init_finish(binlog);
@@ -551,8 +894,9 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
     }
   }
   VLOG(td_init) << "Start to init database";
+  auto sqlite_start_time = Time::now();
   auto db = make_unique<TdDb>();
-  auto init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+  auto init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc, *config_pmc);
   VLOG(td_init) << "Finish to init database";
   if (init_sqlite_status.is_error()) {
     LOG(ERROR) << "Destroy bad SQLite database because of " << init_sqlite_status;
@@ -560,7 +904,7 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
       db->sql_connection_->get().close();
     }
     SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
-    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc);
+    init_sqlite_status = db->init_sqlite(parameters, new_sqlite_key, old_sqlite_key, *binlog_pmc, *config_pmc);
     if (init_sqlite_status.is_error()) {
       return promise.set_error(Status::Error(400, init_sqlite_status.message()));
     }
@@ -569,6 +913,7 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
     binlog_pmc->erase("sqlite_key");
     binlog_pmc->force_sync(Auto(), "TdDb::open_impl 2");
   }
+  auto sqlite_init_time = Time::now() - sqlite_start_time;
 
   VLOG(td_init) << "Create concurrent_binlog_pmc";
   auto concurrent_binlog_pmc = std::make_shared<BinlogKeyValue<ConcurrentBinlog>>();
@@ -587,6 +932,14 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   CHECK(binlog_ptr != nullptr);
   VLOG(td_init) << "Create concurrent_binlog";
   auto concurrent_binlog = std::make_shared<ConcurrentBinlog>(unique_ptr<Binlog>(binlog_ptr));
+  auto sharded_binlog = std::make_shared<ShardedBinlog>(concurrent_binlog);
+  for (size_t i = 0; i < shard_binlogs.size(); i++) {
+    auto shard_binlog = std::make_shared<ConcurrentBinlog>(std::move(shard_binlogs[i]));
+    if (BINLOG_SHARDS[i].sync_period > 0.0) {
+      shard_binlog->set_sync_policy(BinlogSyncPolicy::periodic(BINLOG_SHARDS[i].sync_period));
+    }
+    sharded_binlog->add_shard(BINLOG_SHARDS[i].min_type, BINLOG_SHARDS[i].max_type, std::move(shard_binlog));
+  }
 
   VLOG(td_init) << "Init concurrent_binlog_pmc";
   concurrent_binlog_pmc->external_init_finish(concurrent_binlog);
@@ -594,12 +947,15 @@ void TdDb::open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise) {
   concurrent_config_pmc->external_init_finish(concurrent_binlog);
 
   LOG(INFO) << "Successfully inited database in directory " << parameters.database_directory_ << " and files directory "
-            << parameters.files_directory_;
+            << parameters.files_directory_ << " in " << Time::now() - start_time << " seconds";
+  LOG(INFO) << "Loaded main binlog in " << binlog_load_time << " seconds, shard binlogs in " << shard_load_times
+            << " seconds, all binlogs in " << binlogs_load_time << " seconds; inited SQLite database in "
+            << sqlite_init_time << " seconds";
 
   db->parameters_ = std::move(parameters);
   db->binlog_pmc_ = std::move(concurrent_binlog_pmc);
   db->config_pmc_ = std::move(concurrent_config_pmc);
-  db->binlog_ = std::move(concurrent_binlog);
+  db->binlog_ = std::move(sharded_binlog);
 
   result.database = std::move(db);
 
@@ -669,16 +1025,21 @@ void TdDb::change_key(DbKey key, Promise<> promise) {
 Status TdDb::destroy(const Parameters &parameters) {
   SqliteDb::destroy(get_sqlite_path(parameters)).ignore();
   Binlog::destroy(get_binlog_path(parameters)).ignore();
+  for (auto &shard : BINLOG_SHARDS) {
+    Binlog::destroy(get_binlog_shard_path(parameters, shard)).ignore();
+  }
   return Status::OK();
 }
 
 void TdDb::with_db_path(const std::function<void(CSlice)> &callback) {
   SqliteDb::with_db_path(get_sqlite_path(parameters_), callback);
   CHECK(binlog_ != nullptr);
-  callback(binlog_->get_path());
+  for (size_t i = 0; i < binlog_->get_shard_count(); i++) {
+    callback(binlog_->get_shard(i).get_path());
+  }
 }
 
-Result<string> TdDb::get_stats() {
+Result<string> TdDb::get_stats(bool with_compression_stats) {
   auto sb = StringBuilder({}, true);
   auto &sql = sql_connection_->get();
   auto run_query = [&](CSlice query, Slice desc) -> Status {
@@ -704,6 +1065,20 @@ Result<string> TdDb::get_stats() {
   };
   TRY_STATUS(run_query("SELECT 0, SUM(length(data)), COUNT(*) FROM stories WHERE 1", "stories"));
   TRY_STATUS(run_query("SELECT 0, SUM(length(data)), COUNT(*) FROM messages WHERE 1", "messages"));
+  if (with_compression_stats) {
+    TRY_RESULT(stmt, sql.get_statement("SELECT substr(data, 1, 8), length(data) FROM messages"));
+    TRY_STATUS(stmt.step());
+    int64 stored_size = 0;
+    int64 original_size = 0;
+    while (stmt.has_row()) {
+      auto size = stmt.view_int64(1);
+      stored_size += size;
+      original_size += get_message_db_data_original_size(stmt.view_blob(0), size);
+      TRY_STATUS(stmt.step());
+    }
+    sb << "messages compression:\n";
+    sb << format::as_size(stored_size) << "\t" << format::as_size(original_size) << "\t\n";
+  }
   TRY_STATUS(run_query("SELECT 0, SUM(length(data)), COUNT(*) FROM dialogs WHERE 1", "dialogs"));
   TRY_STATUS(run_kv_query("%", "common"));
   TRY_STATUS(run_kv_query("%", "files"));
@@ -714,6 +1089,7 @@ Result<string> TdDb::get_stats() {
   TRY_STATUS(run_kv_query("ch%"));
   TRY_STATUS(run_kv_query("ss%"));
   TRY_STATUS(run_kv_query("gr%"));
+  sb << "common key-value writes:\n" << common_kv_async_->get_write_statistics() << "\n";
 
   vector<int32> prev(1);
   size_t count = 0;
@@ -751,7 +1127,40 @@ Result<string> TdDb::get_stats() {
   }
   sb << "Max file database depth out of " << prev.size() << '/' << count
      << " elements: " << *std::max_element(prev.begin(), prev.end()) << "\n";
-  sb << "Have " << bad_count << " forward references with maximum reference to " << max_bad_to;
+  sb << "Have " << bad_count << " forward references with maximum reference to " << max_bad_to << "\n";
+
+  return sb.as_cslice().str();
+}
+
+Result<string> TdDb::get_connection_stats() {
+  auto sb = StringBuilder({}, true);
+  auto &sql = sql_connection_->get();
+  auto connection_stats = sql.get_statistics();
+  sb << "connection page cache:\n";
+  sb << tag("hits", connection_stats.cache_hit_count) << tag("misses", connection_stats.cache_miss_count)
+     << tag("writes", connection_stats.cache_write_count)
+     << tag("used", format::as_size(static_cast<int64>(connection_stats.cache_used_size))) << "\n";
+  sb << "connection commits including automatic checkpoints:\n";
+  sb << tag("count", connection_stats.commit_count)
+     << tag("total", format::as_time(connection_stats.total_commit_time))
+     << tag("max", format::as_time(connection_stats.max_commit_time)) << "\n";
+  TRY_RESULT(page_count, sql.get_pragma("page_count"));
+  TRY_RESULT(free_page_count, sql.get_pragma("freelist_count"));
+  TRY_RESULT(auto_vacuum, sql.get_pragma("auto_vacuum"));
+  sb << "database pages:\n";
+  sb << tag("total", page_count) << tag("free", free_page_count) << tag("auto_vacuum", auto_vacuum) << "\n";
+  auto r_wal_stat = stat(PSLICE() << get_sqlite_path(parameters_) << "-wal");
+  sb << "WAL size: " << format::as_size(r_wal_stat.is_ok() ? r_wal_stat.ok().size_ : 0) << "\n";
+
+  constexpr size_t MAX_SHOWN_STATEMENTS = 20;
+  auto statement_stats = SqliteStatement::get_statistics();
+  sb << "statements with the largest total step time in the process:\n";
+  for (size_t i = 0; i < statement_stats.size() && i < MAX_SHOWN_STATEMENTS; i++) {
+    const auto &stats = statement_stats[i];
+    sb << format::as_time(stats.step_time) << "\t" << stats.step_count << "\t"
+       << format::as_time(stats.step_time / static_cast<double>(max(stats.step_count, static_cast<int64>(1))))
+       << "\t" << stats.sql << "\n";
+  }
 
   return sb.as_cslice().str();
 }
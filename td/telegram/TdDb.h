@@ -35,7 +35,10 @@ class MessageDbAsyncInterface;
 class MessageThreadDbSyncInterface;
 class MessageThreadDbSyncSafeInterface;
 class MessageThreadDbAsyncInterface;
+class ShardedBinlog;
+class SqliteCheckpointer;
 class SqliteConnectionSafe;
+class SqliteIncrementalVacuumer;
 class SqliteKeyValueSafe;
 class SqliteKeyValueAsyncInterface;
 class SqliteKeyValue;
@@ -73,6 +76,7 @@ class TdDb {
     vector<BinlogEvent> web_page_events;
     vector<BinlogEvent> save_app_log_events;
     vector<BinlogEvent> to_account_manager;
+    vector<BinlogEvent> to_message_broadcast_manager;
     vector<BinlogEvent> to_messages_manager;
     vector<BinlogEvent> to_notification_manager;
     vector<BinlogEvent> to_notification_settings_manager;
@@ -152,7 +156,13 @@ class TdDb {
 
   void with_db_path(const std::function<void(CSlice)> &callback);
 
-  Result<string> get_stats();
+  // scans the whole database; must be called on a scheduler other than the database scheduler,
+  // so that a separate SQLite connection is used and database queries aren't blocked meanwhile;
+  // message compression statistics require reading of every message and are collected only if requested
+  Result<string> get_stats(bool with_compression_stats);
+
+  // returns statistics of the SQLite connection of the current scheduler and of all SQLite statements
+  Result<string> get_connection_stats();
 
  private:
   Parameters parameters_;
@@ -160,6 +170,8 @@ class TdDb {
   bool was_dialog_db_created_ = false;
 
   std::shared_ptr<SqliteConnectionSafe> sql_connection_;
+  unique_ptr<SqliteCheckpointer> sqlite_checkpointer_;
+  unique_ptr<SqliteIncrementalVacuumer> sqlite_incremental_vacuumer_;
 
   std::shared_ptr<FileDbInterface> file_db_;
 
@@ -180,14 +192,14 @@ class TdDb {
 
   std::shared_ptr<BinlogKeyValue<ConcurrentBinlog>> binlog_pmc_;
   std::shared_ptr<BinlogKeyValue<ConcurrentBinlog>> config_pmc_;
-  std::shared_ptr<ConcurrentBinlog> binlog_;
+  std::shared_ptr<ShardedBinlog> binlog_;
 
   static void open_impl(Parameters parameters, Promise<OpenedDatabase> &&promise);
 
   static Status check_parameters(Parameters &parameters);
 
   Status init_sqlite(const Parameters &parameters, const DbKey &key, const DbKey &old_key,
-                     BinlogKeyValue<Binlog> &binlog_pmc);
+                     BinlogKeyValue<Binlog> &binlog_pmc, BinlogKeyValue<Binlog> &config_pmc);
 
   void do_close(bool destroy_flag, Promise<Unit> on_finished);
 };
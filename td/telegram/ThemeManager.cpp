@@ -12,6 +12,7 @@
 #include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/net/NetQueryCreator.h"
 #include "td/telegram/OptionManager.h"
+#include "td/telegram/SharedServerDataCache.h"
 #include "td/telegram/Td.h"
 #include "td/telegram/TdDb.h"
 #include "td/telegram/telegram_api.h"
@@ -40,6 +41,7 @@ static bool are_colors_valid(const vector<int32> &colors, size_t min_size, size_
 
 class GetChatThemesQuery final : public Td::ResultHandler {
   Promise<telegram_api::object_ptr<telegram_api::account_Themes>> promise_;
+  bool is_shared_ = false;
 
  public:
   explicit GetChatThemesQuery(Promise<telegram_api::object_ptr<telegram_api::account_Themes>> &&promise)
@@ -47,6 +49,15 @@ class GetChatThemesQuery final : public Td::ResultHandler {
   }
 
   void send(int64 hash) {
+    if (SharedServerDataCache::is_up_to_date("chat_themes", hash)) {
+      return promise_.set_value(telegram_api::make_object<telegram_api::account_themesNotModified>());
+    }
+    auto response = SharedServerDataCache::get_response("chat_themes", hash);
+    if (!response.empty()) {
+      is_shared_ = true;
+      return on_result(std::move(response));
+    }
+
     send_query(G()->net_query_creator().create(telegram_api::account_getChatThemes(hash)));
   }
 
@@ -56,7 +67,12 @@ class GetChatThemesQuery final : public Td::ResultHandler {
       return on_error(result_ptr.move_as_error());
     }
 
-    promise_.set_value(result_ptr.move_as_ok());
+    auto ptr = result_ptr.move_as_ok();
+    if (!is_shared_ && ptr->get_id() == telegram_api::account_themes::ID) {
+      SharedServerDataCache::add_response(
+          "chat_themes", static_cast<const telegram_api::account_themes *>(ptr.get())->hash_, packet);
+    }
+    promise_.set_value(std::move(ptr));
   }
 
   void on_error(Status status) final {
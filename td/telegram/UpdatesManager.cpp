@@ -86,6 +86,7 @@
 #include "td/telegram/Usernames.h"
 #include "td/telegram/WebPagesManager.h"
 
+#include "td/actor/CpuTaskPool.h"
 #include "td/actor/MultiPromise.h"
 #include "td/actor/PromiseFuture.h"
 
@@ -189,6 +190,8 @@ class InitSessionQuery final : public Td::ResultHandler {
   }
 };
 
+static constexpr size_t MIN_BACKGROUND_PARSED_DIFFERENCE_SIZE = 1 << 17;
+
 class GetDifferenceQuery final : public Td::ResultHandler {
   Promise<tl_object_ptr<telegram_api::updates_Difference>> promise_;
 
@@ -203,6 +206,13 @@ class GetDifferenceQuery final : public Td::ResultHandler {
 
   void on_result(BufferSlice packet) final {
     VLOG(get_difference) << "Receive getDifference result of size " << packet.size();
+    if (packet.size() >= MIN_BACKGROUND_PARSED_DIFFERENCE_SIZE) {
+      // parse big differences on another thread, so a prefetched slice is parsed while the previous one is applied
+      G()->get_cpu_task_pool().run(
+          [packet = std::move(packet)] { return fetch_result<telegram_api::updates_getDifference>(packet); },
+          std::move(promise_));
+      return;
+    }
     auto result_ptr = fetch_result<telegram_api::updates_getDifference>(packet);
     if (result_ptr.is_error()) {
       return on_error(result_ptr.move_as_error());
@@ -314,6 +324,10 @@ void UpdatesManager::hangup_shared() {
 }
 
 void UpdatesManager::hangup() {
+  // save the last acknowledged PTS and QTS, which weren't saved yet
+  cancel_timeout();
+  timeout_expired();
+
   pending_pts_updates_.clear();
   postponed_pts_updates_.clear();
   postponed_updates_.clear();
@@ -511,6 +525,27 @@ void UpdatesManager::run_get_difference(bool is_recursive, const char *source) {
     min_postponed_update_qts_ = 0;
   }
 
+  if (prefetched_difference_ != nullptr) {
+    auto prefetched_difference = std::move(prefetched_difference_);
+    if (is_recursive && prefetched_difference->pts_ == pts && prefetched_difference->date_ == date &&
+        prefetched_difference->qts_ == qts) {
+      VLOG(get_difference) << "Use prefetched difference";
+      prefetched_difference_slice_count_++;
+      last_confirmed_pts_ = pts;
+      last_confirmed_qts_ = qts;
+      if (prefetched_difference->difference_ != nullptr) {
+        // apply the slice later to avoid unbounded recursion
+        send_closure_later(actor_id(this), &UpdatesManager::on_get_difference,
+                           std::move(prefetched_difference->difference_));
+      } else {
+        prefetched_difference->is_awaited_ = true;
+        prefetched_difference_ = std::move(prefetched_difference);
+      }
+      return;
+    }
+    VLOG(get_difference) << "Drop prefetched difference";
+  }
+
   auto promise = PromiseCreator::lambda([](Result<tl_object_ptr<telegram_api::updates_Difference>> result) {
     if (result.is_ok()) {
       send_closure(G()->updates_manager(), &UpdatesManager::on_get_difference, result.move_as_ok());
@@ -523,6 +558,53 @@ void UpdatesManager::run_get_difference(bool is_recursive, const char *source) {
   last_confirmed_qts_ = qts;
 }
 
+void UpdatesManager::prefetch_difference(const telegram_api::updates_state *state) {
+  CHECK(state != nullptr);
+  if (prefetched_difference_ != nullptr) {
+    return;
+  }
+
+  VLOG(get_difference) << "Prefetch difference with PTS = " << state->pts_ << ", QTS = " << state->qts_
+                       << ", date = " << state->date_;
+  prefetched_difference_ = make_unique<PrefetchedDifference>();
+  prefetched_difference_->pts_ = state->pts_;
+  prefetched_difference_->date_ = state->date_;
+  prefetched_difference_->qts_ = state->qts_;
+  auto generation = ++prefetched_difference_generation_;
+  auto promise = PromiseCreator::lambda(
+      [generation](Result<tl_object_ptr<telegram_api::updates_Difference>> r_difference) {
+        send_closure(G()->updates_manager(), &UpdatesManager::on_get_prefetched_difference, generation,
+                     std::move(r_difference));
+      });
+  td_->create_handler<GetDifferenceQuery>(std::move(promise))->send(state->pts_, state->date_, state->qts_);
+}
+
+void UpdatesManager::on_get_prefetched_difference(
+    uint64 generation, Result<tl_object_ptr<telegram_api::updates_Difference>> r_difference) {
+  if (G()->close_flag() || !td_->auth_manager_->is_authorized()) {
+    return;
+  }
+  if (prefetched_difference_ == nullptr || generation != prefetched_difference_generation_) {
+    VLOG(get_difference) << "Ignore result of dropped prefetched difference";
+    return;
+  }
+
+  if (prefetched_difference_->is_awaited_) {
+    prefetched_difference_ = nullptr;
+    if (r_difference.is_error()) {
+      return on_failed_get_difference(r_difference.move_as_error());
+    }
+    return on_get_difference(r_difference.move_as_ok());
+  }
+
+  if (r_difference.is_error()) {
+    // the difference will be requested once again after the current slice is applied
+    prefetched_difference_ = nullptr;
+    return;
+  }
+  prefetched_difference_->difference_ = r_difference.move_as_ok();
+}
+
 void UpdatesManager::before_get_difference(bool is_initial) {
   // may be called many times before after_get_difference is called
   send_closure(G()->state_manager(), &StateManager::on_synchronized, false);
@@ -583,7 +665,7 @@ void UpdatesManager::save_pts(int32 pts) {
   } else if (!td_->ignore_background_updates()) {
     auto now = Time::now();
     auto delay = last_pts_save_time_ + MAX_PTS_SAVE_DELAY - now;
-    if (delay <= 0 || !td_->auth_manager_->is_bot()) {
+    if (delay <= 0) {
       last_pts_save_time_ = now;
       pending_pts_ = 0;
       G()->td_db()->get_binlog_pmc()->set("updates.pts", to_string(pts));
@@ -600,7 +682,7 @@ void UpdatesManager::save_qts(int32 qts) {
   if (!td_->ignore_background_updates()) {
     auto now = Time::now();
     auto delay = last_qts_save_time_ + MAX_PTS_SAVE_DELAY - now;
-    if (delay <= 0 || !td_->auth_manager_->is_bot()) {
+    if (delay <= 0) {
       last_qts_save_time_ = now;
       pending_qts_ = 0;
       G()->td_db()->get_binlog_pmc()->set("updates.qts", to_string(qts));
@@ -658,7 +740,7 @@ Promise<> UpdatesManager::set_pts(int32 pts, const char *source) {
     if (last_confirmed_pts_ < get_pts() - FORCED_GET_DIFFERENCE_PTS_DIFF && last_confirmed_pts_ != 0) {
       confirm_pts_qts(get_qts());
     }
-  } else if (pts < get_pts() && (pts > 1 || td_->option_manager_->get_option_integer("session_count") <= 1)) {
+  } else if (pts < get_pts() && (pts > 1 || td_->option_manager_->get_option_integer(OptionId::SessionCount) <= 1)) {
     LOG(ERROR) << "Receive wrong PTS = " << pts << " from " << source << ". Current PTS = " << get_pts();
   }
   return result;
@@ -1754,7 +1836,7 @@ void UpdatesManager::on_update_from_auth_key_id(uint64 auth_key_id) {
   if (info.update_count++ == 0) {
     info.first_update_time = now;
     while (session_infos_.size() >
-           static_cast<size_t>(max(narrow_cast<int32>(G()->get_option_integer("session_count")), 1))) {
+           static_cast<size_t>(max(narrow_cast<int32>(G()->get_option_integer(OptionId::SessionCount)), 1))) {
       auto unused_auth_key_id = get_most_unused_auth_key_id();
       LOG(INFO) << "Delete statistics for auth key " << unused_auth_key_id;
       session_infos_.erase(unused_auth_key_id);
@@ -1943,10 +2025,12 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
     case telegram_api::updates_differenceSlice::ID: {
       auto difference = move_tl_object_as<telegram_api::updates_differenceSlice>(difference_ptr);
       bool is_pts_changed = have_update_pts_changed(difference->other_updates_);
+      get_difference_slice_count_++;
       if (difference->intermediate_state_->pts_ >= get_pts() && get_pts() != std::numeric_limits<int32>::max() &&
           difference->intermediate_state_->date_ >= date_ && difference->intermediate_state_->qts_ == get_qts() &&
           !is_pts_changed) {
-        // TODO send new getDifference request and apply difference slice only after that
+        // request the next slice while the current one is applied; the request doesn't confirm any new QTS
+        prefetch_difference(difference->intermediate_state_.get());
       }
 
       VLOG(get_difference) << "In get difference receive " << difference->users_.size() << " users and "
@@ -2000,7 +2084,7 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
       break;
     }
     case telegram_api::updates_differenceTooLong::ID: {
-      if (td_->option_manager_->get_option_integer("session_count") <= 1) {
+      if (td_->option_manager_->get_option_integer(OptionId::SessionCount) <= 1) {
         LOG(ERROR) << "Receive differenceTooLong";
       }
       // TODO
@@ -2016,6 +2100,7 @@ void UpdatesManager::on_get_difference(tl_object_ptr<telegram_api::updates_Diffe
   get_difference_retry_count_ = 0;
 
   if (!running_get_difference_) {
+    prefetched_difference_ = nullptr;
     after_get_difference();
   }
 }
@@ -2198,6 +2283,13 @@ void UpdatesManager::after_get_difference() {
   td_->messages_manager_->after_get_difference();
   send_closure_later(td_->notification_manager_actor_, &NotificationManager::after_get_difference);
   send_closure(G()->state_manager(), &StateManager::on_synchronized, true);
+  if (get_difference_slice_count_ > 0) {
+    LOG(INFO) << "Finished getDifference in " << (Time::now() - get_difference_start_time_)
+              << " seconds after receiving " << get_difference_slice_count_ << " difference slices, "
+              << prefetched_difference_slice_count_ << " of which were prefetched";
+    get_difference_slice_count_ = 0;
+    prefetched_difference_slice_count_ = 0;
+  }
   get_difference_start_time_ = 0.0;
 
   try_reload_data();
@@ -2767,7 +2859,9 @@ void UpdatesManager::process_updates(vector<tl_object_ptr<telegram_api::Update>>
   for (auto &update : updates) {
     if (update != nullptr) {
       LOG(INFO) << "Process update " << to_string(update);
-      downcast_call(*update, OnUpdate(this, update, get_promise()));
+      if (!process_synchronous_update(update)) {
+        downcast_call(*update, OnUpdate(this, update, get_promise()));
+      }
       CHECK(!running_get_difference_);
     }
   }
@@ -2777,6 +2871,22 @@ void UpdatesManager::process_updates(vector<tl_object_ptr<telegram_api::Update>>
   lock.set_value(Unit());
 }
 
+bool UpdatesManager::process_synchronous_update(tl_object_ptr<telegram_api::Update> &update) {
+  switch (update->get_id()) {
+    case telegram_api::updateUserStatus::ID:
+      on_update(move_tl_object_as<telegram_api::updateUserStatus>(update), Promise<Unit>());
+      return true;
+    case telegram_api::updateChannelMessageViews::ID:
+      on_update(move_tl_object_as<telegram_api::updateChannelMessageViews>(update), Promise<Unit>());
+      return true;
+    case telegram_api::updateReadChannelInbox::ID:
+      on_update(move_tl_object_as<telegram_api::updateReadChannelInbox>(update), Promise<Unit>());
+      return true;
+    default:
+      return false;
+  }
+}
+
 void UpdatesManager::process_pts_update(tl_object_ptr<telegram_api::Update> &&update) {
   CHECK(update != nullptr);
 
@@ -2827,7 +2937,7 @@ void UpdatesManager::add_pending_pts_update(tl_object_ptr<telegram_api::Update>
     bool need_restore_pts = new_pts < old_pts - 19999;
     auto now = Time::now();
     if (old_pts == 2100000000 && new_pts < 1100000000 && pts_count <= 10000 &&
-        td_->option_manager_->get_option_integer("session_count") > 1) {
+        td_->option_manager_->get_option_integer(OptionId::SessionCount) > 1) {
       set_pts(1, "restore PTS").set_value(Unit());
       old_pts = get_pts();
       set_pts_gap_timeout(0.001);
@@ -2931,7 +3041,8 @@ void UpdatesManager::add_pending_pts_update(tl_object_ptr<telegram_api::Update>
 
 void UpdatesManager::postpone_pts_update(tl_object_ptr<telegram_api::Update> &&update, int32 pts, int32 pts_count,
                                          double receive_time, Promise<Unit> &&promise) {
-  if (!can_postpone_updates() || (pts_count > 1 && td_->option_manager_->get_option_integer("session_count") <= 1)) {
+  if (!can_postpone_updates() ||
+      (pts_count > 1 && td_->option_manager_->get_option_integer(OptionId::SessionCount) <= 1)) {
     return promise.set_value(Unit());
   }
   postponed_pts_updates_.emplace(std::move(update), pts, pts_count, receive_time, std::move(promise));
@@ -4162,7 +4273,7 @@ void UpdatesManager::on_update(tl_object_ptr<telegram_api::updateConfig> update,
 }
 
 void UpdatesManager::on_update(tl_object_ptr<telegram_api::updatePtsChanged> update, Promise<Unit> &&promise) {
-  if (td_->option_manager_->get_option_integer("session_count") > 1) {
+  if (td_->option_manager_->get_option_integer(OptionId::SessionCount) > 1) {
     auto old_pts = get_pts();
     auto new_pts = 1;
     if (old_pts != new_pts) {
@@ -53,6 +53,10 @@ class dummyUpdate final : public telegram_api::Update {
     UNREACHABLE();
   }
 
+  void store(TlStorerGrowable &s) const final {
+    UNREACHABLE();
+  }
+
   void store(TlStorerToString &s, const char *field_name) const final {
     s.store_class_begin(field_name, "dummyUpdate");
     s.store_class_end();
@@ -83,6 +87,10 @@ class updateSentMessage final : public telegram_api::Update {
     UNREACHABLE();
   }
 
+  void store(TlStorerGrowable &s) const final {
+    UNREACHABLE();
+  }
+
   void store(TlStorerToString &s, const char *field_name) const final {
     s.store_class_begin(field_name, "updateSentMessage");
     s.store_field("random_id", random_id_);
@@ -144,7 +152,7 @@ class UpdatesManager final : public Actor {
   static constexpr int32 GAP_TIMEOUT_UPDATE_COUNT = 20;
   static constexpr double MIN_UNFILLED_GAP_TIME = 0.05;
   static constexpr double MAX_UNFILLED_GAP_TIME = 0.7;
-  static constexpr double MAX_PTS_SAVE_DELAY = 0.05;
+  static constexpr double MAX_PTS_SAVE_DELAY = 0.05;  // PTS and QTS are saved to the database at most once per delay
   static constexpr double UPDATE_APPLY_WARNING_TIME = 0.1;
   static constexpr bool DROP_PTS_UPDATES = false;
   static constexpr const char *AFTER_GET_DIFFERENCE_SOURCE = "after get difference";
@@ -274,6 +282,19 @@ class UpdatesManager final : public Actor {
   int32 min_postponed_update_qts_ = 0;
   double get_difference_start_time_ = 0;  // time from which we started to get difference without success
   int32 get_difference_retry_count_ = 0;
+  int32 get_difference_slice_count_ = 0;
+  int32 prefetched_difference_slice_count_ = 0;
+
+  // the next difference slice, which is requested while the previous slice is applied
+  struct PrefetchedDifference {
+    int32 pts_ = 0;
+    int32 date_ = 0;
+    int32 qts_ = 0;
+    bool is_awaited_ = false;
+    tl_object_ptr<telegram_api::updates_Difference> difference_;
+  };
+  unique_ptr<PrefetchedDifference> prefetched_difference_;
+  uint64 prefetched_difference_generation_ = 0;
 
   struct SessionInfo {
     uint64 update_count = 0;
@@ -357,6 +378,9 @@ class UpdatesManager final : public Actor {
 
   void process_pts_update(tl_object_ptr<telegram_api::Update> &&update);
 
+  // processes frequent updates, which are applied synchronously, without creating a promise for them
+  bool process_synchronous_update(tl_object_ptr<telegram_api::Update> &update);
+
   void process_seq_updates(int32 seq_end, int32 date, vector<tl_object_ptr<telegram_api::Update>> &&updates,
                            Promise<Unit> &&promise);
 
@@ -398,6 +422,11 @@ class UpdatesManager final : public Actor {
 
   void run_get_difference(bool is_recursive, const char *source);
 
+  void prefetch_difference(const telegram_api::updates_state *state);
+
+  void on_get_prefetched_difference(uint64 generation,
+                                    Result<tl_object_ptr<telegram_api::updates_Difference>> r_difference);
+
   void confirm_pts_qts(int32 qts);
 
   void on_failed_get_updates_state(Status &&error);
@@ -1343,6 +1343,10 @@ class GetIsPremiumRequiredToContactQuery final : public Td::ResultHandler {
 template <class StorerT>
 void UserManager::User::store(StorerT &storer) const {
   using td::store;
+  const auto &info = get_user_extra_info(this);
+  const auto &restriction_reasons = info.restriction_reasons;
+  const auto &inline_query_placeholder = info.inline_query_placeholder;
+  const auto &language_code = info.language_code;
   bool has_last_name = !last_name.empty();
   bool legacy_has_username = false;
   bool has_photo = photo.small_file_id.is_valid();
@@ -1571,21 +1575,25 @@ void UserManager::User::parse(ParserT &parser) {
     is_close_friend = false;
   }
   parse(was_online, parser);
+  UserExtraInfo info;
   if (legacy_is_restricted) {
     string restriction_reason;
     parse(restriction_reason, parser);
-    restriction_reasons = get_restriction_reasons(restriction_reason);
+    info.restriction_reasons = get_restriction_reasons(restriction_reason);
   } else if (has_restriction_reasons) {
-    parse(restriction_reasons, parser);
+    parse(info.restriction_reasons, parser);
   }
   if (is_inline_bot) {
-    parse(inline_query_placeholder, parser);
+    parse(info.inline_query_placeholder, parser);
   }
   if (is_bot) {
     parse(bot_info_version, parser);
   }
   if (has_language_code) {
-    parse(language_code, parser);
+    parse(info.language_code, parser);
+  }
+  if (!info.restriction_reasons.empty() || !info.inline_query_placeholder.empty() || !info.language_code.empty()) {
+    extra_info = td::make_unique<UserExtraInfo>(std::move(info));
   }
   if (has_cache_version) {
     parse(cache_version, parser);
@@ -2074,9 +2082,11 @@ void UserManager::on_user_online_timeout(UserId user_id) {
   CHECK(u->is_update_user_sent);
 
   LOG(INFO) << "Update " << user_id << " online status to offline";
-  send_closure(G()->td(), &Td::send_update,
-               td_api::make_object<td_api::updateUserStatus>(user_id.get(),
-                                                             get_user_status_object(user_id, u, G()->unix_time())));
+  if (!td_->is_update_ignored(td_api::updateUserStatus::ID)) {
+    send_closure(G()->td(), &Td::send_update,
+                 td_api::make_object<td_api::updateUserStatus>(user_id.get(),
+                                                               get_user_status_object(user_id, u, G()->unix_time())));
+  }
 
   td_->dialog_participant_manager_->update_user_online_member_count(user_id);
 }
@@ -2407,7 +2417,8 @@ void UserManager::on_get_user(telegram_api::object_ptr<telegram_api::User> &&use
   if (is_verified != u->is_verified || is_support != u->is_support || is_bot != u->is_bot ||
       can_join_groups != u->can_join_groups || can_read_all_group_messages != u->can_read_all_group_messages ||
       is_scam != u->is_scam || is_fake != u->is_fake || is_inline_bot != u->is_inline_bot ||
-      is_business_bot != u->is_business_bot || inline_query_placeholder != u->inline_query_placeholder ||
+      is_business_bot != u->is_business_bot ||
+      inline_query_placeholder != get_user_extra_info(u).inline_query_placeholder ||
       need_location_bot != u->need_location_bot || can_be_added_to_attach_menu != u->can_be_added_to_attach_menu) {
     if (is_bot != u->is_bot) {
       LOG_IF(ERROR, !is_deleted && !u->is_deleted && u->is_received)
@@ -2424,7 +2435,9 @@ void UserManager::on_get_user(telegram_api::object_ptr<telegram_api::User> &&use
     u->is_fake = is_fake;
     u->is_inline_bot = is_inline_bot;
     u->is_business_bot = is_business_bot;
-    u->inline_query_placeholder = std::move(inline_query_placeholder);
+    if (inline_query_placeholder != get_user_extra_info(u).inline_query_placeholder) {
+      add_user_extra_info(u).inline_query_placeholder = std::move(inline_query_placeholder);
+    }
     u->need_location_bot = need_location_bot;
     u->can_be_added_to_attach_menu = can_be_added_to_attach_menu;
 
@@ -2481,10 +2494,10 @@ void UserManager::on_get_user(telegram_api::object_ptr<telegram_api::User> &&use
   bool has_language_code = (flags & USER_FLAG_HAS_LANGUAGE_CODE) != 0;
   LOG_IF(ERROR, has_language_code && !td_->auth_manager_->is_bot())
       << "Receive language code for " << user_id << " from " << source;
-  if (u->language_code != user->lang_code_ && !user->lang_code_.empty()) {
-    u->language_code = user->lang_code_;
+  if (get_user_extra_info(u).language_code != user->lang_code_ && !user->lang_code_.empty()) {
+    add_user_extra_info(u).language_code = user->lang_code_;
 
-    LOG(DEBUG) << "Language code has changed for " << user_id << " to " << u->language_code;
+    LOG(DEBUG) << "Language code has changed for " << user_id << " to " << user->lang_code_;
     u->is_changed = true;
   }
 
@@ -2526,8 +2539,8 @@ void UserManager::on_get_user(telegram_api::object_ptr<telegram_api::User> &&use
       on_update_user_story_ids_impl(u, user_id, StoryId(user->stories_max_id_), StoryId());
     }
     auto restriction_reasons = get_restriction_reasons(std::move(user->restriction_reason_));
-    if (restriction_reasons != u->restriction_reasons) {
-      u->restriction_reasons = std::move(restriction_reasons);
+    if (restriction_reasons != get_user_extra_info(u).restriction_reasons) {
+      add_user_extra_info(u).restriction_reasons = std::move(restriction_reasons);
       u->is_changed = true;
     }
   }
@@ -2794,7 +2807,7 @@ void UserManager::register_user_photo(User *u, UserId user_id, const Photo &phot
   CHECK(file_type == FileType::Photo);
   CHECK(u != nullptr);
   auto photo_id = photo.id.get();
-  if (photo_id != 0 && u->photo_ids.emplace(photo_id).second) {
+  if (photo_id != 0 && add_user_extra_info(u).photo_ids.emplace(photo_id).second) {
     VLOG(file_references) << "Register photo " << photo_id << " of " << user_id;
     if (user_id == get_my_id()) {
       my_photo_file_id_[photo_id] = first_file_id;
@@ -3584,6 +3597,21 @@ UserManager::User *UserManager::get_user(UserId user_id) {
   return users_.get_pointer(user_id);
 }
 
+const UserManager::UserExtraInfo &UserManager::get_user_extra_info(const User *u) {
+  if (u->extra_info == nullptr) {
+    static const UserExtraInfo empty_info;
+    return empty_info;
+  }
+  return *u->extra_info;
+}
+
+UserManager::UserExtraInfo &UserManager::add_user_extra_info(User *u) {
+  if (u->extra_info == nullptr) {
+    u->extra_info = make_unique<UserExtraInfo>();
+  }
+  return *u->extra_info;
+}
+
 UserManager::User *UserManager::add_user(UserId user_id) {
   CHECK(user_id.is_valid());
   auto &user_ptr = users_[user_id];
@@ -5227,7 +5255,7 @@ void UserManager::on_set_personal_channel(ChannelId channel_id, Promise<Unit> &&
 }
 
 void UserManager::set_emoji_status(const EmojiStatus &emoji_status, Promise<Unit> &&promise) {
-  if (!td_->option_manager_->get_option_boolean("is_premium")) {
+  if (!td_->option_manager_->get_option_boolean(OptionId::IsPremium)) {
     return promise.set_error(Status::Error(400, "The method is available only to Telegram Premium users"));
   }
   add_recent_emoji_status(td_, emoji_status);
@@ -5475,7 +5503,7 @@ FileSourceId UserManager::get_user_profile_photo_file_source_id(UserId user_id,
   }
 
   auto u = get_user(user_id);
-  if (u != nullptr && u->photo_ids.count(photo_id) != 0) {
+  if (u != nullptr && get_user_extra_info(u).photo_ids.count(photo_id) != 0) {
     VLOG(file_references) << "Don't need to create file source for photo " << photo_id << " of " << user_id;
     // photo was already added, source ID was registered and shouldn't be needed
     return FileSourceId();
@@ -5647,7 +5675,7 @@ void UserManager::can_send_message_to_user(UserId user_id, bool force,
   }
   CHECK(user_id.is_valid());
   if ((u != nullptr && (!u->contact_require_premium || u->is_mutual_contact)) ||
-      td_->option_manager_->get_option_boolean("is_premium")) {
+      td_->option_manager_->get_option_boolean(OptionId::IsPremium)) {
     return promise.set_value(td_api::make_object<td_api::canSendMessageToUserResultOk>());
   }
 
@@ -7466,7 +7494,7 @@ void UserManager::update_user(User *u, UserId user_id, bool from_binlog, bool fr
   };
 
   if (user_id == get_my_id()) {
-    if (td_->option_manager_->get_option_boolean("is_premium") != u->is_premium) {
+    if (td_->option_manager_->get_option_boolean(OptionId::IsPremium) != u->is_premium) {
       td_->option_manager_->set_option_boolean("is_premium", u->is_premium);
       send_closure(td_->config_manager_, &ConfigManager::request_config, true);
       if (!td_->auth_manager_->is_bot()) {
@@ -7562,7 +7590,7 @@ void UserManager::update_user(User *u, UserId user_id, bool from_binlog, bool fr
     u->is_stories_hidden_changed = false;
   }
   if (!td_->auth_manager_->is_bot()) {
-    if (u->restriction_reasons.empty()) {
+    if (get_user_extra_info(u).restriction_reasons.empty()) {
       restricted_user_ids_.erase(user_id);
     } else {
       restricted_user_ids_.insert(user_id);
@@ -7624,9 +7652,11 @@ void UserManager::update_user(User *u, UserId user_id, bool from_binlog, bool fr
       u->is_status_saved = false;
     }
     CHECK(u->is_update_user_sent);
-    send_closure(
-        G()->td(), &Td::send_update,
-        td_api::make_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u, unix_time)));
+    if (!td_->is_update_ignored(td_api::updateUserStatus::ID)) {
+      send_closure(
+          G()->td(), &Td::send_update,
+          td_api::make_object<td_api::updateUserStatus>(user_id.get(), get_user_status_object(user_id, u, unix_time)));
+    }
     u->is_status_changed = false;
   }
   if (u->is_online_status_changed) {
@@ -7852,13 +7882,14 @@ td_api::object_ptr<td_api::user> UserManager::get_user_object(UserId user_id, co
   if (u == nullptr) {
     return nullptr;
   }
+  const auto &info = get_user_extra_info(u);
   td_api::object_ptr<td_api::UserType> type;
   if (u->is_deleted) {
     type = td_api::make_object<td_api::userTypeDeleted>();
   } else if (u->is_bot) {
     type = td_api::make_object<td_api::userTypeBot>(
         u->can_be_edited_bot, u->can_join_groups, u->can_read_all_group_messages, u->is_inline_bot,
-        u->inline_query_placeholder, u->need_location_bot, u->is_business_bot, u->can_be_added_to_attach_menu);
+        info.inline_query_placeholder, u->need_location_bot, u->is_business_bot, u->can_be_added_to_attach_menu);
   } else {
     type = td_api::make_object<td_api::userTypeRegular>();
   }
@@ -7875,9 +7906,9 @@ td_api::object_ptr<td_api::user> UserManager::get_user_object(UserId user_id, co
       td_->theme_manager_->get_profile_accent_color_id_object(u->profile_accent_color_id),
       u->profile_background_custom_emoji_id.get(), std::move(emoji_status), u->is_contact, u->is_mutual_contact,
       u->is_close_friend, u->is_verified, u->is_premium, u->is_support,
-      get_restriction_reason_description(u->restriction_reasons), u->is_scam, u->is_fake,
+      get_restriction_reason_description(info.restriction_reasons), u->is_scam, u->is_fake,
       u->max_active_story_id.is_valid(), get_user_has_unread_stories(u), restricts_new_chats, have_access,
-      std::move(type), u->language_code, u->attach_menu_enabled);
+      std::move(type), info.language_code, u->attach_menu_enabled);
 }
 
 vector<int64> UserManager::get_user_ids_object(const vector<UserId> &user_ids, const char *source) const {
@@ -466,6 +466,15 @@ class UserManager final : public Actor {
   void get_current_state(vector<td_api::object_ptr<td_api::Update>> &updates) const;
 
  private:
+  // rarely non-empty fields of User, which are allocated only if needed
+  struct UserExtraInfo {
+    vector<RestrictionReason> restriction_reasons;
+    string inline_query_placeholder;
+    string language_code;
+
+    FlatHashSet<int64> photo_ids;
+  };
+
   struct User {
     string first_name;
     string last_name;
@@ -477,8 +486,6 @@ class UserManager final : public Actor {
 
     ProfilePhoto photo;
 
-    vector<RestrictionReason> restriction_reasons;
-    string inline_query_placeholder;
     int32 bot_info_version = -1;
 
     AccentColorId accent_color_id;
@@ -493,9 +500,7 @@ class UserManager final : public Actor {
     StoryId max_active_story_id;
     StoryId max_read_story_id;
 
-    string language_code;
-
-    FlatHashSet<int64> photo_ids;
+    unique_ptr<UserExtraInfo> extra_info;
 
     static constexpr uint32 CACHE_VERSION = 4;
     uint32 cache_version = 0;
@@ -562,6 +567,10 @@ class UserManager final : public Actor {
     void parse(ParserT &parser);
   };
 
+  static const UserExtraInfo &get_user_extra_info(const User *u);
+
+  static UserExtraInfo &add_user_extra_info(User *u);
+
   // do not forget to update drop_user_full and on_get_user_full
   struct UserFull {
     Photo photo;
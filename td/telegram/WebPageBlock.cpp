@@ -2444,6 +2444,10 @@ void store(const unique_ptr<WebPageBlock> &block, LogEventStorerCalcLength &stor
   store_web_page_block(block, storer);
 }
 
+void store(const unique_ptr<WebPageBlock> &block, LogEventStorerGrowable &storer) {
+  store_web_page_block(block, storer);
+}
+
 void store(const unique_ptr<WebPageBlock> &block, LogEventStorerUnsafe &storer) {
   store_web_page_block(block, storer);
 }
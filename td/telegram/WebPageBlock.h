@@ -91,6 +91,8 @@ class WebPageBlock {
 
 void store(const unique_ptr<WebPageBlock> &block, LogEventStorerCalcLength &storer);
 
+void store(const unique_ptr<WebPageBlock> &block, LogEventStorerGrowable &storer);
+
 void store(const unique_ptr<WebPageBlock> &block, LogEventStorerUnsafe &storer);
 
 void parse(unique_ptr<WebPageBlock> &block, LogEventParser &parser);
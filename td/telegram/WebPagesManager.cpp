@@ -518,6 +518,7 @@ WebPageId WebPagesManager::on_get_web_page(tl_object_ptr<telegram_api::WebPage>
                                                   get_web_page_file_ids(web_page_to_delete), vector<FileId>());
         }
         web_pages_.erase(web_page_id);
+        loaded_web_page_instant_views_.erase(web_page_id);
       }
 
       on_web_page_changed(web_page_id, false);
@@ -710,6 +711,7 @@ void WebPagesManager::update_web_page(unique_ptr<WebPage> web_page, WebPageId we
   }
 
   update_web_page_instant_view(web_page_id, page->instant_view_, std::move(old_instant_view));
+  on_web_page_instant_view_used(web_page_id);
 
   auto new_file_ids = get_web_page_file_ids(page.get());
   if (old_file_ids != new_file_ids) {
@@ -812,7 +814,7 @@ void WebPagesManager::on_get_web_page_instant_view_view_count(WebPageId web_page
     return;
   }
   instant_view->view_count_ = view_count;
-  if (G()->use_message_database()) {
+  if (G()->use_message_database() && instant_view->is_loaded_) {
     LOG(INFO) << "Save instant view of " << web_page_id << " to database after updating view count to " << view_count;
     G()->td_db()->get_sqlite_pmc()->set(get_web_page_instant_view_database_key(web_page_id),
                                         log_event_store(*instant_view).as_slice().str(), Auto());
@@ -1014,6 +1016,7 @@ void WebPagesManager::get_web_page_instant_view_impl(WebPageId web_page_id, bool
     reload_web_page_instant_view(web_page_id);
   }
 
+  on_web_page_instant_view_used(web_page_id);
   promise.set_value(std::move(web_page_id));
 }
 
@@ -1110,6 +1113,7 @@ void WebPagesManager::on_load_web_page_instant_view_from_database(WebPageId web_
   if (old_file_ids != new_file_ids) {
     td_->file_manager_->change_files_source(get_web_page_file_source_id(web_page), old_file_ids, new_file_ids);
   }
+  on_web_page_instant_view_used(web_page_id);
 
   update_web_page_instant_view_load_requests(web_page_id, false, web_page_id);
 }
@@ -1560,6 +1564,68 @@ const WebPagesManager::WebPageInstantView *WebPagesManager::get_web_page_instant
   return &web_page->instant_view_;
 }
 
+void WebPagesManager::on_web_page_instant_view_used(WebPageId web_page_id) {
+  if (!G()->use_message_database()) {
+    // instant views can't be reloaded from the database
+    return;
+  }
+  const WebPageInstantView *web_page_instant_view = get_web_page_instant_view(web_page_id);
+  if (web_page_instant_view == nullptr || !web_page_instant_view->is_loaded_) {
+    return;
+  }
+
+  loaded_web_page_instant_views_[web_page_id] = ++current_instant_view_use_time_;
+  if (loaded_web_page_instant_views_.size() > MAX_LOADED_INSTANT_VIEW_COUNT) {
+    unload_least_recently_used_web_page_instant_view();
+  }
+}
+
+void WebPagesManager::unload_least_recently_used_web_page_instant_view() {
+  WebPageId unloaded_web_page_id;
+  int64 min_use_time = std::numeric_limits<int64>::max();
+  vector<WebPageId> unloaded_web_page_ids;
+  for (const auto &it : loaded_web_page_instant_views_) {
+    auto web_page_id = it.first;
+    const WebPageInstantView *web_page_instant_view = get_web_page_instant_view(web_page_id);
+    if (web_page_instant_view == nullptr || !web_page_instant_view->is_loaded_) {
+      unloaded_web_page_ids.push_back(web_page_id);
+      continue;
+    }
+    if (!web_page_instant_view->was_loaded_from_database_ ||
+        load_web_page_instant_view_queries_.count(web_page_id) != 0) {
+      // the instant view isn't saved to the database yet
+      continue;
+    }
+    if (it.second < min_use_time) {
+      min_use_time = it.second;
+      unloaded_web_page_id = web_page_id;
+    }
+  }
+  for (auto web_page_id : unloaded_web_page_ids) {
+    loaded_web_page_instant_views_.erase(web_page_id);
+  }
+  if (!unloaded_web_page_id.is_valid()) {
+    return;
+  }
+  loaded_web_page_instant_views_.erase(unloaded_web_page_id);
+
+  LOG(INFO) << "Unload instant view of " << unloaded_web_page_id;
+  WebPage *web_page = web_pages_.get_pointer(unloaded_web_page_id);
+  CHECK(web_page != nullptr);
+  auto old_file_ids = get_web_page_file_ids(web_page);
+
+  // the instant view will be loaded from the database on the next request
+  auto &instant_view = web_page->instant_view_;
+  Scheduler::instance()->destroy_on_scheduler(G()->get_gc_scheduler_id(), instant_view.page_blocks_);
+  instant_view.is_loaded_ = false;
+  instant_view.was_loaded_from_database_ = false;
+
+  auto new_file_ids = get_web_page_file_ids(web_page);
+  if (old_file_ids != new_file_ids) {
+    td_->file_manager_->change_files_source(get_web_page_file_source_id(web_page), old_file_ids, new_file_ids);
+  }
+}
+
 void WebPagesManager::on_pending_web_page_timeout_callback(void *web_pages_manager_ptr, int64 web_page_id_int) {
   if (G()->close_flag()) {
     return;
@@ -1587,8 +1653,11 @@ void WebPagesManager::on_pending_web_page_timeout(WebPageId web_page_id) {
       count++;
     }
     if (!message_full_ids.empty()) {
-      send_closure_later(G()->messages_manager(), &MessagesManager::get_messages_from_server,
-                         std::move(message_full_ids), Promise<Unit>(), "on_pending_web_page_timeout", nullptr);
+      // timeouts of web pages received together expire together, so reload their messages in one batch
+      if (pending_web_page_reload_message_full_ids_.empty()) {
+        send_closure_later(actor_id(this), &WebPagesManager::reload_pending_web_page_messages);
+      }
+      append(pending_web_page_reload_message_full_ids_, std::move(message_full_ids));
     }
   }
   auto get_it = pending_get_web_pages_.find(web_page_id);
@@ -1605,6 +1674,18 @@ void WebPagesManager::on_pending_web_page_timeout(WebPageId web_page_id) {
   }
 }
 
+void WebPagesManager::reload_pending_web_page_messages() {
+  if (G()->close_flag()) {
+    return;
+  }
+
+  auto message_full_ids = std::move(pending_web_page_reload_message_full_ids_);
+  reset_to_empty(pending_web_page_reload_message_full_ids_);
+  LOG(INFO) << "Reload " << message_full_ids.size() << " messages with pending web pages";
+  send_closure_later(G()->messages_manager(), &MessagesManager::get_messages_from_server, std::move(message_full_ids),
+                     Promise<Unit>(), "reload_pending_web_page_messages", nullptr);
+}
+
 void WebPagesManager::on_get_web_page_instant_view(WebPage *web_page, tl_object_ptr<telegram_api::page> &&page,
                                                    int32 hash, DialogId owner_dialog_id) {
   CHECK(page != nullptr);
@@ -109,6 +109,8 @@ class WebPagesManager final : public Actor {
   void on_story_changed(StoryFullId story_full_id);
 
  private:
+  static constexpr size_t MAX_LOADED_INSTANT_VIEW_COUNT = 100;  // the maximum number of instant views kept in memory
+
   class WebPage;
 
   class WebPageInstantView;
@@ -129,6 +131,10 @@ class WebPagesManager final : public Actor {
 
   const WebPageInstantView *get_web_page_instant_view(WebPageId web_page_id) const;
 
+  void on_web_page_instant_view_used(WebPageId web_page_id);
+
+  void unload_least_recently_used_web_page_instant_view();
+
   void get_web_page_instant_view_impl(WebPageId web_page_id, bool force_full, Promise<WebPageId> &&promise);
 
   tl_object_ptr<td_api::webPageInstantView> get_web_page_instant_view_object(
@@ -138,6 +144,8 @@ class WebPagesManager final : public Actor {
 
   void on_pending_web_page_timeout(WebPageId web_page_id);
 
+  void reload_pending_web_page_messages();
+
   void on_get_web_page_preview_success(unique_ptr<GetWebPagePreviewOptions> &&options, WebPageId web_page_id,
                                        Promise<td_api::object_ptr<td_api::webPage>> &&promise);
 
@@ -197,6 +205,10 @@ class WebPagesManager final : public Actor {
   };
   FlatHashMap<WebPageId, PendingWebPageInstantViewQueries, WebPageIdHash> load_web_page_instant_view_queries_;
 
+  // web pages with an instant view loaded in memory -> logical time of the last use of the instant view
+  FlatHashMap<WebPageId, int64, WebPageIdHash> loaded_web_page_instant_views_;
+  int64 current_instant_view_use_time_ = 0;
+
   FlatHashMap<WebPageId, FlatHashSet<MessageFullId, MessageFullIdHash>, WebPageIdHash> web_page_messages_;
 
   FlatHashMap<WebPageId,
@@ -211,6 +223,7 @@ class WebPagesManager final : public Actor {
   FlatHashMap<string, FileSourceId> url_to_file_source_id_;
 
   MultiTimeout pending_web_pages_timeout_{"PendingWebPagesTimeout"};
+  vector<MessageFullId> pending_web_page_reload_message_full_ids_;
 };
 
 }  // namespace td
@@ -3207,6 +3207,8 @@ class CliClient final : public Actor {
       string value;
       get_args(args, name, value);
       send_request(td_api::make_object<td_api::setOption>(name, td_api::make_object<td_api::optionValueString>(value)));
+    } else if (op == "siut") {
+      send_request(td_api::make_object<td_api::setIgnoredUpdateTypes>(autosplit_str(args)));
     } else if (op == "me") {
       send_request(td_api::make_object<td_api::getMe>());
     } else if (op == "sdmadt") {
@@ -3471,6 +3473,10 @@ class CliClient final : public Actor {
       send_request(td_api::make_object<td_api::getStorageStatisticsFast>());
     } else if (op == "database") {
       send_request(td_api::make_object<td_api::getDatabaseStatistics>());
+    } else if (op == "message_cache") {
+      send_request(td_api::make_object<td_api::getMessageCacheStatistics>());
+    } else if (op == "reduce_memory") {
+      send_request(td_api::make_object<td_api::reduceMemoryUsage>());
     } else if (op == "optimize_storage" || op == "optimize_storage_all") {
       string chat_ids;
       string exclude_chat_ids;
@@ -3509,6 +3515,12 @@ class CliClient final : public Actor {
       send_request(td_api::make_object<td_api::getNetworkStatistics>(true));
     } else if (op == "reset_network") {
       send_request(td_api::make_object<td_api::resetNetworkStatistics>());
+    } else if (op == "network_latency" || op == "reset_network_latency") {
+      send_request(td_api::make_object<td_api::getNetworkRequestLatencyStatistics>(op == "reset_network_latency"));
+    } else if (op == "network_rate_limits") {
+      send_request(td_api::make_object<td_api::getNetworkRequestRateLimits>());
+    } else if (op == "metrics") {
+      send_request(td_api::make_object<td_api::getMetrics>());
     } else if (op == "snt") {
       send_request(td_api::make_object<td_api::setNetworkType>(as_network_type(args)));
     } else if (op == "gadsp") {
@@ -4856,6 +4868,17 @@ class CliClient final : public Actor {
           chat_id,
           td_api::make_object<td_api::inputMessageText>(as_formatted_text(message), get_link_preview_options(), true),
           op == "sms", false);
+    } else if (op == "smb") {
+      string chat_ids;
+      string message;
+      get_args(args, chat_ids, message);
+      send_request(td_api::make_object<td_api::sendMessageBroadcast>(
+          as_chat_ids(chat_ids), rand_bool(), rand_bool(),
+          td_api::make_object<td_api::inputMessageText>(as_formatted_text(message), get_link_preview_options(), true)));
+    } else if (op == "cmb") {
+      int64 broadcast_id;
+      get_args(args, broadcast_id);
+      send_request(td_api::make_object<td_api::cancelMessageBroadcast>(broadcast_id));
     } else if (op == "smce") {
       ChatId chat_id;
       get_args(args, chat_id);
@@ -6839,6 +6862,15 @@ class CliClient final : public Actor {
       } else {
         execute(std::move(request));
       }
+    } else if (op == "sasc") {
+      bool is_enabled;
+      double log_period;
+      get_args(args, is_enabled, log_period);
+      execute(td_api::make_object<td_api::setActorStatisticsCollection>(is_enabled, log_period));
+    } else if (op == "gas" || op == "gasr") {
+      execute(td_api::make_object<td_api::getActorStatistics>(op == "gasr"));
+    } else if (op == "gms") {
+      execute(td_api::make_object<td_api::getMemoryStatistics>());
     } else if (op == "alog" || op == "aloge") {
       int32 level;
       string text;
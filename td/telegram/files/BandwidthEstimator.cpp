@@ -0,0 +1,89 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/BandwidthEstimator.h"
+
+#include "td/utils/logging.h"
+
+namespace td {
+
+static constexpr double FILTER_WINDOW = 10.0;  // time during which the measured extremums are kept
+static constexpr double WINDOW_GAIN = 2.0;
+static constexpr int64 MIN_WINDOW = 128 << 10;
+static constexpr size_t MIN_PREFERRED_PART_SIZE = 64 << 10;
+static constexpr size_t MAX_PREFERRED_PART_SIZE = 512 << 10;  // must not exceed PartsManager::MAX_PART_SIZE
+static constexpr int64 PARTS_PER_WINDOW = 8;
+
+bool BandwidthEstimator::may_send(int64 size) const {
+  auto window = get_window();
+  return window == 0 || in_flight_ + size <= window;
+}
+
+BandwidthEstimator::SendState BandwidthEstimator::on_send(int64 size, double now) {
+  if (in_flight_ == 0) {
+    // the path was idle, so delivery rate must be measured from now
+    delivered_at_ = now;
+  }
+  in_flight_ += size;
+
+  SendState state;
+  state.size_ = size;
+  state.sent_at_ = now;
+  state.delivered_ = delivered_;
+  state.delivered_at_ = delivered_at_;
+  return state;
+}
+
+void BandwidthEstimator::on_delivered(const SendState &send_state, double now) {
+  on_lost(send_state);
+  delivered_ += send_state.size_;
+  delivered_at_ = now;
+
+  auto rtt = now - send_state.sent_at_;
+  if (rtt > 0 && (min_rtt_ == 0.0 || rtt <= min_rtt_ || now - min_rtt_at_ > FILTER_WINDOW)) {
+    min_rtt_ = rtt;
+    min_rtt_at_ = now;
+  }
+
+  // delivery rate is measured over the time, during which the part was in flight,
+  // but not less than the round-trip time to avoid overestimation because of batched responses
+  auto interval = max(now - send_state.delivered_at_, min_rtt_);
+  if (interval <= 0) {
+    return;
+  }
+  auto bandwidth = static_cast<double>(delivered_ - send_state.delivered_) / interval;
+  if (bandwidth >= max_bandwidth_ || now - max_bandwidth_at_ > FILTER_WINDOW) {
+    max_bandwidth_ = bandwidth;
+    max_bandwidth_at_ = now;
+  }
+}
+
+void BandwidthEstimator::on_lost(const SendState &send_state) {
+  in_flight_ -= send_state.size_;
+  LOG_CHECK(in_flight_ >= 0) << in_flight_ << ' ' << send_state.size_;
+}
+
+int64 BandwidthEstimator::get_window() const {
+  if (max_bandwidth_ == 0.0 || min_rtt_ == 0.0) {
+    return 0;
+  }
+  return max(static_cast<int64>(WINDOW_GAIN * max_bandwidth_ * min_rtt_), MIN_WINDOW);
+}
+
+size_t BandwidthEstimator::get_preferred_part_size() const {
+  auto window = get_window();
+  if (window == 0) {
+    return 0;
+  }
+  // the window must contain enough parts for them to be spread over all connections
+  size_t part_size = MIN_PREFERRED_PART_SIZE;
+  while (part_size < MAX_PREFERRED_PART_SIZE && static_cast<int64>(part_size) * 2 * PARTS_PER_WINDOW <= window) {
+    part_size *= 2;
+  }
+  return part_size;
+}
+
+}  // namespace td
@@ -0,0 +1,58 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// BBR-like estimator of bottleneck bandwidth and round-trip time of a path to a DC
+// it is shared between all file loaders, which use the path, and must be used only from the scheduler of the loaders
+class BandwidthEstimator {
+ public:
+  struct SendState {
+    int64 size_ = 0;
+    double sent_at_ = 0.0;
+    int64 delivered_ = 0;
+    double delivered_at_ = 0.0;
+  };
+
+  // returns true, if a part of the given size can be sent without exceeding the estimated in-flight window
+  bool may_send(int64 size) const;
+
+  SendState on_send(int64 size, double now);
+
+  void on_delivered(const SendState &send_state, double now);
+
+  void on_lost(const SendState &send_state);
+
+  // returns maximum number of bytes, which can be in flight, or 0 if the path wasn't measured yet
+  int64 get_window() const;
+
+  // returns preferred part size for the next downloads or 0 if the path wasn't measured yet
+  size_t get_preferred_part_size() const;
+
+  double get_bandwidth() const {
+    return max_bandwidth_;
+  }
+
+  double get_min_rtt() const {
+    return min_rtt_;
+  }
+
+ private:
+  int64 in_flight_ = 0;
+  int64 delivered_ = 0;
+  double delivered_at_ = 0.0;
+
+  double max_bandwidth_ = 0.0;
+  double max_bandwidth_at_ = 0.0;
+  double min_rtt_ = 0.0;
+  double min_rtt_at_ = 0.0;
+};
+
+}  // namespace td
@@ -8,58 +8,149 @@
 
 #include "td/utils/common.h"
 #include "td/utils/misc.h"
-#include "td/utils/ScopeGuard.h"
+
+#include <algorithm>
 
 namespace td {
 
-Bitmask::Bitmask(Decode, Slice data) : data_(zero_one_decode(data)) {
+namespace {
+
+// produces the same result as zero_one_encode applied to the sequence of appended bytes
+class ZeroOneEncoder {
+ public:
+  void append(uint8 c, int64 count) {
+    if (count <= 0) {
+      return;
+    }
+    if (c != 0 && c != 0xff) {
+      flush();
+      while (count-- > 0) {
+        result_ += static_cast<char>(c);
+      }
+      return;
+    }
+    if (run_count_ != 0 && run_byte_ != c) {
+      flush();
+    }
+    run_byte_ = c;
+    run_count_ += count;
+  }
+
+  string finish() {
+    flush();
+    return std::move(result_);
+  }
+
+ private:
+  string result_;
+  uint8 run_byte_ = 0;
+  int64 run_count_ = 0;
+
+  void flush() {
+    while (run_count_ > 0) {
+      auto cnt = min(run_count_, static_cast<int64>(250));
+      result_ += static_cast<char>(run_byte_);
+      result_ += static_cast<char>(cnt);
+      run_count_ -= cnt;
+    }
+  }
+};
+
+uint8 get_bits_mask(int64 begin_bit, int64 end_bit) {
+  return static_cast<uint8>((0xff << begin_bit) & (0xff >> (8 - end_bit)));
 }
 
-Bitmask::Bitmask(Ones, int64 count) : data_(narrow_cast<size_t>((count + 7) / 8), '\0') {
-  for (int64 i = 0; i < count; i++) {
-    set(i);
+}  // namespace
+
+Bitmask::Bitmask(Decode, Slice data) {
+  int64 byte_pos = 0;
+  auto add_byte = [&](uint8 c) {
+    for (int bit = 0; bit < 8; bit++) {
+      if ((c & (1 << bit)) != 0) {
+        append(byte_pos * 8 + bit, byte_pos * 8 + bit + 1);
+      }
+    }
+    byte_pos++;
+  };
+  for (size_t n = data.size(), i = 0; i < n; i++) {
+    auto c = static_cast<uint8>(data[i]);
+    if ((c == 0 || c == 0xff) && i + 1 < n) {
+      auto cnt = static_cast<int64>(static_cast<uint8>(data[i + 1]));
+      if (c == 0xff) {
+        append(byte_pos * 8, (byte_pos + cnt) * 8);
+      }
+      byte_pos += cnt;
+      i++;
+      continue;
+    }
+    add_byte(c);
   }
 }
 
+Bitmask::Bitmask(Ones, int64 count) {
+  append(0, count);
+}
+
+void Bitmask::append(int64 begin, int64 end) {
+  if (begin >= end) {
+    return;
+  }
+  if (!ranges_.empty() && ranges_.back().end == begin) {
+    ranges_.back().end = end;
+  } else {
+    CHECK(ranges_.empty() || ranges_.back().end < begin);
+    ranges_.push_back(Range{begin, end});
+  }
+}
+
+vector<Bitmask::Range>::const_iterator Bitmask::find(int64 offset_part) const {
+  // the first range, which ends after the part
+  return std::upper_bound(ranges_.begin(), ranges_.end(), offset_part,
+                          [](int64 offset_part, const Range &range) { return offset_part < range.end; });
+}
+
 Bitmask Bitmask::compress(int k) const {
   Bitmask res;
-  for (int64 i = 0; i * k < size(); i++) {
-    bool f = true;
-    for (int64 j = 0; j < k && f; j++) {
-      f &= get(i * k + j);
-    }
-    if (f) {
-      res.set(i);
-    }
+  for (auto &range : ranges_) {
+    res.append((range.begin + k - 1) / k, range.end / k);
   }
   return res;
 }
 
-std::string Bitmask::encode(int32 prefix_count) {
-  // remove zeroes at the end to make encoding deterministic
-  Slice data(data_);
-
-  int save_i = -1;
-  char save_c;
-  if (prefix_count != -1) {
-    auto truncated_size = (prefix_count + 7) / 8;
-    data.truncate(truncated_size);
-    if (prefix_count % 8 != 0) {
-      save_i = truncated_size - 1;
-      save_c = data_[save_i];
-      auto mask = 0xff >> (8 - prefix_count % 8);
-      data_[save_i] = static_cast<char>(data_[save_i] & mask);
+std::string Bitmask::encode(int32 prefix_count) const {
+  // zeroes at the end are never encoded to make encoding deterministic
+  ZeroOneEncoder encoder;
+  int64 byte_pos = 0;  // the byte being filled
+  uint8 byte = 0;
+  for (auto range : ranges_) {
+    if (prefix_count != -1) {
+      if (range.begin >= prefix_count) {
+        break;
+      }
+      range.end = min(range.end, static_cast<int64>(prefix_count));
     }
-  }
-  SCOPE_EXIT {
-    if (save_i != -1) {
-      data_[save_i] = save_c;
+    auto first_byte = range.begin / 8;
+    auto last_byte = (range.end - 1) / 8;
+    if (first_byte > byte_pos) {
+      encoder.append(byte, 1);
+      encoder.append(0, first_byte - byte_pos - 1);
+      byte_pos = first_byte;
+      byte = 0;
     }
-  };
-  while (!data.empty() && data.back() == '\0') {
-    data.remove_suffix(1);
+    if (first_byte == last_byte) {
+      byte |= get_bits_mask(range.begin % 8, (range.end - 1) % 8 + 1);
+      continue;
+    }
+    byte |= get_bits_mask(range.begin % 8, 8);
+    encoder.append(byte, 1);
+    encoder.append(0xff, last_byte - first_byte - 1);
+    byte_pos = last_byte;
+    byte = get_bits_mask(0, (range.end - 1) % 8 + 1);
+  }
+  if (byte != 0) {
+    encoder.append(byte, 1);
   }
-  return zero_one_encode(data);
+  return encoder.finish();
 }
 
 int64 Bitmask::get_ready_prefix_size(int64 offset, int64 part_size, int64 file_size) const {
@@ -89,46 +180,40 @@ int64 Bitmask::get_ready_prefix_size(int64 offset, int64 part_size, int64 file_s
 
 int64 Bitmask::get_total_size(int64 part_size, int64 file_size) const {
   int64 res = 0;
-  for (int64 i = 0; i < size(); i++) {
-    if (get(i)) {
-      auto from = i * part_size;
-      auto to = from + part_size;
-      if (file_size != 0 && file_size < to) {
-        to = file_size;
-      }
-      if (from < to) {
-        res += to - from;
-      }
+  for (auto &range : ranges_) {
+    auto from = range.begin * part_size;
+    auto to = range.end * part_size;
+    if (file_size != 0 && file_size < to) {
+      to = file_size;
     }
+    if (from >= to) {
+      break;
+    }
+    res += to - from;
   }
   return res;
 }
 
 bool Bitmask::get(int64 offset_part) const {
-  if (offset_part < 0) {
-    return false;
-  }
-  auto index = narrow_cast<size_t>(offset_part / 8);
-  if (index >= data_.size()) {
-    return false;
-  }
-  return (static_cast<uint8>(data_[index]) & (1 << static_cast<int>(offset_part % 8))) != 0;
+  return get_ready_parts(offset_part) != 0;
 }
 
 int64 Bitmask::get_ready_parts(int64 offset_part) const {
-  int64 res = 0;
-  while (get(offset_part + res)) {
-    res++;
+  if (offset_part < 0) {
+    return 0;
   }
-  return res;
+  auto it = find(offset_part);
+  if (it == ranges_.end() || it->begin > offset_part) {
+    return 0;
+  }
+  return it->end - offset_part;
 }
 
 std::vector<int32> Bitmask::as_vector() const {
   std::vector<int32> res;
-  auto size = narrow_cast<int32>(data_.size() * 8);
-  for (int32 i = 0; i < size; i++) {
-    if (get(i)) {
-      res.push_back(i);
+  for (auto &range : ranges_) {
+    for (auto i = range.begin; i < range.end; i++) {
+      res.push_back(narrow_cast<int32>(i));
     }
   }
   return res;
@@ -136,35 +221,50 @@ std::vector<int32> Bitmask::as_vector() const {
 
 void Bitmask::set(int64 offset_part) {
   CHECK(offset_part >= 0);
-  auto need_size = narrow_cast<size_t>(offset_part / 8 + 1);
-  if (need_size > data_.size()) {
-    data_.resize(need_size, '\0');
+  auto it = ranges_.begin() + (find(offset_part - 1) - ranges_.begin());
+  if (it != ranges_.end() && it->begin <= offset_part) {
+    if (offset_part < it->end) {
+      return;
+    }
+    // the part is right after the range
+    it->end++;
+    auto next = it + 1;
+    if (next != ranges_.end() && next->begin == it->end) {
+      it->end = next->end;
+      ranges_.erase(next);
+    }
+    return;
+  }
+  if (it != ranges_.end() && it->begin == offset_part + 1) {
+    it->begin--;
+    return;
   }
-  data_[need_size - 1] = static_cast<char>(data_[need_size - 1] | (1 << (offset_part % 8)));
+  ranges_.insert(it, Range{offset_part, offset_part + 1});
 }
 
 int64 Bitmask::size() const {
-  return static_cast<int64>(data_.size()) * 8;
+  if (ranges_.empty()) {
+    return 0;
+  }
+  return (ranges_.back().end + 7) / 8 * 8;
 }
 
 StringBuilder &operator<<(StringBuilder &sb, const Bitmask &mask) {
-  bool prev = false;
-  int32 cnt = 0;
-  for (int64 i = 0; i <= mask.size(); i++) {
-    bool cur = mask.get(i);
-    if (cur != prev) {  // zeros at the end are intentionally skipped
-      if (cnt < 5) {
-        while (cnt > 0) {
-          sb << (prev ? '1' : '0');
-          cnt--;
-        }
-      } else {
-        sb << (prev ? '1' : '0') << "(x" << cnt << ')';
-        cnt = 0;
+  auto print_run = [&sb](char c, int64 cnt) {
+    if (cnt < 5) {
+      while (cnt > 0) {
+        sb << c;
+        cnt--;
       }
+    } else {
+      sb << c << "(x" << cnt << ')';
     }
-    prev = cur;
-    cnt++;
+  };
+  int64 end = 0;
+  for (auto &range : mask.ranges_) {  // zeros at the end are intentionally skipped
+    print_run('0', range.begin - end);
+    print_run('1', range.end - range.begin);
+    end = range.end;
   }
   return sb;
 }
@@ -12,6 +12,7 @@
 
 namespace td {
 
+// set of ready parts, stored as sorted disjoint non-adjacent ranges of part numbers
 class Bitmask {
  public:
   struct Decode {};
@@ -19,7 +20,7 @@ class Bitmask {
   Bitmask() = default;
   Bitmask(Decode, Slice data);
   Bitmask(Ones, int64 count);
-  std::string encode(int32 prefix_count = -1);
+  std::string encode(int32 prefix_count = -1) const;
   int64 get_ready_prefix_size(int64 offset, int64 part_size, int64 file_size) const;
   int64 get_total_size(int64 part_size, int64 file_size) const;
   bool get(int64 offset_part) const;
@@ -33,7 +34,17 @@ class Bitmask {
   Bitmask compress(int k) const;
 
  private:
-  std::string data_;
+  struct Range {
+    int64 begin;
+    int64 end;
+  };
+  vector<Range> ranges_;
+
+  vector<Range>::const_iterator find(int64 offset_part) const;
+
+  void append(int64 begin, int64 end);
+
+  friend StringBuilder &operator<<(StringBuilder &sb, const Bitmask &mask);
 };
 
 StringBuilder &operator<<(StringBuilder &sb, const Bitmask &mask);
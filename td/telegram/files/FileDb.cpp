@@ -26,9 +26,12 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 
+#include <utility>
+
 namespace td {
 
 Status drop_file_db(SqliteDb &db, int32 version) {
@@ -65,25 +68,131 @@ class FileDb final : public FileDbInterface {
     }
 
     void close(Promise<> promise) {
+      process_pending_file_data_loads();
+      do_flush();
       file_kv_safe_.reset();
       LOG(INFO) << "FileDb is closed";
       promise.set_value(Unit());
       stop();
     }
 
-    void load_file_data(const string &key, Promise<FileData> promise) {
-      promise.set_result(load_file_data_impl(actor_id(this), file_pmc(), key, max_file_db_id_));
+    void load_file_data(string key, Promise<FileData> promise) {
+      // concurrent requests for files are answered in one read transaction after all already received requests
+      // are handled
+      if (pending_file_data_loads_.empty()) {
+        send_closure_later(actor_id(this), &FileDbActor::process_pending_file_data_loads);
+      }
+      pending_file_data_loads_.emplace_back(std::move(key), std::move(promise));
     }
 
     void clear_file_data(FileDbId file_db_id, const string &remote_key, const string &local_key,
                          const string &generate_key) {
+      add_write_query([this, file_db_id, remote_key, local_key, generate_key](Unit) {
+        do_clear_file_data(file_db_id, remote_key, local_key, generate_key);
+      });
+    }
+
+    void store_file_data(FileDbId file_db_id, const string &file_data, const string &remote_key,
+                         const string &local_key, const string &generate_key) {
+      add_write_query([this, file_db_id, file_data, remote_key, local_key, generate_key](Unit) {
+        do_store_file_data(file_db_id, file_data, remote_key, local_key, generate_key);
+      });
+    }
+
+    void store_file_data_ref(FileDbId file_db_id, FileDbId new_file_db_id) {
+      add_write_query([this, file_db_id, new_file_db_id](Unit) {
+        update_max_file_db_id(file_db_id);
+        do_store_file_data_ref(file_db_id, new_file_db_id);
+      });
+    }
+
+    void optimize_refs(std::vector<FileDbId> file_db_ids, FileDbId main_file_db_id) {
+      LOG(INFO) << "Optimize " << file_db_ids.size() << " file_db_ids in file database to " << main_file_db_id.get();
+      add_write_query([this, file_db_ids = std::move(file_db_ids), main_file_db_id](Unit) {
+        for (size_t i = 0; i + 1 < file_db_ids.size(); i++) {
+          do_store_file_data_ref(file_db_ids[i], main_file_db_id);
+        }
+      });
+    }
+
+   private:
+    // writes are batched into one transaction to speed up registration of many files at once
+    static constexpr size_t MAX_PENDING_QUERIES_COUNT{1000};
+    static constexpr double MAX_PENDING_QUERIES_DELAY{0.01};
+
+    FileDbId max_file_db_id_;
+    std::shared_ptr<SqliteKeyValueSafe> file_kv_safe_;
+    vector<Promise<Unit>> pending_writes_;
+    double wakeup_at_ = 0;
+    vector<std::pair<string, Promise<FileData>>> pending_file_data_loads_;
+
+    SqliteKeyValue &file_pmc() {
+      return file_kv_safe_->get();
+    }
+
+    void process_pending_file_data_loads() {
+      if (pending_file_data_loads_.empty()) {
+        return;
+      }
+      auto loads = std::move(pending_file_data_loads_);
+      pending_file_data_loads_.clear();
+      do_flush();
+
+      // a single transaction is much faster than a separate implicit transaction for each lookup
+      auto &pmc = file_pmc();
+      pmc.begin_read_transaction().ensure();
+      for (auto &load : loads) {
+        load.second.set_result(load_file_data_impl(actor_id(this), pmc, load.first, max_file_db_id_));
+      }
+      pmc.commit_transaction().ensure();
+    }
+
+    template <class F>
+    void add_write_query(F &&f) {
+      process_pending_file_data_loads();
+      pending_writes_.push_back(PromiseCreator::lambda(std::forward<F>(f)));
+      if (pending_writes_.size() > MAX_PENDING_QUERIES_COUNT) {
+        do_flush();
+        wakeup_at_ = 0;
+      } else if (wakeup_at_ == 0) {
+        wakeup_at_ = Time::now_cached() + MAX_PENDING_QUERIES_DELAY;
+      }
+      if (wakeup_at_ != 0) {
+        set_timeout_at(wakeup_at_);
+      }
+    }
+
+    void do_flush() {
+      wakeup_at_ = 0;
+      if (pending_writes_.empty()) {
+        return;
+      }
       auto &pmc = file_pmc();
       pmc.begin_write_transaction().ensure();
+      set_promises(pending_writes_);
+      pmc.commit_transaction().ensure();
+      cancel_timeout();
+    }
+
+    void timeout_expired() final {
+      do_flush();
+    }
+
+    void tear_down() final {
+      do_flush();
+    }
 
+    void update_max_file_db_id(FileDbId file_db_id) {
       if (file_db_id > max_file_db_id_) {
-        pmc.set("file_id", to_string(file_db_id.get()));
+        file_pmc().set("file_id", to_string(file_db_id.get()));
         max_file_db_id_ = file_db_id;
       }
+    }
+
+    void do_clear_file_data(FileDbId file_db_id, const string &remote_key, const string &local_key,
+                            const string &generate_key) {
+      auto &pmc = file_pmc();
+      update_max_file_db_id(file_db_id);
 
       pmc.erase(PSTRING() << "file" << file_db_id.get());
       // LOG(DEBUG) << "ERASE " << format::as_hex_dump<4>(Slice(PSLICE() << "file" << file_db_id.get()));
@@ -99,19 +208,12 @@ class FileDb final : public FileDbInterface {
       if (!generate_key.empty()) {
         pmc.erase(generate_key);
       }
-
-      pmc.commit_transaction().ensure();
     }
 
-    void store_file_data(FileDbId file_db_id, const string &file_data, const string &remote_key,
-                         const string &local_key, const string &generate_key) {
+    void do_store_file_data(FileDbId file_db_id, const string &file_data, const string &remote_key,
+                            const string &local_key, const string &generate_key) {
       auto &pmc = file_pmc();
-      pmc.begin_write_transaction().ensure();
-
-      if (file_db_id > max_file_db_id_) {
-        pmc.set("file_id", to_string(file_db_id.get()));
-        max_file_db_id_ = file_db_id;
-      }
+      update_max_file_db_id(file_db_id);
 
       pmc.set(PSTRING() << "file" << file_db_id.get(), file_data);
 
@@ -124,40 +226,6 @@ class FileDb final : public FileDbInterface {
       if (!generate_key.empty()) {
         pmc.set(generate_key, to_string(file_db_id.get()));
       }
-
-      pmc.commit_transaction().ensure();
-    }
-
-    void store_file_data_ref(FileDbId file_db_id, FileDbId new_file_db_id) {
-      auto &pmc = file_pmc();
-      pmc.begin_write_transaction().ensure();
-
-      if (file_db_id > max_file_db_id_) {
-        pmc.set("file_id", to_string(file_db_id.get()));
-        max_file_db_id_ = file_db_id;
-      }
-
-      do_store_file_data_ref(file_db_id, new_file_db_id);
-
-      pmc.commit_transaction().ensure();
-    }
-
-    void optimize_refs(std::vector<FileDbId> file_db_ids, FileDbId main_file_db_id) {
-      LOG(INFO) << "Optimize " << file_db_ids.size() << " file_db_ids in file database to " << main_file_db_id.get();
-      auto &pmc = file_pmc();
-      pmc.begin_write_transaction().ensure();
-      for (size_t i = 0; i + 1 < file_db_ids.size(); i++) {
-        do_store_file_data_ref(file_db_ids[i], main_file_db_id);
-      }
-      pmc.commit_transaction().ensure();
-    }
-
-   private:
-    FileDbId max_file_db_id_;
-    std::shared_ptr<SqliteKeyValueSafe> file_kv_safe_;
-
-    SqliteKeyValue &file_pmc() {
-      return file_kv_safe_->get();
     }
 
     void do_store_file_data_ref(FileDbId file_db_id, FileDbId new_file_db_id) {
@@ -23,19 +23,31 @@
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/port/IoSlice.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/UInt.h"
 
 #include <tuple>
 
 namespace td {
 
+static constexpr double MIN_DOWNLOAD_WINDOW = 1.0;
+static constexpr double INITIAL_DOWNLOAD_WINDOW = 4.0;
+static constexpr double MAX_DOWNLOAD_WINDOW = 16.0;
+static constexpr double DOWNLOAD_LATENCY_SLACK = 0.05;
+
+static constexpr size_t MAX_PENDING_WRITE_PARTS = 64;
+static constexpr int64 DROP_PAGE_CACHE_MIN_FILE_SIZE = static_cast<int64>(64) << 20;
+
 FileDownloader::FileDownloader(const FullRemoteFileLocation &remote, const LocalFileLocation &local, int64 size,
                                string name, const FileEncryptionKey &encryption_key, bool is_small,
-                               bool need_search_file, int64 offset, int64 limit, unique_ptr<Callback> callback)
+                               bool need_search_file, int64 offset, int64 limit,
+                               std::shared_ptr<BandwidthEstimator> bandwidth_estimator,
+                               std::shared_ptr<SpeedLimiter> speed_limiter, unique_ptr<Callback> callback)
     : remote_(remote)
     , local_(local)
     , size_(size)
@@ -45,7 +57,9 @@ FileDownloader::FileDownloader(const FullRemoteFileLocation &remote, const Local
     , is_small_(is_small)
     , need_search_file_(need_search_file)
     , offset_(offset)
-    , limit_(limit) {
+    , limit_(limit)
+    , bandwidth_estimator_(std::move(bandwidth_estimator))
+    , speed_limiter_(std::move(speed_limiter)) {
   if (encryption_key.is_secret()) {
     set_ordered_flag(true);
   }
@@ -120,6 +134,19 @@ Result<FileLoader::FileInfo> FileDownloader::init() {
        file_type == FileType::VideoStory || (file_type == FileType::Encrypted && size_ > (1 << 20)));
   res.offset = offset_;
   res.limit = limit_;
+  if (bandwidth_estimator_ != nullptr) {
+    // use bigger parts on high-BDP paths, unless the file is streamed from some offset
+    if (part_size == 0 && !is_small_ && offset_ == 0) {
+      res.min_part_size = bandwidth_estimator_->get_preferred_part_size();
+    }
+    res.bandwidth_estimator = bandwidth_estimator_;
+  }
+  res.speed_limiter = speed_limiter_;
+
+  use_parallel_download_ = !is_small_ && !only_check_ && G()->get_option_boolean("use_parallel_file_download");
+  for (auto &source : download_sources_) {
+    source.window_ = INITIAL_DOWNLOAD_WINDOW;
+  }
   return res;
 }
 
@@ -151,6 +178,8 @@ void FileDownloader::on_error(Status status) {
 }
 
 Result<bool> FileDownloader::should_restart_part(Part part, const NetQueryPtr &net_query) {
+  on_part_finished(part, net_query);
+
   // Check if we should use CDN or reupload file to CDN
 
   if (net_query->is_error()) {
@@ -240,11 +269,13 @@ Result<std::pair<NetQueryPtr, bool>> FileDownloader::start_part(Part part, int32
 
   auto net_query_type = is_small_ ? NetQuery::Type::DownloadSmall : NetQuery::Type::Download;
   NetQueryPtr net_query;
-  if (!use_cdn_) {
+  auto source = choose_download_source();
+  if (source == DownloadSource::Origin) {
     int32 flags = 0;
 #if !TD_EMSCRIPTEN
     // CDN is supported, unless we use domains instead of IPs from a browser
-    if (streaming_offset == 0) {
+    // the part must be sent by the original DC itself if the file is already downloaded from a CDN in parallel
+    if (streaming_offset == 0 && !use_cdn_) {
       flags |= telegram_api::upload_getFile::CDN_SUPPORTED_MASK;
     }
 #endif
@@ -262,6 +293,7 @@ Result<std::pair<NetQueryPtr, bool>> FileDownloader::start_part(Part part, int32
                   telegram_api::upload_getFile(flags, false /*ignored*/, false /*ignored*/,
                                                remote_.as_input_file_location(), part.offset, narrow_cast<int32>(size)),
                   {}, dc_id, net_query_type, NetQuery::AuthFlag::On);
+    on_part_started(part, source);
   } else {
     if (remote_.is_web()) {
       return Status::Error("Can't download web file from CDN");
@@ -273,6 +305,7 @@ Result<std::pair<NetQueryPtr, bool>> FileDownloader::start_part(Part part, int32
       net_query =
           G()->net_query_creator().create(UniqueId::next(UniqueId::Type::Default, static_cast<uint8>(QueryType::CDN)),
                                           nullptr, query, {}, cdn_dc_id_, net_query_type, NetQuery::AuthFlag::Off);
+      on_part_started(part, source);
     } else {
       auto query = telegram_api::upload_reuploadCdnFile(BufferSlice(cdn_file_token_), BufferSlice(it->second));
       net_query = G()->net_query_creator().create(
@@ -285,6 +318,87 @@ Result<std::pair<NetQueryPtr, bool>> FileDownloader::start_part(Part part, int32
   return std::make_pair(std::move(net_query), false);
 }
 
+bool FileDownloader::is_download_source_available(DownloadSource source) const {
+  switch (source) {
+    case DownloadSource::Origin:
+      return !use_cdn_ || use_parallel_download_;
+    case DownloadSource::Cdn:
+      return use_cdn_;
+    default:
+      UNREACHABLE();
+      return false;
+  }
+}
+
+bool FileDownloader::may_start_part() const {
+  if (!use_parallel_download_) {
+    return true;
+  }
+  for (int32 i = 0; i < static_cast<int32>(DownloadSource::Size); i++) {
+    const auto &state = download_sources_[i];
+    if (is_download_source_available(static_cast<DownloadSource>(i)) && state.active_part_count_ < state.window_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+FileDownloader::DownloadSource FileDownloader::choose_download_source() const {
+  if (!is_download_source_available(DownloadSource::Cdn)) {
+    return DownloadSource::Origin;
+  }
+  if (!is_download_source_available(DownloadSource::Origin)) {
+    return DownloadSource::Cdn;
+  }
+
+  // choose the source with the least loaded congestion window
+  const auto &origin = download_sources_[static_cast<int32>(DownloadSource::Origin)];
+  const auto &cdn = download_sources_[static_cast<int32>(DownloadSource::Cdn)];
+  if (origin.active_part_count_ * cdn.window_ < cdn.active_part_count_ * origin.window_) {
+    return DownloadSource::Origin;
+  }
+  return DownloadSource::Cdn;
+}
+
+void FileDownloader::on_part_started(Part part, DownloadSource source) {
+  if (!use_parallel_download_) {
+    return;
+  }
+  download_sources_[static_cast<int32>(source)].active_part_count_++;
+  active_parts_[part.id] = ActivePartInfo{source, Time::now()};
+}
+
+void FileDownloader::on_part_finished(Part part, const NetQueryPtr &net_query) {
+  auto it = active_parts_.find(part.id);
+  if (it == active_parts_.end()) {
+    return;
+  }
+  auto source = static_cast<int32>(it->second.source_);
+  auto &state = download_sources_[source];
+  auto latency = Time::now() - it->second.start_time_;
+  active_parts_.erase(it);
+  CHECK(state.active_part_count_ > 0);
+  state.active_part_count_--;
+
+  if (net_query->is_error()) {
+    if (net_query->error().code() != NetQuery::Error::Canceled) {
+      state.window_ = max(state.window_ * 0.5, MIN_DOWNLOAD_WINDOW);
+    }
+  } else {
+    if (state.min_latency_ == 0.0 || latency < state.min_latency_) {
+      state.min_latency_ = latency;
+    }
+    // the window grows while parts are received without noticeable queueing delay and shrinks otherwise
+    if (latency < 2 * state.min_latency_ + DOWNLOAD_LATENCY_SLACK) {
+      state.window_ = min(state.window_ + 1.0 / state.window_, MAX_DOWNLOAD_WINDOW);
+    } else {
+      state.window_ = max(state.window_ - 1.0 / state.window_, MIN_DOWNLOAD_WINDOW);
+    }
+  }
+  VLOG(file_loader) << "Update download window for source " << source << " to " << state.window_ << " after part "
+                    << part.id << " with latency " << latency;
+}
+
 Status FileDownloader::check_net_query(NetQueryPtr &net_query) {
   if (net_query->is_error()) {
     auto error = net_query->move_as_error();
@@ -366,16 +480,57 @@ Result<size_t> FileDownloader::process_part(Part part, NetQueryPtr net_query) {
                     bytes.as_mutable_slice());
   }
 
-  auto slice = bytes.as_slice().substr(0, part.size);
-  TRY_STATUS(acquire_fd());
-  LOG(INFO) << "Receive " << slice.size() << " bytes at offset " << part.offset << " for \"" << path_ << '"';
-  TRY_RESULT(written, fd_.pwrite(slice, part.offset));
-  LOG(INFO) << "Written " << written << " bytes";
+  // the part was decrypted in place, so the received buffer itself is written to the file
+  bytes.truncate(part.size);
+  auto size = bytes.size();
+  LOG(INFO) << "Receive " << size << " bytes at offset " << part.offset;
+  if (pending_write_size_ != 0 && (pending_write_offset_ + pending_write_size_ != part.offset ||
+                                   pending_write_parts_.size() >= MAX_PENDING_WRITE_PARTS)) {
+    TRY_STATUS(flush_parts());
+  }
+  if (pending_write_size_ == 0) {
+    pending_write_offset_ = part.offset;
+  }
+  pending_write_size_ += static_cast<int64>(size);
+  pending_write_parts_.push_back(std::move(bytes));
   // may write less than part.size, when size of downloadable file is unknown
-  if (written != slice.size()) {
+  return size;
+}
+
+Status FileDownloader::flush_parts() {
+  if (pending_write_parts_.empty()) {
+    return Status::OK();
+  }
+  auto parts = std::move(pending_write_parts_);
+  auto offset = pending_write_offset_;
+  auto size = pending_write_size_;
+  pending_write_parts_.clear();
+  pending_write_size_ = 0;
+
+  TRY_STATUS(acquire_fd());
+  vector<IoSlice> slices;
+  slices.reserve(parts.size());
+  for (auto &part : parts) {
+    slices.push_back(as_io_slice(part.as_slice()));
+  }
+  TRY_RESULT(written, fd_.pwritev(slices, offset));
+  LOG(INFO) << "Written " << written << " bytes from " << parts.size() << " parts at offset " << offset << " to \""
+            << path_ << '"';
+  if (static_cast<int64>(written) != size) {
     return Status::Error("Failed to save file part to the file");
   }
-  return written;
+
+  if (size_ >= DROP_PAGE_CACHE_MIN_FILE_SIZE) {
+    // writeback of the previously written range must have been already started, so its pages can be evicted;
+    // the advice for the new range starts its writeback
+    if (dropped_page_cache_size_ != 0) {
+      fd_.advise_dont_need(dropped_page_cache_offset_, dropped_page_cache_size_);
+    }
+    fd_.advise_dont_need(offset, size);
+    dropped_page_cache_offset_ = offset;
+    dropped_page_cache_size_ = size;
+  }
+  return Status::OK();
 }
 
 void FileDownloader::on_progress(Progress progress) {
@@ -6,18 +6,22 @@
 //
 #pragma once
 
+#include "td/telegram/files/BandwidthEstimator.h"
 #include "td/telegram/files/FileEncryptionKey.h"
 #include "td/telegram/files/FileLoader.h"
 #include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/SpeedLimiter.h"
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/NetQuery.h"
 #include "td/telegram/telegram_api.h"
 
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/Status.h"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <utility>
 
@@ -34,7 +38,8 @@ class FileDownloader final : public FileLoader {
 
   FileDownloader(const FullRemoteFileLocation &remote, const LocalFileLocation &local, int64 size, string name,
                  const FileEncryptionKey &encryption_key, bool is_small, bool need_search_file, int64 offset,
-                 int64 limit, unique_ptr<Callback> callback);
+                 int64 limit, std::shared_ptr<BandwidthEstimator> bandwidth_estimator,
+                 std::shared_ptr<SpeedLimiter> speed_limiter, unique_ptr<Callback> callback);
 
   // Should just implement all parent pure virtual methods.
   // Must not call any of them...
@@ -58,6 +63,8 @@ class FileDownloader final : public FileLoader {
   bool need_search_file_{false};
   int64 offset_;
   int64 limit_;
+  std::shared_ptr<BandwidthEstimator> bandwidth_estimator_;
+  std::shared_ptr<SpeedLimiter> speed_limiter_;
 
   bool use_cdn_ = false;
   DcId cdn_dc_id_;
@@ -68,6 +75,29 @@ class FileDownloader final : public FileLoader {
   std::map<int32, string> cdn_part_reupload_token_;
   std::map<int32, int32> cdn_part_file_token_generation_;
 
+  // if use_parallel_download_, parts of files redirected to a CDN are requested from both the CDN and the original DC,
+  // and number of parts in flight is limited by a congestion window, computed independently for every source
+  enum class DownloadSource : int32 { Origin, Cdn, Size };
+  struct DownloadSourceState {
+    double window_ = 0.0;
+    int32 active_part_count_ = 0;
+    double min_latency_ = 0.0;
+  };
+  struct ActivePartInfo {
+    DownloadSource source_;
+    double start_time_;
+  };
+  bool use_parallel_download_{false};
+  DownloadSourceState download_sources_[static_cast<int32>(DownloadSource::Size)];
+  std::map<int32, ActivePartInfo> active_parts_;
+
+  // received parts, which are adjacent in the file and are waiting to be written by a single system call
+  vector<BufferSlice> pending_write_parts_;
+  int64 pending_write_offset_ = 0;
+  int64 pending_write_size_ = 0;
+  int64 dropped_page_cache_offset_ = 0;
+  int64 dropped_page_cache_size_ = 0;
+
   bool need_check_{false};
   struct HashInfo {
     int64 offset;
@@ -87,6 +117,7 @@ class FileDownloader final : public FileLoader {
   Result<std::pair<NetQueryPtr, bool>> start_part(Part part, int32 part_count,
                                                   int64 streaming_offset) final TD_WARN_UNUSED_RESULT;
   Result<size_t> process_part(Part part, NetQueryPtr net_query) final TD_WARN_UNUSED_RESULT;
+  Status flush_parts() final TD_WARN_UNUSED_RESULT;
   void on_progress(Progress progress) final;
   FileLoader::Callback *get_callback() final;
   Status process_check_query(NetQueryPtr net_query) final;
@@ -99,5 +130,11 @@ class FileDownloader final : public FileLoader {
   Status acquire_fd() TD_WARN_UNUSED_RESULT;
 
   Status check_net_query(NetQueryPtr &net_query);
+
+  bool may_start_part() const final;
+  bool is_download_source_available(DownloadSource source) const;
+  DownloadSource choose_download_source() const;
+  void on_part_started(Part part, DownloadSource source);
+  void on_part_finished(Part part, const NetQueryPtr &net_query);
 };
 }  // namespace td
@@ -12,27 +12,133 @@
 #include "td/telegram/Global.h"
 
 #include "td/utils/algorithm.h"
+#include "td/utils/CancellationToken.h"
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Time.h"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 
 namespace td {
 
 int VERBOSITY_NAME(file_gc) = VERBOSITY_NAME(INFO);
 
+static constexpr size_t GC_UNLINK_BATCH_SIZE = 256;
+static constexpr size_t GC_UNLINK_THREAD_COUNT = 4;
+static constexpr size_t GC_MIN_UNLINKS_PER_THREAD = 16;
+
+// moves the least recently used files from files[begin:] to files[begin:result] without sorting all of them;
+// selects at least remove_count files and files of total size at least remove_size
+static size_t select_least_recently_used_files(vector<FullFileInfo> &files, size_t begin, size_t remove_count,
+                                               int64 remove_size) {
+  auto by_atime = [](const FullFileInfo &a, const FullFileInfo &b) {
+    return a.atime_nsec < b.atime_nsec;
+  };
+  auto lo = begin;
+  auto hi = files.size();
+  if (remove_count > 0) {
+    CHECK(remove_count <= hi - lo);
+    std::nth_element(files.begin() + lo, files.begin() + (lo + remove_count - 1), files.end(), by_atime);
+    for (size_t i = lo; i < lo + remove_count; i++) {
+      remove_size -= files[i].size;
+    }
+    lo += remove_count;
+  }
+
+  // weighted quickselect; sum of sizes of files[lo:hi] is always at least remove_size
+  while (remove_size > 0 && lo < hi) {
+    auto mid = lo + (hi - lo) / 2;
+    std::nth_element(files.begin() + lo, files.begin() + mid, files.begin() + hi, by_atime);
+    int64 left_size = 0;
+    for (size_t i = lo; i < mid; i++) {
+      left_size += files[i].size;
+    }
+    if (left_size >= remove_size) {
+      hi = mid;
+    } else {
+      remove_size -= left_size + files[mid].size;
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+static void unlink_file(const FullFileInfo &info) {
+  auto status = unlink(info.path);
+  LOG_IF(WARNING, status.is_error()) << "Failed to unlink file \"" << info.path << "\" during files GC: " << status;
+}
+
+// unlinks files[0:end] by batches in a fixed number of threads with the lowest disk priority
+// batches are taken in order, so earlier files are unlinked first; returns false if canceled
+static bool unlink_files(const vector<FullFileInfo> &files, size_t end, const CancellationToken &token) {
+  std::atomic<size_t> next_batch_begin{0};
+  auto unlink_batches = [&files, end, &token, &next_batch_begin] {
+    while (!token) {
+      auto batch_begin = next_batch_begin.fetch_add(GC_UNLINK_BATCH_SIZE, std::memory_order_relaxed);
+      if (batch_begin >= end) {
+        break;
+      }
+      auto batch_end = td::min(batch_begin + GC_UNLINK_BATCH_SIZE, end);
+      for (size_t i = batch_begin; i < batch_end; i++) {
+        unlink_file(files[i]);
+      }
+    }
+  };
+#if TD_THREAD_UNSUPPORTED
+  unlink_batches();
+#else
+  auto thread_count = td::min(GC_UNLINK_THREAD_COUNT, end / GC_MIN_UNLINKS_PER_THREAD + 1);
+  vector<td::thread> threads;
+  for (size_t thread_id = 0; thread_id < thread_count; thread_id++) {
+    threads.emplace_back([&unlink_batches] {
+#if TD_HAVE_THREAD_IO_PRIORITY
+      td::thread::set_idle_io_priority().ignore();
+#endif
+      unlink_batches();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+#endif
+  return !token;
+}
+
+int32 FileGcWorker::remove_unused_shared_files(CSlice dir, const CancellationToken &token) {
+  int32 removed_file_count = 0;
+  WalkPath::run(dir, [&](CSlice path, WalkPath::Type type) {
+    if (token) {
+      return WalkPath::Action::Abort;
+    }
+    if (type != WalkPath::Type::RegularFile) {
+      return WalkPath::Action::Continue;
+    }
+    // the only link to the file is the store entry itself
+    auto r_stat = stat(path);
+    if (r_stat.is_ok() && r_stat.ok().link_count_ == 1) {
+      auto status = unlink(path);
+      if (status.is_ok()) {
+        removed_file_count++;
+      } else {
+        LOG(WARNING) << "Failed to unlink shared file \"" << path << "\" during files GC: " << status;
+      }
+    }
+    return WalkPath::Action::Continue;
+  }).ignore();
+  return removed_file_count;
+}
+
 void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files,
                           Promise<FileGcResult> promise) {
   auto begin_time = Time::now();
   VLOG(file_gc) << "Start files GC with " << parameters;
-  // quite stupid implementations
-  // needs a lot of memory
-  // may write something more clever, but i will need at least 2 passes over the files
   // TODO update atime for all files in android (?)
 
   std::array<bool, MAX_FILE_TYPE> immune_types{{false}};
@@ -81,20 +187,19 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
     total_size += info.size;
   }
 
-  FileStats new_stats(false, parameters.dialog_limit_ != 0);
-  FileStats removed_stats(false, parameters.dialog_limit_ != 0);
+  // statistics are always split by owner dialog to be usable as storage statistics index
+  FileStats new_stats(false, true);
+  FileStats removed_stats(false, true);
 
-  auto do_remove_file = [&removed_stats](const FullFileInfo &info) {
+  auto on_file_removed = [&removed_stats](const FullFileInfo &info) {
     removed_stats.add_copy(info);
-    auto status = unlink(info.path);
-    LOG_IF(WARNING, status.is_error()) << "Failed to unlink file \"" << info.path << "\" during files GC: " << status;
     send_closure(G()->file_manager(), &FileManager::on_file_unlink,
                  FullLocalFileLocation(info.file_type, info.path, info.mtime_nsec));
   };
 
   double now = Clocks::system();
 
-  // Remove all suitable files with (atime > now - max_time_from_last_access)
+  // keep all immune files
   td::remove_if(files, [&](const FullFileInfo &info) {
     if (token_) {
       return false;
@@ -120,57 +225,54 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
       new_stats.add_copy(info);
       return true;
     }
-
-    if (static_cast<double>(info.atime_nsec) * 1e-9 < now - parameters.max_time_from_last_access_) {
-      do_remove_file(info);
-      total_removed_size += info.size;
-      remove_by_atime_cnt++;
-      return true;
-    }
     return false;
   });
   if (token_) {
     return promise.set_error(Global::request_aborted_error());
   }
 
-  // sort by max(atime, mtime)
-  std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) { return a.atime_nsec < b.atime_nsec; });
+  // move files, which were accessed too long ago, to the beginning
+  auto remove_by_atime_end = std::partition(files.begin(), files.end(), [&](const FullFileInfo &info) {
+    return static_cast<double>(info.atime_nsec) * 1e-9 < now - parameters.max_time_from_last_access_;
+  });
+  auto remove_by_atime_pos = static_cast<size_t>(remove_by_atime_end - files.begin());
+  remove_by_atime_cnt = narrow_cast<int32>(remove_by_atime_pos);
 
   // 1. Total size must be less than parameters.max_files_size_
   // 2. Total file count must be less than parameters.max_file_count_
   size_t remove_count = 0;
-  if (files.size() > parameters.max_file_count_) {
-    remove_count = files.size() - parameters.max_file_count_;
+  auto left_file_count = files.size() - remove_by_atime_pos;
+  if (left_file_count > parameters.max_file_count_) {
+    remove_count = left_file_count - parameters.max_file_count_;
   }
   int64 remove_size = -parameters.max_files_size_;
-  for (auto &file : files) {
-    remove_size += file.size;
+  for (size_t i = remove_by_atime_pos; i < files.size(); i++) {
+    remove_size += files[i].size;
   }
+  auto remove_end = select_least_recently_used_files(files, remove_by_atime_pos, remove_count, remove_size);
+  remove_by_count_cnt = narrow_cast<int32>(remove_count);
+  remove_by_size_cnt = narrow_cast<int32>(remove_end - remove_by_atime_pos - remove_count);
 
-  size_t pos = 0;
-  while (pos < files.size() && (remove_count > 0 || remove_size > 0)) {
-    if (token_) {
-      return promise.set_error(Global::request_aborted_error());
-    }
-    if (remove_count > 0) {
-      remove_by_count_cnt++;
-    } else {
-      remove_by_size_cnt++;
-    }
-
-    if (remove_count > 0) {
-      remove_count--;
-    }
-    remove_size -= files[pos].size;
+  // remove least recently used files first in case the GC is canceled
+  std::sort(files.begin() + remove_by_atime_pos, files.begin() + remove_end,
+            [](const auto &a, const auto &b) { return a.atime_nsec < b.atime_nsec; });
 
-    total_removed_size += files[pos].size;
-    do_remove_file(files[pos]);
-    pos++;
+  if (!unlink_files(files, remove_end, token_)) {
+    return promise.set_error(Global::request_aborted_error());
+  }
+  for (size_t i = 0; i < remove_end; i++) {
+    total_removed_size += files[i].size;
+    on_file_removed(files[i]);
   }
 
-  while (pos < files.size()) {
+  for (size_t pos = remove_end; pos < files.size(); pos++) {
     new_stats.add_copy(files[pos]);
-    pos++;
+  }
+
+  int32 removed_shared_file_count = 0;
+  auto shared_file_store_directory = G()->get_option_string("shared_file_store_directory");
+  if (!shared_file_store_directory.empty()) {
+    removed_shared_file_count = remove_unused_shared_files(shared_file_store_directory, token_);
   }
 
   auto end_time = Time::now();
@@ -183,7 +285,8 @@ void FileGcWorker::run_gc(const FileGcParameters &parameters, std::vector<FullFi
                 << tag("by_size", remove_by_size_cnt) << tag("type_immunity", type_immunity_ignored_cnt)
                 << tag("time_immunity", time_immunity_ignored_cnt)
                 << tag("owner_dialog_id_immunity", owner_dialog_id_ignored_cnt)
-                << tag("exclude_owner_dialog_id_immunity", exclude_owner_dialog_id_ignored_cnt);
+                << tag("exclude_owner_dialog_id_immunity", exclude_owner_dialog_id_ignored_cnt)
+                << tag("removed_shared", removed_shared_file_count);
   if (end_time - begin_time > 1.0) {
     LOG(WARNING) << "Finish file GC: " << tag("time", end_time - begin_time) << tag("total", file_cnt)
                  << tag("removed", remove_by_atime_cnt + remove_by_count_cnt + remove_by_size_cnt)
@@ -12,8 +12,10 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/CancellationToken.h"
+#include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/Promise.h"
+#include "td/utils/Slice.h"
 
 namespace td {
 
@@ -30,6 +32,9 @@ class FileGcWorker final : public Actor {
   }
   void run_gc(const FileGcParameters &parameters, std::vector<FullFileInfo> files, Promise<FileGcResult> promise);
 
+  // removes files from the shared file store, which aren't used by any client; returns number of removed files
+  static int32 remove_unused_shared_files(CSlice dir, const CancellationToken &token);
+
  private:
   ActorShared<> parent_;
   CancellationToken token_;
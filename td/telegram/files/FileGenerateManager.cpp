@@ -27,6 +27,7 @@
 #include "td/utils/port/Stat.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 
 #include <cmath>
 #include <memory>
@@ -388,6 +389,9 @@ class FileExternalGenerateActor final : public FileGenerateActor {
   }
 };
 
+constexpr int32 FileGenerateManager::DEFAULT_MAX_ACTIVE_EXTERNAL_GENERATIONS;
+constexpr double FileGenerateManager::EXTERNAL_GENERATION_SLOT_TIMEOUT;
+
 FileGenerateManager::Query::~Query() = default;
 FileGenerateManager::Query::Query(Query &&) noexcept = default;
 FileGenerateManager::Query &FileGenerateManager::Query::operator=(Query &&) noexcept = default;
@@ -423,7 +427,7 @@ static Status check_mtime(std::string &conversion, CSlice original_path) {
 }
 
 void FileGenerateManager::generate_file(uint64 query_id, FullGenerateFileLocation generate_location,
-                                        const LocalFileLocation &local_location, string name,
+                                        const LocalFileLocation &local_location, string name, int8 priority,
                                         unique_ptr<FileGenerateCallback> callback) {
   LOG(INFO) << "Begin to generate file with " << generate_location;
   auto mtime_status = check_mtime(generate_location.conversion_, generate_location.original_path_);
@@ -434,7 +438,6 @@ void FileGenerateManager::generate_file(uint64 query_id, FullGenerateFileLocatio
   CHECK(query_id != 0);
   auto it_flag = query_id_to_query_.emplace(query_id, Query{});
   LOG_CHECK(it_flag.second) << "Query identifier must be unique";
-  auto parent = actor_shared(this, query_id);
 
   Slice file_id_query = "#file_id#";
   Slice conversion = generate_location.conversion_;
@@ -443,60 +446,147 @@ void FileGenerateManager::generate_file(uint64 query_id, FullGenerateFileLocatio
   if (begins_with(conversion, file_id_query)) {
     auto file_id = FileId(to_integer<int32>(conversion.substr(file_id_query.size())), 0);
     query.worker_ = create_actor<FileDownloadGenerateActor>("FileDownloadGenerateActor", generate_location.file_type_,
-                                                            file_id, std::move(callback), std::move(parent));
+                                                            file_id, std::move(callback), actor_shared(this, query_id));
   } else if (FileManager::is_remotely_generated_file(conversion) && generate_location.original_path_.empty()) {
     query.worker_ = create_actor<WebFileDownloadGenerateActor>("WebFileDownloadGenerateActor",
                                                                std::move(generate_location.conversion_),
-                                                               std::move(callback), std::move(parent));
+                                                               std::move(callback), actor_shared(this, query_id));
   } else {
-    query.worker_ = create_actor<FileExternalGenerateActor>("FileExternalGenerationActor", query_id, generate_location,
-                                                            local_location, std::move(name), std::move(callback),
-                                                            std::move(parent));
+    query.callback_ = std::move(callback);
+    query.generate_location_ = std::move(generate_location);
+    query.local_location_ = local_location;
+    query.name_ = std::move(name);
+    query.priority_ = priority;
+    if (active_external_generation_count_ < get_max_active_external_generations()) {
+      start_external_generation(query_id, query);
+    } else {
+      LOG(INFO) << "Delay generation " << query_id << " with priority " << priority;
+      pending_external_queries_.emplace(-static_cast<int32>(priority), query_id);
+    }
   }
 }
 
+void FileGenerateManager::start_external_generation(uint64 query_id, Query &query) {
+  CHECK(query.callback_ != nullptr);
+  CHECK(!query.is_active_external_);
+  query.is_active_external_ = true;
+  query.slot_release_time_ = Time::now() + EXTERNAL_GENERATION_SLOT_TIMEOUT;
+  active_external_generation_count_++;
+  if (!has_timeout()) {
+    set_timeout_at(query.slot_release_time_);
+  }
+  query.worker_ = create_actor<FileExternalGenerateActor>(
+      "FileExternalGenerationActor", query_id, std::move(query.generate_location_), std::move(query.local_location_),
+      std::move(query.name_), std::move(query.callback_), actor_shared(this, query_id));
+  query.callback_ = nullptr;
+}
+
+void FileGenerateManager::start_pending_external_generations() {
+  auto max_active_external_generations = get_max_active_external_generations();
+  while (!close_flag_ && active_external_generation_count_ < max_active_external_generations &&
+         !pending_external_queries_.empty()) {
+    auto query_id = pending_external_queries_.begin()->second;
+    pending_external_queries_.erase(pending_external_queries_.begin());
+    auto it = query_id_to_query_.find(query_id);
+    CHECK(it != query_id_to_query_.end());
+    LOG(INFO) << "Start delayed generation " << query_id;
+    start_external_generation(query_id, it->second);
+  }
+}
+
+size_t FileGenerateManager::get_max_active_external_generations() {
+  return narrow_cast<size_t>(
+      G()->get_option_integer("file_generation_active_count_max", DEFAULT_MAX_ACTIVE_EXTERNAL_GENERATIONS));
+}
+
+FileGenerateManager::Query *FileGenerateManager::get_active_query(uint64 query_id) {
+  auto it = query_id_to_query_.find(query_id);
+  if (it == query_id_to_query_.end() || it->second.callback_ != nullptr) {
+    // the application isn't aware of generations, which haven't been started yet
+    return nullptr;
+  }
+  auto &query = it->second;
+  if (query.is_active_external_) {
+    query.slot_release_time_ = Time::now() + EXTERNAL_GENERATION_SLOT_TIMEOUT;
+  }
+  return &query;
+}
+
 void FileGenerateManager::cancel(uint64 query_id) {
   auto it = query_id_to_query_.find(query_id);
   if (it == query_id_to_query_.end()) {
     return;
   }
-  it->second.worker_.reset();
+  auto &query = it->second;
+  if (query.callback_ != nullptr) {
+    pending_external_queries_.erase({-static_cast<int32>(query.priority_), query_id});
+    auto callback = std::move(query.callback_);
+    query_id_to_query_.erase(it);
+    callback->on_error(Status::Error(-1, "Canceled"));
+    return loop();
+  }
+  query.worker_.reset();
 }
 
-void FileGenerateManager::external_file_generate_write_part(uint64 query_id, int64 offset, string data,
-                                                            Promise<> promise) {
+void FileGenerateManager::update_priority(uint64 query_id, int8 priority) {
   auto it = query_id_to_query_.find(query_id);
   if (it == query_id_to_query_.end()) {
+    return;
+  }
+  auto &query = it->second;
+  if (query.callback_ == nullptr || query.priority_ == priority) {
+    // the priority of already started generations can't be changed
+    return;
+  }
+  LOG(INFO) << "Change priority of delayed generation " << query_id << " to " << priority;
+  pending_external_queries_.erase({-static_cast<int32>(query.priority_), query_id});
+  query.priority_ = priority;
+  pending_external_queries_.emplace(-static_cast<int32>(priority), query_id);
+}
+
+void FileGenerateManager::external_file_generate_write_part(uint64 query_id, int64 offset, string data,
+                                                            Promise<> promise) {
+  auto *query = get_active_query(query_id);
+  if (query == nullptr) {
     return promise.set_error(Status::Error(400, "Unknown generation_id"));
   }
   auto safe_promise = SafePromise<>(std::move(promise), Status::Error(400, "Generation has already been finished"));
-  send_closure(it->second.worker_, &FileGenerateActor::file_generate_write_part, offset, std::move(data),
+  send_closure(query->worker_, &FileGenerateActor::file_generate_write_part, offset, std::move(data),
                std::move(safe_promise));
 }
 
 void FileGenerateManager::external_file_generate_progress(uint64 query_id, int64 expected_size, int64 local_prefix_size,
                                                           Promise<> promise) {
-  auto it = query_id_to_query_.find(query_id);
-  if (it == query_id_to_query_.end()) {
+  auto *query = get_active_query(query_id);
+  if (query == nullptr) {
     return promise.set_error(Status::Error(400, "Unknown generation_id"));
   }
   auto safe_promise = SafePromise<>(std::move(promise), Status::Error(400, "Generation has already been finished"));
-  send_closure(it->second.worker_, &FileGenerateActor::file_generate_progress, expected_size, local_prefix_size,
+  send_closure(query->worker_, &FileGenerateActor::file_generate_progress, expected_size, local_prefix_size,
                std::move(safe_promise));
 }
 
 void FileGenerateManager::external_file_generate_finish(uint64 query_id, Status status, Promise<> promise) {
-  auto it = query_id_to_query_.find(query_id);
-  if (it == query_id_to_query_.end()) {
+  auto *query = get_active_query(query_id);
+  if (query == nullptr) {
     return promise.set_error(Status::Error(400, "Unknown generation_id"));
   }
   auto safe_promise = SafePromise<>(std::move(promise), Status::Error(400, "Generation has already been finished"));
-  send_closure(it->second.worker_, &FileGenerateActor::file_generate_finish, std::move(status),
+  send_closure(query->worker_, &FileGenerateActor::file_generate_finish, std::move(status),
                std::move(safe_promise));
 }
 
 void FileGenerateManager::do_cancel(uint64 query_id) {
-  query_id_to_query_.erase(query_id);
+  auto it = query_id_to_query_.find(query_id);
+  if (it == query_id_to_query_.end()) {
+    return;
+  }
+  if (it->second.is_active_external_) {
+    CHECK(active_external_generation_count_ > 0);
+    active_external_generation_count_--;
+  }
+  query_id_to_query_.erase(it);
+  start_pending_external_generations();
 }
 
 void FileGenerateManager::hangup_shared() {
@@ -506,12 +596,44 @@ void FileGenerateManager::hangup_shared() {
 
 void FileGenerateManager::hangup() {
   close_flag_ = true;
+  for (auto &pending_query : pending_external_queries_) {
+    auto it = query_id_to_query_.find(pending_query.second);
+    CHECK(it != query_id_to_query_.end());
+    auto callback = std::move(it->second.callback_);
+    query_id_to_query_.erase(it);
+    callback->on_error(Status::Error(-1, "Canceled"));
+  }
+  pending_external_queries_.clear();
   for (auto &it : query_id_to_query_) {
     it.second.worker_.reset();
   }
   loop();
 }
 
+void FileGenerateManager::timeout_expired() {
+  auto now = Time::now();
+  double next_release_time = 0.0;
+  for (auto &it : query_id_to_query_) {
+    auto &query = it.second;
+    if (!query.is_active_external_) {
+      continue;
+    }
+    if (query.slot_release_time_ <= now) {
+      LOG(WARNING) << "Generation " << it.first << " wasn't updated for " << EXTERNAL_GENERATION_SLOT_TIMEOUT
+                   << " seconds, free its slot";
+      query.is_active_external_ = false;
+      CHECK(active_external_generation_count_ > 0);
+      active_external_generation_count_--;
+    } else if (next_release_time == 0.0 || query.slot_release_time_ < next_release_time) {
+      next_release_time = query.slot_release_time_;
+    }
+  }
+  if (next_release_time != 0.0) {
+    set_timeout_at(next_release_time);
+  }
+  start_pending_external_generations();
+}
+
 void FileGenerateManager::loop() {
   if (close_flag_ && query_id_to_query_.empty()) {
     stop();
@@ -15,6 +15,8 @@
 #include "td/utils/Status.h"
 
 #include <map>
+#include <set>
+#include <utility>
 
 namespace td {
 
@@ -38,8 +40,10 @@ class FileGenerateManager final : public Actor {
   }
 
   void generate_file(uint64 query_id, FullGenerateFileLocation generate_location,
-                     const LocalFileLocation &local_location, string name, unique_ptr<FileGenerateCallback> callback);
+                     const LocalFileLocation &local_location, string name, int8 priority,
+                     unique_ptr<FileGenerateCallback> callback);
   void cancel(uint64 query_id);
+  void update_priority(uint64 query_id, int8 priority);
 
   // external updates about file generation state
   void external_file_generate_write_part(uint64 query_id, int64 offset, string data, Promise<> promise);
@@ -57,15 +61,38 @@ class FileGenerateManager final : public Actor {
     ~Query();
 
     ActorOwn<FileGenerateActor> worker_;
+    bool is_active_external_ = false;
+    double slot_release_time_ = 0.0;
+
+    // arguments of an external generation, which waits for a free slot
+    unique_ptr<FileGenerateCallback> callback_;
+    FullGenerateFileLocation generate_location_;
+    LocalFileLocation local_location_;
+    string name_;
+    int8 priority_ = 0;
   };
 
+  // every external generation is done by the application, which is likely to convert the files in parallel,
+  // so the number of simultaneously started generations is limited by the option "file_generation_active_count_max"
+  static constexpr int32 DEFAULT_MAX_ACTIVE_EXTERNAL_GENERATIONS = 4;
+  // a generation, which isn't updated by the application for the time, frees its slot for the queued generations
+  static constexpr double EXTERNAL_GENERATION_SLOT_TIMEOUT = 60.0;
+
   ActorShared<> parent_;
   std::map<uint64, Query> query_id_to_query_;
+  std::set<std::pair<int32, uint64>> pending_external_queries_;  // (-priority, query_id)
+  size_t active_external_generation_count_ = 0;
   bool close_flag_ = false;
 
+  Query *get_active_query(uint64 query_id);
+  void start_external_generation(uint64 query_id, Query &query);
+  void start_pending_external_generations();
+  static size_t get_max_active_external_generations();
+
   void hangup() final;
   void hangup_shared() final;
   void loop() final;
+  void timeout_expired() final;
   void do_cancel(uint64 query_id);
 };
 
@@ -20,11 +20,14 @@
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
 #include "td/utils/port/FileFd.h"
-#include "td/utils/port/PollFlags.h"
+#include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
 namespace td {
 
+// the file is hashed by chunks to not block the scheduler for a long time
+static constexpr int64 HASH_CHUNK_SIZE = 8 << 20;
+
 void FileHashUploader::start_up() {
   auto status = init();
   if (status.is_error()) {
@@ -40,7 +43,7 @@ Status FileHashUploader::init() {
   if (file_size != size_) {
     return Status::Error("Size mismatch");
   }
-  fd_ = BufferedFd<FileFd>(std::move(fd));
+  fd_ = std::move(fd);
   sha256_state_.init();
 
   resource_state_.set_unit_size(1024);
@@ -87,29 +90,39 @@ Status FileHashUploader::loop_sha() {
   if (limit > size_left_) {
     limit = size_left_;
   }
-  resource_state_.start_use(limit);
-
-  fd_.get_poll_info().add_flags(PollFlags::Read());
-  TRY_RESULT(read_size, fd_.flush_read(static_cast<size_t>(limit)));
-  if (read_size != static_cast<size_t>(limit)) {
-    return Status::Error("Unexpected end of file");
-  }
-  while (true) {
-    auto ready = fd_.input_buffer().prepare_read();
-    if (ready.empty()) {
-      break;
-    }
-    sha256_state_.feed(ready);
-    fd_.input_buffer().confirm_read(ready.size());
+  if (limit > HASH_CHUNK_SIZE) {
+    limit = HASH_CHUNK_SIZE;
   }
+  resource_state_.start_use(limit);
+  TRY_STATUS(feed_sha(size_ - size_left_, limit));
   resource_state_.stop_use(limit);
 
-  size_left_ -= narrow_cast<int64>(read_size);
+  size_left_ -= limit;
   CHECK(size_left_ >= 0);
   if (size_left_ == 0) {
     state_ = State::NetRequest;
     return Status::OK();
   }
+  if (resource_state_.unused() > 0) {
+    // continue hashing after other events are processed
+    yield();
+  }
+  return Status::OK();
+}
+
+Status FileHashUploader::feed_sha(int64 offset, int64 size) {
+  // the file isn't memory mapped, because access to a mapping of a file truncated concurrently causes SIGBUS
+  read_buffer_.resize(static_cast<size_t>(size));
+  MutableSlice buffer(read_buffer_);
+  while (!buffer.empty()) {
+    TRY_RESULT(read_size, fd_.pread(buffer, offset));
+    if (read_size == 0) {
+      return Status::Error("Unexpected end of file");
+    }
+    buffer.remove_prefix(read_size);
+    offset += narrow_cast<int64>(read_size);
+  }
+  sha256_state_.feed(read_buffer_);
   return Status::OK();
 }
 
@@ -12,7 +12,6 @@
 
 #include "td/actor/actor.h"
 
-#include "td/utils/BufferedFd.h"
 #include "td/utils/crypto.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/Status.h"
@@ -54,7 +53,8 @@ class FileHashUploader final : public FileLoaderActor {
 
  private:
   ResourceState resource_state_;
-  BufferedFd<FileFd> fd_;
+  FileFd fd_;
+  string read_buffer_;
 
   FullLocalFileLocation local_;
   int64 size_;
@@ -76,6 +76,8 @@ class FileHashUploader final : public FileLoaderActor {
 
   Status loop_sha();
 
+  Status feed_sha(int64 offset, int64 size);
+
   void on_result(NetQueryPtr net_query) final;
 
   Status on_result_impl(NetQueryPtr net_query);
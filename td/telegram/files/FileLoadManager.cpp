@@ -14,6 +14,7 @@
 #include "td/utils/format.h"
 #include "td/utils/port/path.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
@@ -26,7 +27,7 @@ void FileLoadManager::start_up() {
   upload_resource_manager_ = create_actor<ResourceManager>(
       "UploadResourceManager", MAX_UPLOAD_RESOURCE_LIMIT,
       !G()->keep_media_order() ? ResourceManager::Mode::Greedy : ResourceManager::Mode::Baseline);
-  if (G()->get_option_boolean("is_premium")) {
+  if (G()->get_option_boolean(OptionId::IsPremium)) {
     max_download_resource_limit_ *= 8;
   }
 }
@@ -41,6 +42,14 @@ ActorOwn<ResourceManager> &FileLoadManager::get_download_resource_manager(bool i
   return actor;
 }
 
+std::shared_ptr<BandwidthEstimator> FileLoadManager::get_download_bandwidth_estimator(DcId dc_id) {
+  auto &estimator = download_bandwidth_estimators_[dc_id];
+  if (estimator == nullptr) {
+    estimator = std::make_shared<BandwidthEstimator>();
+  }
+  return estimator;
+}
+
 void FileLoadManager::download(QueryId query_id, const FullRemoteFileLocation &remote_location,
                                const LocalFileLocation &local, int64 size, string name,
                                const FileEncryptionKey &encryption_key, bool search_file, int64 offset, int64 limit,
@@ -52,12 +61,18 @@ void FileLoadManager::download(QueryId query_id, const FullRemoteFileLocation &r
   Node *node = nodes_container_.get(node_id);
   CHECK(node);
   node->query_id_ = query_id;
+  if (local.type() == LocalFileLocation::Type::Partial) {
+    // the partial file can be rewritten by the download and is renamed after it
+    node->partial_path_ = local.partial().path_;
+    file_read_cache_.forget_file(node->partial_path_);
+  }
   auto callback = make_unique<FileDownloaderCallback>(actor_shared(this, node_id));
   bool is_small = size < 20 * 1024;
-  node->loader_ =
-      create_actor<FileDownloader>("Downloader", remote_location, local, size, std::move(name), encryption_key,
-                                   is_small, search_file, offset, limit, std::move(callback));
   DcId dc_id = remote_location.is_web() ? G()->get_webfile_dc_id() : remote_location.get_dc_id();
+  node->loader_ = create_actor<FileDownloader>("Downloader", remote_location, local, size, std::move(name),
+                                               encryption_key, is_small, search_file, offset, limit,
+                                               get_download_bandwidth_estimator(dc_id),
+                                               is_small ? nullptr : download_speed_limiter_, std::move(callback));
   auto &resource_manager = get_download_resource_manager(is_small, dc_id);
   send_closure(resource_manager, &ResourceManager::register_worker,
                ActorShared<FileLoaderActor>(node->loader_.get(), static_cast<uint64>(-1)), priority);
@@ -77,7 +92,7 @@ void FileLoadManager::upload(QueryId query_id, const LocalFileLocation &local_lo
   node->query_id_ = query_id;
   auto callback = make_unique<FileUploaderCallback>(actor_shared(this, node_id));
   node->loader_ = create_actor<FileUploader>("Uploader", local_location, remote_location, expected_size, encryption_key,
-                                             std::move(bad_parts), std::move(callback));
+                                             std::move(bad_parts), upload_speed_limiter_, std::move(callback));
   send_closure(upload_resource_manager_, &ResourceManager::register_worker,
                ActorShared<FileLoaderActor>(node->loader_.get(), static_cast<uint64>(-1)), priority);
   bool is_inserted = query_id_to_node_id_.emplace(query_id, node_id).second;
@@ -94,7 +109,9 @@ void FileLoadManager::upload_by_hash(QueryId query_id, const FullLocalFileLocati
   CHECK(node);
   node->query_id_ = query_id;
   auto callback = make_unique<FileHashUploaderCallback>(actor_shared(this, node_id));
-  node->loader_ = create_actor<FileHashUploader>("HashUploader", local_location, size, std::move(callback));
+  // hashing of big files takes a lot of time, so it is done on another scheduler to not delay ongoing file loading
+  node->loader_ = create_actor_on_scheduler<FileHashUploader>("HashUploader", G()->get_gc_scheduler_id(),
+                                                              local_location, size, std::move(callback));
   send_closure(upload_resource_manager_, &ResourceManager::register_worker,
                ActorShared<FileLoaderActor>(node->loader_.get(), static_cast<uint64>(-1)), priority);
   bool is_inserted = query_id_to_node_id_.emplace(query_id, node_id).second;
@@ -135,11 +152,20 @@ void FileLoadManager::get_content(string file_path, Promise<BufferSlice> promise
   promise.set_result(read_file(file_path));
 }
 
-void FileLoadManager::read_file_part(string file_path, int64 offset, int64 count, Promise<string> promise) {
-  promise.set_result(read_file_str(file_path, count, offset));
+void FileLoadManager::read_file_part(string file_path, int64 offset, int64 count, int64 max_read_ahead_count,
+                                     Promise<string> promise) {
+  promise.set_result(file_read_cache_.read(file_path, offset, count, max_read_ahead_count, Time::now()));
+  if (!file_read_cache_.empty() && !has_timeout()) {
+    set_timeout_in(FileReadCache::CACHED_FILE_TTL);
+  }
+}
+
+void FileLoadManager::forget_read_file_parts(string file_path) {
+  file_read_cache_.forget_file(file_path);
 }
 
 void FileLoadManager::unlink_file(string file_path, Promise<Unit> promise) {
+  file_read_cache_.forget_file(file_path);
   unlink(file_path).ignore();
   promise.set_value(Unit());
 }
@@ -199,8 +225,25 @@ void FileLoadManager::update_downloaded_part(QueryId query_id, int64 offset, int
   send_closure(node->loader_, &FileLoaderActor::update_downloaded_part, offset, limit, max_download_resource_limit_);
 }
 
+void FileLoadManager::on_speed_limit_changed() {
+  if (stop_flag_) {
+    return;
+  }
+  // wake up loaders, which wait for the previous speed limit
+  nodes_container_.for_each(
+      [](auto node_id, auto &node) { send_closure(node.loader_, &FileLoaderActor::on_speed_limit_changed); });
+}
+
+void FileLoadManager::timeout_expired() {
+  file_read_cache_.expire_files(Time::now());
+  if (!file_read_cache_.empty()) {
+    set_timeout_in(FileReadCache::CACHED_FILE_TTL);
+  }
+}
+
 void FileLoadManager::hangup() {
   nodes_container_.for_each([](auto query_id, auto &node) { node.loader_.reset(); });
+  file_read_cache_.clear();
   stop_flag_ = true;
   loop();
 }
@@ -256,6 +299,9 @@ void FileLoadManager::on_ok_download(FullLocalFileLocation local, int64 size, bo
   if (node == nullptr) {
     return;
   }
+  if (!node->partial_path_.empty()) {
+    file_read_cache_.forget_file(node->partial_path_);
+  }
   if (!stop_flag_) {
     send_closure(callback_, &Callback::on_download_ok, node->query_id_, std::move(local), size, is_new);
   }
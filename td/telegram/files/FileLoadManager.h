@@ -6,15 +6,18 @@
 //
 #pragma once
 
+#include "td/telegram/files/BandwidthEstimator.h"
 #include "td/telegram/files/FileDownloader.h"
 #include "td/telegram/files/FileEncryptionKey.h"
 #include "td/telegram/files/FileFromBytes.h"
 #include "td/telegram/files/FileHashUploader.h"
 #include "td/telegram/files/FileLoaderUtils.h"
 #include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/FileReadCache.h"
 #include "td/telegram/files/FileType.h"
 #include "td/telegram/files/FileUploader.h"
 #include "td/telegram/files/ResourceManager.h"
+#include "td/telegram/files/SpeedLimiter.h"
 #include "td/telegram/net/DcId.h"
 
 #include "td/actor/actor.h"
@@ -26,6 +29,7 @@
 #include "td/utils/Status.h"
 
 #include <map>
+#include <memory>
 
 namespace td {
 
@@ -59,9 +63,14 @@ class FileLoadManager final : public Actor {
   void update_local_file_location(QueryId query_id, const LocalFileLocation &local);
   void update_downloaded_part(QueryId query_id, int64 offset, int64 limit);
 
+  void on_speed_limit_changed();
+
   void get_content(string file_path, Promise<BufferSlice> promise);
 
-  void read_file_part(string file_path, int64 offset, int64 count, Promise<string> promise);
+  void read_file_part(string file_path, int64 offset, int64 count, int64 max_read_ahead_count,
+                      Promise<string> promise);
+
+  void forget_read_file_parts(string file_path);
 
   void unlink_file(string file_path, Promise<Unit> promise);
 
@@ -75,12 +84,17 @@ class FileLoadManager final : public Actor {
     QueryId query_id_;
     ActorOwn<FileLoaderActor> loader_;
     ResourceState resource_state_;
+    string partial_path_;
   };
   using NodeId = uint64;
 
   std::map<DcId, ActorOwn<ResourceManager>> download_resource_manager_map_;
   std::map<DcId, ActorOwn<ResourceManager>> download_small_resource_manager_map_;
+  std::map<DcId, std::shared_ptr<BandwidthEstimator>> download_bandwidth_estimators_;
   ActorOwn<ResourceManager> upload_resource_manager_;
+  std::shared_ptr<SpeedLimiter> download_speed_limiter_ = std::make_shared<SpeedLimiter>();
+  std::shared_ptr<SpeedLimiter> upload_speed_limiter_ = std::make_shared<SpeedLimiter>();
+  FileReadCache file_read_cache_;
 
   Container<Node> nodes_container_;
   ActorShared<Callback> callback_;
@@ -91,11 +105,13 @@ class FileLoadManager final : public Actor {
 
   void start_up() final;
   void loop() final;
+  void timeout_expired() final;
   void hangup() final;
   void hangup_shared() final;
 
   void close_node(NodeId node_id);
   ActorOwn<ResourceManager> &get_download_resource_manager(bool is_small, DcId dc_id);
+  std::shared_ptr<BandwidthEstimator> get_download_bandwidth_estimator(DcId dc_id);
 
   void on_start_download();
   void on_partial_download(PartialLocalFileLocation partial_local, int64 ready_size, int64 size);
@@ -17,6 +17,8 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Time.h"
 
 #include <tuple>
 
@@ -55,6 +57,19 @@ void FileLoader::hangup_shared() {
   }
 }
 
+void FileLoader::timeout_expired() {
+  speed_limit_wakeup_at_ = 0.0;
+  loop();
+}
+
+void FileLoader::on_speed_limit_changed() {
+  if (speed_limit_wakeup_at_ == 0.0) {
+    return;
+  }
+  cancel_timeout();
+  timeout_expired();
+}
+
 void FileLoader::update_local_file_location(const LocalFileLocation &local) {
   auto r_prefix_info = on_update_local_location(local, parts_manager_.get_size_or_zero());
   if (r_prefix_info.is_error()) {
@@ -119,6 +134,7 @@ void FileLoader::start_up() {
   // pm.init(0, 100000, false, 10, {0, 1, 2}, false, true).ensure_error();
   // This can happen only if file state became inconsistent at some point. For example, local location was deleted,
   // but partial remote location was kept. This is possible, but probably should be fixed.
+  parts_manager_.set_min_part_size(file_info.min_part_size);
   auto status =
       parts_manager_.init(size, expected_size, is_size_final, part_size, ready_parts, use_part_count_limit, is_upload);
   LOG(DEBUG) << "Start " << (is_upload ? "up" : "down") << "loading a file of size " << size << " with expected "
@@ -140,6 +156,9 @@ void FileLoader::start_up() {
     delay_dispatcher_ = create_actor<DelayDispatcher>("DelayDispatcher", 0.003, actor_shared(this, 1));
     next_delay_ = 0.05;
   }
+  bandwidth_estimator_ = std::move(file_info.bandwidth_estimator);
+  speed_limiter_ = std::move(file_info.speed_limiter);
+  is_upload_ = is_upload;
   resource_state_.set_unit_size(parts_manager_.get_part_size());
   update_estimated_limit();
   on_progress_impl();
@@ -199,6 +218,14 @@ Status FileLoader::do_loop() {
       VLOG(file_loader) << "Receive only " << resource_state_.unused() << " resource";
       break;
     }
+    if (!may_start_part() || !may_send_part()) {
+      VLOG(file_loader) << "Wait for finish of started parts";
+      break;
+    }
+    if (is_speed_limited()) {
+      VLOG(file_loader) << "Wait for speed limit until " << speed_limit_wakeup_at_;
+      break;
+    }
     TRY_RESULT(part, parts_manager_.start_part());
     if (part.size == 0) {
       break;
@@ -207,6 +234,9 @@ Status FileLoader::do_loop() {
     resource_state_.start_use(static_cast<int64>(part.size));
 
     TRY_RESULT(query_flag, start_part(part, parts_manager_.get_part_count(), parts_manager_.get_streaming_offset()));
+    if (speed_limiter_ != nullptr) {
+      speed_limiter_->on_part_started(static_cast<int64>(part.size));
+    }
     NetQueryPtr query;
     bool is_blocking;
     std::tie(query, is_blocking) = std::move(query_flag);
@@ -216,6 +246,9 @@ Status FileLoader::do_loop() {
       blocking_id_ = unique_id;
     }
     part_map_[unique_id] = std::make_pair(part, query->cancel_slot_.get_signal_new());
+    if (bandwidth_estimator_ != nullptr) {
+      part_send_states_[unique_id] = bandwidth_estimator_->on_send(static_cast<int64>(part.size), Time::now());
+    }
     // part_map_[unique_id] = std::make_pair(part, query.get_weak());
 
     auto callback = actor_shared(this, unique_id);
@@ -235,12 +268,66 @@ void FileLoader::tear_down() {
   for (auto &it : part_map_) {
     it.second.second.reset();  // cancel_query(it.second.second);
   }
+  if (bandwidth_estimator_ != nullptr) {
+    for (auto &it : part_send_states_) {
+      bandwidth_estimator_->on_lost(it.second);
+    }
+    part_send_states_.clear();
+  }
   ordered_parts_.clear([](auto &&part) { part.second->clear(); });
   if (!delay_dispatcher_.empty()) {
     send_closure(std::move(delay_dispatcher_), &DelayDispatcher::close_silent);
   }
 }
 
+bool FileLoader::may_send_part() {
+  if (bandwidth_estimator_ == nullptr) {
+    return true;
+  }
+  auto window = bandwidth_estimator_->get_window();
+  if (window != logged_bandwidth_window_) {
+    logged_bandwidth_window_ = window;
+    LOG(INFO) << "Use in-flight window of " << window << " bytes for estimated bandwidth of "
+              << static_cast<int64>(bandwidth_estimator_->get_bandwidth()) << " bytes per second and RTT of "
+              << bandwidth_estimator_->get_min_rtt();
+  }
+  // the first part is always sent to ensure that the loader will be woken up after some part is finished
+  return part_send_states_.empty() ||
+         bandwidth_estimator_->may_send(static_cast<int64>(parts_manager_.get_part_size()));
+}
+
+bool FileLoader::is_speed_limited() {
+  if (speed_limiter_ == nullptr) {
+    return false;
+  }
+  if (speed_limit_wakeup_at_ != 0.0) {
+    return true;
+  }
+  auto speed_limit = G()->get_option_integer(is_upload_ ? Slice("file_upload_speed_limit")
+                                                        : Slice("file_download_speed_limit"));
+  auto wakeup_at = speed_limiter_->get_wakeup_time(speed_limit, Time::now());
+  if (wakeup_at == 0.0) {
+    return false;
+  }
+  speed_limit_wakeup_at_ = wakeup_at;
+  set_timeout_at(wakeup_at);
+  return true;
+}
+
+void FileLoader::on_part_send_finished(uint64 unique_id, bool is_delivered) {
+  auto it = part_send_states_.find(unique_id);
+  if (it == part_send_states_.end()) {
+    return;
+  }
+  CHECK(bandwidth_estimator_ != nullptr);
+  if (is_delivered) {
+    bandwidth_estimator_->on_delivered(it->second, Time::now());
+  } else {
+    bandwidth_estimator_->on_lost(it->second);
+  }
+  part_send_states_.erase(it);
+}
+
 void FileLoader::update_estimated_limit() {
   if (stop_flag_) {
     return;
@@ -292,6 +379,7 @@ void FileLoader::on_result(NetQueryPtr query) {
     }
     return Status::OK();
   }();
+  on_part_send_finished(unique_id, next && !query->is_error());
   if (status.is_error()) {
     on_error(std::move(status));
     stop_flag_ = true;
@@ -299,29 +387,42 @@ void FileLoader::on_result(NetQueryPtr query) {
   }
 
   if (next) {
+    std::vector<std::pair<Part, NetQueryPtr>> queries;
     if (ordered_flag_) {
       auto seq_no = part.id;
-      ordered_parts_.add(
-          seq_no, std::make_pair(part, std::move(query)),
-          [this](uint64 seq_no, std::pair<Part, NetQueryPtr> &&p) { on_part_query(p.first, std::move(p.second)); });
+      ordered_parts_.add(seq_no, std::make_pair(part, std::move(query)),
+                         [&queries](uint64 seq_no, std::pair<Part, NetQueryPtr> &&p) {
+                           queries.push_back(std::move(p));
+                         });
     } else {
-      on_part_query(part, std::move(query));
+      queries.emplace_back(part, std::move(query));
+    }
+    if (!queries.empty()) {
+      on_part_queries(std::move(queries));
     }
   }
   update_estimated_limit();
   loop();
 }
 
-void FileLoader::on_part_query(Part part, NetQueryPtr query) {
+void FileLoader::on_part_queries(std::vector<std::pair<Part, NetQueryPtr>> queries) {
   if (stop_flag_) {
     // important for secret files
     return;
   }
-  auto status = try_on_part_query(part, std::move(query));
+  auto status = [&] {
+    // consecutive parts are processed together to allow them to be written to the file at once
+    for (auto &query : queries) {
+      TRY_STATUS(try_on_part_query(query.first, std::move(query.second)));
+    }
+    return flush_parts();
+  }();
   if (status.is_error()) {
     on_error(std::move(status));
     stop_flag_ = true;
+    return;
   }
+  on_progress_impl();
 }
 
 void FileLoader::on_common_query(NetQueryPtr query) {
@@ -344,7 +445,6 @@ Status FileLoader::try_on_part_query(Part part, NetQueryPtr query) {
     debug_bad_parts_.push_back(part.id);
     debug_bad_part_order_++;
   }
-  on_progress_impl();
   return Status::OK();
 }
 
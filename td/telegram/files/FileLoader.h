@@ -7,11 +7,13 @@
 #pragma once
 
 #include "td/telegram/DelayDispatcher.h"
+#include "td/telegram/files/BandwidthEstimator.h"
 #include "td/telegram/files/FileLoaderActor.h"
 #include "td/telegram/files/FileLocation.h"
 #include "td/telegram/files/PartsManager.h"
 #include "td/telegram/files/ResourceManager.h"
 #include "td/telegram/files/ResourceState.h"
+#include "td/telegram/files/SpeedLimiter.h"
 #include "td/telegram/net/NetQuery.h"
 
 #include "td/actor/actor.h"
@@ -21,6 +23,7 @@
 #include "td/utils/Status.h"
 
 #include <map>
+#include <memory>
 #include <utility>
 
 namespace td {
@@ -40,6 +43,7 @@ class FileLoader : public FileLoaderActor {
 
   void update_local_file_location(const LocalFileLocation &local) final;
   void update_downloaded_part(int64 offset, int64 limit, int64 max_resource_limit) final;
+  void on_speed_limit_changed() final;
 
  protected:
   void set_ordered_flag(bool flag);
@@ -61,6 +65,9 @@ class FileLoader : public FileLoaderActor {
     int64 offset{0};
     int64 limit{0};
     bool is_upload{false};
+    size_t min_part_size{0};
+    std::shared_ptr<BandwidthEstimator> bandwidth_estimator;
+    std::shared_ptr<SpeedLimiter> speed_limiter;
   };
   virtual Result<FileInfo> init() TD_WARN_UNUSED_RESULT = 0;
   virtual Status on_ok(int64 size) TD_WARN_UNUSED_RESULT = 0;
@@ -68,11 +75,19 @@ class FileLoader : public FileLoaderActor {
   virtual Status before_start_parts() {
     return Status::OK();
   }
+  // returns false if no more parts must be started until some of the started parts are finished
+  virtual bool may_start_part() const {
+    return true;
+  }
   virtual Result<std::pair<NetQueryPtr, bool>> start_part(Part part, int part_count,
                                                           int64 streaming_offset) TD_WARN_UNUSED_RESULT = 0;
   virtual void after_start_parts() {
   }
   virtual Result<size_t> process_part(Part part, NetQueryPtr net_query) TD_WARN_UNUSED_RESULT = 0;
+  // called after a batch of consecutive parts was processed and before progress is reported
+  virtual Status flush_parts() TD_WARN_UNUSED_RESULT {
+    return Status::OK();
+  }
   struct Progress {
     int32 part_count{0};
     int32 part_size{0};
@@ -120,6 +135,12 @@ class FileLoader : public FileLoaderActor {
   OrderedEventsProcessor<std::pair<Part, NetQueryPtr>> ordered_parts_;
   ActorOwn<DelayDispatcher> delay_dispatcher_;
   double next_delay_ = 0;
+  std::shared_ptr<BandwidthEstimator> bandwidth_estimator_;
+  std::map<uint64, BandwidthEstimator::SendState> part_send_states_;
+  int64 logged_bandwidth_window_ = 0;
+  std::shared_ptr<SpeedLimiter> speed_limiter_;
+  bool is_upload_ = false;
+  double speed_limit_wakeup_at_ = 0.0;
 
   uint32 debug_total_parts_ = 0;
   uint32 debug_bad_part_order_ = 0;
@@ -130,13 +151,17 @@ class FileLoader : public FileLoaderActor {
   Status do_loop();
   void hangup() final;
   void hangup_shared() final;
+  void timeout_expired() final;
   void tear_down() final;
 
   void update_estimated_limit();
+  bool may_send_part();
+  bool is_speed_limited();
+  void on_part_send_finished(uint64 unique_id, bool is_delivered);
   void on_progress_impl();
 
   void on_result(NetQueryPtr query) final;
-  void on_part_query(Part part, NetQueryPtr query);
+  void on_part_queries(std::vector<std::pair<Part, NetQueryPtr>> queries);
   void on_common_query(NetQueryPtr query);
   Status try_on_part_query(Part part, NetQueryPtr query);
 };
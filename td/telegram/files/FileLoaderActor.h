@@ -27,6 +27,8 @@ class FileLoaderActor : public NetQueryCallback {
   }
   virtual void update_downloaded_part(int64 offset, int64 limit, int64 max_resource_limit) {
   }
+  virtual void on_speed_limit_changed() {
+  }
 };
 
 }  // namespace td
@@ -32,6 +32,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/PathView.h"
+#include "td/utils/port/path.h"
 #include "td/utils/port/Stat.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
@@ -882,6 +883,9 @@ FileManager::FileManager(unique_ptr<Context> context) : context_(std::move(conte
   next_file_id();
   next_file_node_id();
 
+  progress_update_timeout_.set_callback(on_progress_update_timeout_callback);
+  progress_update_timeout_.set_callback_data(static_cast<void *>(this));
+
   G()->td_db()->with_db_path([bad_paths = &bad_paths_](CSlice path) { bad_paths->insert(path.str()); });
 }
 
@@ -895,7 +899,8 @@ void FileManager::init_actor() {
 FileManager::~FileManager() {
   Scheduler::instance()->destroy_on_scheduler(
       G()->get_gc_scheduler_id(), remote_location_info_, file_hash_to_file_id_, remote_location_to_file_id_,
-      local_location_to_file_id_, generate_location_to_file_id_, file_id_info_, empty_file_ids_, file_nodes_);
+      local_location_to_file_id_, generate_location_to_file_id_, file_id_info_, empty_file_ids_, file_nodes_,
+      empty_file_node_ids_, download_callbacks_, upload_callbacks_);
 }
 
 string FileManager::fix_file_extension(Slice file_name, Slice file_type, Slice file_extension) {
@@ -1172,6 +1177,26 @@ FileManager::FileIdInfo *FileManager::get_file_id_info(FileId file_id) {
   return &file_id_info_[file_id.get()];
 }
 
+std::shared_ptr<FileManager::DownloadCallback> FileManager::extract_download_callback(FileId file_id) {
+  auto it = download_callbacks_.find(file_id.get());
+  if (it == download_callbacks_.end()) {
+    return nullptr;
+  }
+  auto callback = std::move(it->second);
+  download_callbacks_.erase(it);
+  return callback;
+}
+
+std::shared_ptr<FileManager::UploadCallback> FileManager::extract_upload_callback(FileId file_id) {
+  auto it = upload_callbacks_.find(file_id.get());
+  if (it == upload_callbacks_.end()) {
+    return nullptr;
+  }
+  auto callback = std::move(it->second);
+  upload_callbacks_.erase(it);
+  return callback;
+}
+
 FileId FileManager::dup_file_id(FileId file_id, const char *source) {
   int32 file_node_id;
   auto *file_node = get_file_node_raw(file_id, &file_node_id);
@@ -1219,6 +1244,8 @@ void FileManager::try_forget_file_id(FileId file_id) {
   bool is_removed = td::remove(file_node->file_ids_, file_id);
   CHECK(is_removed);
   *info = FileIdInfo();
+  download_callbacks_.erase(file_id.get());
+  upload_callbacks_.erase(file_id.get());
   empty_file_ids_.push_back(file_id.get());
 }
 
@@ -1226,6 +1253,10 @@ FileId FileManager::register_empty(FileType type) {
   return register_local(FullLocalFileLocation(type, "", 0), DialogId(), 0, false, true).ok();
 }
 
+void FileManager::on_speed_limit_changed() {
+  send_closure(file_load_manager_, &FileLoadManager::on_speed_limit_changed);
+}
+
 void FileManager::on_file_unlink(const FullLocalFileLocation &location) {
   auto it = local_location_to_file_id_.find(location);
   if (it == local_location_to_file_id_.end()) {
@@ -1234,6 +1265,7 @@ void FileManager::on_file_unlink(const FullLocalFileLocation &location) {
   auto file_id = it->second;
   auto file_node = get_sync_file_node(file_id);
   CHECK(file_node);
+  send_closure(file_load_manager_, &FileLoadManager::forget_read_file_parts, location.path_);
   clear_from_pmc(file_node);
   send_closure(G()->download_manager(), &DownloadManager::remove_file_if_finished, file_node->main_file_id_);
   file_node->drop_local_location();
@@ -1874,21 +1906,22 @@ Status FileManager::merge(FileId x_file_id, FileId y_file_id, bool no_sync) {
     auto *info = get_file_id_info(file_id);
     if (info->download_priority_ != 0 && file_view.has_local_location()) {
       info->download_priority_ = 0;
-      if (info->download_callback_) {
-        info->download_callback_->on_download_ok(file_id);
-        info->download_callback_.reset();
+      auto download_callback = extract_download_callback(file_id);
+      if (download_callback) {
+        download_callback->on_download_ok(file_id);
       }
     }
     if (info->upload_priority_ != 0 && file_view.has_active_upload_remote_location()) {
       info->upload_priority_ = 0;
-      if (info->upload_callback_) {
-        info->upload_callback_->on_upload_ok(file_id, nullptr);
-        info->upload_callback_.reset();
+      auto upload_callback = extract_upload_callback(file_id);
+      if (upload_callback) {
+        upload_callback->on_upload_ok(file_id, nullptr);
       }
     }
   }
 
   file_nodes_[node_ids[other_node_i]] = nullptr;
+  empty_file_node_ids_.push_back(node_ids[other_node_i]);
 
   run_generate(node);
   run_download(node, false);
@@ -2037,21 +2070,65 @@ void FileManager::try_flush_node_pmc(FileNodePtr node, const char *source) {
 
 void FileManager::try_flush_node_info(FileNodePtr node, const char *source) {
   if (node->need_info_flush()) {
+    node->last_info_flush_time_ = Time::now();
+    node->last_info_flush_ready_size_ = node->local_ready_size_ + node->remote_.ready_size;
     for (auto file_id : vector<FileId>(node->file_ids_)) {
       auto *info = get_file_id_info(file_id);
       if (info->send_updates_flag_) {
         VLOG(update_file) << "Send UpdateFile about file " << file_id << " from " << source;
         context_->on_file_updated(file_id);
       }
-      if (info->download_callback_) {
+      auto it = download_callbacks_.find(file_id.get());
+      if (it != download_callbacks_.end()) {
         // For DownloadManager. For everybody else it is just an empty function call (I hope).
-        info->download_callback_->on_progress(file_id);
+        auto download_callback = it->second;
+        download_callback->on_progress(file_id);
       }
     }
     node->on_info_flushed();
   }
 }
 
+// progress of loading is sent at most once per the minimum interval, unless enough bytes were loaded;
+// completion and errors are flushed by the other handlers immediately
+void FileManager::try_flush_node_progress(FileNodePtr node, const char *source) {
+  try_flush_node_pmc(node, source);
+  if (!node->need_info_flush()) {
+    return;
+  }
+
+  auto min_interval = static_cast<double>(G()->get_option_integer(OptionId::FileProgressUpdateMinIntervalMs)) * 1e-3;
+  if (min_interval > 0.0) {
+    auto next_update_time = node->last_info_flush_time_ + min_interval;
+    auto min_delta = G()->get_option_integer(OptionId::FileProgressUpdateMinDelta);
+    auto delta = std::abs(node->local_ready_size_ + node->remote_.ready_size - node->last_info_flush_ready_size_);
+    if (Time::now() < next_update_time && (min_delta <= 0 || delta < min_delta)) {
+      auto key = node->main_file_id_.get();
+      if (!progress_update_timeout_.has_timeout(key)) {
+        progress_update_timeout_.set_timeout_at(key, next_update_time);
+      }
+      return;
+    }
+  }
+  try_flush_node_info(node, source);
+}
+
+void FileManager::on_progress_update_timeout_callback(void *file_manager_ptr, int64 file_id_int) {
+  auto file_manager = static_cast<FileManager *>(file_manager_ptr);
+  send_closure_later(file_manager->actor_id(file_manager), &FileManager::on_progress_update_timeout,
+                     FileId(narrow_cast<int32>(file_id_int), 0));
+}
+
+void FileManager::on_progress_update_timeout(FileId file_id) {
+  if (is_closed_) {
+    return;
+  }
+  auto node = get_file_node(file_id);
+  if (node) {
+    try_flush_node_info(node, "on_progress_update_timeout");
+  }
+}
+
 void FileManager::clear_from_pmc(FileNodePtr node) {
   if (!file_db_) {
     return;
@@ -2217,7 +2294,7 @@ bool FileManager::set_encryption_key(FileId file_id, FileEncryptionKey key) {
 }
 
 bool FileManager::set_content(FileId file_id, BufferSlice bytes) {
-  if (G()->get_option_boolean("ignore_inline_thumbnails")) {
+  if (G()->get_option_boolean(OptionId::IgnoreInlineThumbnails)) {
     return false;
   }
 
@@ -2285,12 +2362,13 @@ void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int
 
   auto file_view = FileView(node);
 
+  auto downloaded_prefix = file_view.downloaded_prefix(offset);
   if (count == 0) {
-    count = file_view.downloaded_prefix(offset);
+    count = downloaded_prefix;
     if (count == 0) {
       return promise.set_value(td_api::make_object<td_api::filePart>());
     }
-  } else if (file_view.downloaded_prefix(offset) < count) {
+  } else if (downloaded_prefix < count) {
     // TODO this check is safer to do in another thread
     return promise.set_error(Status::Error(400, "There is not enough downloaded bytes in the file to read"));
   }
@@ -2335,7 +2413,7 @@ void FileManager::read_file_part(FileId file_id, int64 offset, int64 count, int
           promise.set_value(std::move(result));
         }
       });
-  send_closure(file_load_manager_, &FileLoadManager::read_file_part, *path, offset, count,
+  send_closure(file_load_manager_, &FileLoadManager::read_file_part, *path, offset, count, downloaded_prefix,
                std::move(read_file_part_promise));
 }
 
@@ -2354,7 +2432,8 @@ void FileManager::delete_file(FileId file_id, Promise<Unit> promise, const char
     if (begins_with(file_view.local_location().path_, get_files_dir(file_view.get_type()))) {
       clear_from_pmc(node);
       if (context_->need_notify_on_new_files()) {
-        context_->on_new_file(-file_view.size(), -file_view.get_allocated_local_size(), -1);
+        context_->on_new_file(file_view.get_type(), file_view.owner_dialog_id(), -file_view.size(),
+                              -file_view.get_allocated_local_size(), -1);
       }
       path = std::move(node->local_.full().path_);
     }
@@ -2454,23 +2533,24 @@ void FileManager::download_impl(FileId file_id, std::shared_ptr<DownloadCallback
   node->set_download_limit(limit);
   auto *file_info = get_file_id_info(file_id);
   CHECK(new_priority == 0 || callback);
-  if (file_info->download_callback_ != nullptr && file_info->download_callback_.get() != callback.get()) {
+  auto old_callback = extract_download_callback(file_id);
+  if (old_callback != nullptr && old_callback.get() != callback.get()) {
     // the old callback will be destroyed soon and lost forever
     // this is a bug and must never happen, unless we cancel previous download query
     // but still there is no way to prevent this with the current FileManager implementation
     if (new_priority == 0) {
-      file_info->download_callback_->on_download_error(file_id, Status::Error(200, "Canceled"));
+      old_callback->on_download_error(file_id, Status::Error(200, "Canceled"));
     } else {
       LOG(ERROR) << "File " << file_id << " is used with different download callbacks";
-      file_info->download_callback_->on_download_error(file_id, Status::Error(500, "Internal Server Error"));
+      old_callback->on_download_error(file_id, Status::Error(500, "Internal Server Error"));
     }
   }
   file_info->ignore_download_limit = limit == IGNORE_DOWNLOAD_LIMIT;
   file_info->download_priority_ = narrow_cast<int8>(new_priority);
-  file_info->download_callback_ = std::move(callback);
 
-  if (file_info->download_callback_) {
-    file_info->download_callback_->on_progress(file_id);
+  if (callback) {
+    download_callbacks_[file_id.get()] = callback;
+    callback->on_progress(file_id);
   }
   // TODO: send current progress?
 
@@ -2549,6 +2629,10 @@ void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
   CHECK(!node->file_ids_.empty());
   auto file_id = node->main_file_id_;
 
+  if (try_download_from_shared_file_store(node, file_id)) {
+    return;
+  }
+
   if (node->need_reload_photo_ && file_view.may_reload_photo()) {
     LOG(INFO) << "Reload photo from file " << node->main_file_id_;
     QueryId query_id = queries_container_.create(Query{file_id, Query::Type::DownloadReloadDialog});
@@ -2612,6 +2696,96 @@ void FileManager::run_download(FileNodePtr node, bool force_update_priority) {
                download_limit, priority);
 }
 
+// files with the same unique identifier have the same content, so they can be shared by all clients of the process;
+// the store is trusted by file name and size only, so the directory must be writable only by trusted clients
+string FileManager::get_shared_file_store_path(string dir, Slice unique_file_id, int64 size) {
+  if (dir.empty() || unique_file_id.empty() || size <= 0) {
+    return string();
+  }
+  if (dir.back() != TD_DIR_SLASH) {
+    dir += TD_DIR_SLASH;
+  }
+  return PSTRING() << dir << unique_file_id << '_' << size;
+}
+
+string FileManager::get_shared_file_store_path(const FileView &file_view) {
+  if (file_view.is_encrypted_any()) {
+    return string();
+  }
+  return get_shared_file_store_path(G()->get_option_string("shared_file_store_directory"),
+                                    file_view.get_unique_file_id(), file_view.size());
+}
+
+Status FileManager::link_from_shared_file_store(CSlice store_path, int64 size, CSlice path) {
+  TRY_RESULT(store_stat, stat(store_path));
+  if (store_stat.size_ != size) {
+    return Status::Error(PSLICE() << "Shared file has size " << store_stat.size_ << " instead of " << size);
+  }
+  return hard_link(store_path, path);
+}
+
+Status FileManager::link_to_shared_file_store(CSlice path, CSlice store_path) {
+  mkpath(store_path).ignore();
+  // the link is created atomically, so other clients never see a partially written file
+  return hard_link(path, store_path);
+}
+
+bool FileManager::try_download_from_shared_file_store(FileNodePtr node, FileId file_id) {
+  if (node->local_.type() != LocalFileLocation::Type::Empty) {
+    return false;
+  }
+  FileView file_view(node);
+  auto store_path = get_shared_file_store_path(file_view);
+  if (store_path.empty() || stat(store_path).is_error()) {
+    return false;
+  }
+
+  // the file is linked to a temporary path first to choose its final name in the same way as for downloaded files
+  auto file_type = file_view.get_type();
+  auto r_temp_file = open_temp_file(file_type);
+  if (r_temp_file.is_error()) {
+    return false;
+  }
+  r_temp_file.ok_ref().first.close();
+  auto temp_path = std::move(r_temp_file.ok_ref().second);
+  unlink(temp_path).ignore();
+  auto status = link_from_shared_file_store(store_path, node->size_, temp_path);
+  if (status.is_error()) {
+    LOG(INFO) << "Can't use shared copy of file " << file_id << ": " << status;
+    return false;
+  }
+  auto r_path = create_from_temp(file_type, temp_path, node->suggested_path());
+  if (r_path.is_error()) {
+    LOG(INFO) << "Can't use shared copy of file " << file_id << ": " << r_path.error();
+    unlink(temp_path).ignore();
+    return false;
+  }
+
+  LOG(INFO) << "Use shared copy " << store_path << " of file " << file_id;
+  QueryId query_id = queries_container_.create(Query{file_id, Query::Type::Download});
+  node->download_id_ = query_id;
+  node->is_download_started_ = false;
+  send_closure_later(actor_id(this), &FileManager::on_download_ok, query_id,
+                     FullLocalFileLocation(file_type, r_path.move_as_ok(), 0), node->size_, true);
+  return true;
+}
+
+void FileManager::add_to_shared_file_store(FileId file_id) {
+  auto file_view = get_file_view(file_id);
+  if (!file_view.has_local_location()) {
+    return;
+  }
+  auto store_path = get_shared_file_store_path(file_view);
+  if (store_path.empty()) {
+    return;
+  }
+  auto status = link_to_shared_file_store(file_view.local_location().path_, store_path);
+  if (status.is_error()) {
+    // the file can be already added by another client
+    LOG(INFO) << "Can't add file " << file_id << " to shared file store: " << status;
+  }
+}
+
 class FileManager::ForceUploadActor final : public Actor {
  public:
   ForceUploadActor(FileManager *file_manager, FileId file_id, std::shared_ptr<FileManager::UploadCallback> callback,
@@ -2830,20 +3004,23 @@ void FileManager::resume_upload(FileId file_id, vector<int> bad_parts, std::shar
             << callback.get();
   auto *file_info = get_file_id_info(file_id);
   CHECK(new_priority == 0 || callback);
-  if (file_info->upload_callback_ != nullptr && file_info->upload_callback_.get() != callback.get()) {
+  auto old_callback = extract_upload_callback(file_id);
+  if (old_callback != nullptr && old_callback.get() != callback.get()) {
     // the old callback will be destroyed soon and lost forever
     // this is a bug and must never happen, unless we cancel previous upload query
     // but still there is no way to prevent this with the current FileManager implementation
     if (new_priority == 0) {
-      file_info->upload_callback_->on_upload_error(file_id, Status::Error(200, "Canceled"));
+      old_callback->on_upload_error(file_id, Status::Error(200, "Canceled"));
     } else {
       LOG(ERROR) << "File " << file_id << " is used with different upload callbacks";
-      file_info->upload_callback_->on_upload_error(file_id, Status::Error(500, "Internal Server Error"));
+      old_callback->on_upload_error(file_id, Status::Error(500, "Internal Server Error"));
     }
   }
   file_info->upload_order_ = upload_order;
   file_info->upload_priority_ = narrow_cast<int8>(new_priority);
-  file_info->upload_callback_ = std::move(callback);
+  if (callback) {
+    upload_callbacks_[file_id.get()] = std::move(callback);
+  }
   // TODO: send current progress?
 
   run_generate(node);
@@ -2982,7 +3159,11 @@ void FileManager::run_generate(FileNodePtr node) {
   }
 
   if (old_priority != 0) {
-    LOG(INFO) << "TODO: change file " << file_id << " generation priority";
+    if (old_priority != node->generate_priority_) {
+      LOG(INFO) << "Change file " << file_id << " generation priority to " << node->generate_priority_;
+      send_closure(file_generate_manager_, &FileGenerateManager::update_priority, node->generate_id_,
+                   node->generate_priority_);
+    }
     return;
   }
 
@@ -2990,7 +3171,7 @@ void FileManager::run_generate(FileNodePtr node) {
   node->generate_id_ = query_id;
   send_closure(
       file_generate_manager_, &FileGenerateManager::generate_file, query_id, *node->generate_, node->local_,
-      node->suggested_path(), [file_manager = this, query_id] {
+      node->suggested_path(), node->generate_priority_, [file_manager = this, query_id] {
         class Callback final : public FileGenerateCallback {
           ActorId<FileManager> actor_;
           uint64 query_id_;
@@ -3678,6 +3859,11 @@ FileId FileManager::next_file_id() {
 }
 
 FileManager::FileNodeId FileManager::next_file_node_id() {
+  if (!empty_file_node_ids_.empty()) {
+    auto res = empty_file_node_ids_.back();
+    empty_file_node_ids_.pop_back();
+    return res;
+  }
   CHECK(file_nodes_.size() <= static_cast<size_t>(std::numeric_limits<FileNodeId>::max()));
   auto res = static_cast<FileNodeId>(file_nodes_.size());
   file_nodes_.emplace_back(nullptr);
@@ -3733,7 +3919,7 @@ void FileManager::on_partial_download(QueryId query_id, PartialLocalFileLocation
     }
   }
   file_node->set_local_location(LocalFileLocation(std::move(partial_local)), ready_size, -1, -1 /* TODO */);
-  try_flush_node(file_node, "on_partial_download");
+  try_flush_node_progress(file_node, "on_partial_download");
 }
 
 void FileManager::on_hash(QueryId query_id, string hash) {
@@ -3781,7 +3967,7 @@ void FileManager::on_partial_upload(QueryId query_id, PartialRemoteFileLocation
   }
 
   file_node->set_partial_remote_location(std::move(partial_remote), ready_size);
-  try_flush_node(file_node, "on_partial_upload");
+  try_flush_node_progress(file_node, "on_partial_upload");
 }
 
 void FileManager::on_download_ok(QueryId query_id, FullLocalFileLocation local, int64 size, bool is_new) {
@@ -3800,7 +3986,12 @@ void FileManager::on_download_ok(QueryId query_id, FullLocalFileLocation local,
     status = Status::Error(PSLICE() << "Can't register local file after download: " << r_new_file_id.error().message());
   } else {
     if (is_new && context_->need_notify_on_new_files()) {
-      context_->on_new_file(size, get_file_view(r_new_file_id.ok()).get_allocated_local_size(), 1);
+      auto new_file_view = get_file_view(r_new_file_id.ok());
+      context_->on_new_file(new_file_view.get_type(), new_file_view.owner_dialog_id(), size,
+                            new_file_view.get_allocated_local_size(), 1);
+    }
+    if (is_new) {
+      add_to_shared_file_store(r_new_file_id.ok());
     }
   }
   if (status.is_error()) {
@@ -3854,20 +4045,20 @@ void FileManager::on_upload_ok(QueryId query_id, FileType file_type, PartialRemo
       input_file = make_tl_object<telegram_api::inputEncryptedFileUploaded>(
           partial_remote.file_id_, partial_remote.part_count_, "", file_view.encryption_key().calc_fingerprint());
     }
-    if (file_info->upload_callback_) {
+    auto upload_callback = extract_upload_callback(file_id);
+    if (upload_callback) {
       file_node->set_upload_pause(file_id);
-      file_info->upload_callback_->on_upload_encrypted_ok(file_id, std::move(input_file));
-      file_info->upload_callback_.reset();
+      upload_callback->on_upload_encrypted_ok(file_id, std::move(input_file));
     }
   } else if (file_view.is_secure()) {
     tl_object_ptr<telegram_api::InputSecureFile> input_file;
     input_file = make_tl_object<telegram_api::inputSecureFileUploaded>(
         partial_remote.file_id_, partial_remote.part_count_, "" /*md5*/, BufferSlice() /*file_hash*/,
         BufferSlice() /*encrypted_secret*/);
-    if (file_info->upload_callback_) {
+    auto upload_callback = extract_upload_callback(file_id);
+    if (upload_callback) {
       file_node->set_upload_pause(file_id);
-      file_info->upload_callback_->on_upload_secure_ok(file_id, std::move(input_file));
-      file_info->upload_callback_.reset();
+      upload_callback->on_upload_secure_ok(file_id, std::move(input_file));
     }
   } else {
     tl_object_ptr<telegram_api::InputFile> input_file;
@@ -3878,10 +4069,10 @@ void FileManager::on_upload_ok(QueryId query_id, FileType file_type, PartialRemo
       input_file = make_tl_object<telegram_api::inputFile>(partial_remote.file_id_, partial_remote.part_count_,
                                                            std::move(file_name), "");
     }
-    if (file_info->upload_callback_) {
+    auto upload_callback = extract_upload_callback(file_id);
+    if (upload_callback) {
       file_node->set_upload_pause(file_id);
-      file_info->upload_callback_->on_upload_ok(file_id, std::move(input_file));
-      file_info->upload_callback_.reset();
+      upload_callback->on_upload_ok(file_id, std::move(input_file));
     }
   }
   // don't flush node info, because nothing actually changed
@@ -3965,7 +4156,8 @@ void FileManager::on_generate_ok(QueryId query_id, FullLocalFileLocation local)
   FileView file_view(file_node);
   if (context_->need_notify_on_new_files()) {
     if (!file_view.has_generate_location() || !begins_with(file_view.generate_location().conversion_, "#file_id#")) {
-      context_->on_new_file(file_view.size(), file_view.get_allocated_local_size(), 1);
+      context_->on_new_file(file_view.get_type(), file_view.owner_dialog_id(), file_view.size(),
+                            file_view.get_allocated_local_size(), 1);
     }
   }
 
@@ -4132,16 +4324,16 @@ void FileManager::on_error_impl(FileNodePtr node, Query::Type type, bool was_act
     auto *info = get_file_id_info(file_id);
     if (info->download_priority_ != 0) {
       info->download_priority_ = 0;
-      if (info->download_callback_) {
-        info->download_callback_->on_download_error(file_id, status.clone());
-        info->download_callback_.reset();
+      auto download_callback = extract_download_callback(file_id);
+      if (download_callback) {
+        download_callback->on_download_error(file_id, status.clone());
       }
     }
     if (info->upload_priority_ != 0) {
       info->upload_priority_ = 0;
-      if (info->upload_callback_) {
-        info->upload_callback_->on_upload_error(file_id, status.clone());
-        info->upload_callback_.reset();
+      auto upload_callback = extract_upload_callback(file_id);
+      if (upload_callback) {
+        upload_callback->on_upload_error(file_id, status.clone());
       }
     }
   }
@@ -22,11 +22,13 @@
 #include "td/telegram/telegram_api.h"
 
 #include "td/actor/actor.h"
+#include "td/actor/MultiTimeout.h"
 
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/Container.h"
 #include "td/utils/Enumerator.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/FlatHashSet.h"
 #include "td/utils/logging.h"
 #include "td/utils/optional.h"
@@ -160,6 +162,10 @@ class FileNode {
 
   double last_successful_force_reupload_time_ = -1e10;
 
+  // time and loaded size at the last sending of updateFile, which are used to throttle progress updates
+  double last_info_flush_time_ = 0.0;
+  int64 last_info_flush_ready_size_ = 0;
+
   FileId upload_pause_;
 
   int8 upload_priority_ = 0;
@@ -414,7 +420,8 @@ class FileManager final : public FileLoadManager::Callback {
    public:
     virtual bool need_notify_on_new_files() = 0;
 
-    virtual void on_new_file(int64 size, int64 real_size, int32 cnt) = 0;
+    virtual void on_new_file(FileType file_type, DialogId owner_dialog_id, int64 size, int64 real_size,
+                             int32 cnt) = 0;
 
     virtual void on_file_updated(FileId size) = 0;
 
@@ -451,6 +458,12 @@ class FileManager final : public FileLoadManager::Callback {
 
   static vector<int> get_missing_file_parts(const Status &error);
 
+  static string get_shared_file_store_path(string dir, Slice unique_file_id, int64 size);
+
+  static Status link_from_shared_file_store(CSlice store_path, int64 size, CSlice path);
+
+  static Status link_to_shared_file_store(CSlice path, CSlice store_path);
+
   void init_actor();
 
   FileId dup_file_id(FileId file_id, const char *source);
@@ -508,6 +521,8 @@ class FileManager final : public FileLoadManager::Callback {
 
   void delete_file(FileId file_id, Promise<Unit> promise, const char *source);
 
+  void on_speed_limit_changed();
+
   void external_file_generate_write_part(int64 generation_id, int64 offset, string data, Promise<> promise);
   void external_file_generate_progress(int64 generation_id, int64 expected_size, int64 local_prefix_size,
                                        Promise<> promise);
@@ -598,9 +613,6 @@ class FileManager final : public FileLoadManager::Callback {
     int8 upload_priority_{0};
 
     uint64 upload_order_{0};
-
-    std::shared_ptr<DownloadCallback> download_callback_;
-    std::shared_ptr<UploadCallback> upload_callback_;
   };
 
   class ForceUploadActor;
@@ -611,6 +623,9 @@ class FileManager final : public FileLoadManager::Callback {
 
   FileIdInfo *get_file_id_info(FileId file_id);
 
+  std::shared_ptr<DownloadCallback> extract_download_callback(FileId file_id);
+  std::shared_ptr<UploadCallback> extract_upload_callback(FileId file_id);
+
   struct RemoteInfo {
     // mutable is set to to enable changing of access hash
     mutable FullRemoteFileLocation remote_;
@@ -634,11 +649,18 @@ class FileManager final : public FileLoadManager::Callback {
   WaitFreeVector<FileIdInfo> file_id_info_;
   WaitFreeVector<int32> empty_file_ids_;
   WaitFreeVector<unique_ptr<FileNode>> file_nodes_;
+  WaitFreeVector<FileNodeId> empty_file_node_ids_;
+
+  // callbacks are needed only for files being loaded, so they are kept outside of FileIdInfo
+  FlatHashMap<int32, std::shared_ptr<DownloadCallback>> download_callbacks_;
+  FlatHashMap<int32, std::shared_ptr<UploadCallback>> upload_callbacks_;
   ActorOwn<FileLoadManager> file_load_manager_;
   ActorOwn<FileGenerateManager> file_generate_manager_;
 
   Container<Query> queries_container_;
 
+  MultiTimeout progress_update_timeout_{"FileProgressUpdateTimeout"};
+
   bool is_closed_ = false;
 
   std::set<std::string> bad_paths_;
@@ -676,6 +698,9 @@ class FileManager final : public FileLoadManager::Callback {
   void try_flush_node_full(FileNodePtr node, bool new_remote, bool new_local, bool new_generate, FileDbId other_pmc_id);
   void try_flush_node(FileNodePtr node, const char *source);
   void try_flush_node_info(FileNodePtr node, const char *source);
+  void try_flush_node_progress(FileNodePtr node, const char *source);
+  static void on_progress_update_timeout_callback(void *file_manager_ptr, int64 file_id_int);
+  void on_progress_update_timeout(FileId file_id);
   void try_flush_node_pmc(FileNodePtr node, const char *source);
   void clear_from_pmc(FileNodePtr node);
   void flush_to_pmc(FileNodePtr node, bool new_remote, bool new_local, bool new_generate, const char *source);
@@ -708,6 +733,10 @@ class FileManager final : public FileLoadManager::Callback {
   void run_download(FileNodePtr node, bool force_update_priority);
   void run_generate(FileNodePtr node);
 
+  static string get_shared_file_store_path(const FileView &file_view);
+  bool try_download_from_shared_file_store(FileNodePtr node, FileId file_id);
+  void add_to_shared_file_store(FileId file_id);
+
   void on_start_download(QueryId query_id) final;
   void on_partial_download(QueryId query_id, PartialLocalFileLocation partial_local, int64 ready_size,
                            int64 size) final;
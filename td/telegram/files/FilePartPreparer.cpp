@@ -0,0 +1,47 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FilePartPreparer.h"
+
+#include "td/utils/crypto.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+
+namespace td {
+
+void FilePartPreparer::prepare_parts(string path, vector<Part> parts, bool need_encrypt, UInt256 key, UInt256 iv,
+                                     Promise<vector<PreparedPart>> promise) {
+  vector<PreparedPart> result;
+  auto r_fd = FileFd::open(path, FileFd::Read);
+  if (r_fd.is_error()) {
+    LOG(INFO) << "Failed to open file for upload part preparation: " << r_fd.error();
+    return promise.set_value(std::move(result));
+  }
+  auto fd = r_fd.move_as_ok();
+  for (auto &part : parts) {
+    auto padded_size = part.size;
+    if (need_encrypt) {
+      padded_size = (padded_size + 15) & ~15;
+    }
+    BufferSlice bytes(padded_size);
+    auto r_size = fd.pread(bytes.as_mutable_slice().truncate(part.size), part.offset);
+    if (r_size.is_error() || r_size.ok() != part.size) {
+      LOG(INFO) << "Failed to read part " << part.id << " for upload";
+      break;
+    }
+    if (need_encrypt) {
+      Random::secure_bytes(bytes.as_mutable_slice().substr(part.size));
+      aes_ige_encrypt(as_slice(key), as_mutable_slice(iv), bytes.as_slice(), bytes.as_mutable_slice());
+    }
+    result.push_back(PreparedPart{part, std::move(bytes), iv});
+  }
+  fd.close();
+  promise.set_value(std::move(result));
+}
+
+}  // namespace td
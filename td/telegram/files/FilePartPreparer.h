@@ -0,0 +1,35 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/telegram/files/PartsManager.h"
+
+#include "td/actor/actor.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+#include "td/utils/UInt.h"
+
+namespace td {
+
+// reads and encrypts parts of a file for upload in advance, so uploaders don't wait for disk and AES
+class FilePartPreparer final : public Actor {
+ public:
+  struct PreparedPart {
+    Part part_;
+    BufferSlice bytes_;
+    UInt256 next_iv_;  // IV after encryption of the part, if the file is secret
+  };
+
+  // parts must be consecutive; if need_encrypt, then the parts are encrypted by AES-IGE starting with the given IV
+  // returns successfully prepared prefix of the parts
+  void prepare_parts(string path, vector<Part> parts, bool need_encrypt, UInt256 key, UInt256 iv,
+                     Promise<vector<PreparedPart>> promise);
+};
+
+}  // namespace td
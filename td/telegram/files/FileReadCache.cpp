@@ -0,0 +1,116 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileReadCache.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/Stat.h"
+
+namespace td {
+
+static constexpr size_t MAX_CACHED_FILES = 16;
+static constexpr int64 READ_AHEAD_SIZE = 1 << 20;
+
+constexpr double FileReadCache::CACHED_FILE_TTL;
+
+Result<string> FileReadCache::read(const string &path, int64 offset, int64 count, int64 max_read_ahead_count,
+                                   double now) {
+  TRY_RESULT(file, get_file(path, now));
+
+  auto data_end = file->data_offset_ + static_cast<int64>(file->data_.size());
+  if (file->data_offset_ <= offset && offset + count <= data_end) {
+    file->last_read_end_ = offset + count;
+    auto data_begin = narrow_cast<size_t>(offset - file->data_offset_);
+    return file->data_.as_slice().substr(data_begin, narrow_cast<size_t>(count)).str();
+  }
+
+  auto file_size = file->size_;
+  if (offset > file_size) {
+    return Status::Error("Failed to read file: invalid offset");
+  }
+  if (count > file_size - offset) {
+    count = file_size - offset;
+  }
+
+  // read ahead only if the file is read sequentially
+  auto read_count = count;
+  if (offset == file->last_read_end_) {
+    read_count = td::min(td::max(count, READ_AHEAD_SIZE), td::min(max_read_ahead_count, file_size - offset));
+  }
+  BufferSlice data(narrow_cast<size_t>(read_count));
+  auto r_read_size = file->fd_.pread(data.as_mutable_slice(), offset);
+  if (r_read_size.is_error()) {
+    forget_file(path);
+    return r_read_size.move_as_error();
+  }
+  if (r_read_size.ok() < static_cast<size_t>(count)) {
+    forget_file(path);
+    return Status::Error("Failed to read file");
+  }
+  data.truncate(r_read_size.ok());
+
+  auto result = data.as_slice().substr(0, narrow_cast<size_t>(count)).str();
+  file->data_offset_ = offset;
+  file->data_ = std::move(data);
+  file->last_read_end_ = offset + count;
+  return std::move(result);
+}
+
+Result<FileReadCache::CachedFile *> FileReadCache::get_file(const string &path, double now) {
+  auto it = files_.find(path);
+  if (it != files_.end()) {
+    // the file could have been deleted, renamed, replaced or changed since it was opened
+    auto r_stat = stat(path);
+    if (r_stat.is_error()) {
+      files_.erase(it);
+      return r_stat.move_as_error();
+    }
+    auto &file = it->second;
+    if (r_stat.ok().size_ == file->size_ && r_stat.ok().mtime_nsec_ == file->mtime_nsec_) {
+      file->last_used_at_ = now;
+      return file.get();
+    }
+    LOG(DEBUG) << "Reopen changed file \"" << path << '"';
+    files_.erase(it);
+  }
+
+  TRY_RESULT(fd, FileFd::open(path, FileFd::Read));
+  TRY_RESULT(stat, fd.stat());
+  LOG(DEBUG) << "Open file \"" << path << "\" for reading parts";
+  if (files_.size() >= MAX_CACHED_FILES) {
+    // close the least recently used file
+    auto oldest_it = files_.begin();
+    for (auto file_it = files_.begin(); file_it != files_.end(); ++file_it) {
+      if (file_it->second->last_used_at_ < oldest_it->second->last_used_at_) {
+        oldest_it = file_it;
+      }
+    }
+    files_.erase(oldest_it);
+  }
+  auto &file = files_[path];
+  file = make_unique<CachedFile>();
+  file->fd_ = std::move(fd);
+  file->size_ = stat.size_;
+  file->mtime_nsec_ = stat.mtime_nsec_;
+  file->last_used_at_ = now;
+  return file.get();
+}
+
+void FileReadCache::forget_file(const string &path) {
+  files_.erase(path);
+}
+
+void FileReadCache::clear() {
+  files_.clear();
+}
+
+void FileReadCache::expire_files(double now) {
+  table_remove_if(files_, [now](const auto &it) { return it.second->last_used_at_ < now - CACHED_FILE_TTL; });
+}
+
+}  // namespace td
@@ -0,0 +1,55 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// cache of open files and recently read file bytes for sequential reading of small file parts
+// cached data is served only while size and modification time of the file at the path are unchanged
+class FileReadCache {
+ public:
+  static constexpr double CACHED_FILE_TTL = 10.0;
+
+  // reads count bytes starting from offset; bytes up to offset + max_read_ahead_count are known to be downloaded
+  // and can be read ahead
+  Result<string> read(const string &path, int64 offset, int64 count, int64 max_read_ahead_count, double now);
+
+  void forget_file(const string &path);
+
+  void clear();
+
+  // closes files, which weren't used for CACHED_FILE_TTL seconds
+  void expire_files(double now);
+
+  bool empty() const {
+    return files_.empty();
+  }
+
+ private:
+  struct CachedFile {
+    FileFd fd_;
+    int64 size_ = 0;
+    uint64 mtime_nsec_ = 0;
+    int64 data_offset_ = 0;
+    BufferSlice data_;
+    int64 last_read_end_ = -1;
+    double last_used_at_ = 0.0;
+  };
+
+  FlatHashMap<string, unique_ptr<CachedFile>> files_;
+
+  Result<CachedFile *> get_file(const string &path, double now);
+};
+
+}  // namespace td
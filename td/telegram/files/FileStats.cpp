@@ -202,6 +202,39 @@ vector<FullFileInfo> FileStats::get_all_files() {
   return std::move(all_files_);
 }
 
+void FileStats::add_delta(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt) {
+  auto pos = static_cast<size_t>(file_type);
+  CHECK(pos < stat_by_type_.size());
+  auto &stat = split_by_owner_dialog_id_ ? stat_by_owner_dialog_id_[owner_dialog_id][pos] : stat_by_type_[pos];
+  stat.size += size;
+  stat.cnt += cnt;
+  if (stat.size < 0 || stat.cnt < 0 || (stat.cnt == 0 && stat.size != 0)) {
+    // the file wasn't counted before
+    stat = FileTypeStat();
+  }
+}
+
+void FileStats::merge_owner_dialogs() {
+  if (!split_by_owner_dialog_id_) {
+    return;
+  }
+  for (auto &dialog : stat_by_owner_dialog_id_) {
+    for (int32 i = 0; i < MAX_FILE_TYPE; i++) {
+      stat_by_type_[i].size += dialog.second[i].size;
+      stat_by_type_[i].cnt += dialog.second[i].cnt;
+    }
+  }
+  stat_by_owner_dialog_id_.clear();
+  split_by_owner_dialog_id_ = false;
+}
+
+FileStats FileStats::get_aggregated_copy() const {
+  FileStats result(false, split_by_owner_dialog_id_);
+  result.stat_by_type_ = stat_by_type_;
+  result.stat_by_owner_dialog_id_ = stat_by_owner_dialog_id_;
+  return result;
+}
+
 static StringBuilder &operator<<(StringBuilder &sb, const FileTypeStat &stat) {
   return sb << tag("size", format::as_size(stat.size)) << tag("count", stat.cnt);
 }
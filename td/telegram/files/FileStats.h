@@ -10,6 +10,7 @@
 #include "td/telegram/files/FileType.h"
 
 #include "td/utils/common.h"
+#include "td/utils/misc.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tl_helpers.h"
 
@@ -80,6 +81,37 @@ class FileStats {
 
   void add(StatByType &by_type, FileType file_type, int64 size);
 
+  template <class StorerT>
+  static void store_stat_by_type(const StatByType &by_type, StorerT &storer) {
+    int32 type_count = 0;
+    for (auto &stat : by_type) {
+      if (stat.cnt != 0) {
+        type_count++;
+      }
+    }
+    td::store(type_count, storer);
+    for (int32 i = 0; i < MAX_FILE_TYPE; i++) {
+      if (by_type[i].cnt != 0) {
+        td::store(i, storer);
+        td::store(by_type[i], storer);
+      }
+    }
+  }
+
+  template <class ParserT>
+  static void parse_stat_by_type(StatByType &by_type, ParserT &parser) {
+    int32 type_count;
+    td::parse(type_count, parser);
+    for (int32 i = 0; i < type_count; i++) {
+      int32 file_type;
+      td::parse(file_type, parser);
+      if (file_type < 0 || file_type >= MAX_FILE_TYPE) {
+        return parser.set_error("Invalid file type");
+      }
+      td::parse(by_type[file_type], parser);
+    }
+  }
+
   static FileTypeStat get_nontemp_stat(const StatByType &by_type);
 
   static td_api::object_ptr<td_api::storageStatisticsByChat> get_storage_statistics_by_chat_object(
@@ -88,6 +120,8 @@ class FileStats {
   friend StringBuilder &operator<<(StringBuilder &sb, const FileStats &file_stats);
 
  public:
+  FileStats() = default;
+
   FileStats(bool need_all_files, bool split_by_owner_dialog_id)
       : need_all_files_(need_all_files), split_by_owner_dialog_id_(split_by_owner_dialog_id) {
   }
@@ -107,6 +141,47 @@ class FileStats {
   FileTypeStat get_total_nontemp_stat() const;
 
   vector<FullFileInfo> get_all_files();
+
+  // adds cnt files of the given total size; size and cnt are negative if files are removed
+  void add_delta(FileType file_type, DialogId owner_dialog_id, int64 size, int32 cnt);
+
+  // joins statistics of all owner dialogs
+  void merge_owner_dialogs();
+
+  // returns statistics without the list of all files
+  FileStats get_aggregated_copy() const;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    CHECK(!need_all_files_);
+    td::store(split_by_owner_dialog_id_, storer);
+    if (!split_by_owner_dialog_id_) {
+      store_stat_by_type(stat_by_type_, storer);
+      return;
+    }
+    td::store(narrow_cast<int32>(stat_by_owner_dialog_id_.size()), storer);
+    for (auto &it : stat_by_owner_dialog_id_) {
+      td::store(it.first, storer);
+      store_stat_by_type(it.second, storer);
+    }
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    need_all_files_ = false;
+    td::parse(split_by_owner_dialog_id_, parser);
+    if (!split_by_owner_dialog_id_) {
+      parse_stat_by_type(stat_by_type_, parser);
+      return;
+    }
+    int32 dialog_count;
+    td::parse(dialog_count, parser);
+    for (int32 i = 0; i < dialog_count && parser.get_error() == nullptr; i++) {
+      DialogId dialog_id;
+      td::parse(dialog_id, parser);
+      parse_stat_by_type(stat_by_owner_dialog_id_[dialog_id], parser);
+    }
+  }
 };
 
 StringBuilder &operator<<(StringBuilder &sb, const FileStats &file_stats);
@@ -25,14 +25,18 @@
 
 namespace td {
 
+static constexpr size_t MAX_PREPARED_PART_COUNT = 8;
+static constexpr int64 MAX_PREPARED_PARTS_SIZE = 4 << 20;
+
 FileUploader::FileUploader(const LocalFileLocation &local, const RemoteFileLocation &remote, int64 expected_size,
                            const FileEncryptionKey &encryption_key, std::vector<int> bad_parts,
-                           unique_ptr<Callback> callback)
+                           std::shared_ptr<SpeedLimiter> speed_limiter, unique_ptr<Callback> callback)
     : local_(local)
     , remote_(remote)
     , expected_size_(expected_size)
     , encryption_key_(encryption_key)
     , bad_parts_(std::move(bad_parts))
+    , speed_limiter_(std::move(speed_limiter))
     , callback_(std::move(callback)) {
   if (encryption_key_.is_secret()) {
     iv_ = encryption_key_.mutable_iv();
@@ -94,6 +98,7 @@ Result<FileLoader::FileInfo> FileUploader::init() {
   res.part_size = part_size;
   res.ready_parts = std::move(parts);
   res.is_upload = true;
+  res.speed_limiter = speed_limiter_;
   return res;
 }
 
@@ -167,6 +172,9 @@ Result<FileLoader::PrefixInfo> FileUploader::on_update_local_location(const Loca
 
     fd_.close();
     fd_ = res_fd.move_as_ok();
+    if (fd_path_ != path) {
+      reset_prepared_parts();
+    }
     fd_path_ = path;
     is_temp_ = is_temp;
   }
@@ -201,6 +209,8 @@ Result<FileLoader::PrefixInfo> FileUploader::on_update_local_location(const Loca
 }
 
 Status FileUploader::on_ok(int64 size) {
+  reset_prepared_parts();
+  part_preparer_.reset();
   fd_.close();
   if (is_temp_) {
     LOG(INFO) << "UNLINK " << fd_path_;
@@ -210,6 +220,8 @@ Status FileUploader::on_ok(int64 size) {
 }
 
 void FileUploader::on_error(Status status) {
+  reset_prepared_parts();
+  part_preparer_.reset();
   fd_.close();
   if (is_temp_) {
     LOG(INFO) << "UNLINK " << fd_path_;
@@ -254,32 +266,36 @@ void FileUploader::after_start_parts() {
 }
 
 Result<std::pair<NetQueryPtr, bool>> FileUploader::start_part(Part part, int32 part_count, int64 streaming_offset) {
-  auto padded_size = part.size;
-  if (encryption_key_.is_secret()) {
-    padded_size = (padded_size + 15) & ~15;
-  }
-  BufferSlice bytes(padded_size);
-  TRY_RESULT(size, fd_.pread(bytes.as_mutable_slice().truncate(part.size), part.offset));
-  if (encryption_key_.is_secret()) {
-    Random::secure_bytes(bytes.as_mutable_slice().substr(part.size));
-    if (next_offset_ == part.offset) {
-      aes_ige_encrypt(as_slice(encryption_key_.key()), as_mutable_slice(iv_), bytes.as_slice(),
-                      bytes.as_mutable_slice());
-      next_offset_ += static_cast<int64>(bytes.size());
-    } else {
-      if (part.id >= static_cast<int32>(iv_map_.size())) {
-        TRY_STATUS(generate_iv_map());
+  BufferSlice bytes;
+  if (!use_prepared_part(part, bytes)) {
+    auto padded_size = part.size;
+    if (encryption_key_.is_secret()) {
+      padded_size = (padded_size + 15) & ~15;
+    }
+    bytes = BufferSlice(padded_size);
+    TRY_RESULT(size, fd_.pread(bytes.as_mutable_slice().truncate(part.size), part.offset));
+    if (encryption_key_.is_secret()) {
+      Random::secure_bytes(bytes.as_mutable_slice().substr(part.size));
+      if (next_offset_ == part.offset) {
+        aes_ige_encrypt(as_slice(encryption_key_.key()), as_mutable_slice(iv_), bytes.as_slice(),
+                        bytes.as_mutable_slice());
+        next_offset_ += static_cast<int64>(bytes.size());
+      } else {
+        if (part.id >= static_cast<int32>(iv_map_.size())) {
+          TRY_STATUS(generate_iv_map());
+        }
+        CHECK(part.id < static_cast<int32>(iv_map_.size()) && part.id >= 0);
+        auto iv = iv_map_[part.id];
+        aes_ige_encrypt(as_slice(encryption_key_.key()), as_mutable_slice(iv), bytes.as_slice(),
+                        bytes.as_mutable_slice());
       }
-      CHECK(part.id < static_cast<int32>(iv_map_.size()) && part.id >= 0);
-      auto iv = iv_map_[part.id];
-      aes_ige_encrypt(as_slice(encryption_key_.key()), as_mutable_slice(iv), bytes.as_slice(),
-                      bytes.as_mutable_slice());
     }
-  }
 
-  if (size != part.size) {
-    return Status::Error("Failed to read file part");
+    if (size != part.size) {
+      return Status::Error("Failed to read file part");
+    }
   }
+  on_part_started(part);
 
   NetQueryPtr net_query;
   if (big_flag_) {
@@ -324,6 +340,129 @@ void FileUploader::on_progress(Progress progress) {
   }
 }
 
+bool FileUploader::use_prepared_part(const Part &part, BufferSlice &bytes) {
+  auto it = prepared_parts_.find(part.id);
+  if (it == prepared_parts_.end()) {
+    return false;
+  }
+  auto prepared_part = std::move(it->second);
+  prepared_parts_.erase(it);
+  prepared_size_ -= static_cast<int64>(prepared_part.part_.size);
+  if (prepared_part.part_.offset != part.offset || prepared_part.part_.size != part.size) {
+    return false;
+  }
+  if (encryption_key_.is_secret()) {
+    if (next_offset_ != part.offset) {
+      // the part was encrypted as a continuation of the previous part
+      return false;
+    }
+    iv_ = prepared_part.next_iv_;
+    next_offset_ += static_cast<int64>(prepared_part.bytes_.size());
+  }
+  bytes = std::move(prepared_part.bytes_);
+  return true;
+}
+
+void FileUploader::on_part_started(const Part &part) {
+  max_started_part_id_ = td::max(max_started_part_id_, part.id);
+  while (!prepared_parts_.empty() && prepared_parts_.begin()->first <= max_started_part_id_) {
+    prepared_size_ -= static_cast<int64>(prepared_parts_.begin()->second.part_.size);
+    prepared_parts_.erase(prepared_parts_.begin());
+  }
+  if (next_prepare_part_id_ <= part.id) {
+    reset_prepared_parts();
+    if (encryption_key_.is_secret() && next_offset_ != static_cast<int64>(get_part_size()) * (part.id + 1)) {
+      // the next part will not be encrypted sequentially
+      return;
+    }
+    next_prepare_part_id_ = part.id + 1;
+    prepare_iv_ = iv_;
+  }
+  prepare_parts();
+}
+
+void FileUploader::reset_prepared_parts() {
+  prepared_parts_.clear();
+  prepared_size_ = 0;
+  next_prepare_part_id_ = -1;
+  is_preparing_parts_ = false;
+  prepare_generation_++;
+}
+
+void FileUploader::prepare_parts() {
+  if (is_preparing_parts_ || next_prepare_part_id_ < 0 || fd_path_.empty()) {
+    return;
+  }
+  auto part_size = get_part_size();
+  if (part_size == 0) {
+    return;
+  }
+
+  vector<Part> parts;
+  while (prepared_parts_.size() + parts.size() < MAX_PREPARED_PART_COUNT &&
+         prepared_size_ + static_cast<int64>(part_size) <= MAX_PREPARED_PARTS_SIZE) {
+    auto offset = static_cast<int64>(part_size) * next_prepare_part_id_;
+    if (offset >= local_size_) {
+      break;
+    }
+    auto size = static_cast<size_t>(td::min(static_cast<int64>(part_size), local_size_ - offset));
+    if (size < part_size && !local_is_ready_) {
+      // the part can still grow
+      break;
+    }
+    parts.push_back(Part{next_prepare_part_id_, offset, size});
+    prepared_size_ += static_cast<int64>(size);
+    next_prepare_part_id_++;
+  }
+  if (parts.empty()) {
+    return;
+  }
+
+  if (part_preparer_.empty()) {
+    part_preparer_ = create_actor_on_scheduler<FilePartPreparer>("FilePartPreparer", G()->get_gc_scheduler_id());
+  }
+  is_preparing_parts_ = true;
+  send_closure(part_preparer_, &FilePartPreparer::prepare_parts, fd_path_, std::move(parts),
+               encryption_key_.is_secret(), encryption_key_.is_secret() ? encryption_key_.key() : UInt256(),
+               prepare_iv_,
+               PromiseCreator::lambda([actor_id = actor_id(this), generation = prepare_generation_](
+                                          Result<vector<FilePartPreparer::PreparedPart>> r_prepared_parts) {
+                 if (r_prepared_parts.is_ok()) {
+                   send_closure(actor_id, &FileUploader::on_parts_prepared, generation, r_prepared_parts.move_as_ok());
+                 }
+               }));
+}
+
+void FileUploader::on_parts_prepared(uint64 generation, vector<FilePartPreparer::PreparedPart> prepared_parts) {
+  if (generation != prepare_generation_) {
+    return;
+  }
+  is_preparing_parts_ = false;
+
+  int32 next_part_id = -1;
+  for (auto &prepared_part : prepared_parts) {
+    next_part_id = prepared_part.part_.id + 1;
+    prepare_iv_ = prepared_part.next_iv_;
+    if (prepared_part.part_.id <= max_started_part_id_) {
+      // the part has already been read synchronously
+      prepared_size_ -= static_cast<int64>(prepared_part.part_.size);
+      continue;
+    }
+    auto part_id = prepared_part.part_.id;
+    prepared_parts_.emplace(part_id, std::move(prepared_part));
+  }
+  if (next_part_id != next_prepare_part_id_) {
+    // failed to prepare some parts; wait for the next synchronously read part to restart preparation
+    next_prepare_part_id_ = -1;
+    prepared_size_ = 0;
+    for (auto &it : prepared_parts_) {
+      prepared_size_ += static_cast<int64>(it.second.part_.size);
+    }
+    return;
+  }
+  prepare_parts();
+}
+
 FileLoader::Callback *FileUploader::get_callback() {
   return static_cast<FileLoader::Callback *>(callback_.get());
 }
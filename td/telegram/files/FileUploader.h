@@ -9,13 +9,19 @@
 #include "td/telegram/files/FileEncryptionKey.h"
 #include "td/telegram/files/FileLoader.h"
 #include "td/telegram/files/FileLocation.h"
+#include "td/telegram/files/FilePartPreparer.h"
 #include "td/telegram/files/FileType.h"
+#include "td/telegram/files/SpeedLimiter.h"
+
+#include "td/actor/actor.h"
 
 #include "td/utils/common.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/Status.h"
 #include "td/utils/UInt.h"
 
+#include <map>
+#include <memory>
 #include <utility>
 
 namespace td {
@@ -31,7 +37,8 @@ class FileUploader final : public FileLoader {
   };
 
   FileUploader(const LocalFileLocation &local, const RemoteFileLocation &remote, int64 expected_size,
-               const FileEncryptionKey &encryption_key, std::vector<int> bad_parts, unique_ptr<Callback> callback);
+               const FileEncryptionKey &encryption_key, std::vector<int> bad_parts,
+               std::shared_ptr<SpeedLimiter> speed_limiter, unique_ptr<Callback> callback);
 
   // Should just implement all parent pure virtual methods.
   // Must not call any of them...
@@ -42,6 +49,7 @@ class FileUploader final : public FileLoader {
   int64 expected_size_;
   FileEncryptionKey encryption_key_;
   std::vector<int> bad_parts_;
+  std::shared_ptr<SpeedLimiter> speed_limiter_;
   unique_ptr<Callback> callback_;
   int64 local_size_ = 0;
   bool local_is_ready_ = false;
@@ -59,6 +67,16 @@ class FileUploader final : public FileLoader {
   int64 file_id_ = 0;
   bool big_flag_ = false;
 
+  // parts, which are read and encrypted in advance on another thread
+  ActorOwn<FilePartPreparer> part_preparer_;
+  std::map<int32, FilePartPreparer::PreparedPart> prepared_parts_;
+  int64 prepared_size_ = 0;  // including parts, which are being prepared
+  int32 next_prepare_part_id_ = -1;
+  UInt256 prepare_iv_;
+  int32 max_started_part_id_ = -1;
+  bool is_preparing_parts_ = false;
+  uint64 prepare_generation_ = 0;
+
   Result<FileInfo> init() final TD_WARN_UNUSED_RESULT;
   Status on_ok(int64 size) final TD_WARN_UNUSED_RESULT;
   void on_error(Status status) final;
@@ -74,6 +92,12 @@ class FileUploader final : public FileLoader {
 
   Status generate_iv_map();
 
+  bool use_prepared_part(const Part &part, BufferSlice &bytes);
+  void on_part_started(const Part &part);
+  void reset_prepared_parts();
+  void prepare_parts();
+  void on_parts_prepared(uint64 generation, vector<FilePartPreparer::PreparedPart> prepared_parts);
+
   bool keep_fd_ = false;
   void keep_fd_flag(bool keep_fd) final;
   void try_release_fd();
@@ -82,6 +82,11 @@ void PartsManager::set_streaming_limit(int64 limit) {
   }
 }
 
+void PartsManager::set_min_part_size(size_t min_part_size) {
+  LOG_CHECK(min_part_size <= MAX_PART_SIZE && (min_part_size & (min_part_size - 1)) == 0) << min_part_size;
+  min_part_size_ = min_part_size;
+}
+
 Status PartsManager::init_no_size(size_t part_size, const std::vector<int> &ready_parts) {
   unknown_size_flag_ = true;
   size_ = 0;
@@ -91,7 +96,7 @@ Status PartsManager::init_no_size(size_t part_size, const std::vector<int> &read
   if (part_size != 0) {
     part_size_ = part_size;
   } else {
-    part_size_ = 32 << 10;
+    part_size_ = max(static_cast<size_t>(32 << 10), min_part_size_);
     while (part_size_ < MAX_PART_SIZE && calc_part_count(expected_size_, part_size_) > MAX_PART_COUNT) {
       part_size_ *= 2;
     }
@@ -133,7 +138,7 @@ Status PartsManager::init(int64 size, int64 expected_size, bool is_size_final, s
       return Status::Error("FILE_UPLOAD_RESTART");
     }
   } else {
-    part_size_ = 64 << 10;
+    part_size_ = max(static_cast<size_t>(64 << 10), min_part_size_);
     while (part_size_ < MAX_PART_SIZE && calc_part_count(expected_size_, part_size_) > MAX_PART_COUNT) {
       part_size_ *= 2;
     }
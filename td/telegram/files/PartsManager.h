@@ -22,6 +22,8 @@ struct Part {
 
 class PartsManager {
  public:
+  // must be called before init; the part size is chosen to be not less than min_part_size, if it isn't specified
+  void set_min_part_size(size_t min_part_size);
   Status init(int64 size, int64 expected_size, bool is_size_final, size_t part_size,
               const std::vector<int> &ready_parts, bool use_part_count_limit, bool is_upload) TD_WARN_UNUSED_RESULT;
   bool may_finish();
@@ -77,6 +79,7 @@ class PartsManager {
   int64 ready_size_{0};
   int64 streaming_ready_size_{0};
 
+  size_t min_part_size_{0};
   size_t part_size_{0};
   int part_count_{0};
   int pending_count_{0};
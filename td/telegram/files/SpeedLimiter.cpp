@@ -0,0 +1,42 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/SpeedLimiter.h"
+
+#include "td/utils/common.h"
+
+namespace td {
+
+static constexpr double MAX_BURST_TIME = 1.0;  // maximum time during which unused speed is accumulated
+
+double SpeedLimiter::get_wakeup_time(int64 speed_limit, double now) {
+  is_limited_ = speed_limit > 0;
+  if (!is_limited_) {
+    available_ = 0.0;
+    updated_at_ = now;
+    return 0.0;
+  }
+
+  auto speed = static_cast<double>(speed_limit);
+  if (now > updated_at_) {
+    available_ = min(available_ + (now - updated_at_) * speed, speed * MAX_BURST_TIME);
+    updated_at_ = now;
+  }
+  if (available_ < 0.0) {
+    // the previous parts were bigger than the available budget; wait until they are paid off
+    return now + -available_ / speed;
+  }
+  return 0.0;
+}
+
+void SpeedLimiter::on_part_started(int64 size) {
+  if (is_limited_) {
+    // allow to send a part bigger than the budget, so that big parts can be sent even with a low speed limit
+    available_ -= static_cast<double>(size);
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,30 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// token bucket, which limits total speed of file part transfers in one direction
+// it is shared between all file loaders of the direction and must be used only from the scheduler of the loaders
+class SpeedLimiter {
+ public:
+  // returns 0 if a new part can be sent now, or time after which the part can be sent
+  // speed_limit is the maximum speed in bytes per second; non-positive value means no limit
+  double get_wakeup_time(int64 speed_limit, double now);
+
+  // accounts a part of the given size, which was started after get_wakeup_time had returned 0
+  void on_part_started(int64 size);
+
+ private:
+  double available_ = 0.0;
+  double updated_at_ = 0.0;
+  bool is_limited_ = false;
+};
+
+}  // namespace td
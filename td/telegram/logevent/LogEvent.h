@@ -22,6 +22,9 @@
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
 
+#include <cstring>
+#include <utility>
+
 namespace td {
 namespace log_event {
 
@@ -124,6 +127,9 @@ class LogEvent {
     ResetWebAuthorizationOnServer = 0x506,
     ResetWebAuthorizationsOnServer = 0x507,
     InvalidateSignInCodesOnServer = 0x508,
+    SendMessageBroadcast = 0x600,
+    UpdateMessageBroadcastProgress = 0x601,
+    BinlogShards = 0x700,
     ConfigPmcMagic = 0x1f18,
     BinlogPmcMagic = 0x4327
   };
@@ -174,6 +180,20 @@ class LogEventStorerUnsafe final : public WithContext<TlStorerUnsafe, Global *>
   }
 };
 
+class LogEventStorerGrowable final : public WithContext<TlStorerGrowable, Global *> {
+ public:
+  explicit LogEventStorerGrowable(string &buffer) : WithContext<TlStorerGrowable, Global *>(buffer) {
+    store_int(static_cast<int32>(Version::Next) - 1);
+    set_context(G());
+  }
+};
+
+// returns a thread-local buffer for single-pass serialization, which must be returned with release_store_buffer
+string acquire_store_buffer();
+
+void release_store_buffer(string &&buffer);
+
+// the event is serialized once on the first size request and copied by each store
 template <class T>
 class LogEventStorerImpl final : public Storer {
  public:
@@ -181,22 +201,28 @@ class LogEventStorerImpl final : public Storer {
   }
 
   size_t size() const final {
-    LogEventStorerCalcLength storer;
-    td::store(event_, storer);
-    return storer.get_length();
+    if (!is_stored_) {
+      LogEventStorerGrowable storer(buffer_);
+      td::store(event_, storer);
+      buffer_.resize(storer.get_length());
+      is_stored_ = true;
+    }
+    return buffer_.size();
   }
   size_t store(uint8 *ptr) const final {
-    LogEventStorerUnsafe storer(ptr);
-    td::store(event_, storer);
+    auto length = size();
+    std::memcpy(ptr, buffer_.data(), length);
 #ifdef TD_DEBUG
     T check_result;
-    log_event_parse(check_result, Slice(ptr, storer.get_buf())).ensure();
+    log_event_parse(check_result, Slice(ptr, length)).ensure();
 #endif
-    return static_cast<size_t>(storer.get_buf() - ptr);
+    return length;
   }
 
  private:
   const T &event_;
+  mutable string buffer_;
+  mutable bool is_stored_ = false;
 };
 
 }  // namespace log_event
@@ -204,6 +230,7 @@ class LogEventStorerImpl final : public Storer {
 using LogEvent = log_event::LogEvent;
 using LogEventParser = log_event::LogEventParser;
 using LogEventStorerCalcLength = log_event::LogEventStorerCalcLength;
+using LogEventStorerGrowable = log_event::LogEventStorerGrowable;
 using LogEventStorerUnsafe = log_event::LogEventStorerUnsafe;
 
 template <class T>
@@ -224,15 +251,12 @@ inline int32 log_event_get_version(Slice slice) {
 
 template <class T>
 BufferSlice log_event_store_impl(const T &data, const char *file, int line) {
-  LogEventStorerCalcLength storer_calc_length;
-  store(data, storer_calc_length);
-
-  BufferSlice value_buffer{storer_calc_length.get_length()};
-  auto ptr = value_buffer.as_mutable_slice().ubegin();
-  LOG_CHECK(is_aligned_pointer<4>(ptr)) << ptr;
+  auto buffer = log_event::acquire_store_buffer();
+  LogEventStorerGrowable storer(buffer);
+  store(data, storer);
 
-  LogEventStorerUnsafe storer_unsafe(ptr);
-  store(data, storer_unsafe);
+  BufferSlice value_buffer(storer.as_slice());
+  log_event::release_store_buffer(std::move(buffer));
 
 #ifdef TD_DEBUG
   T check_result;
@@ -7,15 +7,38 @@
 #include "td/telegram/logevent/LogEventHelper.h"
 
 #include "td/telegram/Global.h"
+#include "td/telegram/logevent/LogEvent.h"
 #include "td/telegram/TdDb.h"
 
 #include "td/db/binlog/BinlogHelper.h"
 
 #include "td/utils/logging.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/Status.h"
 
+#include <utility>
+
 namespace td {
 
+namespace log_event {
+
+static TD_THREAD_LOCAL string *current_store_buffer;
+
+string acquire_store_buffer() {
+  init_thread_local<string>(current_store_buffer);
+  // the buffer is moved out, so nested serialization gets its own buffer
+  return std::move(*current_store_buffer);
+}
+
+void release_store_buffer(string &&buffer) {
+  static constexpr size_t MAX_KEPT_BUFFER_SIZE = 1 << 20;
+  if (buffer.size() <= MAX_KEPT_BUFFER_SIZE) {
+    *current_store_buffer = std::move(buffer);
+  }
+}
+
+}  // namespace log_event
+
 void add_log_event(LogEventIdWithGeneration &log_event_id, const Storer &storer, uint32 type, Slice name) {
   LOG(INFO) << "Save " << name << " to binlog";
   if (log_event_id.log_event_id == 0) {
@@ -165,6 +165,7 @@ void ConnectionCreator::add_proxy(int32 old_proxy_id, string server, int32 port,
     }
 
     proxies_.erase(old_proxy_id);
+    forget_proxy_ping(old_proxy_id);
     G()->td_db()->get_binlog_pmc()->erase(get_proxy_used_database_key(old_proxy_id));
     proxy_last_used_date_.erase(old_proxy_id);
     proxy_last_used_saved_date_.erase(old_proxy_id);
@@ -224,6 +225,7 @@ void ConnectionCreator::remove_proxy(int32 proxy_id, Promise<Unit> promise) {
   }
 
   proxies_.erase(proxy_id);
+  forget_proxy_ping(proxy_id);
 
   G()->td_db()->get_binlog_pmc()->erase(get_proxy_database_key(proxy_id));
   G()->td_db()->get_binlog_pmc()->erase(get_proxy_used_database_key(proxy_id));
@@ -319,6 +321,25 @@ void ConnectionCreator::ping_proxy(int32 proxy_id, Promise<double> promise) {
   if (it == proxies_.end()) {
     return promise.set_error(Status::Error(400, "Unknown proxy identifier"));
   }
+  auto result_it = ping_proxy_results_.find(proxy_id);
+  if (result_it != ping_proxy_results_.end() && result_it->second.expires_at > Time::now()) {
+    auto ping_time = result_it->second.ping_time;
+    return promise.set_value(std::move(ping_time));
+  }
+
+  auto &token = ping_proxy_request_tokens_[proxy_id];
+  if (token != 0) {
+    ping_proxy_requests_[token].promises.push_back(std::move(promise));
+    return;
+  }
+  token = next_token();
+  auto &request = ping_proxy_requests_[token];
+  request.proxy_id = proxy_id;
+  request.promises.push_back(std::move(promise));
+  promise = PromiseCreator::lambda([actor_id = actor_id(this), token](Result<double> result) {
+    send_closure(actor_id, &ConnectionCreator::on_ping_proxy_result, token, std::move(result));
+  });
+
   const Proxy &proxy = it->second;
   bool prefer_ipv6 = G()->get_option_boolean("prefer_ipv6");
   send_closure(get_dns_resolver(), &GetHostByNameActor::run, proxy.server().str(), proxy.port(), prefer_ipv6,
@@ -611,8 +632,19 @@ void ConnectionCreator::request_raw_connection(DcId dc_id, bool allow_media_only
   VLOG(connections) << "Request connection for " << tag("client", format::as_hex(client.hash)) << " to " << dc_id << " "
                     << tag("allow_media_only", allow_media_only);
   client.queries.push_back(std::move(promise));
+  client.keep_warm_until = Time::now() + ClientInfo::WARM_STANDBY_PERIOD;
 
+  auto ready_connection_count = client.ready_connections.size();
+  auto query_count = client.queries.size();
   client_loop(client);
+  if (client.queries.size() < query_count && ready_connection_count > 0) {
+    warm_connection_stats_.hit_count++;
+  } else {
+    warm_connection_stats_.miss_count++;
+  }
+  VLOG(connections) << "Warm connection hit count = " << warm_connection_stats_.hit_count
+                    << ", miss count = " << warm_connection_stats_.miss_count
+                    << ", saved time = " << format::as_time(warm_connection_stats_.saved_time);
 }
 
 void ConnectionCreator::request_raw_connection_by_ip(IPAddress ip_address, mtproto::TransportType transport_type,
@@ -819,13 +851,14 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
 
   VLOG(connections) << "In client_loop: " << tag("client", format::as_hex(client.hash));
 
-  // Remove expired ready connections
-  td::remove_if(client.ready_connections,
-                [&, expires_at = Time::now_cached() - ClientInfo::READY_CONNECTIONS_TIMEOUT](auto &v) {
-                  bool drop = v.second < expires_at;
-                  VLOG_IF(connections, drop) << "Drop expired " << tag("connection", v.first.get());
-                  return drop;
-                });
+  // Remove expired ready connections and connections created for a previous network
+  auto ready_connections_timeout = Time::now_cached() < client.keep_warm_until ? ClientInfo::WARM_CONNECTIONS_TIMEOUT
+                                                                               : ClientInfo::READY_CONNECTIONS_TIMEOUT;
+  td::remove_if(client.ready_connections, [&, expires_at = Time::now_cached() - ready_connections_timeout](auto &v) {
+    bool drop = v.ready_at < expires_at || v.raw_connection->extra().extra != network_generation_;
+    VLOG_IF(connections, drop) << "Drop expired " << tag("connection", v.raw_connection.get());
+    return drop;
+  });
 
   // Send ready connections into promises
   {
@@ -833,8 +866,10 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
     auto it = begin;
     while (it != client.queries.end() && !client.ready_connections.empty()) {
       if (!it->is_canceled()) {
-        VLOG(connections) << "Send to promise " << tag("connection", client.ready_connections.back().first.get());
-        it->set_value(std::move(client.ready_connections.back().first));
+        auto &ready_connection = client.ready_connections.back();
+        VLOG(connections) << "Send to promise " << tag("connection", ready_connection.raw_connection.get());
+        warm_connection_stats_.saved_time += ready_connection.creation_time;
+        it->set_value(std::move(ready_connection.raw_connection));
         client.ready_connections.pop_back();
       }
       ++it;
@@ -846,18 +881,29 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
   bool check_mode = client.checking_connections != 0 && !proxy.use_proxy();
   while (true) {
     // Check if we need new connections
-    if (client.queries.empty()) {
+    auto warm_connection_count = get_warm_connection_count(client);
+    if (client.queries.empty() &&
+        client.ready_connections.size() + client.pending_connections >= warm_connection_count) {
       if (!client.ready_connections.empty()) {
-        client_set_timeout_at(client, Time::now() + ClientInfo::READY_CONNECTIONS_TIMEOUT);
+        client_set_timeout_at(client, Time::now() + ready_connections_timeout);
       }
       return;
     }
     if (check_mode) {
-      if (client.checking_connections >= 3) {
+      if (client.checking_connections >= ClientInfo::MAX_CHECKING_CONNECTION_COUNT) {
         return;
       }
+      if (client.checking_connections > 0) {
+        auto next_check_at = client.last_check_at + ClientInfo::CHECK_CONNECTION_DELAY;
+        if (next_check_at > Time::now()) {
+          return client_set_timeout_at(client, next_check_at);
+        }
+      }
     } else {
-      if (client.pending_connections >= client.queries.size()) {
+      auto needed_warm_connection_count = warm_connection_count > client.ready_connections.size()
+                                              ? warm_connection_count - client.ready_connections.size()
+                                              : 0;
+      if (client.pending_connections >= client.queries.size() + needed_warm_connection_count) {
         return;
       }
     }
@@ -911,15 +957,20 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
       if (extra.stat) {
         extra.stat->on_check();
       }
+      if (client.checking_connections == 0) {
+        client.is_check_race_won = false;
+      }
       client.checking_connections++;
+      client.last_check_at = Time::now();
     }
 
     auto promise = PromiseCreator::lambda(
         [actor_id = actor_id(this), check_mode, transport_type = extra.transport_type, hash = client.hash,
-         debug_str = extra.debug_str,
-         network_generation = network_generation_](Result<ConnectionData> r_connection_data) mutable {
+         debug_str = extra.debug_str, network_generation = network_generation_, start_time = Time::now(),
+         stat = extra.stat](Result<ConnectionData> r_connection_data) mutable {
           send_closure(actor_id, &ConnectionCreator::client_create_raw_connection, std::move(r_connection_data),
-                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation);
+                       check_mode, std::move(transport_type), hash, std::move(debug_str), network_generation,
+                       start_time, stat);
         });
 
     auto stats_callback =
@@ -935,9 +986,30 @@ void ConnectionCreator::client_loop(ClientInfo &client) {
   }
 }
 
+size_t ConnectionCreator::get_warm_connection_count(const ClientInfo &client) const {
+  if (Time::now_cached() >= client.keep_warm_until || !(online_flag_ || is_logging_out_)) {
+    return 0;
+  }
+  if (client.ready_connections.size() + client.pending_connections > client.queries.size()) {
+    // the client already has its warm-standby connection
+    return 1;
+  }
+
+  size_t total_warm_connection_count = 0;
+  for (auto &it : clients_) {
+    const auto &other_client = it.second;
+    auto connection_count = other_client.ready_connections.size() + other_client.pending_connections;
+    if (connection_count > other_client.queries.size()) {
+      total_warm_connection_count += connection_count - other_client.queries.size();
+    }
+  }
+  return total_warm_connection_count < MAX_WARM_CONNECTION_COUNT ? 1 : 0;
+}
+
 void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                                      mtproto::TransportType transport_type, uint32 hash,
-                                                     string debug_str, uint32 network_generation) {
+                                                     string debug_str, uint32 network_generation, double start_time,
+                                                     DcOptionsSet::Stat *stat) {
   unique_ptr<mtproto::AuthData> auth_data;
   uint64 auth_data_generation{0};
   uint64 session_id{0};
@@ -953,7 +1025,8 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
     }
   }
   auto promise = PromiseCreator::lambda([actor_id = actor_id(this), hash, check_mode, auth_data_generation, session_id,
-                                         debug_str](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
+                                         debug_str, start_time,
+                                         stat](Result<unique_ptr<mtproto::RawConnection>> result) mutable {
     if (result.is_ok()) {
       VLOG(connections) << "Ready connection (" << (check_mode ? "" : "un") << "checked) " << result.ok().get() << ' '
                         << tag("rtt", format::as_time(result.ok()->extra().rtt)) << ' ' << debug_str;
@@ -962,7 +1035,7 @@ void ConnectionCreator::client_create_raw_connection(Result<ConnectionData> r_co
                         << debug_str;
     }
     send_closure(actor_id, &ConnectionCreator::client_add_connection, hash, std::move(result), check_mode,
-                 auth_data_generation, session_id);
+                 auth_data_generation, session_id, start_time, stat);
   });
 
   if (r_connection_data.is_error()) {
@@ -998,7 +1071,8 @@ void ConnectionCreator::client_set_timeout_at(ClientInfo &client, double wakeup_
 }
 
 void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection,
-                                              bool check_flag, uint64 auth_data_generation, uint64 session_id) {
+                                              bool check_flag, uint64 auth_data_generation, uint64 session_id,
+                                              double start_time, DcOptionsSet::Stat *stat) {
   auto &client = clients_[hash];
   client.add_session_id(session_id);
   CHECK(client.pending_connections > 0);
@@ -1011,7 +1085,18 @@ void ConnectionCreator::client_add_connection(uint32 hash, Result<unique_ptr<mtp
     VLOG(connections) << "Add ready connection " << r_raw_connection.ok().get() << " for "
                       << tag("client", format::as_hex(hash));
     client.backoff.clear();
-    client.ready_connections.emplace_back(r_raw_connection.move_as_ok(), Time::now_cached());
+    if (check_flag && !client.is_check_race_won) {
+      client.is_check_race_won = true;
+      if (stat != nullptr) {
+        VLOG(connections) << "Connection " << r_raw_connection.ok().get() << " won the check race";
+        stat->on_race_won();
+      }
+    }
+    ClientInfo::ReadyConnection ready_connection;
+    ready_connection.raw_connection = r_raw_connection.move_as_ok();
+    ready_connection.ready_at = Time::now_cached();
+    ready_connection.creation_time = ready_connection.ready_at - start_time;
+    client.ready_connections.push_back(std::move(ready_connection));
   } else {
     if (r_raw_connection.error().code() == -404 && client.auth_data &&
         client.auth_data_generation == auth_data_generation) {
@@ -1344,4 +1429,29 @@ void ConnectionCreator::on_ping_main_dc_result(uint64 token, Result<double> resu
   }
 }
 
+void ConnectionCreator::on_ping_proxy_result(uint64 token, Result<double> result) {
+  auto it = ping_proxy_requests_.find(token);
+  CHECK(it != ping_proxy_requests_.end());
+  auto request = std::move(it->second);
+  ping_proxy_requests_.erase(it);
+
+  auto token_it = ping_proxy_request_tokens_.find(request.proxy_id);
+  if (token_it != ping_proxy_request_tokens_.end() && token_it->second == token) {
+    // the proxy wasn't changed during the ping
+    ping_proxy_request_tokens_.erase(token_it);
+    if (result.is_ok()) {
+      ping_proxy_results_[request.proxy_id] = {result.ok(), Time::now() + PING_PROXY_RESULT_CACHE_TIME};
+    }
+  }
+
+  for (auto &promise : request.promises) {
+    promise.set_result(result.clone());
+  }
+}
+
+void ConnectionCreator::forget_proxy_ping(int32 proxy_id) {
+  ping_proxy_request_tokens_.erase(proxy_id);
+  ping_proxy_results_.erase(proxy_id);
+}
+
 }  // namespace td
@@ -153,10 +153,27 @@ class ConnectionCreator final : public NetQueryCallback {
     Slot slot;
     size_t pending_connections{0};
     size_t checking_connections{0};
-    std::vector<std::pair<unique_ptr<mtproto::RawConnection>, double>> ready_connections;
+
+    struct ReadyConnection {
+      unique_ptr<mtproto::RawConnection> raw_connection;
+      double ready_at = 0.0;
+      double creation_time = 0.0;
+    };
+    std::vector<ReadyConnection> ready_connections;
     std::vector<Promise<unique_ptr<mtproto::RawConnection>>> queries;
 
+    // a warm-standby connection is kept for some time after the client has requested a connection
+    double keep_warm_until{0.0};
+
+    // checked connections to different options are started with a delay and race with each other
+    double last_check_at{0.0};
+    bool is_check_race_won{false};
+
     static constexpr double READY_CONNECTIONS_TIMEOUT = 10;
+    static constexpr double WARM_CONNECTIONS_TIMEOUT = 30;
+    static constexpr double WARM_STANDBY_PERIOD = 60;
+    static constexpr size_t MAX_CHECKING_CONNECTION_COUNT = 3;
+    static constexpr double CHECK_CONNECTION_DELAY = 0.25;
 
     bool inited{false};
     uint32 hash{0};
@@ -169,6 +186,16 @@ class ConnectionCreator final : public NetQueryCallback {
   };
   std::map<uint32, ClientInfo> clients_;
 
+  // total number of warm-standby connections across all clients
+  static constexpr size_t MAX_WARM_CONNECTION_COUNT = 8;
+
+  struct WarmConnectionStats {
+    uint64 hit_count = 0;
+    uint64 miss_count = 0;
+    double saved_time = 0.0;
+  };
+  WarmConnectionStats warm_connection_stats_;
+
   std::shared_ptr<NetStatsCallback> media_net_stats_callback_;
   std::shared_ptr<NetStatsCallback> common_net_stats_callback_;
 
@@ -185,6 +212,20 @@ class ConnectionCreator final : public NetQueryCallback {
   };
   std::map<uint64, PingMainDcRequest> ping_main_dc_requests_;
 
+  // concurrent pings of the same proxy are merged, and successful results are reused for a short time
+  static constexpr double PING_PROXY_RESULT_CACHE_TIME = 30.0;
+  struct PingProxyRequest {
+    int32 proxy_id = 0;
+    vector<Promise<double>> promises;
+  };
+  std::map<uint64, PingProxyRequest> ping_proxy_requests_;
+  FlatHashMap<int32, uint64> ping_proxy_request_tokens_;
+  struct PingProxyResult {
+    double ping_time = 0.0;
+    double expires_at = 0.0;
+  };
+  FlatHashMap<int32, PingProxyResult> ping_proxy_results_;
+
   uint64 next_token() {
     return ++current_token_;
   }
@@ -220,11 +261,13 @@ class ConnectionCreator final : public NetQueryCallback {
 
   void client_wakeup(uint32 hash);
   void client_loop(ClientInfo &client);
+  size_t get_warm_connection_count(const ClientInfo &client) const;
   void client_create_raw_connection(Result<ConnectionData> r_connection_data, bool check_mode,
                                     mtproto::TransportType transport_type, uint32 hash, string debug_str,
-                                    uint32 network_generation);
+                                    uint32 network_generation, double start_time, DcOptionsSet::Stat *stat);
   void client_add_connection(uint32 hash, Result<unique_ptr<mtproto::RawConnection>> r_raw_connection, bool check_flag,
-                             uint64 auth_data_generation, uint64 session_id);
+                             uint64 auth_data_generation, uint64 session_id, double start_time,
+                             DcOptionsSet::Stat *stat);
   void client_set_timeout_at(ClientInfo &client, double wakeup_at);
 
   void on_proxy_resolved(Result<IPAddress> ip_address, bool dummy);
@@ -252,6 +295,10 @@ class ConnectionCreator final : public NetQueryCallback {
                                      mtproto::TransportType transport_type, string debug_str, Promise<double> promise);
 
   void on_ping_main_dc_result(uint64 token, Result<double> result);
+
+  void on_ping_proxy_result(uint64 token, Result<double> result);
+
+  void forget_proxy_ping(int32 proxy_id);
 };
 
 }  // namespace td
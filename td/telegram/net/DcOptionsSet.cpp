@@ -160,6 +160,9 @@ Result<DcOptionsSet::ConnectionInfo> DcOptionsSet::find_connection(DcId dc_id, b
       return a_state < b_state;
     }
     if (a_state == Stat::State::Ok) {
+      if (a.race_won_at != b.race_won_at) {
+        return a.race_won_at > b.race_won_at;
+      }
       if (a_option.order == b_option.order) {
         return a_option.use_http < b_option.use_http;
       }
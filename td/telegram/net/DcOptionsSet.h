@@ -28,6 +28,7 @@ class DcOptionsSet {
     double ok_at{-1000};
     double error_at{-1001};
     double check_at{-1002};
+    double race_won_at{-1003};
     enum class State : int32 { Ok, Error, Checking };
 
     void on_ok() {
@@ -39,6 +40,10 @@ class DcOptionsSet {
     void on_check() {
       check_at = Time::now_cached();
     }
+    // the option was the first to be checked successfully among concurrently checked options
+    void on_race_won() {
+      race_won_at = Time::now_cached();
+    }
     bool is_ok() const {
       return state() == State::Ok;
     }
@@ -0,0 +1,43 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/LatencyHistogram.h"
+
+namespace td {
+
+namespace {
+
+// upper bounds of the histogram buckets in milliseconds; the last bucket is unbounded
+constexpr int32 LATENCY_BUCKET_BOUNDS[] = {1, 5, 10, 25, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000};
+
+static_assert(sizeof(LATENCY_BUCKET_BOUNDS) / sizeof(LATENCY_BUCKET_BOUNDS[0]) + 1 == LatencyHistogram::BUCKET_COUNT,
+              "");
+
+}  // namespace
+
+void LatencyHistogram::add(double latency) {
+  auto latency_ms = latency * 1000;
+  size_t bucket = 0;
+  while (bucket + 1 < BUCKET_COUNT && latency_ms > LATENCY_BUCKET_BOUNDS[bucket]) {
+    bucket++;
+  }
+  counts[bucket]++;
+  total_count++;
+}
+
+int32 LatencyHistogram::get_percentile(double percentile) const {
+  auto needed_count = static_cast<double>(total_count) * percentile;
+  uint64 count = 0;
+  for (size_t bucket = 0; bucket + 1 < BUCKET_COUNT; bucket++) {
+    count += counts[bucket];
+    if (static_cast<double>(count) >= needed_count) {
+      return LATENCY_BUCKET_BOUNDS[bucket];
+    }
+  }
+  return -1;
+}
+
+}  // namespace td
@@ -0,0 +1,28 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <array>
+
+namespace td {
+
+// histogram of latencies with fixed exponentially growing buckets
+struct LatencyHistogram {
+  static constexpr size_t BUCKET_COUNT = 14;
+
+  std::array<uint64, BUCKET_COUNT> counts{};
+  uint64 total_count = 0;
+
+  void add(double latency);
+
+  // returns an upper bound for the given percentile in milliseconds or -1 if it is unbounded
+  int32 get_percentile(double percentile) const;
+};
+
+}  // namespace td
@@ -12,6 +12,7 @@
 
 #include "td/utils/algorithm.h"
 #include "td/utils/as.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
@@ -22,18 +23,25 @@ namespace td {
 
 int VERBOSITY_NAME(net_query) = VERBOSITY_NAME(INFO);
 
-void NetQuery::debug(string state, bool may_be_lost) {
+void NetQuery::debug(Slice state, bool may_be_lost) {
   may_be_lost_ = may_be_lost;
   VLOG(net_query) << *this << " " << tag("state", state);
-  {
+  auto *debug = get_debug_unsafe();
+  if (debug != nullptr) {
     auto guard = lock();
-    auto &data = get_data_unsafe();
-    data.state_ = std::move(state);
-    data.state_timestamp_ = Time::now();
-    data.state_change_count_++;
+    debug->state_ = state.str();
+    debug->state_timestamp_ = Time::now();
+    debug->state_change_count_++;
   }
 }
 
+void NetQuery::set_stage(NetQueryStage stage) {
+  auto now = Time::now();
+  stage_durations_[static_cast<size_t>(stage_)] += now - stage_start_time_;
+  stage_ = stage;
+  stage_start_time_ = now;
+}
+
 NetQuery::NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFlag auth_flag, GzipFlag gzip_flag,
                    int32 tl_constructor, int32 total_timeout_limit, NetQueryStats *stats, vector<ChainId> chain_ids)
     : state_(State::Query)
@@ -50,34 +58,58 @@ NetQuery::NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFl
   chain_ids_ = transform(chain_ids, [](ChainId chain_id) { return chain_id.get() == 0 ? 1 : chain_id.get(); });
   td::unique(chain_ids_);
 
-  auto &data = get_data_unsafe();
-  data.my_id_ = G()->get_option_integer("my_id");
-  data.start_timestamp_ = data.state_timestamp_ = Time::now();
+  stage_start_time_ = Time::now();
   LOG(INFO) << *this;
   if (stats) {
+    if (stats->is_debug_enabled()) {
+      auto debug = make_unique<NetQueryDebug>();
+      debug->my_id_ = G()->get_option_integer(OptionId::MyId);
+      debug->start_timestamp_ = debug->state_timestamp_ = stage_start_time_;
+      get_data_unsafe() = std::move(debug);
+    }
     nq_counter_ = stats->register_query(this);
+    stats_ = stats;
   }
 }
 
 void NetQuery::clear() {
   if (!is_ready()) {
-    auto guard = lock();
-    LOG(ERROR) << "Destroy not ready query " << *this << " " << tag("state", get_data_unsafe().state_);
+    auto *debug = get_debug_unsafe();
+    if (debug == nullptr) {
+      LOG(ERROR) << "Destroy not ready query " << *this;
+    } else {
+      auto guard = lock();
+      LOG(ERROR) << "Destroy not ready query " << *this << " " << tag("state", debug->state_);
+    }
   }
   // TODO: CHECK if net_query is lost here
+  if (stats_ != nullptr && nq_counter_ && is_ready()) {
+    set_stage(stage_);
+    stats_->on_query_finished(tl_constructor_, stage_durations_);
+    if (trace_id_ != 0) {
+      string stages;
+      for (size_t stage = 0; stage < NET_QUERY_STAGE_COUNT; stage++) {
+        stages += PSTRING() << ' ' << NetQueryStats::get_stage_name(stage) << ' ' << stage_durations_[stage];
+      }
+      LOG(WARNING) << "Trace " << trace_id_ << ": finish query " << format::as_hex(tl_constructor_) << " to " << dc_id_
+                   << " with durations in seconds:" << stages;
+    }
+  }
   cancel_slot_.close();
   *this = NetQuery();
 }
 
 void NetQuery::resend(DcId new_dc_id) {
   VLOG(net_query) << "Resend " << *this;
-  {
+  auto *debug = get_debug_unsafe();
+  if (debug != nullptr) {
     auto guard = lock();
-    get_data_unsafe().resend_count_++;
+    debug->resend_count_++;
   }
   dc_id_ = new_dc_id;
   status_ = Status::OK();
   state_ = State::Query;
+  set_stage(NetQueryStage::Dispatch);
 }
 
 bool NetQuery::update_is_ready() {
@@ -96,9 +128,12 @@ void NetQuery::set_ok(BufferSlice slice) {
   CHECK(state_ == State::Query);
   answer_ = std::move(slice);
   state_ = State::OK;
+  set_stage(NetQueryStage::ResultHandling);
 }
 
 void NetQuery::on_net_write(size_t size) {
+  static auto *counter = MetricsRegistry::get_counter("td_file_sent_bytes_total");
+  counter->add(static_cast<int64>(size));
   const auto &callbacks = G()->get_net_stats_file_callbacks();
   if (static_cast<size_t>(file_type_) < callbacks.size()) {
     callbacks[file_type_]->on_write(size);
@@ -106,6 +141,8 @@ void NetQuery::on_net_write(size_t size) {
 }
 
 void NetQuery::on_net_read(size_t size) {
+  static auto *counter = MetricsRegistry::get_counter("td_file_received_bytes_total");
+  counter->add(static_cast<int64>(size));
   const auto &callbacks = G()->get_net_stats_file_callbacks();
   if (static_cast<size_t>(file_type_) < callbacks.size()) {
     callbacks[file_type_]->on_read(size);
@@ -145,6 +182,7 @@ void NetQuery::set_error_impl(Status status, string source) {
   status_ = std::move(status);
   state_ = State::Error;
   source_ = std::move(source);
+  set_stage(NetQueryStage::ResultHandling);
 }
 
 StringBuilder &operator<<(StringBuilder &stream, const NetQuery &net_query) {
@@ -26,6 +26,7 @@
 #include "td/utils/tl_parsers.h"
 #include "td/utils/TsList.h"
 
+#include <array>
 #include <atomic>
 #include <utility>
 
@@ -45,7 +46,7 @@ class NetQueryCallback : public Actor {
   virtual void on_result_resendable(NetQueryPtr query, Promise<NetQueryPtr> promise);
 };
 
-class NetQuery final : public TsListNode<NetQueryDebug> {
+class NetQuery final : public TsListNode<unique_ptr<NetQueryDebug>> {
   enum class State : int8 { Empty, Query, OK, Error };
 
  public:
@@ -196,12 +197,27 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
     remove();
   }
 
+  // returns nullptr if debug is disabled
+  NetQueryDebug *get_debug_unsafe() {
+    return get_data_unsafe().get();
+  }
+
   void debug_send_failed() {
-    auto guard = lock();
-    get_data_unsafe().send_failed_count_++;
+    auto *debug = get_debug_unsafe();
+    if (debug != nullptr) {
+      auto guard = lock();
+      debug->send_failed_count_++;
+    }
   }
 
-  void debug(string state, bool may_be_lost = false);
+  void debug(Slice state, bool may_be_lost = false);
+
+  // accounts the time since the previous stage change to the previous stage
+  void set_stage(NetQueryStage stage);
+
+  double get_stage_duration(NetQueryStage stage) const {
+    return stage_durations_[static_cast<size_t>(stage)];
+  }
 
   void set_callback(ActorShared<NetQueryCallback> callback) {
     callback_ = std::move(callback);
@@ -246,6 +262,7 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   DcId dc_id_;
 
   NetQueryCounter nq_counter_;
+  NetQueryStats *stats_ = nullptr;
   Status status_;
   uint64 id_ = 0;
   BufferSlice query_;
@@ -259,6 +276,10 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   bool may_be_lost_ = false;
   int8 priority_{0};
 
+  NetQueryStage stage_ = NetQueryStage::Dispatch;
+  double stage_start_time_ = 0.0;
+  std::array<double, NET_QUERY_STAGE_COUNT> stage_durations_{};
+
   template <class T>
   struct movable_atomic final : public std::atomic<T> {
     movable_atomic() = default;
@@ -287,16 +308,18 @@ class NetQuery final : public TsListNode<NetQueryDebug> {
   static int32 tl_magic(const BufferSlice &buffer_slice);
 
  public:
-  int32 next_timeout_ = 1;          // for NetQueryDelayer
-  int32 total_timeout_ = 0;         // for NetQueryDelayer/SequenceDispatcher
-  int32 total_timeout_limit_ = 60;  // for NetQueryDelayer/SequenceDispatcher and to be set by caller
-  int32 last_timeout_ = 0;          // for NetQueryDelayer/SequenceDispatcher
-  string source_;                   // for NetQueryDelayer/SequenceDispatcher
-  int32 dispatch_ttl_ = -1;         // for NetQueryDispatcher and to be set by caller
-  int32 file_type_ = -1;            // to be set by caller
-  Slot cancel_slot_;                // for Session and to be set by caller
-  Promise<> quick_ack_promise_;     // for Session and to be set by caller
-  bool need_resend_on_503_ = true;  // for NetQueryDispatcher and to be set by caller
+  int32 next_timeout_ = 1;              // for NetQueryDelayer
+  int32 total_timeout_ = 0;             // for NetQueryDelayer/SequenceDispatcher
+  int32 total_timeout_limit_ = 60;      // for NetQueryDelayer/SequenceDispatcher and to be set by caller
+  int32 last_timeout_ = 0;              // for NetQueryDelayer/SequenceDispatcher
+  string source_;                       // for NetQueryDelayer/SequenceDispatcher
+  int32 dispatch_ttl_ = -1;             // for NetQueryDispatcher and to be set by caller
+  int32 file_type_ = -1;                // to be set by caller
+  Slot cancel_slot_;                    // for Session and to be set by caller
+  Promise<> quick_ack_promise_;         // for Session and to be set by caller
+  bool need_resend_on_503_ = true;      // for NetQueryDispatcher and to be set by caller
+  bool is_rate_limit_checked_ = false;  // for NetQueryDelayer/NetQueryDispatcher
+  uint64 trace_id_ = 0;                 // for tracing and to be set by NetQueryCreator
 
   NetQuery(uint64 id, BufferSlice &&query, DcId dc_id, Type type, AuthFlag auth_flag, GzipFlag gzip_flag,
            int32 tl_constructor, int32 total_timeout_limit, NetQueryStats *stats, vector<ChainId> chain_ids);
@@ -14,11 +14,11 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/buffer.h"
-#include "td/utils/format.h"
 #include "td/utils/Gzip.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
-#include "td/utils/Storer.h"
+#include "td/utils/tl_storers.h"
 
 namespace td {
 
@@ -28,6 +28,33 @@ NetQueryCreator::NetQueryCreator(std::shared_ptr<NetQueryStats> net_query_stats)
   object_pool_.set_check_empty(true);
 }
 
+// the query is serialized in a single pass to a thread-local buffer, which is reused by subsequent queries
+static TD_THREAD_LOCAL string *current_query_buffer;
+
+BufferSlice NetQueryCreator::store_query(const telegram_api::Function *prefix, const telegram_api::Function &function) {
+  static constexpr size_t MAX_KEPT_BUFFER_SIZE = 1 << 20;
+  init_thread_local<string>(current_query_buffer);
+  auto &buffer = *current_query_buffer;
+
+  TlStorerGrowable storer(buffer);
+  if (prefix != nullptr) {
+    prefix->store(storer);
+  }
+  function.store(storer);
+  BufferSlice result(storer.as_slice());
+  if (buffer.size() > MAX_KEPT_BUFFER_SIZE) {
+    // don't keep too big buffer forever
+    string().swap(buffer);
+  }
+  return result;
+}
+
+static TD_THREAD_LOCAL uint64 current_trace_id;
+
+void NetQueryCreator::set_current_trace_id(uint64 trace_id) {
+  current_trace_id = trace_id;
+}
+
 NetQueryPtr NetQueryCreator::create(const telegram_api::Function &function, vector<ChainId> chain_ids, DcId dc_id,
                                     NetQuery::Type type) {
   return create(UniqueId::next(), nullptr, function, std::move(chain_ids), dc_id, type, NetQuery::AuthFlag::On);
@@ -43,23 +70,7 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
                                     const telegram_api::Function &function, vector<ChainId> &&chain_ids, DcId dc_id,
                                     NetQuery::Type type, NetQuery::AuthFlag auth_flag) {
   LOG(INFO) << "Create query " << to_string(function);
-  string prefix_str;
-  if (prefix != nullptr) {
-    auto storer = DefaultStorer<telegram_api::Function>(*prefix);
-    prefix_str.resize(storer.size());
-    auto real_size = storer.store(MutableSlice(prefix_str).ubegin());
-    CHECK(real_size == prefix_str.size());
-  }
-
-  auto storer = DefaultStorer<telegram_api::Function>(function);
-  BufferSlice slice(prefix_str.size() + storer.size());
-  auto real_size = storer.store(slice.as_mutable_slice().ubegin() + prefix_str.size());
-  LOG_CHECK(prefix_str.size() + real_size == slice.size())
-      << prefix_str.size() << ' ' << real_size << ' ' << slice.size() << ' '
-      << format::as_hex_dump<4>(slice.as_slice());
-  if (prefix != nullptr) {
-    slice.as_mutable_slice().copy_from(prefix_str);
-  }
+  BufferSlice slice = store_query(prefix.get(), function);
 
   size_t min_gzipped_size = 128;
   int32 tl_constructor = function.get_id();
@@ -82,29 +93,70 @@ NetQueryPtr NetQueryCreator::create(uint64 id, const telegram_api::object_ptr<te
     }
   }
 
-  auto gzip_flag = slice.size() < min_gzipped_size ? NetQuery::GzipFlag::Off : NetQuery::GzipFlag::On;
-  if (slice.size() >= 16384) {
-    // test compression ratio for the middle part
-    // if it is less than 0.9, then try to compress the whole request
-    size_t TESTED_SIZE = 1024;
-    BufferSlice compressed_part = gzencode(slice.as_slice().substr((slice.size() - TESTED_SIZE) / 2, TESTED_SIZE), 0.9);
-    if (compressed_part.empty()) {
-      gzip_flag = NetQuery::GzipFlag::Off;
-    }
-  }
-  if (gzip_flag == NetQuery::GzipFlag::On) {
-    BufferSlice compressed = gzencode(slice.as_slice(), 0.9);
-    if (compressed.empty()) {
-      gzip_flag = NetQuery::GzipFlag::Off;
-    } else {
-      slice = std::move(compressed);
-    }
+  auto gzip_flag = NetQuery::GzipFlag::Off;
+  BufferSlice compressed = try_gzip(tl_constructor, slice.as_slice(), min_gzipped_size);
+  if (!compressed.empty()) {
+    gzip_flag = NetQuery::GzipFlag::On;
+    slice = std::move(compressed);
   }
 
   auto query = object_pool_.create(id, std::move(slice), dc_id, type, auth_flag, gzip_flag, tl_constructor,
                                    total_timeout_limit, net_query_stats_.get(), std::move(chain_ids));
   query->set_cancellation_token(query.generation());
+  query->trace_id_ = current_trace_id;
   return query;
 }
 
+BufferSlice NetQueryCreator::try_gzip(int32 tl_constructor, Slice query, size_t min_gzipped_size) {
+  if (query.size() < min_gzipped_size / 2) {
+    return BufferSlice();
+  }
+
+  auto &stats = gzip_stats_[tl_constructor];
+  bool is_trusted = stats.query_count >= MIN_TRUSTED_QUERY_COUNT;
+  if (is_trusted && stats.compression_ratio > MAX_COMPRESSION_RATIO) {
+    // queries of the type are incompressible; check from time to time whether this has changed
+    if (++stats.skipped_query_count < INCOMPRESSIBLE_QUERY_PROBE_PERIOD) {
+      return BufferSlice();
+    }
+    stats.skipped_query_count = 0;
+  }
+  if (query.size() < min_gzipped_size && !(is_trusted && stats.compression_ratio < GOOD_COMPRESSION_RATIO)) {
+    // small queries are compressed only if queries of the type are known to be compressed well
+    return BufferSlice();
+  }
+
+  auto update_stats = [&stats](double compression_ratio) {
+    if (stats.query_count == 0) {
+      stats.compression_ratio = compression_ratio;
+    } else {
+      stats.compression_ratio += (compression_ratio - stats.compression_ratio) * COMPRESSION_RATIO_SMOOTHING;
+    }
+    if (stats.query_count < MIN_TRUSTED_QUERY_COUNT) {
+      stats.query_count++;
+    }
+  };
+
+  if (query.size() >= 16384 && !is_trusted) {
+    // test compression ratio for the middle part
+    // if it is less than 0.9, then try to compress the whole request
+    size_t TESTED_SIZE = 1024;
+    if (gzencode(gzip_, query.substr((query.size() - TESTED_SIZE) / 2, TESTED_SIZE), MAX_COMPRESSION_RATIO).empty()) {
+      update_stats(1.0);
+      return BufferSlice();
+    }
+  }
+
+  BufferSlice compressed = gzencode(gzip_, query, MAX_COMPRESSION_RATIO);
+  if (compressed.empty()) {
+    update_stats(1.0);
+    return BufferSlice();
+  }
+  update_stats(static_cast<double>(compressed.size()) / static_cast<double>(query.size()));
+  if (net_query_stats_ != nullptr) {
+    net_query_stats_->on_query_gzipped(query.size(), compressed.size());
+  }
+  return compressed;
+}
+
 }  // namespace td
@@ -12,8 +12,12 @@
 #include "td/telegram/net/NetQueryStats.h"
 #include "td/telegram/UniqueId.h"
 
+#include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/Gzip.h"
 #include "td/utils/ObjectPool.h"
+#include "td/utils/Slice.h"
 
 #include <memory>
 
@@ -31,6 +35,13 @@ class NetQueryCreator {
     object_pool_.set_check_empty(false);
   }
 
+  const std::shared_ptr<NetQueryStats> &get_net_query_stats() const {
+    return net_query_stats_;
+  }
+
+  // queries created on the current thread until the next call are attributed to the request trace
+  static void set_current_trace_id(uint64 trace_id);
+
   NetQueryPtr create(const telegram_api::Function &function, vector<ChainId> chain_ids = {}, DcId dc_id = DcId::main(),
                      NetQuery::Type type = NetQuery::Type::Common);
 
@@ -47,9 +58,30 @@ class NetQueryCreator {
                      NetQuery::Type type, NetQuery::AuthFlag auth_flag);
 
  private:
+  static constexpr double MAX_COMPRESSION_RATIO = 0.9;
+  static constexpr double GOOD_COMPRESSION_RATIO = 0.5;
+  static constexpr double COMPRESSION_RATIO_SMOOTHING = 0.25;
+  static constexpr int32 MIN_TRUSTED_QUERY_COUNT = 4;
+  static constexpr int32 INCOMPRESSIBLE_QUERY_PROBE_PERIOD = 32;
+
+  // compression statistics for queries with the same constructor
+  struct GzipStats {
+    double compression_ratio = 0.0;
+    int32 query_count = 0;
+    int32 skipped_query_count = 0;
+  };
+
   std::shared_ptr<NetQueryStats> net_query_stats_;
   ObjectPool<NetQuery> object_pool_;
   int32 current_scheduler_id_ = 0;
+
+  FlatHashMap<int32, GzipStats> gzip_stats_;
+  Gzip gzip_;
+
+  static BufferSlice store_query(const telegram_api::Function *prefix, const telegram_api::Function &function);
+
+  // returns an empty BufferSlice if the query must be sent uncompressed
+  BufferSlice try_gzip(int32 tl_constructor, Slice query, size_t min_gzipped_size);
 };
 
 }  // namespace td
@@ -16,15 +16,32 @@
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace td {
 
+NetQueryRateLimitKey::NetQueryRateLimitKey(const NetQuery &net_query) : tl_constructor(net_query.tl_constructor()) {
+  auto chain_ids = net_query.get_chain_ids();
+  if (!chain_ids.empty()) {
+    chain_id = chain_ids[0];
+  }
+}
+
+NetQueryDelayer::NetQueryDelayer(ActorShared<> parent) : parent_(std::move(parent)) {
+  rate_limit_timeout_.set_callback(on_rate_limit_timeout_callback);
+  rate_limit_timeout_.set_callback_data(static_cast<void *>(this));
+}
+
 void NetQueryDelayer::delay(NetQueryPtr query) {
   query->debug("trying to delay");
   query->is_ready();
   CHECK(query->is_error());
   auto code = query->error().code();
   int32 timeout = 0;
+  bool is_flood_wait = false;
   if (code < 0) {
     // skip
   } else if (code == 500) {
@@ -38,6 +55,7 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
                         Slice("TAKEOUT_INIT_DELAY_"), Slice("FLOOD_PREMIUM_WAIT_")}) {
       if (begins_with(error_message, prefix)) {
         timeout = clamp(to_integer<int>(error_message.substr(prefix.size())), 1, 14 * 24 * 60 * 60);
+        is_flood_wait = prefix == "FLOOD_WAIT_" || prefix == "SLOWMODE_WAIT_";
         if (prefix == "FLOOD_PREMIUM_WAIT_") {
           switch (query->type()) {
             case NetQuery::Type::Common:
@@ -62,6 +80,11 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
     return;
   }
 
+  if (is_flood_wait) {
+    CHECK(timeout > 0);
+    on_flood_wait(*query, timeout);
+  }
+
   if (timeout == 0) {
     timeout = query->next_timeout_;
     if (timeout < 60) {
@@ -98,14 +121,151 @@ void NetQueryDelayer::delay(NetQueryPtr query) {
 
   LOG(WARNING) << "Delay: " << query << " " << tag("timeout", timeout) << tag("total_timeout", query->total_timeout_)
                << " because of " << error << " from " << query->source_;
-  query->debug(PSTRING() << "delay for " << format::as_time(timeout));
+  query->debug(PSLICE() << "delay for " << format::as_time(timeout));
+  query->set_stage(NetQueryStage::Delay);
   auto id = container_.create(QuerySlot());
   auto *query_slot = container_.get(id);
   query_slot->query_ = std::move(query);
+  query_slot->is_flood_wait_ = is_flood_wait;
   query_slot->timeout_.set_event(EventCreator::yield(actor_shared(this, id)));
   query_slot->timeout_.set_timeout_in(timeout);
 }
 
+void NetQueryDelayer::on_flood_wait(const NetQuery &query, int32 timeout) {
+  NetQueryRateLimitKey key(query);
+  auto now = Time::now();
+  auto &rate_limit_id = rate_limit_ids_[key];
+  RateLimit *rate_limit = nullptr;
+  if (rate_limit_id == 0) {
+    rate_limit_id = ++current_rate_limit_id_;
+    auto new_rate_limit = make_unique<RateLimit>(key, timeout, now);
+    rate_limit = new_rate_limit.get();
+    rate_limits_.emplace(rate_limit_id, std::move(new_rate_limit));
+    G()->net_query_dispatcher().add_rate_limited_key(key);
+  } else {
+    rate_limit = rate_limits_[rate_limit_id].get();
+    rate_limit->limiter_.on_flood_wait(timeout, now);
+  }
+  LOG(INFO) << "Limit rate of " << query.tl_constructor() << " with chain " << key.chain_id << " to "
+            << rate_limit->limiter_.get_rate(now) << " queries per second";
+  rate_limit_timeout_.set_timeout_at(rate_limit_id, rate_limit->limiter_.get_release_time(0, now));
+}
+
+void NetQueryDelayer::rate_limit(NetQueryPtr query) {
+  auto it = rate_limit_ids_.find(NetQueryRateLimitKey(*query));
+  if (it == rate_limit_ids_.end()) {
+    query->is_rate_limit_checked_ = true;
+    G()->net_query_dispatcher().dispatch(std::move(query));
+    return;
+  }
+
+  auto rate_limit_id = it->second;
+  auto *rate_limit = rate_limits_[rate_limit_id].get();
+  auto now = Time::now();
+  // the time in the queue is charged to the total timeout of the query like a delay because of an error
+  auto wait_time = rate_limit->limiter_.get_release_time(rate_limit->queries_.size() + 1, now) - now;
+  auto timeout = static_cast<int32>(std::ceil(min(wait_time, 1e9)));
+  if (timeout > 0) {
+    if (query->total_timeout_ + timeout > query->total_timeout_limit_) {
+      LOG(WARNING) << "Failed: " << query << " " << tag("timeout", timeout)
+                   << tag("total_timeout", query->total_timeout_) << " because of rate limit";
+      query->set_error(Status::Error(429, PSLICE() << "Too Many Requests: retry after " << timeout));
+      query->debug("DcManager: send to DcManager");
+      G()->net_query_dispatcher().dispatch(std::move(query));
+      return;
+    }
+    query->total_timeout_ += timeout;
+  }
+
+  query->debug("wait for rate limit");
+  query->set_stage(NetQueryStage::Delay);
+  rate_limit->queries_.push(std::move(query));
+  release_queries(rate_limit_id);
+}
+
+void NetQueryDelayer::release_queries(int64 rate_limit_id) {
+  auto it = rate_limits_.find(rate_limit_id);
+  if (it == rate_limits_.end()) {
+    return;
+  }
+  auto *rate_limit = it->second.get();
+  auto now = Time::now();
+
+  auto &queries = rate_limit->queries_;
+  while (!queries.empty()) {
+    // canceled queries don't need to wait
+    if (!queries.front()->update_is_ready()) {
+      if (!rate_limit->limiter_.take_token(now)) {
+        break;
+      }
+      queries.front()->is_rate_limit_checked_ = true;
+    }
+    auto query = queries.pop();
+    query->set_stage(NetQueryStage::Dispatch);
+    G()->net_query_dispatcher().dispatch(std::move(query));
+  }
+
+  double next_check_at;
+  if (!queries.empty()) {
+    next_check_at = rate_limit->limiter_.get_release_time(1, now);
+  } else {
+    next_check_at = rate_limit->limiter_.get_unlimited_time(now);
+    if (next_check_at <= now) {
+      return remove_rate_limit(rate_limit_id);
+    }
+    // check again, when the rate reaches MAX_RATE
+    next_check_at += 1.0;
+  }
+  rate_limit_timeout_.set_timeout_at(rate_limit_id, next_check_at);
+}
+
+void NetQueryDelayer::remove_rate_limit(int64 rate_limit_id) {
+  auto it = rate_limits_.find(rate_limit_id);
+  CHECK(it != rate_limits_.end());
+  CHECK(it->second->queries_.empty());
+  auto key = it->second->key_;
+  LOG(INFO) << "Remove rate limit of " << key.tl_constructor << " with chain " << key.chain_id;
+  G()->net_query_dispatcher().remove_rate_limited_key(key);
+  rate_limit_ids_.erase(key);
+  rate_limits_.erase(it);
+  rate_limit_timeout_.cancel_timeout(rate_limit_id);
+}
+
+void NetQueryDelayer::on_rate_limit_timeout_callback(void *net_query_delayer_ptr, int64 rate_limit_id) {
+  auto net_query_delayer = static_cast<NetQueryDelayer *>(net_query_delayer_ptr);
+  send_closure_later(net_query_delayer->actor_id(net_query_delayer), &NetQueryDelayer::release_queries,
+                     rate_limit_id);
+}
+
+void NetQueryDelayer::get_rate_limit_statistics(Promise<vector<RateLimitStatistics>> &&promise) {
+  auto now = Time::now();
+  FlatHashMap<int32, size_t> statistics_pos;
+  vector<RateLimitStatistics> result;
+  for (auto &it : rate_limits_) {
+    auto *rate_limit = it.second.get();
+    auto &pos = statistics_pos[rate_limit->key_.tl_constructor];
+    if (pos == 0) {
+      result.emplace_back();
+      result.back().tl_constructor = rate_limit->key_.tl_constructor;
+      pos = result.size();
+    }
+    auto &statistics = result[pos - 1];
+    statistics.key_count++;
+    statistics.average_rate += rate_limit->limiter_.get_rate(now);
+    statistics.pending_query_count += narrow_cast<int32>(rate_limit->queries_.size());
+  }
+  for (auto &statistics : result) {
+    statistics.average_rate /= statistics.key_count;
+  }
+  std::sort(result.begin(), result.end(), [](const RateLimitStatistics &lhs, const RateLimitStatistics &rhs) {
+    if (lhs.pending_query_count != rhs.pending_query_count) {
+      return lhs.pending_query_count > rhs.pending_query_count;
+    }
+    return lhs.tl_constructor < rhs.tl_constructor;
+  });
+  promise.set_value(std::move(result));
+}
+
 void NetQueryDelayer::wakeup() {
   auto link_token = get_link_token();
   if (link_token) {
@@ -124,7 +284,11 @@ void NetQueryDelayer::on_slot_event(uint64 id) {
     // Fail query after timeout expired if it is a part of an invokeAfter chain.
     // It is not necessary but helps to avoid server problems, when previous query was lost.
     query->set_error_resend_invoke_after();
+  } else if (slot->is_flood_wait_) {
+    // the query has already waited for the flood wait, which blocks its rate limit for the same time
+    query->is_rate_limit_checked_ = true;
   }
+  query->set_stage(NetQueryStage::Dispatch);
   slot->timeout_.close();
   container_.erase(id);
   G()->net_query_dispatcher().dispatch(std::move(query));
@@ -135,6 +299,14 @@ void NetQueryDelayer::tear_down() {
     query_slot.query_->set_error(Global::request_aborted_error());
     G()->net_query_dispatcher().dispatch(std::move(query_slot.query_));
   });
+  for (auto &it : rate_limits_) {
+    auto &queries = it.second->queries_;
+    while (!queries.empty()) {
+      auto query = queries.pop();
+      query->set_error(Global::request_aborted_error());
+      G()->net_query_dispatcher().dispatch(std::move(query));
+    }
+  }
 }
 
 }  // namespace td
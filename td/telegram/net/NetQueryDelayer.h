@@ -7,31 +7,94 @@
 #pragma once
 
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryRateLimiter.h"
 
 #include "td/actor/actor.h"
+#include "td/actor/MultiTimeout.h"
 #include "td/actor/SignalSlot.h"
 
+#include "td/utils/common.h"
 #include "td/utils/Container.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/HashTableUtils.h"
+#include "td/utils/Promise.h"
+#include "td/utils/VectorQueue.h"
 
 namespace td {
 
+// queries with the same function and the first chain identifier, which usually is a chat, share a rate limit
+struct NetQueryRateLimitKey {
+  int32 tl_constructor = 0;
+  uint64 chain_id = 0;
+
+  NetQueryRateLimitKey() = default;
+
+  explicit NetQueryRateLimitKey(const NetQuery &net_query);
+
+  bool operator==(const NetQueryRateLimitKey &other) const {
+    return tl_constructor == other.tl_constructor && chain_id == other.chain_id;
+  }
+};
+
+struct NetQueryRateLimitKeyHash {
+  uint32 operator()(const NetQueryRateLimitKey &key) const {
+    return combine_hashes(Hash<int32>()(key.tl_constructor), Hash<uint64>()(key.chain_id));
+  }
+};
+
 class NetQueryDelayer final : public Actor {
  public:
-  explicit NetQueryDelayer(ActorShared<> parent) : parent_(std::move(parent)) {
-  }
+  explicit NetQueryDelayer(ActorShared<> parent);
+
   void delay(NetQueryPtr query);
 
+  // postpones the query until it can be sent without exceeding the rate limit learned for its key
+  void rate_limit(NetQueryPtr query);
+
+  struct RateLimitStatistics {
+    int32 tl_constructor = 0;
+    int32 key_count = 0;
+    double average_rate = 0.0;
+    int32 pending_query_count = 0;
+  };
+
+  void get_rate_limit_statistics(Promise<vector<RateLimitStatistics>> &&promise);
+
  private:
   struct QuerySlot {
     NetQueryPtr query_;
     Slot timeout_;
+    bool is_flood_wait_ = false;
   };
   Container<QuerySlot> container_;
+
+  struct RateLimit {
+    NetQueryRateLimitKey key_;
+    NetQueryRateLimiter limiter_;
+    VectorQueue<NetQueryPtr> queries_;
+
+    RateLimit(NetQueryRateLimitKey key, int32 flood_wait, double now) : key_(key), limiter_(flood_wait, now) {
+    }
+  };
+  FlatHashMap<NetQueryRateLimitKey, int64, NetQueryRateLimitKeyHash> rate_limit_ids_;
+  FlatHashMap<int64, unique_ptr<RateLimit>> rate_limits_;
+  int64 current_rate_limit_id_ = 0;
+  MultiTimeout rate_limit_timeout_{"RateLimitTimeout"};
+
   ActorShared<> parent_;
+
   void wakeup() final;
 
   void on_slot_event(uint64 id);
 
+  void on_flood_wait(const NetQuery &query, int32 timeout);
+
+  void release_queries(int64 rate_limit_id);
+
+  void remove_rate_limit(int64 rate_limit_id);
+
+  static void on_rate_limit_timeout_callback(void *net_query_delayer_ptr, int64 rate_limit_id);
+
   void tear_down() final;
 };
 
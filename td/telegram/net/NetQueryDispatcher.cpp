@@ -31,7 +31,11 @@
 
 namespace td {
 
+constexpr int32 NetQueryDispatcher::MIN_MEDIA_SESSION_COUNT;
+constexpr size_t NetQueryDispatcher::SEQUENCE_DISPATCHER_SHARD_COUNT;
+
 void NetQueryDispatcher::complete_net_query(NetQueryPtr net_query) {
+  complete_duplicate_queries(*net_query);
   auto callback = net_query->move_callback();
   if (callback.empty()) {
     net_query->debug("sent to td (no callback)");
@@ -42,7 +46,138 @@ void NetQueryDispatcher::complete_net_query(NetQueryPtr net_query) {
   }
 }
 
-bool NetQueryDispatcher::check_stop_flag(NetQueryPtr &net_query) const {
+bool NetQueryDispatcher::is_deduplicable_query(const NetQuery &net_query) {
+  if (net_query.type() != NetQuery::Type::Common || !net_query.get_chain_ids().empty() ||
+      !net_query.invoke_after().empty()) {
+    return false;
+  }
+  switch (net_query.tl_constructor()) {
+    case telegram_api::users_getUsers::ID:
+    case telegram_api::users_getFullUser::ID:
+    case telegram_api::messages_getChats::ID:
+    case telegram_api::messages_getFullChat::ID:
+    case telegram_api::channels_getChannels::ID:
+    case telegram_api::channels_getFullChannel::ID:
+    case telegram_api::channels_getParticipant::ID:
+    case telegram_api::messages_getMessages::ID:
+    case telegram_api::channels_getMessages::ID:
+    case telegram_api::messages_getStickerSet::ID:
+    case telegram_api::messages_getCustomEmojiDocuments::ID:
+    case telegram_api::messages_getMessagesReactions::ID:
+    case telegram_api::stories_getStoriesByID::ID:
+      return true;
+    default:
+      return false;
+  }
+}
+
+string NetQueryDispatcher::get_duplicate_query_key(const NetQuery &net_query) {
+  string key;
+  key.reserve(net_query.query().size() + 1);
+  key += net_query.auth_flag() == NetQuery::AuthFlag::On ? 'a' : 'n';
+  key += net_query.query().as_slice().str();
+  return key;
+}
+
+bool NetQueryDispatcher::add_duplicate_query(NetQueryPtr &net_query) {
+  if (!net_query->dc_id().is_main() || !is_deduplicable_query(*net_query)) {
+    return false;
+  }
+  auto key = get_duplicate_query_key(*net_query);
+  std::lock_guard<std::mutex> guard(duplicate_queries_mutex_);
+  auto &duplicate_queries = duplicate_queries_[key];
+  if (duplicate_queries.leader_query_id_ == 0) {
+    duplicate_queries.leader_query_id_ = net_query->id();
+    return false;
+  }
+  if (duplicate_queries.leader_query_id_ == net_query->id()) {
+    // the query is resent
+    return false;
+  }
+  net_query->debug("wait for an identical query");
+  duplicate_queries.queries_.push_back(std::move(net_query));
+  return true;
+}
+
+void NetQueryDispatcher::complete_duplicate_queries(const NetQuery &net_query) {
+  if (!is_deduplicable_query(net_query)) {
+    return;
+  }
+  auto key = get_duplicate_query_key(net_query);
+  vector<NetQueryPtr> queries;
+  {
+    std::lock_guard<std::mutex> guard(duplicate_queries_mutex_);
+    auto it = duplicate_queries_.find(key);
+    if (it == duplicate_queries_.end() || it->second.leader_query_id_ != net_query.id()) {
+      return;
+    }
+    queries = std::move(it->second.queries_);
+    duplicate_queries_.erase(it);
+  }
+  if (queries.empty()) {
+    return;
+  }
+
+  VLOG(net_query) << "Complete " << queries.size() << " queries identical to " << net_query;
+  if (net_query.is_error() && net_query.error().code() == NetQuery::Canceled) {
+    // the result wasn't received, so the identical queries must be sent again
+    for (auto &query : queries) {
+      dispatch(std::move(query));
+    }
+    return;
+  }
+  for (auto &query : queries) {
+    if (net_query.is_ok()) {
+      query->set_ok(net_query.ok().copy());
+    } else {
+      query->set_error(net_query.error().clone());
+    }
+    complete_net_query(std::move(query));
+  }
+}
+
+bool NetQueryDispatcher::add_rate_limited_query(NetQueryPtr &net_query) {
+  if (net_query->is_rate_limit_checked_) {
+    // the query has already waited for its rate limit
+    net_query->is_rate_limit_checked_ = false;
+    return false;
+  }
+  if (!has_rate_limited_keys_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (check_stop_flag(net_query)) {
+    return true;
+  }
+  if (rate_limited_keys_.count(NetQueryRateLimitKey(*net_query)) == 0) {
+    return false;
+  }
+  net_query->debug("sent to NetQueryDelayer for rate limit");
+  send_closure_later(delayer_, &NetQueryDelayer::rate_limit, std::move(net_query));
+  return true;
+}
+
+void NetQueryDispatcher::add_rate_limited_key(const NetQueryRateLimitKey &key) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  rate_limited_keys_.insert(key);
+  has_rate_limited_keys_ = true;
+}
+
+void NetQueryDispatcher::remove_rate_limited_key(const NetQueryRateLimitKey &key) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  rate_limited_keys_.erase(key);
+  has_rate_limited_keys_ = !rate_limited_keys_.empty();
+}
+
+void NetQueryDispatcher::get_rate_limit_statistics(Promise<vector<NetQueryDelayer::RateLimitStatistics>> &&promise) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (stop_flag_.load(std::memory_order_relaxed)) {
+    return promise.set_error(Global::request_aborted_error());
+  }
+  send_closure_later(delayer_, &NetQueryDelayer::get_rate_limit_statistics, std::move(promise));
+}
+
+bool NetQueryDispatcher::check_stop_flag(NetQueryPtr &net_query) {
   if (stop_flag_.load(std::memory_order_relaxed)) {
     net_query->set_error(Global::request_aborted_error());
     complete_net_query(std::move(net_query));
@@ -73,7 +208,7 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
     if (check_stop_flag(net_query)) {
       return;
     }
-    send_closure_later(sequence_dispatcher_, &MultiSequenceDispatcher::send, std::move(net_query));
+    sequence_dispatcher_->send(std::move(net_query));
     return;
   }
 
@@ -113,10 +248,18 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
     return complete_net_query(std::move(net_query));
   }
 
+  if (add_rate_limited_query(net_query)) {
+    return;
+  }
+
   if (net_query->dispatch_ttl_ > 0) {
     net_query->dispatch_ttl_--;
   }
 
+  if (add_duplicate_query(net_query)) {
+    return;
+  }
+
   auto dc_pos = static_cast<size_t>(dest_dc_id.get_raw_id() - 1);
   CHECK(dc_pos < dcs_.size());
   std::lock_guard<std::mutex> guard(mutex_);
@@ -125,19 +268,19 @@ void NetQueryDispatcher::dispatch(NetQueryPtr net_query) {
   }
   switch (net_query->type()) {
     case NetQuery::Type::Common:
-      net_query->debug(PSTRING() << "sent to main session multi proxy " << dest_dc_id);
+      net_query->debug(PSLICE() << "sent to main session multi proxy " << dest_dc_id);
       send_closure_later(dcs_[dc_pos].main_session_, &SessionMultiProxy::send, std::move(net_query));
       break;
     case NetQuery::Type::Upload:
-      net_query->debug(PSTRING() << "sent to upload session multi proxy " << dest_dc_id);
+      net_query->debug(PSLICE() << "sent to upload session multi proxy " << dest_dc_id);
       send_closure_later(dcs_[dc_pos].upload_session_, &SessionMultiProxy::send, std::move(net_query));
       break;
     case NetQuery::Type::Download:
-      net_query->debug(PSTRING() << "sent to download session multi proxy " << dest_dc_id);
+      net_query->debug(PSLICE() << "sent to download session multi proxy " << dest_dc_id);
       send_closure_later(dcs_[dc_pos].download_session_, &SessionMultiProxy::send, std::move(net_query));
       break;
     case NetQuery::Type::DownloadSmall:
-      net_query->debug(PSTRING() << "sent to download small session multi proxy " << dest_dc_id);
+      net_query->debug(PSLICE() << "sent to download small session multi proxy " << dest_dc_id);
       send_closure_later(dcs_[dc_pos].download_small_session_, &SessionMultiProxy::send, std::move(net_query));
       break;
     default:
@@ -190,22 +333,24 @@ Status NetQueryDispatcher::wait_dc_init(DcId dc_id, bool force) {
     int32 slow_net_scheduler_id = G()->get_slow_net_scheduler_id();
 
     auto raw_dc_id = dc_id.get_raw_id();
-    bool is_premium = G()->get_option_boolean("is_premium");
+    bool is_premium = G()->get_option_boolean(OptionId::IsPremium);
     int32 upload_session_count = (raw_dc_id != 2 && raw_dc_id != 4) || is_premium ? 8 : 4;
     int32 download_session_count = is_premium ? 8 : 2;
     int32 download_small_session_count = is_premium ? 8 : 2;
+    // the number of main sessions is fixed, because it affects processing of updates;
+    // media sessions are added under load up to the allowed maximum
     dc.main_session_ = create_actor_on_scheduler<SessionMultiProxy>(
         PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":main", get_main_session_scheduler_id(), session_count,
-        auth_data, true, raw_dc_id == main_dc_id_, use_pfs, false, false, is_cdn);
+        session_count, auth_data, true, raw_dc_id == main_dc_id_, use_pfs, false, false, is_cdn);
     dc.upload_session_ = create_actor_on_scheduler<SessionMultiProxy>(
-        PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":upload", slow_net_scheduler_id, upload_session_count,
-        auth_data, false, false, use_pfs, false, true, is_cdn);
+        PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":upload", slow_net_scheduler_id, MIN_MEDIA_SESSION_COUNT,
+        upload_session_count, auth_data, false, false, use_pfs, false, true, is_cdn);
     dc.download_session_ = create_actor_on_scheduler<SessionMultiProxy>(
-        PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":download", slow_net_scheduler_id, download_session_count,
-        auth_data, false, false, use_pfs, true, true, is_cdn);
+        PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":download", slow_net_scheduler_id, MIN_MEDIA_SESSION_COUNT,
+        download_session_count, auth_data, false, false, use_pfs, true, true, is_cdn);
     dc.download_small_session_ = create_actor_on_scheduler<SessionMultiProxy>(
         PSLICE() << "SessionMultiProxy:" << raw_dc_id << ":download_small", slow_net_scheduler_id,
-        download_small_session_count, auth_data, false, false, use_pfs, true, true, is_cdn);
+        MIN_MEDIA_SESSION_COUNT, download_small_session_count, auth_data, false, false, use_pfs, true, true, is_cdn);
     dc.is_inited_ = true;
     if (dc_id.is_internal()) {
       send_closure_later(dc_auth_manager_, &DcAuthManager::add_dc, std::move(auth_data));
@@ -240,8 +385,29 @@ void NetQueryDispatcher::stop() {
   }
   public_rsa_key_watchdog_.reset();
   dc_auth_manager_.reset();
-  sequence_dispatcher_.reset();
+  vector<NetQueryPtr> blocked_queries;
+  if (sequence_dispatcher_ != nullptr) {
+    blocked_queries = sequence_dispatcher_->close();
+    sequence_dispatcher_.reset();
+  }
   td_guard_.reset();
+
+  FlatHashMap<string, DuplicateQueries> duplicate_queries;
+  {
+    std::lock_guard<std::mutex> duplicate_queries_guard(duplicate_queries_mutex_);
+    duplicate_queries = std::move(duplicate_queries_);
+    duplicate_queries_.clear();
+  }
+  for (auto &it : duplicate_queries) {
+    for (auto &query : it.second.queries_) {
+      query->set_error(Global::request_aborted_error());
+      complete_net_query(std::move(query));
+    }
+  }
+  for (auto &query : blocked_queries) {
+    query->set_error(Global::request_aborted_error());
+    complete_net_query(std::move(query));
+  }
 }
 
 void NetQueryDispatcher::update_session_count() {
@@ -307,7 +473,7 @@ bool NetQueryDispatcher::is_dc_inited(int32 raw_dc_id) {
 }
 
 int32 NetQueryDispatcher::get_session_count() {
-  return max(narrow_cast<int32>(G()->get_option_integer("session_count")), 1);
+  return max(narrow_cast<int32>(G()->get_option_integer(OptionId::SessionCount)), 1);
 }
 
 bool NetQueryDispatcher::get_use_pfs() {
@@ -327,7 +493,8 @@ NetQueryDispatcher::NetQueryDispatcher(const std::function<ActorShared<>()> &cre
   dc_auth_manager_ =
       create_actor_on_scheduler<DcAuthManager>("DcAuthManager", get_main_session_scheduler_id(), create_reference());
   public_rsa_key_watchdog_ = create_actor<PublicRsaKeyWatchdog>("PublicRsaKeyWatchdog", create_reference());
-  sequence_dispatcher_ = MultiSequenceDispatcher::create("MultiSequenceDispatcher");
+  sequence_dispatcher_ =
+      make_unique<ShardedSequenceDispatcher>("MultiSequenceDispatcher", SEQUENCE_DISPATCHER_SHARD_COUNT);
 
   td_guard_ = create_shared_lambda_guard([actor = create_reference()] {});
 }
@@ -8,10 +8,13 @@
 
 #include "td/telegram/net/DcId.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryDelayer.h"
 
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/FlatHashSet.h"
 #include "td/utils/Promise.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/Status.h"
@@ -25,10 +28,9 @@
 namespace td {
 
 class DcAuthManager;
-class MultiSequenceDispatcher;
-class NetQueryDelayer;
 class PublicRsaKeyWatchdog;
 class SessionMultiProxy;
+class ShardedSequenceDispatcher;
 
 // Not just dispatcher.
 class NetQueryDispatcher {
@@ -56,12 +58,21 @@ class NetQueryDispatcher {
   void set_main_dc_id(int32 new_main_dc_id);
   void check_authorization_is_ok();
 
+  // queries with the key are sent through NetQueryDelayer, which can postpone them
+  void add_rate_limited_key(const NetQueryRateLimitKey &key);
+  void remove_rate_limited_key(const NetQueryRateLimitKey &key);
+
+  void get_rate_limit_statistics(Promise<vector<NetQueryDelayer::RateLimitStatistics>> &&promise);
+
  private:
+  static constexpr int32 MIN_MEDIA_SESSION_COUNT = 1;
+  static constexpr size_t SEQUENCE_DISPATCHER_SHARD_COUNT = 4;
+
   std::atomic<bool> stop_flag_{false};
   bool need_destroy_auth_key_{false};
   ActorOwn<NetQueryDelayer> delayer_;
   ActorOwn<DcAuthManager> dc_auth_manager_;
-  ActorOwn<MultiSequenceDispatcher> sequence_dispatcher_;
+  unique_ptr<ShardedSequenceDispatcher> sequence_dispatcher_;
   struct Dc {
     DcId id_;
     std::atomic<bool> is_valid_{false};
@@ -82,6 +93,17 @@ class NetQueryDispatcher {
   std::mutex mutex_;
   std::shared_ptr<Guard> td_guard_;
 
+  // identical idempotent queries, which wait for the result of the first of them
+  struct DuplicateQueries {
+    uint64 leader_query_id_ = 0;
+    vector<NetQueryPtr> queries_;
+  };
+  std::mutex duplicate_queries_mutex_;
+  FlatHashMap<string, DuplicateQueries> duplicate_queries_;
+
+  std::atomic<bool> has_rate_limited_keys_{false};
+  FlatHashSet<NetQueryRateLimitKey, NetQueryRateLimitKeyHash> rate_limited_keys_;  // protected by mutex_
+
   Status wait_dc_init(DcId dc_id, bool force);
   bool is_dc_inited(int32 raw_dc_id);
 
@@ -89,8 +111,18 @@ class NetQueryDispatcher {
   static int32 get_session_count();
   static bool get_use_pfs();
 
-  static void complete_net_query(NetQueryPtr net_query);
-  bool check_stop_flag(NetQueryPtr &net_query) const;
+  void complete_net_query(NetQueryPtr net_query);
+  bool check_stop_flag(NetQueryPtr &net_query);
+
+  static bool is_deduplicable_query(const NetQuery &net_query);
+  static string get_duplicate_query_key(const NetQuery &net_query);
+
+  // returns true if the query was postponed until an identical query is finished
+  bool add_duplicate_query(NetQueryPtr &net_query);
+  void complete_duplicate_queries(const NetQuery &net_query);
+
+  // returns true if the query was sent to NetQueryDelayer to wait for its rate limit
+  bool add_rate_limited_query(NetQueryPtr &net_query);
 
   void try_fix_migrate(NetQueryPtr &net_query);
 };
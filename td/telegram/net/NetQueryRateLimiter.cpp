@@ -0,0 +1,69 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQueryRateLimiter.h"
+
+#include <cmath>
+
+namespace td {
+
+constexpr double NetQueryRateLimiter::MIN_RATE;
+constexpr double NetQueryRateLimiter::MAX_RATE;
+constexpr double NetQueryRateLimiter::RATE_DECREASE;
+constexpr double NetQueryRateLimiter::RATE_INCREASE;
+
+NetQueryRateLimiter::NetQueryRateLimiter(int32 flood_wait, double now)
+    : rate_(max(1.0 / flood_wait, MIN_RATE)), updated_at_(now), blocked_until_(now + flood_wait) {
+}
+
+void NetQueryRateLimiter::on_flood_wait(int32 flood_wait, double now) {
+  update(now);
+  rate_ = max(rate_ * RATE_DECREASE, MIN_RATE);
+  token_count_ = 0.0;
+  blocked_until_ = max(blocked_until_, now + flood_wait);
+}
+
+bool NetQueryRateLimiter::take_token(double now) {
+  update(now);
+  if (now < blocked_until_ || token_count_ < 1.0) {
+    return false;
+  }
+  token_count_ -= 1.0;
+  return true;
+}
+
+double NetQueryRateLimiter::get_release_time(size_t query_count, double now) {
+  update(now);
+  auto missing_token_count = static_cast<double>(query_count) - token_count_;
+  return max(now, blocked_until_) + max(missing_token_count, 0.0) / rate_;
+}
+
+double NetQueryRateLimiter::get_unlimited_time(double now) {
+  update(now);
+  auto start_time = max(now, blocked_until_);
+  if (rate_ >= MAX_RATE) {
+    return start_time;
+  }
+  return start_time + std::log(MAX_RATE / rate_) / std::log(RATE_INCREASE);
+}
+
+double NetQueryRateLimiter::get_rate(double now) {
+  update(now);
+  return rate_;
+}
+
+void NetQueryRateLimiter::update(double now) {
+  auto unblocked_time = now - max(updated_at_, blocked_until_);
+  updated_at_ = max(updated_at_, now);
+  if (unblocked_time <= 0) {
+    return;
+  }
+  // at most one query can be sent immediately after a pause
+  token_count_ = min(token_count_ + unblocked_time * rate_, 1.0);
+  rate_ = min(rate_ * std::pow(RATE_INCREASE, unblocked_time), MAX_RATE);
+}
+
+}  // namespace td
@@ -0,0 +1,46 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+namespace td {
+
+// token bucket with the rate learned from flood waits, which limits queries with the same NetQueryRateLimitKey
+class NetQueryRateLimiter {
+ public:
+  static constexpr double MIN_RATE = 1.0 / 3600;  // the minimum learned number of queries per second
+  static constexpr double MAX_RATE = 100.0;       // the rate limit is forgotten after reaching the rate
+  static constexpr double RATE_DECREASE = 0.5;    // the rate multiplier after a repeated flood wait
+  static constexpr double RATE_INCREASE = 1.05;   // the rate multiplier for each second without flood waits
+
+  // the initial rate is one query per flood wait period
+  NetQueryRateLimiter(int32 flood_wait, double now);
+
+  void on_flood_wait(int32 flood_wait, double now);
+
+  // returns true and consumes a token if a query can be sent now
+  bool take_token(double now);
+
+  // returns time after which query_count more queries can be sent; the rate increase while waiting is ignored
+  double get_release_time(size_t query_count, double now);
+
+  // returns time at which the rate reaches MAX_RATE if there will be no flood waits
+  double get_unlimited_time(double now);
+
+  double get_rate(double now);
+
+ private:
+  double rate_ = 0.0;  // the number of allowed queries per second
+  double token_count_ = 0.0;
+  double updated_at_ = 0.0;
+  double blocked_until_ = 0.0;  // queries can't be sent before this time because of a flood wait
+
+  void update(double now);
+};
+
+}  // namespace td
@@ -10,21 +10,120 @@
 
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace td {
 
 uint64 NetQueryStats::get_count() const {
   return count_.load(std::memory_order_relaxed);
 }
 
+std::pair<uint64, uint64> NetQueryStats::get_gzip_stats() const {
+  return {gzip_original_size_.load(std::memory_order_relaxed), gzip_saved_size_.load(std::memory_order_relaxed)};
+}
+
+void NetQueryStats::on_query_finished(int32 tl_constructor,
+                                      const std::array<double, NET_QUERY_STAGE_COUNT> &stage_durations) {
+  if (tl_constructor == 0) {
+    return;
+  }
+  double total_duration = 0.0;
+  for (auto duration : stage_durations) {
+    total_duration += duration;
+  }
+  static auto *histogram = MetricsRegistry::get_histogram("td_net_query_duration_seconds", 0.001);
+  histogram->observe(total_duration);
+
+  auto now = Time::now();
+  bool need_log = false;
+  {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    auto &statistics = latency_statistics_[tl_constructor];
+    statistics.tl_constructor = tl_constructor;
+    for (size_t stage = 0; stage < NET_QUERY_STAGE_COUNT; stage++) {
+      statistics.histograms[stage].add(stage_durations[stage]);
+    }
+    statistics.histograms[NET_QUERY_STAGE_COUNT].add(total_duration);
+
+    if (latency_logged_at_ == 0.0) {
+      latency_logged_at_ = now;
+    } else if (latency_logged_at_ < now - LATENCY_LOG_PERIOD) {
+      latency_logged_at_ = now;
+      need_log = true;
+    }
+  }
+  if (need_log) {
+    log_latency_statistics(get_latency_statistics(false));
+  }
+}
+
+vector<NetQueryStats::LatencyStatistics> NetQueryStats::get_latency_statistics(bool reset) {
+  vector<LatencyStatistics> result;
+  {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    result.reserve(latency_statistics_.size());
+    for (auto &it : latency_statistics_) {
+      result.push_back(it.second);
+    }
+    if (reset) {
+      latency_statistics_.clear();
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const LatencyStatistics &lhs, const LatencyStatistics &rhs) {
+    auto lhs_count = lhs.histograms[NET_QUERY_STAGE_COUNT].total_count;
+    auto rhs_count = rhs.histograms[NET_QUERY_STAGE_COUNT].total_count;
+    if (lhs_count != rhs_count) {
+      return lhs_count > rhs_count;
+    }
+    return lhs.tl_constructor < rhs.tl_constructor;
+  });
+  return result;
+}
+
+const char *NetQueryStats::get_stage_name(size_t stage) {
+  static const char *STAGE_NAMES[] = {"dispatch", "delay", "session_queue", "network", "result_handling", "total"};
+  CHECK(stage <= NET_QUERY_STAGE_COUNT);
+  return STAGE_NAMES[stage];
+}
+
+void NetQueryStats::log_latency_statistics(vector<LatencyStatistics> statistics) {
+  auto get_tail_latency = [](const LatencyStatistics &entry) {
+    auto latency = entry.histograms[NET_QUERY_STAGE_COUNT].get_percentile(0.99);
+    return latency == -1 ? std::numeric_limits<int32>::max() : latency;
+  };
+  // log queries with the worst tail latency first
+  std::stable_sort(statistics.begin(), statistics.end(),
+                   [&](const LatencyStatistics &lhs, const LatencyStatistics &rhs) {
+                     return get_tail_latency(lhs) > get_tail_latency(rhs);
+                   });
+  if (statistics.size() > MAX_LOGGED_LATENCY_STATISTICS) {
+    statistics.resize(MAX_LOGGED_LATENCY_STATISTICS);
+  }
+  for (auto &entry : statistics) {
+    string stages;
+    for (size_t stage = 0; stage <= NET_QUERY_STAGE_COUNT; stage++) {
+      const auto &histogram = entry.histograms[stage];
+      stages += PSTRING() << ' ' << get_stage_name(stage) << ' ' << histogram.get_percentile(0.5) << '/'
+                          << histogram.get_percentile(0.99);
+    }
+    LOG(INFO) << "Latency of queries " << format::as_hex(entry.tl_constructor)
+              << tag("count", entry.histograms[NET_QUERY_STAGE_COUNT].total_count) << " p50/p99 in ms:" << stages;
+  }
+}
+
 void NetQueryStats::dump_pending_network_queries() {
   auto n = get_count();
-  LOG(WARNING) << tag("pending net queries", n);
+  auto gzip_stats = get_gzip_stats();
+  LOG(WARNING) << tag("pending net queries", n) << tag("sessions", get_session_count())
+               << tag("gzipped size", gzip_stats.first) << tag("saved by gzip", gzip_stats.second);
 
-  if (!use_list_) {
+  if (!is_debug_enabled_) {
     return;
   }
   decltype(n) i = 0;
@@ -38,7 +137,8 @@ void NetQueryStats::dump_pending_network_queries() {
         LOG(WARNING) << "...";
         was_gap = false;
       }
-      const NetQueryDebug &debug = cur->get_data_unsafe();
+      CHECK(cur->get_data_unsafe() != nullptr);
+      const NetQueryDebug &debug = *cur->get_data_unsafe();
       const NetQuery &nq = *static_cast<const NetQuery *>(cur);
       LOG(WARNING) << tag("user", lpad(PSTRING() << debug.my_id_, 10, ' ')) << nq
                    << tag("total flood", format::as_time(nq.total_timeout_))
@@ -6,15 +6,21 @@
 //
 #pragma once
 
+#include "td/telegram/net/LatencyHistogram.h"
 #include "td/telegram/net/NetQueryCounter.h"
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/TsList.h"
 
+#include <array>
 #include <atomic>
+#include <mutex>
+#include <utility>
 
 namespace td {
 
+// is allocated separately for each query only if debug is enabled in NetQueryStats
 struct NetQueryDebug {
   double start_timestamp_ = 0;
   int64 my_id_ = 0;
@@ -27,10 +33,29 @@ struct NetQueryDebug {
   bool unknown_state_ = false;
 };
 
+// stages of a network query lifecycle, between which time of the query is split
+enum class NetQueryStage : int8 { Dispatch, Delay, SessionQueue, Network, ResultHandling };
+
+constexpr size_t NET_QUERY_STAGE_COUNT = 5;
+
 class NetQueryStats {
  public:
-  NetQueryCounter register_query(TsListNode<NetQueryDebug> *query) {
-    if (use_list_.load(std::memory_order_relaxed)) {
+  struct LatencyStatistics {
+    int32 tl_constructor = 0;
+    // per stage histograms, followed by the histogram of the total query latency
+    std::array<LatencyHistogram, NET_QUERY_STAGE_COUNT + 1> histograms;
+  };
+
+  // debug information about pending queries is costly to maintain, so it can be disabled
+  explicit NetQueryStats(bool is_debug_enabled = true) : is_debug_enabled_(is_debug_enabled) {
+  }
+
+  bool is_debug_enabled() const {
+    return is_debug_enabled_;
+  }
+
+  NetQueryCounter register_query(TsListNode<unique_ptr<NetQueryDebug>> *query) {
+    if (query->get_data_unsafe() != nullptr) {
       list_.put(query);
     }
     return NetQueryCounter(&count_);
@@ -38,12 +63,48 @@ class NetQueryStats {
 
   uint64 get_count() const;
 
+  void on_session_count_changed(int32 diff) {
+    session_count_.fetch_add(diff, std::memory_order_relaxed);
+  }
+
+  // returns the total number of sessions of all clients sharing the statistics
+  int32 get_session_count() const {
+    return session_count_.load(std::memory_order_relaxed);
+  }
+
+  void on_query_gzipped(size_t original_size, size_t gzipped_size) {
+    gzip_original_size_.fetch_add(original_size, std::memory_order_relaxed);
+    gzip_saved_size_.fetch_add(original_size - gzipped_size, std::memory_order_relaxed);
+  }
+
+  // returns total size of gzipped queries and the number of bytes saved by the compression
+  std::pair<uint64, uint64> get_gzip_stats() const;
+
+  void on_query_finished(int32 tl_constructor, const std::array<double, NET_QUERY_STAGE_COUNT> &stage_durations);
+
+  // the statistics are sorted by decreasing number of queries
+  vector<LatencyStatistics> get_latency_statistics(bool reset);
+
+  static const char *get_stage_name(size_t stage);
+
   void dump_pending_network_queries();
 
  private:
+  static constexpr double LATENCY_LOG_PERIOD = 300.0;
+  static constexpr size_t MAX_LOGGED_LATENCY_STATISTICS = 10;
+
   NetQueryCounter::Counter count_{0};
-  std::atomic<bool> use_list_{true};
-  TsList<NetQueryDebug> list_;
+  std::atomic<int32> session_count_{0};
+  std::atomic<uint64> gzip_original_size_{0};
+  std::atomic<uint64> gzip_saved_size_{0};
+  const bool is_debug_enabled_;
+  TsList<unique_ptr<NetQueryDebug>> list_;
+
+  std::mutex latency_mutex_;
+  FlatHashMap<int32, LatencyStatistics> latency_statistics_;
+  double latency_logged_at_ = 0.0;
+
+  void log_latency_statistics(vector<LatencyStatistics> statistics);
 };
 
 }  // namespace td
@@ -289,7 +289,7 @@ void NetStatsManager::update(NetStatsInfo &info, bool force_save) {
 }
 
 void NetStatsManager::save_stats(NetStatsInfo &info, NetType net_type) {
-  if (G()->get_option_boolean("disable_persistent_network_statistics")) {
+  if (G()->get_option_boolean(OptionId::DisablePersistentNetworkStatistics)) {
     return;
   }
 
@@ -212,23 +212,136 @@ TD_THREAD_LOCAL Semaphore *GenAuthKeyActor::semaphore_{};
 
 }  // namespace detail
 
+namespace {
+
+// weights of the traffic classes for fair dequeuing and their in-flight query limits
+constexpr int32 TRAFFIC_CLASS_WEIGHTS[] = {8, 2, 1};
+constexpr uint64 TRAFFIC_CLASS_MAX_IN_FLIGHT_QUERIES[] = {1024, 64, 16};
+
+}  // namespace
+
+Session::TrafficClass Session::get_traffic_class(const NetQuery &net_query) {
+  if (net_query.priority() > 0) {
+    return TrafficClass::Interactive;
+  }
+  if (net_query.type() != NetQuery::Type::Common) {
+    return TrafficClass::Bulk;
+  }
+  switch (net_query.tl_constructor()) {
+    case telegram_api::messages_getHistory::ID:
+    case telegram_api::messages_search::ID:
+    case telegram_api::messages_searchGlobal::ID:
+    case telegram_api::messages_getReplies::ID:
+    case telegram_api::messages_getDialogs::ID:
+    case telegram_api::channels_getParticipants::ID:
+    case telegram_api::contacts_getContacts::ID:
+    case telegram_api::upload_saveFilePart::ID:
+    case telegram_api::upload_saveBigFilePart::ID:
+    case telegram_api::upload_getFile::ID:
+      return TrafficClass::Bulk;
+    case telegram_api::account_updateStatus::ID:
+    case telegram_api::help_getConfig::ID:
+    case telegram_api::help_getAppConfig::ID:
+    case telegram_api::help_getPromoData::ID:
+    case telegram_api::help_getCountriesList::ID:
+    case telegram_api::langpack_getDifference::ID:
+    case telegram_api::langpack_getLangPack::ID:
+    case telegram_api::langpack_getStrings::ID:
+    case telegram_api::messages_getAllStickers::ID:
+    case telegram_api::messages_getRecentStickers::ID:
+    case telegram_api::messages_getFavedStickers::ID:
+    case telegram_api::messages_getSavedGifs::ID:
+    case telegram_api::messages_getMessagesViews::ID:
+      return TrafficClass::Background;
+    default:
+      return TrafficClass::Interactive;
+  }
+}
+
 void Session::PriorityQueue::push(NetQueryPtr query) {
   auto priority = query->priority();
-  queries_[priority].push(std::move(query));
+  auto &class_queue = class_queues_[static_cast<size_t>(get_traffic_class(*query))];
+  class_queue.queries[priority].push(PendingQuery{std::move(query), Time::now()});
+  class_queue.size++;
 }
 
-NetQueryPtr Session::PriorityQueue::pop() {
-  CHECK(!empty());
-  auto it = queries_.begin();
+NetQueryPtr Session::PriorityQueue::pop_from(size_t class_id) {
+  auto &class_queue = class_queues_[class_id];
+  CHECK(class_queue.size > 0);
+  auto it = class_queue.queries.begin();
   auto res = it->second.pop();
   if (it->second.empty()) {
-    queries_.erase(it);
+    class_queue.queries.erase(it);
+  }
+  class_queue.size--;
+  latency_histograms_[class_id].add(Time::now() - res.pending_since);
+  return std::move(res.query);
+}
+
+NetQueryPtr Session::PriorityQueue::pop() {
+  CHECK(!empty());
+  for (size_t class_id = 0; class_id < TRAFFIC_CLASS_COUNT; class_id++) {
+    if (class_queues_[class_id].size > 0) {
+      return pop_from(class_id);
+    }
+  }
+  UNREACHABLE();
+  return NetQueryPtr();
+}
+
+NetQueryPtr Session::PriorityQueue::pop_sendable(
+    const std::array<NetQueryCounter::Counter, TRAFFIC_CLASS_COUNT> &in_flight_query_counts) {
+  // smooth weighted round-robin among the classes, which have pending queries and are below their in-flight limit
+  int32 total_weight = 0;
+  size_t best_class_id = TRAFFIC_CLASS_COUNT;
+  for (size_t class_id = 0; class_id < TRAFFIC_CLASS_COUNT; class_id++) {
+    auto &class_queue = class_queues_[class_id];
+    if (class_queue.size == 0 ||
+        in_flight_query_counts[class_id].load(std::memory_order_relaxed) >=
+            TRAFFIC_CLASS_MAX_IN_FLIGHT_QUERIES[class_id]) {
+      continue;
+    }
+    class_queue.current_weight += TRAFFIC_CLASS_WEIGHTS[class_id];
+    total_weight += TRAFFIC_CLASS_WEIGHTS[class_id];
+    if (best_class_id == TRAFFIC_CLASS_COUNT ||
+        class_queue.current_weight > class_queues_[best_class_id].current_weight) {
+      best_class_id = class_id;
+    }
+  }
+  if (best_class_id == TRAFFIC_CLASS_COUNT) {
+    return NetQueryPtr();
+  }
+  class_queues_[best_class_id].current_weight -= total_weight;
+  return pop_from(best_class_id);
+}
+
+void Session::log_queue_latency() const {
+  static const char *TRAFFIC_CLASS_NAMES[] = {"interactive", "bulk", "background"};
+  for (size_t class_id = 0; class_id < TRAFFIC_CLASS_COUNT; class_id++) {
+    const auto &histogram = pending_queries_.get_latency_histogram(static_cast<TrafficClass>(class_id));
+    if (histogram.total_count == 0) {
+      continue;
+    }
+    LOG(INFO) << "Queue latency of " << TRAFFIC_CLASS_NAMES[class_id] << " queries in " << get_name() << ": "
+              << tag("count", histogram.total_count) << tag("p50_ms", histogram.get_percentile(0.5))
+              << tag("p99_ms", histogram.get_percentile(0.99)) << tag("buckets", format::as_array(histogram.counts));
+  }
+
+  const auto &histogram = tmp_auth_key_rotation_latency_histogram_;
+  if (histogram.total_count != 0) {
+    LOG(INFO) << "Temporary auth key rotation latency in " << get_name() << ": " << tag("count", histogram.total_count)
+              << tag("pregenerated", pregenerated_tmp_auth_key_count_) << tag("p50_ms", histogram.get_percentile(0.5))
+              << tag("p99_ms", histogram.get_percentile(0.99)) << tag("buckets", format::as_array(histogram.counts));
   }
-  return res;
 }
 
 bool Session::PriorityQueue::empty() const {
-  return queries_.empty();
+  for (auto &class_queue : class_queues_) {
+    if (class_queue.size > 0) {
+      return false;
+    }
+  }
+  return true;
 }
 
 Session::Session(unique_ptr<Callback> callback, std::shared_ptr<AuthDataShared> shared_auth_data, int32 raw_dc_id,
@@ -373,7 +486,7 @@ void Session::connection_online_update(double now, bool force) {
 void Session::send(NetQueryPtr &&query) {
   last_activity_timestamp_ = Time::now();
 
-  // query->debug(PSTRING() << get_name() << ": received from SessionProxy");
+  // query->debug(PSLICE() << get_name() << ": received from SessionProxy");
   query->set_session_id(auth_data_.get_session_id());
   VLOG(net_query) << "Receive query " << query;
   if (query->update_is_ready()) {
@@ -436,6 +549,10 @@ void Session::on_bind_result(NetQueryPtr query) {
     LOG(INFO) << "Bound temp auth key " << auth_data_.get_tmp_auth_key().id();
     auth_data_.on_bind();
     last_bind_success_timestamp_ = Time::now();
+    if (tmp_auth_key_needed_at_ != 0) {
+      tmp_auth_key_rotation_latency_histogram_.add(last_bind_success_timestamp_ - tmp_auth_key_needed_at_);
+      tmp_auth_key_needed_at_ = 0;
+    }
     on_tmp_auth_key_updated();
   } else if (status.message() == "DispatchTtlError") {
     LOG(INFO) << "Resend bind auth key " << auth_data_.get_tmp_auth_key().id() << " request after DispatchTtlError";
@@ -783,9 +900,10 @@ void Session::on_message_ack_impl_inner(mtproto::MessageId message_id, int32 typ
   }
   VLOG(net_query) << "Ack " << it->second.net_query_;
   it->second.is_acknowledged_ = true;
-  {
+  auto *debug = it->second.net_query_->get_debug_unsafe();
+  if (debug != nullptr) {
     auto lock = it->second.net_query_->lock();
-    it->second.net_query_->get_data_unsafe().ack_state_ |= type;
+    debug->ack_state_ |= type;
   }
   it->second.net_query_->quick_ack_promise_.set_value(Unit());
   if (!in_container) {
@@ -822,9 +940,10 @@ void Session::cleanup_container(mtproto::MessageId container_message_id, Query *
 }
 
 void Session::mark_as_known(mtproto::MessageId message_id, Query *query) {
-  {
+  auto *debug = query->net_query_->get_debug_unsafe();
+  if (debug != nullptr) {
     auto lock = query->net_query_->lock();
-    query->net_query_->get_data_unsafe().unknown_state_ = false;
+    debug->unknown_state_ = false;
   }
   if (!query->is_unknown_) {
     return;
@@ -838,9 +957,10 @@ void Session::mark_as_known(mtproto::MessageId message_id, Query *query) {
 }
 
 void Session::mark_as_unknown(mtproto::MessageId message_id, Query *query) {
-  {
+  auto *debug = query->net_query_->get_debug_unsafe();
+  if (debug != nullptr) {
     auto lock = query->net_query_->lock();
-    query->net_query_->get_data_unsafe().unknown_state_ = true;
+    debug->unknown_state_ = true;
   }
   if (query->is_unknown_) {
     return;
@@ -1081,7 +1201,7 @@ void Session::on_message_info(mtproto::MessageId message_id, int32 state, mtprot
     if (it != sent_queries_.end()) {
       VLOG_IF(net_query, message_id != mtproto::MessageId())
           << "Resend answer " << answer_message_id << ": " << tag("answer_size", answer_size) << it->second.net_query_;
-      it->second.net_query_->debug(PSTRING() << get_name() << ": resend answer");
+      it->second.net_query_->debug(PSLICE() << get_name() << ": resend answer");
     }
     current_info_->connection_->resend_answer(answer_message_id);
   }
@@ -1111,7 +1231,8 @@ void Session::resend_query(NetQueryPtr query) {
 
 void Session::add_query(NetQueryPtr &&net_query) {
   CHECK(UniqueId::extract_type(net_query->id()) != UniqueId::BindKey);
-  net_query->debug(PSTRING() << get_name() << ": pending");
+  net_query->debug(PSLICE() << get_name() << ": pending");
+  net_query->set_stage(NetQueryStage::SessionQueue);
   pending_queries_.push(std::move(net_query));
 }
 
@@ -1135,7 +1256,7 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
   }
   if (!invoke_after.empty()) {
     if (!unknown_queries_.empty()) {
-      net_query->debug(PSTRING() << get_name() << ": wait unknown query to invoke after it");
+      net_query->debug(PSLICE() << get_name() << ": wait unknown query to invoke after it");
       pending_invoke_after_queries_.push_back(std::move(net_query));
       return;
     }
@@ -1144,7 +1265,7 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
   auto now = Time::now();
   bool immediately_fail_query = false;
   if (!immediately_fail_query) {
-    net_query->debug(PSTRING() << get_name() << ": send to an MTProto connection");
+    net_query->debug(PSLICE() << get_name() << ": send to an MTProto connection");
     auto r_message_id = info->connection_->send_query(
         net_query->query().clone(), net_query->gzip_flag() == NetQuery::GzipFlag::On, message_id,
         invoke_after_message_ids, static_cast<bool>(net_query->quick_ack_promise_));
@@ -1162,17 +1283,21 @@ void Session::connection_send_query(ConnectionInfo *info, NetQueryPtr &&net_quer
   }
   net_query->set_message_id(message_id.get());
   VLOG(net_query) << "Send query to connection " << net_query << tag("invoke_after", invoke_after_message_ids);
-  {
+  auto *debug = net_query->get_debug_unsafe();
+  if (debug != nullptr) {
     auto lock = net_query->lock();
-    net_query->get_data_unsafe().unknown_state_ = false;
-    net_query->get_data_unsafe().ack_state_ = 0;
+    debug->unknown_state_ = false;
+    debug->ack_state_ = 0;
   }
   if (!net_query->cancel_slot_.empty()) {
     LOG(DEBUG) << "Set event for net_query cancellation for " << message_id;
     net_query->cancel_slot_.set_event(EventCreator::raw(actor_id(), message_id.get()));
   }
+  net_query->set_stage(NetQueryStage::Network);
+  auto traffic_class = get_traffic_class(*net_query);
   auto status =
-      sent_queries_.emplace(message_id, Query{message_id, std::move(net_query), main_connection_.connection_id_, now});
+      sent_queries_.emplace(message_id, Query{message_id, std::move(net_query), main_connection_.connection_id_, now,
+                                              &in_flight_query_counts_[static_cast<size_t>(traffic_class)]});
   LOG_CHECK(status.second) << message_id;
   sent_queries_list_.put(status.first->second.get_list_node());
   if (!status.second) {
@@ -1406,36 +1531,47 @@ void Session::on_handshake_ready(Result<unique_ptr<mtproto::AuthKeyHandshake>> r
     if (!handshake->is_ready_for_finish()) {
       LOG(INFO) << "Handshake is not yet ready";
       info.handshake_ = std::move(handshake);
+    } else if (!is_main && !auth_data_.need_tmp_auth_key(Time::now(), get_tmp_auth_key_refresh_time())) {
+      LOG(INFO) << "Keep pre-generated temporary auth key " << handshake->get_auth_key().id();
+      next_tmp_auth_key_handshake_ = std::move(handshake);
     } else {
-      if (is_main) {
-        auth_data_.set_main_auth_key(handshake->release_auth_key());
-        on_auth_key_updated();
-      } else {
-        auth_data_.set_tmp_auth_key(handshake->release_auth_key());
-        if (is_main_) {
-          registered_temp_auth_key_ = TempAuthKeyWatchdog::register_auth_key_id(auth_data_.get_tmp_auth_key().id());
-        }
-        on_tmp_auth_key_updated();
-      }
-      LOG(WARNING) << "Update auth key in session_id " << auth_data_.get_session_id() << " to "
-                   << auth_data_.get_auth_key().id();
-      connection_close(&main_connection_);
-      connection_close(&long_poll_connection_);
-
-      // Salt of temporary key is different salt. Do not rewrite it
-      if (auth_data_.use_pfs() ^ is_main) {
-        auth_data_.set_server_salt(handshake->get_server_salt(), Time::now());
-        on_server_salt_updated();
-      }
-      if (auth_data_.update_server_time_difference(handshake->get_server_time_diff())) {
-        on_server_time_difference_updated(true);
-      }
+      apply_auth_key_handshake(is_main, std::move(handshake));
     }
   }
 
   loop();
 }
 
+void Session::apply_auth_key_handshake(bool is_main, unique_ptr<mtproto::AuthKeyHandshake> handshake) {
+  if (is_main) {
+    auth_data_.set_main_auth_key(handshake->release_auth_key());
+    on_auth_key_updated();
+  } else {
+    auth_data_.set_tmp_auth_key(handshake->release_auth_key());
+    if (is_main_) {
+      registered_temp_auth_key_ = TempAuthKeyWatchdog::register_auth_key_id(auth_data_.get_tmp_auth_key().id());
+    }
+    on_tmp_auth_key_updated();
+  }
+  LOG(WARNING) << "Update auth key in session_id " << auth_data_.get_session_id() << " to "
+               << auth_data_.get_auth_key().id();
+  connection_close(&main_connection_);
+  connection_close(&long_poll_connection_);
+
+  // Salt of temporary key is different salt. Do not rewrite it
+  if (auth_data_.use_pfs() ^ is_main) {
+    auth_data_.set_server_salt(handshake->get_server_salt(), Time::now());
+    on_server_salt_updated();
+  }
+  if (auth_data_.update_server_time_difference(handshake->get_server_time_diff())) {
+    on_server_time_difference_updated(true);
+  }
+}
+
+double Session::get_tmp_auth_key_refresh_time() const {
+  return persist_tmp_auth_key_ ? 2 * 60 : 60 * 60;
+}
+
 void Session::create_gen_auth_key_actor(HandshakeId handshake_id) {
   auto &info = handshake_info_[handshake_id];
   if (info.flag_) {
@@ -1495,7 +1631,25 @@ void Session::auth_loop(double now) {
   if (auth_data_.need_main_auth_key()) {
     create_gen_auth_key_actor(MainAuthKeyHandshake);
   }
-  if (auth_data_.need_tmp_auth_key(now, persist_tmp_auth_key_ ? 2 * 60 : 60 * 60)) {
+  auto refresh_time = get_tmp_auth_key_refresh_time();
+  if (auth_data_.need_tmp_auth_key(now, refresh_time)) {
+    if (tmp_auth_key_needed_at_ == 0) {
+      tmp_auth_key_needed_at_ = now;
+    }
+    if (next_tmp_auth_key_handshake_ != nullptr) {
+      auto handshake = std::move(next_tmp_auth_key_handshake_);
+      if (handshake->get_auth_key().expires_at() > now + refresh_time + TMP_AUTH_KEY_PREGENERATION_TIME) {
+        LOG(INFO) << "Use pre-generated temporary auth key " << handshake->get_auth_key().id();
+        pregenerated_tmp_auth_key_count_++;
+        apply_auth_key_handshake(false, std::move(handshake));
+        return;
+      }
+      LOG(INFO) << "Drop outdated pre-generated temporary auth key " << handshake->get_auth_key().id();
+    }
+    create_gen_auth_key_actor(TmpAuthKeyHandshake);
+  } else if (next_tmp_auth_key_handshake_ == nullptr &&
+             auth_data_.need_tmp_auth_key(now, refresh_time + TMP_AUTH_KEY_PREGENERATION_TIME)) {
+    // generate the next key in advance to replace the current key without waiting for a handshake
     create_gen_auth_key_actor(TmpAuthKeyHandshake);
   }
 }
@@ -1513,6 +1667,10 @@ void Session::loop() {
   if (cached_connection_timestamp_ < now - 10) {
     cached_connection_.reset();
   }
+  if (queue_latency_logged_at_ < now - QUEUE_LATENCY_LOG_PERIOD) {
+    queue_latency_logged_at_ = now;
+    log_queue_latency();
+  }
   if (!is_main_ && !has_queries() && !need_destroy_auth_key_ && last_activity_timestamp_ < now - ACTIVITY_TIMEOUT) {
     on_session_failed(Status::OK());
   }
@@ -1547,7 +1705,10 @@ void Session::loop() {
       if (auth_data_.is_ready(now)) {
         if (need_send_query()) {
           while (!pending_queries_.empty() && sent_queries_.size() < MAX_INFLIGHT_QUERIES) {
-            auto query = pending_queries_.pop();
+            auto query = pending_queries_.pop_sendable(in_flight_query_counts_);
+            if (query.empty()) {
+              break;
+            }
             connection_send_query(&main_connection_, std::move(query));
             need_flush = true;
           }
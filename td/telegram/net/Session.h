@@ -7,7 +7,9 @@
 #pragma once
 
 #include "td/telegram/net/AuthDataShared.h"
+#include "td/telegram/net/LatencyHistogram.h"
 #include "td/telegram/net/NetQuery.h"
+#include "td/telegram/net/NetQueryCounter.h"
 #include "td/telegram/net/TempAuthKeyWatchdog.h"
 
 #include "td/mtproto/AuthData.h"
@@ -79,6 +81,12 @@ class Session final
   static bool is_high_loaded();
 
  private:
+  // queries of different traffic classes are dequeued fairly and have separate in-flight limits
+  enum class TrafficClass : int8 { Interactive, Bulk, Background };
+  static constexpr size_t TRAFFIC_CLASS_COUNT = 3;
+
+  static TrafficClass get_traffic_class(const NetQuery &net_query);
+
   struct Query final : private ListNode {
     mtproto::MessageId container_message_id_;
     NetQueryPtr net_query_;
@@ -89,11 +97,15 @@ class Session final
     const int8 connection_id_;
     const double sent_at_;
 
-    Query(mtproto::MessageId message_id, NetQueryPtr &&net_query, int8 connection_id, double sent_at)
+    NetQueryCounter in_flight_query_counter_;
+
+    Query(mtproto::MessageId message_id, NetQueryPtr &&net_query, int8 connection_id, double sent_at,
+          NetQueryCounter::Counter *in_flight_query_count)
         : container_message_id_(message_id)
         , net_query_(std::move(net_query))
         , connection_id_(connection_id)
-        , sent_at_(sent_at) {
+        , sent_at_(sent_at)
+        , in_flight_query_counter_(in_flight_query_count) {
     }
 
     ListNode *get_list_node() {
@@ -136,6 +148,9 @@ class Session final
   FlatHashSet<mtproto::MessageId, mtproto::MessageIdHash> unknown_queries_;
   vector<mtproto::MessageId> to_cancel_message_ids_;
 
+  // must be destroyed after sent_queries_, which reference the counters
+  std::array<NetQueryCounter::Counter, TRAFFIC_CLASS_COUNT> in_flight_query_counts_{};
+
   // Do not invalidate iterators of these two containers!
   // TODO: better data structures
   struct PriorityQueue {
@@ -143,13 +158,36 @@ class Session final
     NetQueryPtr pop();
     bool empty() const;
 
+    // returns the next query, which can be sent without exceeding in-flight query limits, or an empty query
+    NetQueryPtr pop_sendable(const std::array<NetQueryCounter::Counter, TRAFFIC_CLASS_COUNT> &in_flight_query_counts);
+
+    const LatencyHistogram &get_latency_histogram(TrafficClass traffic_class) const {
+      return latency_histograms_[static_cast<size_t>(traffic_class)];
+    }
+
    private:
-    std::map<int8, VectorQueue<NetQueryPtr>, std::greater<>> queries_;
+    struct PendingQuery {
+      NetQueryPtr query;
+      double pending_since = 0.0;
+    };
+    struct ClassQueue {
+      std::map<int8, VectorQueue<PendingQuery>, std::greater<>> queries;
+      size_t size = 0;
+      int32 current_weight = 0;
+    };
+    std::array<ClassQueue, TRAFFIC_CLASS_COUNT> class_queues_;
+    std::array<LatencyHistogram, TRAFFIC_CLASS_COUNT> latency_histograms_;
+
+    NetQueryPtr pop_from(size_t class_id);
   };
   PriorityQueue pending_queries_;
   std::map<mtproto::MessageId, Query> sent_queries_;
   std::deque<NetQueryPtr> pending_invoke_after_queries_;
   ListNode sent_queries_list_;
+  double queue_latency_logged_at_ = 0;
+  double tmp_auth_key_needed_at_ = 0;  // time when rotation of the temporary key was started or 0
+  LatencyHistogram tmp_auth_key_rotation_latency_histogram_;
+  uint64 pregenerated_tmp_auth_key_count_ = 0;  // the number of rotations, which didn't wait for a handshake
 
   struct ConnectionInfo {
     int8 connection_id_ = 0;
@@ -179,6 +217,8 @@ class Session final
 
   static constexpr double ACTIVITY_TIMEOUT = 60 * 5;
   static constexpr size_t MAX_INFLIGHT_QUERIES = 1024;
+  static constexpr double QUEUE_LATENCY_LOG_PERIOD = 60;
+  static constexpr double TMP_AUTH_KEY_PREGENERATION_TIME = 30 * 60;  // the next temporary key is generated in advance
 
   struct ContainerInfo {
     size_t ref_cnt;
@@ -194,6 +234,7 @@ class Session final
   };
   enum HandshakeId : int32 { MainAuthKeyHandshake = 0, TmpAuthKeyHandshake = 1 };
   std::array<HandshakeInfo, 2> handshake_info_;
+  unique_ptr<mtproto::AuthKeyHandshake> next_tmp_auth_key_handshake_;  // finished handshake with the next temporary key
 
   double wakeup_at_;
 
@@ -201,6 +242,8 @@ class Session final
   mtproto::AuthData auth_data_;
 
   void on_handshake_ready(Result<unique_ptr<mtproto::AuthKeyHandshake>> r_handshake);
+  void apply_auth_key_handshake(bool is_main, unique_ptr<mtproto::AuthKeyHandshake> handshake);
+  double get_tmp_auth_key_refresh_time() const;
   void create_gen_auth_key_actor(HandshakeId handshake_id);
   void auth_loop(double now);
 
@@ -278,6 +321,7 @@ class Session final
   void start_up() final;
   void timeout_expired() final;
   void loop() final;
+  void log_queue_latency() const;
   void hangup() final;
   void raw_event(const Event::Raw &event) final;
 
@@ -6,6 +6,9 @@
 //
 #include "td/telegram/net/SessionMultiProxy.h"
 
+#include "td/telegram/Global.h"
+#include "td/telegram/net/NetQueryCreator.h"
+#include "td/telegram/net/NetQueryStats.h"
 #include "td/telegram/net/SessionProxy.h"
 
 #include "td/utils/common.h"
@@ -15,15 +18,17 @@
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Time.h"
 
 namespace td {
 
 SessionMultiProxy::~SessionMultiProxy() = default;
 
-SessionMultiProxy::SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDataShared> shared_auth_data,
-                                     bool is_primary, bool is_main, bool use_pfs, bool allow_media_only, bool is_media,
-                                     bool is_cdn)
-    : session_count_(session_count)
+SessionMultiProxy::SessionMultiProxy(int32 min_session_count, int32 max_session_count,
+                                     std::shared_ptr<AuthDataShared> shared_auth_data, bool is_primary, bool is_main,
+                                     bool use_pfs, bool allow_media_only, bool is_media, bool is_cdn)
+    : min_session_count_(min_session_count)
+    , max_session_count_(max_session_count)
     , auth_data_(std::move(shared_auth_data))
     , is_primary_(is_primary)
     , is_main_(is_main)
@@ -34,36 +39,50 @@ SessionMultiProxy::SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDa
   if (allow_media_only_) {
     CHECK(is_media_);
   }
+  CHECK(0 < min_session_count_ && min_session_count_ <= max_session_count_);
 }
 
 void SessionMultiProxy::send(NetQueryPtr query) {
   size_t pos = 0;
-  if (query->auth_flag() == NetQuery::AuthFlag::On) {
+  // queries to CDN never need authorization, but they can be spread over all sessions as well
+  if (query->auth_flag() == NetQuery::AuthFlag::On || is_cdn_) {
+    auto active_session_count = static_cast<size_t>(session_count_);
     size_t session_rand = query->session_rand();
     if (session_rand) {
-      pos = session_rand % sessions_.size();
+      pos = session_rand % active_session_count;
     } else {
       size_t equal_count = 1;
       int min_query_count = sessions_[pos].query_count;
-      for (size_t i = 1; i < sessions_.size(); i++) {
+      for (size_t i = 1; i < active_session_count; i++) {
         if (sessions_[i].query_count < min_query_count) {
           pos = i;
           min_query_count = sessions_[pos].query_count;
           equal_count = 1;
-        } else if (sessions_[i].query_count == min_query_count) {
+        } else if (sessions_[i].query_count == min_query_count && !is_scalable()) {
+          // sessions are chosen in order if they can be scaled, so the last of them becomes idle first
           equal_count++;
           if (Random::fast_uint32() % equal_count == 0) {
             pos = i;
           }
         }
       }
+      if (session_count_ < max_session_count_ && need_scale_up(sessions_[pos])) {
+        add_session();
+        pos = static_cast<size_t>(session_count_ - 1);
+      }
     }
   }
-  // query->debug(PSTRING() << get_name() << ": send to proxy #" << pos);
+  // query->debug(PSLICE() << get_name() << ": send to proxy #" << pos);
   sessions_[pos].query_count++;
+  sessions_[pos].last_query_time = Time::now();
   send_closure(sessions_[pos].proxy, &SessionProxy::send, std::move(query));
 }
 
+bool SessionMultiProxy::need_scale_up(const SessionInfo &session) const {
+  return session.query_count >= SCALE_UP_QUERY_COUNT ||
+         session.query_count * session.network_time >= SCALE_UP_QUERY_DELAY;
+}
+
 void SessionMultiProxy::update_main_flag(bool is_main) {
   LOG(INFO) << "Update is_main to " << is_main;
   is_main_ = is_main;
@@ -73,18 +92,23 @@ void SessionMultiProxy::update_main_flag(bool is_main) {
 }
 
 void SessionMultiProxy::destroy_auth_key() {
-  update_options(1, false, true);
+  do_update_options(1, 1, false, true);
 }
 
 void SessionMultiProxy::update_session_count(int32 session_count) {
-  update_options(session_count, use_pfs_, need_destroy_auth_key_);
+  do_update_options(session_count, session_count, use_pfs_, need_destroy_auth_key_);
 }
 
 void SessionMultiProxy::update_use_pfs(bool use_pfs) {
-  update_options(session_count_, use_pfs, need_destroy_auth_key_);
+  do_update_options(min_session_count_, max_session_count_, use_pfs, need_destroy_auth_key_);
 }
 
 void SessionMultiProxy::update_options(int32 session_count, bool use_pfs, bool need_destroy_auth_key) {
+  do_update_options(session_count, session_count, use_pfs, need_destroy_auth_key);
+}
+
+void SessionMultiProxy::do_update_options(int32 min_session_count, int32 max_session_count, bool use_pfs,
+                                          bool need_destroy_auth_key) {
   if (need_destroy_auth_key_) {
     LOG(INFO) << "Ignore session option changes while destroying auth key";
     return;
@@ -92,10 +116,12 @@ void SessionMultiProxy::update_options(int32 session_count, bool use_pfs, bool n
 
   bool is_changed = false;
 
-  session_count = clamp(session_count, 1, 100);
-  if (session_count != session_count_) {
-    session_count_ = session_count;
-    LOG(INFO) << "Update session_count to " << session_count_;
+  min_session_count = clamp(min_session_count, 1, 100);
+  max_session_count = clamp(max_session_count, min_session_count, 100);
+  if (min_session_count != min_session_count_ || max_session_count != max_session_count_) {
+    min_session_count_ = min_session_count;
+    max_session_count_ = max_session_count;
+    LOG(INFO) << "Update session_count to [" << min_session_count_ << ", " << max_session_count_ << ']';
     is_changed = true;
   }
 
@@ -126,54 +152,120 @@ void SessionMultiProxy::update_mtproto_header() {
 }
 
 void SessionMultiProxy::start_up() {
+  net_query_stats_ = G()->net_query_creator().get_net_query_stats();
   init();
 }
 
+void SessionMultiProxy::tear_down() {
+  on_session_count_changed(-static_cast<int32>(sessions_.size()));
+}
+
 bool SessionMultiProxy::get_pfs_flag() const {
   return use_pfs_ && !is_cdn_;
 }
 
 void SessionMultiProxy::init() {
   sessions_generation_++;
+  on_session_count_changed(-static_cast<int32>(sessions_.size()));
   sessions_.clear();
-  if (is_main_ && session_count_ > 1) {
-    LOG(WARNING) << tag("session_count", session_count_);
-  }
-  for (int32 i = 0; i < session_count_; i++) {
-    string name = PSTRING() << "Session" << get_name().substr(Slice("SessionMulti").size())
-                            << format::cond(session_count_ > 1, format::concat("#", i));
-
-    SessionInfo info;
-    class Callback final : public SessionProxy::Callback {
-     public:
-      Callback(ActorId<SessionMultiProxy> parent, uint32 generation, int32 session_id)
-          : parent_(parent), generation_(generation), session_id_(session_id) {
-      }
-      void on_query_finished() final {
-        send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, session_id_);
-      }
+  session_count_ = 0;
+  if (is_main_ && min_session_count_ > 1) {
+    LOG(WARNING) << tag("session_count", min_session_count_);
+  }
+  while (session_count_ < min_session_count_) {
+    add_session();
+  }
+}
+
+void SessionMultiProxy::add_session() {
+  CHECK(session_count_ < max_session_count_);
+  auto session_id = session_count_++;
+  if (session_count_ > min_session_count_ && !has_timeout()) {
+    set_timeout_in(SCALE_DOWN_IDLE_TIME);
+  }
+  if (static_cast<size_t>(session_id) < sessions_.size()) {
+    LOG(INFO) << "Reuse drained session #" << session_id;
+    return;
+  }
+  if (session_id >= min_session_count_) {
+    LOG(INFO) << "Add session #" << session_id;
+  }
+  CHECK(static_cast<size_t>(session_id) == sessions_.size());
+
+  string name = PSTRING() << "Session" << get_name().substr(Slice("SessionMulti").size())
+                          << format::cond(max_session_count_ > 1, format::concat("#", session_id));
 
-     private:
-      ActorId<SessionMultiProxy> parent_;
-      uint32 generation_;
-      int32 session_id_;
-    };
-    info.proxy =
-        create_actor<SessionProxy>(name, make_unique<Callback>(actor_id(this), sessions_generation_, i), auth_data_,
-                                   is_primary_, is_main_, allow_media_only_, is_media_, get_pfs_flag(),
-                                   session_count_ > 1 && is_primary_, is_cdn_, need_destroy_auth_key_ && i == 0);
-    sessions_.push_back(std::move(info));
+  SessionInfo info;
+  class Callback final : public SessionProxy::Callback {
+   public:
+    Callback(ActorId<SessionMultiProxy> parent, uint32 generation, int32 session_id)
+        : parent_(parent), generation_(generation), session_id_(session_id) {
+    }
+    void on_query_finished(double network_time) final {
+      send_closure(parent_, &SessionMultiProxy::on_query_finished, generation_, session_id_, network_time);
+    }
+
+   private:
+    ActorId<SessionMultiProxy> parent_;
+    uint32 generation_;
+    int32 session_id_;
+  };
+  info.proxy = create_actor<SessionProxy>(name, make_unique<Callback>(actor_id(this), sessions_generation_, session_id),
+                                          auth_data_, is_primary_, is_main_, allow_media_only_, is_media_,
+                                          get_pfs_flag(), max_session_count_ > 1 && is_primary_, is_cdn_,
+                                          need_destroy_auth_key_ && session_id == 0);
+  sessions_.push_back(std::move(info));
+  on_session_count_changed(1);
+}
+
+void SessionMultiProxy::timeout_expired() {
+  if (session_count_ <= min_session_count_) {
+    return;
+  }
+  auto now = Time::now();
+  auto &last_session = sessions_[session_count_ - 1];
+  if (last_session.query_count == 0 && last_session.last_query_time < now - SCALE_DOWN_IDLE_TIME) {
+    session_count_--;
+    LOG(INFO) << "Drain session #" << session_count_;
+    destroy_drained_sessions();
+  }
+  if (session_count_ > min_session_count_) {
+    set_timeout_in(max(sessions_[session_count_ - 1].last_query_time + SCALE_DOWN_IDLE_TIME - now, 1.0));
+  }
+}
+
+void SessionMultiProxy::destroy_drained_sessions() {
+  while (sessions_.size() > static_cast<size_t>(session_count_) && sessions_.back().query_count == 0) {
+    LOG(INFO) << "Destroy session #" << sessions_.size() - 1;
+    sessions_.pop_back();
+    on_session_count_changed(-1);
+  }
+}
+
+void SessionMultiProxy::on_session_count_changed(int32 diff) {
+  if (net_query_stats_ != nullptr && diff != 0) {
+    net_query_stats_->on_session_count_changed(diff);
   }
 }
 
-void SessionMultiProxy::on_query_finished(uint32 generation, int session_id) {
+void SessionMultiProxy::on_query_finished(uint32 generation, int session_id, double network_time) {
   if (generation != sessions_generation_) {
     return;
   }
   CHECK(static_cast<size_t>(session_id) < sessions_.size());
-  auto &query_count = sessions_[session_id].query_count;
-  CHECK(query_count > 0);
-  query_count--;
+  auto &session = sessions_[session_id];
+  CHECK(session.query_count > 0);
+  session.query_count--;
+  if (network_time > 0.0) {
+    if (session.network_time == 0.0) {
+      session.network_time = network_time;
+    } else {
+      session.network_time += (network_time - session.network_time) * NETWORK_TIME_SMOOTHING;
+    }
+  }
+  if (session_id >= session_count_) {
+    destroy_drained_sessions();
+  }
 }
 
 }  // namespace td
@@ -11,16 +11,20 @@
 
 #include "td/actor/actor.h"
 
+#include "td/utils/common.h"
+
 #include <memory>
 
 namespace td {
 
+class NetQueryStats;
 class SessionProxy;
 
 class SessionMultiProxy final : public Actor {
  public:
-  SessionMultiProxy(int32 session_count, std::shared_ptr<AuthDataShared> shared_auth_data, bool is_primary,
-                    bool is_main, bool use_pfs, bool allow_media_only, bool is_media, bool is_cdn);
+  // the number of sessions is changed between min_session_count and max_session_count depending on the load
+  SessionMultiProxy(int32 min_session_count, int32 max_session_count, std::shared_ptr<AuthDataShared> shared_auth_data,
+                    bool is_primary, bool is_main, bool use_pfs, bool allow_media_only, bool is_media, bool is_cdn);
   SessionMultiProxy(const SessionMultiProxy &) = delete;
   SessionMultiProxy &operator=(const SessionMultiProxy &) = delete;
   ~SessionMultiProxy() final;
@@ -36,8 +40,16 @@ class SessionMultiProxy final : public Actor {
   void destroy_auth_key();
 
  private:
-  int32 session_count_ = 0;
+  static constexpr int32 SCALE_UP_QUERY_COUNT = 4;       // pending queries in the least loaded session
+  static constexpr double SCALE_UP_QUERY_DELAY = 1.0;    // expected delay of a new query in the least loaded session
+  static constexpr double SCALE_DOWN_IDLE_TIME = 60.0;   // time without queries, after which a session is drained
+  static constexpr double NETWORK_TIME_SMOOTHING = 0.2;  // weight of the last query in the smoothed network time
+
+  int32 min_session_count_ = 0;
+  int32 max_session_count_ = 0;
+  int32 session_count_ = 0;  // the number of sessions to which new queries are sent
   std::shared_ptr<AuthDataShared> auth_data_;
+  std::shared_ptr<NetQueryStats> net_query_stats_;
   const bool is_primary_;
   bool is_main_ = false;
   bool use_pfs_ = false;
@@ -48,16 +60,35 @@ class SessionMultiProxy final : public Actor {
   struct SessionInfo {
     ActorOwn<SessionProxy> proxy;
     int query_count{0};
+    double network_time{0.0};  // smoothed time spent by finished queries in the network
+    double last_query_time{0.0};
   };
   uint32 sessions_generation_{0};
+  // the first session_count_ sessions are active, the others are drained and are destroyed after their last query
   std::vector<SessionInfo> sessions_;
 
   void start_up() final;
+  void tear_down() final;
+  void timeout_expired() final;
   void init();
 
+  void do_update_options(int32 min_session_count, int32 max_session_count, bool use_pfs, bool need_destroy_auth_key);
+
+  bool is_scalable() const {
+    return max_session_count_ > min_session_count_;
+  }
+
+  bool need_scale_up(const SessionInfo &session) const;
+
+  void add_session();
+
+  void destroy_drained_sessions();
+
+  void on_session_count_changed(int32 diff);
+
   bool get_pfs_flag() const;
 
-  void on_query_finished(uint32 generation, int session_id);
+  void on_query_finished(uint32 generation, int session_id, double network_time);
 };
 
 }  // namespace td
@@ -78,7 +78,7 @@ class SessionCallback final : public Session::Callback {
 
   void on_result(NetQueryPtr query) final {
     if (UniqueId::extract_type(query->id()) != UniqueId::BindKey) {
-      send_closure(parent_, &SessionProxy::on_query_finished);
+      send_closure(parent_, &SessionProxy::on_query_finished, query->get_stage_duration(NetQueryStage::Network));
     }
     G()->net_query_dispatcher().dispatch(std::move(query));
   }
@@ -145,7 +145,7 @@ void SessionProxy::start_up() {
 void SessionProxy::tear_down() {
   for (auto &query : pending_queries_) {
     query->resend();
-    callback_->on_query_finished();
+    callback_->on_query_finished(0.0);
     G()->net_query_dispatcher().dispatch(std::move(query));
   }
   pending_queries_.clear();
@@ -153,12 +153,12 @@ void SessionProxy::tear_down() {
 
 void SessionProxy::send(NetQueryPtr query) {
   if (query->auth_flag() == NetQuery::AuthFlag::On && auth_key_state_ != AuthKeyState::OK) {
-    query->debug(PSTRING() << get_name() << ": wait for auth");
+    query->debug(PSLICE() << get_name() << ": wait for auth");
     pending_queries_.emplace_back(std::move(query));
     return;
   }
   open_session(true);
-  query->debug(PSTRING() << get_name() << ": sent to session");
+  query->debug(PSLICE() << get_name() << ": sent to session");
   send_closure(session_, &Session::send, std::move(query));
 }
 
@@ -252,7 +252,7 @@ void SessionProxy::update_auth_key_state() {
     return;
   }
   for (auto &query : pending_queries_) {
-    query->debug(PSTRING() << get_name() << ": sent to session");
+    query->debug(PSLICE() << get_name() << ": sent to session");
     send_closure(session_, &Session::send, std::move(query));
   }
   pending_queries_.clear();
@@ -274,8 +274,8 @@ void SessionProxy::on_server_salt_updated(std::vector<mtproto::ServerSalt> serve
   server_salts_ = std::move(server_salts);
 }
 
-void SessionProxy::on_query_finished() {
-  callback_->on_query_finished();
+void SessionProxy::on_query_finished(double network_time) {
+  callback_->on_query_finished(network_time);
 }
 
 }  // namespace td
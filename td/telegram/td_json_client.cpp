@@ -43,6 +43,22 @@ const char *td_receive(double timeout) {
   return td::json_receive(timeout);
 }
 
+const char *td_receive_with_length(double timeout, size_t *length) {
+  return td::json_receive(timeout, length);
+}
+
+const char *td_receive_binary(double timeout, size_t *length) {
+  return td::json_receive_binary(timeout, length);
+}
+
+const char *td_receive_batch(int max_count, double timeout, size_t *length) {
+  return td::json_receive_batch(max_count, timeout, length);
+}
+
+void td_set_parallel_json_encoding(int is_enabled) {
+  td::json_set_parallel_encoding(is_enabled != 0);
+}
+
 const char *td_execute(const char *request) {
   return td::json_execute(td::Slice(request == nullptr ? "" : request));
 }
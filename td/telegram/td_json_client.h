@@ -50,6 +50,8 @@
 
 #include "td/telegram/tdjson_export.h"
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -62,7 +64,8 @@ extern "C" {
 TDJSON_EXPORT int td_create_client_id();
 
 /**
- * Sends request to the TDLib client. May be called from any thread.
+ * Sends request to the TDLib client. May be called from any thread. Responses to requests, which can be executed
+ * synchronously, can be received before responses to requests sent earlier.
  * \param[in] client_id TDLib client identifier.
  * \param[in] request JSON-serialized null-terminated request to TDLib.
  */
@@ -70,16 +73,65 @@ TDJSON_EXPORT void td_send(int client_id, const char *request);
 
 /**
  * Receives incoming updates and request responses. Must not be called simultaneously from two different threads.
- * The returned pointer can be used until the next call to td_receive or td_execute, after which it will be deallocated by TDLib.
+ * The returned pointer can be used until the next call to td_receive, td_receive_with_length, td_receive_batch or td_execute, after which it will be deallocated by TDLib.
  * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
  * \return JSON-serialized null-terminated incoming update or request response. May be NULL if the timeout expires.
  */
 TDJSON_EXPORT const char *td_receive(double timeout);
 
+/**
+ * Receives incoming updates and request responses along with their length. Must not be called simultaneously from two different threads.
+ * The returned string is built directly in a buffer owned by TDLib, which is reused by subsequent calls in the same thread.
+ * The returned pointer can be used until the next call to td_receive, td_receive_with_length, td_receive_batch or td_execute, after which it will be overwritten by TDLib.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] length Pointer to a variable, which will receive length of the returned string without the terminating null character. May be NULL.
+ * \return JSON-serialized null-terminated incoming update or request response. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_receive_with_length(double timeout, size_t *length);
+
+/**
+ * Receives all already available incoming updates and request responses, but no more than max_count of them.
+ * Waits for the first update or response at most timeout seconds. Must not be called simultaneously from two different threads.
+ * The returned pointer can be used until the next call to td_receive, td_receive_with_length, td_receive_batch or td_execute, after which it will be overwritten by TDLib.
+ * \param[in] max_count The maximum number of updates and responses to return.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] length Pointer to a variable, which will receive length of the returned string without the terminating null character. May be NULL.
+ * \return JSON-serialized null-terminated array of incoming updates and request responses in the order they were received. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_receive_batch(int max_count, double timeout, size_t *length);
+
+/**
+ * Receives incoming updates and request responses serialized in the TL binary format instead of JSON.
+ * Must not be called simultaneously from two different threads.
+ * The returned record consists of the identifier of the client as a 32-bit integer, the JSON-serialized value
+ * of the "@extra" field of the request as a TL string, which is empty for updates, and the boxed TL-serialized object,
+ * which starts with its constructor identifier as in the TDLib TL scheme. Fields of types int53 and int64 are
+ * serialized as 64-bit integers. Nested objects are always serialized with their constructor identifier,
+ * and null objects are serialized as the constructor identifier 0.
+ * The constructor identifier 0 is never used for the returned object itself. The object is serialized in the thread
+ * calling td_receive_binary even if parallel JSON encoding is enabled, so the encoding should be disabled
+ * if td_receive_binary is used.
+ * The returned pointer can be used until the next call to td_receive_binary, after which it will be overwritten by TDLib.
+ * \param[in] timeout The maximum number of seconds allowed for this function to wait for new data.
+ * \param[out] length Pointer to a variable, which will receive length of the returned record. May be NULL.
+ * \return TL-serialized incoming update or request response. May be NULL if the timeout expires.
+ */
+TDJSON_EXPORT const char *td_receive_binary(double timeout, size_t *length);
+
+/**
+ * Enables or disables serialization of incoming updates and request responses to JSON in TDLib threads instead of
+ * the thread calling td_receive. This allows to use multiple cores for JSON serialization if there are many
+ * TDLib client instances, but increases the time TDLib threads spend on each update.
+ * Affects only TDLib client instances to which the first request is sent after the call. By default, the serialization
+ * is done in the thread calling td_receive. Doesn't affect td_receive_binary, which ignores the JSON-serialized objects.
+ * \param[in] is_enabled Pass 1 to enable serialization in TDLib threads or 0 to disable it.
+ */
+TDJSON_EXPORT void td_set_parallel_json_encoding(int is_enabled);
+
 /**
  * Synchronously executes a TDLib request.
  * A request can be executed synchronously, only if it is documented with "Can be called synchronously".
- * The returned pointer can be used until the next call to td_receive or td_execute, after which it will be deallocated by TDLib.
+ * The returned pointer can be used until the next call to td_receive, td_receive_with_length, td_receive_batch or td_execute, after which it will be deallocated by TDLib.
  * \param[in] request JSON-serialized null-terminated request to TDLib.
  * \return JSON-serialized null-terminated request response.
  */
@@ -148,7 +200,8 @@ TDJSON_EXPORT void td_set_log_message_callback(int max_verbosity_level, td_log_m
 TDJSON_EXPORT void *td_json_client_create();
 
 /**
- * Sends request to the TDLib client. May be called from any thread.
+ * Sends request to the TDLib client. May be called from any thread. Responses to requests, which can be executed
+ * synchronously, can be received before responses to requests sent earlier.
  * \param[in] client The client.
  * \param[in] request JSON-serialized null-terminated request to TDLib.
  */
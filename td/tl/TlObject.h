@@ -13,6 +13,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -21,6 +22,8 @@ namespace td {
 
 class TlStorerCalcLength;
 
+class TlStorerGrowable;
+
 class TlStorerUnsafe;
 
 class TlStorerToString;
@@ -49,6 +52,16 @@ class TlObject {
   virtual void store(TlStorerCalcLength &s) const {
   }
 
+  /**
+   * Appends the object to the storer serializing object in a single pass, a buffer growing on demand.
+   * Only objects, which are sent to the server, can be stored this way; for others the call aborts the program,
+   * because an object silently skipped in a single pass would corrupt the serialized data.
+   * \param[in] s Storer to which the object will be appended.
+   */
+  virtual void store(TlStorerGrowable &s) const {
+    std::abort();
+  }
+
   /**
    * Helper function for the to_string method. Appends a string representation of the object to the storer.
    * \param[in] s Storer to which the object string representation will be appended.
@@ -13,6 +13,7 @@
 #include "td/utils/format.h"
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/misc.h"
+#include "td/utils/Parser.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
@@ -199,4 +200,191 @@ std::enable_if_t<std::is_constructible<T>::value, Status> from_json(tl_object_pt
   return from_json(*to, from.get_object());
 }
 
+// Direct conversion of JSON to TL objects without building of the intermediate JsonValue tree.
+// Strings are decoded in place as in json_decode, so the parsed slice is changed.
+// Objects, for which "@type" isn't the first field, and values of unexpected type are converted through JsonValue.
+
+template <class T>
+Status from_json_scalar(T &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json(to, std::move(value));
+}
+
+inline Status from_json(int32 &to, Parser &parser, int32 max_depth) {
+  return from_json_scalar(to, parser, max_depth);
+}
+
+inline Status from_json(bool &to, Parser &parser, int32 max_depth) {
+  return from_json_scalar(to, parser, max_depth);
+}
+
+inline Status from_json(int64 &to, Parser &parser, int32 max_depth) {
+  return from_json_scalar(to, parser, max_depth);
+}
+
+inline Status from_json(double &to, Parser &parser, int32 max_depth) {
+  return from_json_scalar(to, parser, max_depth);
+}
+
+inline Status from_json(string &to, Parser &parser, int32 max_depth) {
+  return from_json_scalar(to, parser, max_depth);
+}
+
+inline Status from_json_bytes(string &to, Parser &parser, int32 max_depth) {
+  TRY_RESULT(value, do_json_decode(parser, max_depth));
+  return from_json_bytes(to, std::move(value));
+}
+
+template <class T>
+Status from_json(std::vector<T> &to, Parser &parser, int32 max_depth) {
+  if (max_depth < 0) {
+    return Status::Error("Too big object depth");
+  }
+  parser.skip_whitespaces();
+  if (parser.peek_char() != '[') {
+    return from_json_scalar(to, parser, max_depth);
+  }
+
+  parser.skip('[');
+  parser.skip_whitespaces();
+  to.clear();
+  if (parser.try_skip(']')) {
+    return Status::OK();
+  }
+  while (true) {
+    if (parser.empty()) {
+      return Status::Error("Unexpected string end");
+    }
+    to.emplace_back();
+    TRY_STATUS(from_json(to.back(), parser, max_depth - 1));
+
+    parser.skip_whitespaces();
+    if (parser.try_skip(']')) {
+      return Status::OK();
+    }
+    if (parser.try_skip(',')) {
+      parser.skip_whitespaces();
+      continue;
+    }
+    if (parser.empty()) {
+      return Status::Error("Unexpected string end");
+    }
+    return Status::Error("Unexpected symbol while parsing JSON Array");
+  }
+}
+
+// parses remaining fields of a JSON object; the opening brace and need_comma fields must be already parsed
+template <class F>
+Status parse_json_object_fields(Parser &parser, bool need_comma, const F &parse_field) {
+  while (true) {
+    parser.skip_whitespaces();
+    if (parser.try_skip('}')) {
+      return Status::OK();
+    }
+    if (need_comma) {
+      if (!parser.try_skip(',')) {
+        if (parser.empty()) {
+          return Status::Error("Unexpected string end");
+        }
+        return Status::Error("Unexpected symbol while parsing JSON Object");
+      }
+      parser.skip_whitespaces();
+    }
+    need_comma = true;
+    if (parser.empty()) {
+      return Status::Error("Unexpected string end");
+    }
+    TRY_RESULT(field, json_string_decode(parser));
+    parser.skip_whitespaces();
+    if (!parser.try_skip(':')) {
+      return Status::Error("':' expected");
+    }
+    parser.skip_whitespaces();
+    TRY_STATUS(parse_field(Slice(field)));
+  }
+}
+
+// if extra isn't null, then raw value of the field "@extra" of the object will be stored in it,
+// and objects without "@type" as the first field aren't supported
+template <class T>
+Status parse_json_object_fields(T &to, Parser &parser, int32 max_depth, bool need_comma, Slice *extra) {
+  return parse_json_object_fields(parser, need_comma, [&](Slice name) {
+    if (extra != nullptr && name == Slice("@extra")) {
+      auto begin = parser.ptr();
+      TRY_STATUS(do_json_skip(parser, max_depth));
+      *extra = Slice(begin, parser.ptr());
+      return Status::OK();
+    }
+    return from_json_field(to, name, parser, max_depth);
+  });
+}
+
+template <class T>
+std::enable_if_t<!std::is_constructible<T>::value, Status> from_json(tl_object_ptr<T> &to, Parser &parser,
+                                                                     int32 max_depth, Slice *extra = nullptr) {
+  if (max_depth < 0) {
+    return Status::Error("Too big object depth");
+  }
+  parser.skip_whitespaces();
+  if (parser.peek_char() != '{') {
+    return from_json_scalar(to, parser, max_depth);
+  }
+
+  auto object_data = parser.data();
+  parser.skip('{');
+  parser.skip_whitespaces();
+  if (!parser.try_skip("\"@type\"")) {
+    if (extra != nullptr) {
+      return Status::Error("Expected \"@type\" as the first field");
+    }
+    // the type of the object is unknown until "@type" is found
+    parser = Parser(object_data);
+    return from_json_scalar(to, parser, max_depth);
+  }
+  parser.skip_whitespaces();
+  if (!parser.try_skip(':')) {
+    return Status::Error("':' expected");
+  }
+
+  TRY_RESULT(constructor_value, do_json_decode(parser, max_depth - 1));
+  int32 constructor = 0;
+  if (constructor_value.type() == JsonValue::Type::Number) {
+    constructor = to_integer<int32>(constructor_value.get_number());
+  } else if (constructor_value.type() == JsonValue::Type::String) {
+    TRY_RESULT_ASSIGN(constructor, tl_constructor_from_string(to.get(), constructor_value.get_string().str()));
+  } else {
+    return Status::Error(PSLICE() << "Expected String or Integer, but receive " << constructor_value.type());
+  }
+
+  TlDowncastHelper<T> helper(constructor);
+  Status status;
+  bool ok = downcast_call(static_cast<T &>(helper), [&](auto &dummy) {
+    auto result = make_tl_object<std::decay_t<decltype(dummy)>>();
+    status = parse_json_object_fields(*result, parser, max_depth - 1, true, extra);
+    to = std::move(result);
+  });
+  TRY_STATUS(std::move(status));
+  if (!ok) {
+    return Status::Error(PSLICE() << "Unknown constructor " << format::as_hex(constructor));
+  }
+
+  return Status::OK();
+}
+
+template <class T>
+std::enable_if_t<std::is_constructible<T>::value, Status> from_json(tl_object_ptr<T> &to, Parser &parser,
+                                                                    int32 max_depth, Slice *extra = nullptr) {
+  if (max_depth < 0) {
+    return Status::Error("Too big object depth");
+  }
+  parser.skip_whitespaces();
+  if (parser.peek_char() != '{') {
+    return from_json_scalar(to, parser, max_depth);
+  }
+
+  parser.skip('{');
+  to = make_tl_object<T>();
+  return parse_json_object_fields(*to, parser, max_depth - 1, false, extra);
+}
+
 }  // namespace td
@@ -36,6 +36,34 @@ class TlStoreBoxedUnknown {
   }
 };
 
+template <class Func, std::int32_t constructor_id>
+class TlStoreBoxedOptional {
+ public:
+  template <class T, class StorerT>
+  static void store(const T &x, StorerT &storer) {
+    if (x == nullptr) {
+      storer.store_binary(static_cast<std::int32_t>(0));
+      return;
+    }
+    storer.store_binary(constructor_id);
+    Func::store(x, storer);
+  }
+};
+
+template <class Func>
+class TlStoreBoxedUnknownOptional {
+ public:
+  template <class T, class StorerT>
+  static void store(const T &x, StorerT &storer) {
+    if (x == nullptr) {
+      storer.store_binary(static_cast<std::int32_t>(0));
+      return;
+    }
+    storer.store_binary(x->get_id());
+    Func::store(x, storer);
+  }
+};
+
 class TlStoreBool {
  public:
   template <class StorerT>
@@ -0,0 +1,146 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/actor/ActorStatistics.h"
+
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/logging.h"
+#include "td/utils/MemoryAttribution.h"
+#include "td/utils/misc.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace td {
+
+std::atomic<bool> ActorStatistics::is_enabled_{false};
+
+namespace {
+
+struct ActorStatisticsRegistry {
+  std::mutex mutex;
+  FlatHashMap<string, unique_ptr<ActorStatisticsEntry>> entries;
+  std::atomic<double> log_period{0.0};
+  std::atomic<double> next_log_time{0.0};
+};
+
+ActorStatisticsRegistry &get_registry() {
+  static ActorStatisticsRegistry registry;
+  return registry;
+}
+
+// actors of the same kind often differ only in a numeric suffix, for example, "ServiceActor3"
+Slice get_actor_kind(Slice actor_name) {
+  while (!actor_name.empty() && is_digit(actor_name.back())) {
+    actor_name.remove_suffix(1);
+  }
+  if (actor_name.empty()) {
+    return Slice("<unnamed>");
+  }
+  return actor_name;
+}
+
+}  // namespace
+
+void ActorStatistics::set_enabled(bool is_enabled, double log_period) {
+  auto &registry = get_registry();
+  if (!is_enabled || log_period < 0) {
+    log_period = 0.0;
+  }
+  registry.log_period.store(log_period, std::memory_order_relaxed);
+  registry.next_log_time.store(log_period > 0 ? Time::now() + log_period : 0.0, std::memory_order_relaxed);
+  is_enabled_.store(is_enabled, std::memory_order_relaxed);
+}
+
+ActorStatisticsEntry *ActorStatistics::get_entry(Slice actor_name) {
+  if (!is_enabled()) {
+    return nullptr;
+  }
+  auto kind = get_actor_kind(actor_name).str();
+  auto &registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto &entry = registry.entries[kind];
+  if (entry == nullptr) {
+    entry = td::make_unique<ActorStatisticsEntry>(std::move(kind));
+  }
+  return entry.get();
+}
+
+const char *ActorStatistics::get_memory_tag(Slice actor_name) {
+  if (!MemoryAttribution::is_enabled()) {
+    return nullptr;
+  }
+  return MemoryAttribution::get_tag(get_actor_kind(actor_name));
+}
+
+vector<ActorStatistics::Entry> ActorStatistics::get_statistics(bool reset) {
+  vector<Entry> result;
+  auto &registry = get_registry();
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto &it : registry.entries) {
+      auto &entry = *it.second;
+      Entry result_entry;
+      result_entry.name = entry.name_;
+      if (reset) {
+        result_entry.event_count = entry.event_count_.exchange(0, std::memory_order_relaxed);
+        result_entry.run_time = static_cast<double>(entry.run_time_ns_.exchange(0, std::memory_order_relaxed)) * 1e-9;
+        result_entry.queue_time =
+            static_cast<double>(entry.queue_time_ns_.exchange(0, std::memory_order_relaxed)) * 1e-9;
+        result_entry.max_mailbox_size = entry.max_mailbox_size_.exchange(0, std::memory_order_relaxed);
+      } else {
+        result_entry.event_count = entry.event_count_.load(std::memory_order_relaxed);
+        result_entry.run_time = static_cast<double>(entry.run_time_ns_.load(std::memory_order_relaxed)) * 1e-9;
+        result_entry.queue_time = static_cast<double>(entry.queue_time_ns_.load(std::memory_order_relaxed)) * 1e-9;
+        result_entry.max_mailbox_size = entry.max_mailbox_size_.load(std::memory_order_relaxed);
+      }
+      if (result_entry.event_count != 0) {
+        result.push_back(std::move(result_entry));
+      }
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const Entry &lhs, const Entry &rhs) {
+    if (lhs.run_time != rhs.run_time) {
+      return lhs.run_time > rhs.run_time;
+    }
+    return lhs.name < rhs.name;
+  });
+  return result;
+}
+
+void ActorStatistics::on_scheduler_run() {
+  if (!is_enabled()) {
+    return;
+  }
+  auto &registry = get_registry();
+  auto next_log_time = registry.next_log_time.load(std::memory_order_relaxed);
+  if (next_log_time == 0.0) {
+    return;
+  }
+  auto now = Time::now();
+  if (now < next_log_time) {
+    return;
+  }
+  auto new_next_log_time = now + registry.log_period.load(std::memory_order_relaxed);
+  if (!registry.next_log_time.compare_exchange_strong(next_log_time, new_next_log_time)) {
+    // other scheduler dumps the statistics
+    return;
+  }
+
+  auto statistics = get_statistics(false);
+  LOG(WARNING) << "Actor statistics for " << statistics.size() << " actor kinds:";
+  for (auto &entry : statistics) {
+    LOG(WARNING) << entry;
+  }
+}
+
+StringBuilder &operator<<(StringBuilder &string_builder, const ActorStatistics::Entry &entry) {
+  return string_builder << entry.name << ": " << entry.event_count << " events, run time " << entry.run_time
+                        << " s, queue time " << entry.queue_time << " s, max mailbox size " << entry.max_mailbox_size;
+}
+
+}  // namespace td
@@ -0,0 +1,91 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/StringBuilder.h"
+
+#include <atomic>
+#include <utility>
+
+namespace td {
+
+// statistics of all actors with the same name, updated concurrently by all schedulers
+class ActorStatisticsEntry {
+ public:
+  explicit ActorStatisticsEntry(string name) : name_(std::move(name)) {
+  }
+
+  void on_run(double run_time, double queue_time, uint64 event_count) {
+    event_count_.fetch_add(event_count, std::memory_order_relaxed);
+    run_time_ns_.fetch_add(to_ns(run_time), std::memory_order_relaxed);
+    queue_time_ns_.fetch_add(to_ns(queue_time), std::memory_order_relaxed);
+  }
+
+  void on_mailbox_size(size_t mailbox_size) {
+    auto size = static_cast<uint64>(mailbox_size);
+    auto old_size = max_mailbox_size_.load(std::memory_order_relaxed);
+    while (old_size < size && !max_mailbox_size_.compare_exchange_weak(old_size, size, std::memory_order_relaxed)) {
+    }
+  }
+
+  const string &get_name() const {
+    return name_;
+  }
+
+ private:
+  friend class ActorStatistics;
+
+  string name_;
+  std::atomic<uint64> event_count_{0};
+  std::atomic<uint64> run_time_ns_{0};
+  std::atomic<uint64> queue_time_ns_{0};
+  std::atomic<uint64> max_mailbox_size_{0};
+
+  static uint64 to_ns(double time) {
+    return time > 0 ? static_cast<uint64>(time * 1e9) : 0;
+  }
+};
+
+// process-wide per actor name CPU time and mailbox profiler
+// only actors created while the statistics are enabled are accounted
+class ActorStatistics {
+ public:
+  struct Entry {
+    string name;
+    uint64 event_count = 0;
+    double run_time = 0.0;
+    double queue_time = 0.0;
+    uint64 max_mailbox_size = 0;
+  };
+
+  static void set_enabled(bool is_enabled, double log_period = 0.0);
+
+  static bool is_enabled() {
+    return is_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // returns nullptr if the statistics are disabled
+  static ActorStatisticsEntry *get_entry(Slice actor_name);
+
+  // returns the tag, to which memory allocated by the actor is attributed, or nullptr if the attribution is disabled
+  static const char *get_memory_tag(Slice actor_name);
+
+  // the entries are sorted by decreasing run time
+  static vector<Entry> get_statistics(bool reset);
+
+  // is called periodically by all schedulers to dump the statistics to the log
+  static void on_scheduler_run();
+
+ private:
+  static std::atomic<bool> is_enabled_;
+};
+
+StringBuilder &operator<<(StringBuilder &string_builder, const ActorStatistics::Entry &entry);
+
+}  // namespace td
@@ -6,10 +6,15 @@
 //
 #include "td/actor/ConcurrentScheduler.h"
 
+#include "td/utils/algorithm.h"
 #include "td/utils/ExitGuard.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/SliceBuilder.h"
 
 #include <memory>
 
@@ -70,6 +75,169 @@ void ConcurrentScheduler::test_one_thread_run() {
   } while (!is_finished_.load(std::memory_order_relaxed));
 }
 
+void ConcurrentScheduler::enable_work_stealing() {
+  CHECK(state_ == State::Start);
+  if (work_stealing_ != nullptr) {
+    return;
+  }
+  // the extra scheduler isn't known to other schedulers, so it can't participate
+  auto scheduler_count = static_cast<int32>(schedulers_.size()) - extra_scheduler_;
+  if (scheduler_count <= 1) {
+    return;
+  }
+  work_stealing_ = std::make_shared<Scheduler::WorkStealingState>(scheduler_count);
+  for (int32 i = 0; i < scheduler_count; i++) {
+    schedulers_[i]->enable_work_stealing(work_stealing_);
+  }
+}
+
+Scheduler::WorkStealingStatistics ConcurrentScheduler::get_work_stealing_statistics() const {
+  if (work_stealing_ == nullptr) {
+    return {};
+  }
+  return work_stealing_->get_statistics();
+}
+
+void ConcurrentScheduler::set_batch_outbound_events(bool batch_outbound_events) {
+  CHECK(state_ == State::Start);
+  for (auto &scheduler : schedulers_) {
+    scheduler->set_batch_outbound_events(batch_outbound_events);
+  }
+}
+
+void ConcurrentScheduler::set_event_time_budget(double event_time_budget) {
+  CHECK(state_ == State::Start);
+  for (auto &scheduler : schedulers_) {
+    scheduler->set_event_time_budget(event_time_budget);
+  }
+}
+
+void ConcurrentScheduler::set_thread_placement(ThreadPlacement placement, int32 first_slot) {
+  CHECK(state_ == State::Start);
+  CHECK(first_slot >= 0);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  thread_placement_ = placement;
+  first_thread_placement_slot_ = first_slot;
+#endif
+}
+
+void ConcurrentScheduler::set_thread_cpus(vector<int32> cpus) {
+  CHECK(state_ == State::Start);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  for (auto cpu : cpus) {
+    if (cpu < 0 || cpu >= 64) {
+      LOG(ERROR) << "Ignore thread CPU list with invalid CPU " << cpu;
+      return;
+    }
+  }
+  thread_cpus_ = std::move(cpus);
+#endif
+}
+
+void ConcurrentScheduler::set_low_priority_scheduler(int32 sched_id) {
+  CHECK(state_ == State::Start);
+  CHECK(0 <= sched_id && sched_id < static_cast<int32>(schedulers_.size()));
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  is_low_priority_scheduler_.resize(schedulers_.size());
+  is_low_priority_scheduler_[sched_id] = true;
+#endif
+}
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+vector<vector<int32>> ConcurrentScheduler::get_numa_node_cpus() {
+  vector<vector<int32>> result;
+  uint64 allowed_cpu_mask = 0;
+#if TD_HAVE_THREAD_AFFINITY
+  allowed_cpu_mask = thread::get_affinity_mask(this_thread::get_id());
+#endif
+  auto is_allowed_cpu = [allowed_cpu_mask](int32 cpu) {
+    return allowed_cpu_mask == 0 || (allowed_cpu_mask & (static_cast<uint64>(1) << cpu)) != 0;
+  };
+#if TD_LINUX
+  for (int32 node = 0;; node++) {
+    auto r_cpu_list = read_file_str(PSLICE() << "/sys/devices/system/node/node" << node << "/cpulist");
+    if (r_cpu_list.is_error()) {
+      break;
+    }
+    vector<int32> cpus;
+    for (auto cpu_range : full_split(trim(Slice(r_cpu_list.ok())), ',')) {
+      if (cpu_range.empty()) {
+        continue;
+      }
+      auto range = split(cpu_range, '-');
+      auto begin_cpu = to_integer<int32>(range.first);
+      auto end_cpu = range.second.empty() ? begin_cpu : to_integer<int32>(range.second);
+      for (auto cpu = begin_cpu; cpu <= end_cpu && cpu < 64; cpu++) {
+        if (is_allowed_cpu(cpu)) {
+          cpus.push_back(cpu);
+        }
+      }
+    }
+    if (!cpus.empty()) {
+      result.push_back(std::move(cpus));
+    }
+  }
+#endif
+  if (result.empty()) {
+    vector<int32> cpus;
+    auto cpu_count = static_cast<int32>(min(thread::hardware_concurrency(), 64u));
+    for (int32 cpu = 0; cpu < cpu_count; cpu++) {
+      if (is_allowed_cpu(cpu)) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (cpus.empty()) {
+      cpus.push_back(0);
+    }
+    result.push_back(std::move(cpus));
+  }
+  return result;
+}
+
+vector<uint64> ConcurrentScheduler::get_thread_placement_masks(ThreadPlacement placement, int32 first_slot,
+                                                                size_t thread_count,
+                                                                const vector<vector<int32>> &numa_node_cpus) {
+  vector<uint64> result(thread_count, 0);
+  if (placement == ThreadPlacement::None || numa_node_cpus.empty()) {
+    return result;
+  }
+
+  vector<int32> all_cpus;
+  for (auto &cpus : numa_node_cpus) {
+    append(all_cpus, cpus);
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    auto slot = static_cast<size_t>(first_slot) + i;
+    uint64 mask = 0;
+    if (placement == ThreadPlacement::Compact) {
+      mask = static_cast<uint64>(1) << all_cpus[slot % all_cpus.size()];
+    } else {
+      for (auto cpu : numa_node_cpus[slot % numa_node_cpus.size()]) {
+        mask |= static_cast<uint64>(1) << cpu;
+      }
+    }
+    result[i] = mask;
+  }
+  return result;
+}
+
+vector<uint64> ConcurrentScheduler::get_thread_affinity_masks() const {
+  auto thread_count = schedulers_.size() - 1 - extra_scheduler_;
+  vector<uint64> result(thread_count, thread_affinity_mask_);
+  if (!thread_cpus_.empty()) {
+    for (size_t i = 0; i < thread_count && i < thread_cpus_.size(); i++) {
+      result[i] = static_cast<uint64>(1) << thread_cpus_[i];
+    }
+    return result;
+  }
+  if (thread_placement_ == ThreadPlacement::None) {
+    return result;
+  }
+  return get_thread_placement_masks(thread_placement_, first_thread_placement_slot_, thread_count,
+                                    get_numa_node_cpus());
+}
+#endif
+
 #if !TD_THREAD_UNSUPPORTED
 thread::id ConcurrentScheduler::get_scheduler_thread_id(int32 sched_id) {
   auto thread_pos = static_cast<size_t>(sched_id - 1);
@@ -82,9 +250,12 @@ void ConcurrentScheduler::start() {
   CHECK(state_ == State::Start);
   is_finished_.store(false, std::memory_order_relaxed);
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  auto thread_affinity_masks = get_thread_affinity_masks();
+  is_low_priority_scheduler_.resize(schedulers_.size());
   for (size_t i = 1; i + extra_scheduler_ < schedulers_.size(); i++) {
     auto &sched = schedulers_[i];
-    threads_.push_back(td::thread([&, thread_affinity_mask = thread_affinity_mask_] {
+    threads_.push_back(td::thread([&, thread_affinity_mask = thread_affinity_masks[i - 1],
+                                   is_low_priority = static_cast<bool>(is_low_priority_scheduler_[i])] {
 #if TD_PORT_WINDOWS
       detail::Iocp::Guard iocp_guard(iocp_.get());
 #endif
@@ -94,6 +265,13 @@ void ConcurrentScheduler::start() {
       }
 #else
       (void)thread_affinity_mask;
+#endif
+#if TD_HAVE_THREAD_CPU_PRIORITY
+      if (is_low_priority) {
+        thread::set_low_cpu_priority().ignore();
+      }
+#else
+      (void)is_low_priority;
 #endif
       while (!is_finished()) {
         sched->run(Timestamp::in(10));
@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <utility>
 
@@ -46,6 +47,46 @@ class ConcurrentScheduler final : private Scheduler::Callback {
 
   void test_one_thread_run();
 
+  // lets idle schedulers take over ready stealable actors from busy schedulers
+  // must be called before start()
+  void enable_work_stealing();
+
+  Scheduler::WorkStealingStatistics get_work_stealing_statistics() const;
+
+  // events sent to other schedulers are batched by default; must be called before start()
+  void set_batch_outbound_events(bool batch_outbound_events);
+
+  // see Scheduler::set_event_time_budget; must be called before start()
+  void set_event_time_budget(double event_time_budget);
+
+  enum class ThreadPlacement : int32 {
+    None,     // threads aren't pinned beyond the thread affinity mask
+    Compact,  // each thread is pinned to a separate CPU, filling NUMA nodes one by one
+    Spread    // threads are pinned to NUMA nodes in a round-robin fashion and can use any CPU of their node
+  };
+
+  // pins additional scheduler threads to CPUs; memory allocated by the threads is then local to their NUMA node
+  // the threads occupy placement slots starting from first_slot, so that several schedulers can share the CPUs
+  // must be called before start()
+  void set_thread_placement(ThreadPlacement placement, int32 first_slot = 0);
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+  // returns CPUs of each NUMA node, which are allowed for the current thread;
+  // CPUs, which can't be specified in an affinity mask, are skipped
+  static vector<vector<int32>> get_numa_node_cpus();
+
+  // returns affinity masks of thread_count threads placed starting from first_slot; zero masks for None
+  static vector<uint64> get_thread_placement_masks(ThreadPlacement placement, int32 first_slot, size_t thread_count,
+                                                   const vector<vector<int32>> &numa_node_cpus);
+#endif
+
+  // pins the thread of the i-th additional scheduler to the CPU cpus[i]; overrides set_thread_placement
+  // must be called before start()
+  void set_thread_cpus(vector<int32> cpus);
+
+  // runs the thread of the scheduler with a lower OS priority; must be called before start()
+  void set_low_priority_scheduler(int32 sched_id);
+
   bool is_finished() const {
     return is_finished_.load(std::memory_order_relaxed);
   }
@@ -98,9 +139,16 @@ class ConcurrentScheduler final : private Scheduler::Callback {
   vector<std::function<void()>> at_finish_;  // can be used during destruction by Scheduler destructors
   vector<unique_ptr<Scheduler>> schedulers_;
   std::atomic<bool> is_finished_{false};
+  std::shared_ptr<Scheduler::WorkStealingState> work_stealing_;
 #if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
   vector<td::thread> threads_;
   uint64 thread_affinity_mask_ = 0;
+  ThreadPlacement thread_placement_ = ThreadPlacement::None;
+  int32 first_thread_placement_slot_ = 0;
+  vector<int32> thread_cpus_;
+  vector<bool> is_low_priority_scheduler_;
+
+  vector<uint64> get_thread_affinity_masks() const;
 #endif
 #if TD_PORT_WINDOWS
   unique_ptr<detail::Iocp> iocp_;
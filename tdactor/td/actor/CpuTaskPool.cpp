@@ -0,0 +1,57 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/actor/CpuTaskPool.h"
+
+#include "td/utils/logging.h"
+
+namespace td {
+
+CpuTaskPool::CpuTaskPool(vector<int32> sched_ids) : state_(std::make_shared<State>()) {
+  CHECK(!sched_ids.empty());
+  state_->active_task_counts_ = vector<std::atomic<int64>>(sched_ids.size());
+  for (auto &count : state_->active_task_counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  state_->sched_ids_ = std::move(sched_ids);
+}
+
+size_t CpuTaskPool::State::acquire() {
+  size_t best_index = 0;
+  auto best_count = active_task_counts_[0].load(std::memory_order_relaxed);
+  for (size_t i = 1; i < sched_ids_.size() && best_count > 0; i++) {
+    auto count = active_task_counts_[i].load(std::memory_order_relaxed);
+    if (count < best_count) {
+      best_index = i;
+      best_count = count;
+    }
+  }
+  active_task_counts_[best_index].fetch_add(1, std::memory_order_relaxed);
+  started_task_count_.fetch_add(1, std::memory_order_relaxed);
+  return best_index;
+}
+
+void CpuTaskPool::State::release(size_t index, double run_time) {
+  active_task_counts_[index].fetch_sub(1, std::memory_order_relaxed);
+  finished_task_count_.fetch_add(1, std::memory_order_relaxed);
+  auto run_time_us = static_cast<int64>(run_time * 1e6);
+  total_run_time_us_.fetch_add(run_time_us, std::memory_order_relaxed);
+  auto max_run_time_us = max_run_time_us_.load(std::memory_order_relaxed);
+  while (run_time_us > max_run_time_us &&
+         !max_run_time_us_.compare_exchange_weak(max_run_time_us, run_time_us, std::memory_order_relaxed)) {
+  }
+}
+
+CpuTaskPool::Statistics CpuTaskPool::get_statistics() const {
+  Statistics result;
+  result.started_task_count = state_->started_task_count_.load(std::memory_order_relaxed);
+  result.finished_task_count = state_->finished_task_count_.load(std::memory_order_relaxed);
+  result.total_run_time = static_cast<double>(state_->total_run_time_us_.load(std::memory_order_relaxed)) * 1e-6;
+  result.max_run_time = static_cast<double>(state_->max_run_time_us_.load(std::memory_order_relaxed)) * 1e-6;
+  return result;
+}
+
+}  // namespace td
@@ -0,0 +1,77 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/actor/actor.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+#include "td/utils/Status.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace td {
+
+// runs pure CPU-bound computations on a set of schedulers and returns their results to the calling scheduler
+class CpuTaskPool {
+ public:
+  struct Statistics {
+    uint64 started_task_count = 0;
+    uint64 finished_task_count = 0;
+    double total_run_time = 0.0;  // seconds
+    double max_run_time = 0.0;    // seconds
+  };
+
+  explicit CpuTaskPool(vector<int32> sched_ids);
+
+  // func is executed on the least loaded scheduler of the pool, the promise is completed on the calling scheduler;
+  // func must not access state of the calling actor and must return either T or Result<T>
+  template <class FunctionT, class T>
+  void run(FunctionT &&func, Promise<T> promise) {
+    auto state = state_;
+    auto index = state->acquire();
+    auto sched_id = state->sched_ids_[index];
+    auto caller_sched_id = Scheduler::instance()->sched_id();
+    Scheduler::instance()->run_on_scheduler(
+        sched_id,
+        PromiseCreator::lambda([state = std::move(state), index, caller_sched_id, func = std::forward<FunctionT>(func),
+                                promise = std::move(promise)](Unit) mutable {
+          auto start_time = Time::now();
+          Result<T> result = func();
+          state->release(index, Time::now() - start_time);
+          Scheduler::instance()->run_on_scheduler(
+              caller_sched_id,
+              PromiseCreator::lambda([result = std::move(result), promise = std::move(promise)](Unit) mutable {
+                promise.set_result(std::move(result));
+              }));
+        }));
+  }
+
+  Statistics get_statistics() const;
+
+ private:
+  struct State {
+    vector<int32> sched_ids_;
+    vector<std::atomic<int64>> active_task_counts_;
+    std::atomic<uint64> started_task_count_{0};
+    std::atomic<uint64> finished_task_count_{0};
+    std::atomic<int64> total_run_time_us_{0};
+    std::atomic<int64> max_run_time_us_{0};
+
+    size_t acquire();
+
+    void release(size_t index, double run_time);
+  };
+
+  // shared with the running tasks, so the pool can be destroyed before they finish
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace td
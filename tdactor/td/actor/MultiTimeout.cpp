@@ -11,64 +11,64 @@
 namespace td {
 
 bool MultiTimeout::has_timeout(int64 key) const {
-  return items_.count(Item(key)) > 0;
+  return items_.count(key) > 0;
 }
 
 void MultiTimeout::set_timeout_at(int64 key, double timeout) {
   LOG(DEBUG) << "Set " << get_name() << " for " << key << " in " << timeout - Time::now();
-  auto item = items_.emplace(key);
-  auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
-  if (heap_node->in_heap()) {
-    CHECK(!item.second);
-    bool need_update_timeout = heap_node->is_top();
-    timeout_queue_.fix(timeout, heap_node);
-    if (need_update_timeout || heap_node->is_top()) {
-      update_timeout("set_timeout");
-    }
+  auto it = items_.emplace(key, key);
+  auto *item = &it.first->second;
+  if (item->in_timer_wheel()) {
+    CHECK(!it.second);
+    timeout_wheel_.erase(item);
   } else {
-    CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("set_timeout 2");
-    }
+    CHECK(it.second);
   }
+  insert_timeout(timeout, item, "set_timeout");
 }
 
 void MultiTimeout::add_timeout_at(int64 key, double timeout) {
   LOG(DEBUG) << "Add " << get_name() << " for " << key << " in " << timeout - Time::now();
-  auto item = items_.emplace(key);
-  auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item.first));
-  if (heap_node->in_heap()) {
-    CHECK(!item.second);
+  auto it = items_.emplace(key, key);
+  auto *item = &it.first->second;
+  if (item->in_timer_wheel()) {
+    CHECK(!it.second);
   } else {
-    CHECK(item.second);
-    timeout_queue_.insert(timeout, heap_node);
-    if (heap_node->is_top()) {
-      update_timeout("add_timeout");
-    }
+    CHECK(it.second);
+    insert_timeout(timeout, item, "add_timeout");
   }
 }
 
 void MultiTimeout::cancel_timeout(int64 key, const char *source) {
   LOG(DEBUG) << "Cancel " << get_name() << " for " << key;
-  auto item = items_.find(Item(key));
-  if (item != items_.end()) {
-    auto heap_node = static_cast<HeapNode *>(const_cast<Item *>(&*item));
-    CHECK(heap_node->in_heap());
-    bool need_update_timeout = heap_node->is_top();
-    timeout_queue_.erase(heap_node);
-    items_.erase(item);
+  auto it = items_.find(key);
+  if (it != items_.end()) {
+    CHECK(it->second.in_timer_wheel());
+    timeout_wheel_.erase(&it->second);
+    items_.erase(it);
 
-    if (need_update_timeout) {
+    // the actor timeout is left as is if there are other timeouts; an early wakeup just reschedules it
+    if (items_.empty()) {
       update_timeout(source);
     }
   }
 }
 
+void MultiTimeout::insert_timeout(double timeout, Item *item, const char *source) {
+  if (timeout_wheel_.empty()) {
+    timeout_wheel_.set_current_time(Time::now_cached());
+  }
+  timeout_wheel_.insert(timeout, item);
+  if (wakeup_at_ == 0.0 || timeout_wheel_.get_next_event_time() < wakeup_at_) {
+    update_timeout(source);
+  }
+}
+
 void MultiTimeout::update_timeout(const char *source) {
   if (items_.empty()) {
     LOG(DEBUG) << "Cancel timeout of " << get_name();
-    LOG_CHECK(timeout_queue_.empty()) << get_name() << ' ' << source;
+    LOG_CHECK(timeout_wheel_.empty()) << get_name() << ' ' << source;
+    wakeup_at_ = 0.0;
     if (!Actor::has_timeout()) {
       bool has_pending_timeout = false;
       for (auto &event : get_info()->mailbox_) {
@@ -81,22 +81,25 @@ void MultiTimeout::update_timeout(const char *source) {
       Actor::cancel_timeout();
     }
   } else {
-    LOG(DEBUG) << "Set timeout of " << get_name() << " in " << timeout_queue_.top_key() - Time::now_cached();
-    Actor::set_timeout_at(timeout_queue_.top_key());
+    wakeup_at_ = timeout_wheel_.get_next_event_time();
+    LOG(DEBUG) << "Set timeout of " << get_name() << " in " << wakeup_at_ - Time::now_cached();
+    Actor::set_timeout_at(wakeup_at_);
   }
 }
 
 vector<int64> MultiTimeout::get_expired_keys(double now) {
   vector<int64> expired_keys;
-  while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
-    int64 key = static_cast<Item *>(timeout_queue_.pop())->key;
-    items_.erase(Item(key));
-    expired_keys.push_back(key);
+  timeout_wheel_.run_expired(now, [&expired_keys](TimerWheelNode *node) {
+    expired_keys.push_back(static_cast<Item *>(node)->key);
+  });
+  for (auto key : expired_keys) {
+    items_.erase(key);
   }
   return expired_keys;
 }
 
 void MultiTimeout::timeout_expired() {
+  wakeup_at_ = 0.0;
   vector<int64> expired_keys = get_expired_keys(Time::now_cached());
   if (!items_.empty()) {
     update_timeout("timeout_expired");
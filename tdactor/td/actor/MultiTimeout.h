@@ -9,25 +9,21 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
-#include "td/utils/Heap.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
 
-#include <set>
+#include <unordered_map>
 
 namespace td {
 
-// TODO optimize
+// timeouts are stored in a timer wheel, so they expire with a precision of 1 millisecond
 class MultiTimeout final : public Actor {
-  struct Item final : public HeapNode {
+  struct Item final : public TimerWheelNode {
     int64 key;
 
     explicit Item(int64 key) : key(key) {
     }
-
-    bool operator<(const Item &other) const {
-      return key < other.key;
-    }
   };
 
  public:
@@ -68,8 +64,11 @@ class MultiTimeout final : public Actor {
   Callback callback_;
   Data data_;
 
-  KHeap<double> timeout_queue_;
-  std::set<Item> items_;
+  TimerWheel timeout_wheel_;
+  std::unordered_map<int64, Item> items_;
+  double wakeup_at_ = 0.0;  // time of the actor timeout or 0 if it isn't set
+
+  void insert_timeout(double timeout, Item *item, const char *source);
 
   void update_timeout(const char *source);
 
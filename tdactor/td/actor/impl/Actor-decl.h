@@ -75,6 +75,13 @@ class Actor : public ObserverBase {
   void migrate(int32 sched_id);
   void do_migrate(int32 sched_id);
 
+  // long loops can check this to continue the work in a later event and let other actors run
+  bool is_event_time_budget_exceeded() const;
+
+  // allows an idle scheduler to take the actor over, when work stealing is enabled
+  // the actor must not be subscribed to file descriptors and must not rely on its timeout surviving the migration
+  void set_stealable(bool is_stealable);
+
   uint64 get_link_token();
   std::weak_ptr<ActorContext> get_context_weak_ptr() const;
   std::shared_ptr<ActorContext> set_context(std::shared_ptr<ActorContext> context);
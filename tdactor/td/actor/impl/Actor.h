@@ -51,6 +51,9 @@ inline void Actor::do_stop() {
   Scheduler::instance()->do_stop_actor(this);
   CHECK(empty());
 }
+inline bool Actor::is_event_time_budget_exceeded() const {
+  return Scheduler::instance()->is_event_time_budget_exceeded();
+}
 inline bool Actor::has_timeout() const {
   return get_info()->get_heap_node()->in_heap();
 }
@@ -72,6 +75,9 @@ inline void Actor::migrate(int32 sched_id) {
 inline void Actor::do_migrate(int32 sched_id) {
   Scheduler::instance()->do_migrate_actor(this, sched_id);
 }
+inline void Actor::set_stealable(bool is_stealable) {
+  info_->set_stealable(is_stealable);
+}
 
 template <class ActorType>
 std::enable_if_t<std::is_base_of<Actor, ActorType>::value> start_migrate(ActorType &obj, int32 sched_id) {
@@ -23,6 +23,7 @@
 namespace td {
 
 class Actor;
+class ActorStatisticsEntry;
 
 class ActorContext {
  public:
@@ -108,15 +109,28 @@ class ActorInfo final
   bool need_context() const;
   bool need_start_up() const;
 
+  void set_stealable(bool is_stealable);
+  bool is_stealable() const;
+
+  ActorStatisticsEntry *get_statistics() const;
+  const char *get_memory_tag() const;
+  void on_ready(double now);
+  double extract_ready_time();
+
  private:
   Deleter deleter_ = Deleter::None;
   bool need_context_ = true;
   bool need_start_up_ = true;
   bool is_running_ = false;
+  bool is_stealable_ = false;
 
   std::atomic<int32> sched_id_{0};
   Actor *actor_ = nullptr;
 
+  ActorStatisticsEntry *statistics_ = nullptr;
+  const char *memory_tag_ = nullptr;
+  double ready_time_ = 0.0;
+
 #ifdef TD_DEBUG
   string name_;
 #endif
@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/impl/Actor-decl.h"
 #include "td/actor/impl/ActorInfo-decl.h"
 #include "td/actor/impl/Scheduler-decl.h"
@@ -44,12 +45,16 @@ inline void ActorInfo::init(int32 sched_id, Slice name, ObjectPool<ActorInfo>::O
 #ifdef TD_DEBUG
   name_.assign(name.data(), name.size());
 #endif
+  statistics_ = ActorStatistics::get_entry(name);
+  memory_tag_ = ActorStatistics::get_memory_tag(name);
+  ready_time_ = 0.0;
 
   actor_->set_info(std::move(this_ptr));
   deleter_ = deleter;
   need_context_ = need_context;
   need_start_up_ = need_start_up;
   is_running_ = false;
+  is_stealable_ = false;
 }
 
 inline bool ActorInfo::need_context() const {
@@ -60,6 +65,34 @@ inline bool ActorInfo::need_start_up() const {
   return need_start_up_;
 }
 
+inline void ActorInfo::set_stealable(bool is_stealable) {
+  is_stealable_ = is_stealable;
+}
+
+inline bool ActorInfo::is_stealable() const {
+  return is_stealable_;
+}
+
+inline ActorStatisticsEntry *ActorInfo::get_statistics() const {
+  return statistics_;
+}
+
+inline const char *ActorInfo::get_memory_tag() const {
+  return memory_tag_;
+}
+
+inline void ActorInfo::on_ready(double now) {
+  if (ready_time_ == 0.0) {
+    ready_time_ = now;
+  }
+}
+
+inline double ActorInfo::extract_ready_time() {
+  auto result = ready_time_;
+  ready_time_ = 0.0;
+  return result;
+}
+
 inline void ActorInfo::on_actor_moved(Actor *actor_new_ptr) {
   actor_ = actor_new_ptr;
 }
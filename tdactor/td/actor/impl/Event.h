@@ -6,6 +6,8 @@
 //
 #pragma once
 
+#include "td/actor/impl/EventPool.h"
+
 #include "td/utils/Closure.h"
 #include "td/utils/common.h"
 #include "td/utils/StringBuilder.h"
@@ -47,6 +49,15 @@ class CustomEvent {
   CustomEvent &operator=(CustomEvent &&) = delete;
   virtual ~CustomEvent() = default;
 
+#if TD_ACTOR_EVENT_POOL
+  static void *operator new(size_t size) {
+    return EventPool::allocate(size);
+  }
+  static void operator delete(void *ptr, size_t size) {
+    EventPool::deallocate(ptr, size);
+  }
+#endif
+
   virtual void run(Actor *actor) = 0;
   virtual void start_migrate(int32 sched_id) {
   }
@@ -221,9 +232,9 @@ class Event {
   }
 };
 
-inline StringBuilder &operator<<(StringBuilder &string_builder, const Event &e) {
+inline StringBuilder &operator<<(StringBuilder &string_builder, Event::Type type) {
   string_builder << "Event::";
-  switch (e.type) {
+  switch (type) {
     case Event::Type::Start:
       return string_builder << "Start";
     case Event::Type::Stop:
@@ -244,4 +255,8 @@ inline StringBuilder &operator<<(StringBuilder &string_builder, const Event &e)
   }
 }
 
+inline StringBuilder &operator<<(StringBuilder &string_builder, const Event &e) {
+  return string_builder << e.type;
+}
+
 }  // namespace td
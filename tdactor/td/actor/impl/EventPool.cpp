@@ -0,0 +1,112 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/actor/impl/EventPool.h"
+
+#include "td/utils/port/thread_local.h"
+
+#include <new>
+
+namespace td {
+
+namespace {
+
+struct FreeChunk {
+  FreeChunk *next;
+};
+
+class EventPoolFreeLists {
+ public:
+  EventPoolFreeLists() = default;
+  EventPoolFreeLists(const EventPoolFreeLists &) = delete;
+  EventPoolFreeLists &operator=(const EventPoolFreeLists &) = delete;
+  EventPoolFreeLists(EventPoolFreeLists &&) = delete;
+  EventPoolFreeLists &operator=(EventPoolFreeLists &&) = delete;
+  ~EventPoolFreeLists() {
+    for (auto head : free_chunks_) {
+      while (head != nullptr) {
+        auto next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+    }
+  }
+
+  void *pop(size_t size_class) {
+    auto head = free_chunks_[size_class];
+    if (head == nullptr) {
+      return nullptr;
+    }
+    free_chunks_[size_class] = head->next;
+    free_chunk_count_[size_class]--;
+    return head;
+  }
+
+  bool push(size_t size_class, void *ptr) {
+    if (free_chunk_count_[size_class] >= EventPool::MAX_FREE_CHUNK_COUNT) {
+      return false;
+    }
+    auto chunk = static_cast<FreeChunk *>(ptr);
+    chunk->next = free_chunks_[size_class];
+    free_chunks_[size_class] = chunk;
+    free_chunk_count_[size_class]++;
+    return true;
+  }
+
+  size_t get_free_chunk_count() const {
+    size_t result = 0;
+    for (auto count : free_chunk_count_) {
+      result += count;
+    }
+    return result;
+  }
+
+ private:
+  FreeChunk *free_chunks_[EventPool::SIZE_CLASS_COUNT] = {};
+  size_t free_chunk_count_[EventPool::SIZE_CLASS_COUNT] = {};
+};
+
+TD_THREAD_LOCAL EventPoolFreeLists *free_lists;  // static zero-initialized
+
+size_t get_size_class(size_t size) {
+  return (size + EventPool::SIZE_CLASS_STEP - 1) / EventPool::SIZE_CLASS_STEP - 1;
+}
+
+}  // namespace
+
+void *EventPool::allocate(size_t size) {
+  auto size_class = get_size_class(size);
+  if (size == 0 || size_class >= SIZE_CLASS_COUNT) {
+    return ::operator new(size);
+  }
+  init_thread_local<EventPoolFreeLists>(free_lists);
+  auto ptr = free_lists->pop(size_class);
+  if (ptr != nullptr) {
+    return ptr;
+  }
+  return ::operator new((size_class + 1) * SIZE_CLASS_STEP);
+}
+
+void EventPool::deallocate(void *ptr, size_t size) noexcept {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto size_class = get_size_class(size);
+  // the free lists can be already destroyed during thread exit
+  if (size != 0 && size_class < SIZE_CLASS_COUNT && free_lists != nullptr && free_lists->push(size_class, ptr)) {
+    return;
+  }
+  ::operator delete(ptr);
+}
+
+size_t EventPool::get_free_chunk_count() {
+  if (free_lists == nullptr) {
+    return 0;
+  }
+  return free_lists->get_free_chunk_count();
+}
+
+}  // namespace td
@@ -0,0 +1,35 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+
+#ifndef TD_ACTOR_EVENT_POOL
+#define TD_ACTOR_EVENT_POOL 1
+#endif
+
+namespace td {
+
+// Thread-local cache of memory chunks for small custom events
+//
+// Events are often destroyed by another scheduler, so a chunk is returned to the free list of the thread,
+// which destroys the event. Free lists have bounded size, so memory can't accumulate in consumer threads.
+class EventPool {
+ public:
+  static constexpr size_t SIZE_CLASS_STEP = 32;
+  static constexpr size_t SIZE_CLASS_COUNT = 8;
+  static constexpr size_t MAX_FREE_CHUNK_COUNT = 1024;
+
+  static void *allocate(size_t size);
+
+  static void deallocate(void *ptr, size_t size) noexcept;
+
+  // returns number of chunks in free lists of the current thread
+  static size_t get_free_chunk_count();
+};
+
+}  // namespace td
@@ -28,6 +28,7 @@
 #include "td/utils/Time.h"
 #include "td/utils/type_traits.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <type_traits>
@@ -69,6 +70,34 @@ class Scheduler {
     virtual void on_finish() = 0;
     virtual void register_at_finish(std::function<void()>) = 0;
   };
+
+  struct WorkStealingStatistics {
+    uint64 steal_request_count = 0;
+    uint64 stolen_actor_count = 0;
+    uint64 failed_steal_count = 0;
+    double steal_time = 0.0;  // total time spent by the busy schedulers to hand over the stolen actors
+  };
+
+  // state shared between all schedulers participating in work stealing
+  class WorkStealingState {
+   public:
+    explicit WorkStealingState(int32 scheduler_count);
+
+    WorkStealingStatistics get_statistics() const;
+
+   private:
+    friend class Scheduler;
+
+    vector<std::atomic<int32>> ready_actor_count_;
+    vector<std::atomic<int32>> steal_request_;  // identifier of the stealing scheduler plus one
+    vector<std::atomic<bool>> is_stealing_;
+    vector<std::atomic<bool>> is_idle_;
+    std::atomic<uint64> steal_request_count_{0};
+    std::atomic<uint64> stolen_actor_count_{0};
+    std::atomic<uint64> failed_steal_count_{0};
+    std::atomic<uint64> steal_time_ns_{0};
+  };
+
   Scheduler() = default;
   Scheduler(const Scheduler &) = delete;
   Scheduler &operator=(const Scheduler &) = delete;
@@ -81,6 +110,19 @@ class Scheduler {
   int32 sched_id() const;
   int32 sched_count() const;
 
+  // must be called before the scheduler is run
+  void enable_work_stealing(std::shared_ptr<WorkStealingState> state);
+
+  // events sent to other schedulers while the scheduler runs are published once per mailbox round
+  void set_batch_outbound_events(bool batch_outbound_events);
+
+  // events running longer than the budget in seconds are logged, and the rest of the actor's mailbox is run
+  // only after the other ready actors; zero disables the budget
+  void set_event_time_budget(double event_time_budget);
+
+  // returns true if the currently running actor has spent its event time budget and should continue later
+  bool is_event_time_budget_exceeded() const;
+
   template <class ActorT, class... Args>
   TD_WARN_UNUSED_RESULT ActorOwn<ActorT> create_actor(Slice name, Args &&...args);
   template <class ActorT, class... Args>
@@ -217,6 +259,12 @@ class Scheduler {
   Timestamp run_events(Timestamp timeout);
   void run_poll(Timestamp timeout);
 
+  void flush_outbound_events();
+
+  void publish_ready_actor_count(const ListNode &actors_list);
+  void try_steal_actor();
+  void process_steal_request(ListNode &actors_list);
+
   template <class ActorT>
   ActorOwn<ActorT> register_actor_impl(Slice name, ActorT *actor_ptr, Actor::Deleter deleter, int32 sched_id);
   void destroy_actor(ActorInfo *actor_info);
@@ -245,9 +293,22 @@ class Scheduler {
   int32 sched_n_ = 0;
   std::shared_ptr<MpscPollableQueue<EventFull>> inbound_queue_;
   std::vector<std::shared_ptr<MpscPollableQueue<EventFull>>> outbound_queues_;
+  std::vector<std::vector<EventFull>> outbound_events_;  // events to be published to outbound_queues_
+  std::vector<int32> outbound_event_sched_ids_;           // schedulers with non-empty outbound_events_
+  bool batch_outbound_events_ = true;
+  bool is_batching_outbound_events_ = false;  // true only inside run_no_guard
+  uint64 cross_scheduler_event_count_ = 0;    // not yet published to the metrics registry
 
   std::shared_ptr<ActorContext> save_context_;
 
+  std::shared_ptr<WorkStealingState> work_stealing_;
+
+  double nested_run_time_ = 0.0;  // time spent in the nested events of the currently running actor
+  double event_time_budget_ = 0.0;
+  double mailbox_run_start_time_ = 0.0;  // time when the mailbox of the currently running actor started to run
+  static constexpr int32 MIN_STEAL_VICTIM_READY_ACTOR_COUNT = 2;
+  static constexpr int32 MAX_COUNTED_READY_ACTOR_COUNT = 64;
+
   struct EventContext {
     int32 dest_sched_id{0};
     enum Flags { Stop = 1, Migrate = 2 };
@@ -6,6 +6,7 @@
 //
 #include "td/actor/impl/Scheduler.h"
 
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/impl/Actor.h"
 #include "td/actor/impl/ActorId.h"
 #include "td/actor/impl/ActorInfo.h"
@@ -18,6 +19,8 @@
 #include "td/utils/format.h"
 #include "td/utils/List.h"
 #include "td/utils/logging.h"
+#include "td/utils/MemoryAttribution.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/misc.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/ObjectPool.h"
@@ -27,6 +30,7 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -96,7 +100,13 @@ void Scheduler::ServiceActor::loop() {
     } else {
       VLOG(actor) << "Receive " << event.data();
       finish_migrate(event.data());
-      event.try_emit();
+      auto *actor_info = event.actor_id().get_actor_info();
+      if (Scheduler::instance()->work_stealing_ != nullptr && actor_info != nullptr && actor_info->is_stealable()) {
+        // keep the events in mailboxes, so that the receivers can be stolen by idle schedulers
+        event.try_emit_later();
+      } else {
+        event.try_emit();
+      }
     }
   }
   queue->reader_flush();
@@ -150,7 +160,19 @@ SchedulerGuard::~SchedulerGuard() {
 }
 
 /*** EventGuard ***/
-EventGuard::EventGuard(Scheduler *scheduler, ActorInfo *actor_info) : scheduler_(scheduler) {
+EventGuard::EventGuard(Scheduler *scheduler, ActorInfo *actor_info)
+    : scheduler_(scheduler), statistics_(actor_info->get_statistics()) {
+  if (statistics_ != nullptr) {
+    start_time_ = Time::now();
+    auto ready_time = actor_info->extract_ready_time();
+    if (ready_time != 0.0) {
+      queue_time_ = start_time_ - ready_time;
+    }
+    save_nested_run_time_ = scheduler_->nested_run_time_;
+    scheduler_->nested_run_time_ = 0.0;
+  }
+  save_memory_tag_ = MemoryAttribution::get_current_tag();
+  MemoryAttribution::set_current_tag(actor_info->get_memory_tag());
   actor_info->start_run();
   event_context_.actor_info = actor_info;
   event_context_ptr_ = &event_context_;
@@ -163,6 +185,12 @@ EventGuard::EventGuard(Scheduler *scheduler, ActorInfo *actor_info) : scheduler_
 }
 
 EventGuard::~EventGuard() {
+  if (statistics_ != nullptr) {
+    auto run_time = Time::now() - start_time_;
+    statistics_->on_run(run_time - scheduler_->nested_run_time_, queue_time_, event_count_);
+    scheduler_->nested_run_time_ = save_nested_run_time_ + run_time;
+  }
+  MemoryAttribution::set_current_tag(save_memory_tag_);
   auto info = event_context_.actor_info;
   auto node = info->get_list_node();
   node->remove();
@@ -229,10 +257,41 @@ void Scheduler::init(int32 id, std::vector<std::shared_ptr<MpscPollableQueue<Eve
   outbound_queues_ = std::move(outbound);
   sched_id_ = id;
   sched_n_ = static_cast<int32>(outbound_queues_.size());
+  outbound_events_.resize(outbound_queues_.size());
   service_actor_.set_queue(inbound_queue_);
   register_actor(PSLICE() << "ServiceActor" << id, &service_actor_).release();
 }
 
+Scheduler::WorkStealingState::WorkStealingState(int32 scheduler_count)
+    : ready_actor_count_(static_cast<size_t>(scheduler_count))
+    , steal_request_(static_cast<size_t>(scheduler_count))
+    , is_stealing_(static_cast<size_t>(scheduler_count))
+    , is_idle_(static_cast<size_t>(scheduler_count)) {
+}
+
+Scheduler::WorkStealingStatistics Scheduler::WorkStealingState::get_statistics() const {
+  WorkStealingStatistics result;
+  result.steal_request_count = steal_request_count_.load(std::memory_order_relaxed);
+  result.stolen_actor_count = stolen_actor_count_.load(std::memory_order_relaxed);
+  result.failed_steal_count = failed_steal_count_.load(std::memory_order_relaxed);
+  result.steal_time = static_cast<double>(steal_time_ns_.load(std::memory_order_relaxed)) * 1e-9;
+  return result;
+}
+
+void Scheduler::enable_work_stealing(std::shared_ptr<WorkStealingState> state) {
+  CHECK(state != nullptr);
+  CHECK(static_cast<size_t>(sched_id_) < state->ready_actor_count_.size());
+  work_stealing_ = std::move(state);
+}
+
+void Scheduler::set_batch_outbound_events(bool batch_outbound_events) {
+  batch_outbound_events_ = batch_outbound_events;
+}
+
+void Scheduler::set_event_time_budget(double event_time_budget) {
+  event_time_budget_ = max(event_time_budget, 0.0);
+}
+
 void Scheduler::clear() {
   if (service_actor_.empty()) {
     return;
@@ -354,6 +413,11 @@ void Scheduler::register_migrated_actor(ActorInfo *actor_info) {
   actor_info->get_actor_unsafe()->on_finish_migrate();
 }
 
+static MetricsRegistry::Counter *get_cross_scheduler_event_counter() {
+  static auto *counter = MetricsRegistry::get_counter("td_actor_cross_scheduler_events_total");
+  return counter;
+}
+
 void Scheduler::send_to_other_scheduler(int32 sched_id, const ActorId<> &actor_id, Event &&event) {
   if (sched_id < sched_count()) {
     auto actor_info = actor_id.get_actor_info();
@@ -362,12 +426,38 @@ void Scheduler::send_to_other_scheduler(int32 sched_id, const ActorId<> &actor_i
     } else {
       VLOG(actor) << "Send to scheduler " << sched_id << ": " << event;
     }
+    if (has_guard_) {
+      // the scheduler is owned by the current thread, so the event can be counted without atomic operations
+      cross_scheduler_event_count_++;
+    } else {
+      get_cross_scheduler_event_counter()->add(1);
+    }
     start_migrate(event, sched_id);
+    if (is_batching_outbound_events_) {
+      auto &events = outbound_events_[sched_id];
+      if (events.empty()) {
+        outbound_event_sched_ids_.push_back(sched_id);
+      }
+      events.push_back(EventCreator::event_unsafe(actor_id, std::move(event)));
+      return;
+    }
     outbound_queues_[sched_id]->writer_put(EventCreator::event_unsafe(actor_id, std::move(event)));
     outbound_queues_[sched_id]->writer_flush();
   }
 }
 
+void Scheduler::flush_outbound_events() {
+  if (cross_scheduler_event_count_ != 0) {
+    get_cross_scheduler_event_counter()->add(static_cast<int64>(cross_scheduler_event_count_));
+    cross_scheduler_event_count_ = 0;
+  }
+  for (auto sched_id : outbound_event_sched_ids_) {
+    outbound_queues_[sched_id]->writer_put_batch(outbound_events_[sched_id]);
+    outbound_queues_[sched_id]->writer_flush();
+  }
+  outbound_event_sched_ids_.clear();
+}
+
 void Scheduler::run_on_scheduler(int32 sched_id, Promise<Unit> action) {
   if (sched_id >= 0 && sched_id_ != sched_id) {
     class Worker final : public Actor {
@@ -413,6 +503,11 @@ void Scheduler::add_to_mailbox(ActorInfo *actor_info, Event &&event) {
   }
   VLOG(actor) << "Add to mailbox: " << *actor_info << " " << event;
   actor_info->mailbox_.push_back(std::move(event));
+  auto statistics = actor_info->get_statistics();
+  if (statistics != nullptr) {
+    actor_info->on_ready(Time::now());
+    statistics->on_mailbox_size(actor_info->mailbox_.size());
+  }
 }
 
 void Scheduler::do_stop_actor(Actor *actor) {
@@ -425,6 +520,7 @@ void Scheduler::do_stop_actor(ActorInfo *actor_info) {
   ObjectPool<ActorInfo>::OwnerPtr owner_ptr;
   if (actor_info->need_start_up()) {
     EventGuard guard(this, actor_info);
+    guard.add_event_count(1);
     do_event(actor_info, Event::stop());
     owner_ptr = actor_info->get_actor_unsafe()->clear();
     // Actor context is visible in destructor
@@ -463,6 +559,8 @@ void Scheduler::do_migrate_actor(ActorInfo *actor_info, int32 dest_sched_id) {
   }
   start_migrate_actor(actor_info, dest_sched_id);
   send_to_other_scheduler(dest_sched_id, ActorId<>(), Event::raw(actor_info));
+  // the actor can't run anywhere until the destination scheduler receives it, so it must not wait for the batch
+  flush_outbound_events();
 }
 
 void Scheduler::start_migrate_actor(Actor *actor, int32 dest_sched_id) {
@@ -527,20 +625,56 @@ void Scheduler::flush_mailbox(ActorInfo *actor_info) {
   CHECK(mailbox_size != 0);
   EventGuard guard(this, actor_info);
   size_t i = 0;
-  for (; i < mailbox_size && guard.can_run(); i++) {
-    do_event(actor_info, std::move(mailbox[i]));
+  if (event_time_budget_ <= 0.0) {
+    for (; i < mailbox_size && guard.can_run(); i++) {
+      do_event(actor_info, std::move(mailbox[i]));
+    }
+  } else {
+    // the mailbox can be flushed from an event of another actor, which will continue with its own budget
+    auto saved_mailbox_run_start_time = mailbox_run_start_time_;
+    SCOPE_EXIT {
+      mailbox_run_start_time_ = saved_mailbox_run_start_time;
+    };
+    mailbox_run_start_time_ = Time::now();
+    auto event_start_time = mailbox_run_start_time_;
+    while (i < mailbox_size && guard.can_run()) {
+      auto event_type = mailbox[i].type;
+      do_event(actor_info, std::move(mailbox[i]));
+      i++;
+      auto now = Time::now();
+      if (now - event_start_time >= event_time_budget_) {
+        static auto *counter = MetricsRegistry::get_counter("td_actor_event_time_budget_exceeded_total");
+        counter->add(1);
+        LOG(WARNING) << "Event " << event_type << " of actor " << actor_info->get_name() << " took "
+                     << now - event_start_time << " seconds";
+      }
+      if (now - mailbox_run_start_time_ >= event_time_budget_) {
+        // the remaining events will be run after the other ready actors
+        VLOG(actor) << "Postpone " << mailbox_size - i << " events of actor " << actor_info->get_name() << " after "
+                    << now - mailbox_run_start_time_ << " seconds";
+        break;
+      }
+      event_start_time = now;
+    }
   }
+  guard.add_event_count(i);
   mailbox.erase(mailbox.begin(), mailbox.begin() + i);
 }
 
 void Scheduler::run_mailbox() {
   VLOG(actor) << "Run mailbox : begin";
   ListNode actors_list = std::move(ready_actors_list_);
+  if (work_stealing_ != nullptr) {
+    publish_ready_actor_count(actors_list);
+  }
   while (!actors_list.empty()) {
     ListNode *node = actors_list.get();
     CHECK(node);
     auto actor_info = ActorInfo::from_list_node(node);
     flush_mailbox(actor_info);
+    if (work_stealing_ != nullptr) {
+      process_steal_request(actors_list);
+    }
   }
   VLOG(actor) << "Run mailbox : finish " << actor_count_;
 
@@ -580,21 +714,139 @@ Timestamp Scheduler::run_events(Timestamp timeout) {
   do {
     run_mailbox();
     res = run_timeout();
+    flush_outbound_events();
   } while (!ready_actors_list_.empty() && !timeout.is_in_past());
   return res;
 }
 
+void Scheduler::publish_ready_actor_count(const ListNode &actors_list) {
+  int32 ready_actor_count = 0;
+  for (auto it = actors_list.begin(); it != actors_list.end() && ready_actor_count < MAX_COUNTED_READY_ACTOR_COUNT;
+       it = it->get_next()) {
+    ready_actor_count++;
+  }
+  work_stealing_->ready_actor_count_[sched_id_].store(ready_actor_count, std::memory_order_relaxed);
+  if (ready_actor_count < MIN_STEAL_VICTIM_READY_ACTOR_COUNT) {
+    return;
+  }
+
+  // idle schedulers sleep in poll, so wake up one of them to steal an actor
+  auto scheduler_count = static_cast<int32>(work_stealing_->is_idle_.size());
+  for (int32 i = 0; i < scheduler_count; i++) {
+    bool is_idle = true;
+    if (i != sched_id_ && work_stealing_->is_idle_[i].compare_exchange_strong(is_idle, false)) {
+      send_to_other_scheduler(i, ActorId<>(), Event());
+      // the wakeup is useless if it is delivered after the batch, so it is sent immediately
+      flush_outbound_events();
+      break;
+    }
+  }
+}
+
+void Scheduler::try_steal_actor() {
+  // the main scheduler is run by the user and can't be relied on to run stolen actors in time
+  if (sched_id_ == 0 || !ready_actors_list_.empty() || close_flag_) {
+    return;
+  }
+  SCOPE_EXIT {
+    work_stealing_->is_idle_[sched_id_].store(true, std::memory_order_relaxed);
+  };
+  auto &is_stealing = work_stealing_->is_stealing_[sched_id_];
+  if (is_stealing.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  int32 victim_sched_id = -1;
+  int32 max_ready_actor_count = MIN_STEAL_VICTIM_READY_ACTOR_COUNT - 1;
+  auto scheduler_count = static_cast<int32>(work_stealing_->ready_actor_count_.size());
+  for (int32 i = 0; i < scheduler_count; i++) {
+    if (i == sched_id_) {
+      continue;
+    }
+    auto ready_actor_count = work_stealing_->ready_actor_count_[i].load(std::memory_order_relaxed);
+    if (ready_actor_count > max_ready_actor_count) {
+      max_ready_actor_count = ready_actor_count;
+      victim_sched_id = i;
+    }
+  }
+  if (victim_sched_id == -1) {
+    return;
+  }
+
+  int32 no_request = 0;
+  if (!work_stealing_->steal_request_[victim_sched_id].compare_exchange_strong(no_request, sched_id_ + 1)) {
+    // someone else is already stealing from the scheduler
+    return;
+  }
+  VLOG(actor) << "Try to steal an actor from scheduler " << victim_sched_id << " with " << max_ready_actor_count
+              << " ready actors";
+  is_stealing.store(true, std::memory_order_relaxed);
+  work_stealing_->steal_request_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Scheduler::process_steal_request(ListNode &actors_list) {
+  auto &steal_request = work_stealing_->steal_request_[sched_id_];
+  if (steal_request.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  auto thief_sched_id = steal_request.exchange(0) - 1;
+  CHECK(thief_sched_id >= 0);
+
+  auto start_time = Time::now();
+  SCOPE_EXIT {
+    auto steal_time_ns = static_cast<uint64>(max(Time::now() - start_time, 0.0) * 1e9);
+    work_stealing_->steal_time_ns_.fetch_add(steal_time_ns, std::memory_order_relaxed);
+    work_stealing_->is_stealing_[thief_sched_id].store(false, std::memory_order_relaxed);
+  };
+
+  // actors are taken from the end of the lists, so the actors at the beginning, which will run first, aren't stolen
+  ActorInfo *stolen_actor_info = nullptr;
+  int32 ready_actor_count = 0;
+  for (auto *list : {&ready_actors_list_, &actors_list}) {
+    for (auto it = list->get_prev(); it != list->end(); it = it->get_prev()) {
+      ready_actor_count++;
+      auto actor_info = ActorInfo::from_list_node(it);
+      if (stolen_actor_info == nullptr && actor_info->is_stealable() && !actor_info->is_running() &&
+          !actor_info->is_migrating() && !actor_info->get_heap_node()->in_heap()) {
+        stolen_actor_info = actor_info;
+      }
+      if (stolen_actor_info != nullptr && ready_actor_count >= MIN_STEAL_VICTIM_READY_ACTOR_COUNT) {
+        break;
+      }
+    }
+  }
+  if (stolen_actor_info == nullptr || ready_actor_count < MIN_STEAL_VICTIM_READY_ACTOR_COUNT || close_flag_) {
+    work_stealing_->failed_steal_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  VLOG(actor) << "Actor " << *stolen_actor_info << " is stolen by scheduler " << thief_sched_id;
+  work_stealing_->stolen_actor_count_.fetch_add(1, std::memory_order_relaxed);
+  do_migrate_actor(stolen_actor_info, thief_sched_id);
+}
+
 void Scheduler::run_no_guard(Timestamp timeout) {
   CHECK(has_guard_);
+  is_batching_outbound_events_ = batch_outbound_events_;
   SCOPE_EXIT {
     yield_flag_ = false;
+    flush_outbound_events();
+    is_batching_outbound_events_ = false;
   };
 
+  ActorStatistics::on_scheduler_run();
+
   timeout.relax(run_events(timeout));
   if (yield_flag_) {
     return;
   }
+  if (work_stealing_ != nullptr) {
+    try_steal_actor();
+  }
   run_poll(timeout);
+  if (work_stealing_ != nullptr) {
+    work_stealing_->is_idle_[sched_id_].store(false, std::memory_order_relaxed);
+  }
   run_events(timeout);
 }
 
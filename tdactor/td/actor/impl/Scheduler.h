@@ -34,6 +34,10 @@ class EventGuard {
     return event_context_.flags == 0;
   }
 
+  void add_event_count(uint64 event_count) {
+    event_count_ += event_count;
+  }
+
   EventGuard(const EventGuard &) = delete;
   EventGuard &operator=(const EventGuard &) = delete;
   EventGuard(EventGuard &&) = delete;
@@ -46,6 +50,13 @@ class EventGuard {
   Scheduler *scheduler_;
   ActorContext *save_context_;
   const char *save_log_tag2_;
+  const char *save_memory_tag_;
+
+  ActorStatisticsEntry *statistics_;
+  double start_time_ = 0.0;
+  double queue_time_ = 0.0;
+  double save_nested_run_time_ = 0.0;
+  uint64 event_count_ = 0;
 
   void swap_context(ActorInfo *info);
 };
@@ -193,6 +204,7 @@ void Scheduler::send_immediately_impl(const ActorId<> &actor_id, const RunFuncT
 
   if (likely(can_send_immediately)) {  // run immediately
     EventGuard guard(this, actor_info);
+    guard.add_event_count(1);
     run_func(actor_info);
   } else {
     if (on_current_sched) {
@@ -325,6 +337,10 @@ inline void Scheduler::finish() {
   yield();
 }
 
+inline bool Scheduler::is_event_time_budget_exceeded() const {
+  return event_time_budget_ > 0.0 && Time::now() - mailbox_run_start_time_ >= event_time_budget_;
+}
+
 inline void Scheduler::yield() {
   yield_flag_ = true;
 }
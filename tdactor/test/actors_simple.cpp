@@ -5,6 +5,7 @@
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 #include "td/actor/actor.h"
+#include "td/actor/ActorStatistics.h"
 #include "td/actor/ConcurrentScheduler.h"
 #include "td/actor/MultiPromise.h"
 #include "td/actor/PromiseFuture.h"
@@ -12,6 +13,7 @@
 
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/MemoryAttribution.h"
 #include "td/utils/MpscPollableQueue.h"
 #include "td/utils/Observer.h"
 #include "td/utils/port/FileFd.h"
@@ -65,6 +67,65 @@ TEST(Actors, SendLater) {
   ASSERT_STREQ("AAA", sb.as_cslice().c_str());
 }
 
+static void busy_wait(double seconds) {
+  auto end_time = td::Time::now() + seconds;
+  while (td::Time::now() < end_time) {
+  }
+}
+
+class ChunkedWorker final : public td::Actor {
+ public:
+  void process(int left) {
+    while (left > 0) {
+      busy_wait(0.0005);
+      left--;
+      if (left > 0 && is_event_time_budget_exceeded()) {
+        sb << "C";
+        return td::send_closure_later(actor_id(this), &ChunkedWorker::process, left);
+      }
+    }
+    sb << "D";
+  }
+};
+
+TEST(Actors, event_time_budget) {
+  sb.clear();
+  td::Scheduler scheduler;
+  scheduler.init(0, create_queues(), nullptr);
+  scheduler.set_event_time_budget(0.001);
+
+  auto guard = scheduler.get_guard();
+  class Worker final : public td::Actor {
+   public:
+    explicit Worker(char c) : c_(c) {
+    }
+    void f() {
+      sb << td::Slice(&c_, 1);
+      busy_wait(0.002);
+    }
+
+   private:
+    char c_;
+  };
+  auto a = td::create_actor<Worker>("A", 'A');
+  auto b = td::create_actor<Worker>("B", 'B');
+  for (int i = 0; i < 3; i++) {
+    td::send_closure_later(a, &Worker::f);
+  }
+  td::send_closure_later(b, &Worker::f);
+  scheduler.run_no_guard(td::Timestamp::in(1));
+  ASSERT_STREQ("ABAA", sb.as_cslice().c_str());
+
+  sb.clear();
+  auto chunked = td::create_actor<ChunkedWorker>("ChunkedWorker");
+  td::send_closure_later(chunked, &ChunkedWorker::process, 10);
+  scheduler.run_no_guard(td::Timestamp::in(1));
+  auto result = sb.as_cslice().str();
+  ASSERT_TRUE(result.size() >= 2u);
+  ASSERT_EQ('C', result[0]);
+  ASSERT_EQ('D', result.back());
+}
+
 class X {
  public:
   X() {
@@ -273,6 +334,71 @@ TEST(Actors, simple_migrate) {
 #endif
 }
 
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+TEST(Actors, thread_placement_masks) {
+  using ThreadPlacement = td::ConcurrentScheduler::ThreadPlacement;
+  td::vector<td::vector<td::int32>> numa_node_cpus{{0, 1}, {2, 3}};
+  ASSERT_TRUE(td::ConcurrentScheduler::get_thread_placement_masks(ThreadPlacement::None, 1, 3, numa_node_cpus) ==
+              td::vector<td::uint64>(3, 0));
+  ASSERT_TRUE(td::ConcurrentScheduler::get_thread_placement_masks(ThreadPlacement::Compact, 1, 4, numa_node_cpus) ==
+              td::vector<td::uint64>({2, 4, 8, 1}));
+  ASSERT_TRUE(td::ConcurrentScheduler::get_thread_placement_masks(ThreadPlacement::Spread, 1, 3, numa_node_cpus) ==
+              td::vector<td::uint64>({12, 3, 12}));
+}
+#endif
+
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED && TD_HAVE_THREAD_AFFINITY
+static td::uint64 scheduler_affinity_masks[3];
+
+class AffinityMaskRecorder final : public td::Actor {
+ public:
+  explicit AffinityMaskRecorder(td::int32 sched_id) : sched_id_(sched_id) {
+  }
+  void start_up() final {
+    scheduler_affinity_masks[sched_id_] = td::thread::get_affinity_mask(td::this_thread::get_id());
+    stop();
+  }
+
+ private:
+  td::int32 sched_id_;
+};
+#endif
+
+TEST(Actors, thread_placement) {
+  for (auto placement : {td::ConcurrentScheduler::ThreadPlacement::Compact,
+                         td::ConcurrentScheduler::ThreadPlacement::Spread}) {
+    sb.clear();
+    sb2.clear();
+
+    td::ConcurrentScheduler scheduler(2, 0);
+    scheduler.set_thread_placement(placement, 1);
+    scheduler.set_low_priority_scheduler(2);
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED && TD_HAVE_THREAD_AFFINITY
+    // the recorders are run before Ping and Pong on their schedulers
+    for (td::int32 sched_id = 1; sched_id <= 2; sched_id++) {
+      scheduler_affinity_masks[sched_id] = 0;
+      scheduler.create_actor_unsafe<AffinityMaskRecorder>(sched_id, "AffinityMaskRecorder", sched_id).release();
+    }
+#endif
+    auto pong = scheduler.create_actor_unsafe<Pong>(2, "Pong").release();
+    scheduler.create_actor_unsafe<Ping>(1, "Ping", pong).release();
+    scheduler.start();
+    while (scheduler.run_main(10)) {
+    }
+    scheduler.finish();
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED
+    ASSERT_STREQ("start", sb.as_cslice().c_str());
+    ASSERT_STREQ("finish", sb2.as_cslice().c_str());
+#endif
+#if !TD_THREAD_UNSUPPORTED && !TD_EVENTFD_UNSUPPORTED && TD_HAVE_THREAD_AFFINITY
+    auto expected_masks = td::ConcurrentScheduler::get_thread_placement_masks(
+        placement, 1, 2, td::ConcurrentScheduler::get_numa_node_cpus());
+    ASSERT_EQ(expected_masks[0], scheduler_affinity_masks[1]);
+    ASSERT_EQ(expected_masks[1], scheduler_affinity_masks[2]);
+#endif
+  }
+}
+
 class OpenClose final : public td::Actor {
  public:
   explicit OpenClose(int cnt) : cnt_(cnt) {
@@ -445,6 +571,47 @@ TEST(Actors, promise) {
   ASSERT_EQ(1, value);
 }
 
+TEST(Actors, promise_inline_storage) {
+  int value = 0;
+  td::Promise<int> small = td::PromiseCreator::lambda([&value](int x) { value += x; });
+  ASSERT_TRUE(small.is_inline());
+  td::Promise<int> moved = std::move(small);
+  ASSERT_TRUE(!small);
+  ASSERT_TRUE(moved.is_inline());
+  td::vector<td::Promise<int>> promises;
+  for (int i = 0; i < 10; i++) {
+    promises.push_back(std::move(moved));
+    moved = std::move(promises.back());
+    promises.pop_back();
+  }
+  moved.set_value(1);
+  ASSERT_TRUE(!moved);
+  ASSERT_EQ(1, value);
+
+  td::string big_capture(100, 'a');
+  td::Promise<int> big = td::PromiseCreator::lambda(
+      [&value, big_capture, nested = td::Promise<int>()](td::Result<int> r_x) { value += r_x.is_ok() ? 10 : 100; });
+  ASSERT_TRUE(!big.is_inline());
+  big = {};
+  ASSERT_EQ(101, value);
+
+  td::Promise<int> released = td::PromiseCreator::lambda([&value](int x) { value += x; });
+  td::Promise<int> from_heap(released.release());
+  ASSERT_TRUE(!from_heap.is_inline());
+  from_heap.set_value(1000);
+  ASSERT_EQ(1101, value);
+
+  {
+    td::Promise<int> lost = td::PromiseCreator::lambda([&value](td::Result<int> r_x) {
+      if (r_x.is_error()) {
+        value = -1;
+      }
+    });
+    auto moved_lost = std::move(lost);
+  }
+  ASSERT_EQ(-1, value);
+}
+
 class LaterSlave final : public td::Actor {
  public:
   explicit LaterSlave(td::ActorShared<> parent) : parent_(std::move(parent)) {
@@ -552,6 +719,87 @@ TEST(Actors, FastPromise) {
   scheduler.finish();
 }
 
+class StatisticsPing final : public td::Actor {
+ public:
+  void ping(int left) {
+    if (left == 0) {
+      td::Scheduler::instance()->finish();
+      return;
+    }
+    td::send_closure_later(actor_id(this), &StatisticsPing::ping, left - 1);
+  }
+};
+
+TEST(Actors, ActorStatistics) {
+  td::ActorStatistics::set_enabled(true);
+  td::ConcurrentScheduler scheduler(0, 0);
+  auto actor_id = scheduler.create_actor_unsafe<StatisticsPing>(0, "StatisticsPing123").release();
+  td::ActorStatistics::set_enabled(false);
+  scheduler.start();
+  {
+    auto guard = scheduler.get_main_guard();
+    td::send_closure_later(actor_id, &StatisticsPing::ping, 100);
+  }
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+
+  bool is_found = false;
+  for (auto &entry : td::ActorStatistics::get_statistics(true)) {
+    if (entry.name == "StatisticsPing") {
+      is_found = true;
+      ASSERT_TRUE(entry.event_count >= 101);
+      ASSERT_TRUE(entry.max_mailbox_size >= 1);
+      ASSERT_TRUE(entry.run_time >= 0.0);
+    }
+  }
+  ASSERT_TRUE(is_found);
+  // entries without events are omitted, so the reset entry must disappear
+  for (auto &entry : td::ActorStatistics::get_statistics(false)) {
+    ASSERT_TRUE(entry.name != "StatisticsPing");
+  }
+}
+
+static td::vector<td::MemoryAttribution::Entry> get_empty_memory_attribution() {
+  return {};
+}
+
+class MemoryTagChecker final : public td::Actor {
+ public:
+  explicit MemoryTagChecker(const char **memory_tag) : memory_tag_(memory_tag) {
+  }
+
+  void check() {
+    *memory_tag_ = td::MemoryAttribution::get_current_tag();
+    td::Scheduler::instance()->finish();
+  }
+
+ private:
+  const char **memory_tag_;
+};
+
+TEST(Actors, MemoryAttribution) {
+  td::MemoryAttribution::set_statistics_getter(&get_empty_memory_attribution);
+  ASSERT_TRUE(td::MemoryAttribution::get_tag("MemoryTagChecker") == td::MemoryAttribution::get_tag("MemoryTagChecker"));
+  const char *memory_tag = nullptr;
+  td::ConcurrentScheduler scheduler(0, 0);
+  auto actor_id = scheduler.create_actor_unsafe<MemoryTagChecker>(0, "MemoryTagChecker42", &memory_tag).release();
+  td::MemoryAttribution::set_statistics_getter(nullptr);
+  scheduler.start();
+  {
+    auto guard = scheduler.get_main_guard();
+    td::send_closure_later(actor_id, &MemoryTagChecker::check);
+  }
+  while (scheduler.run_main(10)) {
+  }
+  scheduler.finish();
+
+  ASSERT_TRUE(memory_tag != nullptr);
+  ASSERT_STREQ("MemoryTagChecker", memory_tag);
+  ASSERT_TRUE(td::MemoryAttribution::get_current_tag() == nullptr);
+  ASSERT_TRUE(td::MemoryAttribution::get_statistics().empty());
+}
+
 class StopInTeardown final : public td::Actor {
   void loop() final {
     stop();
@@ -680,3 +928,29 @@ TEST(Actors, MultiPromiseSendClosureLater) {
   }
   scheduler.finish();
 }
+
+#if TD_ACTOR_EVENT_POOL
+TEST(Actors, EventPool) {
+  int events_n = 100;
+  int run_count = 0;
+  auto create_events = [&] {
+    td::vector<td::Event> events;
+    for (int i = 0; i < events_n; i++) {
+      events.push_back(td::Event::from_lambda([&run_count, i] { run_count += i; }));
+    }
+    return events;
+  };
+
+  auto events = create_events();
+  auto allocated_free_chunk_count = td::EventPool::get_free_chunk_count();
+  events.clear();
+  ASSERT_EQ(allocated_free_chunk_count + events_n, td::EventPool::get_free_chunk_count());
+
+  events = create_events();
+  ASSERT_EQ(allocated_free_chunk_count, td::EventPool::get_free_chunk_count());
+  for (auto &event : events) {
+    event.data.custom_event->run(nullptr);
+  }
+  ASSERT_EQ(events_n * (events_n - 1) / 2, run_count);
+}
+#endif
@@ -6,12 +6,16 @@
 //
 #include "td/actor/actor.h"
 #include "td/actor/ConcurrentScheduler.h"
+#include "td/actor/CpuTaskPool.h"
 
 #include "td/utils/common.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
+#include <atomic>
+#include <memory>
+
 class PowerWorker final : public td::Actor {
  public:
   class Callback {
@@ -186,3 +190,255 @@ TEST(Actors, send_closure_while_finish) {
   }
   sched.finish();
 }
+
+class StealableWorker final : public td::Actor {
+ public:
+  explicit StealableWorker(std::shared_ptr<std::atomic<int>> left_tasks) : left_tasks_(std::move(left_tasks)) {
+  }
+
+  void task(td::uint32 x, td::uint32 p) {
+    td::uint32 res = 1;
+    for (td::uint32 i = 0; i < p; i++) {
+      res *= x;
+    }
+    CHECK(res != 0);
+    if (left_tasks_->fetch_sub(1) == 1) {
+      td::Scheduler::instance()->finish();
+    }
+  }
+
+ private:
+  std::shared_ptr<std::atomic<int>> left_tasks_;
+
+  void start_up() final {
+    set_stealable(true);
+  }
+};
+
+TEST(Actors, work_stealing) {
+  int threads_n = 3;
+  int workers_n = 20;
+  int queries_n = 50;
+  td::ConcurrentScheduler sched(threads_n, 0);
+  sched.enable_work_stealing();
+
+  auto left_tasks = std::make_shared<std::atomic<int>>(workers_n * queries_n);
+  td::vector<td::ActorId<StealableWorker>> workers;
+  for (int i = 0; i < workers_n; i++) {
+    workers.push_back(
+        sched.create_actor_unsafe<StealableWorker>(1, PSLICE() << "StealableWorker" << i, left_tasks).release());
+  }
+
+  sched.start();
+  {
+    auto guard = sched.get_main_guard();
+    for (int j = 0; j < queries_n; j++) {
+      for (auto &worker : workers) {
+        td::send_closure(worker, &StealableWorker::task, 3, 100000);
+      }
+    }
+  }
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+
+  auto stats = sched.get_work_stealing_statistics();
+  LOG(INFO) << "Work stealing: " << stats.steal_request_count << " requests, " << stats.stolen_actor_count
+            << " stolen actors, " << stats.failed_steal_count << " failed steals, " << stats.steal_time << " seconds";
+  ASSERT_TRUE(stats.stolen_actor_count + stats.failed_steal_count <= stats.steal_request_count);
+  ASSERT_EQ(0, left_tasks->load());
+}
+
+class OrderedReceiver final : public td::Actor {
+ public:
+  explicit OrderedReceiver(int total_n) : total_n_(total_n) {
+  }
+
+  void receive(int sender_id, int x) {
+    if (static_cast<size_t>(sender_id) >= next_.size()) {
+      next_.resize(sender_id + 1);
+    }
+    CHECK(next_[sender_id] == x);
+    next_[sender_id]++;
+    if (--total_n_ == 0) {
+      td::Scheduler::instance()->finish();
+    }
+  }
+
+ private:
+  int total_n_;
+  td::vector<int> next_;
+};
+
+class BurstSender final : public td::Actor {
+ public:
+  BurstSender(int sender_id, td::ActorId<OrderedReceiver> receiver) : sender_id_(sender_id), receiver_(receiver) {
+  }
+
+  void send(int n) {
+    for (int i = 0; i < n; i++) {
+      td::send_closure(receiver_, &OrderedReceiver::receive, sender_id_, sent_n_++);
+    }
+  }
+
+ private:
+  int sender_id_;
+  td::ActorId<OrderedReceiver> receiver_;
+  int sent_n_ = 0;
+};
+
+TEST(Actors, batch_outbound_events) {
+  int senders_n = 4;
+  int bursts_n = 20;
+  int burst_size = 500;
+  td::ConcurrentScheduler sched(3, 0);
+
+  auto receiver =
+      sched.create_actor_unsafe<OrderedReceiver>(3, "OrderedReceiver", senders_n * bursts_n * burst_size).release();
+  td::vector<td::ActorId<BurstSender>> senders;
+  for (int i = 0; i < senders_n; i++) {
+    senders.push_back(
+        sched.create_actor_unsafe<BurstSender>(1 + i % 2, PSLICE() << "BurstSender" << i, i, receiver).release());
+  }
+
+  sched.start();
+  {
+    auto guard = sched.get_main_guard();
+    for (int j = 0; j < bursts_n; j++) {
+      for (auto &sender : senders) {
+        td::send_closure(sender, &BurstSender::send, burst_size);
+      }
+    }
+  }
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+}
+
+class CpuTaskPoolClient final : public td::Actor {
+ public:
+  CpuTaskPoolClient(td::CpuTaskPool *pool, int tasks_n) : pool_(pool), tasks_n_(tasks_n) {
+  }
+
+ private:
+  td::CpuTaskPool *pool_;
+  int tasks_n_;
+  int left_tasks_n_ = 0;
+
+  void start_up() final {
+    left_tasks_n_ = tasks_n_;
+    for (int i = 0; i < tasks_n_; i++) {
+      pool_->run(
+          [i] {
+            td::uint32 res = 1;
+            for (int j = 0; j < 100000; j++) {
+              res = res * 3 + static_cast<td::uint32>(i);
+            }
+            return res;
+          },
+          td::PromiseCreator::lambda([actor_id = actor_id(this), sched_id = td::Scheduler::instance()->sched_id(),
+                                      i](td::Result<td::uint32> result) {
+            CHECK(td::Scheduler::instance()->sched_id() == sched_id);
+            CHECK(result.is_ok());
+            td::uint32 res = 1;
+            for (int j = 0; j < 100000; j++) {
+              res = res * 3 + static_cast<td::uint32>(i);
+            }
+            CHECK(result.ok() == res);
+            td::send_closure(actor_id, &CpuTaskPoolClient::on_task_finished);
+          }));
+    }
+  }
+
+  void on_task_finished() {
+    if (--left_tasks_n_ == 0) {
+      td::Scheduler::instance()->finish();
+      stop();
+    }
+  }
+};
+
+TEST(Actors, cpu_task_pool) {
+  int tasks_n = 100;
+  td::ConcurrentScheduler sched(3, 0);
+  td::CpuTaskPool pool({2, 3});
+  sched.create_actor_unsafe<CpuTaskPoolClient>(1, "CpuTaskPoolClient", &pool, tasks_n).release();
+  sched.start();
+  while (sched.run_main(10)) {
+    // empty
+  }
+  sched.finish();
+
+  auto stats = pool.get_statistics();
+  ASSERT_EQ(static_cast<td::uint64>(tasks_n), stats.started_task_count);
+  ASSERT_EQ(static_cast<td::uint64>(tasks_n), stats.finished_task_count);
+  ASSERT_TRUE(stats.max_run_time <= stats.total_run_time);
+}
+
+class StealableCounter final : public td::Actor {
+ public:
+  StealableCounter(std::shared_ptr<std::atomic<int>> left_tasks, std::shared_ptr<std::atomic<int>> stolen_tasks)
+      : left_tasks_(std::move(left_tasks)), stolen_tasks_(std::move(stolen_tasks)) {
+  }
+
+  void task(td::uint32 x, td::uint32 p) {
+    td::uint32 res = 1;
+    for (td::uint32 i = 0; i < p; i++) {
+      res *= x;
+    }
+    CHECK(res != 0);
+    if (td::Scheduler::instance()->sched_id() != 1) {
+      stolen_tasks_->fetch_add(1);
+    }
+    left_tasks_->fetch_sub(1);
+  }
+
+ private:
+  std::shared_ptr<std::atomic<int>> left_tasks_;
+  std::shared_ptr<std::atomic<int>> stolen_tasks_;
+
+  void start_up() final {
+    set_stealable(true);
+  }
+};
+
+TEST(Actors, work_stealing_runs_stolen_actors) {
+  int threads_n = 3;
+  int workers_n = 20;
+  int queries_n = 20;
+  td::ConcurrentScheduler sched(threads_n, 0);
+  sched.enable_work_stealing();
+
+  auto left_tasks = std::make_shared<std::atomic<int>>(0);
+  auto stolen_tasks = std::make_shared<std::atomic<int>>(0);
+  td::vector<td::ActorId<StealableCounter>> workers;
+  for (int i = 0; i < workers_n; i++) {
+    workers.push_back(sched
+                          .create_actor_unsafe<StealableCounter>(1, PSLICE() << "StealableCounter" << i, left_tasks,
+                                                                 stolen_tasks)
+                          .release());
+  }
+
+  sched.start();
+  for (int round = 0; round < 100 && stolen_tasks->load() == 0; round++) {
+    left_tasks->store(workers_n * queries_n);
+    {
+      auto guard = sched.get_main_guard();
+      for (int j = 0; j < queries_n; j++) {
+        for (auto &worker : workers) {
+          td::send_closure(worker, &StealableCounter::task, 3, 100000);
+        }
+      }
+    }
+    while (left_tasks->load() != 0) {
+      sched.run_main(0.01);
+    }
+  }
+  sched.finish();
+
+  auto stats = sched.get_work_stealing_statistics();
+  ASSERT_TRUE(stats.stolen_actor_count > 0);
+  ASSERT_TRUE(stolen_tasks->load() > 0);
+}
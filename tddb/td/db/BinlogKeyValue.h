@@ -14,11 +14,13 @@
 #include "td/utils/algorithm.h"
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
+#include "td/utils/EpochBasedMemoryReclamation.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/RwMutex.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
@@ -26,6 +28,7 @@
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <unordered_map>
@@ -144,6 +147,7 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
     } else {
       VLOG(binlog) << "Set value of key " << key << " to " << hex_encode(value);
     }
+    on_map_changed();
     bool rewrite = false;
     uint64 event_id;
     auto seq_no = binlog_->next_event_id();
@@ -170,6 +174,7 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
     VLOG(binlog) << "Remove value of key " << key << ", which is " << hex_encode(it->second.first);
     uint64 event_id = it->second.second;
     map_.erase(it);
+    on_map_changed();
     auto seq_no = binlog_->next_event_id();
     lock.reset();
     add_event(seq_no, BinlogEvent::create_raw(event_id, BinlogEvent::ServiceTypes::Empty, BinlogEvent::Flags::Rewrite,
@@ -190,6 +195,7 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
     if (log_event_ids.empty()) {
       return 0;
     }
+    on_map_changed();
     VLOG(binlog) << "Remove value of keys " << keys;
     return binlog_->erase_batch(std::move(log_event_ids));
   }
@@ -199,18 +205,38 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
   bool isset(const string &key) final {
-    auto lock = rw_mutex_.lock_read().move_as_ok();
-    return map_.count(key) > 0;
+    bool is_set = false;
+    if (read_snapshot([&](const Snapshot &snapshot) { is_set = snapshot.count(key) > 0; })) {
+      return is_set;
+    }
+    {
+      auto lock = rw_mutex_.lock_read().move_as_ok();
+      is_set = map_.count(key) > 0;
+    }
+    on_locked_read();
+    return is_set;
   }
 
   string get(const string &key) final {
-    auto lock = rw_mutex_.lock_read().move_as_ok();
-    auto it = map_.find(key);
-    if (it == map_.end()) {
-      return string();
+    string value;
+    if (read_snapshot([&](const Snapshot &snapshot) {
+          auto it = snapshot.find(key);
+          if (it != snapshot.end()) {
+            value = it->second;
+          }
+        })) {
+      return value;
+    }
+    {
+      auto lock = rw_mutex_.lock_read().move_as_ok();
+      auto it = map_.find(key);
+      if (it != map_.end()) {
+        VLOG(binlog) << "Get value of key " << key << ", which is " << hex_encode(it->second.first);
+        value = it->second.first;
+      }
     }
-    VLOG(binlog) << "Get value of key " << key << ", which is " << hex_encode(it->second.first);
-    return it->second.first;
+    on_locked_read();
+    return value;
   }
 
   void force_sync(Promise<> &&promise, const char *source) final {
@@ -259,6 +285,7 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
       }
       return false;
     });
+    on_map_changed();
     auto seq_no = binlog_->next_event_id(narrow_cast<int32>(event_ids.size()));
     lock.reset();
     for (auto event_id : event_ids) {
@@ -276,10 +303,89 @@ class BinlogKeyValue final : public KeyValueSyncInterface {
   }
 
  private:
+  // values are read without locks from an immutable snapshot of the map, which is published after enough reads
+  // since the last change and is reclaimed using EpochBasedMemoryReclamation
+  static constexpr int32 MAX_SNAPSHOT_THREAD_ID = 128;        // other threads always read values under the lock
+  static constexpr uint32 SNAPSHOT_CREATION_READ_COUNT = 64;  // the number of locked reads before a snapshot is created
+
+  using Snapshot = FlatHashMap<string, string>;
+
+  struct SnapshotState {
+    EpochBasedMemoryReclamation<Snapshot> ebmr{static_cast<size_t>(MAX_SNAPSHOT_THREAD_ID)};
+    // lockers[0] is used by writers, which are serialized by rw_mutex_, other lockers by readers with the thread ID
+    vector<typename EpochBasedMemoryReclamation<Snapshot>::Locker> lockers;
+    std::atomic<Snapshot *> snapshot{nullptr};
+    std::atomic<uint32> locked_read_count{0};
+
+    SnapshotState() {
+      lockers.reserve(MAX_SNAPSHOT_THREAD_ID);
+      for (int32 i = 0; i < MAX_SNAPSHOT_THREAD_ID; i++) {
+        lockers.push_back(ebmr.get_locker(static_cast<size_t>(i)));
+      }
+    }
+    SnapshotState(const SnapshotState &) = delete;
+    SnapshotState &operator=(const SnapshotState &) = delete;
+    SnapshotState(SnapshotState &&) = delete;
+    SnapshotState &operator=(SnapshotState &&) = delete;
+    ~SnapshotState() {
+      delete snapshot.load(std::memory_order_relaxed);
+    }
+  };
+
   FlatHashMap<string, std::pair<string, uint64>> map_;
   std::shared_ptr<BinlogT> binlog_;
   RwMutex rw_mutex_;
+  unique_ptr<SnapshotState> snapshot_state_ = make_unique<SnapshotState>();
   int32 magic_ = MAGIC;
+
+  // returns false if there is no snapshot and the value must be read under the lock
+  template <class F>
+  bool read_snapshot(F &&f) {
+    auto thread_id = get_thread_id();
+    if (thread_id <= 0 || thread_id >= MAX_SNAPSHOT_THREAD_ID) {
+      return false;
+    }
+    auto &locker = snapshot_state_->lockers[thread_id];
+    locker.lock();
+    auto *snapshot = snapshot_state_->snapshot.load(std::memory_order_acquire);
+    if (snapshot != nullptr) {
+      f(*snapshot);
+    }
+    locker.unlock();
+    return snapshot != nullptr;
+  }
+
+  void on_locked_read() {
+    auto &state = *snapshot_state_;
+    if (state.locked_read_count.fetch_add(1, std::memory_order_relaxed) + 1 != SNAPSHOT_CREATION_READ_COUNT) {
+      return;
+    }
+
+    auto lock = rw_mutex_.lock_write().move_as_ok();
+    if (state.snapshot.load(std::memory_order_relaxed) != nullptr) {
+      return;
+    }
+    auto snapshot = make_unique<Snapshot>();
+    snapshot->reserve(map_.size());
+    for (const auto &kv : map_) {
+      snapshot->emplace(kv.first, kv.second.first);
+    }
+    state.snapshot.store(snapshot.release(), std::memory_order_release);
+  }
+
+  // must be called under the write lock
+  void on_map_changed() {
+    auto &state = *snapshot_state_;
+    state.locked_read_count.store(0, std::memory_order_relaxed);
+    auto *snapshot = state.snapshot.exchange(nullptr, std::memory_order_acq_rel);
+    if (snapshot != nullptr) {
+      auto &locker = state.lockers[0];
+      locker.lock();
+      locker.retire(snapshot);
+      locker.retire();
+      locker.unlock();
+    }
+  }
 };
 
 template <>
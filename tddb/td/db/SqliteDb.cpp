@@ -14,6 +14,7 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 #include "td/utils/Timer.h"
 
 #include "sqlite/sqlite3.h"
@@ -198,11 +199,59 @@ Status SqliteDb::begin_write_transaction() {
 Status SqliteDb::commit_transaction() {
   TRY_RESULT(need_commit, raw_->on_commit());
   if (need_commit) {
-    return exec("COMMIT");
+    auto start_time = Time::now();
+    auto status = exec("COMMIT");
+    raw_->on_commit_executed(Time::now() - start_time);
+    return status;
   }
   return Status::OK();
 }
 
+SqliteDb::Statistics SqliteDb::get_statistics() const {
+  Statistics result;
+  auto get_status = [db = get_native()](int op) {
+    int current = 0;
+    int highwater = 0;
+    tdsqlite3_db_status(db, op, &current, &highwater, 0);
+    return static_cast<int32>(current);
+  };
+  result.cache_hit_count = get_status(SQLITE_DBSTATUS_CACHE_HIT);
+  result.cache_miss_count = get_status(SQLITE_DBSTATUS_CACHE_MISS);
+  result.cache_write_count = get_status(SQLITE_DBSTATUS_CACHE_WRITE);
+  result.cache_used_size = get_status(SQLITE_DBSTATUS_CACHE_USED);
+  result.commit_count = raw_->get_commit_count();
+  result.total_commit_time = raw_->get_total_commit_time();
+  result.max_commit_time = raw_->get_max_commit_time();
+  return result;
+}
+
+Status SqliteDb::set_performance_profile(const PerformanceProfile &profile) {
+  if (profile.mmap_size >= 0) {
+    TRY_STATUS(exec(PSLICE() << "PRAGMA mmap_size=" << profile.mmap_size));
+  }
+  if (profile.cache_size > 0) {
+    // negative value is interpreted by SQLite as a size in KiB
+    TRY_STATUS(exec(PSLICE() << "PRAGMA cache_size=" << -profile.cache_size));
+  }
+  if (profile.wal_autocheckpoint >= 0) {
+    TRY_STATUS(exec(PSLICE() << "PRAGMA wal_autocheckpoint=" << profile.wal_autocheckpoint));
+  }
+  return Status::OK();
+}
+
+Result<int32> SqliteDb::checkpoint_wal() {
+  CHECK(!empty());
+  int wal_page_count = 0;
+  int checkpointed_page_count = 0;
+  auto rc = tdsqlite3_wal_checkpoint_v2(raw_->db(), nullptr, SQLITE_CHECKPOINT_PASSIVE, &wal_page_count,
+                                        &checkpointed_page_count);
+  if (rc != SQLITE_OK && rc != SQLITE_BUSY) {
+    return Status::Error(PSLICE() << "WAL checkpoint of database \"" << raw_->path()
+                                  << "\" failed: " << tdsqlite3_errmsg(raw_->db()));
+  }
+  return static_cast<int32>(wal_page_count);
+}
+
 Status SqliteDb::check_encryption() {
   auto status = exec("SELECT count(*) FROM sqlite_master");
   if (status.is_ok()) {
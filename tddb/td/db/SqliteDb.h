@@ -52,6 +52,29 @@ class SqliteDb {
   Status begin_write_transaction() TD_WARN_UNUSED_RESULT;
   Status commit_transaction() TD_WARN_UNUSED_RESULT;
 
+  // statistics of the connection; must be called on the thread, which uses the connection
+  struct Statistics {
+    int32 cache_hit_count = 0;
+    int32 cache_miss_count = 0;
+    int32 cache_write_count = 0;
+    int32 cache_used_size = 0;
+    int64 commit_count = 0;
+    double total_commit_time = 0.0;
+    double max_commit_time = 0.0;
+  };
+  Statistics get_statistics() const;
+
+  // connection settings, which trade memory for speed of large databases
+  struct PerformanceProfile {
+    int64 mmap_size = -1;           // in bytes; -1 keeps the SQLite default
+    int64 cache_size = 0;           // in KiB; 0 keeps the SQLite default
+    int32 wal_autocheckpoint = -1;  // in pages; 0 disables automatic checkpoints; -1 keeps the SQLite default
+  };
+  Status set_performance_profile(const PerformanceProfile &profile) TD_WARN_UNUSED_RESULT;
+
+  // runs a passive WAL checkpoint, which never waits for readers and writers; returns number of WAL pages
+  Result<int32> checkpoint_wal();
+
   Result<int32> user_version();
   Status set_user_version(int32 version) TD_WARN_UNUSED_RESULT;
   void trace(bool flag);
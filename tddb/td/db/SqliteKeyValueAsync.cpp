@@ -11,23 +11,32 @@
 #include "td/actor/actor.h"
 
 #include "td/utils/common.h"
+#include "td/utils/misc.h"
 #include "td/utils/optional.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Time.h"
 
+#include <atomic>
+#include <memory>
+
 namespace td {
 
 class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
  public:
-  explicit SqliteKeyValueAsync(std::shared_ptr<SqliteKeyValueSafe> kv_safe, int32 scheduler_id = -1) {
-    impl_ = create_actor_on_scheduler<Impl>("KV", scheduler_id, std::move(kv_safe));
+  explicit SqliteKeyValueAsync(std::shared_ptr<SqliteKeyValueSafe> kv_safe, int32 scheduler_id = -1)
+      : statistics_(std::make_shared<WriteStatistics>()) {
+    impl_ = create_actor_on_scheduler<Impl>("KV", scheduler_id, std::move(kv_safe), statistics_);
   }
   void set(string key, string value, Promise<Unit> promise) final {
+    statistics_->query_count_.fetch_add(1, std::memory_order_relaxed);
     send_closure_later(impl_, &Impl::set, std::move(key), std::move(value), std::move(promise));
   }
   void set_all(FlatHashMap<string, string> key_values, Promise<Unit> promise) final {
+    statistics_->query_count_.fetch_add(key_values.size(), std::memory_order_relaxed);
     send_closure_later(impl_, &Impl::set_all, std::move(key_values), std::move(promise));
   }
   void erase(string key, Promise<Unit> promise) final {
+    statistics_->query_count_.fetch_add(1, std::memory_order_relaxed);
     send_closure_later(impl_, &Impl::erase, std::move(key), std::move(promise));
   }
   void erase_by_prefix(string key_prefix, Promise<Unit> promise) final {
@@ -39,11 +48,24 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
   void close(Promise<Unit> promise) final {
     send_closure_later(impl_, &Impl::close, std::move(promise));
   }
+  string get_write_statistics() const final {
+    return PSTRING() << statistics_->query_count_.load(std::memory_order_relaxed) << " write queries\t"
+                     << statistics_->row_count_.load(std::memory_order_relaxed) << " written rows\t"
+                     << statistics_->transaction_count_.load(std::memory_order_relaxed) << " transactions\t";
+  }
 
  private:
+  struct WriteStatistics {
+    std::atomic<uint64> query_count_{0};
+    std::atomic<uint64> row_count_{0};
+    std::atomic<uint64> transaction_count_{0};
+  };
+  std::shared_ptr<WriteStatistics> statistics_;
+
   class Impl final : public Actor {
    public:
-    explicit Impl(std::shared_ptr<SqliteKeyValueSafe> kv_safe) : kv_safe_(std::move(kv_safe)) {
+    Impl(std::shared_ptr<SqliteKeyValueSafe> kv_safe, std::shared_ptr<WriteStatistics> statistics)
+        : kv_safe_(std::move(kv_safe)), statistics_(std::move(statistics)) {
     }
 
     void set(string key, string value, Promise<Unit> promise) {
@@ -57,13 +79,14 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
       do_flush(false /*force*/);
     }
 
     void set_all(FlatHashMap<string, string> key_values, Promise<Unit> promise) {
       do_flush(true /*force*/);
       kv_->set_all(key_values);
+      statistics_->row_count_.fetch_add(key_values.size(), std::memory_order_relaxed);
+      statistics_->transaction_count_.fetch_add(1, std::memory_order_relaxed);
       promise.set_value(Unit());
     }
 
@@ -78,7 +101,6 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       if (promise) {
         buffer_promises_.push_back(std::move(promise));
       }
-      cnt_++;
       do_flush(false /*force*/);
     }
 
@@ -107,14 +129,26 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
    private:
     std::shared_ptr<SqliteKeyValueSafe> kv_safe_;
     SqliteKeyValue *kv_ = nullptr;
-
-    static constexpr double MAX_PENDING_QUERIES_DELAY = 0.01;
-    static constexpr size_t MAX_PENDING_QUERIES_COUNT = 100;
+    std::shared_ptr<WriteStatistics> statistics_;
+
+    // the delay is adapted to the observed commit time, so that with slow commits the actor spends most time
+    // serving reads instead of committing small transactions
+    static constexpr double MIN_PENDING_QUERIES_DELAY = 0.01;
+    static constexpr double MAX_PENDING_QUERIES_DELAY = 0.1;
+    static constexpr double COMMIT_TIME_DELAY_MULTIPLIER = 3.0;
+    // repeated writes of the same key are merged in buffer_, so only the number of different keys is limited
+    static constexpr size_t MAX_PENDING_KEYS_COUNT = 1000;
     FlatHashMap<string, optional<string>> buffer_;
     vector<Promise<Unit>> buffer_promises_;
-    size_t cnt_ = 0;
 
     double wakeup_at_ = 0;
+    double average_commit_time_ = 0;
+
+    double get_pending_queries_delay() const {
+      return clamp(average_commit_time_ * COMMIT_TIME_DELAY_MULTIPLIER, MIN_PENDING_QUERIES_DELAY,
+                   MAX_PENDING_QUERIES_DELAY);
+    }
+
     void do_flush(bool force) {
       if (buffer_.empty()) {
         return;
@@ -123,17 +157,17 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
       if (!force) {
         auto now = Time::now_cached();
         if (wakeup_at_ == 0) {
-          wakeup_at_ = now + MAX_PENDING_QUERIES_DELAY;
+          wakeup_at_ = now + get_pending_queries_delay();
         }
-        if (now < wakeup_at_ && cnt_ < MAX_PENDING_QUERIES_COUNT) {
+        if (now < wakeup_at_ && buffer_.size() < MAX_PENDING_KEYS_COUNT) {
           set_timeout_at(wakeup_at_);
           return;
         }
       }
 
       wakeup_at_ = 0;
-      cnt_ = 0;
 
+      auto start_time = Time::now();
       kv_->begin_write_transaction().ensure();
       for (auto &it : buffer_) {
         if (it.second) {
@@ -143,6 +177,10 @@ class SqliteKeyValueAsync final : public SqliteKeyValueAsyncInterface {
         }
       }
       kv_->commit_transaction().ensure();
+      auto commit_time = Time::now() - start_time;
+      average_commit_time_ = average_commit_time_ * 0.8 + commit_time * 0.2;
+      statistics_->row_count_.fetch_add(buffer_.size(), std::memory_order_relaxed);
+      statistics_->transaction_count_.fetch_add(1, std::memory_order_relaxed);
       buffer_.clear();
       set_promises(buffer_promises_);
     }
@@ -31,6 +31,9 @@ class SqliteKeyValueAsyncInterface {
   virtual void get(string key, Promise<string> promise) = 0;
 
   virtual void close(Promise<Unit> promise) = 0;
+
+  // returns numbers of requested writes, written rows and write transactions
+  virtual string get_write_statistics() const = 0;
 };
 
 unique_ptr<SqliteKeyValueAsyncInterface> create_sqlite_key_value_async(std::shared_ptr<SqliteKeyValueSafe> kv,
@@ -8,11 +8,18 @@
 
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/StackAllocator.h"
 #include "td/utils/StringBuilder.h"
+#include "td/utils/Time.h"
 
 #include "sqlite/sqlite3.h"
 
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+
 namespace td {
 
 int VERBOSITY_NAME(sqlite) = VERBOSITY_NAME(DEBUG) + 10;
@@ -50,9 +57,64 @@ int printExplainQueryPlan(StringBuilder &sb, tdsqlite3_stmt *pStmt) {
 }
 }  // namespace
 
+struct SqliteStatement::StepStatistics {
+  std::atomic<int64> step_count{0};
+  std::atomic<int64> step_time{0};  // in microseconds
+};
+
+struct SqliteStatement::StepStatisticsStorage {
+  static constexpr size_t MAX_STATEMENT_COUNT = 1000;  // statements with dynamic SQL text must not consume all memory
+
+  std::mutex mutex;
+  std::map<string, unique_ptr<StepStatistics>, std::less<>> statistics;
+};
+
+SqliteStatement::StepStatisticsStorage &SqliteStatement::get_step_statistics_storage() {
+  static StepStatisticsStorage *storage = new StepStatisticsStorage();  // must outlive all statements
+  return *storage;
+}
+
+SqliteStatement::StepStatistics *SqliteStatement::get_step_statistics(Slice sql) {
+  auto &storage = get_step_statistics_storage();
+  std::lock_guard<std::mutex> lock(storage.mutex);
+  auto it = storage.statistics.find(sql);
+  if (it != storage.statistics.end()) {
+    return it->second.get();
+  }
+  if (storage.statistics.size() >= StepStatisticsStorage::MAX_STATEMENT_COUNT) {
+    return nullptr;
+  }
+  auto &statistics = storage.statistics[sql.str()];
+  statistics = td::make_unique<StepStatistics>();
+  return statistics.get();
+}
+
+vector<SqliteStatement::Statistics> SqliteStatement::get_statistics() {
+  vector<Statistics> result;
+  {
+    auto &storage = get_step_statistics_storage();
+    std::lock_guard<std::mutex> lock(storage.mutex);
+    for (auto &it : storage.statistics) {
+      Statistics statistics;
+      statistics.sql = it.first;
+      statistics.step_count = it.second->step_count.load(std::memory_order_relaxed);
+      statistics.step_time = static_cast<double>(it.second->step_time.load(std::memory_order_relaxed)) * 1e-6;
+      result.push_back(std::move(statistics));
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const Statistics &lhs, const Statistics &rhs) {
+    if (lhs.step_time != rhs.step_time) {
+      return lhs.step_time > rhs.step_time;
+    }
+    return lhs.sql < rhs.sql;
+  });
+  return result;
+}
+
 SqliteStatement::SqliteStatement(tdsqlite3_stmt *stmt, std::shared_ptr<detail::RawSqliteDb> db)
     : stmt_(stmt), db_(std::move(db)) {
   CHECK(stmt != nullptr);
+  step_statistics_ = get_step_statistics(CSlice(tdsqlite3_sql(stmt)));
 }
 SqliteStatement::~SqliteStatement() = default;
 
@@ -174,13 +236,31 @@ void SqliteStatement::reset() {
   state_ = State::Start;
 }
 
+std::atomic<double> SqliteStatement::slow_step_threshold_{0.0};
+
+void SqliteStatement::set_slow_step_threshold(double threshold) {
+  slow_step_threshold_.store(threshold, std::memory_order_relaxed);
+}
+
 Status SqliteStatement::step() {
   if (state_ == State::Finish) {
     return Status::Error("One has to reset statement");
   }
   VLOG(sqlite) << "Start step " << tag("query", tdsqlite3_sql(stmt_.get())) << tag("statement", stmt_.get())
                << tag("database", db_.get());
+  static auto *step_counter = MetricsRegistry::get_counter("td_sqlite_statement_steps_total");
+  step_counter->add(1);
+  auto slow_step_threshold = slow_step_threshold_.load(std::memory_order_relaxed);
+  auto start_time = Time::now();
   auto rc = tdsqlite3_step(stmt_.get());
+  auto duration = Time::now() - start_time;
+  if (step_statistics_ != nullptr) {
+    step_statistics_->step_count.fetch_add(1, std::memory_order_relaxed);
+    step_statistics_->step_time.fetch_add(static_cast<int64>(duration * 1e6), std::memory_order_relaxed);
+  }
+  if (slow_step_threshold > 0.0 && duration >= slow_step_threshold) {
+    LOG(WARNING) << "Slow SQLite step in " << duration << " seconds: " << tdsqlite3_sql(stmt_.get());
+  }
   VLOG(sqlite) << "Finish step with response " << (rc == SQLITE_ROW ? "ROW" : (rc == SQLITE_DONE ? "DONE" : "ERROR"));
   if (rc == SQLITE_ROW) {
     state_ = State::HaveRow;
@@ -14,6 +14,7 @@
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
+#include <atomic>
 #include <memory>
 
 struct tdsqlite3;
@@ -47,6 +48,19 @@ class SqliteStatement {
 
   Result<string> explain();
 
+  // steps taking at least the specified number of seconds are logged; a non-positive threshold disables the log
+  static void set_slow_step_threshold(double threshold);
+
+  struct Statistics {
+    string sql;
+    int64 step_count = 0;
+    double step_time = 0.0;
+  };
+
+  // returns step statistics of statements with the same SQL text prepared in the process,
+  // sorted by decreasing total step time
+  static vector<Statistics> get_statistics();
+
   bool can_step() const {
     return state_ != State::Finish;
   }
@@ -82,6 +96,16 @@ class SqliteStatement {
   std::unique_ptr<tdsqlite3_stmt, StmtDeleter> stmt_;
   std::shared_ptr<detail::RawSqliteDb> db_;
 
+  struct StepStatistics;
+  StepStatistics *step_statistics_ = nullptr;
+
+  static std::atomic<double> slow_step_threshold_;
+
+  struct StepStatisticsStorage;
+  static StepStatisticsStorage &get_step_statistics_storage();
+
+  static StepStatistics *get_step_statistics(Slice sql);
+
   Status last_error();
 };
 
@@ -11,16 +11,27 @@
 #include "td/db/binlog/BinlogHelper.h"
 #include "td/db/binlog/BinlogInterface.h"
 
+#include "td/utils/as.h"
+#include "td/utils/buffer.h"
+#include "td/utils/crypto.h"
+#include "td/utils/EpochBasedMemoryReclamation.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/PathView.h"
+#include "td/utils/port/MemoryMapping.h"
+#include "td/utils/port/path.h"
 #include "td/utils/Random.h"
+#include "td/utils/ScopeGuard.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/StorerBase.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_storers.h"
 
+#include <algorithm>
+#include <atomic>
 #include <set>
 
 namespace td {
@@ -88,6 +99,25 @@ class TQueueImpl final : public TQueue {
   static constexpr size_t MAX_TOTAL_EVENT_LENGTH = 1 << 27;
 
  public:
+  TQueueImpl() = default;
+  TQueueImpl(const TQueueImpl &) = delete;
+  TQueueImpl &operator=(const TQueueImpl &) = delete;
+  TQueueImpl(TQueueImpl &&) = delete;
+  TQueueImpl &operator=(TQueueImpl &&) = delete;
+  ~TQueueImpl() final {
+    if (concurrent_state_ == nullptr) {
+      return;
+    }
+    for (auto &it : queues_) {
+      if (it.second.concurrent_queue != nullptr) {
+        for (auto &event_it : it.second.concurrent_queue->events) {
+          delete event_it.second;
+        }
+      }
+    }
+    delete concurrent_state_->table.load();
+  }
+
   void set_callback(unique_ptr<StorageCallback> callback) final {
     callback_ = std::move(callback);
   }
@@ -95,6 +125,24 @@ class TQueueImpl final : public TQueue {
     return std::move(callback_);
   }
 
+  void enable_concurrent_reads(size_t max_reader_count) final {
+    CHECK(concurrent_state_ == nullptr);
+    CHECK(queues_.empty());
+    concurrent_state_ = make_unique<ConcurrentState>(max_reader_count);
+  }
+
+  unique_ptr<ConcurrentReader> create_concurrent_reader() final {
+    CHECK(concurrent_state_ != nullptr);
+    auto &reader_slots = concurrent_state_->reader_slots;
+    for (size_t i = 0; i < reader_slots.size(); i++) {
+      bool is_used = false;
+      if (reader_slots[i].compare_exchange_strong(is_used, true)) {
+        return make_unique<ConcurrentReaderImpl>(concurrent_state_.get(), i);
+      }
+    }
+    return nullptr;
+  }
+
   bool do_push(QueueId queue_id, RawEvent &&raw_event) final {
     CHECK(raw_event.event_id.is_valid());
     // raw_event.data can be empty when replaying binlog
@@ -118,6 +166,7 @@ class TQueueImpl final : public TQueue {
         if (callback_ != nullptr && it->second.log_event_id != 0) {
           callback_->pop(it->second.log_event_id);
         }
+        on_concurrent_event_deleted(q, it->first);
         q.events.erase(it);
       }
     }
@@ -130,7 +179,8 @@ class TQueueImpl final : public TQueue {
     }
     q.tail_id = event_id.next().move_as_ok();
     q.total_event_length += raw_event.data.size();
-    q.events.emplace(event_id, std::move(raw_event));
+    auto it = q.events.emplace(event_id, std::move(raw_event)).first;
+    on_concurrent_event_added(queue_id, q, it->second);
     return true;
   }
 
@@ -262,6 +312,12 @@ class TQueueImpl final : public TQueue {
     }
     auto callback_clear_time = Time::now() - start_time;
 
+    if (concurrent_state_ != nullptr) {
+      for (auto it = q.events.begin(); it != end_it; ++it) {
+        on_concurrent_event_deleted(q, it->first);
+      }
+    }
+
     std::map<EventId, RawEvent> deleted_events;
     if (keep_count > size / 2) {
       for (auto it = q.events.begin(); it != end_it;) {
@@ -374,16 +430,215 @@ class TQueueImpl final : public TQueue {
   }
 
  private:
+  struct ConcurrentObject {
+    ConcurrentObject() = default;
+    ConcurrentObject(const ConcurrentObject &) = delete;
+    ConcurrentObject &operator=(const ConcurrentObject &) = delete;
+    ConcurrentObject(ConcurrentObject &&) = delete;
+    ConcurrentObject &operator=(ConcurrentObject &&) = delete;
+    virtual ~ConcurrentObject() = default;
+  };
+
+  // immutable copy of an event, which can be read by concurrent readers
+  struct ConcurrentEvent final : public ConcurrentObject {
+    EventId event_id;
+    int32 expires_at{0};
+    string data;
+    int64 extra{0};
+    std::atomic<ConcurrentEvent *> next{nullptr};
+    ConcurrentEvent *prev{nullptr};  // accessed only by the queue owner
+  };
+
+  // list of events of a queue; deleted events are unlinked and freed after all readers stopped using them
+  struct ConcurrentQueue {
+    std::atomic<ConcurrentEvent *> head{nullptr};
+    ConcurrentEvent *last{nullptr};
+    FlatHashMap<int32, ConcurrentEvent *> events;  // accessed only by the queue owner
+  };
+
+  // immutable table of all queues, which is replaced whenever a new queue is created
+  struct ConcurrentQueueTable final : public ConcurrentObject {
+    FlatHashMap<QueueId, ConcurrentQueue *> queues;
+  };
+
+  struct ConcurrentState {
+    // the first thread slot is used by the queue owner
+    explicit ConcurrentState(size_t max_reader_count)
+        : ebmr(max_reader_count + 1), reader_slots(max_reader_count), owner_locker(ebmr.get_locker(0)) {
+    }
+
+    EpochBasedMemoryReclamation<ConcurrentObject> ebmr;
+    vector<std::atomic<bool>> reader_slots;
+    EpochBasedMemoryReclamation<ConcurrentObject>::Locker owner_locker;
+    std::atomic<ConcurrentQueueTable *> table{nullptr};
+    size_t retired_object_count = 0;
+  };
+
+  class ConcurrentReaderImpl final : public ConcurrentReader {
+    using Locker = EpochBasedMemoryReclamation<ConcurrentObject>::Locker;
+
+   public:
+    ConcurrentReaderImpl(ConcurrentState *state, size_t slot)
+        : state_(state), slot_(slot), locker_(make_unique<Locker>(state->ebmr.get_locker(slot + 1))) {
+    }
+    ConcurrentReaderImpl(const ConcurrentReaderImpl &) = delete;
+    ConcurrentReaderImpl &operator=(const ConcurrentReaderImpl &) = delete;
+    ConcurrentReaderImpl(ConcurrentReaderImpl &&) = delete;
+    ConcurrentReaderImpl &operator=(ConcurrentReaderImpl &&) = delete;
+    ~ConcurrentReaderImpl() final {
+      locker_ = nullptr;
+      state_->reader_slots[slot_] = false;
+    }
+
+    void get(QueueId queue_id, EventId from_id, int32 unix_time_now, size_t limit,
+             vector<RawEvent> &result_events) final {
+      result_events.clear();
+      locker_->lock();
+      SCOPE_EXIT {
+        locker_->unlock();
+      };
+      auto table = state_->table.load(std::memory_order_acquire);
+      if (table == nullptr) {
+        return;
+      }
+      auto it = table->queues.find(queue_id);
+      if (it == table->queues.end()) {
+        return;
+      }
+      for (auto event = it->second->head.load(std::memory_order_acquire);
+           event != nullptr && result_events.size() < limit; event = event->next.load(std::memory_order_acquire)) {
+        if (event->event_id < from_id || event->expires_at < unix_time_now || event->data.empty()) {
+          continue;
+        }
+        RawEvent raw_event;
+        raw_event.event_id = event->event_id;
+        raw_event.expires_at = event->expires_at;
+        raw_event.data = event->data;
+        raw_event.extra = event->extra;
+        result_events.push_back(std::move(raw_event));
+      }
+    }
+
+   private:
+    ConcurrentState *state_;
+    size_t slot_;
+    unique_ptr<Locker> locker_;
+  };
+
   struct Queue {
     EventId tail_id;
     std::map<EventId, RawEvent> events;
     size_t total_event_length = 0;
     int32 gc_at = 0;
+    unique_ptr<ConcurrentQueue> concurrent_queue;
   };
 
   FlatHashMap<QueueId, Queue> queues_;
   std::set<std::pair<int32, QueueId>> queue_gc_at_;
   unique_ptr<StorageCallback> callback_;
+  unique_ptr<ConcurrentState> concurrent_state_;
+
+  void retire_concurrent_object(ConcurrentObject *object) {
+    auto &locker = concurrent_state_->owner_locker;
+    locker.retire(object);
+    if (++concurrent_state_->retired_object_count % 64 == 0) {
+      // free objects, which aren't used by readers anymore
+      locker.retire();
+      locker.unlock();
+    }
+  }
+
+  static ConcurrentEvent *create_concurrent_event(const RawEvent &raw_event) {
+    auto event = make_unique<ConcurrentEvent>();
+    event->event_id = raw_event.event_id;
+    event->expires_at = raw_event.expires_at;
+    event->data = raw_event.data;
+    event->extra = raw_event.extra;
+    return event.release();
+  }
+
+  // replaces event in the list with new_event, which is either the next event or a new event linked to the next event
+  static void replace_concurrent_event(ConcurrentQueue &cq, ConcurrentEvent *event, ConcurrentEvent *new_event) {
+    auto prev = event->prev;
+    auto next = event->next.load(std::memory_order_relaxed);
+    auto new_prev = new_event == next ? prev : new_event;
+    if (next != nullptr) {
+      next->prev = new_prev;
+    } else {
+      cq.last = new_prev;
+    }
+    if (new_event != next) {
+      new_event->prev = prev;
+    }
+    if (prev != nullptr) {
+      prev->next.store(new_event, std::memory_order_release);
+    } else {
+      cq.head.store(new_event, std::memory_order_release);
+    }
+  }
+
+  void on_concurrent_event_added(QueueId queue_id, Queue &q, const RawEvent &raw_event) {
+    if (concurrent_state_ == nullptr) {
+      return;
+    }
+    if (q.concurrent_queue == nullptr) {
+      q.concurrent_queue = make_unique<ConcurrentQueue>();
+      auto old_table = concurrent_state_->table.load(std::memory_order_relaxed);
+      auto new_table = make_unique<ConcurrentQueueTable>();
+      if (old_table != nullptr) {
+        for (auto &it : old_table->queues) {
+          new_table->queues.emplace(it.first, it.second);
+        }
+      }
+      new_table->queues.emplace(queue_id, q.concurrent_queue.get());
+      concurrent_state_->table.store(new_table.release(), std::memory_order_release);
+      if (old_table != nullptr) {
+        retire_concurrent_object(old_table);
+      }
+    }
+
+    auto &cq = *q.concurrent_queue;
+    auto event = create_concurrent_event(raw_event);
+    event->prev = cq.last;
+    bool is_inserted = cq.events.emplace(raw_event.event_id.value(), event).second;
+    CHECK(is_inserted);
+    if (cq.last == nullptr) {
+      cq.head.store(event, std::memory_order_release);
+    } else {
+      cq.last->next.store(event, std::memory_order_release);
+    }
+    cq.last = event;
+  }
+
+  void on_concurrent_event_deleted(Queue &q, EventId event_id) {
+    if (concurrent_state_ == nullptr) {
+      return;
+    }
+    CHECK(q.concurrent_queue != nullptr);
+    auto &cq = *q.concurrent_queue;
+    auto it = cq.events.find(event_id.value());
+    CHECK(it != cq.events.end());
+    auto event = it->second;
+    cq.events.erase(it);
+    replace_concurrent_event(cq, event, event->next.load(std::memory_order_relaxed));
+    retire_concurrent_object(event);
+  }
+
+  void on_concurrent_event_data_cleared(Queue &q, const RawEvent &raw_event) {
+    if (concurrent_state_ == nullptr) {
+      return;
+    }
+    CHECK(q.concurrent_queue != nullptr);
+    auto &cq = *q.concurrent_queue;
+    auto it = cq.events.find(raw_event.event_id.value());
+    CHECK(it != cq.events.end());
+    auto event = it->second;
+    auto new_event = create_concurrent_event(raw_event);
+    new_event->next.store(event->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    replace_concurrent_event(cq, event, new_event);
+    it->second = new_event;
+    retire_concurrent_object(event);
+  }
 
   static EventId get_queue_head(const Queue &q) {
     if (q.events.empty()) {
@@ -419,14 +674,16 @@ class TQueueImpl final : public TQueue {
     }
   }
 
-  static void remove_event(Queue &q, std::map<EventId, RawEvent>::iterator &it) {
+  void remove_event(Queue &q, std::map<EventId, RawEvent>::iterator &it) {
     q.total_event_length -= it->second.data.size();
+    on_concurrent_event_deleted(q, it->first);
     it = q.events.erase(it);
   }
 
-  static void clear_event_data(Queue &q, RawEvent &event) {
+  void clear_event_data(Queue &q, RawEvent &event) {
     q.total_event_length -= event.data.size();
     event.data = {};
+    on_concurrent_event_data_cleared(q, event);
   }
 
   void do_get(QueueId queue_id, Queue &q, EventId from_id, bool forget_previous, int32 unix_time_now,
@@ -605,6 +862,266 @@ void TQueueMemoryStorage::close(Promise<> promise) {
   promise.set_value({});
 }
 
+TQueueSegmentStorage::~TQueueSegmentStorage() = default;
+
+uint64 TQueueSegmentStorage::get_record_location(uint32 segment_id, uint32 record_index) {
+  return (static_cast<uint64>(segment_id) << 32) | (static_cast<uint64>(record_index) + 1);
+}
+
+string TQueueSegmentStorage::get_segment_path(uint32 segment_id, Slice extension) const {
+  return PSTRING() << directory_ << TD_DIR_SLASH << "segment" << segment_id << '.' << extension;
+}
+
+Status TQueueSegmentStorage::open_segment(uint32 segment_id, Segment &segment) const {
+  TRY_RESULT_ASSIGN(segment.data_fd,
+                    FileFd::open(get_segment_path(segment_id, "data"), FileFd::Read | FileFd::Write | FileFd::Create));
+  TRY_RESULT_ASSIGN(segment.index_fd,
+                    FileFd::open(get_segment_path(segment_id, "index"), FileFd::Read | FileFd::Write | FileFd::Create));
+  return Status::OK();
+}
+
+Status TQueueSegmentStorage::replay(string directory, TQueue &q) {
+  CHECK(segments_.empty());
+  directory_ = std::move(directory);
+  TRY_STATUS(mkdir(directory_));
+
+  vector<uint32> segment_ids;
+  TRY_STATUS(walk_path(directory_, [&](CSlice path, WalkPath::Type type) {
+    if (type == WalkPath::Type::EnterDir) {
+      return path == directory_ ? WalkPath::Action::Continue : WalkPath::Action::SkipDir;
+    }
+    PathView path_view(path);
+    if (type == WalkPath::Type::RegularFile && path_view.extension() == "data" &&
+        begins_with(path_view.file_stem(), "segment")) {
+      auto r_segment_id = to_integer_safe<uint32>(path_view.file_stem().substr(7));
+      if (r_segment_id.is_ok() && r_segment_id.ok() != 0) {
+        segment_ids.push_back(r_segment_id.ok());
+      }
+    }
+    return WalkPath::Action::Continue;
+  }));
+  std::sort(segment_ids.begin(), segment_ids.end());
+
+  // the last event of each queue and whether its data is empty
+  FlatHashMap<QueueId, std::pair<uint64, bool>> last_events;
+  for (auto segment_id : segment_ids) {
+    TRY_STATUS(replay_segment(segment_id, q, last_events));
+  }
+
+  create_current_segment(segment_ids.empty() ? 1 : segment_ids.back() + 1);
+  vector<uint32> empty_segment_ids;
+  for (auto &it : segments_) {
+    if (it.second.live_record_count == 0 && it.first != current_segment_id_) {
+      empty_segment_ids.push_back(it.first);
+    }
+  }
+  for (auto segment_id : empty_segment_ids) {
+    delete_segment(segment_id);
+  }
+  return Status::OK();
+}
+
+Status TQueueSegmentStorage::replay_segment(uint32 segment_id, TQueue &q,
+                                            FlatHashMap<QueueId, std::pair<uint64, bool>> &last_events) {
+  auto &segment = segments_[segment_id];
+  TRY_STATUS(open_segment(segment_id, segment));
+  // the segment must not be deleted until it is completely replayed
+  current_segment_id_ = segment_id;
+
+  TRY_RESULT(data_size, segment.data_fd.get_size());
+  TRY_RESULT(index_size, segment.index_fd.get_size());
+  if (data_size == 0) {
+    return Status::OK();
+  }
+  TRY_RESULT(data_mapping, MemoryMapping::create_from_file(segment.data_fd));
+  // non-zero bytes of the index mark deleted records
+  Result<MemoryMapping> r_index_mapping = Status::Error("Index is empty");
+  Slice index;
+  if (index_size > 0) {
+    r_index_mapping = MemoryMapping::create_from_file(segment.index_fd);
+    if (r_index_mapping.is_error()) {
+      return r_index_mapping.move_as_error();
+    }
+    index = r_index_mapping.ok().as_slice();
+  }
+
+  auto data = data_mapping.as_slice();
+  size_t offset = 0;
+  while (data.size() - offset >= RECORD_HEADER_SIZE) {
+    auto size = as<uint32>(data.begin() + offset);
+    auto crc = as<uint32>(data.begin() + offset + 4);
+    if (data.size() - offset - RECORD_HEADER_SIZE < size) {
+      break;
+    }
+    auto payload = data.substr(offset + RECORD_HEADER_SIZE, size);
+    if (crc32(payload) != crc) {
+      break;
+    }
+
+    auto record_index = segment.record_count;
+    auto location = get_record_location(segment_id, record_index);
+    offset += RECORD_HEADER_SIZE + size;
+    segment.record_count++;
+    segment.live_record_count++;
+    if (record_index < index.size() && index[record_index] != 0) {
+      segment.live_record_count--;
+      continue;
+    }
+
+    TlParser parser(payload);
+    auto has_extra = parser.fetch_int();
+    TQueueLogEvent log_event;
+    log_event.parse(parser, has_extra);
+    parser.fetch_end();
+    auto r_event_id = EventId::from_int32(log_event.event_id);
+    if (parser.get_error() != nullptr || r_event_id.is_error()) {
+      LOG(ERROR) << "Failed to parse TQueue event in segment " << segment_id;
+      delete_record(location);
+      continue;
+    }
+
+    RawEvent raw_event;
+    raw_event.log_event_id = location;
+    raw_event.event_id = r_event_id.move_as_ok();
+    raw_event.expires_at = log_event.expires_at;
+    raw_event.data = log_event.data.str();
+    raw_event.extra = log_event.extra;
+    bool is_empty = raw_event.data.empty();
+
+    auto &last_event = last_events[log_event.queue_id];
+    if (!q.do_push(log_event.queue_id, std::move(raw_event))) {
+      delete_record(location);
+      continue;
+    }
+    if (last_event.first != 0 && last_event.second) {
+      // TQueue deletes the last event with empty data after a new event is added to the queue
+      delete_record(last_event.first);
+    }
+    last_event = {location, is_empty};
+  }
+  if (offset != data.size()) {
+    LOG(WARNING) << "Ignore last " << data.size() - offset << " bytes in TQueue segment " << segment_id;
+  }
+  segment.data_size = static_cast<int64>(data.size());
+  return Status::OK();
+}
+
+void TQueueSegmentStorage::create_current_segment(uint32 segment_id) {
+  CHECK(segments_.count(segment_id) == 0);
+  auto old_segment_id = current_segment_id_;
+  auto &segment = segments_[segment_id];
+  open_segment(segment_id, segment).ensure();
+  segment.data_fd.truncate_to_current_position(0).ensure();
+  segment.index_fd.truncate_to_current_position(0).ensure();
+  current_segment_id_ = segment_id;
+
+  auto it = segments_.find(old_segment_id);
+  if (it != segments_.end() && it->second.live_record_count == 0) {
+    delete_segment(old_segment_id);
+  }
+}
+
+uint64 TQueueSegmentStorage::append_record(QueueId queue_id, const RawEvent &event) {
+  TQueueLogEvent log_event;
+  log_event.queue_id = queue_id;
+  log_event.event_id = event.event_id.value();
+  log_event.expires_at = event.expires_at;
+  log_event.data = event.data;
+  log_event.extra = event.extra;
+
+  auto payload_size = 4 + log_event.size();
+  BufferSlice record(RECORD_HEADER_SIZE + payload_size);
+  auto payload = record.as_mutable_slice().substr(RECORD_HEADER_SIZE);
+  TlStorerUnsafe storer(payload.ubegin());
+  storer.store_int(log_event.extra != 0);
+  log_event.store(storer);
+  CHECK(storer.get_buf() == payload.uend());
+  as<uint32>(record.as_mutable_slice().begin()) = narrow_cast<uint32>(payload_size);
+  as<uint32>(record.as_mutable_slice().begin() + 4) = crc32(payload);
+
+  auto *segment = &segments_[current_segment_id_];
+  if (segment->data_size >= MAX_SEGMENT_SIZE) {
+    create_current_segment(current_segment_id_ + 1);
+    segment = &segments_[current_segment_id_];
+  }
+  auto r_size = segment->data_fd.pwrite(record.as_slice(), segment->data_size);
+  if (r_size.is_error() || r_size.ok() != record.size()) {
+    LOG(FATAL) << "Failed to write TQueue event to segment " << current_segment_id_ << ": " << r_size.error();
+  }
+  segment->data_size += static_cast<int64>(record.size());
+  segment->live_record_count++;
+  return get_record_location(current_segment_id_, segment->record_count++);
+}
+
+void TQueueSegmentStorage::delete_record(uint64 location) {
+  auto segment_id = static_cast<uint32>(location >> 32);
+  auto record_index = static_cast<uint32>(location & 0xFFFFFFFF) - 1;
+  auto it = segments_.find(segment_id);
+  CHECK(it != segments_.end());
+  auto &segment = it->second;
+  CHECK(record_index < segment.record_count);
+  CHECK(segment.live_record_count > 0);
+
+  auto r_size = segment.index_fd.pwrite("\x01", record_index);
+  if (r_size.is_error()) {
+    LOG(FATAL) << "Failed to delete TQueue event from segment " << segment_id << ": " << r_size.error();
+  }
+  segment.live_record_count--;
+  if (segment.live_record_count == 0 && segment_id != current_segment_id_) {
+    delete_segment(segment_id);
+  }
+}
+
+void TQueueSegmentStorage::delete_segment(uint32 segment_id) {
+  LOG(INFO) << "Delete TQueue segment " << segment_id;
+  auto it = segments_.find(segment_id);
+  CHECK(it != segments_.end());
+  it->second.data_fd.close();
+  it->second.index_fd.close();
+  segments_.erase(it);
+  unlink(get_segment_path(segment_id, "data")).ignore();
+  unlink(get_segment_path(segment_id, "index")).ignore();
+}
+
+uint64 TQueueSegmentStorage::push(QueueId queue_id, const RawEvent &event) {
+  auto location = append_record(queue_id, event);
+  if (event.log_event_id == 0) {
+    return location;
+  }
+
+  // the event is rewritten; its identifier must not change
+  auto &moved_location = moved_events_[event.log_event_id];
+  delete_record(moved_location == 0 ? event.log_event_id : moved_location);
+  moved_location = location;
+  return event.log_event_id;
+}
+
+void TQueueSegmentStorage::pop(uint64 log_event_id) {
+  auto it = moved_events_.find(log_event_id);
+  if (it == moved_events_.end()) {
+    return delete_record(log_event_id);
+  }
+  auto location = it->second;
+  moved_events_.erase(it);
+  delete_record(location);
+}
+
+void TQueueSegmentStorage::close(Promise<> promise) {
+  for (auto &it : segments_) {
+    it.second.data_fd.sync().ignore();
+    it.second.index_fd.sync().ignore();
+    it.second.data_fd.close();
+    it.second.index_fd.close();
+  }
+  segments_.clear();
+  moved_events_.clear();
+  promise.set_value(Unit());
+}
+
+Status TQueueSegmentStorage::destroy(CSlice directory) {
+  return rmrf(directory);
+}
+
 void TQueue::StorageCallback::pop_batch(std::vector<uint64> log_event_ids) {
   for (auto id : log_event_ids) {
     pop(id);
@@ -7,6 +7,8 @@
 #pragma once
 
 #include "td/utils/common.h"
+#include "td/utils/FlatHashMap.h"
+#include "td/utils/port/FileFd.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Span.h"
@@ -86,6 +88,20 @@ class TQueue {
     virtual void pop_batch(std::vector<uint64> log_event_ids);
   };
 
+  class ConcurrentReader {
+   public:
+    ConcurrentReader() = default;
+    ConcurrentReader(const ConcurrentReader &) = delete;
+    ConcurrentReader &operator=(const ConcurrentReader &) = delete;
+    ConcurrentReader(ConcurrentReader &&) = delete;
+    ConcurrentReader &operator=(ConcurrentReader &&) = delete;
+    virtual ~ConcurrentReader() = default;
+
+    // replaces result_events with up to limit non-expired events with identifiers not less than from_id
+    virtual void get(QueueId queue_id, EventId from_id, int32 unix_time_now, size_t limit,
+                     vector<RawEvent> &result_events) = 0;
+  };
+
   static unique_ptr<TQueue> create();
 
   TQueue() = default;
@@ -99,6 +115,14 @@ class TQueue {
   virtual void set_callback(unique_ptr<StorageCallback> callback) = 0;
   virtual unique_ptr<StorageCallback> extract_callback() = 0;
 
+  // allows to read events from up to max_reader_count other threads concurrently with the queue owner
+  // must be called before the first event is added to the queue
+  virtual void enable_concurrent_reads(size_t max_reader_count) = 0;
+
+  // returns a reader, which can be used from any single thread, or nullptr if there are too many readers
+  // the reader must be destroyed before the queue
+  virtual unique_ptr<ConcurrentReader> create_concurrent_reader() = 0;
+
   virtual bool do_push(QueueId queue_id, RawEvent &&raw_event) = 0;
 
   virtual Result<EventId> push(QueueId queue_id, string data, int32 expires_at, int64 extra, EventId hint_new_id) = 0;
@@ -154,4 +178,66 @@ class TQueueMemoryStorage final : public TQueue::StorageCallback {
   std::map<uint64, std::pair<QueueId, RawEvent>> events_;
 };
 
+// stores events in append-only segment files in a directory
+// deleted events are marked in the index file of their segment, and a segment is deleted as a whole after all its
+// events are deleted, so no per-event state is kept in memory
+class TQueueSegmentStorage final : public TQueue::StorageCallback {
+ public:
+  TQueueSegmentStorage() = default;
+  TQueueSegmentStorage(const TQueueSegmentStorage &) = delete;
+  TQueueSegmentStorage &operator=(const TQueueSegmentStorage &) = delete;
+  TQueueSegmentStorage(TQueueSegmentStorage &&) = delete;
+  TQueueSegmentStorage &operator=(TQueueSegmentStorage &&) = delete;
+  ~TQueueSegmentStorage() final;
+
+  // opens the storage and adds all stored events to the queue; must be called before the storage is set as callback
+  Status replay(string directory, TQueue &q) TD_WARN_UNUSED_RESULT;
+
+  uint64 push(QueueId queue_id, const RawEvent &event) final;
+  void pop(uint64 log_event_id) final;
+  void close(Promise<> promise) final;
+
+  size_t get_segment_count() const {
+    return segments_.size();
+  }
+
+  static Status destroy(CSlice directory) TD_WARN_UNUSED_RESULT;
+
+ private:
+  static constexpr int64 MAX_SEGMENT_SIZE = 1 << 24;
+  static constexpr size_t RECORD_HEADER_SIZE = 8;
+
+  struct Segment {
+    FileFd data_fd;
+    FileFd index_fd;
+    int64 data_size = 0;
+    uint32 record_count = 0;
+    uint32 live_record_count = 0;
+  };
+
+  string directory_;
+  std::map<uint32, Segment> segments_;
+  uint32 current_segment_id_ = 0;
+
+  // new locations of rewritten events
+  FlatHashMap<uint64, uint64> moved_events_;
+
+  static uint64 get_record_location(uint32 segment_id, uint32 record_index);
+
+  string get_segment_path(uint32 segment_id, Slice extension) const;
+
+  Status open_segment(uint32 segment_id, Segment &segment) const TD_WARN_UNUSED_RESULT;
+
+  Status replay_segment(uint32 segment_id, TQueue &q,
+                        FlatHashMap<QueueId, std::pair<uint64, bool>> &last_events) TD_WARN_UNUSED_RESULT;
+
+  void create_current_segment(uint32 segment_id);
+
+  uint64 append_record(QueueId queue_id, const RawEvent &event);
+
+  void delete_record(uint64 location);
+
+  void delete_segment(uint32 segment_id);
+};
+
 }  // namespace td
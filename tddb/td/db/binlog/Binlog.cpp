@@ -10,14 +10,18 @@
 #include "td/db/binlog/detail/BinlogEventsProcessor.h"
 
 #include "td/utils/buffer.h"
+#include "td/utils/FlatHashMap.h"
 #include "td/utils/format.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/Clocks.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/MemoryMapping.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/PollFlags.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/SliceBuilder.h"
@@ -26,8 +30,101 @@
 #include "td/utils/tl_helpers.h"
 #include "td/utils/tl_parsers.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
 namespace td {
 namespace detail {
+// derived keys are shared between open binlogs in the process, which use the same key and salt
+// the cache is used only if the environment variable TDLIB_BINLOG_KEY_CACHE is set to 1 and a key is kept only
+// while a binlog, which derived it, isn't closed and doesn't change its key
+class DerivedKeyCache {
+ public:
+  static bool is_enabled() {
+    static const bool is_enabled = [] {
+      const char *str = std::getenv("TDLIB_BINLOG_KEY_CACHE");
+      return str != nullptr && Slice(str) == "1";
+    }();
+    return is_enabled;
+  }
+
+  // if the cache is enabled, adds a reference to the key, which must be released with release_key
+  static string get_key(Slice secret, Slice salt, int iteration_count, size_t key_size, vector<string> &cache_keys) {
+    if (!is_enabled()) {
+      return derive_key(secret, salt, iteration_count, key_size);
+    }
+
+    auto cache_key = get_cache_key(secret, salt, iteration_count, key_size);
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto it = keys_.find(cache_key);
+      if (it != keys_.end()) {
+        it->second.ref_count_++;
+        cache_keys.push_back(std::move(cache_key));
+        return it->second.key_;
+      }
+    }
+
+    auto key = derive_key(secret, salt, iteration_count, key_size);
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto &entry = keys_[cache_key];
+    entry.key_ = key;
+    entry.ref_count_++;
+    cache_keys.push_back(std::move(cache_key));
+    return key;
+  }
+
+  static void release_keys(vector<string> &cache_keys) {
+    if (cache_keys.empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto &cache_key : cache_keys) {
+      auto it = keys_.find(cache_key);
+      CHECK(it != keys_.end());
+      if (--it->second.ref_count_ == 0) {
+        std::fill(it->second.key_.begin(), it->second.key_.end(), '\0');
+        keys_.erase(it);
+      }
+    }
+    cache_keys.clear();
+  }
+
+ private:
+  struct Entry {
+    string key_;
+    int32 ref_count_ = 0;
+  };
+
+  static string derive_key(Slice secret, Slice salt, int iteration_count, size_t key_size) {
+    string key(key_size, '\0');
+    pbkdf2_sha256(secret, salt, iteration_count, key);
+    return key;
+  }
+
+  // the hash is keyed by a random per-process secret, so cache keys can't be used to check password guesses
+  static string get_cache_key(Slice secret, Slice salt, int iteration_count, size_t key_size) {
+    static const string hash_key = [] {
+      string result(32, '\0');
+      Random::secure_bytes(result);
+      return result;
+    }();
+    string data = PSTRING() << iteration_count << ' ' << key_size << ' ' << salt.size() << ' ' << salt << secret;
+    string result(32, '\0');
+    hmac_sha256(hash_key, data, result);
+    std::fill(data.begin(), data.end(), '\0');
+    return result;
+  }
+
+  static std::mutex mutex_;
+  static FlatHashMap<string, Entry> keys_;
+};
+
+std::mutex DerivedKeyCache::mutex_;
+FlatHashMap<string, DerivedKeyCache::Entry> DerivedKeyCache::keys_;
+
 struct AesCtrEncryptionEvent {
   static constexpr size_t min_salt_size() {
     return 16;  // 256 bits
@@ -55,15 +152,14 @@ struct AesCtrEncryptionEvent {
   string iv_;
   string key_hash_;
 
-  string generate_key(const DbKey &db_key) const {
+  string generate_key(const DbKey &db_key, vector<string> &cache_keys) const {
     CHECK(!db_key.is_empty());
-    string key(key_size(), '\0');
     size_t iteration_count = kdf_iteration_count();
     if (db_key.is_raw_key()) {
       iteration_count = kdf_fast_iteration_count();
     }
-    pbkdf2_sha256(db_key.data(), key_salt_, narrow_cast<int>(iteration_count), key);
-    return key;
+    return DerivedKeyCache::get_key(db_key.data(), key_salt_, narrow_cast<int>(iteration_count), key_size(),
+                                    cache_keys);
   }
 
   static string generate_hash(Slice key) {
@@ -169,6 +265,30 @@ static int64 file_size(CSlice path) {
 
 int32 VERBOSITY_NAME(binlog) = VERBOSITY_NAME(DEBUG) + 8;
 
+struct Binlog::BackgroundReindex {
+  static constexpr size_t STEP_SIZE = 1 << 18;
+
+  FileFd fd_;
+  bool is_encrypted_ = false;
+  AesCtrState aes_ctr_state_;
+  string buffer_;             // events, which are ready to be written to the new file
+  uint64 next_event_id_ = 0;  // all live events with smaller identifiers are already copied
+  int64 size_ = 0;
+  uint64 event_count_ = 0;
+  double start_time_ = 0.0;
+  double busy_time_ = 0.0;
+
+  Status flush() {
+    Slice data = buffer_;
+    while (!data.empty()) {
+      TRY_RESULT(written_size, fd_.write(data));
+      data.remove_prefix(written_size);
+    }
+    buffer_.clear();
+    return Status::OK();
+  }
+};
+
 Binlog::Binlog() = default;
 
 Binlog::~Binlog() {
@@ -231,6 +351,9 @@ void Binlog::add_event(BinlogEvent &&event) {
     LOG(FATAL) << "Trying to add event with bad size " << event.public_to_string();
   }
 
+  static auto *added_event_size_counter = MetricsRegistry::get_counter("td_binlog_added_event_bytes_total");
+  added_event_size_counter->add(static_cast<int64>(event.size_));
+
   if (!events_buffer_) {
     do_add_event(std::move(event));
   } else {
@@ -239,6 +362,10 @@ void Binlog::add_event(BinlogEvent &&event) {
   lazy_flush();
 
   if (state_ == State::Run) {
+    if (background_reindex_ != nullptr) {
+      continue_background_reindex();
+      return;
+    }
     auto fd_size = fd_size_;
     if (events_buffer_) {
       fd_size += events_buffer_->size();
@@ -249,7 +376,8 @@ void Binlog::add_event(BinlogEvent &&event) {
     if (need_reindex(50000, 5) || need_reindex(100000, 4) || need_reindex(300000, 3) || need_reindex(500000, 2)) {
       LOG(INFO) << tag("fd_size", format::as_size(fd_size))
                 << tag("total events size", format::as_size(processor_->total_raw_events_size()));
-      do_reindex();
+      start_background_reindex();
+      continue_background_reindex();
     }
   }
 }
@@ -282,14 +410,22 @@ void Binlog::do_add_event(BinlogEvent &&event) {
 }
 
 Status Binlog::close(bool need_sync) {
+  detail::DerivedKeyCache::release_keys(derived_key_cache_keys_);
   if (fd_.empty()) {
     return Status::OK();
   }
   if (need_sync) {
+    if (state_ == State::Run && need_reindex_on_close()) {
+      // compact the binlog on clean close, so the next initialization replays only alive events
+      LOG(INFO) << "Reindex binlog on close: " << tag("fd_size", format::as_size(fd_size_))
+                << tag("total events size", format::as_size(processor_->total_raw_events_size()));
+      do_reindex();
+    }
     sync("close");
   } else {
     flush("close");
   }
+  cancel_background_reindex();
 
   fd_.lock(FileFd::LockFlags::Unlock, path_, 1).ensure();
   fd_.close();
@@ -299,12 +435,23 @@ Status Binlog::close(bool need_sync) {
   return Status::OK();
 }
 
+bool Binlog::need_reindex_on_close() const {
+  constexpr int64 MIN_REINDEX_ON_CLOSE_SIZE = 100000;
+  auto fd_size = fd_size_;
+  if (events_buffer_) {
+    fd_size += events_buffer_->size();
+  }
+  // more than a third of the binlog is occupied by erased or rewritten events
+  return fd_size > MIN_REINDEX_ON_CLOSE_SIZE && fd_size / 3 * 2 > processor_->total_raw_events_size();
+}
+
 void Binlog::close(Promise<> promise) {
   TRY_STATUS_PROMISE(promise, close());
   promise.set_value({});
 }
 
 void Binlog::change_key(DbKey new_db_key) {
+  detail::DerivedKeyCache::release_keys(derived_key_cache_keys_);
   db_key_ = std::move(new_db_key);
   aes_ctr_key_salt_ = string();
   do_reindex();
@@ -335,6 +482,12 @@ void Binlog::do_event(BinlogEvent &&event) {
     VLOG(binlog) << "Write binlog event: " << format::cond(state_ == State::Reindex, "[reindex] ")
                  << event.public_to_string();
     buffer_writer_.append(as_slice(event.raw_event_));
+
+    if (background_reindex_ != nullptr && (event.flags_ & BinlogEvent::Flags::Rewrite) &&
+        event.id_ < background_reindex_->next_event_id_) {
+      // the event has already been copied to the new file, so the rewrite must be copied too
+      write_background_reindex_event(as_slice(event.raw_event_));
+    }
   }
 
   if (event.type_ < 0) {
@@ -346,13 +499,13 @@ void Binlog::do_event(BinlogEvent &&event) {
       if (aes_ctr_key_salt_ == encryption_event.key_salt_) {
         key = as_slice(aes_ctr_key_).str();
       } else if (!db_key_.is_empty()) {
-        key = encryption_event.generate_key(db_key_);
+        key = encryption_event.generate_key(db_key_, derived_key_cache_keys_);
       }
 
       if (detail::AesCtrEncryptionEvent::generate_hash(key) != encryption_event.key_hash_) {
         CHECK(state_ == State::Load);
         if (!old_db_key_.is_empty()) {
-          key = encryption_event.generate_key(old_db_key_);
+          key = encryption_event.generate_key(old_db_key_, derived_key_cache_keys_);
           if (detail::AesCtrEncryptionEvent::generate_hash(key) != encryption_event.key_hash_) {
             info_.wrong_password = true;
           }
@@ -501,6 +654,106 @@ void Binlog::update_write_encryption() {
   }
 }
 
+bool Binlog::load_binlog_parallel(const Callback &debug_callback) {
+#if TD_THREAD_UNSUPPORTED
+  return false;
+#else
+  constexpr int64 MIN_FILE_SIZE = 1 << 20;
+  constexpr size_t BATCH_SIZE = 1 << 24;
+  constexpr size_t MAX_THREAD_COUNT = 8;
+
+  auto r_fd_size = fd_.get_size();
+  if (r_fd_size.is_error() || r_fd_size.ok() < MIN_FILE_SIZE) {
+    return false;
+  }
+  auto fd_size = r_fd_size.move_as_ok();
+  auto r_mapping = MemoryMapping::create_from_file(fd_);
+  if (r_mapping.is_error()) {
+    LOG(INFO) << "Failed to map binlog \"" << path_ << "\": " << r_mapping.error();
+    return false;
+  }
+  auto mapping = r_mapping.move_as_ok();
+  auto data = mapping.as_slice();
+  if (static_cast<int64>(data.size()) != fd_size) {
+    return false;
+  }
+
+  // find all events first; encrypted binlogs and binlogs with invalid event sizes are loaded sequentially
+  vector<Slice> raw_events;
+  size_t data_offset = 0;
+  while (data.size() - data_offset >= 4) {
+    auto size = static_cast<size_t>(TlParser(data.substr(data_offset, 4)).fetch_int());
+    if (size > BinlogEvent::MAX_SIZE || size < BinlogEvent::MIN_SIZE || size % 4 != 0) {
+      return false;
+    }
+    if (data.size() - data_offset < size) {
+      break;
+    }
+    auto raw_event = data.substr(data_offset, size);
+    if (TlParser(raw_event.substr(12, 4)).fetch_int() == BinlogEvent::ServiceTypes::AesCtrEncryption) {
+      return false;
+    }
+    raw_events.push_back(raw_event);
+    data_offset += size;
+  }
+
+  auto thread_count =
+      clamp(static_cast<size_t>(thread::hardware_concurrency()), static_cast<size_t>(1), MAX_THREAD_COUNT);
+  LOG(INFO) << "Load " << raw_events.size() << " events from binlog \"" << path_ << "\" of size "
+            << format::as_size(fd_size) << " using " << thread_count << " threads";
+
+  // events are parsed and validated in parallel, but are applied strictly in order
+  int64 offset = 0;
+  size_t begin = 0;
+  bool is_valid = true;
+  while (is_valid && begin < raw_events.size()) {
+    size_t end = begin;
+    size_t batch_size = 0;
+    while (end < raw_events.size() && batch_size < BATCH_SIZE) {
+      batch_size += raw_events[end].size();
+      end++;
+    }
+
+    vector<BinlogEvent> events(end - begin);
+    vector<Status> statuses(end - begin);
+    auto parse_events = [&](size_t first) {
+      for (size_t i = first; i < events.size(); i += thread_count) {
+        events[i].debug_info_ = BinlogDebugInfo{__FILE__, __LINE__};
+        events[i].init(raw_events[begin + i].str());
+        statuses[i] = events[i].validate();
+      }
+    };
+    vector<thread> threads;
+    for (size_t i = 1; i < thread_count && i < events.size(); i++) {
+      threads.emplace_back(parse_events, i);
+    }
+    parse_events(0);
+    for (auto &parse_thread : threads) {
+      parse_thread.join();
+    }
+
+    for (size_t i = 0; i < events.size(); i++) {
+      if (statuses[i].is_error()) {
+        LOG(ERROR) << statuses[i];
+        is_valid = false;
+        break;
+      }
+      offset += static_cast<int64>(events[i].raw_event_.size());
+      events[i].offset_ = offset;
+      if (debug_callback) {
+        debug_callback(events[i]);
+      }
+      do_add_event(std::move(events[i]));
+    }
+    begin = end;
+  }
+
+  // the file was read bypassing the buffered reader, so the position must be moved to the end of loaded events
+  fd_.seek(processor_->offset()).ensure();
+  return true;
+#endif
+}
+
 Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callback) {
   state_ = State::Load;
 
@@ -514,7 +767,8 @@ Status Binlog::load_binlog(const Callback &callback, const Callback &debug_callb
 
   fd_.get_poll_info().add_flags(PollFlags::Read());
   info_.wrong_password = false;
-  while (true) {
+  bool is_loaded = load_binlog_parallel(debug_callback);
+  while (!is_loaded) {
     BinlogEvent event;
     auto r_need_size = reader.read_next(&event);
     if (r_need_size.is_error()) {
@@ -616,7 +870,7 @@ void Binlog::reset_encryption() {
   if (aes_ctr_key_salt_ == event.key_salt_) {
     key = as_slice(aes_ctr_key_).str();
   } else {
-    key = event.generate_key(db_key_);
+    key = event.generate_key(db_key_, derived_key_cache_keys_);
   }
 
   event.key_hash_ = EncryptionEvent::generate_hash(key);
@@ -627,6 +881,7 @@ void Binlog::reset_encryption() {
 }
 
 void Binlog::do_reindex() {
+  cancel_background_reindex();
   flush_events_buffer(true);
   // start reindex
   CHECK(state_ == State::Run);
@@ -707,6 +962,7 @@ void Binlog::do_reindex() {
   }(PSLICE() << "Regenerate index " << tag("name", path_) << tag("time", format::as_time(finish_time - start_time))
              << tag("before_size", format::as_size(start_size)) << tag("after_size", format::as_size(finish_size))
              << tag("ratio", ratio) << tag("before_events", start_events) << tag("after_events", finish_events));
+  on_reindex_finished(finish_time - start_time, finish_time - start_time, start_size, finish_size);
 
   buffer_writer_ = ChainBufferWriter();
   buffer_reader_ = buffer_writer_.extract_reader();
@@ -718,6 +974,144 @@ void Binlog::do_reindex() {
   update_write_encryption();
 }
 
+void Binlog::start_background_reindex() {
+  CHECK(state_ == State::Run);
+  CHECK(background_reindex_ == nullptr);
+  flush_events_buffer(true);
+
+  string new_path = path_ + ".new";
+  auto r_opened_file = open_binlog(new_path, FileFd::Flags::Write | FileFd::Flags::Create | FileFd::Truncate);
+  if (r_opened_file.is_error()) {
+    LOG(ERROR) << "Can't open new binlog for regenerate: " << r_opened_file.error();
+    return;
+  }
+
+  background_reindex_ = make_unique<BackgroundReindex>();
+  background_reindex_->fd_ = r_opened_file.move_as_ok();
+  background_reindex_->start_time_ = Clocks::monotonic();
+  if (encryption_type_ == EncryptionType::AesCtr) {
+    // the new file is encrypted with the same key, but a different IV
+    detail::AesCtrEncryptionEvent event;
+    event.key_salt_ = aes_ctr_key_salt_;
+    event.iv_.resize(detail::AesCtrEncryptionEvent::iv_size());
+    Random::secure_bytes(event.iv_);
+    event.key_hash_ = detail::AesCtrEncryptionEvent::generate_hash(as_slice(aes_ctr_key_));
+
+    auto raw_event =
+        BinlogEvent::create_raw(0, BinlogEvent::ServiceTypes::AesCtrEncryption, 0, create_default_storer(event));
+    write_background_reindex_event(raw_event.as_slice());
+    background_reindex_->is_encrypted_ = true;
+    background_reindex_->aes_ctr_state_.init(as_slice(aes_ctr_key_), event.iv_);
+  }
+}
+
+bool Binlog::continue_background_reindex() {
+  if (background_reindex_ == nullptr) {
+    return false;
+  }
+  CHECK(state_ == State::Run);
+  auto start_time = Clocks::monotonic();
+  auto &reindex = *background_reindex_;
+  size_t copied_size = 0;
+  bool is_finished = true;
+  processor_->for_each_from(reindex.next_event_id_, [&](BinlogEvent &event) {
+    if (copied_size >= BackgroundReindex::STEP_SIZE) {
+      is_finished = false;
+      return false;
+    }
+    write_background_reindex_event(as_slice(event.raw_event_));
+    copied_size += event.raw_event_.size();
+    reindex.next_event_id_ = event.id_ + 1;
+    return true;
+  });
+  auto status = reindex.flush();
+  if (status.is_error()) {
+    LOG(ERROR) << "Failed to write new binlog: " << status;
+    cancel_background_reindex();
+    return false;
+  }
+  if (is_finished) {
+    if (reindex.size_ != 0) {  // must sync creation of the file if it is non-empty
+      status = reindex.fd_.sync_barrier();
+      LOG_IF(FATAL, status.is_error()) << "Failed to sync binlog: " << status;
+    }
+    reindex.busy_time_ += Clocks::monotonic() - start_time;
+    finish_background_reindex();
+    return false;
+  }
+  reindex.busy_time_ += Clocks::monotonic() - start_time;
+  return true;
+}
+
+void Binlog::write_background_reindex_event(Slice raw_event) {
+  auto &reindex = *background_reindex_;
+  auto old_size = reindex.buffer_.size();
+  reindex.buffer_.append(raw_event.begin(), raw_event.size());
+  if (reindex.is_encrypted_) {
+    MutableSlice data(&reindex.buffer_[old_size], raw_event.size());
+    reindex.aes_ctr_state_.encrypt(data, data);
+  }
+  reindex.size_ += static_cast<int64>(raw_event.size());
+  reindex.event_count_++;
+}
+
+void Binlog::finish_background_reindex() {
+  auto reindex = std::move(background_reindex_);
+  CHECK(reindex->buffer_.empty());
+  flush_events_buffer(true);
+
+  // all events written to the old file are already in the new file, so unflushed data can be dropped
+  string new_path = path_ + ".new";
+  auto status = unlink(path_);
+  LOG_IF(FATAL, status.is_error()) << "Failed to unlink old binlog: " << status;
+  fd_.close();  // now we can close old file and release the system lock
+  status = rename(new_path, path_);
+  FileFd::remove_local_lock(new_path);  // now we can release local lock for temporary file
+  LOG_IF(FATAL, status.is_error()) << "Failed to rename binlog: " << status;
+
+  auto before_size = fd_size_;
+  auto before_events = fd_events_;
+  fd_ = BufferedFdBase<FileFd>(std::move(reindex->fd_));
+  fd_size_ = reindex->size_;
+  fd_events_ = reindex->event_count_;
+  need_sync_ = false;
+  need_flush_since_ = 0;
+
+  buffer_writer_ = ChainBufferWriter();
+  buffer_reader_ = buffer_writer_.extract_reader();
+  if (reindex->is_encrypted_) {
+    aes_ctr_state_ = std::move(reindex->aes_ctr_state_);
+  }
+  update_write_encryption();
+
+  auto duration = Clocks::monotonic() - reindex->start_time_;
+  LOG(INFO) << "Regenerate index in background " << tag("name", path_) << tag("time", format::as_time(duration))
+            << tag("busy_time", format::as_time(reindex->busy_time_))
+            << tag("before_size", format::as_size(before_size)) << tag("after_size", format::as_size(fd_size_))
+            << tag("before_events", before_events) << tag("after_events", fd_events_);
+  on_reindex_finished(duration, reindex->busy_time_, before_size, fd_size_);
+}
+
+void Binlog::cancel_background_reindex() {
+  if (background_reindex_ == nullptr) {
+    return;
+  }
+  string new_path = path_ + ".new";
+  background_reindex_->fd_.close();
+  FileFd::remove_local_lock(new_path);
+  unlink(new_path).ignore();
+  background_reindex_ = nullptr;
+}
+
+void Binlog::on_reindex_finished(double duration, double busy_time, int64 before_size, int64 after_size) {
+  auto reclaimed_size = max(before_size - after_size, static_cast<int64>(0));
+  reindex_statistics_.reindex_count++;
+  reindex_statistics_.last_duration = duration;
+  reindex_statistics_.last_busy_time = busy_time;
+  reindex_statistics_.last_reclaimed_size = reclaimed_size;
+  reindex_statistics_.total_reclaimed_size += reclaimed_size;
+}
+
 string Binlog::debug_get_binlog_data(int64 begin_offset, int64 end_offset) {
   if (begin_offset > end_offset) {
     return "Begin offset is bigger than end_offset";
@@ -37,6 +37,14 @@ struct BinlogInfo {
   bool is_opened{false};
 };
 
+struct BinlogReindexStatistics {
+  int32 reindex_count{0};
+  double last_duration{0.0};   // time from the start to the end of the last reindex
+  double last_busy_time{0.0};  // time during which the last reindex blocked writing of new events
+  int64 last_reclaimed_size{0};
+  int64 total_reclaimed_size{0};
+};
+
 namespace detail {
 class BinlogReader;
 class BinlogEventsProcessor;
@@ -69,6 +77,13 @@ class Binlog {
     return last_event_id_ + 1;
   }
 
+  // identifiers of all new events will be not less than min_event_id
+  void skip_event_ids(uint64 min_event_id) {
+    if (last_event_id_ < min_event_id) {
+      last_event_id_ = min_event_id - 1;
+    }
+  }
+
   bool empty() const {
     return fd_.empty();
   }
@@ -130,6 +145,17 @@ class Binlog {
     return info_;
   }
 
+  bool is_background_reindex_in_progress() const {
+    return background_reindex_ != nullptr;
+  }
+
+  // copies next events to the new binlog file; returns true if the background reindex isn't finished yet
+  bool continue_background_reindex();
+
+  const BinlogReindexStatistics &get_reindex_statistics() const {
+    return reindex_statistics_;
+  }
+
  private:
   BufferedFdBase<FileFd> fd_;
   ChainBufferWriter buffer_writer_;
@@ -140,6 +166,7 @@ class Binlog {
   DbKey db_key_;
   bool db_key_used_ = false;
   DbKey old_db_key_;
+  vector<string> derived_key_cache_keys_;  // keys of the binlog in the process-wide cache of derived keys
   enum class EncryptionType { None, AesCtr } encryption_type_ = EncryptionType::None;
 
   // AesCtrEncryption
@@ -165,12 +192,27 @@ class Binlog {
   bool need_sync_{false};
   enum class State { Empty, Load, Reindex, Run } state_{State::Empty};
 
+  // live events are copied to the new binlog file in batches, while new events are still written to the old file
+  struct BackgroundReindex;
+  unique_ptr<BackgroundReindex> background_reindex_;
+  BinlogReindexStatistics reindex_statistics_;
+
   static Result<FileFd> open_binlog(const string &path, int32 flags);
   size_t flush_events_buffer(bool force);
   void do_add_event(BinlogEvent &&event);
   void do_event(BinlogEvent &&event);
   Status load_binlog(const Callback &callback, const Callback &debug_callback = Callback()) TD_WARN_UNUSED_RESULT;
+  // loads big unencrypted binlogs through a memory mapping, validating events in several threads;
+  // returns false if the binlog must be loaded sequentially
+  bool load_binlog_parallel(const Callback &debug_callback);
   void do_reindex();
+  bool need_reindex_on_close() const;
+
+  void start_background_reindex();
+  void write_background_reindex_event(Slice raw_event);
+  void finish_background_reindex();
+  void cancel_background_reindex();
+  void on_reindex_finished(double duration, double busy_time, int64 before_size, int64 after_size);
 
   void update_encryption(Slice key, Slice iv);
   void reset_encryption();
@@ -42,20 +42,20 @@ class BinlogInterface {
   }
 
   uint64 add(int32 type, const Storer &storer, Promise<> promise = Promise<>()) {
-    auto event_id = next_event_id();
+    auto event_id = next_event_id_by_type(type);
     add_raw_event_impl(event_id, BinlogEvent::create_raw(event_id, type, 0, storer), std::move(promise), {});
     return event_id;
   }
 
   uint64 rewrite(uint64 event_id, int32 type, const Storer &storer, Promise<> promise = Promise<>()) {
-    auto seq_no = next_event_id();
+    auto seq_no = next_event_id_by_event_id(event_id);
     add_raw_event_impl(seq_no, BinlogEvent::create_raw(event_id, type, BinlogEvent::Flags::Rewrite, storer),
                        std::move(promise), {});
     return seq_no;
   }
 
   uint64 erase(uint64 event_id, Promise<> promise = Promise<>()) {
-    auto seq_no = next_event_id();
+    auto seq_no = next_event_id_by_event_id(event_id);
     add_raw_event_impl(
         seq_no,
         BinlogEvent::create_raw(event_id, BinlogEvent::ServiceTypes::Empty, BinlogEvent::Flags::Rewrite, EmptyStorer()),
@@ -82,6 +82,16 @@ class BinlogInterface {
   virtual uint64 next_event_id(int32 shift) = 0;
 
  protected:
+  // returns identifier for a new event of the given type
+  virtual uint64 next_event_id_by_type(int32 type) {
+    return next_event_id();
+  }
+
+  // returns sequence number for a new event, which changes the event with the given identifier
+  virtual uint64 next_event_id_by_event_id(uint64 event_id) {
+    return next_event_id();
+  }
+
   virtual void close_impl(Promise<> promise) = 0;
   virtual void close_and_destroy_impl(Promise<> promise) = 0;
   virtual void add_raw_event_impl(uint64 seq_no, BufferSlice &&raw_event, Promise<> promise, BinlogDebugInfo info) = 0;
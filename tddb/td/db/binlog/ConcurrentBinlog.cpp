@@ -59,6 +59,7 @@ class BinlogActor final : public Actor {
     });
     flush_immediate_sync();
     try_flush();
+    schedule_background_reindex();
   }
 
   void force_sync(Promise<> &&promise, const char *source) {
@@ -82,6 +83,15 @@ class BinlogActor final : public Actor {
     promise.set_value(Unit());
   }
 
+  void set_sync_policy(BinlogSyncPolicy sync_policy) {
+    sync_policy_ = sync_policy;
+    if (force_sync_flag_) {
+      // apply the new policy to already waiting sync requests
+      force_sync_flag_ = false;
+      do_immediate_sync(Promise<>());
+    }
+  }
+
  private:
   unique_ptr<Binlog> binlog_;
 
@@ -92,7 +102,11 @@ class BinlogActor final : public Actor {
   bool force_sync_flag_ = false;
   bool lazy_sync_flag_ = false;
   bool flush_flag_ = false;
+  bool is_reindex_scheduled_ = false;
   double wakeup_at_ = 0;
+  double last_sync_time_ = 0;
+  double force_sync_at_ = 0;
+  BinlogSyncPolicy sync_policy_;
 
   static constexpr double FLUSH_TIMEOUT = 0.001;  // 1ms
 
@@ -108,6 +122,22 @@ class BinlogActor final : public Actor {
     }
   }
 
+  // continue background reindex after all already received events are processed
+  void schedule_background_reindex() {
+    if (!is_reindex_scheduled_ && binlog_->is_background_reindex_in_progress()) {
+      is_reindex_scheduled_ = true;
+      yield();
+    }
+  }
+
+  void loop() final {
+    if (is_reindex_scheduled_) {
+      is_reindex_scheduled_ = false;
+      binlog_->continue_background_reindex();
+      schedule_background_reindex();
+    }
+  }
+
   void do_add_raw_event(BufferSlice &&raw_event, BinlogDebugInfo info) {
     binlog_->add_raw_event(std::move(raw_event), info);
   }
@@ -137,12 +167,39 @@ class BinlogActor final : public Actor {
     if (promise) {
       sync_promises_.emplace_back(std::move(promise));
     }
-    if (!force_sync_flag_) {
-      force_sync_flag_ = true;
-      wakeup_after(0.003);
+    switch (sync_policy_.type_) {
+      case BinlogSyncPolicy::Type::PerEvent:
+        return do_sync("force_sync");
+      case BinlogSyncPolicy::Type::Grouped:
+        if (sync_policy_.max_group_size_ != 0 && sync_promises_.size() >= sync_policy_.max_group_size_) {
+          return do_sync("force_sync");
+        }
+        if (!force_sync_flag_) {
+          force_sync_flag_ = true;
+          wakeup_after(sync_policy_.delay_);
+        }
+        break;
+      case BinlogSyncPolicy::Type::Periodic:
+        if (!force_sync_flag_) {
+          force_sync_flag_ = true;
+          force_sync_at_ = max(last_sync_time_ + sync_policy_.delay_, Time::now_cached());
+          wakeup_at(force_sync_at_);
+        }
+        break;
+      default:
+        UNREACHABLE();
     }
   }
 
+  void do_sync(const char *source) {
+    lazy_sync_flag_ = false;
+    force_sync_flag_ = false;
+    force_sync_at_ = 0;
+    binlog_->sync(source);
+    last_sync_time_ = Time::now();
+    set_promises(sync_promises_);
+  }
+
   void do_lazy_sync(Promise<> &&promise) {
     if (!promise) {
       return;
@@ -155,6 +212,16 @@ class BinlogActor final : public Actor {
   }
 
   void timeout_expired() final {
+    if (force_sync_flag_ && Time::now_cached() + 1e-9 < force_sync_at_) {
+      // the periodic sync isn't due yet
+      wakeup_at_ = 0;
+      wakeup_at(force_sync_at_);
+      if (flush_flag_) {
+        flush_flag_ = false;
+        try_flush();
+      }
+      return;
+    }
     bool need_sync = lazy_sync_flag_ || force_sync_flag_;
     lazy_sync_flag_ = false;
     force_sync_flag_ = false;
@@ -162,9 +229,8 @@ class BinlogActor final : public Actor {
     flush_flag_ = false;
     wakeup_at_ = 0;
     if (need_sync) {
-      binlog_->sync("timeout_expired");
+      do_sync("timeout_expired");
       // LOG(ERROR) << "BINLOG SYNC";
-      set_promises(sync_promises_);
     } else if (need_flush) {
       try_flush();
       // LOG(ERROR) << "BINLOG FLUSH";
@@ -218,6 +284,10 @@ void ConcurrentBinlog::change_key(DbKey db_key, Promise<> promise) {
   send_closure(binlog_actor_, &detail::BinlogActor::change_key, std::move(db_key), std::move(promise));
 }
 
+void ConcurrentBinlog::set_sync_policy(BinlogSyncPolicy sync_policy) {
+  send_closure(binlog_actor_, &detail::BinlogActor::set_sync_policy, sync_policy);
+}
+
 uint64 ConcurrentBinlog::erase_batch(vector<uint64> event_ids) {
   auto shift = narrow_cast<int32>(event_ids.size());
   if (shift == 0) {
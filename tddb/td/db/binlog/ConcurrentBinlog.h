@@ -27,6 +27,29 @@ namespace detail {
 class BinlogActor;
 }  // namespace detail
 
+// defines when forced binlog syncs are performed
+struct BinlogSyncPolicy {
+  enum class Type : int32 { PerEvent, Grouped, Periodic };
+  Type type_ = Type::Grouped;
+  double delay_ = 0.003;       // maximum delay of a grouped sync or period of periodic syncs
+  size_t max_group_size_ = 0;  // number of waiting sync requests, which forces a grouped sync; 0 if unlimited
+
+  // every sync request is completed by its own sync
+  static BinlogSyncPolicy per_event() {
+    return {Type::PerEvent, 0.0, 0};
+  }
+
+  // sync requests received within the delay are completed by the same sync
+  static BinlogSyncPolicy grouped(double delay, size_t max_group_size = 0) {
+    return {Type::Grouped, delay, max_group_size};
+  }
+
+  // all sync requests are completed by syncs, which are done not more often than once in the period
+  static BinlogSyncPolicy periodic(double period) {
+    return {Type::Periodic, period, 0};
+  }
+};
+
 class ConcurrentBinlog final : public BinlogInterface {
  public:
   using Callback = std::function<void(const BinlogEvent &)>;
@@ -45,6 +68,8 @@ class ConcurrentBinlog final : public BinlogInterface {
   void force_flush() final;
   void change_key(DbKey db_key, Promise<> promise) final;
 
+  void set_sync_policy(BinlogSyncPolicy sync_policy);
+
   uint64 next_event_id() final {
     return last_event_id_.fetch_add(1, std::memory_order_relaxed);
   }
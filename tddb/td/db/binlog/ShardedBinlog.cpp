@@ -0,0 +1,172 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/db/binlog/ShardedBinlog.h"
+
+#include "td/actor/MultiPromise.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+ShardedBinlog::ShardedBinlog(std::shared_ptr<ConcurrentBinlog> main_binlog) {
+  CHECK(main_binlog != nullptr);
+  Shard shard;
+  shard.binlog_ = std::move(main_binlog);
+  shards_.push_back(std::move(shard));
+}
+
+ShardedBinlog::~ShardedBinlog() = default;
+
+uint64 ShardedBinlog::get_shard_min_event_id(size_t shard_index) {
+  CHECK(shard_index < MAX_SHARD_COUNT);
+  return (static_cast<uint64>(shard_index) << SHARD_INDEX_SHIFT) + 1;
+}
+
+void ShardedBinlog::add_shard(int32 min_type, int32 max_type, std::shared_ptr<ConcurrentBinlog> binlog) {
+  CHECK(binlog != nullptr);
+  CHECK(min_type <= max_type);
+  CHECK(shards_.size() < MAX_SHARD_COUNT);
+  for (size_t i = 1; i < shards_.size(); i++) {
+    LOG_CHECK(max_type < shards_[i].min_type_ || shards_[i].max_type_ < min_type)
+        << min_type << ' ' << max_type << ' ' << shards_[i].min_type_ << ' ' << shards_[i].max_type_;
+  }
+  Shard shard;
+  shard.min_type_ = min_type;
+  shard.max_type_ = max_type;
+  shard.binlog_ = std::move(binlog);
+  shards_.push_back(std::move(shard));
+}
+
+size_t ShardedBinlog::get_event_shard_index(uint64 event_id) const {
+  auto shard_index = static_cast<size_t>(event_id >> SHARD_INDEX_SHIFT);
+  if (shard_index >= shards_.size()) {
+    LOG(ERROR) << "Receive event " << event_id << " from an unknown binlog shard " << shard_index;
+    return shards_.size();
+  }
+  return shard_index;
+}
+
+size_t ShardedBinlog::get_type_shard_index(int32 type) const {
+  for (size_t i = 1; i < shards_.size(); i++) {
+    if (shards_[i].min_type_ <= type && type <= shards_[i].max_type_) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+uint64 ShardedBinlog::next_event_id_by_type(int32 type) {
+  return shards_[get_type_shard_index(type)].binlog_->next_event_id();
+}
+
+uint64 ShardedBinlog::next_event_id_by_event_id(uint64 event_id) {
+  auto shard_index = get_event_shard_index(event_id);
+  if (shard_index == shards_.size()) {
+    // the change will be ignored by add_raw_event_impl
+    return event_id;
+  }
+  return shards_[shard_index].binlog_->next_event_id();
+}
+
+void ShardedBinlog::add_raw_event_impl(uint64 seq_no, BufferSlice &&raw_event, Promise<> promise,
+                                       BinlogDebugInfo info) {
+  auto shard_index = get_event_shard_index(seq_no);
+  if (shard_index == shards_.size()) {
+    return promise.set_error(Status::Error(400, "Unknown binlog shard"));
+  }
+  if (raw_event.empty() && shards_.size() > 1) {
+    // lazy sync must wait for events in all shards
+    CHECK(shard_index == 0);
+    MultiPromiseActorSafe mpas{"ShardedBinlogLazySyncMultiPromiseActor"};
+    mpas.add_promise(std::move(promise));
+    auto lock = mpas.get_promise();
+    shards_[0].binlog_->add_raw_event(info, seq_no, std::move(raw_event), mpas.get_promise());
+    for (size_t i = 1; i < shards_.size(); i++) {
+      shards_[i].binlog_->lazy_sync(mpas.get_promise());
+    }
+    lock.set_value(Unit());
+    return;
+  }
+  shards_[shard_index].binlog_->add_raw_event(info, seq_no, std::move(raw_event), std::move(promise));
+}
+
+void ShardedBinlog::force_sync(Promise<> promise, const char *source) {
+  if (shards_.size() == 1) {
+    return shards_[0].binlog_->force_sync(std::move(promise), source);
+  }
+  MultiPromiseActorSafe mpas{"ShardedBinlogSyncMultiPromiseActor"};
+  mpas.add_promise(std::move(promise));
+  auto lock = mpas.get_promise();
+  for (auto &shard : shards_) {
+    shard.binlog_->force_sync(mpas.get_promise(), source);
+  }
+  lock.set_value(Unit());
+}
+
+void ShardedBinlog::force_flush() {
+  for (auto &shard : shards_) {
+    shard.binlog_->force_flush();
+  }
+}
+
+void ShardedBinlog::change_key(DbKey db_key, Promise<> promise) {
+  MultiPromiseActorSafe mpas{"ShardedBinlogChangeKeyMultiPromiseActor"};
+  mpas.add_promise(std::move(promise));
+  auto lock = mpas.get_promise();
+  for (auto &shard : shards_) {
+    shard.binlog_->change_key(db_key, mpas.get_promise());
+  }
+  lock.set_value(Unit());
+}
+
+uint64 ShardedBinlog::erase_batch(vector<uint64> event_ids) {
+  if (event_ids.empty()) {
+    return 0;
+  }
+  vector<vector<uint64>> shard_event_ids(shards_.size());
+  for (auto event_id : event_ids) {
+    auto shard_index = get_event_shard_index(event_id);
+    if (shard_index < shards_.size()) {
+      shard_event_ids[shard_index].push_back(event_id);
+    }
+  }
+  uint64 seq_no = 0;
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if (!shard_event_ids[i].empty()) {
+      auto shard_seq_no = shards_[i].binlog_->erase_batch(std::move(shard_event_ids[i]));
+      if (seq_no == 0) {
+        seq_no = shard_seq_no;
+      }
+    }
+  }
+  return seq_no;
+}
+
+void ShardedBinlog::close_impl(Promise<> promise) {
+  MultiPromiseActorSafe mpas{"ShardedBinlogCloseMultiPromiseActor"};
+  mpas.add_promise(std::move(promise));
+  auto lock = mpas.get_promise();
+  for (auto &shard : shards_) {
+    shard.binlog_->close(mpas.get_promise());
+  }
+  shards_.clear();
+  lock.set_value(Unit());
+}
+
+void ShardedBinlog::close_and_destroy_impl(Promise<> promise) {
+  MultiPromiseActorSafe mpas{"ShardedBinlogCloseAndDestroyMultiPromiseActor"};
+  mpas.add_promise(std::move(promise));
+  auto lock = mpas.get_promise();
+  for (auto &shard : shards_) {
+    shard.binlog_->close_and_destroy(mpas.get_promise());
+  }
+  shards_.clear();
+  lock.set_value(Unit());
+}
+
+}  // namespace td
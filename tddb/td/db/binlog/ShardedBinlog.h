@@ -0,0 +1,87 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/db/binlog/BinlogInterface.h"
+#include "td/db/binlog/ConcurrentBinlog.h"
+#include "td/db/DbKey.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/Promise.h"
+
+#include <memory>
+
+namespace td {
+
+// binlog, which is partitioned into several independent ConcurrentBinlog by event type ranges
+// identifiers of events and sequence numbers contain index of the shard in the high bits, so events can be rewritten
+// and erased without knowing their type; shard 0 is the main binlog, which receives events of all other types
+class ShardedBinlog final : public BinlogInterface {
+ public:
+  static constexpr size_t MAX_SHARD_COUNT = 256;
+
+  explicit ShardedBinlog(std::shared_ptr<ConcurrentBinlog> main_binlog);
+  ShardedBinlog(const ShardedBinlog &) = delete;
+  ShardedBinlog &operator=(const ShardedBinlog &) = delete;
+  ShardedBinlog(ShardedBinlog &&) = delete;
+  ShardedBinlog &operator=(ShardedBinlog &&) = delete;
+  ~ShardedBinlog() final;
+
+  // returns the minimum identifier of events in the shard; must be passed to Binlog::skip_event_ids before the shard
+  // binlog is wrapped into ConcurrentBinlog
+  static uint64 get_shard_min_event_id(size_t shard_index);
+
+  // events with types from min_type to max_type inclusive will be added to the binlog
+  void add_shard(int32 min_type, int32 max_type, std::shared_ptr<ConcurrentBinlog> binlog);
+
+  size_t get_shard_count() const {
+    return shards_.size();
+  }
+
+  const ConcurrentBinlog &get_shard(size_t shard_index) const {
+    CHECK(shard_index < shards_.size());
+    return *shards_[shard_index].binlog_;
+  }
+
+  void force_sync(Promise<> promise, const char *source) final;
+  void force_flush() final;
+  void change_key(DbKey db_key, Promise<> promise) final;
+
+  uint64 next_event_id() final {
+    return shards_[0].binlog_->next_event_id();
+  }
+  uint64 next_event_id(int32 shift) final {
+    return shards_[0].binlog_->next_event_id(shift);
+  }
+
+  uint64 erase_batch(vector<uint64> event_ids) final;
+
+ private:
+  static constexpr int32 SHARD_INDEX_SHIFT = 48;
+
+  struct Shard {
+    int32 min_type_ = 0;
+    int32 max_type_ = 0;
+    std::shared_ptr<ConcurrentBinlog> binlog_;
+  };
+  vector<Shard> shards_;
+
+  // returns shards_.size() if the event doesn't belong to any known shard
+  size_t get_event_shard_index(uint64 event_id) const;
+
+  size_t get_type_shard_index(int32 type) const;
+
+  uint64 next_event_id_by_type(int32 type) final;
+  uint64 next_event_id_by_event_id(uint64 event_id) final;
+
+  void close_impl(Promise<> promise) final;
+  void close_and_destroy_impl(Promise<> promise) final;
+  void add_raw_event_impl(uint64 seq_no, BufferSlice &&raw_event, Promise<> promise, BinlogDebugInfo info) final;
+};
+
+}  // namespace td
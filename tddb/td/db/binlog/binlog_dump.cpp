@@ -18,6 +18,7 @@
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tl_parsers.h"
 
+#include <algorithm>
 #include <map>
 
 struct Trie {
@@ -95,64 +96,112 @@ struct Trie {
 
 enum Magic { ConfigPmcMagic = 0x1f18, BinlogPmcMagic = 0x4327 };
 
+static void print_usage() {
+  LOG(PLAIN) << "Usage: binlog_dump <binlog_file_name> [--summary]";
+  LOG(PLAIN) << "  --summary  don't print every log event, print only the statistics";
+}
+
 int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    LOG(PLAIN) << "Usage: binlog_dump <binlog_file_name>";
+  if (argc < 2 || argc > 3 || (argc == 3 && td::Slice(argv[2]) != "--summary")) {
+    print_usage();
     return 1;
   }
+  bool is_summary = argc == 3;
   td::string binlog_file_name = argv[1];
   auto r_stat = td::stat(binlog_file_name);
   if (r_stat.is_error() || r_stat.ok().size_ == 0 || !r_stat.ok().is_reg_) {
     LOG(PLAIN) << "Wrong binlog file name specified";
-    LOG(PLAIN) << "Usage: binlog_dump <binlog_file_name>";
+    print_usage();
     return 1;
   }
+  auto file_size = r_stat.ok().size_;
 
   struct Info {
     std::size_t full_size = 0;
     std::size_t compressed_size = 0;
+    std::size_t full_count = 0;
+    std::size_t compressed_count = 0;
+    td::uint64 oldest_event_id = 0;
     Trie trie;
     Trie compressed_trie;
   };
   std::map<td::uint64, Info> info;
 
+  struct LiveEvent {
+    td::uint64 id;
+    td::uint64 type;
+    std::size_t size;
+  };
+  td::vector<LiveEvent> live_events;
+
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   td::Binlog binlog;
   binlog
       .init(
           binlog_file_name,
           [&](auto &event) {
-            info[0].compressed_size += event.raw_event_.size();
-            info[event.type_].compressed_size += event.raw_event_.size();
+            for (auto type : {static_cast<td::uint64>(0), static_cast<td::uint64>(event.type_)}) {
+              auto &type_info = info[type];
+              type_info.compressed_size += event.raw_event_.size();
+              type_info.compressed_count++;
+              if (type_info.oldest_event_id == 0 || event.id_ < type_info.oldest_event_id) {
+                type_info.oldest_event_id = event.id_;
+              }
+            }
             if (event.type_ == ConfigPmcMagic || event.type_ == BinlogPmcMagic) {
               auto key = td::TlParser(event.get_data()).template fetch_string<td::Slice>();
               info[event.type_].compressed_trie.add(key);
             }
+            live_events.push_back(LiveEvent{event.id_, static_cast<td::uint64>(event.type_), event.raw_event_.size()});
           },
           td::DbKey::raw_key("cucumber"), td::DbKey::empty(), -1,
           [&](auto &event) mutable {
             info[0].full_size += event.raw_event_.size();
+            info[0].full_count++;
             info[event.type_].full_size += event.raw_event_.size();
+            info[event.type_].full_count++;
             if (event.type_ == ConfigPmcMagic || event.type_ == BinlogPmcMagic) {
               auto key = td::TlParser(event.get_data()).template fetch_string<td::Slice>();
               info[event.type_].trie.add(key);
             }
-            LOG(PLAIN) << "LogEvent[" << td::tag("event_id", td::format::as_hex(event.id_))
-                       << td::tag("type", event.type_) << td::tag("flags", event.flags_)
-                       << td::tag("size", event.get_data().size())
-                       << td::tag("data", td::format::escaped(event.get_data())) << "]\n";
+            if (!is_summary) {
+              LOG(PLAIN) << "LogEvent[" << td::tag("event_id", td::format::as_hex(event.id_))
+                         << td::tag("type", event.type_) << td::tag("flags", event.flags_)
+                         << td::tag("size", event.get_data().size())
+                         << td::tag("data", td::format::escaped(event.get_data())) << "]\n";
+            }
           })
       .ensure();
 
   for (auto &it : info) {
     LOG(PLAIN) << td::tag("handler", td::format::as_hex(it.first))
                << td::tag("full_size", td::format::as_size(it.second.full_size))
-               << td::tag("compressed_size", td::format::as_size(it.second.compressed_size));
+               << td::tag("compressed_size", td::format::as_size(it.second.compressed_size))
+               << td::tag("dead_size", td::format::as_size(it.second.full_size - it.second.compressed_size))
+               << td::tag("full_count", it.second.full_count) << td::tag("live_count", it.second.compressed_count)
+               << td::tag("oldest_live_event_id", td::format::as_hex(it.second.oldest_event_id));
     it.second.trie.dump();
     if (it.second.full_size != it.second.compressed_size) {
       it.second.compressed_trie.dump();
     }
   }
 
+  // event identifiers are increasing, so the events with the smallest identifiers are the oldest
+  constexpr std::size_t MAX_OLDEST_EVENTS = 10;
+  auto oldest_count = td::min(MAX_OLDEST_EVENTS, live_events.size());
+  std::partial_sort(live_events.begin(), live_events.begin() + oldest_count, live_events.end(),
+                    [](const LiveEvent &lhs, const LiveEvent &rhs) { return lhs.id < rhs.id; });
+  for (std::size_t i = 0; i < oldest_count; i++) {
+    auto &event = live_events[i];
+    LOG(PLAIN) << "Oldest live event " << td::tag("event_id", td::format::as_hex(event.id))
+               << td::tag("handler", td::format::as_hex(event.type)) << td::tag("size", event.size);
+  }
+
+  auto live_size = info[0].compressed_size;
+  auto dead_percent = 100.0 - static_cast<double>(live_size) * 100.0 / static_cast<double>(file_size);
+  LOG(PLAIN) << td::tag("file_size", td::format::as_size(file_size))
+             << td::tag("size_after_reindex", td::format::as_size(live_size))
+             << td::tag("dead_size_percent", td::StringBuilder::FixedDouble(dead_percent, 2));
+
   return 0;
 }
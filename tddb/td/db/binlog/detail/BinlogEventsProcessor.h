@@ -12,6 +12,8 @@
 #include "td/utils/logging.h"
 #include "td/utils/Status.h"
 
+#include <algorithm>
+
 namespace td {
 namespace detail {
 
@@ -33,6 +35,17 @@ class BinlogEventsProcessor {
     }
   }
 
+  // calls callback for events with event_id >= min_event_id in increasing order of event_id, until it returns false
+  template <class CallbackT>
+  void for_each_from(uint64 min_event_id, CallbackT &&callback) {
+    auto it = std::lower_bound(event_ids_.begin(), event_ids_.end(), min_event_id * 2);
+    for (auto i = static_cast<size_t>(it - event_ids_.begin()); i < event_ids_.size(); i++) {
+      if ((event_ids_[i] & 1) == 0 && !callback(events_[i])) {
+        return;
+      }
+    }
+  }
+
   uint64 last_event_id() const {
     return last_event_id_;
   }
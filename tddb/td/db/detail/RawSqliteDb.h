@@ -59,6 +59,27 @@ class RawSqliteDb {
     return begin_cnt_ == 0;
   }
 
+  // the commit duration includes duration of the automatic WAL checkpoint if it was triggered by the commit
+  void on_commit_executed(double duration) {
+    commit_count_++;
+    total_commit_time_ += duration;
+    if (duration > max_commit_time_) {
+      max_commit_time_ = duration;
+    }
+  }
+
+  int64 get_commit_count() const {
+    return commit_count_;
+  }
+
+  double get_total_commit_time() const {
+    return total_commit_time_;
+  }
+
+  double get_max_commit_time() const {
+    return max_commit_time_;
+  }
+
   void set_cipher_version(int32 cipher_version) {
     cipher_version_ = cipher_version;
   }
@@ -71,6 +92,9 @@ class RawSqliteDb {
   tdsqlite3 *db_;
   std::string path_;
   size_t begin_cnt_{0};
+  int64 commit_count_{0};
+  double total_commit_time_{0.0};
+  double max_commit_time_{0.0};
   optional<int32> cipher_version_;
 };
 
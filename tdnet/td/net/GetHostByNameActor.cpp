@@ -144,7 +144,7 @@ void GetHostByNameActor::run(string host, int port, bool prefer_ipv6, Promise<IP
   }
 
   auto begin_time = Time::now();
-  auto &value = cache_[prefer_ipv6].emplace(ascii_host, Value{{}, begin_time - 1.0}).first->second;
+  auto &value = cache_[prefer_ipv6].emplace(ascii_host, Value{{}, begin_time - 1.0, begin_time - 1.0}).first->second;
   if (value.expires_at > begin_time) {
     return promise.set_result(value.get_ip_port(port));
   }
@@ -154,9 +154,13 @@ void GetHostByNameActor::run(string host, int port, bool prefer_ipv6, Promise<IP
     query_ptr = make_unique<Query>();
   }
   auto &query = *query_ptr;
-  query.promises.emplace_back(port, std::move(promise));
+  if (value.ip.is_ok() && value.stale_expires_at > begin_time) {
+    // return the expired IP address immediately and update it in background
+    promise.set_result(value.get_ip_port(port));
+  } else {
+    query.promises.emplace_back(port, std::move(promise));
+  }
   if (query.query.empty()) {
-    CHECK(query.promises.size() == 1);
     query.real_host = std::move(host);
     query.begin_time = Time::now();
     run_query(std::move(ascii_host), prefer_ipv6, query);
@@ -190,7 +194,6 @@ void GetHostByNameActor::on_query_result(std::string host, bool prefer_ipv6, Res
   auto query_it = active_queries_[prefer_ipv6].find(host);
   CHECK(query_it != active_queries_[prefer_ipv6].end());
   auto &query = *query_it->second;
-  CHECK(!query.promises.empty());
   CHECK(!query.query.empty());
 
   if (result.is_error() && query.pos < options_.resolver_types.size()) {
@@ -205,12 +208,21 @@ void GetHostByNameActor::on_query_result(std::string host, bool prefer_ipv6, Res
   auto promises = std::move(query.promises);
   auto value_it = cache_[prefer_ipv6].find(host);
   CHECK(value_it != cache_[prefer_ipv6].end());
-  auto cache_timeout = result.is_ok() ? options_.ok_timeout : options_.error_timeout;
-  value_it->second = Value{std::move(result), end_time + cache_timeout};
+  auto &value = value_it->second;
+  if (result.is_error() && value.ip.is_ok() && value.stale_expires_at > end_time) {
+    // keep the old IP address, but don't try to update it too often
+    value.expires_at = td::min(end_time + options_.error_timeout, value.stale_expires_at);
+  } else if (result.is_ok()) {
+    auto expires_at = end_time + options_.ok_timeout;
+    value = Value{std::move(result), expires_at, expires_at + options_.stale_timeout};
+  } else {
+    auto expires_at = end_time + options_.error_timeout;
+    value = Value{std::move(result), expires_at, expires_at};
+  }
   active_queries_[prefer_ipv6].erase(query_it);
 
   for (auto &promise : promises) {
-    promise.second.set_result(value_it->second.get_ip_port(promise.first));
+    promise.second.set_result(value.get_ip_port(promise.first));
   }
 }
 
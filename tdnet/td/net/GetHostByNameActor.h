@@ -26,13 +26,16 @@ class GetHostByNameActor final : public Actor {
   enum class ResolverType { Native, Google };
 
   struct Options {
-    static constexpr int32 DEFAULT_CACHE_TIME = 60 * 29;       // 29 minutes
-    static constexpr int32 DEFAULT_ERROR_CACHE_TIME = 60 * 5;  // 5 minutes
+    static constexpr int32 DEFAULT_CACHE_TIME = 60 * 29;        // 29 minutes
+    static constexpr int32 DEFAULT_ERROR_CACHE_TIME = 60 * 5;   // 5 minutes
+    static constexpr int32 DEFAULT_STALE_CACHE_TIME = 60 * 60;  // 1 hour
 
     vector<ResolverType> resolver_types{ResolverType::Native};
     int32 scheduler_id{-1};
     int32 ok_timeout{DEFAULT_CACHE_TIME};
     int32 error_timeout{DEFAULT_ERROR_CACHE_TIME};
+    // how long an expired IP address can be returned while it is being updated
+    int32 stale_timeout{DEFAULT_STALE_CACHE_TIME};
   };
 
   explicit GetHostByNameActor(Options options);
@@ -45,8 +48,10 @@ class GetHostByNameActor final : public Actor {
   struct Value {
     Result<IPAddress> ip;
     double expires_at;
+    double stale_expires_at;
 
-    Value(Result<IPAddress> ip, double expires_at) : ip(std::move(ip)), expires_at(expires_at) {
+    Value(Result<IPAddress> ip, double expires_at, double stale_expires_at)
+        : ip(std::move(ip)), expires_at(expires_at), stale_expires_at(stale_expires_at) {
     }
 
     Result<IPAddress> get_ip_port(int port) const {
@@ -16,8 +16,10 @@
 #include "td/utils/misc.h"
 #include "td/utils/Parser.h"
 #include "td/utils/PathView.h"
+#include "td/utils/port/IoSlice.h"
 #include "td/utils/port/path.h"
 #include "td/utils/SliceBuilder.h"
+#include "td/utils/Span.h"
 
 #include <cstddef>
 #include <cstring>
@@ -193,7 +195,7 @@ Result<size_t> HttpReader::do_read_next(bool can_be_slow) {
         auto size = content_->size();
         bool restart = false;
         if (size > (1 << 20) || flow_sink_.is_ready()) {
-          TRY_STATUS(save_file_part(content_->cut_head(size).move_as_buffer_slice()));
+          TRY_STATUS(save_file_part(content_->cut_head(size)));
           restart = true;
         }
         if (flow_sink_.is_ready()) {
@@ -481,7 +483,7 @@ Result<bool> HttpReader::parse_multipart_form_data(bool can_be_slow) {
           }
         }
         if (find_boundary(content_->clone(), boundary_, form_data_read_length_)) {
-          auto file_part = content_->cut_head(form_data_read_length_).move_as_buffer_slice();
+          auto file_part = content_->cut_head(form_data_read_length_);
           content_->advance(boundary_.size());
           form_data_skipped_length_ += form_data_read_length_ + boundary_.size();
           form_data_read_length_ = 0;
@@ -496,7 +498,7 @@ Result<bool> HttpReader::parse_multipart_form_data(bool can_be_slow) {
         }
 
         // TODO optimize?
-        auto file_part = content_->cut_head(form_data_read_length_).move_as_buffer_slice();
+        auto file_part = content_->cut_head(form_data_read_length_);
         form_data_skipped_length_ += form_data_read_length_;
         form_data_read_length_ = 0;
         CHECK(content_->size() < boundary_.size());
@@ -841,7 +843,7 @@ Status HttpReader::try_open_temp_file(Slice directory_name, CSlice desired_file_
   return Status::OK();
 }
 
-Status HttpReader::save_file_part(BufferSlice &&file_part) {
+Status HttpReader::save_file_part(ChainBufferReader &&file_part) {
   file_size_ += narrow_cast<int64>(file_part.size());
   if (file_size_ > MAX_FILE_SIZE) {
     clean_temporary_file();
@@ -850,10 +852,27 @@ Status HttpReader::save_file_part(BufferSlice &&file_part) {
   }
 
   LOG(DEBUG) << "Save file part of size " << file_part.size() << " to file " << temp_file_name_;
-  auto result_written = temp_file_.write(file_part.as_slice());
-  if (result_written.is_error() || result_written.ok() != file_part.size()) {
-    clean_temporary_file();
-    return Status::Error(500, "Internal Server Error: can't upload the file");
+  // write the buffer chunks directly to avoid copying them to a contiguous buffer
+  while (!file_part.empty()) {
+    constexpr size_t BUF_SIZE = 64;
+    IoSlice buf[BUF_SIZE];
+
+    auto it = file_part.clone();
+    size_t buf_i;
+    for (buf_i = 0; buf_i < BUF_SIZE; buf_i++) {
+      Slice slice = it.prepare_read();
+      if (slice.empty()) {
+        break;
+      }
+      buf[buf_i] = as_io_slice(slice);
+      it.confirm_read(slice.size());
+    }
+    auto result_written = temp_file_.writev(Span<IoSlice>(buf, buf_i));
+    if (result_written.is_error() || result_written.ok() == 0) {
+      clean_temporary_file();
+      return Status::Error(500, "Internal Server Error: can't upload the file");
+    }
+    file_part.advance(result_written.ok());
   }
   return Status::OK();
 }
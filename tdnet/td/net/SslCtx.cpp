@@ -23,6 +23,7 @@
 #include <openssl/x509.h>
 #include <openssl/x509_vfy.h>
 
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <mutex>
@@ -153,6 +154,112 @@ X509_STORE *load_system_certificate_store() {
 
 using SslCtxPtr = std::shared_ptr<SSL_CTX>;
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+// client-side cache of TLS sessions, which allows to resume sessions instead of doing full handshakes
+class SslSessionCache {
+ public:
+  SslSessionCache() = default;
+  SslSessionCache(const SslSessionCache &) = delete;
+  SslSessionCache &operator=(const SslSessionCache &) = delete;
+  SslSessionCache(SslSessionCache &&) = delete;
+  SslSessionCache &operator=(SslSessionCache &&) = delete;
+  ~SslSessionCache() {
+    for (auto &it : sessions_) {
+      SSL_SESSION_free(it.second);
+    }
+  }
+
+  static int get_ssl_ctx_ex_data_index() {
+    static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+  }
+
+  static int get_ssl_ex_data_index() {
+    static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+  }
+
+  void enable(SSL_CTX *ssl_ctx) {
+    if (get_ssl_ctx_ex_data_index() < 0 || get_ssl_ex_data_index() < 0 ||
+        SSL_CTX_set_ex_data(ssl_ctx, get_ssl_ctx_ex_data_index(), static_cast<void *>(this)) != 1) {
+      return;
+    }
+    SSL_CTX_set_session_cache_mode(ssl_ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ssl_ctx, on_new_session);
+    SSL_CTX_set_info_callback(ssl_ctx, on_info);
+  }
+
+  static std::atomic<size_t> &get_max_session_count() {
+    static std::atomic<size_t> max_session_count{256};
+    return max_session_count;
+  }
+
+  static std::atomic<int64> &get_handshake_count() {
+    static std::atomic<int64> handshake_count{0};
+    return handshake_count;
+  }
+
+  static std::atomic<int64> &get_resumed_handshake_count() {
+    static std::atomic<int64> resumed_handshake_count{0};
+    return resumed_handshake_count;
+  }
+
+  // removes the session from the cache, because TLS 1.3 tickets are supposed to be used once
+  SSL_SESSION *extract_session(const string &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(key);
+    if (it == sessions_.end()) {
+      return nullptr;
+    }
+    auto *session = it->second;
+    sessions_.erase(it);
+    return session;
+  }
+
+ private:
+  std::mutex mutex_;
+  FlatHashMap<string, SSL_SESSION *> sessions_;
+
+  bool add_session(const string &key, SSL_SESSION *session) {
+    auto max_session_count = get_max_session_count().load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (sessions_.size() >= max_session_count && sessions_.count(key) == 0) {
+      if (sessions_.empty()) {
+        return false;
+      }
+      auto it = sessions_.begin();
+      SSL_SESSION_free(it->second);
+      sessions_.erase(it);
+    }
+    auto &old_session = sessions_[key];
+    if (old_session != nullptr) {
+      SSL_SESSION_free(old_session);
+    }
+    old_session = session;
+    return true;
+  }
+
+  static int on_new_session(SSL *ssl_handle, SSL_SESSION *session) {
+    auto *cache = static_cast<SslSessionCache *>(
+        SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl_handle), get_ssl_ctx_ex_data_index()));
+    auto *key = static_cast<const string *>(SSL_get_ex_data(ssl_handle, get_ssl_ex_data_index()));
+    if (cache == nullptr || key == nullptr || SSL_SESSION_is_resumable(session) != 1) {
+      return 0;
+    }
+    return cache->add_session(*key, session) ? 1 : 0;  // the cache owns added sessions
+  }
+
+  static void on_info(const SSL *ssl_handle, int where, int ret) {
+    if ((where & SSL_CB_HANDSHAKE_DONE) != 0) {
+      get_handshake_count().fetch_add(1, std::memory_order_relaxed);
+      if (SSL_session_reused(const_cast<SSL *>(ssl_handle)) == 1) {
+        get_resumed_handshake_count().fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+};
+#endif
+
 Result<SslCtxPtr> do_create_ssl_ctx(CSlice cert_file, SslCtx::VerifyPeer verify_peer) {
   auto ssl_method =
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
@@ -216,8 +323,20 @@ Result<SslCtxPtr> do_create_ssl_ctx(CSlice cert_file, SslCtx::VerifyPeer verify_
   return std::move(ssl_ctx_ptr);
 }
 
+// sessions are cached only for default contexts, because they are never destroyed and use the same certificates
+Result<SslCtxPtr> create_default_ssl_ctx(SslCtx::VerifyPeer verify_peer) {
+  TRY_RESULT(ssl_ctx_ptr, do_create_ssl_ctx(CSlice(), verify_peer));
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  static SslSessionCache verified_session_cache;
+  static SslSessionCache unverified_session_cache;
+  auto &session_cache = verify_peer == SslCtx::VerifyPeer::On ? verified_session_cache : unverified_session_cache;
+  session_cache.enable(ssl_ctx_ptr.get());
+#endif
+  return std::move(ssl_ctx_ptr);
+}
+
 Result<SslCtxPtr> get_default_ssl_ctx() {
-  static auto ctx = do_create_ssl_ctx(CSlice(), SslCtx::VerifyPeer::On);
+  static auto ctx = create_default_ssl_ctx(SslCtx::VerifyPeer::On);
   if (ctx.is_error()) {
     return ctx.error().clone();
   }
@@ -226,7 +345,7 @@ Result<SslCtxPtr> get_default_ssl_ctx() {
 }
 
 Result<SslCtxPtr> get_default_unverified_ssl_ctx() {
-  static auto ctx = do_create_ssl_ctx(CSlice(), SslCtx::VerifyPeer::Off);
+  static auto ctx = create_default_ssl_ctx(SslCtx::VerifyPeer::Off);
   if (ctx.is_error()) {
     return ctx.error().clone();
   }
@@ -321,6 +440,41 @@ void *SslCtx::get_openssl_ctx() const {
   return impl_ == nullptr ? nullptr : impl_->get_openssl_ctx();
 }
 
+void SslCtx::set_max_cached_session_count(size_t max_count) {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  detail::SslSessionCache::get_max_session_count() = max_count;
+#endif
+}
+
+SslCtx::SessionCacheStats SslCtx::get_session_cache_stats() {
+  SessionCacheStats result;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  result.handshake_count = detail::SslSessionCache::get_handshake_count().load(std::memory_order_relaxed);
+  result.resumed_handshake_count =
+      detail::SslSessionCache::get_resumed_handshake_count().load(std::memory_order_relaxed);
+#endif
+  return result;
+}
+
+void SslCtx::init_openssl_session(void *ssl_handle, const string *session_key) {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  auto *ssl = static_cast<SSL *>(ssl_handle);
+  auto *cache = static_cast<detail::SslSessionCache *>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), detail::SslSessionCache::get_ssl_ctx_ex_data_index()));
+  if (cache == nullptr ||
+      SSL_set_ex_data(ssl, detail::SslSessionCache::get_ssl_ex_data_index(),
+                      const_cast<void *>(static_cast<const void *>(session_key))) != 1) {
+    return;
+  }
+  auto *session = cache->extract_session(*session_key);
+  if (session != nullptr) {
+    LOG(DEBUG) << "Try to resume TLS session for " << *session_key;
+    SSL_set_session(ssl, session);
+    SSL_SESSION_free(session);
+  }
+#endif
+}
+
 SslCtx::SslCtx(unique_ptr<detail::SslCtxImpl> impl) : impl_(std::move(impl)) {
 }
 
@@ -362,6 +516,16 @@ void *SslCtx::get_openssl_ctx() const {
   return nullptr;
 }
 
+void SslCtx::set_max_cached_session_count(size_t max_count) {
+}
+
+SslCtx::SessionCacheStats SslCtx::get_session_cache_stats() {
+  return SessionCacheStats();
+}
+
+void SslCtx::init_openssl_session(void *ssl_handle, const string *session_key) {
+}
+
 SslCtx::SslCtx(unique_ptr<detail::SslCtxImpl> impl) : impl_(std::move(impl)) {
 }
 
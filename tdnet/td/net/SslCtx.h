@@ -6,6 +6,7 @@
 //
 #pragma once
 
+#include "td/utils/common.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 
@@ -32,6 +33,20 @@ class SslCtx {
 
   void *get_openssl_ctx() const;
 
+  struct SessionCacheStats {
+    int64 handshake_count = 0;  // number of finished handshakes of connections, for which sessions are cached
+    int64 resumed_handshake_count = 0;
+  };
+
+  static SessionCacheStats get_session_cache_stats();
+
+  // sets maximum number of cached TLS sessions per SSL context; 0 disables the cache
+  static void set_max_cached_session_count(size_t max_count);
+
+  // allows a new OpenSSL handle to resume a TLS session saved by a previous connection with the same session key
+  // the key must be kept alive until the handle is destroyed
+  static void init_openssl_session(void *ssl_handle, const string *session_key);
+
   explicit operator bool() const noexcept {
     return static_cast<bool>(impl_);
   }
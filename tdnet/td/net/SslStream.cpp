@@ -12,6 +12,7 @@
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/IPAddress.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/Time.h"
 
@@ -177,6 +178,9 @@ class SslStreamImpl {
 #endif
     SSL_set_connect_state(ssl_handle.get());
 
+    session_key_ = PSTRING() << host << (check_ip_address_as_host ? "@host" : "");
+    SslCtx::init_openssl_session(ssl_handle.get(), &session_key_);
+
     ssl_handle_ = std::move(ssl_handle);
 
     return Status::OK();
@@ -196,6 +200,7 @@ class SslStreamImpl {
   }
 
  private:
+  string session_key_;  // must outlive ssl_handle_
   SslHandle ssl_handle_;
 
   friend class SslReadByteFlow;
@@ -825,10 +825,16 @@ static void write_base_function_class(const tl_config &config, tl_outputer &out,
   out.append(w.gen_class_end());
 }
 
-void write_tl(const tl_config &config, tl_outputer &out, const TL_writer &w) {
+// the base classes are written to the first outputer, other classes and functions are distributed evenly
+static void write_tl_to_outputers(const tl_config &config, const std::vector<tl_outputer *> &outs,
+                                  const TL_writer &w) {
+  assert(!outs.empty());
   find_complex_types(config, w);
 
-  out.append(w.gen_output_begin(std::string()));
+  for (std::size_t i = 0; i < outs.size(); i++) {
+    outs[i]->append(w.gen_output_begin(std::string()));
+  }
+  tl_outputer &out = *outs[0];
   out.append(w.gen_output_begin_once());
 
   std::set<std::string> request_types;
@@ -843,6 +849,7 @@ void write_tl(const tl_config &config, tl_outputer &out, const TL_writer &w) {
 
   write_base_function_class(config, out, request_types, result_types, w);
 
+  std::size_t written_count = 0;
   for (std::size_t type = 0; type < config.get_type_count(); type++) {
     tl_type *t = config.get_type_by_num(type);
     if (t->constructors_num == 0 || w.is_built_in_simple_type(t->name) ||
@@ -855,7 +862,7 @@ void write_tl(const tl_config &config, tl_outputer &out, const TL_writer &w) {
       continue;
     }
 
-    write_class(out, t, request_types, result_types, w);
+    write_class(*outs[written_count++ % outs.size()], t, request_types, result_types, w);
   }
 
   for (std::size_t function = 0; function < config.get_function_count(); function++) {
@@ -865,9 +872,11 @@ void write_tl(const tl_config &config, tl_outputer &out, const TL_writer &w) {
       continue;
     }
 
-    write_function(out, t, request_types, result_types, w);
+    write_function(*outs[written_count++ % outs.size()], t, request_types, result_types, w);
+  }
+  for (std::size_t i = 0; i < outs.size(); i++) {
+    outs[i]->append(w.gen_output_end());
   }
-  out.append(w.gen_output_end());
 
   for (std::size_t type = 0; type < config.get_type_count(); type++) {
     tl_type *t = config.get_type_by_num(type);
@@ -877,6 +886,10 @@ void write_tl(const tl_config &config, tl_outputer &out, const TL_writer &w) {
   }
 }
 
+void write_tl(const tl_config &config, tl_outputer &out, const TL_writer &w) {
+  write_tl_to_outputers(config, std::vector<tl_outputer *>(1, &out), w);
+}
+
 tl_config read_tl_config_from_file(const std::string &file_name) {
   std::string config = get_file_contents(file_name);
   if (config.empty()) {
@@ -899,6 +912,30 @@ bool write_tl_to_file(const tl_config &config, const std::string &file_name, con
   return put_file_contents(file_name, out.get_result(), w.is_documentation_generated());
 }
 
+bool write_tl_to_split_files(const tl_config &config, const std::string &file_name_prefix,
+                             const std::string &file_name_suffix, int part_count, const TL_writer &w) {
+  assert(part_count > 0);
+  std::vector<tl_string_outputer> outs(part_count);
+  std::vector<tl_outputer *> out_ptrs;
+  for (int i = 0; i < part_count; i++) {
+    out_ptrs.push_back(&outs[i]);
+  }
+  write_tl_to_outputers(config, out_ptrs, w);
+
+  bool is_ok = true;
+  for (int i = 0; i < part_count; i++) {
+    std::string file_name = file_name_prefix;
+    if (i != 0) {
+      file_name += "_" + std::to_string(i);
+    }
+    file_name += file_name_suffix;
+    if (!put_file_contents(file_name, outs[i].get_result(), w.is_documentation_generated())) {
+      is_ok = false;
+    }
+  }
+  return is_ok;
+}
+
 static std::string get_additional_imports(const std::map<std::string, bool> &types, const std::string base_class_name,
                                           const std::string &file_name_prefix, const std::string &file_name_suffix,
                                           const TL_writer &w) {
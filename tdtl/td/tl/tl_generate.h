@@ -21,6 +21,11 @@ tl_config read_tl_config_from_file(const std::string &file_name);
 
 bool write_tl_to_file(const tl_config &config, const std::string &file_name, const TL_writer &w);
 
+// writes the first part to file_name_prefix + file_name_suffix and
+// the part i to file_name_prefix + "_" + i + file_name_suffix
+bool write_tl_to_split_files(const tl_config &config, const std::string &file_name_prefix,
+                             const std::string &file_name_suffix, int part_count, const TL_writer &w);
+
 bool write_tl_to_multiple_files(const tl_config &config, const std::string &file_name_prefix,
                                 const std::string &file_name_suffix, const TL_writer &w);
 
@@ -80,6 +80,15 @@ Status AsyncFileLog::init(string path, int64 rotate_threshold, bool redirect_std
           }
         };
 
+        // all ready log lines are written with a single system call
+        string pending_data;
+        auto flush_pending_data = [&] {
+          if (!pending_data.empty()) {
+            append(pending_data);
+            pending_data.clear();
+          }
+        };
+
         while (true) {
           int ready_count = queue->reader_wait_nonblock();
           if (ready_count == 0) {
@@ -91,9 +100,17 @@ Status AsyncFileLog::init(string path, int64 rotate_threshold, bool redirect_std
             Query query = queue->reader_get_unsafe();
             switch (query.type_) {
               case Query::Type::Log:
-                append(query.data_);
+                if (pending_data.empty()) {
+                  pending_data = std::move(query.data_);
+                } else {
+                  pending_data += query.data_;
+                }
+                if (pending_data.size() >= MAX_PENDING_DATA_SIZE) {
+                  flush_pending_data();
+                }
                 break;
               case Query::Type::AfterRotation:
+                flush_pending_data();
                 after_rotation();
                 break;
               case Query::Type::Close:
@@ -103,6 +120,7 @@ Status AsyncFileLog::init(string path, int64 rotate_threshold, bool redirect_std
                 process_fatal_error("Invalid query type in AsyncFileLog");
             }
           }
+          flush_pending_data();
           queue->reader_flush();
 
           if (need_close) {
@@ -35,6 +35,8 @@ class AsyncFileLog final : public LogInterface {
     string data_;
   };
 
+  static constexpr size_t MAX_PENDING_DATA_SIZE = 1 << 16;
+
   string path_;
   unique_ptr<MpscPollableQueue<Query>> queue_;
   thread logging_thread_;
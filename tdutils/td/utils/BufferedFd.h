@@ -118,7 +118,7 @@ Result<size_t> BufferedFdBase<FdT>::flush_write() {
   write_->sync_with_writer();
   size_t result = 0;
   while (!write_->empty() && ::td::can_write_local(*this)) {
-    constexpr size_t BUF_SIZE = 20;
+    constexpr size_t BUF_SIZE = 64;
     IoSlice buf[BUF_SIZE];
 
     auto it = write_->clone();
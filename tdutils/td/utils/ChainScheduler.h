@@ -18,8 +18,6 @@
 #include "td/utils/StringBuilder.h"
 #include "td/utils/VectorQueue.h"
 
-#include <functional>
-
 namespace td {
 
 struct ChainSchedulerBase {
@@ -52,6 +50,15 @@ class ChainScheduler final : public ChainSchedulerBase {
     tasks_.for_each([&f](uint64, Task &task) { f(task.extra); });
   }
 
+  template <class F>
+  void for_each_task_chain(TaskId task_id, F &&f) {
+    auto *task = tasks_.get(task_id);
+    CHECK(task != nullptr);
+    for (TaskChainInfo &task_chain_info : task->chains) {
+      f(task_chain_info.chain_id);
+    }
+  }
+
   template <class F>
   void for_each_dependent(TaskId task_id, F &&f) {
     auto *task = tasks_.get(task_id);
@@ -109,13 +116,15 @@ class ChainScheduler final : public ChainSchedulerBase {
       return head_.empty();
     }
 
-    void foreach(std::function<void(TaskId, uint64)> f) const {
+    template <class F>
+    void foreach(F &&f) const {
       for (auto it = head_.begin(); it != head_.end(); it = it->get_next()) {
         auto &node = static_cast<const ChainNode &>(*it);
         f(node.task_id, node.generation);
       }
     }
-    void foreach_child(ListNode *start_node, std::function<void(TaskId, uint64)> f) const {
+    template <class F>
+    void foreach_child(ListNode *start_node, F &&f) const {
       for (auto it = start_node; it != head_.end(); it = it->get_next()) {
         auto &node = static_cast<const ChainNode &>(*it);
         f(node.task_id, node.generation);
@@ -0,0 +1,219 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace td {
+
+// ordered set of small copyable values, which is stored as a sorted list of sorted chunks
+// an insertion or an erasure moves at most MAX_CHUNK_SIZE elements and doesn't allocate memory in most cases,
+// iteration is sequential over contiguous memory; iterators are invalidated by any modification
+template <class T, size_t MAX_CHUNK_SIZE = 256>
+class ChunkedSet {
+  static_assert(MAX_CHUNK_SIZE >= 4, "Too small chunk size");
+
+  using Chunk = vector<T>;
+
+  // all chunks are non-empty, the last element of each chunk is less than the first element of the next chunk
+  vector<Chunk> chunks_;
+  size_t size_ = 0;
+
+ public:
+  class const_iterator {
+    const vector<Chunk> *chunks_ = nullptr;
+    size_t chunk_pos_ = 0;
+    size_t pos_ = 0;
+
+    friend class ChunkedSet;
+
+    const_iterator(const vector<Chunk> *chunks, size_t chunk_pos, size_t pos)
+        : chunks_(chunks), chunk_pos_(chunk_pos), pos_(pos) {
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    const_iterator() = default;
+
+    const T &operator*() const {
+      return (*chunks_)[chunk_pos_][pos_];
+    }
+
+    const T *operator->() const {
+      return &**this;
+    }
+
+    const_iterator &operator++() {
+      if (++pos_ == (*chunks_)[chunk_pos_].size()) {
+        chunk_pos_++;
+        pos_ = 0;
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return chunk_pos_ == other.chunk_pos_ && pos_ == other.pos_;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+  };
+  using iterator = const_iterator;
+
+  const_iterator begin() const {
+    return const_iterator(&chunks_, 0, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(&chunks_, chunks_.size(), 0);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    chunks_.clear();
+    size_ = 0;
+  }
+
+  std::pair<const_iterator, bool> insert(const T &value) {
+    if (chunks_.empty()) {
+      chunks_.emplace_back(1, value);
+      size_ = 1;
+      return {begin(), true};
+    }
+
+    auto chunk_pos = get_chunk_pos(value);
+    if (chunk_pos == chunks_.size()) {
+      chunk_pos--;  // append to the last chunk
+    }
+    auto &chunk = chunks_[chunk_pos];
+    auto it = std::lower_bound(chunk.begin(), chunk.end(), value);
+    auto pos = static_cast<size_t>(it - chunk.begin());
+    if (it != chunk.end() && !(value < *it)) {
+      return {const_iterator(&chunks_, chunk_pos, pos), false};
+    }
+    chunk.insert(it, value);
+    size_++;
+
+    if (chunk.size() > MAX_CHUNK_SIZE) {
+      auto half_size = chunk.size() / 2;
+      Chunk new_chunk(std::make_move_iterator(chunk.begin() + half_size), std::make_move_iterator(chunk.end()));
+      chunk.erase(chunk.begin() + half_size, chunk.end());
+      chunks_.insert(chunks_.begin() + (chunk_pos + 1), std::move(new_chunk));
+      if (pos >= half_size) {
+        chunk_pos++;
+        pos -= half_size;
+      }
+    }
+    return {const_iterator(&chunks_, chunk_pos, pos), true};
+  }
+
+  size_t erase(const T &value) {
+    auto chunk_pos = get_chunk_pos(value);
+    if (chunk_pos == chunks_.size()) {
+      return 0;
+    }
+    auto &chunk = chunks_[chunk_pos];
+    auto it = std::lower_bound(chunk.begin(), chunk.end(), value);
+    CHECK(it != chunk.end());
+    if (value < *it) {
+      return 0;
+    }
+    chunk.erase(it);
+    size_--;
+
+    if (chunk.empty()) {
+      chunks_.erase(chunks_.begin() + chunk_pos);
+    } else if (chunk.size() <= MAX_CHUNK_SIZE / 4) {
+      // merge with a neighbour if the resulting chunk would be at most half-full
+      if (chunk_pos + 1 < chunks_.size() && chunk.size() + chunks_[chunk_pos + 1].size() <= MAX_CHUNK_SIZE / 2) {
+        merge_chunks(chunk_pos);
+      } else if (chunk_pos > 0 && chunk.size() + chunks_[chunk_pos - 1].size() <= MAX_CHUNK_SIZE / 2) {
+        merge_chunks(chunk_pos - 1);
+      }
+    }
+    return 1;
+  }
+
+  size_t count(const T &value) const {
+    return find(value) == end() ? 0 : 1;
+  }
+
+  const_iterator find(const T &value) const {
+    auto result = lower_bound(value);
+    if (result == end() || value < *result) {
+      return end();
+    }
+    return result;
+  }
+
+  // returns iterator to the first element, which is not less than value
+  const_iterator lower_bound(const T &value) const {
+    auto chunk_pos = get_chunk_pos(value);
+    if (chunk_pos == chunks_.size()) {
+      return end();
+    }
+    const auto &chunk = chunks_[chunk_pos];
+    auto pos = std::lower_bound(chunk.begin(), chunk.end(), value) - chunk.begin();
+    return const_iterator(&chunks_, chunk_pos, static_cast<size_t>(pos));
+  }
+
+  // returns iterator to the first element, which is greater than value
+  const_iterator upper_bound(const T &value) const {
+    auto chunk_pos = static_cast<size_t>(
+        std::upper_bound(chunks_.begin(), chunks_.end(), value,
+                         [](const T &lhs, const Chunk &rhs_chunk) { return lhs < rhs_chunk.back(); }) -
+        chunks_.begin());
+    if (chunk_pos == chunks_.size()) {
+      return end();
+    }
+    const auto &chunk = chunks_[chunk_pos];
+    auto pos = std::upper_bound(chunk.begin(), chunk.end(), value) - chunk.begin();
+    return const_iterator(&chunks_, chunk_pos, static_cast<size_t>(pos));
+  }
+
+ private:
+  // returns position of the first chunk, which last element is not less than value
+  size_t get_chunk_pos(const T &value) const {
+    return static_cast<size_t>(
+        std::lower_bound(chunks_.begin(), chunks_.end(), value,
+                         [](const Chunk &lhs_chunk, const T &rhs) { return lhs_chunk.back() < rhs; }) -
+        chunks_.begin());
+  }
+
+  void merge_chunks(size_t chunk_pos) {
+    auto &chunk = chunks_[chunk_pos];
+    auto &next_chunk = chunks_[chunk_pos + 1];
+    chunk.insert(chunk.end(), next_chunk.begin(), next_chunk.end());
+    chunks_.erase(chunks_.begin() + (chunk_pos + 1));
+  }
+};
+
+}  // namespace td
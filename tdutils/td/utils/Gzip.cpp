@@ -43,6 +43,33 @@ Status Gzip::init_encode() {
   return Status::OK();
 }
 
+Status Gzip::init_reusable_encode() {
+  TRY_STATUS(init_encode());
+  is_reusable_ = true;
+  return Status::OK();
+}
+
+Status Gzip::reset() {
+  if (mode_ == Mode::Empty) {
+    return Status::Error("Stream isn't initialized");
+  }
+  int ret = mode_ == Mode::Encode ? deflateReset(&impl_->stream_) : inflateReset(&impl_->stream_);
+  if (ret != Z_OK) {
+    clear();
+    return Status::Error(PSLICE() << "zlib reset failed: " << ret);
+  }
+  impl_->stream_.avail_in = 0;
+  impl_->stream_.next_in = nullptr;
+  impl_->stream_.avail_out = 0;
+  impl_->stream_.next_out = nullptr;
+
+  input_size_ = 0;
+  output_size_ = 0;
+
+  close_input_flag_ = false;
+  return Status::OK();
+}
+
 Status Gzip::init_decode() {
   CHECK(mode_ == Mode::Empty);
   init_common();
@@ -87,7 +114,9 @@ Result<Gzip::State> Gzip::run() {
     }
     if (ret == Z_STREAM_END) {
       // TODO(now): fail if input is not empty;
-      clear();
+      if (!is_reusable_) {
+        clear();
+      }
       return State::Done;
     }
     clear();
@@ -125,6 +154,7 @@ void Gzip::clear() {
     deflateEnd(&impl_->stream_);
   }
   mode_ = Mode::Empty;
+  is_reusable_ = false;
 }
 
 Gzip::Gzip() : impl_(make_unique<Impl>()) {
@@ -147,6 +177,7 @@ void Gzip::swap(Gzip &other) {
   swap(input_size_, other.input_size_);
   swap(output_size_, other.output_size_);
   swap(close_input_flag_, other.close_input_flag_);
+  swap(is_reusable_, other.is_reusable_);
   swap(mode_, other.mode_);
 }
 
@@ -161,7 +192,17 @@ BufferSlice gzdecode(Slice s) {
   gzip.set_input(s);
   gzip.close_input();
   double k = 2;
-  gzip.set_output(message.prepare_append(static_cast<size_t>(static_cast<double>(s.size()) * k)));
+  auto output_size = static_cast<size_t>(static_cast<double>(s.size()) * k);
+  if (s.size() >= 18 && s.ubegin()[0] == 0x1f && s.ubegin()[1] == 0x8b) {
+    // gzip stream ends with the size of the uncompressed data modulo 2^32, which can be used to avoid reallocations
+    const unsigned char *trailer = s.uend() - 4;
+    auto uncompressed_size = static_cast<size_t>(trailer[0]) | (static_cast<size_t>(trailer[1]) << 8) |
+                             (static_cast<size_t>(trailer[2]) << 16) | (static_cast<size_t>(trailer[3]) << 24);
+    if (output_size < uncompressed_size && uncompressed_size / 64 <= s.size()) {
+      output_size = uncompressed_size;
+    }
+  }
+  gzip.set_output(message.prepare_append(output_size));
   while (true) {
     auto r_state = gzip.run();
     if (r_state.is_error()) {
@@ -184,9 +225,7 @@ BufferSlice gzdecode(Slice s) {
   return message.extract_reader().move_as_buffer_slice();
 }
 
-BufferSlice gzencode(Slice s, double max_compression_ratio) {
-  Gzip gzip;
-  gzip.init_encode().ensure();
+static BufferSlice do_gzencode(Gzip &gzip, Slice s, double max_compression_ratio) {
   gzip.set_input(s);
   gzip.close_input();
   auto max_size = static_cast<size_t>(static_cast<double>(s.size()) * max_compression_ratio);
@@ -204,5 +243,18 @@ BufferSlice gzencode(Slice s, double max_compression_ratio) {
   return message.as_buffer_slice();
 }
 
+BufferSlice gzencode(Slice s, double max_compression_ratio) {
+  Gzip gzip;
+  gzip.init_encode().ensure();
+  return do_gzencode(gzip, s, max_compression_ratio);
+}
+
+BufferSlice gzencode(Gzip &gzip, Slice s, double max_compression_ratio) {
+  if (gzip.reset().is_error() && gzip.init_reusable_encode().is_error()) {
+    return BufferSlice();
+  }
+  return do_gzencode(gzip, s, max_compression_ratio);
+}
+
 }  // namespace td
 #endif
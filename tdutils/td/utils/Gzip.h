@@ -39,6 +39,11 @@ class Gzip {
 
   Status init_decode() TD_WARN_UNUSED_RESULT;
 
+  // the stream isn't destroyed after the end of the data and can be reused for the next data after reset()
+  Status init_reusable_encode() TD_WARN_UNUSED_RESULT;
+
+  Status reset() TD_WARN_UNUSED_RESULT;
+
   void set_input(Slice input);
 
   void set_output(MutableSlice output);
@@ -89,6 +94,7 @@ class Gzip {
   size_t input_size_ = 0;
   size_t output_size_ = 0;
   bool close_input_flag_ = false;
+  bool is_reusable_ = false;
   Mode mode_ = Mode::Empty;
 
   void init_common();
@@ -101,6 +107,9 @@ BufferSlice gzdecode(Slice s);
 
 BufferSlice gzencode(Slice s, double max_compression_ratio);
 
+// reuses the stream, which must be initialized with init_reusable_encode()
+BufferSlice gzencode(Gzip &gzip, Slice s, double max_compression_ratio);
+
 }  // namespace td
 
 #endif
@@ -42,7 +42,8 @@ vector<string> Hints::get_words(Slice name) {
 
 void Hints::add_word(const string &word, KeyT key, std::map<string, vector<KeyT>> &word_to_keys) {
   vector<KeyT> &keys = word_to_keys[word];
-  CHECK(!td::contains(keys, key));
+  // words are unique after fix_words; the check is linear in the number of keys with the word
+  DCHECK(!td::contains(keys, key));
   keys.push_back(key);
 }
 
@@ -105,6 +106,14 @@ void Hints::add(KeyT key, Slice name) {
   key_to_name_[key] = name.str();
 }
 
+Hints::RatingT Hints::get_rating(KeyT key) const {
+  auto it = key_to_rating_.find(key);
+  if (it == key_to_rating_.end()) {
+    return RatingT();
+  }
+  return it->second;
+}
+
 void Hints::set_rating(KeyT key, RatingT rating) {
   // LOG(ERROR) << "Set rating " << key << ": " << rating;
   key_to_rating_[key] = rating;
@@ -173,13 +182,24 @@ std::pair<size_t, vector<Hints::KeyT>> Hints::search(Slice query, int32 limit, b
   }
 
   auto total_size = results.size();
-  if (total_size < static_cast<size_t>(limit)) {
-    std::sort(results.begin(), results.end(), CompareByRating(key_to_rating_));
-  } else {
-    std::partial_sort(results.begin(), results.begin() + limit, results.end(), CompareByRating(key_to_rating_));
-    results.resize(limit);
+
+  // ratings are looked up once per key instead of twice per comparison
+  vector<std::pair<RatingT, KeyT>> rated_results;
+  rated_results.reserve(total_size);
+  for (auto key : results) {
+    rated_results.emplace_back(get_rating(key), key);
   }
+  if (total_size > static_cast<size_t>(limit)) {
+    // select the best keys in linear time and sort only them
+    std::nth_element(rated_results.begin(), rated_results.begin() + limit, rated_results.end());
+    rated_results.resize(limit);
+  }
+  std::sort(rated_results.begin(), rated_results.end());
 
+  results.resize(rated_results.size());
+  for (size_t i = 0; i < rated_results.size(); i++) {
+    results[i] = rated_results[i].second;
+  }
   return {total_size, std::move(results)};
 }
 
@@ -11,8 +11,42 @@
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/utf8.h"
 
+#include <cstring>
+
 namespace td {
 
+// long spans of characters, which don't need to be escaped, are copied at once
+static constexpr size_t MIN_JSON_PLAIN_SPAN_SIZE = 16;
+
+// returns end of the longest span of characters starting at pos, which don't need to be escaped
+static size_t skip_json_plain_characters(const char *s, size_t pos, size_t len, bool is_raw) {
+  // check 8 characters at once
+  const uint64 ones = static_cast<uint64>(0x0101010101010101);
+  const uint64 high_bits = ones * 0x80;
+  while (len - pos >= 8) {
+    uint64 word;
+    std::memcpy(&word, s + pos, sizeof(word));
+    auto quote_word = word ^ (ones * '"');
+    auto backslash_word = word ^ (ones * '\\');
+    auto special_mask = ((word - ones * 32) | (quote_word - ones) | (backslash_word - ones)) & ~word;
+    if (!is_raw) {
+      special_mask |= word;
+    }
+    if ((special_mask & high_bits) != 0) {
+      break;
+    }
+    pos += 8;
+  }
+  while (pos < len) {
+    auto ch = static_cast<unsigned char>(s[pos]);
+    if (ch < 32 || ch == '"' || ch == '\\' || (ch >= 128 && !is_raw)) {
+      break;
+    }
+    pos++;
+  }
+  return pos;
+}
+
 StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   sb << '"';
   SCOPE_EXIT {
@@ -22,6 +56,21 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonRawString &val) {
   auto len = val.value_.size();
 
   for (size_t pos = 0; pos < len; pos++) {
+    if (len - pos >= MIN_JSON_PLAIN_SPAN_SIZE) {
+      auto plain_end = skip_json_plain_characters(s, pos, len, true);
+      if (plain_end - pos >= MIN_JSON_PLAIN_SPAN_SIZE) {
+        sb << Slice(s + pos, s + plain_end);
+      } else {
+        for (; pos < plain_end; pos++) {
+          sb << s[pos];
+        }
+      }
+      pos = plain_end;
+      if (pos == len) {
+        break;
+      }
+    }
+
     auto ch = static_cast<unsigned char>(s[pos]);
     switch (ch) {
       case '"':
@@ -66,6 +115,21 @@ StringBuilder &operator<<(StringBuilder &sb, const JsonString &val) {
   auto len = val.str_.size();
 
   for (size_t pos = 0; pos < len; pos++) {
+    if (len - pos >= MIN_JSON_PLAIN_SPAN_SIZE) {
+      auto plain_end = skip_json_plain_characters(s, pos, len, false);
+      if (plain_end - pos >= MIN_JSON_PLAIN_SPAN_SIZE) {
+        sb << Slice(s + pos, s + plain_end);
+      } else {
+        for (; pos < plain_end; pos++) {
+          sb << s[pos];
+        }
+      }
+      pos = plain_end;
+      if (pos == len) {
+        break;
+      }
+    }
+
     auto ch = static_cast<unsigned char>(s[pos]);
     switch (ch) {
       case '"':
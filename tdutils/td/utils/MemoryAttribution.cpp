@@ -0,0 +1,54 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/MemoryAttribution.h"
+
+#include "td/utils/FlatHashMap.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace td {
+
+TD_THREAD_LOCAL const char *MemoryAttribution::current_tag_;
+std::atomic<MemoryAttribution::StatisticsGetter> MemoryAttribution::statistics_getter_{nullptr};
+
+void MemoryAttribution::set_statistics_getter(StatisticsGetter statistics_getter) {
+  statistics_getter_.store(statistics_getter, std::memory_order_relaxed);
+}
+
+const char *MemoryAttribution::get_tag(Slice name) {
+  if (!is_enabled()) {
+    return nullptr;
+  }
+
+  // tags are never deleted, because there can be live allocations attributed to them
+  static std::mutex mutex;
+  static FlatHashMap<string, unique_ptr<string>> tags;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &tag = tags[name.str()];
+  if (tag == nullptr) {
+    tag = td::make_unique<string>(name.str());
+  }
+  return tag->c_str();
+}
+
+vector<MemoryAttribution::Entry> MemoryAttribution::get_statistics() {
+  auto statistics_getter = statistics_getter_.load(std::memory_order_relaxed);
+  if (statistics_getter == nullptr) {
+    return {};
+  }
+  auto result = statistics_getter();
+  std::sort(result.begin(), result.end(), [](const Entry &lhs, const Entry &rhs) {
+    if (lhs.size != rhs.size) {
+      return lhs.size > rhs.size;
+    }
+    return lhs.tag < rhs.tag;
+  });
+  return result;
+}
+
+}  // namespace td
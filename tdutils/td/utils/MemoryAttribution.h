@@ -0,0 +1,55 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Slice.h"
+
+#include <atomic>
+
+namespace td {
+
+// attribution of live memory allocations to the subsystem, which was running on the thread during the allocation
+// the statistics are collected only by a memory profiler, which registers itself using set_statistics_getter
+class MemoryAttribution {
+ public:
+  struct Entry {
+    string tag;
+    size_t size = 0;
+    size_t allocation_count = 0;
+  };
+
+  using StatisticsGetter = vector<Entry> (*)();
+
+  // the tag must never be destroyed; nullptr tag is used for allocations outside of known subsystems
+  static void set_current_tag(const char *tag) {
+    current_tag_ = tag;
+  }
+
+  static const char *get_current_tag() {
+    return current_tag_;
+  }
+
+  static void set_statistics_getter(StatisticsGetter statistics_getter);
+
+  static bool is_enabled() {
+    return statistics_getter_.load(std::memory_order_relaxed) != nullptr;
+  }
+
+  // returns interned tag for the given name or nullptr if the attribution is disabled
+  static const char *get_tag(Slice name);
+
+  // the entries are sorted by decreasing size
+  static vector<Entry> get_statistics();
+
+ private:
+  static TD_THREAD_LOCAL const char *current_tag_;
+  static std::atomic<StatisticsGetter> statistics_getter_;
+};
+
+}  // namespace td
@@ -0,0 +1,137 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/MetricsRegistry.h"
+
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StringBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace td {
+
+void MetricsRegistry::Histogram::observe(double value) {
+  size_t bucket = 0;
+  auto bucket_bound = min_bucket_bound_;
+  while (bucket < BUCKET_COUNT && value > bucket_bound) {
+    bucket_bound *= 2;
+    bucket++;
+  }
+  if (bucket < BUCKET_COUNT) {
+    counters_.add(bucket, 1);
+  }
+  counters_.add(BUCKET_COUNT, 1);
+  counters_.add(BUCKET_COUNT + 1, static_cast<int64>(std::llround(value * 1e6)));
+}
+
+double MetricsRegistry::Histogram::get_bucket_bound(size_t bucket) const {
+  CHECK(bucket < BUCKET_COUNT);
+  return std::ldexp(min_bucket_bound_, static_cast<int>(bucket));
+}
+
+int64 MetricsRegistry::Histogram::get_cumulative_count(size_t bucket) const {
+  CHECK(bucket < BUCKET_COUNT);
+  int64 result = 0;
+  for (size_t i = 0; i <= bucket; i++) {
+    result += counters_.sum(i);
+  }
+  return result;
+}
+
+namespace {
+
+struct Registry {
+  std::mutex mutex;
+  std::map<string, unique_ptr<MetricsRegistry::Counter>> counters;
+  std::map<string, unique_ptr<MetricsRegistry::Histogram>> histograms;
+};
+
+Registry &get_registry() {
+  static Registry *registry = new Registry();  // must outlive all threads, which can update the metrics
+  return *registry;
+}
+
+}  // namespace
+
+MetricsRegistry::Counter *MetricsRegistry::get_counter(Slice name) {
+  auto &registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto &counter = registry.counters[name.str()];
+  if (counter == nullptr) {
+    counter = td::make_unique<Counter>();
+  }
+  return counter.get();
+}
+
+MetricsRegistry::Histogram *MetricsRegistry::get_histogram(Slice name, double min_bucket_bound) {
+  auto &registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto &histogram = registry.histograms[name.str()];
+  if (histogram == nullptr) {
+    histogram = td::make_unique<Histogram>(min_bucket_bound);
+  }
+  return histogram.get();
+}
+
+vector<MetricsRegistry::Metric> MetricsRegistry::get_metrics() {
+  vector<Metric> result;
+  auto &registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto &it : registry.counters) {
+    Metric metric;
+    metric.name = it.first;
+    metric.type = Slice("counter");
+    metric.samples.emplace_back(it.first, static_cast<double>(it.second->get()));
+    result.push_back(std::move(metric));
+  }
+  for (auto &it : registry.histograms) {
+    const auto &histogram = *it.second;
+    Metric metric;
+    metric.name = it.first;
+    metric.type = Slice("histogram");
+    for (size_t bucket = 0; bucket < Histogram::BUCKET_COUNT; bucket++) {
+      metric.samples.emplace_back(PSTRING() << it.first << "_bucket{le=\"" << histogram.get_bucket_bound(bucket)
+                                            << "\"}",
+                                  static_cast<double>(histogram.get_cumulative_count(bucket)));
+    }
+    auto count = static_cast<double>(histogram.get_count());
+    metric.samples.emplace_back(PSTRING() << it.first << "_bucket{le=\"+Inf\"}", count);
+    metric.samples.emplace_back(PSTRING() << it.first << "_sum", histogram.get_sum());
+    metric.samples.emplace_back(PSTRING() << it.first << "_count", count);
+    result.push_back(std::move(metric));
+  }
+  std::sort(result.begin(), result.end(), [](const Metric &lhs, const Metric &rhs) { return lhs.name < rhs.name; });
+  return result;
+}
+
+MetricsRegistry::Metric MetricsRegistry::get_gauge(Slice name, double value) {
+  Metric metric;
+  metric.name = name.str();
+  metric.type = Slice("gauge");
+  metric.samples.emplace_back(metric.name, value);
+  return metric;
+}
+
+string MetricsRegistry::get_prometheus_text(const vector<Metric> &metrics) {
+  string result;
+  for (auto &metric : metrics) {
+    result += PSTRING() << "# TYPE " << metric.name << ' ' << metric.type << '\n';
+    for (auto &sample : metric.samples) {
+      auto value = sample.second;
+      if (value == std::floor(value) && std::abs(value) < 1e15) {
+        result += PSTRING() << sample.first << ' ' << static_cast<int64>(value) << '\n';
+      } else {
+        result += PSTRING() << sample.first << ' ' << value << '\n';
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace td
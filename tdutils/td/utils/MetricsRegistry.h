@@ -0,0 +1,83 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/ThreadSafeCounter.h"
+
+#include <utility>
+
+namespace td {
+
+// process-wide counters and histograms, which are updated without locks in per-thread storage and merged on read
+class MetricsRegistry {
+ public:
+  class Counter {
+   public:
+    void add(int64 diff) {
+      counter_.add(diff);
+    }
+
+    int64 get() const {
+      return counter_.sum();
+    }
+
+   private:
+    ThreadSafeCounter counter_;
+  };
+
+  // histogram of non-negative values with bucket upper bounds min_bucket_bound * 2^i
+  class Histogram {
+   public:
+    static constexpr size_t BUCKET_COUNT = 20;
+
+    explicit Histogram(double min_bucket_bound) : min_bucket_bound_(min_bucket_bound) {
+    }
+
+    void observe(double value);
+
+    double get_bucket_bound(size_t bucket) const;
+
+    // returns the number of values not greater than the bucket upper bound
+    int64 get_cumulative_count(size_t bucket) const;
+
+    int64 get_count() const {
+      return counters_.sum(BUCKET_COUNT);
+    }
+
+    double get_sum() const {
+      return static_cast<double>(counters_.sum(BUCKET_COUNT + 1)) * 1e-6;
+    }
+
+   private:
+    double min_bucket_bound_;
+
+    // the buckets are followed by the total number of values and the sum of the values in millionths
+    ThreadSafeMultiCounter<BUCKET_COUNT + 2> counters_;
+  };
+
+  struct Metric {
+    string name;
+    Slice type;  // "counter", "gauge" or "histogram"
+    vector<std::pair<string, double>> samples;  // full names of samples with labels and their values
+  };
+
+  // the returned objects are never destroyed; the name must be a valid Prometheus metric name
+  static Counter *get_counter(Slice name);
+
+  static Histogram *get_histogram(Slice name, double min_bucket_bound);
+
+  // the metrics are sorted by name
+  static vector<Metric> get_metrics();
+
+  static Metric get_gauge(Slice name, double value);
+
+  static string get_prometheus_text(const vector<Metric> &metrics);
+};
+
+}  // namespace td
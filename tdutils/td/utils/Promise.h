@@ -12,6 +12,8 @@
 #include "td/utils/MovableValue.h"
 #include "td/utils/Status.h"
 
+#include <cstddef>
+#include <new>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -176,47 +178,48 @@ template <class T, class F,
 auto promise_interface(F &&f) {
   return lambda_promise<T>(std::forward<F>(f));
 }
-
-template <class T, class F,
-          std::enable_if_t<is_promise_interface_ptr<std::decay_t<F>>::value, bool> from_promise_interface = true>
-auto promise_interface_ptr(F &&f) {
-  return std::forward<F>(f);
-}
-
-template <class T, class F,
-          std::enable_if_t<!is_promise_interface_ptr<std::decay_t<F>>::value, bool> from_promise_interface = false>
-auto promise_interface_ptr(F &&f) {
-  return td::make_unique<std::decay_t<decltype(promise_interface<T>(std::forward<F>(f)))>>(
-      promise_interface<T>(std::forward<F>(f)));
-}
 }  // namespace detail
 
+// small promise implementations are stored inline without a memory allocation;
+// the storage fits lambda promises capturing up to 16 bytes, for example an actor identifier,
+// and is kept small, because promises are moved a lot and are often captured by other promises
 template <class T>
 class Promise {
  public:
+  static constexpr size_t INLINE_STORAGE_SIZE = 32;
+
   void set_value(T &&value) {
     if (!promise_) {
       return;
     }
     promise_->set_value(std::move(value));
-    promise_.reset();
+    reset();
   }
   void set_error(Status &&error) {
     if (!promise_) {
       return;
     }
     promise_->set_error(std::move(error));
-    promise_.reset();
+    reset();
   }
   void set_result(Result<T> &&result) {
     if (!promise_) {
       return;
     }
     promise_->set_result(std::move(result));
-    promise_.reset();
+    reset();
   }
   void reset() {
-    promise_.reset();
+    if (promise_ == nullptr) {
+      return;
+    }
+    if (relocate_ == nullptr) {
+      delete promise_;
+    } else {
+      promise_->~PromiseInterface<T>();
+    }
+    promise_ = nullptr;
+    relocate_ = nullptr;
   }
   bool is_cancellable() const {
     if (!promise_) {
@@ -231,28 +234,107 @@ class Promise {
     return promise_->is_canceled();
   }
   unique_ptr<PromiseInterface<T>> release() {
-    return std::move(promise_);
+    if (relocate_ != nullptr) {
+      promise_ = relocate_(promise_, nullptr);
+      relocate_ = nullptr;
+    }
+    auto result = unique_ptr<PromiseInterface<T>>(promise_);
+    promise_ = nullptr;
+    return result;
+  }
+
+  bool is_inline() const {
+    return relocate_ != nullptr;
   }
 
   Promise() = default;
-  explicit Promise(unique_ptr<PromiseInterface<T>> promise) : promise_(std::move(promise)) {
+  explicit Promise(unique_ptr<PromiseInterface<T>> promise) : promise_(promise.release()) {
   }
   Promise(Auto) {
   }
   Promise(SafePromise<T> &&other);
   Promise &operator=(SafePromise<T> &&other);
   template <class F, std::enable_if_t<!std::is_same<std::decay_t<F>, Promise>::value, int> = 0>
-  Promise(F &&f) : promise_(detail::promise_interface_ptr<T>(std::forward<F>(f))) {
+  Promise(F &&f) {
+    init(std::forward<F>(f), detail::is_promise_interface_ptr<std::decay_t<F>>());
+  }
+  Promise(const Promise &) = delete;
+  Promise &operator=(const Promise &) = delete;
+  Promise(Promise &&other) noexcept {
+    move_from(other);
+  }
+  Promise &operator=(Promise &&other) noexcept {
+    if (this != &other) {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+  ~Promise() {
+    reset();
   }
 
   explicit operator bool() const noexcept {
-    return static_cast<bool>(promise_);
+    return promise_ != nullptr;
   }
 
  private:
-  unique_ptr<PromiseInterface<T>> promise_;
+  // moves the promise to the storage, or to the heap if the storage is null, and returns the new promise
+  using RelocateFunc = PromiseInterface<T> *(*)(PromiseInterface<T> *promise, void *storage);
+
+  PromiseInterface<T> *promise_ = nullptr;
+  RelocateFunc relocate_ = nullptr;  // non-null if and only if the promise is stored inline
+  alignas(std::max_align_t) char storage_[INLINE_STORAGE_SIZE];
+
+  template <class ImplT>
+  static PromiseInterface<T> *relocate(PromiseInterface<T> *promise, void *storage) {
+    auto *impl = static_cast<ImplT *>(promise);
+    PromiseInterface<T> *result =
+        storage == nullptr ? new ImplT(std::move(*impl)) : new (storage) ImplT(std::move(*impl));
+    impl->~ImplT();
+    return result;
+  }
+
+  template <class F>
+  void init(F &&f, std::true_type /*is_promise_interface_ptr*/) {
+    promise_ = f.release();
+  }
+
+  template <class F>
+  void init(F &&f, std::false_type /*is_promise_interface_ptr*/) {
+    using ImplT = std::decay_t<decltype(detail::promise_interface<T>(std::forward<F>(f)))>;
+    using IsInline = std::integral_constant<bool, sizeof(ImplT) <= INLINE_STORAGE_SIZE &&
+                                                      alignof(ImplT) <= alignof(std::max_align_t) &&
+                                                      std::is_nothrow_move_constructible<ImplT>::value>;
+    emplace<ImplT>(detail::promise_interface<T>(std::forward<F>(f)), IsInline());
+  }
+
+  template <class ImplT, class ArgT>
+  void emplace(ArgT &&arg, std::true_type /*is_inline*/) {
+    promise_ = new (storage_) ImplT(std::forward<ArgT>(arg));
+    relocate_ = &relocate<ImplT>;
+  }
+
+  template <class ImplT, class ArgT>
+  void emplace(ArgT &&arg, std::false_type /*is_inline*/) {
+    promise_ = new ImplT(std::forward<ArgT>(arg));
+  }
+
+  void move_from(Promise &other) noexcept {
+    if (other.relocate_ != nullptr) {
+      promise_ = other.relocate_(other.promise_, storage_);
+      relocate_ = other.relocate_;
+    } else {
+      promise_ = other.promise_;
+    }
+    other.promise_ = nullptr;
+    other.relocate_ = nullptr;
+  }
 };
 
+template <class T>
+constexpr size_t Promise<T>::INLINE_STORAGE_SIZE;
+
 template <class T = Unit>
 class SafePromise {
  public:
@@ -326,7 +408,7 @@ class PromiseCreator {
  public:
   template <class OkT, class ArgT = detail::drop_result_t<detail::get_arg_t<OkT>>>
   static Promise<ArgT> lambda(OkT &&ok) {
-    return Promise<ArgT>(td::make_unique<detail::LambdaPromise<ArgT, std::decay_t<OkT>>>(std::forward<OkT>(ok)));
+    return Promise<ArgT>(std::forward<OkT>(ok));
   }
 
   template <class OkT, class ArgT = detail::drop_result_t<detail::get_arg_t<OkT>>>
@@ -43,7 +43,7 @@ class ThreadLocalStorage {
   };
   static constexpr int32 MAX_THREAD_ID = 128;
   std::atomic<int32> max_thread_id_{MAX_THREAD_ID};
-  std::array<Node, MAX_THREAD_ID> nodes_;
+  std::array<Node, MAX_THREAD_ID> nodes_{};  // must be zero-initialized even if allocated on the heap
 
   Node &thread_local_node() {
     auto thread_id = get_thread_id();
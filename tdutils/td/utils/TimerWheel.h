@@ -0,0 +1,199 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/List.h"
+
+#include <utility>
+
+namespace td {
+
+class TimerWheelNode : private ListNode {
+ public:
+  bool in_timer_wheel() const {
+    return !empty();
+  }
+
+  double get_timeout_at() const {
+    return timeout_at_;
+  }
+
+ private:
+  friend class TimerWheel;
+
+  double timeout_at_ = 0.0;
+  int32 bucket_ = -1;
+};
+
+// hierarchical timing wheel with O(1) insert and erase
+// a timeout expires not earlier than requested and at most one tick of TICKS_PER_SECOND later
+// nodes must be erased from the wheel before they are destroyed
+class TimerWheel {
+ public:
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  // restarts an empty wheel from the given time
+  void set_current_time(double now) {
+    CHECK(empty());
+    current_tick_ = get_tick(now);
+  }
+
+  void insert(double timeout_at, TimerWheelNode *node) {
+    CHECK(!node->in_timer_wheel());
+    node->timeout_at_ = timeout_at;
+    place(node);
+    size_++;
+  }
+
+  void erase(TimerWheelNode *node) {
+    CHECK(node->in_timer_wheel());
+    unlink(node);
+    size_--;
+  }
+
+  // returns the earliest time at which run_expired can expire a timeout or move timeouts between levels
+  double get_next_event_time() const {
+    CHECK(!empty());
+    return static_cast<double>(get_next_event_tick() + 1) / TICKS_PER_SECOND;
+  }
+
+  // removes all nodes, which timeouts expired before now, and calls f for each of them in order of expiration ticks
+  // nodes expiring in the same tick are processed in order of insertion, because slots are FIFO lists and nodes moved
+  // from an outer level are placed to an inner level slot before any node can be inserted directly to it
+  // f can destroy the node, but must not change the wheel
+  template <class F>
+  void run_expired(double now, F &&f) {
+    auto target_tick = get_tick(now);
+    while (size_ != 0) {
+      auto tick = get_next_event_tick();
+      if (tick >= target_tick) {
+        break;
+      }
+      move_to_tick(tick);
+
+      auto &level = *levels_[0];
+      auto slot_id = static_cast<int32>(tick & SLOT_MASK);
+      auto &slot = level.slots_[slot_id];
+      while (!slot.empty()) {
+        auto *node = static_cast<TimerWheelNode *>(slot.get());
+        node->bucket_ = -1;
+        size_--;
+        f(node);
+      }
+      level.occupied_mask_ &= ~(static_cast<uint64>(1) << slot_id);
+
+      move_to_tick(tick + 1);
+    }
+    if (current_tick_ < target_tick) {
+      move_to_tick(target_tick);
+    }
+  }
+
+ private:
+  static constexpr int32 TICKS_PER_SECOND = 1000;
+  static constexpr int32 SLOT_BITS = 6;
+  static constexpr int32 SLOT_COUNT = 1 << SLOT_BITS;
+  static constexpr int64 SLOT_MASK = SLOT_COUNT - 1;
+  static constexpr int32 MAX_LEVEL_COUNT = 8;
+  static constexpr int64 MAX_TICK = (static_cast<int64>(1) << (SLOT_BITS * MAX_LEVEL_COUNT)) - 1;
+
+  struct Level {
+    ListNode slots_[SLOT_COUNT];
+    uint64 occupied_mask_ = 0;
+  };
+
+  // levels are allocated on demand; level i contains timeouts expiring in less than 64^(i + 1) ticks
+  vector<unique_ptr<Level>> levels_;
+  int64 current_tick_ = 0;
+  size_t size_ = 0;
+
+  static int64 get_tick(double time) {
+    if (!(time > 0.0)) {
+      return 0;
+    }
+    auto tick = time * TICKS_PER_SECOND;
+    if (tick >= static_cast<double>(MAX_TICK)) {
+      return MAX_TICK;
+    }
+    return static_cast<int64>(tick);
+  }
+
+  // all nodes on level 0 are in slots not less than the current one and all nodes
+  // on other levels are in slots greater than the current one in the same outer slot
+  int64 get_next_event_tick() const {
+    for (size_t i = 0; i < levels_.size(); i++) {
+      auto mask = levels_[i]->occupied_mask_;
+      if (mask != 0) {
+        auto shift = static_cast<int32>(i) * SLOT_BITS;
+        auto slot_id = static_cast<int64>(count_trailing_zeroes_non_zero64(mask));
+        auto result = ((current_tick_ >> (shift + SLOT_BITS)) << (shift + SLOT_BITS)) | (slot_id << shift);
+        DCHECK(result >= current_tick_);
+        return result;
+      }
+    }
+    UNREACHABLE();
+    return MAX_TICK;
+  }
+
+  void place(TimerWheelNode *node) {
+    auto tick = max(get_tick(node->timeout_at_), current_tick_);
+    auto diff = static_cast<uint64>(tick ^ current_tick_);
+    auto level_id = diff < static_cast<uint64>(SLOT_COUNT) ? 0
+                                                           : (63 - count_leading_zeroes_non_zero64(diff)) / SLOT_BITS;
+    auto slot_id = static_cast<int32>((tick >> (level_id * SLOT_BITS)) & SLOT_MASK);
+    while (levels_.size() <= static_cast<size_t>(level_id)) {
+      levels_.push_back(make_unique<Level>());
+    }
+    auto &level = *levels_[level_id];
+    level.slots_[slot_id].put(node);
+    level.occupied_mask_ |= static_cast<uint64>(1) << slot_id;
+    node->bucket_ = level_id * SLOT_COUNT + slot_id;
+  }
+
+  void unlink(TimerWheelNode *node) {
+    auto &level = *levels_[node->bucket_ / SLOT_COUNT];
+    auto slot_id = node->bucket_ % SLOT_COUNT;
+    node->remove();
+    if (level.slots_[slot_id].empty()) {
+      level.occupied_mask_ &= ~(static_cast<uint64>(1) << slot_id);
+    }
+    node->bucket_ = -1;
+  }
+
+  // moves timeouts from the slots, which start at the new tick, to lower levels
+  void move_to_tick(int64 tick) {
+    DCHECK(tick >= current_tick_);
+    current_tick_ = tick;
+    for (auto i = levels_.size(); i-- > 1;) {
+      auto shift = static_cast<int32>(i) * SLOT_BITS;
+      if ((tick & ((static_cast<int64>(1) << shift) - 1)) != 0) {
+        continue;
+      }
+      auto &level = *levels_[i];
+      auto slot_id = static_cast<int32>((tick >> shift) & SLOT_MASK);
+      auto slot_bit = static_cast<uint64>(1) << slot_id;
+      if ((level.occupied_mask_ & slot_bit) == 0) {
+        continue;
+      }
+      level.occupied_mask_ &= ~slot_bit;
+      ListNode nodes = std::move(level.slots_[slot_id]);
+      while (!nodes.empty()) {
+        place(static_cast<TimerWheelNode *>(nodes.get()));
+      }
+    }
+  }
+};
+
+}  // namespace td
@@ -6,9 +6,11 @@
 //
 #include "td/utils/buffer.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/logging.h"
 #include "td/utils/port/thread_local.h"
 
+#include <array>
 #include <cstddef>
 #include <new>
 
@@ -25,6 +27,51 @@ TD_THREAD_LOCAL BufferAllocator::BufferRawTls *BufferAllocator::buffer_raw_tls;
 
 std::atomic<size_t> BufferAllocator::buffer_mem;
 
+namespace {
+
+// data of small buffers is allocated in size classes with 4 classes per power of two from 640 bytes to 64 KB,
+// bigger buffers are allocated with their exact size
+constexpr int BUFFER_SIZE_CLASS_COUNT = 28;
+constexpr size_t MAX_CACHED_BUFFER_COUNT = 32;     // per size class
+constexpr size_t MAX_CACHED_BUFFER_SIZE = 1 << 20;  // per thread
+
+int get_buffer_size_class(size_t data_size) {
+  auto m = static_cast<uint64>(data_size - 1);
+  if (m < 512) {
+    return 0;
+  }
+  int k = 63 - count_leading_zeroes64(m);
+  auto size_class = (k - 9) * 4 + static_cast<int>((m >> (k - 2)) & 3);
+  return size_class < BUFFER_SIZE_CLASS_COUNT ? size_class : -1;
+}
+
+size_t get_buffer_size_class_size(int size_class) {
+  return static_cast<size_t>(5 + size_class % 4) << (size_class / 4 + 7);
+}
+
+// released buffers are cached by the thread that released them and reused by subsequent allocations
+struct BufferRawCache {
+  std::array<vector<char *>, BUFFER_SIZE_CLASS_COUNT> buffers;
+  size_t size = 0;
+
+  BufferRawCache() = default;
+  BufferRawCache(const BufferRawCache &) = delete;
+  BufferRawCache &operator=(const BufferRawCache &) = delete;
+  BufferRawCache(BufferRawCache &&) = delete;
+  BufferRawCache &operator=(BufferRawCache &&) = delete;
+  ~BufferRawCache() {
+    for (auto &class_buffers : buffers) {
+      for (auto *buffer : class_buffers) {
+        delete[] buffer;
+      }
+    }
+  }
+};
+
+TD_THREAD_LOCAL BufferRawCache *buffer_raw_cache;  // static zero-initialized
+
+}  // namespace
+
 int64 BufferAllocator::get_buffer_slice_size() {
   return 0;
 }
@@ -89,10 +136,23 @@ BufferAllocator::ReaderPtr BufferAllocator::create_reader(const ReaderPtr &raw)
 void BufferAllocator::dec_ref_cnt(BufferRaw *ptr) {
   int left = ptr->ref_cnt_.fetch_sub(1, std::memory_order_acq_rel);
   if (left == 1) {
-    auto buf_size = max(sizeof(BufferRaw), TD_OFFSETOF(BufferRaw, data_) + ptr->data_size_);
+    auto size_class = get_buffer_size_class(ptr->data_size_);
+    auto data_size = size_class >= 0 ? get_buffer_size_class_size(size_class) : ptr->data_size_;
+    auto buf_size = max(sizeof(BufferRaw), TD_OFFSETOF(BufferRaw, data_) + data_size);
     buffer_mem -= buf_size;
     ptr->~BufferRaw();
-    delete[] ptr;
+
+    auto *buffer = reinterpret_cast<char *>(ptr);
+    auto *cache = buffer_raw_cache;
+    if (size_class >= 0 && cache != nullptr && cache->size + buf_size <= MAX_CACHED_BUFFER_SIZE) {
+      auto &class_buffers = cache->buffers[size_class];
+      if (class_buffers.size() < MAX_CACHED_BUFFER_COUNT) {
+        class_buffers.push_back(buffer);
+        cache->size += buf_size;
+        return;
+      }
+    }
+    delete[] buffer;
   }
 }
 
@@ -105,13 +165,27 @@ size_t ChainBufferReader::advance(size_t offset, MutableSlice dest) {
 BufferRaw *BufferAllocator::create_buffer_raw(size_t size) {
   size = (size + 7) & -8;
 
-  auto buf_size = TD_OFFSETOF(BufferRaw, data_) + size;
+  auto size_class = get_buffer_size_class(size);
+  auto data_size = size_class >= 0 ? get_buffer_size_class_size(size_class) : size;
+  auto buf_size = TD_OFFSETOF(BufferRaw, data_) + data_size;
   if (buf_size < sizeof(BufferRaw)) {
     buf_size = sizeof(BufferRaw);
   }
+  char *buffer = nullptr;
+  if (size_class >= 0) {
+    init_thread_local<BufferRawCache>(buffer_raw_cache);
+    auto &class_buffers = buffer_raw_cache->buffers[size_class];
+    if (!class_buffers.empty()) {
+      buffer = class_buffers.back();
+      class_buffers.pop_back();
+      buffer_raw_cache->size -= buf_size;
+    }
+  }
+  if (buffer == nullptr) {
+    buffer = new char[buf_size];
+  }
   buffer_mem += buf_size;
-  auto *buffer_raw = reinterpret_cast<BufferRaw *>(new char[buf_size]);
-  return new (buffer_raw) BufferRaw(size);
+  return new (buffer) BufferRaw(size);
 }
 
 void BufferBuilder::append(BufferSlice slice) {
@@ -735,7 +735,8 @@ class ChainBufferWriter {
     auto ready = prepare_append_inplace();
     // TODO(perf): we have to store some stats in ChainBufferWriter
     // for better append logic
-    if (slice.size() < (1 << 8) || ready.size() >= slice.size()) {
+    // large slices are always linked to avoid copying them, they are gathered by writev anyway
+    if (slice.size() < (1 << 8) || (ready.size() >= slice.size() && slice.size() < MAX_COPIED_SLICE_SIZE)) {
       return append(slice.as_slice());
     }
 
@@ -766,6 +767,8 @@ class ChainBufferWriter {
     return !tail_;
   }
 
+  static constexpr size_t MAX_COPIED_SLICE_SIZE = 1 << 12;
+
   BufferWriter writer_;
   ChainBufferNodeWriterPtr tail_;
   ChainBufferNodeReaderPtr head_;
@@ -48,6 +48,14 @@
 #include "crc32c/crc32c.h"
 #endif
 
+#if TD_HAVE_OPENSSL && (TD_GCC || TD_CLANG) && defined(__x86_64__) && !TD_EMSCRIPTEN
+#define TD_HAVE_AES_NI 1
+#include <cpuid.h>
+#include <wmmintrin.h>
+#else
+#define TD_HAVE_AES_NI 0
+#endif
+
 #include <algorithm>
 #include <cerrno>
 #include <cstring>
@@ -554,6 +562,150 @@ class AesIgeStateImpl {
   AesBlock plaintext_iv_;
 };
 
+#if TD_HAVE_AES_NI
+#define TD_AES_NI_TARGET __attribute__((target("aes,sse2")))
+
+static bool has_aes_ni() {
+  static const bool result = [] {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_AES) != 0;
+  }();
+  return result;
+}
+
+static constexpr size_t AES_NI_MAX_LANE_COUNT = 8;
+
+// state of one buffer processed by the multi-buffer AES-IGE engine
+struct AesNiIgeLane {
+  __m128i round_keys[15];
+  __m128i prev_output;
+  __m128i prev_input;
+  uint8 *data;
+  size_t block_count;
+  AesIgeBuffer *buffer;
+};
+
+TD_AES_NI_TARGET static __m128i aes_ni_expand_key_even(__m128i key, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, 0xff);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 8));
+  return _mm_xor_si128(key, assist);
+}
+
+TD_AES_NI_TARGET static __m128i aes_ni_expand_key_odd(__m128i even_key, __m128i key) {
+  auto assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(even_key, 0x00), 0xaa);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 8));
+  return _mm_xor_si128(key, assist);
+}
+
+TD_AES_NI_TARGET static void aes_ni_expand_key(const uint8 *key, __m128i *round_keys) {
+  round_keys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key));
+  round_keys[1] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key + AES_BLOCK_SIZE));
+  round_keys[2] = aes_ni_expand_key_even(round_keys[0], _mm_aeskeygenassist_si128(round_keys[1], 0x01));
+  round_keys[3] = aes_ni_expand_key_odd(round_keys[2], round_keys[1]);
+  round_keys[4] = aes_ni_expand_key_even(round_keys[2], _mm_aeskeygenassist_si128(round_keys[3], 0x02));
+  round_keys[5] = aes_ni_expand_key_odd(round_keys[4], round_keys[3]);
+  round_keys[6] = aes_ni_expand_key_even(round_keys[4], _mm_aeskeygenassist_si128(round_keys[5], 0x04));
+  round_keys[7] = aes_ni_expand_key_odd(round_keys[6], round_keys[5]);
+  round_keys[8] = aes_ni_expand_key_even(round_keys[6], _mm_aeskeygenassist_si128(round_keys[7], 0x08));
+  round_keys[9] = aes_ni_expand_key_odd(round_keys[8], round_keys[7]);
+  round_keys[10] = aes_ni_expand_key_even(round_keys[8], _mm_aeskeygenassist_si128(round_keys[9], 0x10));
+  round_keys[11] = aes_ni_expand_key_odd(round_keys[10], round_keys[9]);
+  round_keys[12] = aes_ni_expand_key_even(round_keys[10], _mm_aeskeygenassist_si128(round_keys[11], 0x20));
+  round_keys[13] = aes_ni_expand_key_odd(round_keys[12], round_keys[11]);
+  round_keys[14] = aes_ni_expand_key_even(round_keys[12], _mm_aeskeygenassist_si128(round_keys[13], 0x40));
+}
+
+TD_AES_NI_TARGET static void aes_ni_init_lane(AesNiIgeLane &lane, AesIgeBuffer &buffer, bool encrypt) {
+  CHECK(buffer.data.size() % AES_BLOCK_SIZE == 0);
+  __m128i round_keys[15];
+  aes_ni_expand_key(buffer.key.raw, round_keys);
+  if (encrypt) {
+    std::memcpy(lane.round_keys, round_keys, sizeof(round_keys));
+  } else {
+    lane.round_keys[0] = round_keys[14];
+    for (int i = 1; i < 14; i++) {
+      lane.round_keys[i] = _mm_aesimc_si128(round_keys[14 - i]);
+    }
+    lane.round_keys[14] = round_keys[0];
+  }
+
+  // IV consists of the previous encrypted block followed by the previous plaintext block
+  auto encrypted_iv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer.iv.raw));
+  auto plaintext_iv = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer.iv.raw + AES_BLOCK_SIZE));
+  lane.prev_output = encrypt ? encrypted_iv : plaintext_iv;
+  lane.prev_input = encrypt ? plaintext_iv : encrypted_iv;
+  lane.data = buffer.data.ubegin();
+  lane.block_count = buffer.data.size() / AES_BLOCK_SIZE;
+  lane.buffer = &buffer;
+}
+
+TD_AES_NI_TARGET static void aes_ni_finish_lane(const AesNiIgeLane &lane, bool encrypt) {
+  auto *iv = lane.buffer->iv.raw;
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(iv), encrypt ? lane.prev_output : lane.prev_input);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(iv + AES_BLOCK_SIZE), encrypt ? lane.prev_input : lane.prev_output);
+}
+
+// IGE is serial within a buffer, but rounds for blocks of different buffers are independent,
+// so processing several buffers simultaneously hides the latency of AES instructions
+template <bool encrypt>
+TD_AES_NI_TARGET static void aes_ni_ige_process(AesNiIgeLane *lanes, size_t lane_count) {
+  CHECK(lane_count <= AES_NI_MAX_LANE_COUNT);
+  while (true) {
+    for (size_t i = 0; i < lane_count;) {
+      if (lanes[i].block_count == 0) {
+        aes_ni_finish_lane(lanes[i], encrypt);
+        lanes[i] = lanes[--lane_count];
+      } else {
+        i++;
+      }
+    }
+    if (lane_count == 0) {
+      break;
+    }
+
+    __m128i input[AES_NI_MAX_LANE_COUNT];
+    __m128i state[AES_NI_MAX_LANE_COUNT];
+    for (size_t i = 0; i < lane_count; i++) {
+      input[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes[i].data));
+      state[i] = _mm_xor_si128(_mm_xor_si128(input[i], lanes[i].prev_output), lanes[i].round_keys[0]);
+    }
+    for (int round = 1; round < 14; round++) {
+      for (size_t i = 0; i < lane_count; i++) {
+        state[i] = encrypt ? _mm_aesenc_si128(state[i], lanes[i].round_keys[round])
+                           : _mm_aesdec_si128(state[i], lanes[i].round_keys[round]);
+      }
+    }
+    for (size_t i = 0; i < lane_count; i++) {
+      state[i] = encrypt ? _mm_aesenclast_si128(state[i], lanes[i].round_keys[14])
+                         : _mm_aesdeclast_si128(state[i], lanes[i].round_keys[14]);
+      state[i] = _mm_xor_si128(state[i], lanes[i].prev_input);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes[i].data), state[i]);
+      lanes[i].prev_output = state[i];
+      lanes[i].prev_input = input[i];
+      lanes[i].data += AES_BLOCK_SIZE;
+      lanes[i].block_count--;
+    }
+  }
+}
+
+template <bool encrypt>
+static void aes_ni_ige_batch(MutableSpan<AesIgeBuffer> buffers) {
+  AesNiIgeLane lanes[AES_NI_MAX_LANE_COUNT];
+  for (size_t offset = 0; offset < buffers.size(); offset += AES_NI_MAX_LANE_COUNT) {
+    auto lane_count = td::min(AES_NI_MAX_LANE_COUNT, buffers.size() - offset);
+    for (size_t i = 0; i < lane_count; i++) {
+      aes_ni_init_lane(lanes[i], buffers[offset + i], encrypt);
+    }
+    aes_ni_ige_process<encrypt>(lanes, lane_count);
+  }
+}
+#endif
+
 AesIgeState::AesIgeState() = default;
 AesIgeState::AesIgeState(AesIgeState &&) noexcept = default;
 AesIgeState &AesIgeState::operator=(AesIgeState &&) noexcept = default;
@@ -575,7 +727,34 @@ void AesIgeState::decrypt(Slice from, MutableSlice to) {
   impl_->decrypt(from, to);
 }
 
+#if TD_HAVE_AES_NI
+static void aes_ni_ige(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to, bool encrypt) {
+  CHECK(aes_key.size() == 32);
+  CHECK(aes_iv.size() == 32);
+  CHECK(from.size() % AES_BLOCK_SIZE == 0);
+  CHECK(to.size() >= from.size());
+  if (from.begin() != to.begin()) {
+    to.copy_from(from);
+  }
+  AesIgeBuffer buffer;
+  buffer.key.as_mutable_slice().copy_from(aes_key);
+  buffer.iv.as_mutable_slice().copy_from(aes_iv);
+  buffer.data = to.substr(0, from.size());
+  if (encrypt) {
+    aes_ni_ige_batch<true>(MutableSpan<AesIgeBuffer>(&buffer, 1));
+  } else {
+    aes_ni_ige_batch<false>(MutableSpan<AesIgeBuffer>(&buffer, 1));
+  }
+  aes_iv.copy_from(buffer.iv.as_slice());
+}
+#endif
+
 void aes_ige_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to) {
+#if TD_HAVE_AES_NI
+  if (has_aes_ni()) {
+    return aes_ni_ige(aes_key, aes_iv, from, to, true);
+  }
+#endif
   AesIgeStateImpl state;
   state.init(aes_key, aes_iv, true);
   state.encrypt(from, to);
@@ -583,12 +762,39 @@ void aes_ige_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlic
 }
 
 void aes_ige_decrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to) {
+#if TD_HAVE_AES_NI
+  if (has_aes_ni()) {
+    return aes_ni_ige(aes_key, aes_iv, from, to, false);
+  }
+#endif
   AesIgeStateImpl state;
   state.init(aes_key, aes_iv, false);
   state.decrypt(from, to);
   state.get_iv(aes_iv);
 }
 
+void aes_ige_encrypt_batch(MutableSpan<AesIgeBuffer> buffers) {
+#if TD_HAVE_AES_NI
+  if (has_aes_ni()) {
+    return aes_ni_ige_batch<true>(buffers);
+  }
+#endif
+  for (auto &buffer : buffers) {
+    aes_ige_encrypt(as_slice(buffer.key), as_mutable_slice(buffer.iv), buffer.data, buffer.data);
+  }
+}
+
+void aes_ige_decrypt_batch(MutableSpan<AesIgeBuffer> buffers) {
+#if TD_HAVE_AES_NI
+  if (has_aes_ni()) {
+    return aes_ni_ige_batch<false>(buffers);
+  }
+#endif
+  for (auto &buffer : buffers) {
+    aes_ige_decrypt(as_slice(buffer.key), as_mutable_slice(buffer.iv), buffer.data, buffer.data);
+  }
+}
+
 void aes_cbc_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to) {
   CHECK(from.size() <= to.size());
   CHECK(from.size() % 16 == 0);
@@ -1330,8 +1536,33 @@ static const uint64 crc64_table[256] = {
     0xe0ada17364673f59};
 
 static uint64 crc64_partial(Slice data, uint64 crc) {
-  const char *p = data.begin();
-  for (auto len = data.size(); len > 0; len--) {
+  // slicing-by-8: crc64_tables[k][i] is CRC of the byte i followed by k zero bytes
+  static uint64 crc64_tables_raw[8][256];
+  static const uint64(*crc64_tables)[256] = [] {
+    auto *tables = crc64_tables_raw;
+    for (int i = 0; i < 256; i++) {
+      tables[0][i] = crc64_table[i];
+    }
+    for (int k = 1; k < 8; k++) {
+      for (int i = 0; i < 256; i++) {
+        auto prev = tables[k - 1][i];
+        tables[k][i] = crc64_table[prev & 0xff] ^ (prev >> 8);
+      }
+    }
+    return tables;
+  }();
+
+  const unsigned char *p = data.ubegin();
+  auto len = data.size();
+  for (; len >= 8; len -= 8, p += 8) {
+    crc ^= static_cast<uint64>(p[0]) | (static_cast<uint64>(p[1]) << 8) | (static_cast<uint64>(p[2]) << 16) |
+           (static_cast<uint64>(p[3]) << 24) | (static_cast<uint64>(p[4]) << 32) | (static_cast<uint64>(p[5]) << 40) |
+           (static_cast<uint64>(p[6]) << 48) | (static_cast<uint64>(p[7]) << 56);
+    crc = crc64_tables[7][crc & 0xff] ^ crc64_tables[6][(crc >> 8) & 0xff] ^ crc64_tables[5][(crc >> 16) & 0xff] ^
+          crc64_tables[4][(crc >> 24) & 0xff] ^ crc64_tables[3][(crc >> 32) & 0xff] ^
+          crc64_tables[2][(crc >> 40) & 0xff] ^ crc64_tables[1][(crc >> 48) & 0xff] ^ crc64_tables[0][crc >> 56];
+  }
+  for (; len > 0; len--) {
     crc = crc64_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
   }
   return crc;
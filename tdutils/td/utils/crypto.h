@@ -10,7 +10,9 @@
 #include "td/utils/common.h"
 #include "td/utils/SharedSlice.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
+#include "td/utils/UInt.h"
 
 namespace td {
 
@@ -44,6 +46,18 @@ class AesState {
 void aes_ige_encrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to);
 void aes_ige_decrypt(Slice aes_key, MutableSlice aes_iv, Slice from, MutableSlice to);
 
+// a buffer encrypted or decrypted in place by aes_ige_encrypt_batch and aes_ige_decrypt_batch
+struct AesIgeBuffer {
+  UInt256 key;
+  UInt256 iv;
+  MutableSlice data;
+};
+
+// the same as aes_ige_encrypt and aes_ige_decrypt for each of the buffers, but independent buffers are processed
+// simultaneously if the CPU supports AES-NI; IVs of the buffers are updated
+void aes_ige_encrypt_batch(MutableSpan<AesIgeBuffer> buffers);
+void aes_ige_decrypt_batch(MutableSpan<AesIgeBuffer> buffers);
+
 class AesIgeStateImpl;
 
 class AesIgeState {
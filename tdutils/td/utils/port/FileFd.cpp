@@ -376,6 +376,35 @@ Result<size_t> FileFd::pwrite(Slice slice, int64 offset) {
   return OS_ERROR(PSLICE() << "Pwrite to " << get_native_fd() << " at offset " << offset << " has failed");
 }
 
+Result<size_t> FileFd::pwritev(Span<IoSlice> slices, int64 offset) {
+  if (offset < 0) {
+    return Status::Error("Offset must be non-negative");
+  }
+#if TD_LINUX || TD_FREEBSD
+  auto native_fd = get_native_fd().fd();
+  TRY_RESULT(offset_off_t, narrow_cast_safe<off_t>(offset));
+  TRY_RESULT(slices_size, narrow_cast_safe<int>(slices.size()));
+  auto bytes_written =
+      detail::skip_eintr([&] { return ::pwritev(native_fd, slices.begin(), slices_size, offset_off_t); });
+  if (bytes_written >= 0) {
+    return narrow_cast<size_t>(bytes_written);
+  }
+  return OS_ERROR(PSLICE() << "Pwritev to " << get_native_fd() << " at offset " << offset << " has failed");
+#else
+  size_t res = 0;
+  for (const auto &io_slice : slices) {
+    auto slice = as_slice(io_slice);
+    TRY_RESULT(size, pwrite(slice, offset + static_cast<int64>(res)));
+    res += size;
+    if (size != slice.size()) {
+      CHECK(size < slice.size());
+      break;
+    }
+  }
+  return res;
+#endif
+}
+
 Result<size_t> FileFd::pread(MutableSlice slice, int64 offset) const {
   if (offset < 0) {
     return Status::Error("Offset must be non-negative");
@@ -555,6 +584,7 @@ uint64 filetime_to_unix_time_nsec(LONGLONG filetime) {
 struct FileSize {
   int64 size_;
   int64 real_size_;
+  int64 link_count_;
 };
 
 Result<FileSize> get_file_size(const FileFd &file_fd) {
@@ -566,6 +596,7 @@ Result<FileSize> get_file_size(const FileFd &file_fd) {
   FileSize res;
   res.size_ = standard_info.EndOfFile.QuadPart;
   res.real_size_ = standard_info.AllocationSize.QuadPart;
+  res.link_count_ = standard_info.NumberOfLinks;
 
   if (res.size_ > 0 && res.real_size_ <= 0) {  // just in case
     LOG(ERROR) << "Fix real file size from " << res.real_size_ << " to " << res.size_;
@@ -628,6 +659,7 @@ Result<Stat> FileFd::stat() const {
   TRY_RESULT(file_size, get_file_size(*this));
   res.size_ = file_size.size_;
   res.real_size_ = file_size.real_size_;
+  res.link_count_ = file_size.link_count_;
 
   return res;
 #endif
@@ -649,6 +681,22 @@ Status FileFd::sync() {
   return Status::OK();
 }
 
+void FileFd::advise_dont_need(int64 offset, int64 size) {
+  CHECK(!empty());
+#if TD_LINUX || TD_ANDROID || TD_FREEBSD
+  auto native_fd = get_native_fd().fd();
+  auto r_offset = narrow_cast_safe<off_t>(offset);
+  auto r_size = narrow_cast_safe<off_t>(size);
+  if (r_offset.is_error() || r_size.is_error()) {
+    return;
+  }
+  auto error = posix_fadvise(native_fd, r_offset.ok(), r_size.ok(), POSIX_FADV_DONTNEED);
+  if (error != 0) {
+    VLOG(fd) << "Failed to advise " << get_native_fd() << " with error " << error;
+  }
+#endif
+}
+
 Status FileFd::sync_barrier() {
   CHECK(!empty());
 #if TD_DARWIN && defined(F_BARRIERFSYNC)
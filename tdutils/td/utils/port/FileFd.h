@@ -42,6 +42,7 @@ class FileFd {
   Result<size_t> read(MutableSlice slice) TD_WARN_UNUSED_RESULT;
 
   Result<size_t> pwrite(Slice slice, int64 offset) TD_WARN_UNUSED_RESULT;
+  Result<size_t> pwritev(Span<IoSlice> slices, int64 offset) TD_WARN_UNUSED_RESULT;
   Result<size_t> pread(MutableSlice slice, int64 offset) const TD_WARN_UNUSED_RESULT;
 
   enum class LockFlags { Write, Read, Unlock };
@@ -64,6 +65,10 @@ class FileFd {
   Status sync() TD_WARN_UNUSED_RESULT;
   Status sync_barrier() TD_WARN_UNUSED_RESULT;
 
+  // hints the OS that the given range of the file isn't going to be accessed in the near future
+  // and its pages can be evicted from the page cache after they are written back
+  void advise_dont_need(int64 offset, int64 size);
+
   Status seek(int64 position) TD_WARN_UNUSED_RESULT;
 
   Status truncate_to_current_position(int64 current_position) TD_WARN_UNUSED_RESULT;
@@ -6,6 +6,7 @@
 //
 #include "td/utils/port/MemoryMapping.h"
 
+#include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 
@@ -25,6 +26,17 @@ namespace td {
 class MemoryMapping::Impl {
  public:
   Impl(MutableSlice data, int64 offset) : data_(data), offset_(offset) {
+  }
+  Impl(const Impl &) = delete;
+  Impl &operator=(const Impl &) = delete;
+  Impl(Impl &&) = delete;
+  Impl &operator=(Impl &&) = delete;
+  ~Impl() {
+#if !TD_WINDOWS
+    if (munmap(data_.data(), data_.size()) != 0) {
+      LOG(ERROR) << OS_ERROR("munmap call failed");
+    }
+#endif
   }
   Slice as_slice() const {
     return data_.substr(narrow_cast<size_t>(offset_));
@@ -73,7 +85,11 @@ Result<MemoryMapping> MemoryMapping::create_from_file(const FileFd &file_fd, con
   if (options.size < 0) {
     end = stat.size_;
   } else {
-    end = begin + stat.size_;
+    end = begin + options.size;
+  }
+  if (end > stat.size_) {
+    return Status::Error(PSLICE() << "Can't create memory mapping: end offset " << end << " is beyond the file size "
+                                  << stat.size_);
   }
 
   TRY_RESULT(page_size, get_page_size());
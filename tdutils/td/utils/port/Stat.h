@@ -20,6 +20,7 @@ struct Stat {
   bool is_symbolic_link_;
   int64 size_;
   int64 real_size_;
+  int64 link_count_;
   uint64 atime_nsec_;
   uint64 mtime_nsec_;
 };
@@ -0,0 +1,357 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/port/detail/IoUring.h"
+
+char disable_linker_warning_about_empty_file_io_uring_cpp TD_UNUSED;
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/logging.h"
+#include "td/utils/Status.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace td {
+namespace detail {
+
+namespace {
+
+constexpr uint64 REMOVE_USER_DATA = ~static_cast<uint64>(0);
+
+template <class T>
+T *ring_offset(void *ring, uint32 offset) {
+  return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+uint32 load_acquire(const uint32 *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+void store_release(uint32 *ptr, uint32 value) {
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+}  // namespace
+
+IoUring::~IoUring() {
+  clear_ring();
+}
+
+void IoUring::init() {
+  CHECK(!ring_fd_);
+  CHECK(!use_epoll_);
+  if (!init_ring()) {
+    use_epoll_ = true;
+    epoll_.init();
+  }
+}
+
+bool IoUring::init_ring() {
+  struct io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = COMPLETION_QUEUE_SIZE;
+  ring_fd_ = NativeFd(static_cast<int>(syscall(__NR_io_uring_setup, SUBMISSION_QUEUE_SIZE, &params)));
+  auto io_uring_setup_errno = errno;
+  if (!ring_fd_) {
+    LOG(WARNING) << Status::PosixError(io_uring_setup_errno, "io_uring_setup failed") << ", fall back to epoll";
+    return false;
+  }
+  if ((params.features & IORING_FEAT_EXT_ARG) == 0 || (params.features & IORING_FEAT_NODROP) == 0) {
+    LOG(WARNING) << "io_uring is too old, fall back to epoll";
+    ring_fd_.close();
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    sq_ring_size_ = td::max(sq_ring_size_, cq_ring_size_);
+    cq_ring_size_ = sq_ring_size_;
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_.fd(),
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+  } else if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_.fd(),
+                    IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  if (cq_ring_ != nullptr) {
+    auto sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_.fd(),
+                     IORING_OFF_SQES);
+    if (sqes != MAP_FAILED) {
+      sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+    }
+  }
+  if (sqes_ == nullptr) {
+    auto mmap_errno = errno;
+    LOG(WARNING) << Status::PosixError(mmap_errno, "io_uring mmap failed") << ", fall back to epoll";
+    clear_ring();
+    return false;
+  }
+
+  sq_head_ = ring_offset<uint32>(sq_ring_, params.sq_off.head);
+  sq_tail_ = ring_offset<uint32>(sq_ring_, params.sq_off.tail);
+  sq_flags_ = ring_offset<uint32>(sq_ring_, params.sq_off.flags);
+  sq_array_ = ring_offset<uint32>(sq_ring_, params.sq_off.array);
+  sq_mask_ = *ring_offset<uint32>(sq_ring_, params.sq_off.ring_mask);
+  sq_entry_count_ = *ring_offset<uint32>(sq_ring_, params.sq_off.ring_entries);
+  sq_local_tail_ = *sq_tail_;
+
+  cq_head_ = ring_offset<uint32>(cq_ring_, params.cq_off.head);
+  cq_tail_ = ring_offset<uint32>(cq_ring_, params.cq_off.tail);
+  cqes_ = ring_offset<struct io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+  cq_mask_ = *ring_offset<uint32>(cq_ring_, params.cq_off.ring_mask);
+  return true;
+}
+
+void IoUring::clear_ring() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  ring_fd_.close();
+}
+
+void IoUring::clear() {
+  if (use_epoll_) {
+    use_epoll_ = false;
+    return epoll_.clear();
+  }
+  if (!ring_fd_) {
+    return;
+  }
+  // closing of the ring cancels all poll requests
+  clear_ring();
+  subscriptions_.clear();
+
+  for (auto *list_node = list_root_.next; list_node != &list_root_;) {
+    auto pollable_fd = PollableFd::from_list_node(list_node);
+    list_node = list_node->next;
+  }
+}
+
+struct io_uring_sqe *IoUring::get_sqe() {
+  if (sq_local_tail_ - load_acquire(sq_head_) == sq_entry_count_) {
+    enter(0, 0);
+    CHECK(sq_local_tail_ - load_acquire(sq_head_) < sq_entry_count_);
+  }
+  auto index = sq_local_tail_ & sq_mask_;
+  auto *sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  return sqe;
+}
+
+void IoUring::submit_poll_add(int native_fd, const Subscription &subscription) {
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = native_fd;
+  sqe->poll32_events = subscription.events;
+  sqe->len = IORING_POLL_ADD_MULTI;  // multishot poll requests are edge-triggered
+  sqe->user_data = get_user_data(native_fd, subscription.generation);
+  store_release(sq_tail_, ++sq_local_tail_);
+}
+
+void IoUring::submit_poll_remove(uint64 user_data) {
+  auto *sqe = get_sqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = user_data;
+  sqe->user_data = REMOVE_USER_DATA;
+  store_release(sq_tail_, ++sq_local_tail_);
+}
+
+uint32 IoUring::get_pending_submission_count() const {
+  return sq_local_tail_ - load_acquire(sq_head_);
+}
+
+void IoUring::enter(uint32 min_complete, int timeout_ms) {
+  struct __kernel_timespec timeout;
+  struct io_uring_getevents_arg arg;
+  std::memset(&arg, 0, sizeof(arg));
+  if (timeout_ms >= 0) {
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+    arg.ts = reinterpret_cast<uint64>(&timeout);
+  }
+  uint32 flags = IORING_ENTER_EXT_ARG;
+  if (min_complete > 0 || (load_acquire(sq_flags_) & IORING_SQ_CQ_OVERFLOW) != 0) {
+    flags |= IORING_ENTER_GETEVENTS;
+  }
+  auto result = syscall(__NR_io_uring_enter, ring_fd_.fd(), get_pending_submission_count(), min_complete, flags,
+                        &arg, sizeof(arg));
+  auto io_uring_enter_errno = errno;
+  LOG_IF(FATAL, result == -1 && io_uring_enter_errno != EINTR && io_uring_enter_errno != ETIME &&
+                    io_uring_enter_errno != EAGAIN && io_uring_enter_errno != EBUSY)
+      << Status::PosixError(io_uring_enter_errno, "io_uring_enter failed");
+}
+
+void IoUring::subscribe(PollableFd fd, PollFlags flags) {
+  if (use_epoll_) {
+    return epoll_.subscribe(std::move(fd), flags);
+  }
+  uint32 events = POLLHUP | POLLERR | POLLRDHUP;
+  if (flags.can_read()) {
+    events |= POLLIN;
+  }
+  if (flags.can_write()) {
+    events |= POLLOUT;
+  }
+  auto native_fd = fd.native_fd().fd();
+  CHECK(native_fd >= 0);
+  auto *list_node = fd.release_as_list_node();
+  list_root_.put(list_node);
+
+  auto index = static_cast<size_t>(native_fd);
+  if (index >= subscriptions_.size()) {
+    subscriptions_.resize(td::max(index + 1, 2 * subscriptions_.size()));
+  }
+  auto &subscription = subscriptions_[index];
+  CHECK(subscription.list_node == nullptr);
+  subscription.list_node = list_node;
+  subscription.events = events;
+
+  // the request is submitted together with the next wait
+  submit_poll_add(native_fd, subscription);
+}
+
+void IoUring::unsubscribe(PollableFdRef fd_ref) {
+  if (use_epoll_) {
+    return epoll_.unsubscribe(fd_ref);
+  }
+  auto fd = fd_ref.lock();
+  auto native_fd = fd.native_fd().fd();
+  auto index = static_cast<size_t>(native_fd);
+  LOG_CHECK(index < subscriptions_.size() && subscriptions_[index].list_node != nullptr)
+      << "Unsubscribe from unknown fd = " << native_fd;
+  auto &subscription = subscriptions_[index];
+  auto user_data = get_user_data(native_fd, subscription.generation);
+  subscription.list_node = nullptr;
+  // completions for the previous generation are ignored
+  subscription.generation++;
+  if (subscription.generation == static_cast<uint32>(REMOVE_USER_DATA >> 32)) {
+    subscription.generation = 0;
+  }
+
+  // the poll request holds a reference to the file, so it must be removed immediately
+  submit_poll_remove(user_data);
+  enter(0, 0);
+}
+
+void IoUring::unsubscribe_before_close(PollableFdRef fd) {
+  unsubscribe(fd);
+}
+
+bool IoUring::has_completions() const {
+  return load_acquire(cq_tail_) != *cq_head_;
+}
+
+void IoUring::run(int timeout_ms) {
+  if (use_epoll_) {
+    return epoll_.run(timeout_ms);
+  }
+
+  // there is no need to enter the kernel if some events are already available and there is nothing to submit
+  if (!has_completions() && timeout_ms != 0) {
+    enter(1, timeout_ms);
+  } else if (get_pending_submission_count() != 0 || (load_acquire(sq_flags_) & IORING_SQ_CQ_OVERFLOW) != 0) {
+    enter(0, 0);
+  }
+
+  process_completions();
+}
+
+void IoUring::process_completions() {
+  auto head = *cq_head_;
+  auto tail = load_acquire(cq_tail_);
+  for (; head != tail; head++) {
+    const auto &cqe = cqes_[head & cq_mask_];
+    auto user_data = static_cast<uint64>(cqe.user_data);
+    if (user_data == REMOVE_USER_DATA) {
+      continue;
+    }
+    auto index = static_cast<size_t>(static_cast<uint32>(user_data));
+    auto generation = static_cast<uint32>(user_data >> 32);
+    if (index >= subscriptions_.size()) {
+      continue;
+    }
+    auto &subscription = subscriptions_[index];
+    if (subscription.list_node == nullptr || subscription.generation != generation) {
+      // the file descriptor has already been unsubscribed
+      continue;
+    }
+
+    PollFlags flags;
+    if (cqe.res < 0) {
+      LOG(ERROR) << Status::PosixError(-cqe.res, "io_uring poll failed") << ", fd = " << index;
+      flags = PollFlags::Error();
+    } else {
+      auto events = static_cast<uint32>(cqe.res);
+      if (events & POLLIN) {
+        events &= ~POLLIN;
+        flags = flags | PollFlags::Read();
+      }
+      if (events & POLLOUT) {
+        events &= ~POLLOUT;
+        flags = flags | PollFlags::Write();
+      }
+      if (events & POLLRDHUP) {
+        events &= ~POLLRDHUP;
+        flags = flags | PollFlags::Close();
+      }
+      if (events & POLLHUP) {
+        events &= ~POLLHUP;
+        flags = flags | PollFlags::Close();
+      }
+      if (events & POLLERR) {
+        events &= ~POLLERR;
+        flags = flags | PollFlags::Error();
+      }
+      if (events) {
+        LOG(FATAL) << "Unsupported io_uring poll events: " << static_cast<int32>(events);
+      }
+      if ((cqe.flags & IORING_CQE_F_MORE) == 0) {
+        // the multishot request was terminated by the kernel and must be rearmed
+        submit_poll_add(static_cast<int>(index), subscription);
+      }
+    }
+
+    auto pollable_fd = PollableFd::from_list_node(subscription.list_node);
+    pollable_fd.add_flags(flags);
+    pollable_fd.release_as_list_node();
+  }
+  store_release(cq_head_, head);
+}
+
+}  // namespace detail
+}  // namespace td
+
+#endif
@@ -0,0 +1,118 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include "td/utils/port/config.h"
+
+#ifdef TD_POLL_IO_URING
+
+#include "td/utils/common.h"
+#include "td/utils/List.h"
+#include "td/utils/port/detail/Epoll.h"
+#include "td/utils/port/detail/NativeFd.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/PollBase.h"
+#include "td/utils/port/PollFlags.h"
+
+#include <linux/io_uring.h>
+
+namespace td {
+namespace detail {
+
+// edge-triggered poller based on multishot io_uring poll requests
+// subscriptions are submitted in batches together with waiting, ready events are reaped from the shared
+// completion ring without a system call; falls back to Epoll if io_uring isn't supported by the kernel
+class IoUring final : public PollBase {
+ public:
+  IoUring() = default;
+  IoUring(const IoUring &) = delete;
+  IoUring &operator=(const IoUring &) = delete;
+  IoUring(IoUring &&) = delete;
+  IoUring &operator=(IoUring &&) = delete;
+  ~IoUring() final;
+
+  void init() final;
+
+  void clear() final;
+
+  void subscribe(PollableFd fd, PollFlags flags) final;
+
+  void unsubscribe(PollableFdRef fd) final;
+
+  void unsubscribe_before_close(PollableFdRef fd) final;
+
+  void run(int timeout_ms) final;
+
+  static bool is_edge_triggered() {
+    return true;
+  }
+
+ private:
+  static constexpr uint32 SUBMISSION_QUEUE_SIZE = 256;
+  static constexpr uint32 COMPLETION_QUEUE_SIZE = 4096;
+
+  struct Subscription {
+    ListNode *list_node = nullptr;
+    uint32 generation = 0;
+    uint32 events = 0;
+  };
+
+  NativeFd ring_fd_;
+  bool use_epoll_ = false;
+  Epoll epoll_;
+
+  void *sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void *cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  struct io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  uint32 *sq_head_ = nullptr;
+  uint32 *sq_tail_ = nullptr;
+  uint32 *sq_flags_ = nullptr;
+  uint32 *sq_array_ = nullptr;
+  uint32 sq_mask_ = 0;
+  uint32 sq_entry_count_ = 0;
+  uint32 sq_local_tail_ = 0;
+
+  uint32 *cq_head_ = nullptr;
+  uint32 *cq_tail_ = nullptr;
+  struct io_uring_cqe *cqes_ = nullptr;
+  uint32 cq_mask_ = 0;
+
+  // indexed by native file descriptor
+  vector<Subscription> subscriptions_;
+  ListNode list_root_;
+
+  bool init_ring();
+
+  void clear_ring();
+
+  struct io_uring_sqe *get_sqe();
+
+  void submit_poll_add(int native_fd, const Subscription &subscription);
+
+  void submit_poll_remove(uint64 user_data);
+
+  uint32 get_pending_submission_count() const;
+
+  void enter(uint32 min_complete, int timeout_ms);
+
+  bool has_completions() const;
+
+  void process_completions();
+
+  static uint64 get_user_data(int native_fd, uint32 generation) {
+    return (static_cast<uint64>(generation) << 32) | static_cast<uint32>(native_fd);
+  }
+};
+
+}  // namespace detail
+}  // namespace td
+
+#endif
@@ -25,6 +25,10 @@ char disable_linker_warning_about_empty_file_thread_pthread_cpp TD_UNUSED;
 #if TD_FREEBSD
 #include <sys/cpuset.h>
 #endif
+#if TD_LINUX
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 #if TD_FREEBSD || TD_OPENBSD || TD_NETBSD
 #include <sys/sysctl.h>
 #endif
@@ -206,6 +210,35 @@ uint64 ThreadPthread::get_affinity_mask(id thread_id) {
 }
 #endif
 
+#if TD_HAVE_THREAD_IO_PRIORITY
+Status ThreadPthread::set_idle_io_priority() {
+#ifdef SYS_ioprio_set
+  constexpr int IOPRIO_WHO_PROCESS = 1;
+  constexpr int IOPRIO_CLASS_IDLE = 3;
+  constexpr int IOPRIO_CLASS_SHIFT = 13;
+  // the identifier 0 means the calling thread
+  if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+    return OS_ERROR("Failed to set thread I/O priority");
+  }
+  return Status::OK();
+#else
+  return Status::Error("Unsupported");
+#endif
+}
+#endif
+
+#if TD_HAVE_THREAD_CPU_PRIORITY
+Status ThreadPthread::set_low_cpu_priority() {
+  constexpr int LOW_PRIORITY_NICE_VALUE = 10;
+  // on Linux the nice value is per-thread, so the priority of the current thread identifier is changed
+  auto thread_id = static_cast<id_t>(syscall(SYS_gettid));
+  if (setpriority(PRIO_PROCESS, thread_id, LOW_PRIORITY_NICE_VALUE) != 0) {
+    return OS_ERROR("Failed to set thread CPU priority");
+  }
+  return Status::OK();
+}
+#endif
+
 namespace this_thread_pthread {
 ThreadPthread::id get_id() {
   return pthread_self();
@@ -32,6 +32,11 @@
 #define TD_HAVE_THREAD_AFFINITY 1
 #endif
 
+#if TD_LINUX
+#define TD_HAVE_THREAD_IO_PRIORITY 1
+#define TD_HAVE_THREAD_CPU_PRIORITY 1
+#endif
+
 namespace td {
 namespace detail {
 
@@ -84,6 +89,16 @@ class ThreadPthread {
   static uint64 get_affinity_mask(id thread_id);
 #endif
 
+#if TD_HAVE_THREAD_IO_PRIORITY
+  // disk requests of the current thread will be served only when there are no other pending disk requests
+  static Status set_idle_io_priority();
+#endif
+
+#if TD_HAVE_THREAD_CPU_PRIORITY
+  // the current thread will get less CPU time than other threads of the process, when there is a contention
+  static Status set_low_cpu_priority();
+#endif
+
  private:
   MovableValue<bool> is_inited_;
   pthread_t thread_;
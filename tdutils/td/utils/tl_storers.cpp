@@ -0,0 +1,21 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/tl_storers.h"
+
+namespace td {
+
+void TlStorerGrowable::grow(size_t size) {
+  auto length = get_length();
+  auto new_size = buffer_.size() * 2;
+  if (new_size < length + size) {
+    new_size = length + size;
+  }
+  buffer_.resize(new_size);
+  set_buffer(length);
+}
+
+}  // namespace td
@@ -140,6 +140,85 @@ class TlStorerCalcLength {
   }
 };
 
+// stores data in a single pass to a growable buffer, which can be reused between objects
+class TlStorerGrowable {
+  string &buffer_;
+  unsigned char *begin_ = nullptr;
+  unsigned char *buf_ = nullptr;
+  unsigned char *end_ = nullptr;
+
+  static constexpr size_t MIN_BUFFER_SIZE = 256;
+
+  void reserve(size_t size) {
+    if (unlikely(static_cast<size_t>(end_ - buf_) < size)) {
+      grow(size);
+    }
+  }
+
+  // is kept out of line, so inlined stores stay small
+  void grow(size_t size);
+
+  void set_buffer(size_t length) {
+    begin_ = MutableSlice(buffer_).ubegin();
+    buf_ = begin_ + length;
+    end_ = begin_ + buffer_.size();
+  }
+
+ public:
+  explicit TlStorerGrowable(string &buffer) : buffer_(buffer) {
+    if (buffer_.size() < MIN_BUFFER_SIZE) {
+      buffer_.resize(MIN_BUFFER_SIZE);
+    }
+    set_buffer(0);
+  }
+
+  TlStorerGrowable(const TlStorerGrowable &) = delete;
+  TlStorerGrowable &operator=(const TlStorerGrowable &) = delete;
+
+  template <class T>
+  void store_binary(const T &x) {
+    reserve(sizeof(T));
+    std::memcpy(buf_, &x, sizeof(T));
+    buf_ += sizeof(T);
+  }
+
+  void store_int(int32 x) {
+    store_binary<int32>(x);
+  }
+
+  void store_long(int64 x) {
+    store_binary<int64>(x);
+  }
+
+  void store_slice(Slice slice) {
+    reserve(slice.size());
+    std::memcpy(buf_, slice.begin(), slice.size());
+    buf_ += slice.size();
+  }
+
+  void store_storer(const Storer &storer) {
+    reserve(storer.size());
+    size_t size = storer.store(buf_);
+    buf_ += size;
+  }
+
+  template <class T>
+  void store_string(const T &str) {
+    reserve(str.size() + 11);
+    TlStorerUnsafe storer(buf_);
+    storer.store_string(str);
+    buf_ = storer.get_buf();
+  }
+
+  size_t get_length() const {
+    return static_cast<size_t>(buf_ - begin_);
+  }
+
+  Slice as_slice() const {
+    return Slice(begin_, buf_);
+  }
+};
+
 template <class T>
 size_t tl_calc_length(const T &data) {
   TlStorerCalcLength storer_calc_length;
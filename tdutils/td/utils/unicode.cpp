@@ -8,6 +8,9 @@
 
 #include "td/utils/logging.h"
 
+#include <algorithm>
+#include <array>
+
 namespace td {
 
 // list of [(range_begin << 5) + range_type]
@@ -1316,11 +1319,73 @@ static uint32 binary_search_ranges(const int32 (&ranges)[N], uint32 code) {
   }
 }
 
+/**
+ * Two-level lookup table with replacements of all characters from the Basic Multilingual Plane
+ * Replacements are stored as differences with the character modulo 2^16, so equal blocks of 256 characters are shared
+ */
+class BmpReplacementTable {
+ public:
+  template <size_t N>
+  explicit BmpReplacementTable(const int32 (&ranges)[N]) {
+    std::array<uint16, BLOCK_SIZE> block;
+    for (uint32 block_id = 0; block_id < BLOCK_COUNT; block_id++) {
+      bool is_bmp = true;
+      for (uint32 i = 0; i < BLOCK_SIZE; i++) {
+        auto code = block_id * BLOCK_SIZE + i;
+        auto replacement = binary_search_ranges(ranges, code);
+        is_bmp &= replacement <= 0xffff;
+        block[i] = static_cast<uint16>(replacement - code);
+      }
+      if (!is_bmp) {
+        block_offsets_[block_id] = NO_BLOCK;
+        continue;
+      }
+
+      size_t offset = 0;
+      while (offset < blocks_.size() && !std::equal(block.begin(), block.end(), blocks_.begin() + offset)) {
+        offset += BLOCK_SIZE;
+      }
+      if (offset == blocks_.size()) {
+        blocks_.insert(blocks_.end(), block.begin(), block.end());
+      }
+      block_offsets_[block_id] = static_cast<uint32>(offset);
+    }
+  }
+
+  // returns false if the replacement isn't in the table
+  bool find(uint32 code, uint32 &replacement) const {
+    auto offset = block_offsets_[code / BLOCK_SIZE];
+    if (offset == NO_BLOCK) {
+      return false;
+    }
+    replacement = static_cast<uint16>(code + blocks_[offset + code % BLOCK_SIZE]);
+    return true;
+  }
+
+ private:
+  static constexpr uint32 BLOCK_SIZE = 256;
+  static constexpr uint32 BLOCK_COUNT = 0x10000 / BLOCK_SIZE;
+  static constexpr uint32 NO_BLOCK = static_cast<uint32>(-1);
+
+  std::array<uint32, BLOCK_COUNT> block_offsets_;
+  vector<uint16> blocks_;
+};
+
+template <size_t N>
+static uint32 search_replacement(const BmpReplacementTable &table, const int32 (&ranges)[N], uint32 code) {
+  uint32 replacement;
+  if (code <= 0xffff && table.find(code, replacement)) {
+    return replacement;
+  }
+  return binary_search_ranges(ranges, code);
+}
+
 uint32 prepare_search_character(uint32 code) {
   if (code < TABLE_SIZE) {
     return prepare_search_character_table[code];
   } else {
-    return binary_search_ranges(prepare_search_character_ranges, code);
+    static const BmpReplacementTable table(prepare_search_character_ranges);
+    return search_replacement(table, prepare_search_character_ranges, code);
   }
 }
 
@@ -1328,7 +1393,8 @@ uint32 unicode_to_lower(uint32 code) {
   if (code < TABLE_SIZE) {
     return to_lower_table[code];
   } else {
-    return binary_search_ranges(to_lower_ranges, code);
+    static const BmpReplacementTable table(to_lower_ranges);
+    return search_replacement(table, to_lower_ranges, code);
   }
 }
 
@@ -1336,7 +1402,8 @@ uint32 remove_diacritics(uint32 code) {
   if (code < TABLE_SIZE) {
     return without_diacritics_table[code];
   } else {
-    return binary_search_ranges(without_diacritics_ranges, code);
+    static const BmpReplacementTable table(without_diacritics_ranges);
+    return search_replacement(table, without_diacritics_ranges, code);
   }
 }
 
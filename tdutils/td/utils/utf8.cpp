@@ -6,10 +6,25 @@
 //
 #include "td/utils/utf8.h"
 
+#include "td/utils/bits.h"
 #include "td/utils/misc.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/unicode.h"
 
+#include <cstring>
+
+#if defined(__SSE2__) || (TD_MSVC && (defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)))
+#define TD_UTF8_SSE2 1
+#endif
+
+#ifdef __aarch64__
+#include <arm_neon.h>
+#endif
+
+#if TD_UTF8_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace td {
 
 bool check_utf8(CSlice str) {
@@ -21,6 +36,9 @@ bool check_utf8(CSlice str) {
       if (data == data_end + 1) {
         return true;
       }
+      if (data != data_end) {
+        data += utf8_ascii_prefix_length(Slice(data, data_end));
+      }
       continue;
     }
 
@@ -103,9 +121,15 @@ unsigned char *append_utf8_character_unsafe(unsigned char *ptr, uint32 code) {
 
 string utf8_to_lower(Slice str) {
   string result;
+  result.reserve(str.size());
   auto pos = str.ubegin();
   auto end = str.uend();
   while (pos != end) {
+    if (*pos < 0x80) {
+      // ASCII characters are lowercased in place without decoding
+      result.push_back(to_lower(static_cast<char>(*pos++)));
+      continue;
+    }
     uint32 code;
     pos = next_utf8_unsafe(pos, &code);
     append_utf8_character(result, unicode_to_lower(code));
@@ -121,9 +145,18 @@ vector<string> utf8_get_search_words(Slice str) {
   auto end = str.uend();
   while (pos != end) {
     uint32 code;
-    pos = next_utf8_unsafe(pos, &code);
-
-    code = prepare_search_character(code);
+    if (*pos < 0x80) {
+      // ASCII characters have no diacritics and are replaced with ASCII characters
+      code = prepare_search_character(*pos++);
+      if (code != 0 && code != ' ') {
+        in_word = true;
+        word.push_back(static_cast<char>(code));
+        continue;
+      }
+    } else {
+      pos = next_utf8_unsafe(pos, &code);
+      code = prepare_search_character(code);
+    }
     if (code == 0) {
       continue;
     }
@@ -157,13 +190,79 @@ string utf8_encode(CSlice data) {
 }
 
 size_t utf8_utf16_length(Slice str) {
+  const unsigned char *ptr = str.ubegin();
+  const unsigned char *end = str.uend();
   size_t result = 0;
-  for (auto c : str) {
+  // every byte, except continuation bytes 0x80-0xBF, adds a code unit; first bytes 0xF0-0xF7 add a surrogate pair
+#if TD_UTF8_SSE2
+  const auto min_first = _mm_set1_epi8(-64);  // 0xC0
+  const auto min_long = _mm_set1_epi8(-17);   // 0xEF
+  const auto max_long = _mm_set1_epi8(-8);    // 0xF8
+  while (end - ptr >= 16) {
+    auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    auto continuation_mask = static_cast<uint32>(_mm_movemask_epi8(_mm_cmplt_epi8(bytes, min_first)));
+    auto long_mask = static_cast<uint32>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(bytes, min_long), _mm_cmplt_epi8(bytes, max_long))));
+    result += 16 - count_bits32(continuation_mask) + count_bits32(long_mask);
+    ptr += 16;
+  }
+#elif defined(__aarch64__)
+  const auto min_first = vdupq_n_s8(-64);
+  const auto min_long = vdupq_n_s8(-17);
+  const auto max_long = vdupq_n_s8(-8);
+  while (end - ptr >= 16) {
+    auto bytes = vld1q_s8(reinterpret_cast<const int8_t *>(ptr));
+    auto continuation_mask = vcltq_s8(bytes, min_first);
+    auto long_mask = vandq_u8(vcgtq_s8(bytes, min_long), vcltq_s8(bytes, max_long));
+    result += 16 - vaddvq_u8(vshrq_n_u8(continuation_mask, 7)) + vaddvq_u8(vshrq_n_u8(long_mask, 7));
+    ptr += 16;
+  }
+#endif
+  for (; ptr != end; ptr++) {
+    auto c = *ptr;
     result += is_utf8_character_first_code_unit(c) + ((c & 0xf8) == 0xf0);
   }
   return result;
 }
 
+size_t utf8_ascii_prefix_length(Slice str) {
+  const unsigned char *begin = str.ubegin();
+  const unsigned char *end = str.uend();
+  const unsigned char *ptr = begin;
+#if TD_UTF8_SSE2
+  // check 16 bytes at once
+  while (end - ptr >= 16) {
+    auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    auto mask = _mm_movemask_epi8(bytes);
+    if (mask != 0) {
+      return static_cast<size_t>(ptr - begin) + count_trailing_zeroes32(static_cast<uint32>(mask));
+    }
+    ptr += 16;
+  }
+#elif defined(__aarch64__)
+  // check 16 bytes at once
+  while (end - ptr >= 16) {
+    if (vmaxvq_u8(vld1q_u8(ptr)) >= 0x80) {
+      break;
+    }
+    ptr += 16;
+  }
+#endif
+  // check 8 bytes at once
+  while (end - ptr >= 8) {
+    uint64 word;
+    std::memcpy(&word, ptr, sizeof(word));
+    if ((word & static_cast<uint64>(0x8080808080808080)) != 0) {
+      break;
+    }
+    ptr += 8;
+  }
+  while (ptr != end && (*ptr & 0x80) == 0) {
+    ptr++;
+  }
+  return static_cast<size_t>(ptr - begin);
+}
+
 Slice utf8_utf16_truncate(Slice str, size_t length) {
   for (size_t i = 0; i < str.size(); i++) {
     auto c = static_cast<unsigned char>(str[i]);
@@ -31,6 +31,9 @@ inline size_t utf8_length(Slice str) {
 /// returns length of UTF-8 string in UTF-16 code units
 size_t utf8_utf16_length(Slice str);
 
+/// returns length of the longest prefix of the string, consisting only of ASCII characters
+size_t utf8_ascii_prefix_length(Slice str);
+
 /// appends a Unicode character using UTF-8 encoding
 template <class T>
 void append_utf8_character(T &str, uint32 code) {
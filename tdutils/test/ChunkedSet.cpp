@@ -0,0 +1,80 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/ChunkedSet.h"
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <set>
+
+TEST(ChunkedSet, stress_test) {
+  td::Random::Xorshift128plus rnd(123);
+  std::set<td::uint64> reference;
+  td::ChunkedSet<td::uint64, 8> set;
+
+  td::vector<td::RandomSteps::Step> steps;
+  auto add_step = [&](td::uint32 weight, auto f) {
+    steps.emplace_back(td::RandomSteps::Step{std::move(f), weight});
+  };
+
+  auto gen_key = [&] {
+    return rnd() % 3000;
+  };
+
+  add_step(2000, [&] {
+    auto key = gen_key();
+    auto reference_result = reference.insert(key);
+    auto result = set.insert(key);
+    ASSERT_EQ(reference_result.second, result.second);
+    ASSERT_EQ(key, *result.first);
+    ASSERT_EQ(reference.size(), set.size());
+  });
+
+  add_step(2000, [&] {
+    auto key = gen_key();
+    ASSERT_EQ(reference.erase(key), set.erase(key));
+    ASSERT_EQ(reference.size(), set.size());
+    ASSERT_EQ(reference.empty(), set.empty());
+  });
+
+  add_step(1000, [&] {
+    auto key = gen_key();
+    ASSERT_EQ(reference.count(key), set.count(key));
+
+    auto reference_it = reference.lower_bound(key);
+    auto it = set.lower_bound(key);
+    ASSERT_EQ(reference_it == reference.end(), it == set.end());
+    if (it != set.end()) {
+      ASSERT_EQ(*reference_it, *it);
+    }
+
+    reference_it = reference.upper_bound(key);
+    it = set.upper_bound(key);
+    for (int i = 0; i < 10 && it != set.end(); i++, ++it, ++reference_it) {
+      ASSERT_TRUE(reference_it != reference.end());
+      ASSERT_EQ(*reference_it, *it);
+    }
+    ASSERT_EQ(reference_it == reference.end(), it == set.end());
+  });
+
+  add_step(10, [&] {
+    td::vector<td::uint64> reference_values(reference.begin(), reference.end());
+    td::vector<td::uint64> values(set.begin(), set.end());
+    ASSERT_EQ(reference_values, values);
+  });
+
+  add_step(1, [&] {
+    reference.clear();
+    set.clear();
+    ASSERT_TRUE(set.begin() == set.end());
+  });
+
+  td::RandomSteps runner(std::move(steps));
+  for (size_t i = 0; i < 1000000; i++) {
+    runner.step(rnd);
+  }
+}
@@ -0,0 +1,239 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/utils/benchmark.h"
+#include "td/utils/common.h"
+#include "td/utils/Heap.h"
+#include "td/utils/Random.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/tests.h"
+#include "td/utils/TimerWheel.h"
+
+#include <set>
+
+TEST(TimerWheel, random_events) {
+  td::Random::Xorshift128plus rnd(123);
+  for (auto max_delay : {0.01, 1.0, 100.0, 1e6}) {
+    td::vector<td::TimerWheelNode> nodes(1000);
+    td::TimerWheel wheel;
+    double now = 12345.678;
+    wheel.set_current_time(now);
+    size_t active_count = 0;
+    for (int i = 0; i < 100000; i++) {
+      auto &node = nodes[rnd.fast(0, static_cast<int>(nodes.size()) - 1)];
+      auto type = rnd.fast(0, 9);
+      if (type < 4) {
+        if (node.in_timer_wheel()) {
+          wheel.erase(&node);
+          active_count--;
+        }
+        wheel.insert(now + max_delay * rnd.fast(0, 1000) * 1e-3, &node);
+        active_count++;
+      } else if (type < 6) {
+        if (node.in_timer_wheel()) {
+          wheel.erase(&node);
+          active_count--;
+        }
+      } else {
+        if (active_count != 0) {
+          ASSERT_TRUE(wheel.get_next_event_time() <= now + max_delay + 0.002);
+        }
+        now += max_delay * rnd.fast(0, 100) * 1e-3;
+        wheel.run_expired(now, [&](td::TimerWheelNode *expired_node) {
+          ASSERT_TRUE(!expired_node->in_timer_wheel());
+          ASSERT_TRUE(expired_node->get_timeout_at() < now);
+          active_count--;
+        });
+        for (auto &other_node : nodes) {
+          if (other_node.in_timer_wheel()) {
+            ASSERT_TRUE(other_node.get_timeout_at() >= now - 0.0011);
+          }
+        }
+      }
+      ASSERT_EQ(active_count, wheel.size());
+    }
+    wheel.run_expired(now + 1e10, [&](td::TimerWheelNode *expired_node) { active_count--; });
+    ASSERT_EQ(0u, active_count);
+    ASSERT_TRUE(wheel.empty());
+  }
+}
+
+TEST(TimerWheel, same_tick_order) {
+  td::vector<td::TimerWheelNode> nodes(7);
+  td::TimerWheel wheel;
+  double now = 1.0;
+  wheel.set_current_time(now);
+  double timeout_at = 1000.0005;  // all timeouts are in the same tick
+
+  auto advance = [&](double new_now) {
+    now = new_now;
+    wheel.run_expired(now, [](td::TimerWheelNode *node) { UNREACHABLE(); });
+  };
+
+  // nodes are inserted on different levels of the wheel and moved between levels before expiration
+  wheel.insert(timeout_at, &nodes[0]);
+  wheel.insert(timeout_at, &nodes[1]);
+  advance(990.0);
+  wheel.insert(timeout_at, &nodes[2]);
+  wheel.insert(timeout_at - 0.0001, &nodes[3]);
+  advance(999.9);
+  wheel.insert(timeout_at, &nodes[4]);
+  advance(999.999);
+  wheel.insert(timeout_at - 0.0003, &nodes[5]);
+  wheel.insert(timeout_at, &nodes[6]);
+
+  td::vector<size_t> expired;
+  wheel.run_expired(1001.0, [&](td::TimerWheelNode *node) {
+    expired.push_back(static_cast<size_t>(node - &nodes[0]));
+  });
+  ASSERT_EQ(nodes.size(), expired.size());
+  for (size_t i = 0; i < expired.size(); i++) {
+    ASSERT_EQ(i, expired[i]);
+  }
+}
+
+template <class QueueT>
+class TimeoutChurnBench final : public td::Benchmark {
+  QueueT queue_;
+  int timeout_count_;
+  double now_ = 1000.0;
+
+ public:
+  explicit TimeoutChurnBench(int timeout_count) : timeout_count_(timeout_count) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << QueueT::get_name() << " with " << timeout_count_ << " timeouts";
+  }
+
+  void start_up() final {
+    queue_.init(timeout_count_, now_);
+  }
+
+  void run(int n) final {
+    // every iteration reschedules a random timeout and advances time by 10 microseconds
+    td::Random::Xorshift128plus rnd(123);
+    for (int i = 0; i < n; i++) {
+      now_ += 1e-5;
+      auto id = rnd.fast(0, timeout_count_ - 1);
+      if (rnd.fast(0, 9) == 0) {
+        queue_.cancel(id);
+      } else {
+        queue_.set(id, now_ + rnd.fast(1, 3600000) * 1e-3);
+      }
+      if ((i & 127) == 0) {
+        queue_.run_expired(now_);
+      }
+    }
+  }
+
+  void tear_down() final {
+    queue_.clear();
+  }
+};
+
+class HeapTimeouts {
+  struct Item final : public td::HeapNode {
+    int id;
+
+    explicit Item(int id) : id(id) {
+    }
+
+    bool operator<(const Item &other) const {
+      return id < other.id;
+    }
+  };
+  td::KHeap<double> timeout_queue_;
+  std::set<Item> items_;
+
+ public:
+  static const char *get_name() {
+    return "KHeap with std::set";
+  }
+
+  void init(int count, double now) {
+  }
+
+  void set(int id, double timeout_at) {
+    auto it = items_.emplace(id).first;
+    auto heap_node = static_cast<td::HeapNode *>(const_cast<Item *>(&*it));
+    if (heap_node->in_heap()) {
+      timeout_queue_.fix(timeout_at, heap_node);
+    } else {
+      timeout_queue_.insert(timeout_at, heap_node);
+    }
+  }
+
+  void cancel(int id) {
+    auto it = items_.find(Item(id));
+    if (it != items_.end()) {
+      timeout_queue_.erase(const_cast<Item *>(&*it));
+      items_.erase(it);
+    }
+  }
+
+  void run_expired(double now) {
+    while (!timeout_queue_.empty() && timeout_queue_.top_key() < now) {
+      items_.erase(Item(static_cast<Item *>(timeout_queue_.pop())->id));
+    }
+  }
+
+  void clear() {
+    while (!timeout_queue_.empty()) {
+      timeout_queue_.pop();
+    }
+    items_.clear();
+  }
+};
+
+class TimerWheelTimeouts {
+  td::TimerWheel wheel_;
+  td::vector<td::TimerWheelNode> nodes_;
+
+ public:
+  static const char *get_name() {
+    return "TimerWheel";
+  }
+
+  void init(int count, double now) {
+    nodes_ = td::vector<td::TimerWheelNode>(count);
+    wheel_.set_current_time(now);
+  }
+
+  void set(int id, double timeout_at) {
+    auto *node = &nodes_[id];
+    if (node->in_timer_wheel()) {
+      wheel_.erase(node);
+    }
+    wheel_.insert(timeout_at, node);
+  }
+
+  void cancel(int id) {
+    auto *node = &nodes_[id];
+    if (node->in_timer_wheel()) {
+      wheel_.erase(node);
+    }
+  }
+
+  void run_expired(double now) {
+    wheel_.run_expired(now, [](td::TimerWheelNode *node) {});
+  }
+
+  void clear() {
+    for (auto &node : nodes_) {
+      if (node.in_timer_wheel()) {
+        wheel_.erase(&node);
+      }
+    }
+  }
+};
+
+TEST(TimerWheel, bench_churn) {
+  for (int timeout_count : {1000, 100000}) {
+    td::bench(TimeoutChurnBench<HeapTimeouts>(timeout_count));
+    td::bench(TimeoutChurnBench<TimerWheelTimeouts>(timeout_count));
+  }
+}
@@ -6,8 +6,16 @@
 //
 #include "td/utils/tests.h"
 
+#include "td/utils/benchmark.h"
 #include "td/utils/buffer.h"
+#include "td/utils/common.h"
+#include "td/utils/find_boundary.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/port/thread_local.h"
 #include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 
 TEST(Buffer, buffer_builder) {
   {
@@ -54,3 +62,97 @@ TEST(Buffer, buffer_builder) {
     ASSERT_EQ(builder.extract().as_slice(), str);
   }
 }
+
+TEST(Buffer, find_boundary) {
+  td::string boundary = "\r\n--ab";
+  for (int test = 0; test < 1000; test++) {
+    td::string str;
+    auto length = td::Random::fast(0, 3000);
+    while (static_cast<int>(str.size()) < length) {
+      if (td::Random::fast(0, 200) == 0) {
+        str += boundary;
+      } else {
+        str += "\r\n-ab"[td::Random::fast(0, 4)];
+      }
+    }
+    auto expected_pos = str.find(boundary);
+
+    td::ChainBufferWriter writer;
+    auto reader = writer.extract_reader();
+    size_t already_read = 0;
+    bool is_found = false;
+    size_t pos = 0;
+    while (!is_found && pos < str.size()) {
+      // pieces of at least 256 bytes are stored in separate chunks
+      auto piece_size = td::min(str.size() - pos, static_cast<size_t>(td::Random::fast(256, 300)));
+      writer.append(td::BufferSlice(td::Slice(str).substr(pos, piece_size)));
+      pos += piece_size;
+      reader.sync_with_writer();
+      is_found = td::find_boundary(reader.clone(), boundary, already_read);
+    }
+    ASSERT_EQ(expected_pos != td::string::npos, is_found);
+    if (is_found) {
+      ASSERT_EQ(expected_pos, already_read);
+    }
+  }
+}
+
+TEST(Buffer, buffer_allocator_reuse) {
+  td::clear_thread_locals();
+  auto start_mem = td::BufferAllocator::get_buffer_mem();
+  for (int i = 0; i < 1000; i++) {
+    auto size = static_cast<size_t>(td::Random::fast(0, 100000));
+    td::BufferSlice slice(size);
+    ASSERT_EQ(size, slice.size());
+    ASSERT_TRUE(td::BufferAllocator::get_buffer_mem() >= start_mem + size);
+    slice.as_mutable_slice().fill('a');
+
+    td::BufferWriter writer(0, 0, size);
+    ASSERT_TRUE(writer.prepare_append().size() >= size);
+  }
+  td::clear_thread_locals();
+  ASSERT_EQ(start_mem, td::BufferAllocator::get_buffer_mem());
+}
+
+#if !TD_THREAD_UNSUPPORTED
+class BufferAllocatorBench final : public td::Benchmark {
+  size_t thread_count_;
+  size_t buffer_size_;
+
+ public:
+  BufferAllocatorBench(size_t thread_count, size_t buffer_size)
+      : thread_count_(thread_count), buffer_size_(buffer_size) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "Allocate and release buffers of size " << buffer_size_ << " in " << thread_count_
+                     << " threads";
+  }
+
+  void run(int n) final {
+    td::vector<td::thread> threads;
+    for (size_t i = 0; i < thread_count_; i++) {
+      threads.emplace_back([n, buffer_size = buffer_size_] {
+        td::vector<td::BufferSlice> buffers(16);
+        for (int j = 0; j < n; j++) {
+          auto &buffer = buffers[j & 15];
+          buffer = td::BufferSlice(buffer_size);
+          buffer.as_mutable_slice()[0] = 'a';
+        }
+        buffers.clear();
+        td::clear_thread_locals();
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+};
+
+TEST(Buffer, bench_buffer_allocator) {
+  for (size_t buffer_size : {1000, 16000, 60000}) {
+    td::bench(BufferAllocatorBench(1, buffer_size));
+    td::bench(BufferAllocatorBench(4, buffer_size));
+  }
+}
+#endif
@@ -4,6 +4,7 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "td/utils/algorithm.h"
 #include "td/utils/base64.h"
 #include "td/utils/benchmark.h"
 #include "td/utils/common.h"
@@ -160,6 +161,48 @@ TEST(Crypto, AesIgeState) {
   }
 }
 
+TEST(Crypto, AesIgeBatch) {
+  for (int buffer_count : {1, 2, 7, 8, 9, 20}) {
+    td::vector<td::string> plaintexts;
+    td::vector<td::AesIgeBuffer> buffers(buffer_count);
+    td::vector<td::string> expected;
+    td::vector<td::UInt256> expected_ivs;
+    for (int i = 0; i < buffer_count; i++) {
+      auto length = 16 * td::Random::fast(0, 300);
+      plaintexts.push_back(td::rand_string(0, 255, length));
+      td::Random::secure_bytes(buffers[i].key.raw, sizeof(buffers[i].key.raw));
+      td::Random::secure_bytes(buffers[i].iv.raw, sizeof(buffers[i].iv.raw));
+
+      td::AesIgeState state;
+      state.init(as_slice(buffers[i].key), as_slice(buffers[i].iv), true);
+      td::string encrypted(length, '\0');
+      state.encrypt(plaintexts[i], encrypted);
+      expected.push_back(std::move(encrypted));
+      auto iv = buffers[i].iv;
+      td::string unused(length, '\0');
+      td::aes_ige_encrypt(as_slice(buffers[i].key), as_mutable_slice(iv), plaintexts[i], unused);
+      expected_ivs.push_back(iv);
+    }
+
+    td::vector<td::string> data = plaintexts;
+    auto ivs = td::transform(buffers, [](const auto &buffer) { return buffer.iv; });
+    for (int i = 0; i < buffer_count; i++) {
+      buffers[i].data = data[i];
+    }
+    td::aes_ige_encrypt_batch(buffers);
+    for (int i = 0; i < buffer_count; i++) {
+      ASSERT_EQ(expected[i], data[i]);
+      ASSERT_TRUE(expected_ivs[i] == buffers[i].iv);
+      buffers[i].iv = ivs[i];
+    }
+
+    td::aes_ige_decrypt_batch(buffers);
+    for (int i = 0; i < buffer_count; i++) {
+      ASSERT_EQ(plaintexts[i], data[i]);
+    }
+  }
+}
+
 TEST(Crypto, AesCbcState) {
   td::vector<td::uint32> answers1{0u, 3617355989u, 3449188102u, 186999968u, 4244808847u, 2626031206u};
 
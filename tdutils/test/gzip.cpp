@@ -11,7 +11,9 @@
 #include "td/utils/Gzip.h"
 #include "td/utils/GzipByteFlow.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/thread_local.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Status.h"
 #include "td/utils/tests.h"
@@ -29,6 +31,23 @@ TEST(Gzip, gzencode_gzdecode) {
   encode_decode(td::string(1000000, 'a'));
 }
 
+TEST(Gzip, gzdecode_gzip_format) {
+  auto packed = td::hex_decode("1f8b08000000000002034b4c4a4e1c45c4210084b8c4d02c010000").move_as_ok();
+  td::string unpacked;
+  for (int i = 0; i < 100; i++) {
+    unpacked += "abc";
+  }
+  ASSERT_EQ(unpacked, td::gzdecode(packed).as_slice());
+
+  // a wrong size in the trailer must not affect decoded data
+  for (size_t i = 1; i <= 4; i++) {
+    auto corrupted = packed;
+    corrupted[corrupted.size() - i] = '\x7f';
+    auto result = td::gzdecode(corrupted);
+    ASSERT_TRUE(result.empty() || result.as_slice() == unpacked);
+  }
+}
+
 static void test_gzencode(const td::string &s) {
   auto begin_time = td::Time::now();
   auto r = td::gzencode(s, td::max(2, static_cast<int>(100 / s.size())));
@@ -45,6 +64,22 @@ TEST(Gzip, gzencode) {
   }
 }
 
+TEST(Gzip, reusable_gzencode) {
+  td::Gzip gzip;
+  ASSERT_TRUE(gzip.init_reusable_encode().is_ok());
+  for (int i = 0; i < 10; i++) {
+    auto s = i % 3 == 0 ? td::rand_string(0, 255, 10000) : td::rand_string('a', 'b', td::Random::fast(1, 100000));
+    auto r = td::gzencode(gzip, s, i % 3 == 0 ? 0.9 : 2.0);
+    if (i % 3 == 0) {
+      ASSERT_TRUE(r.empty());
+    } else {
+      ASSERT_TRUE(!r.empty());
+      ASSERT_EQ(s, td::gzdecode(r.as_slice()));
+      ASSERT_EQ(r.as_slice(), td::gzencode(s, 2.0).as_slice());
+    }
+  }
+}
+
 TEST(Gzip, flow) {
   auto str = td::rand_string('a', 'z', 1000000);
   auto parts = td::rand_split(str);
@@ -9,6 +9,7 @@
 #include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/Parser.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Slice.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
@@ -249,6 +250,53 @@ TEST(JSON, bench_json_string_decode) {
   td::bench(JsonStringDecodeBenchmark(str));
 }
 
+TEST(JSON, string_encode) {
+  auto encode = [](td::Slice str) {
+    td::string result(1000, '\0');
+    td::StringBuilder sb(td::MutableSlice(result), true);
+    sb << td::JsonString(str);
+    return sb.as_cslice().str();
+  };
+  ASSERT_EQ("\"\"", encode(""));
+  ASSERT_EQ("\"abc\"", encode("abc"));
+  ASSERT_EQ("\"a\\\"b\\\\c\\n\"", encode("a\"b\\c\n"));
+  ASSERT_EQ("\"\\u0001 \\u0442\\u0435\\u0441\\u0442 \\ud83c\\udfdf\"", encode("\x01 тест 🏟"));
+  ASSERT_EQ("\"abc\\t\"", encode("abc\t"));
+}
+
+class JsonStringEncodeBenchmark final : public td::Benchmark {
+  td::string str_;
+
+ public:
+  explicit JsonStringEncodeBenchmark(td::string str) : str_(std::move(str)) {
+  }
+
+  td::string get_description() const final {
+    return PSTRING() << "JsonStringEncodeBenchmark of " << str_.size() << " bytes " << str_.substr(0, 6);
+  }
+
+  void run(int n) final {
+    td::string result(str_.size() * 6 + 2, '\0');
+    size_t size = 0;
+    for (int i = 0; i < n; i++) {
+      td::StringBuilder sb{td::MutableSlice(result)};
+      sb << td::JsonString(str_);
+      size += sb.as_cslice().size();
+    }
+    td::do_not_optimize_away(size);
+  }
+};
+
+TEST(JSON, bench_json_string_encode) {
+  td::bench(JsonStringEncodeBenchmark("chat_id"));
+  td::bench(JsonStringEncodeBenchmark(td::string(1000, 'a')));
+  td::string str;
+  for (int i = 0; i < 100; i++) {
+    str += "Line of text\n";
+  }
+  td::bench(JsonStringEncodeBenchmark(str));
+}
+
 static void test_string_decode(td::string str, const td::string &result) {
   auto str_copy = str;
   td::Parser skip_parser(str_copy);
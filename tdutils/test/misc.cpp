@@ -20,6 +20,7 @@
 #include "td/utils/HashTableUtils.h"
 #include "td/utils/invoke.h"
 #include "td/utils/logging.h"
+#include "td/utils/MetricsRegistry.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/EventFd.h"
 #include "td/utils/port/FileFd.h"
@@ -38,6 +39,7 @@
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 #include "td/utils/tl_helpers.h"
+#include "td/utils/tl_storers.h"
 #include "td/utils/translit.h"
 #include "td/utils/uint128.h"
 #include "td/utils/unicode.h"
@@ -689,6 +691,50 @@ TEST(Misc, to_wstring) {
 }
 #endif
 
+TEST(Misc, utf8_ascii_prefix_length) {
+  ASSERT_EQ(0u, td::utf8_ascii_prefix_length(""));
+  ASSERT_EQ(4u, td::utf8_ascii_prefix_length("test"));
+  ASSERT_EQ(0u, td::utf8_ascii_prefix_length("тест"));
+  for (size_t i = 0; i < 40; i++) {
+    td::string str(i, 'a');
+    ASSERT_EQ(i, td::utf8_ascii_prefix_length(str));
+    ASSERT_TRUE(td::check_utf8(str));
+    for (size_t j = 0; j < 20; j++) {
+      auto bad_str = str + td::string(j, 'b') + "\xc0" + td::string(i, 'c');
+      ASSERT_EQ(i + j, td::utf8_ascii_prefix_length(bad_str));
+      ASSERT_TRUE(!td::check_utf8(bad_str));
+      auto good_str = str + td::string(j, 'b') + "тест" + td::string(i, 'c');
+      ASSERT_EQ(i + j, td::utf8_ascii_prefix_length(good_str));
+      ASSERT_TRUE(td::check_utf8(good_str));
+    }
+  }
+}
+
+TEST(Misc, utf8_utf16_length) {
+  ASSERT_EQ(0u, td::utf8_utf16_length(""));
+  ASSERT_EQ(4u, td::utf8_utf16_length("тест"));
+  ASSERT_EQ(2u, td::utf8_utf16_length("🏟"));
+  td::vector<td::string> parts{"a", "тест", "€", "🏟", "\xff", "\x80", "\xf7", "\xf8"};
+  for (int i = 0; i < 1000; i++) {
+    td::string str;
+    auto part_count = td::Random::fast(0, 100);
+    for (int j = 0; j < part_count; j++) {
+      str += parts[td::Random::fast(0, static_cast<int>(parts.size()) - 1)];
+    }
+    size_t expected = 0;
+    for (auto c : str) {
+      auto code_unit = static_cast<unsigned char>(c);
+      expected += (code_unit < 0x80 || code_unit >= 0xc0) + (code_unit >= 0xf0 && code_unit < 0xf8);
+    }
+    ASSERT_EQ(expected, td::utf8_utf16_length(str));
+    auto ascii_prefix_length = str.find_first_of("\xd1\xe2\xf0\xff\x80\xf7\xf8");
+    if (ascii_prefix_length == td::string::npos) {
+      ascii_prefix_length = str.size();
+    }
+    ASSERT_EQ(ascii_prefix_length, td::utf8_ascii_prefix_length(str));
+  }
+}
+
 static void test_translit(const td::string &word, const td::vector<td::string> &result, bool allow_partial = true) {
   ASSERT_EQ(result, td::get_word_transliterations(word, allow_partial));
 }
@@ -1345,6 +1391,24 @@ TEST(Misc, serialize) {
   ASSERT_EQ(td::base64_encode(td::serialize(y)), td::base64_encode(td::string("\xfe\xff\xff\xff\xff\xff\xff\xff", 8)));
 }
 
+TEST(Misc, tl_storer_growable) {
+  td::string buffer;
+  for (int test = 0; test < 100; test++) {
+    td::vector<td::string> strings;
+    for (int i = td::Random::fast(0, 20); i > 0; i--) {
+      strings.push_back(td::rand_string('a', 'z', td::Random::fast(0, test < 90 ? 300 : 100000)));
+    }
+    auto x = td::Random::fast_uint64();
+
+    td::TlStorerGrowable storer(buffer);
+    td::store(strings, storer);
+    td::store(x, storer);
+    auto expected = td::serialize(std::make_pair(strings, x));
+    ASSERT_EQ(expected.size(), storer.get_length());
+    ASSERT_TRUE(expected == storer.as_slice());
+  }
+}
+
 TEST(Misc, check_reset_guard) {
   CheckExitGuard check_exit_guard{false};
 }
@@ -1391,3 +1455,34 @@ TEST(UniqueValuePtr, Basic) {
   ASSERT_TRUE(c == d);
   ASSERT_TRUE(6 == **d);
 }
+
+TEST(Misc, MetricsRegistry) {
+  auto counter = td::MetricsRegistry::get_counter("test_counter_total");
+  ASSERT_TRUE(counter == td::MetricsRegistry::get_counter("test_counter_total"));
+  counter->add(2);
+#if !TD_THREAD_UNSUPPORTED
+  td::thread([counter] { counter->add(3); }).join();
+#else
+  counter->add(3);
+#endif
+  ASSERT_EQ(5, counter->get());
+
+  auto histogram = td::MetricsRegistry::get_histogram("test_duration_seconds", 0.5);
+  histogram->observe(0.25);
+  histogram->observe(0.5);
+  histogram->observe(1.5);
+  histogram->observe(1e9);
+  ASSERT_EQ(2, histogram->get_cumulative_count(0));
+  ASSERT_EQ(2, histogram->get_cumulative_count(1));
+  ASSERT_EQ(3, histogram->get_cumulative_count(2));
+  ASSERT_EQ(4, histogram->get_count());
+
+  auto metrics = td::MetricsRegistry::get_metrics();
+  metrics.push_back(td::MetricsRegistry::get_gauge("test_gauge", 0.5));
+  auto text = td::MetricsRegistry::get_prometheus_text(metrics);
+  ASSERT_TRUE(text.find("# TYPE test_counter_total counter\ntest_counter_total 5\n") != td::string::npos);
+  ASSERT_TRUE(text.find("test_duration_seconds_bucket{le=\"1.000000\"} 2\n") != td::string::npos);
+  ASSERT_TRUE(text.find("test_duration_seconds_bucket{le=\"+Inf\"} 4\n") != td::string::npos);
+  ASSERT_TRUE(text.find("test_duration_seconds_count 4\n") != td::string::npos);
+  ASSERT_TRUE(text.find("# TYPE test_gauge gauge\ntest_gauge 0.500000\n") != td::string::npos);
+}
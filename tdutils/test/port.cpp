@@ -11,7 +11,10 @@
 #include "td/utils/port/EventFd.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/IoSlice.h"
+#include "td/utils/port/MemoryMapping.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Poll.h"
+#include "td/utils/port/PollFlags.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/sleep.h"
 #include "td/utils/port/Stat.h"
@@ -33,6 +36,12 @@
 #include <signal.h>
 #endif
 
+#if TD_HAVE_THREAD_IO_PRIORITY || TD_HAVE_THREAD_CPU_PRIORITY
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 TEST(Port, files) {
   td::CSlice main_dir = "test_dir";
   td::rmrf(main_dir).ignore();
@@ -124,6 +133,30 @@ TEST(Port, SparseFiles) {
   td::unlink(path).ensure();
 }
 
+TEST(Port, HardLink) {
+  td::CSlice path = "hard_link_source.txt";
+  td::CSlice link_path = "hard_link_target.txt";
+  td::unlink(path).ignore();
+  td::unlink(link_path).ignore();
+  auto fd = td::FileFd::open(path, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+  fd.write("hard link").ensure();
+  fd.close();
+
+  auto status = td::hard_link(path, link_path);
+  if (status.is_error()) {
+    LOG(ERROR) << "File system doesn't support hard links: " << status;
+    td::unlink(path).ensure();
+    return;
+  }
+  ASSERT_TRUE(td::hard_link(path, link_path).is_error());
+  ASSERT_EQ(2, td::stat(path).move_as_ok().link_count_);
+  td::unlink(path).ensure();
+  ASSERT_EQ(9, td::stat(link_path).move_as_ok().size_);
+  ASSERT_EQ(1, td::stat(link_path).move_as_ok().link_count_);
+  ASSERT_TRUE(td::hard_link(path, link_path).is_error());
+  td::unlink(link_path).ensure();
+}
+
 TEST(Port, LargeFiles) {
   td::CSlice path = "large.txt";
   td::unlink(path).ignore();
@@ -179,6 +212,60 @@ TEST(Port, Writev) {
   td::unlink(test_file_path).ignore();
 }
 
+TEST(Port, Pwritev) {
+  td::vector<td::IoSlice> vec;
+  td::CSlice test_file_path = "test.txt";
+  td::unlink(test_file_path).ignore();
+  auto fd = td::FileFd::open(test_file_path, td::FileFd::Write | td::FileFd::Read | td::FileFd::CreateNew).move_as_ok();
+  vec.push_back(td::as_io_slice("ef"));
+  vec.push_back(td::as_io_slice(""));
+  vec.push_back(td::as_io_slice("ghi"));
+  ASSERT_EQ(5u, fd.pwritev(vec, 4).move_as_ok());
+  vec.clear();
+  vec.push_back(td::as_io_slice("a"));
+  vec.push_back(td::as_io_slice("bcd"));
+  ASSERT_EQ(4u, fd.pwritev(vec, 0).move_as_ok());
+  fd.advise_dont_need(0, 9);
+
+  td::Slice expected_content = "abcdefghi";
+  ASSERT_EQ(static_cast<td::int64>(expected_content.size()), fd.get_size().ok());
+  td::string content(expected_content.size(), '\0');
+  ASSERT_EQ(content.size(), fd.pread(content, 0).move_as_ok());
+  ASSERT_EQ(expected_content, content);
+  fd.close();
+
+  td::unlink(test_file_path).ignore();
+}
+
+#if !TD_WINDOWS
+TEST(Port, MemoryMapping) {
+  td::CSlice test_file_path = "test.txt";
+  td::unlink(test_file_path).ignore();
+  auto fd = td::FileFd::open(test_file_path, td::FileFd::Write | td::FileFd::Read | td::FileFd::CreateNew).move_as_ok();
+  td::string content(100000, '\0');
+  for (size_t i = 0; i < content.size(); i++) {
+    content[i] = static_cast<char>(td::Random::fast(0, 255));
+  }
+  ASSERT_EQ(content.size(), fd.pwrite(content, 0).move_as_ok());
+
+  ASSERT_EQ(td::Slice(content), td::MemoryMapping::create_from_file(fd).move_as_ok().as_slice());
+  for (auto offset : {0, 1, 4095, 4096, 50000, 99999}) {
+    for (auto size : {1, 1000, 4096, 50000}) {
+      auto options = td::MemoryMapping::Options().with_offset(offset).with_size(size);
+      auto r_mapping = td::MemoryMapping::create_from_file(fd, options);
+      if (offset + size > static_cast<int>(content.size())) {
+        ASSERT_TRUE(r_mapping.is_error());
+        continue;
+      }
+      ASSERT_EQ(td::Slice(content).substr(offset, size), r_mapping.ok().as_slice());
+    }
+  }
+  fd.close();
+
+  td::unlink(test_file_path).ignore();
+}
+#endif
+
 #if TD_PORT_POSIX && !TD_THREAD_UNSUPPORTED
 
 static std::mutex m;
@@ -295,6 +382,30 @@ TEST(Port, EventFdAndSignals) {
 #endif
 #endif
 
+#if !TD_EVENTFD_UNSUPPORTED
+TEST(Port, PollEventFd) {
+  td::Poll poll;
+  poll.init();
+  td::EventFd event_fd;
+  event_fd.init();
+  for (int subscription = 0; subscription < 2; subscription++) {
+    poll.subscribe(event_fd.get_poll_info().extract_pollable_fd(nullptr), td::PollFlags::Read());
+    for (int i = 0; i < 3; i++) {
+      poll.run(0);
+      ASSERT_TRUE(!event_fd.get_poll_info().sync_with_poll().can_read());
+
+      event_fd.release();
+      poll.run(1000);
+      ASSERT_TRUE(event_fd.get_poll_info().sync_with_poll().can_read());
+      event_fd.acquire();
+    }
+    poll.unsubscribe(event_fd.get_poll_info().get_pollable_fd_ref());
+  }
+  event_fd.close();
+  poll.clear();
+}
+#endif
+
 #if TD_HAVE_THREAD_AFFINITY
 TEST(Port, ThreadAffinityMask) {
   auto thread_id = td::this_thread::get_id();
@@ -324,3 +435,47 @@ TEST(Port, ThreadAffinityMask) {
   LOG(INFO) << old_mask;
 }
 #endif
+
+#if TD_HAVE_THREAD_IO_PRIORITY
+static constexpr int IOPRIO_CLASS_IDLE = 3;
+
+static int get_io_priority_class() {
+  constexpr int IOPRIO_WHO_PROCESS = 1;
+  constexpr int IOPRIO_CLASS_SHIFT = 13;
+  // the identifier 0 means the calling thread
+  return static_cast<int>(syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0) >> IOPRIO_CLASS_SHIFT);
+}
+
+TEST(Port, ThreadIdleIoPriority) {
+  td::thread thread([] {
+    td::thread::set_idle_io_priority().ensure();
+    ASSERT_EQ(IOPRIO_CLASS_IDLE, get_io_priority_class());
+  });
+  thread.join();
+
+  // the priority of other threads must not change
+  ASSERT_TRUE(get_io_priority_class() != IOPRIO_CLASS_IDLE);
+}
+#endif
+
+#if TD_HAVE_THREAD_CPU_PRIORITY
+static int get_thread_nice_value() {
+  return getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+}
+
+TEST(Port, ThreadLowCpuPriority) {
+  auto nice_value = get_thread_nice_value();
+  if (nice_value > 10) {
+    // the priority can't be increased without privileges
+    return;
+  }
+  td::thread thread([] {
+    td::thread::set_low_cpu_priority().ensure();
+    ASSERT_EQ(10, get_thread_nice_value());
+  });
+  thread.join();
+
+  // the priority of other threads must not change
+  ASSERT_EQ(nice_value, get_thread_nice_value());
+}
+#endif
@@ -6,8 +6,11 @@
 //
 #include "data.h"
 
+#include "td/telegram/MessageDb.h"
+
 #include "td/db/binlog/BinlogHelper.h"
 #include "td/db/binlog/ConcurrentBinlog.h"
+#include "td/db/binlog/ShardedBinlog.h"
 #include "td/db/BinlogKeyValue.h"
 #include "td/db/DbKey.h"
 #include "td/db/SeqKeyValue.h"
@@ -25,14 +28,19 @@
 #include "td/utils/filesystem.h"
 #include "td/utils/FlatHashMap.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/StringBuilder.h"
 #include "td/utils/tests.h"
 
+#include <atomic>
 #include <limits>
 #include <map>
 #include <memory>
@@ -138,6 +146,248 @@ TEST(DB, binlog_encryption) {
   td::Binlog::destroy(binlog_name).ignore();
 }
 
+TEST(DB, binlog_background_reindex) {
+  td::CSlice binlog_name = "test_binlog";
+  for (auto db_key : {td::DbKey::empty(), td::DbKey::raw_key(td::string(32, 'A'))}) {
+    td::Binlog::destroy(binlog_name).ignore();
+
+    std::map<td::uint64, td::string> events;
+    {
+      td::Binlog binlog;
+      binlog.init(binlog_name.str(), [](const td::BinlogEvent &x) {}, db_key).ensure();
+      auto get_data = [](td::uint64 event_id) {
+        return td::string(td::Random::fast(25, 500) * 4, static_cast<char>('a' + event_id % 26));
+      };
+      for (int i = 0; i < 3000; i++) {
+        auto data = get_data(binlog.peek_next_event_id());
+        auto event_id = binlog.add(1, td::create_storer(data));
+        events[event_id] = data;
+      }
+
+      // a new encrypted binlog is reindexed synchronously during initialization
+      auto reindex_count = binlog.get_reindex_statistics().reindex_count;
+      bool was_in_progress = false;
+      for (int i = 0; i < 100000 && binlog.get_reindex_statistics().reindex_count == reindex_count; i++) {
+        auto it = events.lower_bound(td::Random::fast_uint64() % binlog.peek_next_event_id());
+        if (it == events.end()) {
+          it = events.begin();
+        }
+        if (td::Random::fast(0, 3) == 0) {
+          auto data = get_data(binlog.peek_next_event_id());
+          binlog.rewrite(it->first, 1, td::create_storer(data));
+          it->second = data;
+        } else {
+          binlog.erase(it->first);
+          events.erase(it);
+        }
+        if (td::Random::fast(0, 9) == 0) {
+          auto data = get_data(binlog.peek_next_event_id());
+          auto event_id = binlog.add(1, td::create_storer(data));
+          events[event_id] = data;
+        }
+        if (binlog.is_background_reindex_in_progress()) {
+          was_in_progress = true;
+        }
+      }
+      ASSERT_TRUE(was_in_progress);
+      ASSERT_TRUE(!binlog.is_background_reindex_in_progress());
+      ASSERT_EQ(reindex_count + 1, binlog.get_reindex_statistics().reindex_count);
+      ASSERT_TRUE(binlog.get_reindex_statistics().total_reclaimed_size > 0);
+
+      auto data = get_data(binlog.peek_next_event_id());
+      auto event_id = binlog.add(1, td::create_storer(data));
+      events[event_id] = data;
+      binlog.close().ensure();
+    }
+
+    std::map<td::uint64, td::string> loaded_events;
+    td::Binlog binlog;
+    binlog
+        .init(
+            binlog_name.str(), [&](const td::BinlogEvent &x) { loaded_events[x.id_] = x.get_data().str(); }, db_key)
+        .ensure();
+    ASSERT_TRUE(events == loaded_events);
+    binlog.close().ensure();
+  }
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
+TEST(DB, binlog_reindex_on_close) {
+  td::CSlice binlog_name = "test_binlog";
+  td::Binlog::destroy(binlog_name).ignore();
+
+  std::map<td::uint64, td::string> events;
+  td::int64 size_before_close = 0;
+  {
+    td::Binlog binlog;
+    binlog.init(binlog_name.str(), [](const td::BinlogEvent &x) {}).ensure();
+    for (int i = 0; i < 1000; i++) {
+      auto data = td::string(400, static_cast<char>('a' + i % 26));
+      auto event_id = binlog.add(1, td::create_storer(data));
+      events[event_id] = data;
+    }
+    for (int i = 0; i < 600; i++) {
+      binlog.erase(events.begin()->first);
+      events.erase(events.begin());
+    }
+    ASSERT_TRUE(!binlog.is_background_reindex_in_progress());
+    binlog.sync("binlog_reindex_on_close");
+    size_before_close = td::stat(binlog_name).move_as_ok().size_;
+    binlog.close().ensure();
+  }
+  auto size_after_close = td::stat(binlog_name).move_as_ok().size_;
+  ASSERT_TRUE(size_after_close * 2 < size_before_close);
+
+  std::map<td::uint64, td::string> loaded_events;
+  td::Binlog binlog;
+  binlog.init(binlog_name.str(), [&](const td::BinlogEvent &x) { loaded_events[x.id_] = x.get_data().str(); })
+      .ensure();
+  ASSERT_TRUE(events == loaded_events);
+  binlog.close().ensure();
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
+TEST(DB, binlog_parallel_load) {
+  td::CSlice binlog_name = "test_binlog";
+  td::Binlog::destroy(binlog_name).ignore();
+
+  std::map<td::uint64, td::string> events;
+  td::uint64 last_event_id = 0;
+  {
+    td::Binlog binlog;
+    binlog.init(binlog_name.str(), [](const td::BinlogEvent &x) {}).ensure();
+    for (int i = 0; i < 5000; i++) {
+      auto data = td::string(td::Random::fast(100, 300) * 4, static_cast<char>('a' + i % 26));
+      auto event_id = binlog.add(1, td::create_storer(data));
+      events[event_id] = data;
+      if (i % 10 == 0) {
+        binlog.erase(events.begin()->first);
+        events.erase(events.begin());
+      }
+    }
+    last_event_id = binlog.add(1, td::create_storer(td::string(100, 'z')));
+    binlog.close().ensure();
+  }
+
+  auto load = [&] {
+    std::map<td::uint64, td::string> loaded_events;
+    td::Binlog binlog;
+    binlog.init(binlog_name.str(), [&](const td::BinlogEvent &x) { loaded_events[x.id_] = x.get_data().str(); })
+        .ensure();
+    binlog.close().ensure();
+    return loaded_events;
+  };
+
+  events[last_event_id] = td::string(100, 'z');
+  ASSERT_TRUE(td::stat(binlog_name).ok().size_ > (1 << 20));
+  ASSERT_TRUE(events == load());
+
+  // corrupt CRC of the last event; the event must be dropped and the binlog must be truncated
+  {
+    auto fd = td::FileFd::open(binlog_name, td::FileFd::Flags::Read | td::FileFd::Flags::Write).move_as_ok();
+    auto size = fd.get_size().move_as_ok();
+    fd.pwrite("\x01", size - 1).ensure();
+    fd.close();
+  }
+  events.erase(last_event_id);
+  ASSERT_TRUE(events == load());
+  ASSERT_TRUE(events == load());
+  td::Binlog::destroy(binlog_name).ignore();
+}
+
+TEST(DB, sharded_binlog) {
+  td::CSlice main_binlog_name = "test_binlog";
+  td::CSlice shard_binlog_name = "test_binlog_shard";
+  td::Binlog::destroy(main_binlog_name).ignore();
+  td::Binlog::destroy(shard_binlog_name).ignore();
+
+  std::map<td::uint64, td::string> events;
+  class Main final : public td::Actor {
+   public:
+    Main(td::CSlice main_binlog_name, td::CSlice shard_binlog_name, std::map<td::uint64, td::string> *events)
+        : main_binlog_name_(main_binlog_name), shard_binlog_name_(shard_binlog_name), events_(events) {
+    }
+
+    void start_up() final {
+      auto main_binlog = td::make_unique<td::Binlog>();
+      main_binlog->init(main_binlog_name_.str(), [](const td::BinlogEvent &x) {}).ensure();
+      auto shard_binlog = td::make_unique<td::Binlog>();
+      shard_binlog->init(shard_binlog_name_.str(), [](const td::BinlogEvent &x) {}).ensure();
+      shard_binlog->skip_event_ids(td::ShardedBinlog::get_shard_min_event_id(1));
+
+      td::ShardedBinlog binlog(std::make_shared<td::ConcurrentBinlog>(std::move(main_binlog)));
+      binlog.add_shard(10, 19, std::make_shared<td::ConcurrentBinlog>(std::move(shard_binlog)));
+
+      td::vector<td::uint64> erased_event_ids;
+      for (int i = 0; i < 100; i++) {
+        auto type = i % 2 == 0 ? 1 : 15;
+        auto data = td::to_string(i) + "!!!";
+        data.resize(4 * ((data.size() + 3) / 4), ' ');
+        auto event_id = binlog.add(type, td::create_storer(data));
+        (*events_)[event_id] = data;
+        if (i % 5 == 0) {
+          data = "rewritten " + td::to_string(type);
+          data.resize(4 * ((data.size() + 3) / 4), ' ');
+          binlog.rewrite(event_id, type, td::create_storer(data));
+          (*events_)[event_id] = data;
+        } else if (i % 7 == 0) {
+          binlog.erase(event_id);
+          events_->erase(event_id);
+        } else if (i % 11 == 0) {
+          erased_event_ids.push_back(event_id);
+          events_->erase(event_id);
+        }
+      }
+      // changes of events from unknown shards must be ignored
+      auto unknown_event_id = td::ShardedBinlog::get_shard_min_event_id(2);
+      erased_event_ids.push_back(unknown_event_id);
+      binlog.erase_batch(std::move(erased_event_ids));
+      binlog.erase(unknown_event_id, td::PromiseCreator::lambda([](td::Result<td::Unit> result) {
+        ASSERT_TRUE(result.is_error());
+      }));
+      binlog.rewrite(unknown_event_id, 15, td::create_storer(td::string("unknown ")));
+      binlog.force_sync(td::PromiseCreator::lambda([](td::Unit) {}), "test");
+      binlog.close(td::PromiseCreator::lambda([](td::Unit) { td::Scheduler::instance()->finish(); }));
+      stop();
+    }
+
+   private:
+    td::CSlice main_binlog_name_;
+    td::CSlice shard_binlog_name_;
+    std::map<td::uint64, td::string> *events_;
+  };
+
+  {
+    td::ConcurrentScheduler sched(0, 0);
+    sched.create_actor_unsafe<Main>(0, "Main", main_binlog_name, shard_binlog_name, &events).release();
+    sched.start();
+    while (sched.run_main(10)) {
+      // empty
+    }
+    sched.finish();
+  }
+
+  std::map<td::uint64, td::string> loaded_events;
+  auto load = [&](td::CSlice binlog_name, td::int32 type, td::uint64 min_event_id) {
+    td::Binlog binlog;
+    binlog
+        .init(binlog_name.str(),
+              [&](const td::BinlogEvent &x) {
+                ASSERT_EQ(type, x.type_);
+                ASSERT_TRUE(x.id_ >= min_event_id);
+                loaded_events[x.id_] = x.get_data().str();
+              })
+        .ensure();
+    binlog.close().ensure();
+  };
+  load(main_binlog_name, 1, 1);
+  load(shard_binlog_name, 15, td::ShardedBinlog::get_shard_min_event_id(1));
+  ASSERT_TRUE(events == loaded_events);
+
+  td::Binlog::destroy(main_binlog_name).ignore();
+  td::Binlog::destroy(shard_binlog_name).ignore();
+}
+
 TEST(DB, sqlite_lfs) {
   td::string path = "test_sqlite_db";
   td::SqliteDb::destroy(path).ignore();
@@ -147,6 +397,56 @@ TEST(DB, sqlite_lfs) {
   td::SqliteDb::destroy(path).ignore();
 }
 
+TEST(DB, message_db_index_counts) {
+  td::string path = "test_message_db";
+  td::SqliteDb::destroy(path).ignore();
+  auto db = td::SqliteDb::open_with_key(path, true, td::DbKey::empty()).move_as_ok();
+  td::init_message_db(db, 0).ensure();
+
+  const td::int64 secret_dialog_id = -2000000000000ll + 5;
+  const td::int64 user_dialog_id = 5;
+  auto add_message = [&](td::int64 dialog_id, td::int64 message_id, td::int32 index_mask) {
+    db.exec(PSLICE() << "INSERT OR REPLACE INTO messages VALUES(" << dialog_id << ", " << message_id
+                     << ", NULL, 0, NULL, x'', NULL, " << index_mask << ", NULL, NULL, NULL, 0)")
+        .ensure();
+  };
+  auto delete_message = [&](td::int64 dialog_id, td::int64 message_id) {
+    db.exec(PSLICE() << "DELETE FROM messages WHERE dialog_id = " << dialog_id << " AND message_id = " << message_id)
+        .ensure();
+  };
+  auto get_count = [&](td::int64 dialog_id, td::int32 index_id) {
+    auto stmt =
+        db.get_statement("SELECT message_count FROM message_index_counts WHERE dialog_id = ?1 AND index_id = ?2")
+            .move_as_ok();
+    stmt.bind_int64(1, dialog_id).ensure();
+    stmt.bind_int32(2, index_id).ensure();
+    stmt.step().ensure();
+    return stmt.has_row() ? stmt.view_int32(0) : -1;
+  };
+
+  add_message(secret_dialog_id, 1, 3);
+  add_message(secret_dialog_id, 2, 1);
+  add_message(user_dialog_id, 1, 1);
+  ASSERT_EQ(2, get_count(secret_dialog_id, 0));
+  ASSERT_EQ(1, get_count(secret_dialog_id, 1));
+  ASSERT_EQ(-1, get_count(user_dialog_id, 0));
+
+  // the counters of the previous version of a replaced message must be decreased
+  add_message(secret_dialog_id, 1, 4);
+  ASSERT_EQ(1, get_count(secret_dialog_id, 0));
+  ASSERT_EQ(0, get_count(secret_dialog_id, 1));
+  ASSERT_EQ(1, get_count(secret_dialog_id, 2));
+
+  delete_message(secret_dialog_id, 2);
+  delete_message(user_dialog_id, 1);
+  ASSERT_EQ(0, get_count(secret_dialog_id, 0));
+  ASSERT_EQ(1, get_count(secret_dialog_id, 2));
+  ASSERT_EQ(-1, get_count(user_dialog_id, 0));
+
+  db.close();
+  td::SqliteDb::destroy(path).ignore();
+}
+
 TEST(DB, sqlite_encryption) {
   td::string path = "test_sqlite_db";
   td::SqliteDb::destroy(path).ignore();
@@ -634,6 +934,47 @@ TEST(DB, thread_key_value) {
 }
 #endif
 
+#if !TD_THREAD_UNSUPPORTED
+TEST(DB, binlog_key_value_concurrent_get) {
+  td::CSlice name = "test_binlog_kv_get";
+  td::Binlog::destroy(name).ignore();
+  td::BinlogKeyValue<td::Binlog> kv;
+  kv.init(name.str()).ensure();
+  kv.set("constant", "value");
+  kv.set("counter", "0");
+
+  constexpr int WRITE_COUNT = 1000;
+  std::atomic<bool> is_finished{false};
+  td::vector<td::thread> readers;
+  for (int i = 0; i < 3; i++) {
+    readers.emplace_back([&] {
+      int last_value = 0;
+      while (!is_finished.load()) {
+        ASSERT_EQ("value", kv.get("constant"));
+        ASSERT_TRUE(!kv.isset("unknown"));
+        auto value = td::to_integer<int>(kv.get("counter"));
+        ASSERT_TRUE(value >= last_value);
+        last_value = value;
+      }
+    });
+  }
+  for (int i = 1; i <= WRITE_COUNT; i++) {
+    kv.set("counter", td::to_string(i));
+    if (i % 100 == 0) {
+      // let the readers create a snapshot
+      td::usleep_for(1000);
+    }
+  }
+  is_finished = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(td::to_string(WRITE_COUNT), kv.get("counter"));
+  kv.close();
+  td::Binlog::destroy(name).ignore();
+}
+#endif
+
 TEST(DB, persistent_key_value) {
   using KeyValue = td::BinlogKeyValue<td::ConcurrentBinlog>;
   // using KeyValue = td::SqliteKeyValue;
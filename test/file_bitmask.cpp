@@ -0,0 +1,192 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileBitmask.h"
+
+#include "td/utils/common.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/Slice.h"
+#include "td/utils/SliceBuilder.h"
+#include "td/utils/StringBuilder.h"
+#include "td/utils/tests.h"
+
+// straightforward implementation of the same operations over a bit string
+class SimpleBitmask {
+ public:
+  SimpleBitmask() = default;
+
+  explicit SimpleBitmask(td::Slice data) : data_(td::zero_one_decode(data)) {
+  }
+
+  td::string encode(td::int32 prefix_count) const {
+    auto data = data_;
+    if (prefix_count != -1) {
+      auto truncated_size = static_cast<size_t>((prefix_count + 7) / 8);
+      if (truncated_size <= data.size()) {
+        data.resize(truncated_size);
+        if (prefix_count % 8 != 0) {
+          data.back() = static_cast<char>(data.back() & (0xff >> (8 - prefix_count % 8)));
+        }
+      }
+    }
+    while (!data.empty() && data.back() == '\0') {
+      data.pop_back();
+    }
+    return td::zero_one_encode(data);
+  }
+
+  td::int64 get_total_size(td::int64 part_size, td::int64 file_size) const {
+    td::int64 res = 0;
+    for (td::int64 i = 0; i < size(); i++) {
+      if (get(i)) {
+        auto from = i * part_size;
+        auto to = from + part_size;
+        if (file_size != 0 && file_size < to) {
+          to = file_size;
+        }
+        if (from < to) {
+          res += to - from;
+        }
+      }
+    }
+    return res;
+  }
+
+  bool get(td::int64 offset_part) const {
+    if (offset_part < 0) {
+      return false;
+    }
+    auto index = static_cast<size_t>(offset_part / 8);
+    if (index >= data_.size()) {
+      return false;
+    }
+    return (static_cast<td::uint8>(data_[index]) & (1 << static_cast<int>(offset_part % 8))) != 0;
+  }
+
+  td::int64 get_ready_parts(td::int64 offset_part) const {
+    td::int64 res = 0;
+    while (get(offset_part + res)) {
+      res++;
+    }
+    return res;
+  }
+
+  td::vector<td::int32> as_vector() const {
+    td::vector<td::int32> res;
+    for (td::int32 i = 0; i < size(); i++) {
+      if (get(i)) {
+        res.push_back(i);
+      }
+    }
+    return res;
+  }
+
+  void set(td::int64 offset_part) {
+    auto need_size = static_cast<size_t>(offset_part / 8 + 1);
+    if (need_size > data_.size()) {
+      data_.resize(need_size, '\0');
+    }
+    data_[need_size - 1] = static_cast<char>(data_[need_size - 1] | (1 << (offset_part % 8)));
+  }
+
+  td::int64 size() const {
+    return static_cast<td::int64>(data_.size()) * 8;
+  }
+
+  td::string to_string() const {
+    td::string res;
+    bool prev = false;
+    td::int32 cnt = 0;
+    for (td::int64 i = 0; i <= size(); i++) {
+      bool cur = get(i);
+      if (cur != prev) {
+        if (cnt < 5) {
+          res.append(cnt, prev ? '1' : '0');
+        } else {
+          res += PSTRING() << (prev ? '1' : '0') << "(x" << cnt << ')';
+        }
+        cnt = 0;
+      }
+      prev = cur;
+      cnt++;
+    }
+    return res;
+  }
+
+  SimpleBitmask compress(int k) const {
+    SimpleBitmask res;
+    for (td::int64 i = 0; i * k < size(); i++) {
+      bool f = true;
+      for (td::int64 j = 0; j < k && f; j++) {
+        f &= get(i * k + j);
+      }
+      if (f) {
+        res.set(i);
+      }
+    }
+    return res;
+  }
+
+ private:
+  td::string data_;
+};
+
+static void check_equal(const td::Bitmask &bitmask, const SimpleBitmask &simple_bitmask, td::int64 max_part) {
+  for (td::int64 i = -1; i <= max_part; i++) {
+    ASSERT_EQ(simple_bitmask.get(i), bitmask.get(i));
+    ASSERT_EQ(simple_bitmask.get_ready_parts(i), bitmask.get_ready_parts(i));
+  }
+  ASSERT_TRUE(simple_bitmask.as_vector() == bitmask.as_vector());
+  ASSERT_EQ(simple_bitmask.encode(-1), bitmask.encode());
+  for (int i = 0; i < 10; i++) {
+    auto prefix_count = td::Random::fast(0, static_cast<int>(max_part) + 16);
+    ASSERT_EQ(simple_bitmask.encode(prefix_count), bitmask.encode(prefix_count));
+  }
+  for (int i = 0; i < 10; i++) {
+    auto part_size = td::Random::fast(1, 1000);
+    auto file_size = td::Random::fast_bool() ? 0 : td::Random::fast(1, static_cast<int>(max_part + 2) * part_size);
+    ASSERT_EQ(simple_bitmask.get_total_size(part_size, file_size), bitmask.get_total_size(part_size, file_size));
+  }
+}
+
+TEST(FileBitmask, random) {
+  for (int test = 0; test < 100; test++) {
+    auto max_part = td::Random::fast(1, test < 50 ? 64 : 1000);
+    td::Bitmask bitmask;
+    SimpleBitmask simple_bitmask;
+    auto set_count = td::Random::fast(0, 2 * max_part);
+    for (int i = 0; i < set_count; i++) {
+      auto part = td::Random::fast(0, max_part);
+      bitmask.set(part);
+      simple_bitmask.set(part);
+      if (i % 50 == 0) {
+        check_equal(bitmask, simple_bitmask, max_part);
+      }
+    }
+    check_equal(bitmask, simple_bitmask, max_part);
+    ASSERT_EQ(simple_bitmask.to_string(), td::string(PSTRING() << bitmask));
+
+    auto encoded = bitmask.encode();
+    check_equal(td::Bitmask(td::Bitmask::Decode{}, encoded), SimpleBitmask(encoded), max_part);
+
+    for (int k = 1; k <= 9; k++) {
+      check_equal(bitmask.compress(k), simple_bitmask.compress(k), max_part);
+    }
+  }
+}
+
+TEST(FileBitmask, ones) {
+  for (int count = 0; count <= 100; count++) {
+    td::Bitmask bitmask(td::Bitmask::Ones{}, count);
+    SimpleBitmask simple_bitmask;
+    for (int i = 0; i < count; i++) {
+      simple_bitmask.set(i);
+    }
+    check_equal(bitmask, simple_bitmask, count + 1);
+    ASSERT_EQ(count, bitmask.get_ready_parts(0));
+  }
+}
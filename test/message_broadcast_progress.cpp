@@ -0,0 +1,133 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/MessageBroadcastProgress.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+#include "td/utils/tl_helpers.h"
+
+TEST(MessageBroadcastProgress, commit) {
+  td::MessageBroadcastProgress progress;
+  ASSERT_TRUE(!progress.need_save());
+  for (td::int32 i = 0; i < 4; i++) {
+    ASSERT_EQ(i, progress.start_next_message());
+  }
+  ASSERT_EQ(4, progress.get_active_query_count());
+
+  // messages finished out of order must not be committed before the previous messages
+  progress.finish_message(1, false);
+  progress.finish_message(2, true);
+  ASSERT_EQ(0, progress.get_committed_dialog_pos());
+  ASSERT_EQ(1, progress.get_sent_count());
+  ASSERT_EQ(1, progress.get_failed_count());
+  ASSERT_TRUE(!progress.need_save());
+
+  progress.finish_message(0, true);
+  ASSERT_EQ(3, progress.get_committed_dialog_pos());
+  ASSERT_EQ(4, progress.get_next_dialog_pos());
+  ASSERT_TRUE(progress.get_failed_dialog_positions() == td::vector<td::int32>{1});
+  ASSERT_TRUE(progress.need_save());
+  ASSERT_TRUE(!progress.need_save());
+
+  progress.finish_message(3, false);
+  ASSERT_EQ(0, progress.get_active_query_count());
+  progress.fail_remaining_messages(6);
+  ASSERT_EQ(6, progress.get_committed_dialog_pos());
+  ASSERT_EQ(2, progress.get_sent_count());
+  ASSERT_EQ(4, progress.get_failed_count());
+  ASSERT_TRUE((progress.get_failed_dialog_positions() == td::vector<td::int32>{1, 3, 4, 5}));
+  ASSERT_TRUE(progress.need_save());
+}
+
+namespace {
+struct RawMessageBroadcastProgress {
+  td::int32 committed_dialog_pos = 0;
+  td::int32 committed_sent_count = 0;
+  td::vector<td::int32> failed_dialog_positions;
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    td::store(committed_dialog_pos, storer);
+    td::store(committed_sent_count, storer);
+    td::store(failed_dialog_positions, storer);
+  }
+};
+}  // namespace
+
+TEST(MessageBroadcastProgress, store) {
+  td::MessageBroadcastProgress progress;
+  for (int i = 0; i < 3; i++) {
+    progress.start_next_message();
+  }
+  progress.finish_message(0, false);
+  progress.finish_message(2, true);
+
+  // only the committed state must be saved
+  td::MessageBroadcastProgress new_progress;
+  ASSERT_TRUE(td::unserialize(new_progress, td::serialize(progress)).is_ok());
+  ASSERT_EQ(1, new_progress.get_committed_dialog_pos());
+  ASSERT_EQ(1, new_progress.get_next_dialog_pos());
+  ASSERT_EQ(0, new_progress.get_active_query_count());
+  ASSERT_EQ(0, new_progress.get_sent_count());
+  ASSERT_EQ(1, new_progress.get_failed_count());
+  ASSERT_TRUE(!new_progress.need_save());
+  ASSERT_EQ(1, new_progress.start_next_message());
+
+  // failed chats must be before the committed position
+  RawMessageBroadcastProgress raw_progress;
+  raw_progress.committed_dialog_pos = 2;
+  raw_progress.committed_sent_count = 1;
+  raw_progress.failed_dialog_positions = {1};
+  ASSERT_TRUE(td::unserialize(new_progress, td::serialize(raw_progress)).is_ok());
+  raw_progress.failed_dialog_positions = {2};
+  ASSERT_TRUE(td::unserialize(new_progress, td::serialize(raw_progress)).is_error());
+  raw_progress.failed_dialog_positions = {0, 1};
+  ASSERT_TRUE(td::unserialize(new_progress, td::serialize(raw_progress)).is_error());
+}
+
+TEST(MessageBroadcastProgress, random) {
+  for (int test = 0; test < 100; test++) {
+    td::MessageBroadcastProgress progress;
+    auto dialog_count = td::Random::fast(1, 100);
+    td::vector<int> states(dialog_count, 0);  // 0 - not sent, 1 - pending, 2 - sent, 3 - failed
+    td::vector<td::int32> pending_dialog_positions;
+    while (progress.get_committed_dialog_pos() < dialog_count) {
+      if (progress.get_next_dialog_pos() < dialog_count &&
+          (pending_dialog_positions.empty() || td::Random::fast_bool())) {
+        auto dialog_pos = progress.start_next_message();
+        ASSERT_EQ(0, states[dialog_pos]);
+        states[dialog_pos] = 1;
+        pending_dialog_positions.push_back(dialog_pos);
+        continue;
+      }
+      auto pos = static_cast<size_t>(td::Random::fast(0, static_cast<int>(pending_dialog_positions.size()) - 1));
+      auto dialog_pos = pending_dialog_positions[pos];
+      pending_dialog_positions[pos] = pending_dialog_positions.back();
+      pending_dialog_positions.pop_back();
+      bool is_sent = td::Random::fast_bool();
+      progress.finish_message(dialog_pos, is_sent);
+      states[dialog_pos] = is_sent ? 2 : 3;
+
+      td::int32 committed_dialog_pos = 0;
+      while (committed_dialog_pos < dialog_count && states[committed_dialog_pos] >= 2) {
+        committed_dialog_pos++;
+      }
+      ASSERT_EQ(committed_dialog_pos, progress.get_committed_dialog_pos());
+      ASSERT_EQ(static_cast<td::int32>(pending_dialog_positions.size()), progress.get_active_query_count());
+    }
+
+    td::vector<td::int32> failed_dialog_positions;
+    for (td::int32 dialog_pos = 0; dialog_pos < dialog_count; dialog_pos++) {
+      if (states[dialog_pos] == 3) {
+        failed_dialog_positions.push_back(dialog_pos);
+      }
+    }
+    ASSERT_TRUE(progress.get_failed_dialog_positions() == failed_dialog_positions);
+    ASSERT_EQ(dialog_count, progress.get_sent_count() + progress.get_failed_count());
+  }
+}
@@ -11,6 +11,7 @@
 #include "td/telegram/telegram_api.h"
 
 #include "td/mtproto/AuthData.h"
+#include "td/mtproto/CryptoWorkerPool.h"
 #include "td/mtproto/DhCallback.h"
 #include "td/mtproto/DhHandshake.h"
 #include "td/mtproto/Handshake.h"
@@ -40,12 +41,14 @@
 #include "td/utils/port/SocketFd.h"
 #include "td/utils/Promise.h"
 #include "td/utils/Random.h"
+#include "td/utils/ScopeGuard.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
 #include "td/utils/Status.h"
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
+#include <atomic>
 #include <memory>
 
 TEST(Mtproto, GetHostByNameActor) {
@@ -740,3 +743,35 @@ TEST(Mtproto, RSA) {
   rsa.encrypt(pem.substr(0, 256), to);
   ASSERT_EQ("U2nJEtB2AgpHrm3HB0yhpTQgb0wbesi9Pv/W1v/vULU=", td::base64_encode(td::sha256(to)));
 }
+
+TEST(Mtproto, CryptoWorkerPool) {
+  auto old_thread_count = td::mtproto::CryptoWorkerPool::get_thread_count();
+  SCOPE_EXIT {
+    td::mtproto::CryptoWorkerPool::set_thread_count(old_thread_count);
+  };
+  td::mtproto::CryptoWorkerPool::set_thread_count(3);
+  ASSERT_TRUE(td::mtproto::CryptoWorkerPool::is_enabled());
+  ASSERT_EQ(3, td::mtproto::CryptoWorkerPool::get_thread_count());
+
+  for (size_t task_count : {0, 1, 2, 7, 100}) {
+    td::vector<std::atomic<int>> calls(task_count);
+    for (auto &call : calls) {
+      call = 0;
+    }
+    std::atomic<size_t> total_calls{0};
+    td::mtproto::CryptoWorkerPool::run(task_count, [&](size_t i) {
+      calls[i]++;
+      total_calls++;
+    });
+    ASSERT_EQ(task_count, total_calls.load());
+    for (auto &call : calls) {
+      ASSERT_EQ(1, call.load());
+    }
+  }
+
+  td::mtproto::CryptoWorkerPool::set_thread_count(0);
+  ASSERT_TRUE(!td::mtproto::CryptoWorkerPool::is_enabled());
+  std::atomic<size_t> total_calls{0};
+  td::mtproto::CryptoWorkerPool::run(5, [&](size_t) { total_calls++; });
+  ASSERT_EQ(5u, total_calls.load());
+}
@@ -0,0 +1,62 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/net/NetQueryRateLimiter.h"
+
+#include "td/utils/tests.h"
+
+TEST(NetQueryRateLimiter, refill) {
+  td::NetQueryRateLimiter rate_limiter(10, 100.0);
+  // one query per flood wait period is allowed after the flood wait
+  ASSERT_TRUE(!rate_limiter.take_token(105.0));
+  ASSERT_EQ(110.0, rate_limiter.get_release_time(0, 105.0));
+  ASSERT_TRUE(!rate_limiter.take_token(110.0));
+  ASSERT_EQ(120.0, rate_limiter.get_release_time(1, 110.0));
+  ASSERT_TRUE(!rate_limiter.take_token(115.0));
+  ASSERT_TRUE(rate_limiter.take_token(120.0));
+  ASSERT_TRUE(!rate_limiter.take_token(120.0));
+
+  // the rate must increase without flood waits
+  ASSERT_TRUE(rate_limiter.get_rate(130.0) > 0.25);
+  ASSERT_TRUE(rate_limiter.get_rate(130.0) < 0.3);
+  auto unlimited_time = rate_limiter.get_unlimited_time(130.0);
+  ASSERT_TRUE(unlimited_time > 251.0);
+  ASSERT_TRUE(unlimited_time < 252.0);
+  ASSERT_EQ(300.0, rate_limiter.get_unlimited_time(300.0));
+  ASSERT_EQ(td::NetQueryRateLimiter::MAX_RATE, rate_limiter.get_rate(300.0));
+}
+
+TEST(NetQueryRateLimiter, burst) {
+  td::NetQueryRateLimiter rate_limiter(1, 0.0);
+  // only one query can be sent immediately after a long pause
+  ASSERT_TRUE(rate_limiter.take_token(1000.0));
+  ASSERT_TRUE(!rate_limiter.take_token(1000.0));
+  ASSERT_TRUE(rate_limiter.get_release_time(1, 1000.0) > 1000.0);
+  ASSERT_TRUE(rate_limiter.get_release_time(1, 1000.0) < 1000.02);
+  ASSERT_TRUE(rate_limiter.get_release_time(10, 1000.0) > rate_limiter.get_release_time(1, 1000.0));
+}
+
+TEST(NetQueryRateLimiter, flood_wait) {
+  td::NetQueryRateLimiter rate_limiter(2, 0.0);
+  ASSERT_EQ(0.5, rate_limiter.get_rate(0.0));
+  ASSERT_TRUE(rate_limiter.take_token(4.0));
+
+  // a repeated flood wait must block the queries, drop the accumulated tokens and halve the rate
+  auto rate = rate_limiter.get_rate(5.0);
+  rate_limiter.on_flood_wait(30, 5.0);
+  ASSERT_EQ(rate * td::NetQueryRateLimiter::RATE_DECREASE, rate_limiter.get_rate(5.0));
+  ASSERT_TRUE(!rate_limiter.take_token(34.0));
+  ASSERT_EQ(35.0, rate_limiter.get_release_time(0, 34.0));
+
+  // a shorter flood wait must not shorten the block
+  rate_limiter.on_flood_wait(1, 10.0);
+  ASSERT_EQ(35.0, rate_limiter.get_release_time(0, 10.0));
+
+  for (int i = 0; i < 100; i++) {
+    rate_limiter.on_flood_wait(1, 10.0);
+  }
+  ASSERT_EQ(td::NetQueryRateLimiter::MIN_RATE, rate_limiter.get_rate(10.0));
+}
@@ -0,0 +1,255 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/MessageId.h"
+#include "td/telegram/OrderedMessage.h"
+#include "td/telegram/ServerMessageId.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <iterator>
+#include <map>
+
+static td::MessageId get_message_id(td::int32 server_message_id) {
+  return td::MessageId(td::ServerMessageId(server_message_id));
+}
+
+// straightforward implementation of the same operations over std::map
+class SimpleOrderedMessages {
+ public:
+  struct Links {
+    bool have_previous = false;
+    bool have_next = false;
+  };
+
+  void insert(td::MessageId message_id, bool auto_attach, td::MessageId old_last_message_id) {
+    Links links;
+    auto next_it = messages_.upper_bound(message_id);
+    auto previous_it = next_it == messages_.begin() ? messages_.end() : std::prev(next_it);
+    if (auto_attach) {
+      if (previous_it != messages_.end() &&
+          (previous_it->second.have_next ||
+           (old_last_message_id.is_valid() && previous_it->first >= old_last_message_id))) {
+        links.have_next = previous_it->second.have_next;
+        links.have_previous = true;
+        previous_it->second.have_next = true;
+      } else if (next_it != messages_.end()) {
+        links.have_next = true;
+        next_it->second.have_previous = true;
+      }
+    } else if (previous_it != messages_.end() && previous_it->second.have_next) {
+      previous_it->second.have_next = false;
+      next_it->second.have_previous = false;
+    }
+    messages_.emplace(message_id, links);
+  }
+
+  void erase(td::MessageId message_id, bool only_from_memory) {
+    auto it = messages_.find(message_id);
+    CHECK(it != messages_.end());
+    auto links = it->second;
+    if (links.have_previous && (only_from_memory || !links.have_next)) {
+      std::prev(it)->second.have_next = false;
+    }
+    if (links.have_next && (only_from_memory || !links.have_previous)) {
+      std::next(it)->second.have_previous = false;
+    }
+    messages_.erase(it);
+  }
+
+  void attach_message_to_previous(td::MessageId message_id) {
+    auto it = messages_.find(message_id);
+    if (it->second.have_previous) {
+      return;
+    }
+    it->second.have_previous = true;
+    auto &previous = std::prev(it)->second;
+    if (previous.have_next) {
+      it->second.have_next = true;
+    } else {
+      previous.have_next = true;
+    }
+  }
+
+  void attach_message_to_next(td::MessageId message_id) {
+    auto it = messages_.find(message_id);
+    if (it->second.have_next) {
+      return;
+    }
+    it->second.have_next = true;
+    auto &next = std::next(it)->second;
+    if (next.have_previous) {
+      it->second.have_previous = true;
+    } else {
+      next.have_previous = true;
+    }
+  }
+
+  // returns up to limit connected messages before an existing message from_message_id
+  td::vector<td::MessageId> get_history(td::MessageId from_message_id, td::int32 limit) const {
+    td::vector<td::MessageId> result;
+    auto it = messages_.find(from_message_id);
+    CHECK(it != messages_.end());
+    while (it->second.have_previous && static_cast<td::int32>(result.size()) < limit) {
+      --it;
+      result.push_back(it->first);
+    }
+    return result;
+  }
+
+  const std::map<td::MessageId, Links> &get_messages() const {
+    return messages_;
+  }
+
+ private:
+  std::map<td::MessageId, Links> messages_;
+};
+
+static void check_equal(const td::OrderedMessages &ordered_messages, const SimpleOrderedMessages &simple_messages) {
+  const auto &messages = simple_messages.get_messages();
+  ASSERT_EQ(messages.empty(), ordered_messages.empty());
+
+  td::vector<td::MessageId> message_ids;
+  ordered_messages.traverse_messages([](td::MessageId) { return true; },
+                                     [&](td::MessageId message_id) {
+                                       message_ids.push_back(message_id);
+                                       return true;
+                                     });
+  ASSERT_EQ(messages.size(), message_ids.size());
+
+  td::MessageId previous_message_id;
+  size_t pos = 0;
+  for (auto &it : messages) {
+    auto message_id = it.first;
+    ASSERT_TRUE(message_ids[pos++] == message_id);
+
+    auto ordered_it = ordered_messages.get_const_iterator(message_id);
+    ASSERT_TRUE(*ordered_it != nullptr);
+    ASSERT_TRUE((*ordered_it)->get_message_id() == message_id);
+    ASSERT_EQ(it.second.have_next, (*ordered_it)->have_next());
+
+    --ordered_it;
+    if (it.second.have_previous) {
+      ASSERT_TRUE(*ordered_it != nullptr);
+      ASSERT_TRUE((*ordered_it)->get_message_id() == previous_message_id);
+    } else {
+      ASSERT_TRUE(*ordered_it == nullptr);
+    }
+    previous_message_id = message_id;
+  }
+}
+
+TEST(OrderedMessages, get_history) {
+  td::OrderedMessages ordered_messages;
+  for (td::int32 i = 1; i <= 10; i++) {
+    ordered_messages.insert(get_message_id(i), true, get_message_id(i - 1), "get_history");
+  }
+  auto last_message_id = get_message_id(10);
+
+  auto from_message_id = get_message_id(5);
+  td::int32 offset = 0;
+  td::int32 limit = 3;
+  auto message_ids = ordered_messages.get_history(last_message_id, from_message_id, offset, limit, false);
+  ASSERT_EQ(3u, message_ids.size());
+  ASSERT_TRUE(message_ids[0] == get_message_id(4));
+  ASSERT_TRUE(message_ids[2] == get_message_id(2));
+
+  // the history must include from_message_id and 1 newer message
+  from_message_id = get_message_id(5);
+  offset = -2;
+  limit = 4;
+  message_ids = ordered_messages.get_history(last_message_id, from_message_id, offset, limit, false);
+  ASSERT_EQ(4u, message_ids.size());
+  ASSERT_TRUE(message_ids[0] == get_message_id(6));
+  ASSERT_TRUE(message_ids[3] == get_message_id(3));
+
+  // the newest messages must be returned if from_message_id is after the last message
+  from_message_id = td::MessageId::max();
+  offset = 0;
+  limit = 2;
+  message_ids = ordered_messages.get_history(last_message_id, from_message_id, offset, limit, false);
+  ASSERT_EQ(2u, message_ids.size());
+  ASSERT_TRUE(message_ids[0] == get_message_id(10));
+
+  // nothing must be returned after a gap
+  ordered_messages.insert(get_message_id(20), false, td::MessageId(), "get_history");
+  from_message_id = get_message_id(15);
+  offset = 0;
+  limit = 5;
+  message_ids = ordered_messages.get_history(get_message_id(20), from_message_id, offset, limit, false);
+  ASSERT_TRUE(message_ids.empty());
+
+  ordered_messages.erase(get_message_id(20), false);
+  ordered_messages.erase(get_message_id(1), false);
+  from_message_id = get_message_id(3);
+  offset = 0;
+  limit = 5;
+  message_ids = ordered_messages.get_history(last_message_id, from_message_id, offset, limit, false);
+  // the first message was deleted from the chat, so the history must end at the second message
+  ASSERT_EQ(1u, message_ids.size());
+  ASSERT_TRUE(message_ids[0] == get_message_id(2));
+}
+
+TEST(OrderedMessages, random) {
+  // enough messages to have many chunks, which are split and merged
+  constexpr td::int32 MAX_SERVER_MESSAGE_ID = 2000;
+  for (int test = 0; test < 10; test++) {
+    td::OrderedMessages ordered_messages;
+    SimpleOrderedMessages simple_messages;
+    td::vector<td::MessageId> message_ids;
+    for (int i = 0; i < 5000; i++) {
+      auto type = td::Random::fast(0, 9);
+      if (type < 5 || message_ids.empty()) {
+        auto message_id = get_message_id(td::Random::fast(1, MAX_SERVER_MESSAGE_ID));
+        if (simple_messages.get_messages().count(message_id) != 0) {
+          continue;
+        }
+        bool auto_attach = td::Random::fast_bool();
+        auto old_last_message_id =
+            td::Random::fast_bool() ? td::MessageId() : get_message_id(td::Random::fast(1, MAX_SERVER_MESSAGE_ID));
+        ordered_messages.insert(message_id, auto_attach, old_last_message_id, "random");
+        simple_messages.insert(message_id, auto_attach, old_last_message_id);
+        message_ids.push_back(message_id);
+        continue;
+      }
+
+      auto pos = static_cast<size_t>(td::Random::fast(0, static_cast<int>(message_ids.size()) - 1));
+      auto message_id = message_ids[pos];
+      const auto &messages = simple_messages.get_messages();
+      auto it = messages.find(message_id);
+      if (type < 7) {
+        bool only_from_memory = td::Random::fast_bool();
+        ordered_messages.erase(message_id, only_from_memory);
+        simple_messages.erase(message_id, only_from_memory);
+        message_ids[pos] = message_ids.back();
+        message_ids.pop_back();
+      } else if (type == 7) {
+        if (it != messages.begin()) {
+          ordered_messages.attach_message_to_previous(message_id, "random");
+          simple_messages.attach_message_to_previous(message_id);
+        }
+      } else if (type == 8) {
+        if (std::next(it) != messages.end()) {
+          ordered_messages.attach_message_to_next(message_id, "random");
+          simple_messages.attach_message_to_next(message_id);
+        }
+      } else {
+        auto from_message_id = message_id;
+        td::int32 offset = 0;
+        td::int32 limit = td::Random::fast(1, 100);
+        auto result = ordered_messages.get_history(td::MessageId(), from_message_id, offset, limit, false);
+        ASSERT_TRUE(result == simple_messages.get_history(message_id, limit));
+      }
+      if (i % 100 == 0) {
+        check_equal(ordered_messages, simple_messages);
+      }
+    }
+    check_equal(ordered_messages, simple_messages);
+  }
+}
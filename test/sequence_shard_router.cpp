@@ -0,0 +1,134 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/SequenceShardRouter.h"
+
+#include "td/utils/algorithm.h"
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <map>
+#include <utility>
+
+namespace {
+class SentQueries {
+ public:
+  void operator()(size_t shard, int query) {
+    sent_.emplace_back(shard, query);
+  }
+
+  td::vector<std::pair<size_t, int>> get() {
+    auto result = std::move(sent_);
+    sent_.clear();
+    return result;
+  }
+
+ private:
+  td::vector<std::pair<size_t, int>> sent_;
+};
+}  // namespace
+
+TEST(SequenceShardRouter, blocked_shard) {
+  td::SequenceShardRouter<int> router(4);
+  SentQueries sent;
+
+  // chains 1 and 2 are handled by different shards
+  router.add_query({1}, 1, sent);
+  router.add_query({2}, 2, sent);
+  ASSERT_TRUE((sent.get() == td::vector<std::pair<size_t, int>>{{1, 1}, {2, 2}}));
+
+  // the query must wait until one of the chains is finished
+  router.add_query({1, 2}, 3, sent);
+  // a query with one of the chains must wait for the blocked query
+  router.add_query({2}, 4, sent);
+  ASSERT_TRUE(sent.get().empty());
+  ASSERT_EQ(2u, router.get_blocked_query_count());
+
+  // queries with other chains must not be blocked
+  router.add_query({3}, 5, sent);
+  router.add_query({3, 7}, 6, sent);
+  router.add_query({6}, 7, sent);
+  ASSERT_TRUE((sent.get() == td::vector<std::pair<size_t, int>>{{3, 5}, {3, 6}, {2, 7}}));
+
+  // chains 3 and 6 are handled by different shards too, but the earlier blocked queries must not delay the query
+  router.add_query({3, 6}, 8, sent);
+  ASSERT_EQ(3u, router.get_blocked_query_count());
+  router.on_query_finished(td::vector<td::uint64>{3}, sent);
+  ASSERT_TRUE(sent.get().empty());
+  router.on_query_finished(td::vector<td::uint64>{3, 7}, sent);
+  ASSERT_TRUE((sent.get() == td::vector<std::pair<size_t, int>>{{2, 8}}));
+  ASSERT_EQ(2u, router.get_blocked_query_count());
+
+  router.on_query_finished(td::vector<td::uint64>{1}, sent);
+  ASSERT_TRUE((sent.get() == td::vector<std::pair<size_t, int>>{{2, 3}, {2, 4}}));
+  ASSERT_EQ(0u, router.get_blocked_query_count());
+
+  router.add_query({9}, 9, sent);
+  router.add_query({9, 2}, 10, sent);
+  ASSERT_TRUE((sent.get() == td::vector<std::pair<size_t, int>>{{1, 9}}));
+  ASSERT_TRUE(router.close() == td::vector<int>{10});
+}
+
+TEST(SequenceShardRouter, random) {
+  // checks that queries with a common chain are never sent simultaneously through different shards,
+  // that queries with a common chain are sent in the order of addition, and that all queries are sent
+  for (int test = 0; test < 100; test++) {
+    td::SequenceShardRouter<int> router(td::Random::fast(1, 4));
+    std::map<int, td::vector<td::uint64>> query_chain_ids;
+    std::map<td::uint64, std::pair<size_t, int>> active_chains;  // shard and the number of active queries
+    std::map<td::uint64, int> last_sent_query;
+    td::vector<int> active_queries;
+    int sent_query_count = 0;
+    auto on_sent = [&](size_t shard, int query) {
+      sent_query_count++;
+      for (auto chain_id : query_chain_ids[query]) {
+        auto &active_chain = active_chains[chain_id];
+        ASSERT_TRUE(active_chain.second == 0 || active_chain.first == shard);
+        active_chain.first = shard;
+        active_chain.second++;
+        ASSERT_TRUE(last_sent_query[chain_id] < query);
+        last_sent_query[chain_id] = query;
+      }
+      active_queries.push_back(query);
+    };
+
+    int query_count = 0;
+    for (int i = 0; i < 1000; i++) {
+      if (active_queries.empty() || td::Random::fast_bool()) {
+        auto query = ++query_count;
+        auto &chain_ids = query_chain_ids[query];
+        auto chain_count = td::Random::fast(1, 3);
+        for (int j = 0; j < chain_count; j++) {
+          auto chain_id = static_cast<td::uint64>(td::Random::fast(1, 10));
+          if (!td::contains(chain_ids, chain_id)) {
+            chain_ids.push_back(chain_id);
+          }
+        }
+        router.add_query(chain_ids, query, on_sent);
+      } else {
+        auto pos = static_cast<size_t>(td::Random::fast(0, static_cast<int>(active_queries.size()) - 1));
+        auto query = active_queries[pos];
+        active_queries[pos] = active_queries.back();
+        active_queries.pop_back();
+        for (auto chain_id : query_chain_ids[query]) {
+          active_chains[chain_id].second--;
+        }
+        router.on_query_finished(query_chain_ids[query], on_sent);
+      }
+    }
+    while (!active_queries.empty()) {
+      auto query = active_queries.back();
+      active_queries.pop_back();
+      for (auto chain_id : query_chain_ids[query]) {
+        active_chains[chain_id].second--;
+      }
+      router.on_query_finished(query_chain_ids[query], on_sent);
+    }
+    ASSERT_EQ(query_count, sent_query_count);
+    ASSERT_EQ(0u, router.get_blocked_query_count());
+  }
+}
@@ -0,0 +1,76 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/FileGcWorker.h"
+#include "td/telegram/files/FileManager.h"
+
+#include "td/utils/CancellationToken.h"
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
+#include "td/utils/Slice.h"
+#include "td/utils/tests.h"
+
+static void create_file(td::CSlice path, td::Slice data) {
+  auto fd = td::FileFd::open(path, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+  fd.write(data).ensure();
+  fd.close();
+}
+
+TEST(FileManager, shared_file_store_path) {
+  ASSERT_EQ(td::string("store") + TD_DIR_SLASH + "AgADBAAD_9",
+            td::FileManager::get_shared_file_store_path("store", "AgADBAAD", 9));
+  ASSERT_EQ(td::string("store") + TD_DIR_SLASH + "AgADBAAD_9",
+            td::FileManager::get_shared_file_store_path(td::string("store") + TD_DIR_SLASH, "AgADBAAD", 9));
+  // files can't be shared without a store, a unique identifier or a known size
+  ASSERT_TRUE(td::FileManager::get_shared_file_store_path("", "AgADBAAD", 9).empty());
+  ASSERT_TRUE(td::FileManager::get_shared_file_store_path("store", "", 9).empty());
+  ASSERT_TRUE(td::FileManager::get_shared_file_store_path("store", "AgADBAAD", 0).empty());
+}
+
+TEST(FileManager, shared_file_store) {
+  td::string dir = "test_shared_file_store";
+  td::rmrf(dir).ignore();
+  td::string path = "test_shared_file";
+  td::string other_path = "test_shared_file_copy";
+  td::unlink(path).ignore();
+  td::unlink(other_path).ignore();
+
+  create_file(path, "shared file");
+  auto store_path = td::FileManager::get_shared_file_store_path(dir, "AgADBAAD", 11);
+  auto status = td::FileManager::link_to_shared_file_store(path, store_path);
+  if (status.is_error()) {
+    LOG(ERROR) << "File system doesn't support hard links: " << status;
+    td::unlink(path).ensure();
+    td::rmrf(dir).ignore();
+    return;
+  }
+  // the file can be added only once
+  ASSERT_TRUE(td::FileManager::link_to_shared_file_store(path, store_path).is_error());
+
+  // the store is trusted by file size, so a file of a different size must not be used
+  ASSERT_TRUE(td::FileManager::link_from_shared_file_store(store_path, 12, other_path).is_error());
+  ASSERT_TRUE(td::stat(other_path).is_error());
+  td::FileManager::link_from_shared_file_store(store_path, 11, other_path).ensure();
+  ASSERT_EQ(11, td::stat(other_path).move_as_ok().size_);
+  ASSERT_EQ(3, td::stat(store_path).move_as_ok().link_count_);
+
+  td::CancellationTokenSource source;
+  auto token = source.get_cancellation_token();
+  td::unlink(path).ensure();
+  ASSERT_EQ(0, td::FileGcWorker::remove_unused_shared_files(dir, token));
+  ASSERT_TRUE(td::stat(store_path).is_ok());
+
+  // the store entry is removed after the last client deletes its copy of the file
+  td::unlink(other_path).ensure();
+  ASSERT_EQ(1, td::FileGcWorker::remove_unused_shared_files(dir, token));
+  ASSERT_TRUE(td::stat(store_path).is_error());
+  ASSERT_TRUE(td::FileManager::link_from_shared_file_store(store_path, 11, other_path).is_error());
+
+  td::rmrf(dir).ignore();
+}
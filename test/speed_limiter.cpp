@@ -0,0 +1,54 @@
+//
+// Copyright Aliaksei Levin (levlam@telegram.org), Arseny Smirnov (arseny30@gmail.com) 2014-2024
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+#include "td/telegram/files/SpeedLimiter.h"
+
+#include "td/utils/tests.h"
+
+TEST(SpeedLimiter, no_limit) {
+  td::SpeedLimiter speed_limiter;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(0, 1.0));
+    speed_limiter.on_part_started(1 << 20);
+  }
+  // parts sent without a limit must not be accounted after the limit is set
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1000, 1.0));
+}
+
+TEST(SpeedLimiter, refill) {
+  td::SpeedLimiter speed_limiter;
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1000, 10.0));
+  // a part bigger than the budget can be sent
+  speed_limiter.on_part_started(3000);
+  ASSERT_EQ(12.0, speed_limiter.get_wakeup_time(1000, 10.0));
+  ASSERT_EQ(12.0, speed_limiter.get_wakeup_time(1000, 11.0));
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1000, 12.0));
+
+  // the debt must be paid off with the current limit
+  speed_limiter.on_part_started(4000);
+  ASSERT_EQ(14.0, speed_limiter.get_wakeup_time(2000, 12.0));
+}
+
+TEST(SpeedLimiter, burst) {
+  td::SpeedLimiter speed_limiter;
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1000, 0.0));
+  // unused speed must be accumulated only for 1 second
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1000, 100.0));
+  speed_limiter.on_part_started(1000);
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1000, 100.0));
+  speed_limiter.on_part_started(1000);
+  ASSERT_EQ(101.0, speed_limiter.get_wakeup_time(1000, 100.0));
+}
+
+TEST(SpeedLimiter, remove_limit) {
+  td::SpeedLimiter speed_limiter;
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1, 0.0));
+  speed_limiter.on_part_started(1 << 20);
+  ASSERT_TRUE(speed_limiter.get_wakeup_time(1, 0.0) > 1000.0);
+  // the debt must be forgotten after the limit is removed
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(0, 0.0));
+  ASSERT_EQ(0.0, speed_limiter.get_wakeup_time(1, 0.0));
+}
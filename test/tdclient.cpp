@@ -955,6 +955,13 @@ TEST(Client, Manager) {
     thread.join();
   }
 
+  td::int32 client_count = 0;
+  for (auto count : client.get_client_distribution()) {
+    ASSERT_TRUE(count >= 0);
+    client_count += count;
+  }
+  ASSERT_EQ(threads_n * clients_n, client_count);
+
   std::set<td::int32> ids;
   while (ids.size() != static_cast<size_t>(threads_n) * clients_n) {
     auto event = client.receive(10);
@@ -970,7 +977,141 @@ TEST(Client, Manager) {
   }
 }
 
+TEST(Client, ManagerSynchronousRequest) {
+  td::ClientManager client;
+  auto id = client.create_client_id();
+  client.send(id, 3, td::make_tl_object<td::td_api::getTextEntities>("@telegram"));
+  client.send(id, 4, td::make_tl_object<td::td_api::testSquareInt>(3));
+  client.send(id, 5, td::make_tl_object<td::td_api::getFileExtension>("image/jpeg"));
+
+  td::int32 response_count = 0;
+  while (response_count != 3) {
+    auto event = client.receive(10);
+    if (event.request_id == 0) {
+      continue;
+    }
+    ASSERT_EQ(id, event.client_id);
+    response_count++;
+    if (event.request_id == 3) {
+      ASSERT_EQ(td::td_api::textEntities::ID, event.object->get_id());
+      ASSERT_EQ(1u, static_cast<td::td_api::textEntities &>(*event.object).entities_.size());
+    } else if (event.request_id == 4) {
+      ASSERT_EQ(td::td_api::testInt::ID, event.object->get_id());
+    } else {
+      ASSERT_EQ(5u, event.request_id);
+      ASSERT_EQ(td::td_api::text::ID, event.object->get_id());
+      ASSERT_STREQ("jpg", static_cast<td::td_api::text &>(*event.object).text_);
+    }
+  }
+}
+
+TEST(Client, ManagerSynchronousRequestClose) {
+  td::ClientManager client;
+  auto id = client.create_client_id();
+  constexpr td::uint64 REQUEST_COUNT = 100;
+  for (td::uint64 request_id = 1; request_id <= REQUEST_COUNT; request_id++) {
+    client.send(id, request_id, td::make_tl_object<td::td_api::testSquareInt>(static_cast<td::int32>(request_id)));
+  }
+  client.send(id, REQUEST_COUNT + 1, td::make_tl_object<td::td_api::close>());
+
+  // responses to synchronous requests of the same client must be received in order and before the client is closed
+  td::uint64 last_request_id = 0;
+  while (true) {
+    auto event = client.receive(10);
+    if (event.object == nullptr) {
+      continue;
+    }
+    if (event.request_id == 0) {
+      ASSERT_EQ(id, event.client_id);
+      if (event.object->get_id() == td::td_api::updateAuthorizationState::ID &&
+          static_cast<td::td_api::updateAuthorizationState &>(*event.object).authorization_state_->get_id() ==
+              td::td_api::authorizationStateClosed::ID) {
+        break;
+      }
+      continue;
+    }
+    if (event.request_id == REQUEST_COUNT + 1) {
+      continue;
+    }
+    ASSERT_EQ(last_request_id + 1, event.request_id);
+    last_request_id = event.request_id;
+    ASSERT_EQ(td::td_api::testInt::ID, event.object->get_id());
+    auto value = static_cast<td::int32>(event.request_id);
+    ASSERT_EQ(value * value, static_cast<td::td_api::testInt &>(*event.object).value_);
+  }
+  ASSERT_EQ(REQUEST_COUNT, last_request_id);
+}
+
+TEST(Client, ManagerResponseEncoder) {
+  td::ClientManager client;
+  client.set_response_encoder([](const td::td_api::Object &object) { return td::td_api::to_string(object); });
+  auto id = client.create_client_id();
+  client.send(id, 1, td::make_tl_object<td::td_api::testSquareInt>(3));
+  client.send(id, 2, td::make_tl_object<td::td_api::getTextEntities>("@telegram"));
+  client.send(id, 3, td::make_tl_object<td::td_api::close>());
+
+  int response_count = 0;
+  while (true) {
+    auto event = client.receive(10);
+    if (event.object == nullptr) {
+      continue;
+    }
+    if (event.object->get_id() == td::td_api::updateAuthorizationState::ID) {
+      // updateAuthorizationState is never serialized
+      ASSERT_TRUE(event.encoded_object.empty());
+      if (static_cast<td::td_api::updateAuthorizationState &>(*event.object).authorization_state_->get_id() ==
+          td::td_api::authorizationStateClosed::ID) {
+        break;
+      }
+      continue;
+    }
+    ASSERT_EQ(td::td_api::to_string(event.object), event.encoded_object);
+    if (event.request_id != 0) {
+      response_count++;
+    }
+  }
+  ASSERT_EQ(3, response_count);
+}
+
 #if !TD_EVENTFD_UNSUPPORTED  // Client must be used from a single thread if there is no EventFd
+TEST(Client, ManagerPartitions) {
+  td::ClientManager client;
+  client.set_response_partitioner(
+      2, [](td::ClientManager::ClientId client_id, td::ClientManager::RequestId request_id,
+            const td::td_api::Object &object) { return static_cast<std::int32_t>(request_id % 2); });
+  int clients_n = 10;
+  int requests_n = 100;
+  for (int i = 0; i < clients_n; i++) {
+    auto id = client.create_client_id();
+    for (int j = 1; j <= requests_n; j++) {
+      client.send(id, j, td::make_tl_object<td::td_api::testSquareInt>(j));
+    }
+  }
+
+  std::atomic<int> odd_response_count{0};
+  td::thread odd_thread([&] {
+    while (odd_response_count.load() != clients_n * requests_n / 2) {
+      auto event = client.receive_partition(1, 10);
+      ASSERT_TRUE(event.object != nullptr);
+      ASSERT_EQ(1u, event.request_id % 2);
+      ASSERT_EQ(td::td_api::testInt::ID, event.object->get_id());
+      odd_response_count++;
+    }
+  });
+  int even_response_count = 0;
+  while (even_response_count != clients_n * requests_n / 2) {
+    auto event = client.receive_partition(0, 10);
+    if (event.request_id == 0) {
+      continue;
+    }
+    ASSERT_EQ(0u, event.request_id % 2);
+    ASSERT_EQ(td::td_api::testInt::ID, event.object->get_id());
+    even_response_count++;
+  }
+  odd_thread.join();
+  ASSERT_EQ(clients_n * requests_n / 2, odd_response_count.load());
+}
+
 TEST(Client, Close) {
   std::atomic<bool> stop_send{false};
   std::atomic<bool> can_stop_receive{false};
@@ -13,6 +13,8 @@
 #include "td/utils/common.h"
 #include "td/utils/int_types.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SliceBuilder.h"
@@ -20,6 +22,7 @@
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
+#include <atomic>
 #include <memory>
 #include <utility>
 
@@ -51,6 +54,10 @@ class TestTQueue {
     return td::CSlice("tqueue_binlog");
   }
 
+  static td::CSlice segment_path() {
+    return td::CSlice("tqueue_segments");
+  }
+
   TestTQueue() {
     baseline_ = td::TQueue::create();
 
@@ -66,6 +73,9 @@ class TestTQueue {
     binlog->init(binlog_path().str(), [&](const td::BinlogEvent &event) { UNREACHABLE(); }).ensure();
     tqueue_binlog->set_binlog(std::move(binlog));
     binlog_->set_callback(std::move(tqueue_binlog));
+
+    td::TQueueSegmentStorage::destroy(segment_path()).ignore();
+    open_segment_storage();
   }
 
   TestTQueue(const TestTQueue &) = delete;
@@ -75,6 +85,15 @@ class TestTQueue {
 
   ~TestTQueue() {
     td::Binlog::destroy(binlog_path()).ensure();
+    segment_ = nullptr;
+    td::TQueueSegmentStorage::destroy(segment_path()).ensure();
+  }
+
+  void open_segment_storage() {
+    segment_ = td::TQueue::create();
+    auto segment_storage = td::make_unique<td::TQueueSegmentStorage>();
+    segment_storage->replay(segment_path().str(), *segment_).ensure();
+    segment_->set_callback(std::move(segment_storage));
   }
 
   void restart(td::Random::Xorshift128plus &rnd, td::int32 now) {
@@ -91,6 +110,14 @@ class TestTQueue {
       memory_->run_gc(now);
     }
 
+    if (rnd.fast(0, 10) == 0) {
+      LOG(INFO) << "Restart segment storage";
+      open_segment_storage();
+      if (rnd.fast(0, 2) == 0) {
+        segment_->run_gc(now);
+      }
+    }
+
     if (rnd.fast(0, 30) != 0) {
       return;
     }
@@ -114,8 +141,10 @@ class TestTQueue {
     auto a_id = baseline_->push(queue_id, data, expires_at, 0, new_id).move_as_ok();
     auto b_id = memory_->push(queue_id, data, expires_at, 0, new_id).move_as_ok();
     auto c_id = binlog_->push(queue_id, data, expires_at, 0, new_id).move_as_ok();
+    auto d_id = segment_->push(queue_id, data, expires_at, 0, new_id).move_as_ok();
     ASSERT_EQ(a_id, b_id);
     ASSERT_EQ(a_id, c_id);
+    ASSERT_EQ(a_id, d_id);
     return a_id;
   }
 
@@ -124,6 +153,7 @@ class TestTQueue {
     //ASSERT_EQ(baseline_->get_head(qid), binlog_->get_head(qid));
     ASSERT_EQ(baseline_->get_tail(qid), memory_->get_tail(qid));
     ASSERT_EQ(baseline_->get_tail(qid), binlog_->get_tail(qid));
+    ASSERT_EQ(baseline_->get_tail(qid), segment_->get_tail(qid));
   }
 
   void check_get(td::TQueue::QueueId qid, td::Random::Xorshift128plus &rnd, td::int32 now) {
@@ -133,6 +163,8 @@ class TestTQueue {
     td::MutableSpan<td::TQueue::Event> b_span(b, 10);
     td::TQueue::Event c[10];
     td::MutableSpan<td::TQueue::Event> c_span(c, 10);
+    td::TQueue::Event d[10];
+    td::MutableSpan<td::TQueue::Event> d_span(d, 10);
 
     auto a_from = baseline_->get_head(qid);
     //auto b_from = memory_->get_head(qid);
@@ -147,13 +179,17 @@ class TestTQueue {
     baseline_->get(qid, a_from, true, now, a_span).move_as_ok();
     memory_->get(qid, a_from, true, now, b_span).move_as_ok();
     binlog_->get(qid, a_from, true, now, c_span).move_as_ok();
+    segment_->get(qid, a_from, true, now, d_span).move_as_ok();
     ASSERT_EQ(a_span.size(), b_span.size());
     ASSERT_EQ(a_span.size(), c_span.size());
+    ASSERT_EQ(a_span.size(), d_span.size());
     for (size_t i = 0; i < a_span.size(); i++) {
       ASSERT_EQ(a_span[i].id, b_span[i].id);
       ASSERT_EQ(a_span[i].id, c_span[i].id);
+      ASSERT_EQ(a_span[i].id, d_span[i].id);
       ASSERT_EQ(a_span[i].data, b_span[i].data);
       ASSERT_EQ(a_span[i].data, c_span[i].data);
+      ASSERT_EQ(a_span[i].data, d_span[i].data);
     }
   }
 
@@ -161,6 +197,7 @@ class TestTQueue {
   td::unique_ptr<td::TQueue> baseline_;
   td::unique_ptr<td::TQueue> memory_;
   td::unique_ptr<td::TQueue> binlog_;
+  td::unique_ptr<td::TQueue> segment_;
   td::TQueueMemoryStorage *memory_storage_{nullptr};
 };
 
@@ -258,3 +295,104 @@ TEST(TQueue, clear) {
   CHECK(tqueue->get_tail(1) == tail_id);
   CHECK(deleted_events.size() == 100000 - keep_count);
 }
+
+TEST(TQueue, segment_storage) {
+  td::CSlice path("tqueue_segment_storage");
+  td::TQueueSegmentStorage::destroy(path).ignore();
+
+  auto tqueue = td::TQueue::create();
+  auto segment_storage = td::make_unique<td::TQueueSegmentStorage>();
+  auto segment_storage_ptr = segment_storage.get();
+  segment_storage->replay(path.str(), *tqueue).ensure();
+  tqueue->set_callback(std::move(segment_storage));
+
+  td::int32 now = 0;
+  for (size_t i = 0; i < 50000; i++) {
+    tqueue->push(1, td::string(1000, 'a'), now + 600000, 0, {}).ensure();
+  }
+  auto segment_count = segment_storage_ptr->get_segment_count();
+  ASSERT_TRUE(segment_count > 2u);
+
+  // forget the first half of the events
+  td::TQueue::Event events[1];
+  td::MutableSpan<td::TQueue::Event> events_span(events, 1);
+  auto middle_id = tqueue->get_head(1).advance(25000).move_as_ok();
+  tqueue->get(1, middle_id, true, now, events_span).ensure();
+  ASSERT_EQ(25000u, tqueue->get_size(1));
+  ASSERT_TRUE(segment_storage_ptr->get_segment_count() < segment_count);
+
+  tqueue = td::TQueue::create();
+  segment_storage = td::make_unique<td::TQueueSegmentStorage>();
+  segment_storage->replay(path.str(), *tqueue).ensure();
+  tqueue->set_callback(std::move(segment_storage));
+  ASSERT_EQ(25000u, tqueue->get_size(1));
+  ASSERT_EQ(middle_id, tqueue->get_head(1));
+
+  tqueue->clear(1, 0);
+  ASSERT_EQ(0u, tqueue->get_size(1));
+  tqueue = nullptr;
+  td::TQueueSegmentStorage::destroy(path).ensure();
+}
+
+TEST(TQueue, concurrent_reads) {
+  constexpr size_t READER_COUNT = 3;
+  auto tqueue = td::TQueue::create();
+  tqueue->enable_concurrent_reads(READER_COUNT);
+
+  std::atomic<bool> is_finished{false};
+  std::atomic<td::int64> read_event_count{0};
+  td::vector<td::thread> readers;
+  for (size_t i = 0; i < READER_COUNT; i++) {
+    auto reader = tqueue->create_concurrent_reader();
+    CHECK(reader != nullptr);
+    readers.emplace_back([&, reader = std::move(reader), i]() mutable {
+      td::Random::Xorshift128plus rnd(static_cast<td::uint64>(i + 1));
+      td::vector<td::TQueue::RawEvent> events;
+      while (!is_finished.load()) {
+        auto from_id = td::TQueue::EventId::from_int32(rnd.fast(1000, 2000000)).move_as_ok();
+        reader->get(rnd.fast(1, 5), from_id, 0, 100, events);
+        for (size_t j = 0; j < events.size(); j++) {
+          CHECK(!(events[j].event_id < from_id));
+          CHECK(j == 0 || events[j - 1].event_id < events[j].event_id);
+          CHECK(events[j].data == td::to_string(events[j].event_id.value()));
+        }
+        read_event_count += static_cast<td::int64>(events.size());
+      }
+      reader = nullptr;
+    });
+  }
+  ASSERT_TRUE(tqueue->create_concurrent_reader() == nullptr);
+
+  td::Random::Xorshift128plus rnd(123);
+  td::TQueue::Event events[10];
+  for (int i = 0; i < 300000; i++) {
+    auto queue_id = rnd.fast(1, 5);
+    auto type = rnd.fast(0, 99);
+    if (type < 60) {
+      auto event_id = tqueue->get_tail(queue_id);
+      if (event_id.empty()) {
+        event_id = td::TQueue::EventId::from_int32(1000).move_as_ok();
+      }
+      tqueue->push(queue_id, td::to_string(event_id.value()), 1000000, 0, event_id).ensure();
+    } else if (type < 80) {
+      auto from_id = tqueue->get_head(queue_id).advance(rnd.fast(0, 20));
+      if (from_id.is_ok()) {
+        td::MutableSpan<td::TQueue::Event> events_span(events, 10);
+        tqueue->get(queue_id, from_id.ok(), true, 0, events_span).ignore();
+      }
+    } else if (type < 99) {
+      auto event_id = tqueue->get_head(queue_id).advance(rnd.fast(0, 100));
+      if (event_id.is_ok()) {
+        tqueue->forget(queue_id, event_id.ok());
+      }
+    } else {
+      tqueue->clear(queue_id, rnd.fast(0, 10));
+    }
+  }
+  is_finished = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  LOG(INFO) << "Read " << read_event_count.load() << " events";
+  ASSERT_TRUE(read_event_count.load() > 0);
+}